@@ -8,6 +8,8 @@
  * 2. Call BTLoggerSender::begin() in setup()
  * 3. Use BTLoggerSender::log() to send log messages
  *
+ * Bursts of log lines are batched into MTU-sized notifications (see setBatching()).
+ *
  * Example:
  * BTLoggerSender::begin("My_ESP32_Device");
  * BTLoggerSender::log(INFO, "MAIN", "System started successfully");
@@ -19,24 +21,80 @@
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
+#include <esp_gap_ble_api.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include "BTLoggerWire.hpp"
 
-// Log levels (match BTLogger's LogPacket structure)
+// Log levels (match BTLogger's LogPacket structure, 0 = VERBOSE is unused here)
 enum BTLogLevel {
-    BT_DEBUG = 0,
-    BT_INFO = 1,
-    BT_WARN = 2,
-    BT_ERROR = 3
+    BT_DEBUG = 1,
+    BT_INFO = 2,
+    BT_WARN = 3,
+    BT_ERROR = 4
 };
 
 // Default UUIDs (must match BTLogger's BluetoothManager)
 #define BTLOGGER_SERVICE_UUID "12345678-1234-1234-1234-123456789abc"
 #define BTLOGGER_LOG_CHAR_UUID "87654321-4321-4321-4321-cba987654321"
 
+// Legacy fixed-size packet (must match BTLogger's LogPacket)
+struct LogPacket {
+    uint32_t timestamp;
+    uint8_t level;
+    uint16_t length;
+    char message[256];
+    char tag[32];
+
+    LogPacket() : timestamp(0), level(0), length(0) {
+        message[0] = '\0';
+        tag[0] = '\0';
+    }
+};
+
+// Compact wire format, shared with BTLogger (BTLoggerWire.hpp, copy it along with this file):
+// records, batches and compressed frames. This sender speaks version 2, without sequence numbers.
+// BTLogger enables it by writing [magic][WIRE_CTRL_HELLO][maxVersion][features] to the log characteristic;
+// until then the legacy LogPacket above is sent.
+#define BTLOGGER_WIRE_VERSION 2
+#define BTLOGGER_WIRE_MAX_FRAME (sizeof(BTLoggerWireFrameHeader) + sizeof(BTLoggerWireRecordHeader) + 31 + 255)
+
+// Batching: default flush deadline. With compression (see setCompression()) batches are packed
+// past one MTU as long as they still compress into one notification.
+#define BTLOGGER_BATCH_DEFAULT_LATENCY_MS 20
+
+// Offline backlog: records flagged as replayed carry their original timestamp. The replay runs
+// in bursts on a timer; without a HELLO from BTLogger it starts in the legacy format after a wait.
+#define BTLOGGER_BACKLOG_REPLAY_BURST 8
+#define BTLOGGER_BACKLOG_HELLO_WAIT_MS 1000
+#define BTLOGGER_SPILL_SECTOR_SIZE 4096  // Flash erase unit
+
+// Link profiles: connection parameters the sender asks BTLogger for once connected
+// (intervals in 1.25 ms units, supervision timeout in 10 ms units)
+enum BTLinkProfile {
+    BT_LINK_LOW_LATENCY = 0,      // 7.5-15 ms interval, data length extension, 2M PHY where supported
+    BT_LINK_HIGH_THROUGHPUT = 1,  // 15-30 ms interval, data length extension, 2M PHY where supported
+    BT_LINK_LOW_POWER = 2         // 100-200 ms interval, may skip 4 connection events
+};
+
+#define BTLOGGER_LINK_MAX_DATA_LENGTH 251
+
+// What a bounded buffer does when a new record does not fit
+enum BTDropPolicy {
+    BT_DROP_OLDEST = 0,  // Discard queued records to make room (keep the latest logs)
+    BT_DROP_NEWEST = 1   // Discard the incoming record (keep the earliest logs)
+};
+
 class BTLoggerSender {
    public:
     // Initialize the BLE service for sending logs
-    static bool begin(const String& deviceName = "ESP32_Dev") {
+    static bool begin(const String& deviceName = "ESP32_Dev", BTLinkProfile linkProfile = BT_LINK_HIGH_THROUGHPUT) {
         if (_initialized) return true;
+        _linkProfile = linkProfile;
 
         Serial.println("Initializing BTLogger Sender...");
 
@@ -58,6 +116,17 @@ class BTLoggerSender {
                 BLECharacteristic::PROPERTY_NOTIFY);
 
         _logCharacteristic->addDescriptor(new BLE2902());
+        _logCharacteristic->setCallbacks(new LogCharacteristicCallbacks());
+
+        // Batch flush timer
+        if (!_sendMutex) _sendMutex = xSemaphoreCreateMutex();  // enableBacklog() may have created it
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = batchTimerCallback;
+        timerArgs.name = "btlogger_batch";
+        esp_timer_create(&timerArgs, &_batchTimer);
+        timerArgs.callback = replayTimerCallback;
+        timerArgs.name = "btlogger_replay";
+        esp_timer_create(&timerArgs, &_replayTimer);
 
         // Start service
         service->start();
@@ -66,7 +135,9 @@ class BTLoggerSender {
         BLEAdvertising* advertising = BLEDevice::getAdvertising();
         advertising->addServiceUUID(BTLOGGER_SERVICE_UUID);
         advertising->setScanResponse(false);
-        advertising->setMinPreferred(0x0);  // Set value to 0x00 to not advertise this parameter
+        LinkSettings settings = linkSettings(_linkProfile);
+        advertising->setMinPreferred(settings.minInterval);  // Advertised connection interval range
+        advertising->setMaxPreferred(settings.maxInterval);
         BLEDevice::startAdvertising();
 
         _initialized = true;
@@ -78,22 +149,37 @@ class BTLoggerSender {
         return true;
     }
 
-    // Send a log message
-    static void log(BTLogLevel level, const String& tag, const String& message) {
-        if (!_initialized || !_logCharacteristic) return;
+    // Send a log message. The const char* forms never allocate; the String ones are kept for
+    // existing callers.
+    static void log(BTLogLevel level, const char* tag, const char* message) {
+        if (!canAccept()) return;
 
-        // Create log packet (simple text format for now)
-        String logEntry = "[" + String(millis()) + "] [" + levelToString(level) + "] [" + tag + "] " + message;
-
-        // Send via BLE
-        _logCharacteristic->setValue(logEntry.c_str());
-        _logCharacteristic->notify();
+        uint32_t timestamp = millis();
+        sendRecord(timestamp, (uint8_t)level, tag, message);
 
         // Also print to serial for local debugging
-        Serial.println(logEntry);
+        Serial.printf("[%lu] [%s] [%s] %s\n", (unsigned long)timestamp, levelToString(level), tag, message);
+    }
+
+    static void log(BTLogLevel level, const String& tag, const String& message) { log(level, tag.c_str(), message.c_str()); }
+
+    // printf-style, rendered into a stack buffer only once the record can be sent
+    static void logf(BTLogLevel level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4))) {
+        if (!canAccept()) return;
+
+        char message[sizeof(LogPacket::message)];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(message, sizeof(message), format, args);
+        va_end(args);
+        log(level, tag, message);
     }
 
-    // Convenience macros
+    // Convenience functions
+    static void debug(const char* tag, const char* message) { log(BT_DEBUG, tag, message); }
+    static void info(const char* tag, const char* message) { log(BT_INFO, tag, message); }
+    static void warn(const char* tag, const char* message) { log(BT_WARN, tag, message); }
+    static void error(const char* tag, const char* message) { log(BT_ERROR, tag, message); }
     static void debug(const String& tag, const String& message) { log(BT_DEBUG, tag, message); }
     static void info(const String& tag, const String& message) { log(BT_INFO, tag, message); }
     static void warn(const String& tag, const String& message) { log(BT_WARN, tag, message); }
@@ -104,12 +190,143 @@ class BTLoggerSender {
         return _server && _server->getConnectedCount() > 0;
     }
 
+    // Batching: pack several records per notification, flushed when the MTU is full,
+    // after maxLatencyMs, or immediately for BT_ERROR. Only used once BTLogger negotiates v2.
+    static void setBatching(bool enabled, uint16_t maxLatencyMs = BTLOGGER_BATCH_DEFAULT_LATENCY_MS) {
+        flush();
+        _batchingEnabled = enabled;
+        _batchLatencyMs = maxLatencyMs;
+    }
+
+    // Compress batches when BTLogger supports it (negotiated on connect); raw otherwise
+    static void setCompression(bool enabled) {
+        if (_sendMutex) xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        flushBatchLocked();
+        _compressionEnabled = enabled;
+        if (_sendMutex) xSemaphoreGive(_sendMutex);
+    }
+    static bool isCompressionEnabled() { return _compressionEnabled; }
+    static bool isCompressionActive() { return _compressionEnabled && (_peerFeatures & BTLOGGER_WIRE_FEATURE_COMPRESSION); }
+    // Batch bytes before / after compression on this connection (1.0 when nothing was compressed)
+    static float getCompressionRatio() { return _compressedWireBytes > 0 ? (float)_compressedRawBytes / _compressedWireBytes : 1.0f; }
+
+    // Send any records still waiting in the batch buffer
+    static void flush() {
+        if (!_sendMutex) return;
+
+        xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        flushBatchLocked();
+        xSemaphoreGive(_sendMutex);
+    }
+
+    static uint32_t getNotificationCount() { return _notificationCount; }
+    static BTLinkProfile getLinkProfile() { return _linkProfile; }
+
+    // Offline backlog: while no BTLogger is connected, records are kept in the caller's buffer
+    // (already wire-encoded, no allocation) and, once it is full, in an optional flash partition.
+    // They are replayed at full MTU on connect. Call before begin() to capture the boot sequence.
+    static bool enableBacklog(uint8_t* buffer, size_t capacity, BTDropPolicy policy = BT_DROP_NEWEST,
+                              const char* spillPartitionLabel = nullptr) {
+        if (!buffer || capacity < sizeof(BTLoggerWireRecordHeader)) return false;
+        if (!_sendMutex) _sendMutex = xSemaphoreCreateMutex();
+
+        const esp_partition_t* partition = nullptr;
+        if (spillPartitionLabel) {
+            partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, spillPartitionLabel);
+            if (!partition) {
+                Serial.printf("BTLogger backlog: partition '%s' not found, RAM only\n", spillPartitionLabel);
+            }
+        }
+
+        xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        _backlog = buffer;
+        _backlogCapacity = capacity;
+        _backlogHead = 0;
+        _backlogTail = 0;
+        _backlogUsed = 0;
+        _backlogPolicy = policy;
+        _spillPartition = partition;
+        _spillHead = 0;
+        _spillTail = 0;
+        xSemaphoreGive(_sendMutex);
+        return true;
+    }
+
+    static bool isBacklogEnabled() { return _backlog != nullptr; }
+    static size_t getBacklogBytes() { return _backlogUsed + (_spillHead - _spillTail); }
+    static uint32_t getBacklogDroppedCount() { return _backlogDropped; }
+
    private:
     static bool _initialized;
     static BLEServer* _server;
     static BLECharacteristic* _logCharacteristic;
+    static uint8_t _wireVersion;
+    static uint8_t _frameBuffer[BTLOGGER_WIRE_MAX_FRAME];
+    static uint32_t _notificationCount;
+    static SemaphoreHandle_t _sendMutex;
+    static esp_timer_handle_t _batchTimer;
+    static bool _batchingEnabled;
+    static uint16_t _batchLatencyMs;
+    static uint8_t _batchBuffer[BTLOGGER_COMPRESS_MAX_INPUT];
+    static BTLoggerBatch _batch;  // In _batchBuffer, limited to one notification at the peer MTU
+
+    static bool _compressionEnabled;
+    static uint8_t _peerFeatures;  // From the HELLO, cleared on disconnect
+    static uint8_t _compressBuffer[BTLOGGER_BATCH_MAX_PAYLOAD];
+    static uint8_t _compressWork[BTLOGGER_COMPRESS_WORK_SIZE(BTLOGGER_COMPRESS_MAX_INPUT)];
+    static uint16_t _compressTable[1 << BTLOGGER_COMPRESS_HASH_BITS];
+    static BTLoggerCompressor _compressor;
+    static uint32_t _compressedRawBytes;
+    static uint32_t _compressedWireBytes;
+    static BTLinkProfile _linkProfile;
 
-    static String levelToString(BTLogLevel level) {
+    static uint8_t* _backlog;
+    static size_t _backlogCapacity;
+    static size_t _backlogHead;
+    static size_t _backlogTail;
+    static size_t _backlogUsed;
+    static BTDropPolicy _backlogPolicy;
+    static uint32_t _backlogDropped;
+    static const esp_partition_t* _spillPartition;
+    static size_t _spillHead;  // Spill partition is filled linearly and reset once drained
+    static size_t _spillTail;
+    static esp_timer_handle_t _replayTimer;
+    static bool _linkReady;  // Connected and the wire format settled; live records may bypass the backlog
+
+    struct LinkSettings {
+        uint16_t minInterval;
+        uint16_t maxInterval;
+        uint16_t latency;
+        uint16_t timeout;
+    };
+
+    static LinkSettings linkSettings(BTLinkProfile profile) {
+        switch (profile) {
+            case BT_LINK_LOW_LATENCY:
+                return {6, 12, 0, 400};
+            case BT_LINK_LOW_POWER:
+                return {80, 160, 4, 600};
+            case BT_LINK_HIGH_THROUGHPUT:
+            default:
+                return {12, 24, 0, 400};
+        }
+    }
+
+    // Request the profile's parameters on a fresh connection; BTLogger settles the final values
+    static void applyLinkProfile(esp_bd_addr_t address) {
+        LinkSettings settings = linkSettings(_linkProfile);
+        _server->updateConnParams(address, settings.minInterval, settings.maxInterval, settings.latency, settings.timeout);
+        if (_linkProfile != BT_LINK_LOW_POWER) {
+            esp_ble_gap_set_pkt_data_len(address, BTLOGGER_LINK_MAX_DATA_LENGTH);
+#if SOC_BLE_50_SUPPORTED
+            // BLE 5 controllers only; the classic ESP32 stays on 1M
+            esp_ble_gap_set_preferred_phy(address, 0, ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                          ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+        }
+    }
+
+    static const char* levelToString(BTLogLevel level) {
         switch (level) {
             case BT_DEBUG:
                 return "DEBUG";
@@ -124,14 +341,391 @@ class BTLoggerSender {
         }
     }
 
+    // Records are accepted once the BLE service is up, or earlier when the backlog can hold them
+    static bool canAccept() { return (_initialized && _logCharacteristic) || _backlog; }
+
+    static bool backlogPendingLocked() { return _backlogUsed > 0 || _spillHead > _spillTail; }
+
+    // Store a record in wire format, written straight into the RAM ring or the flash spill
+    static void backlogAppendLocked(uint32_t timestamp, uint8_t level, const char* tag, const char* message) {
+        BTLoggerWireRecordHeader record = {timestamp, level, BTLOGGER_WIRE_FLAG_REPLAYED,
+                                           (uint8_t)strnlen(tag, sizeof(LogPacket::tag) - 1),
+                                           (uint16_t)strnlen(message, sizeof(LogPacket::message) - 1)};
+        size_t needed = sizeof(record) + record.tagLength + record.messageLength;
+
+        // Once records spill to flash, later ones follow them there to keep the order
+        if (_spillPartition && (_spillHead > _spillTail || _backlogCapacity - _backlogUsed < needed)) {
+            if (!spillAppendLocked(record, tag, message)) {
+                _backlogDropped++;
+            }
+            return;
+        }
+
+        if (needed > _backlogCapacity) {
+            _backlogDropped++;
+            return;
+        }
+
+        while (_backlogCapacity - _backlogUsed < needed) {
+            if (_backlogPolicy == BT_DROP_NEWEST) {
+                _backlogDropped++;
+                return;
+            }
+
+            BTLoggerWireRecordHeader oldest;
+            backlogRead(_backlogTail, (uint8_t*)&oldest, sizeof(oldest));
+            size_t oldestSize = sizeof(oldest) + oldest.tagLength + oldest.messageLength;
+            _backlogTail = (_backlogTail + oldestSize) % _backlogCapacity;
+            _backlogUsed -= oldestSize;
+            _backlogDropped++;
+        }
+
+        backlogWrite(_backlogHead, (const uint8_t*)&record, sizeof(record));
+        backlogWrite(_backlogHead + sizeof(record), (const uint8_t*)tag, record.tagLength);
+        backlogWrite(_backlogHead + sizeof(record) + record.tagLength, (const uint8_t*)message, record.messageLength);
+        _backlogHead = (_backlogHead + needed) % _backlogCapacity;
+        _backlogUsed += needed;
+    }
+
+    static bool spillAppendLocked(const BTLoggerWireRecordHeader& record, const char* tag, const char* message) {
+        size_t needed = sizeof(record) + record.tagLength + record.messageLength;
+        if (_spillHead + needed > _spillPartition->size) return false;
+
+        // Erase each sector the first time the head enters it
+        size_t sector = (_spillHead + BTLOGGER_SPILL_SECTOR_SIZE - 1) / BTLOGGER_SPILL_SECTOR_SIZE * BTLOGGER_SPILL_SECTOR_SIZE;
+        for (; sector < _spillHead + needed; sector += BTLOGGER_SPILL_SECTOR_SIZE) {
+            if (esp_partition_erase_range(_spillPartition, sector, BTLOGGER_SPILL_SECTOR_SIZE) != ESP_OK) return false;
+        }
+
+        esp_partition_write(_spillPartition, _spillHead, &record, sizeof(record));
+        esp_partition_write(_spillPartition, _spillHead + sizeof(record), tag, record.tagLength);
+        esp_partition_write(_spillPartition, _spillHead + sizeof(record) + record.tagLength, message, record.messageLength);
+        _spillHead += needed;
+        return true;
+    }
+
+    // Oldest backlog record: RAM first, then the flash spill (which only holds newer records)
+    static bool backlogFrontLocked(BTLoggerWireRecordHeader& record) {
+        if (_backlogUsed > 0) {
+            backlogRead(_backlogTail, (uint8_t*)&record, sizeof(record));
+            return true;
+        }
+        if (_spillHead > _spillTail) {
+            esp_partition_read(_spillPartition, _spillTail, &record, sizeof(record));
+            return true;
+        }
+        return false;
+    }
+
+    // Copy the oldest record (header included) to destination and remove it
+    static void backlogPopLocked(uint8_t* destination, size_t length) {
+        if (_backlogUsed > 0) {
+            backlogRead(_backlogTail, destination, length);
+            _backlogTail = (_backlogTail + length) % _backlogCapacity;
+            _backlogUsed -= length;
+            return;
+        }
+
+        esp_partition_read(_spillPartition, _spillTail, destination, length);
+        _spillTail += length;
+        if (_spillTail >= _spillHead) {
+            _spillHead = 0;
+            _spillTail = 0;
+        }
+    }
+
+    static void backlogWrite(size_t offset, const uint8_t* data, size_t length) {
+        offset %= _backlogCapacity;
+        size_t first = length < _backlogCapacity - offset ? length : _backlogCapacity - offset;
+        memcpy(_backlog + offset, data, first);
+        memcpy(_backlog, data + first, length - first);
+    }
+
+    static void backlogRead(size_t offset, uint8_t* data, size_t length) {
+        offset %= _backlogCapacity;
+        size_t first = length < _backlogCapacity - offset ? length : _backlogCapacity - offset;
+        memcpy(data, _backlog + offset, first);
+        memcpy(data + first, _backlog, length - first);
+    }
+
+    // Send up to maxNotifications of backlog, packing whole records straight into full-MTU
+    // batch frames; returns true while records remain
+    static bool replayBacklogLocked(size_t maxNotifications) {
+        BTLoggerWireRecordHeader record;
+        for (size_t sent = 0; sent < maxNotifications && backlogFrontLocked(record); sent++) {
+            size_t recordLength = sizeof(record) + record.tagLength + record.messageLength;
+
+            if (_wireVersion >= BTLOGGER_WIRE_BATCH_VERSION) {
+                uint16_t mtu = _server ? _server->getPeerMTU(_server->getConnId()) : 23;
+                size_t limit = mtu > 3 ? mtu - 3 : 20;
+                if (limit > BTLOGGER_BATCH_MAX_PAYLOAD) {
+                    limit = BTLOGGER_BATCH_MAX_PAYLOAD;
+                }
+
+                BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_BATCH};
+                memcpy(_batchBuffer, &frame, sizeof(frame));
+                size_t length = sizeof(frame) + 1;
+                uint8_t count = 0;
+                while (count < 255 && length + recordLength <= limit) {
+                    backlogPopLocked(_batchBuffer + length, recordLength);
+                    length += recordLength;
+                    count++;
+                    if (!backlogFrontLocked(record)) break;
+                    recordLength = sizeof(record) + record.tagLength + record.messageLength;
+                }
+
+                if (count > 0) {
+                    _batchBuffer[sizeof(frame)] = count;
+                    notifyBatchLocked(_batchBuffer, length, limit);
+                    continue;
+                }
+                // Too large for a batch at this MTU - fall through and send it on its own
+            }
+
+            BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_RECORD};
+            memcpy(_frameBuffer, &frame, sizeof(frame));
+            backlogPopLocked(_frameBuffer + sizeof(frame), recordLength);
+
+            if (_wireVersion > 0) {
+                notifyLocked(_frameBuffer, sizeof(frame) + recordLength);
+            } else {
+                // Legacy receivers get the fixed packet; the replayed flag cannot be carried
+                const char* body = (const char*)_frameBuffer + sizeof(frame) + sizeof(record);
+                LogPacket packet;
+                packet.timestamp = record.timestamp;
+                packet.level = record.level;
+                packet.length = record.messageLength;
+                memcpy(packet.tag, body, record.tagLength);
+                packet.tag[record.tagLength] = '\0';
+                memcpy(packet.message, body + record.tagLength, record.messageLength);
+                packet.message[record.messageLength] = '\0';
+                notifyLocked((uint8_t*)&packet, sizeof(LogPacket));
+            }
+        }
+        return backlogPendingLocked();
+    }
+
+    // (Re)arm the replay; runs on the esp_timer task so the BLE callbacks never block on notify()
+    static void scheduleReplay(uint32_t delayMs) {
+        if (!_replayTimer) return;
+        esp_timer_stop(_replayTimer);
+        esp_timer_start_once(_replayTimer, delayMs > 0 ? (uint64_t)delayMs * 1000 : 1000);
+    }
+
+    static void replayTimerCallback(void* arg) {
+        if (!_sendMutex) return;
+
+        xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        bool more = false;
+        if (isConnected()) {
+            _linkReady = true;
+            if (_backlog && backlogPendingLocked()) {
+                flushBatchLocked();
+                more = replayBacklogLocked(BTLOGGER_BACKLOG_REPLAY_BURST);
+            }
+        }
+        xSemaphoreGive(_sendMutex);
+
+        if (more) {
+            scheduleReplay(0);
+        }
+    }
+
+    // Encode a record in the negotiated wire format and notify (or batch) it
+    static void sendRecord(uint32_t timestamp, uint8_t level, const char* tag, const char* message) {
+        if (!_sendMutex) return;
+
+        xSemaphoreTake(_sendMutex, portMAX_DELAY);
+
+        // Nobody listening yet, or older records still waiting to be replayed
+        if (_backlog && (!_linkReady || !isConnected() || backlogPendingLocked())) {
+            backlogAppendLocked(timestamp, level, tag, message);
+            xSemaphoreGive(_sendMutex);
+            return;
+        }
+
+        if (!_logCharacteristic) {
+            xSemaphoreGive(_sendMutex);  // Before begin(), and no backlog to keep it
+            return;
+        }
+
+        if (_wireVersion == 0) {
+            sendLegacyLocked(timestamp, level, tag, message);
+        } else if (_batchingEnabled && _wireVersion >= BTLOGGER_WIRE_BATCH_VERSION) {
+            appendToBatchLocked(timestamp, level, tag, message);
+            if (level >= BT_ERROR) {
+                flushBatchLocked();
+            }
+        } else {
+            sendSingleLocked(timestamp, level, tag, message);
+        }
+
+        xSemaphoreGive(_sendMutex);
+    }
+
+    static void sendLegacyLocked(uint32_t timestamp, uint8_t level, const char* tag, const char* message) {
+        LogPacket packet;
+        packet.timestamp = timestamp;
+        packet.level = level;
+
+        strncpy(packet.message, message, sizeof(packet.message) - 1);
+        packet.message[sizeof(packet.message) - 1] = '\0';
+        packet.length = strlen(packet.message);
+
+        strncpy(packet.tag, tag, sizeof(packet.tag) - 1);
+        packet.tag[sizeof(packet.tag) - 1] = '\0';
+
+        notifyLocked((uint8_t*)&packet, sizeof(LogPacket));
+    }
+
+    static void sendSingleLocked(uint32_t timestamp, uint8_t level, const char* tag, const char* message) {
+        BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_RECORD};
+        memcpy(_frameBuffer, &frame, sizeof(frame));
+
+        size_t length = sizeof(frame) + btLoggerEncodeRecord(_frameBuffer + sizeof(frame), timestamp, level, 0, tag, message,
+                                                             strlen(message));
+        notifyLocked(_frameBuffer, length);
+    }
+
+    static void appendToBatchLocked(uint32_t timestamp, uint8_t level, const char* tag, const char* message) {
+        size_t messageLength = strlen(message);
+        size_t recordLength = btLoggerRecordLength(tag, messageLength);
+
+        // Compressed batches may hold more raw bytes than one notification
+        size_t capacity = isCompressionActive() ? sizeof(_batchBuffer) : _batch.getLimit();
+
+        // Make room if this record would overflow the current batch
+        if (!_batch.isEmpty() && (_batch.getLength() + recordLength > capacity || _batch.getCount() == 255)) {
+            flushBatchLocked();
+        }
+
+        if (_batch.isEmpty()) {
+            // Clamp to the MTU BTLogger negotiated for this connection
+            uint16_t mtu = _server ? _server->getPeerMTU(_server->getConnId()) : 23;
+            size_t limit = mtu > 3 ? mtu - 3 : 20;
+            if (limit > BTLOGGER_BATCH_MAX_PAYLOAD) {
+                limit = BTLOGGER_BATCH_MAX_PAYLOAD;
+            }
+            capacity = isCompressionActive() ? sizeof(_batchBuffer) : limit;
+
+            // Too small to hold even this record as a batch - send it on its own
+            if (sizeof(BTLoggerWireFrameHeader) + 1 + recordLength > limit) {
+                sendSingleLocked(timestamp, level, tag, message);
+                return;
+            }
+
+            _batch.open(_wireVersion, sizeof(BTLoggerWireFrameHeader) + 1, limit);
+            if (_batchTimer) {
+                esp_timer_start_once(_batchTimer, (uint64_t)_batchLatencyMs * 1000);
+            }
+        }
+
+        // Past one MTU the batch is only kept if it still compresses into one notification
+        if (!_batch.add(timestamp, level, 0, tag, message, messageLength, isCompressionActive() ? &_compressor : nullptr,
+                        _compressBuffer)) {
+            flushBatchLocked();
+            appendToBatchLocked(timestamp, level, tag, message);  // Fits raw in a fresh batch
+            return;
+        }
+
+        if (_batch.getLength() + sizeof(BTLoggerWireRecordHeader) >= capacity) {
+            flushBatchLocked();
+        }
+    }
+
+    static void flushBatchLocked() {
+        if (_batch.isEmpty()) return;
+
+        if (_batchTimer) {
+            esp_timer_stop(_batchTimer);
+        }
+
+        if (_batch.needsSplit(_compressor, _compressBuffer)) {
+            notifyBatchLocked(_batch.data(), _batch.getSplitLength(), _batch.getLimit());
+            _batch.dropSplit(sizeof(BTLoggerWireFrameHeader) + 1);
+        }
+
+        notifyBatchLocked(_batch.data(), _batch.getLength(), _batch.getLimit());
+        _batch.clear();
+    }
+
+    // Send a batch frame, compressed when the peer supports it and that makes it smaller.
+    // A frame longer than limit is only ever passed in when it is known to compress below it.
+    static void notifyBatchLocked(uint8_t* frame, size_t length, size_t limit) {
+        if (!isCompressionActive()) {
+            notifyLocked(frame, length);
+            return;
+        }
+
+        size_t packed = _compressor.compressFrame(frame, length, _compressBuffer,
+                                                  limit < sizeof(_compressBuffer) ? limit : sizeof(_compressBuffer));
+        _compressedRawBytes += length;
+        if (packed > 0 && packed < length) {
+            _compressedWireBytes += packed;
+            notifyLocked(_compressBuffer, packed);
+        } else {
+            _compressedWireBytes += length;
+            notifyLocked(frame, length);
+        }
+    }
+
+    static void notifyLocked(uint8_t* data, size_t length) {
+        _logCharacteristic->setValue(data, length);
+        _logCharacteristic->notify();
+        _notificationCount++;
+    }
+
+    // Latency deadline reached - push out whatever has been batched so far
+    static void batchTimerCallback(void* arg) {
+        flush();
+    }
+
+    // Handle control messages written by BTLogger
+    static void handleControlWrite(const uint8_t* data, size_t length) {
+        if (!data || length < 3 || data[0] != BTLOGGER_WIRE_MAGIC) return;
+
+        if (data[1] == BTLOGGER_WIRE_CTRL_HELLO) {
+            uint8_t peerVersion = data[2];
+            if (_sendMutex) xSemaphoreTake(_sendMutex, portMAX_DELAY);
+            flushBatchLocked();
+            _wireVersion = peerVersion < BTLOGGER_WIRE_VERSION ? peerVersion : BTLOGGER_WIRE_VERSION;
+            _peerFeatures = length >= 4 ? data[3] : 0;  // Older BTLogger sends no feature byte
+            _compressedRawBytes = 0;
+            _compressedWireBytes = 0;
+            if (_sendMutex) xSemaphoreGive(_sendMutex);
+            scheduleReplay(0);
+            Serial.printf("BTLogger protocol v%d negotiated\n", _wireVersion);
+        }
+    }
+
+    // Log characteristic callbacks (control channel from BTLogger)
+    class LogCharacteristicCallbacks : public BLECharacteristicCallbacks {
+        void onWrite(BLECharacteristic* characteristic) override {
+            handleControlWrite(characteristic->getData(), characteristic->getLength());
+        }
+    };
+
     // BLE Server callbacks
     class ServerCallbacks : public BLEServerCallbacks {
         void onConnect(BLEServer* server) override {
             Serial.println("BTLogger connected!");
         }
 
+        void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) override {
+            applyLinkProfile(param->connect.remote_bda);
+            scheduleReplay(BTLOGGER_BACKLOG_HELLO_WAIT_MS);  // Brought forward by the HELLO
+        }
+
         void onDisconnect(BLEServer* server) override {
             Serial.println("BTLogger disconnected - Restarting advertising...");
+            if (_sendMutex) {
+                xSemaphoreTake(_sendMutex, portMAX_DELAY);
+                _batch.clear();  // Nobody left to deliver the pending batch to
+                _wireVersion = 0;  // Renegotiate on the next connection
+                _peerFeatures = 0;
+                _linkReady = false;
+                xSemaphoreGive(_sendMutex);
+            }
             BLEDevice::startAdvertising();
         }
     };
@@ -141,9 +735,40 @@ class BTLoggerSender {
 bool BTLoggerSender::_initialized = false;
 BLEServer* BTLoggerSender::_server = nullptr;
 BLECharacteristic* BTLoggerSender::_logCharacteristic = nullptr;
+uint8_t BTLoggerSender::_wireVersion = 0;
+uint8_t BTLoggerSender::_frameBuffer[BTLOGGER_WIRE_MAX_FRAME];
+uint32_t BTLoggerSender::_notificationCount = 0;
+SemaphoreHandle_t BTLoggerSender::_sendMutex = nullptr;
+esp_timer_handle_t BTLoggerSender::_batchTimer = nullptr;
+bool BTLoggerSender::_batchingEnabled = true;
+uint16_t BTLoggerSender::_batchLatencyMs = BTLOGGER_BATCH_DEFAULT_LATENCY_MS;
+uint8_t BTLoggerSender::_batchBuffer[BTLOGGER_COMPRESS_MAX_INPUT];
+BTLoggerBatch BTLoggerSender::_batch(_batchBuffer, sizeof(_batchBuffer));
+bool BTLoggerSender::_compressionEnabled = false;
+uint8_t BTLoggerSender::_peerFeatures = 0;
+uint8_t BTLoggerSender::_compressBuffer[BTLOGGER_BATCH_MAX_PAYLOAD];
+uint8_t BTLoggerSender::_compressWork[BTLOGGER_COMPRESS_WORK_SIZE(BTLOGGER_COMPRESS_MAX_INPUT)];
+uint16_t BTLoggerSender::_compressTable[1 << BTLOGGER_COMPRESS_HASH_BITS];
+BTLoggerCompressor BTLoggerSender::_compressor(_compressWork, _compressTable, BTLOGGER_COMPRESS_MAX_INPUT,
+                                               BTLOGGER_COMPRESS_HASH_BITS);
+uint32_t BTLoggerSender::_compressedRawBytes = 0;
+uint32_t BTLoggerSender::_compressedWireBytes = 0;
+BTLinkProfile BTLoggerSender::_linkProfile = BT_LINK_HIGH_THROUGHPUT;
+uint8_t* BTLoggerSender::_backlog = nullptr;
+size_t BTLoggerSender::_backlogCapacity = 0;
+size_t BTLoggerSender::_backlogHead = 0;
+size_t BTLoggerSender::_backlogTail = 0;
+size_t BTLoggerSender::_backlogUsed = 0;
+BTDropPolicy BTLoggerSender::_backlogPolicy = BT_DROP_NEWEST;
+uint32_t BTLoggerSender::_backlogDropped = 0;
+const esp_partition_t* BTLoggerSender::_spillPartition = nullptr;
+size_t BTLoggerSender::_spillHead = 0;
+size_t BTLoggerSender::_spillTail = 0;
+esp_timer_handle_t BTLoggerSender::_replayTimer = nullptr;
+bool BTLoggerSender::_linkReady = false;
 
 // Convenience macros for even easier usage
 #define BT_LOG_DEBUG(tag, msg) BTLoggerSender::debug(tag, msg)
 #define BT_LOG_INFO(tag, msg) BTLoggerSender::info(tag, msg)
 #define BT_LOG_WARN(tag, msg) BTLoggerSender::warn(tag, msg)
-#define BT_LOG_ERROR(tag, msg) BTLoggerSender::error(tag, msg)
\ No newline at end of file
+#define BT_LOG_ERROR(tag, msg) BTLoggerSender::error(tag, msg)
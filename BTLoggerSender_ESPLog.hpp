@@ -1,8 +1,8 @@
 #pragma once
 
 // Toggleable debug logging for BTLogger itself
-// Uncomment the line below to enable BTLogger debug prints
-#define DEBUG_BTLOGGER
+// Uncomment the line below to enable BTLogger debug prints (they run on every log call)
+// #define DEBUG_BTLOGGER
 
 #ifdef DEBUG_BTLOGGER
 #define BTLOGGER_DEBUG(format, ...) Serial.printf("[BTLOGGER_DEBUG] " format "\n", ##__VA_ARGS__)
@@ -18,6 +18,8 @@
  *
  * Features:
  * - Zero code changes needed - just include and initialize
+ * - Batches bursts of log lines into MTU-sized notifications (see setBatching())
+ * - Optional async mode: ESP_LOG calls only enqueue, a background task does BLE (see enableAsync())
  * - Automatically captures ESP_LOGI, ESP_LOGW, ESP_LOGE, ESP_LOGD, ESP_LOGV
  * - Preserves normal serial output while sending to BTLogger
  * - Parses log level and tag automatically
@@ -29,6 +31,7 @@
  * 2. Call BTLoggerSender::begin() in setup() - that's it!
  * 3. All your existing ESP_LOG* calls will automatically be sent to BTLogger
  * 4. Log levels can now be changed at runtime, even if disabled at compile time
+ *    (per tag too, see setTagLevel()); BTLOGGER_COMPILE_LEVEL removes sites below it
  *
  * Example:
  * BTLoggerSender::begin("MyProject");
@@ -41,9 +44,17 @@
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
+#include <esp_gap_ble_api.h>
+#include <esp_partition.h>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <sys/time.h>
+#include "BTLoggerWire.hpp"
 
 // Undefine existing ESP_LOG macros to override them
 #ifdef ESP_LOGE
@@ -65,21 +76,26 @@
 // Forward declaration of our class for use in macros
 class BTLoggerSender;
 
-// New ESP_LOG macros that enable runtime control
-#define ESP_LOGE(tag, format, ...) \
-    BTLoggerSender::espLogWrite(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__);
-
-#define ESP_LOGW(tag, format, ...) \
-    BTLoggerSender::espLogWrite(ESP_LOG_WARN, tag, format, ##__VA_ARGS__);
-
-#define ESP_LOGI(tag, format, ...) \
-    BTLoggerSender::espLogWrite(ESP_LOG_INFO, tag, format, ##__VA_ARGS__);
+// Lowest level (BT_* value) an ESP_LOG site can ever log at; sites below it compile to nothing.
+// Their arguments are still type-checked but never evaluated.
+#ifndef BTLOGGER_COMPILE_LEVEL
+#define BTLOGGER_COMPILE_LEVEL 0
+#endif
 
-#define ESP_LOGD(tag, format, ...) \
-    BTLoggerSender::espLogWrite(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__);
+// New ESP_LOG macros that enable runtime control. A level nothing can take is rejected inline
+// with one load and compare, before the arguments are evaluated; espLogWrite() does the rest.
+#define BTLOGGER_ESP_LOG(espLevel, btLevel, tag, format, ...)                        \
+    do {                                                                            \
+        if ((btLevel) >= BTLOGGER_COMPILE_LEVEL && BTLoggerSender::isEnabled(espLevel)) { \
+            BTLoggerSender::espLogWrite(espLevel, tag, format, ##__VA_ARGS__);      \
+        }                                                                           \
+    } while (0)
 
-#define ESP_LOGV(tag, format, ...) \
-    BTLoggerSender::espLogWrite(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__);
+#define ESP_LOGE(tag, format, ...) BTLOGGER_ESP_LOG(ESP_LOG_ERROR, BT_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) BTLOGGER_ESP_LOG(ESP_LOG_WARN, BT_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) BTLOGGER_ESP_LOG(ESP_LOG_INFO, BT_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) BTLOGGER_ESP_LOG(ESP_LOG_DEBUG, BT_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) BTLOGGER_ESP_LOG(ESP_LOG_VERBOSE, BT_VERBOSE, tag, format, ##__VA_ARGS__)
 
 // Log levels (match both ESP_LOG and BTLogger)
 enum BTLogLevel {
@@ -108,12 +124,105 @@ struct LogPacket {
     }
 };
 
+// Compact wire format, shared with BTLogger (BTLoggerWire.hpp, copy it along with this file)
+// Frame:  [magic:1][version:1][type:1]
+// Record: [timestamp:4][level:1][flags:1][tagLength:1][messageLength:2][tag...][message...]
+// Batch (version 2+): [frame header][count:1][record][record]...
+// Dictionary (version 3+): [frame header][formatId:2][formatLength:1][format...]
+// Compressed (peer feature): [frame header][innerType:1][rawLength:2][LZ4-style block]
+// Sync reply (version 4+): [frame header][sequence:1][senderMicros:8][unixMillis:8]
+// Sequencing (version 5+): records are numbered per connection from 0 (mod 2^16); a record
+// frame is [frame header][sequence:2][record], a batch [frame header][count:1][firstSequence:2][records].
+// BTLogger asks for missed records with [magic][WIRE_CTRL_RESEND][firstSequence:2][count:2]; what
+// is still in the history (see enableRetransmit()) comes back in resend frames laid out like a
+// batch, flagged RESENT, the rest is reported in a lost frame [frame header][firstSequence:2][count:2].
+// Flow and level control (version 6+): BTLogger writes [magic][WIRE_CTRL_FLOW][minLevel][rate:2]
+// while it is falling behind - records below minLevel are dropped here, and at most rate per second
+// below WARN are sent (0 for no limit) - and [magic][WIRE_CTRL_LEVEL][level][tagLength][tag...] to
+// set the level of one tag (all tags if empty; 0xFF clears it). Both last until the disconnect.
+// BTLogger enables it by writing [magic][WIRE_CTRL_HELLO][maxVersion][features] to the log characteristic;
+// until then (or with an older BTLogger) the legacy LogPacket above is sent. It then writes
+// [magic][WIRE_CTRL_SYNC][sequence] now and then to line our clock up with its own.
+#define BTLOGGER_WIRE_VERSION 6
+#define BTLOGGER_WIRE_LEVEL_CLEAR 0xFF
+#define BTLOGGER_WALL_CLOCK_MIN_MS 1577836800000ULL  // A clock before 2020 has never been set
+#define BTLOGGER_WIRE_MAX_FRAME (sizeof(BTLoggerWireFrameHeader) + 2 + sizeof(BTLoggerWireRecordHeader) + 31 + 255)
+
+// Batching: default flush deadline. With compression (see setCompression()) batches are packed
+// past one MTU as long as they still compress into one notification.
+#define BTLOGGER_BATCH_DEFAULT_LATENCY_MS 20
+
+// Offline backlog: records flagged as replayed carry their original timestamp. The replay runs
+// in bursts on a timer; without a HELLO from BTLogger it starts in the legacy format after a wait.
+#define BTLOGGER_BACKLOG_REPLAY_BURST 8
+#define BTLOGGER_BACKLOG_HELLO_WAIT_MS 1000
+#define BTLOGGER_SPILL_SECTOR_SIZE 4096  // Flash erase unit
+
+// Retransmit (see enableRetransmit()): the last records sent, kept as [sequence:2][record] so
+// BTLogger can ask for the ones it missed. Resends go out in bursts on the replay timer.
+#define BTLOGGER_HISTORY_DEFAULT_CAPACITY 8192
+#define BTLOGGER_RESEND_QUEUE 4  // Requests waiting; more are ignored and asked for again
+
+// Per-tag levels (see setTagLevel()), set by name here or by BTLogger and looked up by tag
+// pointer: ESP_LOG tags are string literals, so after the first call a tag costs one hashed load
+#define BTLOGGER_TAG_LEVELS 16
+#define BTLOGGER_TAG_CACHE_SLOTS 64  // Power of two
+
+// Tokenized mode (see setTokenizedLogging()): the message of a flagged record is
+// [formatId:2][args...] - int32 and pointer args as 4 bytes, long long/intmax_t as 8, floating
+// point as an 8 byte double, strings as [length:1][bytes]. Each format string is sent once per
+// connection in a dictionary frame before its first record. Formats using %n, long double or
+// wide strings, or with more than BTLOGGER_TOKEN_MAX_ARGS arguments, are always sent as text.
+#define BTLOGGER_TOKEN_MAX_FORMATS 128
+#define BTLOGGER_TOKEN_HASH_SLOTS 256  // Power of two, larger than BTLOGGER_TOKEN_MAX_FORMATS
+#define BTLOGGER_TOKEN_MAX_ARGS 12
+#define BTLOGGER_TOKEN_ARENA_BYTES 4096
+#define BTLOGGER_TOKEN_NONE 0xFFFF
+
+enum BTTokenArgKind : uint8_t {
+    BT_TOKEN_ARG_INT32 = 0,
+    BT_TOKEN_ARG_INT64 = 1,
+    BT_TOKEN_ARG_DOUBLE = 2,
+    BT_TOKEN_ARG_STRING = 3
+};
+
+// Link profiles: connection parameters the sender asks BTLogger for once connected
+// (intervals in 1.25 ms units, supervision timeout in 10 ms units)
+enum BTLinkProfile {
+    BT_LINK_LOW_LATENCY = 0,      // 7.5-15 ms interval, data length extension, 2M PHY where supported
+    BT_LINK_HIGH_THROUGHPUT = 1,  // 15-30 ms interval, data length extension, 2M PHY where supported
+    BT_LINK_LOW_POWER = 2         // 100-200 ms interval, may skip 4 connection events
+};
+
+#define BTLOGGER_LINK_MAX_DATA_LENGTH 251
+
+// Async mode: ring buffer size in bytes and sender task settings
+#define BTLOGGER_ASYNC_DEFAULT_CAPACITY 8192
+#define BTLOGGER_ASYNC_TASK_STACK 4096
+#define BTLOGGER_ASYNC_TASK_PRIORITY 1
+
+// What the async ring does when a new record does not fit
+enum BTDropPolicy {
+    BT_DROP_OLDEST = 0,  // Discard queued records to make room (keep the latest logs)
+    BT_DROP_NEWEST = 1   // Discard the incoming record (keep the earliest logs)
+};
+
+// Header of a record waiting in the async ring, followed by tag and message bytes
+struct __attribute__((packed)) BTLoggerQueuedRecord {
+    uint32_t timestamp;
+    uint8_t level;
+    uint8_t flags;
+    uint8_t tagLength;
+    uint16_t messageLength;
+};
+
 class BTLoggerSender {
    public:
     // Set BTLogger-specific log level (independent of global ESP_LOG_LEVEL)
     static void setBTLogLevel(BTLogLevel level) {
         BTLOGGER_DEBUG("Setting BTLogger log level from %s to %s", levelToString(_btLogLevel).c_str(), levelToString(level).c_str());
         _btLogLevel = level;
+        updateFloor();
         ESP_LOGI("BTLOGGER", "BTLogger log level set to: %s", levelToString(level).c_str());
     }
 
@@ -126,6 +235,7 @@ class BTLoggerSender {
     static void setESPLogLevel(esp_log_level_t level) {
         BTLOGGER_DEBUG("Setting ESP log level from %s to %s", espLevelToString(_espLogLevel).c_str(), espLevelToString(level).c_str());
         _espLogLevel = level;
+        updateFloor();
         ESP_LOGI("BTLOGGER", "ESP serial log level set to: %s", espLevelToString(level).c_str());
     }
 
@@ -134,66 +244,75 @@ class BTLoggerSender {
         return _espLogLevel;
     }
 
-    // Core function that handles all ESP_LOG macro calls
+    // Level for one tag instead of setBTLogLevel()'s; one BTLogger sets for the tag wins while connected.
+    // Matched by name, so any pointer to the same text works. False when the table is full.
+    static bool setTagLevel(const char* tag, BTLogLevel level) { return setTagLevelEntry(tag, strlen(tag), (uint8_t)level, false); }
+    static void clearTagLevel(const char* tag) { setTagLevelEntry(tag, strlen(tag), BTLOGGER_WIRE_LEVEL_CLEAR, false); }
+
+    // Could a record at this level go anywhere - serial or BTLogger, for some tag? The ESP_LOG
+    // macros ask before evaluating their arguments.
+    static inline bool isEnabled(esp_log_level_t level) { return level <= _espGate; }
+
+    // Core function that handles all ESP_LOG macro calls. The line is rendered once, on the stack,
+    // and that one buffer goes to serial and to BTLogger; nothing here touches the heap.
     static void espLogWrite(esp_log_level_t esp_level, const char* tag, const char* format, ...) {
+        // Level checks first, so a filtered call formats nothing
+        BTLogLevel bt_level = espLevelToBTLevel(esp_level);
+        bool toSerial = esp_level <= _espLogLevel;
+        bool toBTLogger = canAccept() && admit(bt_level, tag);
+        if (!toSerial && !toBTLogger) {
+            return;
+        }
+
+        BTLOGGER_DEBUG("espLogWrite called - ESP level: %s, tag: %s, serial: %s, BTLogger: %s",
+                       espLevelToString(esp_level).c_str(), tag,
+                       toSerial ? "yes" : "no", toBTLogger ? "yes" : "no");
+
+        char line[sizeof(LogPacket::message)];
         va_list args;
         va_start(args, format);
 
-        BTLOGGER_DEBUG("espLogWrite called - ESP level: %s, tag: %s, initialized: %s, connected: %s",
-                       espLevelToString(esp_level).c_str(), tag,
-                       _initialized ? "true" : "false",
-                       isConnected() ? "true" : "false");
-
-        // Check ESP log level for serial output
-        if (esp_level <= _espLogLevel) {
-            BTLOGGER_DEBUG("Sending to ESP serial (level %s <= %s)", espLevelToString(esp_level).c_str(), espLevelToString(_espLogLevel).c_str());
-            // Call the original ESP logging function for serial output
-            esp_log_writev(esp_level, tag, format, args);
-        } else {
-            BTLOGGER_DEBUG("Skipping ESP serial (level %s > %s)", espLevelToString(esp_level).c_str(), espLevelToString(_espLogLevel).c_str());
+        // Tokenized: format id plus raw arguments; anything that does not fit goes as text
+        if (toBTLogger && _tokenizedEnabled && _wireVersion >= BTLOGGER_WIRE_TOKEN_VERSION) {
+            uint16_t formatId = lookupFormat(format);
+            if (formatId != BTLOGGER_TOKEN_NONE) {
+                va_list tokenArgs;
+                va_copy(tokenArgs, args);
+                size_t tokenLength = encodeTokenized(formatId, tokenArgs, (uint8_t*)line, sizeof(line) - 1);
+                va_end(tokenArgs);
+                if (tokenLength > 0) {
+                    BTLOGGER_DEBUG("BTLogger record: level=%d, tag=%s, tokenized %d bytes", (int)bt_level, tag, (int)tokenLength);
+                    submitRecord(millis(), (uint8_t)bt_level, tag, line, tokenLength, BTLOGGER_WIRE_FLAG_TOKENIZED);
+                    _directLogCount++;
+                    toBTLogger = false;
+                }
+            }
         }
 
-        // Check BTLogger level and send to BTLogger
-        BTLogLevel bt_level = espLevelToBTLevel(esp_level);
-        if (_initialized && _logCharacteristic && bt_level >= _btLogLevel) {
-            BTLOGGER_DEBUG("Sending to BTLogger (BT level %s >= %s)", levelToString(bt_level).c_str(), levelToString(_btLogLevel).c_str());
-            // Format the message as LogPacket for BTLogger
-            LogPacket packet;
-            packet.timestamp = millis();
-            packet.level = (uint8_t)bt_level;
-
-            // Format message
-            va_start(args, format);  // Reset va_list
-            vsnprintf(packet.message, sizeof(packet.message), format, args);
-            packet.length = strlen(packet.message);
-
-            // Copy tag (ensure null termination)
-            strncpy(packet.tag, tag, sizeof(packet.tag) - 1);
-            packet.tag[sizeof(packet.tag) - 1] = '\0';
-
-            BTLOGGER_DEBUG("BTLogger packet: timestamp=%d, level=%d, tag=%s, message=%s",
-                           packet.timestamp, packet.level, packet.tag, packet.message);
-
-            // Send as binary data
-            _logCharacteristic->setValue((uint8_t*)&packet, sizeof(LogPacket));
-            _logCharacteristic->notify();
-            _directLogCount++;
-            BTLOGGER_DEBUG("BTLogger notification sent, total count: %d", _directLogCount);
-        } else {
-            if (!_initialized) {
-                BTLOGGER_DEBUG("Skipping BTLogger - not initialized");
-            } else if (!_logCharacteristic) {
-                BTLOGGER_DEBUG("Skipping BTLogger - no characteristic");
-            } else {
-                BTLOGGER_DEBUG("Skipping BTLogger - level check failed (BT level %s < %s)", levelToString(bt_level).c_str(), levelToString(_btLogLevel).c_str());
+        if (toSerial || toBTLogger) {
+            va_list serialArgs;
+            va_copy(serialArgs, args);  // Only used again if the line does not fit
+            int rendered = vsnprintf(line, sizeof(line), format, args);
+            size_t length = rendered < 0 ? 0 : min((size_t)rendered, sizeof(line) - 1);
+
+            if (toSerial) {
+                bool truncated = rendered > (int)length;
+                writeSerialLine(esp_level, tag, line, length, truncated ? format : nullptr, serialArgs);
+            }
+            if (toBTLogger) {
+                BTLOGGER_DEBUG("BTLogger record: level=%d, tag=%s, message=%s", (int)bt_level, tag, line);
+                submitRecord(millis(), (uint8_t)bt_level, tag, line, length, 0);
+                _directLogCount++;
             }
+            va_end(serialArgs);
         }
 
         va_end(args);
     }
 
     // Initialize - simplified version without ESP_LOG hooking since we override macros
-    static bool begin(const String& deviceName = "ESP32_Dev", BTLogLevel btLogLevel = BT_INFO, esp_log_level_t espLogLevel = ESP_LOG_INFO) {
+    static bool begin(const String& deviceName = "ESP32_Dev", BTLogLevel btLogLevel = BT_INFO, esp_log_level_t espLogLevel = ESP_LOG_INFO,
+                      BTLinkProfile linkProfile = BT_LINK_HIGH_THROUGHPUT) {
         if (_initialized) {
             BTLOGGER_DEBUG("begin() called but already initialized");
             return true;
@@ -206,6 +325,8 @@ class BTLoggerSender {
         // Set log levels
         _btLogLevel = btLogLevel;
         _espLogLevel = espLogLevel;
+        _linkProfile = linkProfile;
+        updateFloor();
         BTLOGGER_DEBUG("Log levels set");
 
         // Initialize BLE
@@ -227,6 +348,17 @@ class BTLoggerSender {
                 BLECharacteristic::PROPERTY_NOTIFY);
 
         _logCharacteristic->addDescriptor(new BLE2902());
+        _logCharacteristic->setCallbacks(new LogCharacteristicCallbacks());
+
+        BTLOGGER_DEBUG("Creating batch flush timer");
+        if (!_sendMutex) _sendMutex = xSemaphoreCreateMutex();  // enableBacklog() may have created it
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = batchTimerCallback;
+        timerArgs.name = "btlogger_batch";
+        esp_timer_create(&timerArgs, &_batchTimer);
+        timerArgs.callback = replayTimerCallback;
+        timerArgs.name = "btlogger_replay";
+        esp_timer_create(&timerArgs, &_replayTimer);
         BTLOGGER_DEBUG("Starting BLE service");
         service->start();
 
@@ -234,7 +366,9 @@ class BTLoggerSender {
         BLEAdvertising* advertising = BLEDevice::getAdvertising();
         advertising->addServiceUUID(BTLOGGER_SERVICE_UUID);
         advertising->setScanResponse(false);
-        advertising->setMinPreferred(0x0);
+        LinkSettings settings = linkSettings(_linkProfile);
+        advertising->setMinPreferred(settings.minInterval);  // Advertised connection interval range
+        advertising->setMaxPreferred(settings.maxInterval);
         BLEDevice::startAdvertising();
 
         _initialized = true;
@@ -248,42 +382,49 @@ class BTLoggerSender {
         return true;
     }
 
-    // Manual logging (still available)
-    static void log(BTLogLevel level, const String& tag, const String& message) {
-        BTLOGGER_DEBUG("Manual log called - level: %s, tag: %s, message: %s", levelToString(level).c_str(), tag.c_str(), message.c_str());
+    // Manual logging (still available). The const char* forms never allocate; the String ones
+    // are kept for existing callers.
+    static void log(BTLogLevel level, const char* tag, const char* message) {
+        BTLOGGER_DEBUG("Manual log called - level: %s, tag: %s, message: %s", levelToString(level).c_str(), tag, message);
 
-        if (!_initialized || !_logCharacteristic) {
+        if (!canAccept()) {
             BTLOGGER_DEBUG("Manual log skipped - initialized: %s, characteristic: %s",
                            _initialized ? "true" : "false",
                            _logCharacteristic ? "exists" : "null");
             return;
         }
+        if (!admit(level, tag)) {
+            return;
+        }
 
-        // Format as LogPacket for BTLogger
-        LogPacket packet;
-        packet.timestamp = millis();
-        packet.level = (uint8_t)level;
+        submitRecord(millis(), (uint8_t)level, tag, message);
+        _manualLogCount++;
+    }
 
-        // Copy message (ensure null termination)
-        strncpy(packet.message, message.c_str(), sizeof(packet.message) - 1);
-        packet.message[sizeof(packet.message) - 1] = '\0';
-        packet.length = strlen(packet.message);
+    static void log(BTLogLevel level, const String& tag, const String& message) { log(level, tag.c_str(), message.c_str()); }
 
-        // Copy tag (ensure null termination)
-        strncpy(packet.tag, tag.c_str(), sizeof(packet.tag) - 1);
-        packet.tag[sizeof(packet.tag) - 1] = '\0';
+    // printf-style, rendered into a stack buffer only once the level lets the record through
+    static void logf(BTLogLevel level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4))) {
+        if (!canAccept() || !admit(level, tag)) {
+            return;
+        }
 
-        BTLOGGER_DEBUG("Manual log packet: timestamp=%d, level=%d, tag=%s, message=%s",
-                       packet.timestamp, packet.level, packet.tag, packet.message);
+        char message[sizeof(LogPacket::message)];
+        va_list args;
+        va_start(args, format);
+        int rendered = vsnprintf(message, sizeof(message), format, args);
+        va_end(args);
 
-        // Send as binary data
-        _logCharacteristic->setValue((uint8_t*)&packet, sizeof(LogPacket));
-        _logCharacteristic->notify();
+        size_t length = rendered < 0 ? 0 : min((size_t)rendered, sizeof(message) - 1);
+        submitRecord(millis(), (uint8_t)level, tag, message, length, 0);
         _manualLogCount++;
-        BTLOGGER_DEBUG("Manual log notification sent, total count: %d", _manualLogCount);
     }
 
     // Convenience functions (still available)
+    static void debug(const char* tag, const char* message) { log(BT_DEBUG, tag, message); }
+    static void info(const char* tag, const char* message) { log(BT_INFO, tag, message); }
+    static void warn(const char* tag, const char* message) { log(BT_WARN, tag, message); }
+    static void error(const char* tag, const char* message) { log(BT_ERROR, tag, message); }
     static void debug(const String& tag, const String& message) { log(BT_DEBUG, tag, message); }
     static void info(const String& tag, const String& message) { log(BT_INFO, tag, message); }
     static void warn(const String& tag, const String& message) { log(BT_WARN, tag, message); }
@@ -298,6 +439,157 @@ class BTLoggerSender {
     static uint32_t getDirectLogCount() { return _directLogCount; }
     static uint32_t getManualLogCount() { return _manualLogCount; }
 
+    static uint32_t getNotificationCount() { return _notificationCount; }
+
+    // Negotiated wire format version (0 = legacy fixed-size LogPacket)
+    static uint8_t getWireVersion() { return _wireVersion; }
+
+    // Batching: pack several records per notification, flushed when the MTU is full,
+    // after maxLatencyMs, or immediately for BT_ERROR. Only used once BTLogger negotiates v2.
+    static void setBatching(bool enabled, uint16_t maxLatencyMs = BTLOGGER_BATCH_DEFAULT_LATENCY_MS) {
+        flush();
+        _batchingEnabled = enabled;
+        _batchLatencyMs = maxLatencyMs;
+        BTLOGGER_DEBUG("Batching %s (max latency %d ms)", enabled ? "enabled" : "disabled", maxLatencyMs);
+    }
+
+    static bool isBatchingEnabled() { return _batchingEnabled; }
+
+    // Compress batches when BTLogger supports it (negotiated on connect); raw otherwise
+    static void setCompression(bool enabled) {
+        if (_sendMutex) xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        flushBatchLocked();
+        _compressionEnabled = enabled;
+        if (_sendMutex) xSemaphoreGive(_sendMutex);
+    }
+    static bool isCompressionEnabled() { return _compressionEnabled; }
+    static bool isCompressionActive() { return _compressionEnabled && (_peerFeatures & BTLOGGER_WIRE_FEATURE_COMPRESSION); }
+    // Batch bytes before / after compression on this connection (1.0 when nothing was compressed)
+    static float getCompressionRatio() { return _compressedWireBytes > 0 ? (float)_compressedRawBytes / _compressedWireBytes : 1.0f; }
+
+    // Async mode: log calls copy the formatted record into a ring buffer and return;
+    // a low-priority task drains it into BLE. Can be called before or after begin().
+    static bool enableAsync(size_t capacityBytes = BTLOGGER_ASYNC_DEFAULT_CAPACITY,
+                            BTDropPolicy policy = BT_DROP_OLDEST,
+                            UBaseType_t taskPriority = BTLOGGER_ASYNC_TASK_PRIORITY) {
+        if (_asyncRing) {
+            BTLOGGER_DEBUG("enableAsync() called but async mode already active");
+            _dropPolicy = policy;
+            return true;
+        }
+
+        uint8_t* ring = (uint8_t*)malloc(capacityBytes);
+        if (!ring) {
+            Serial.printf("BTLogger async mode: failed to allocate %d byte ring\n", (int)capacityBytes);
+            return false;
+        }
+
+        _dropPolicy = policy;
+        _asyncCapacity = capacityBytes;
+        _asyncHead = 0;
+        _asyncTail = 0;
+        _asyncUsed = 0;
+        _asyncRing = ring;
+
+        if (xTaskCreate(asyncSenderTask, "BTLogger_Send", BTLOGGER_ASYNC_TASK_STACK, nullptr, taskPriority, &_asyncTask) != pdPASS) {
+            Serial.println("BTLogger async mode: failed to create sender task");
+            _asyncRing = nullptr;
+            free(ring);
+            return false;
+        }
+
+        BTLOGGER_DEBUG("Async mode enabled - %d byte ring, drop %s", (int)capacityBytes, policy == BT_DROP_OLDEST ? "oldest" : "newest");
+        return true;
+    }
+
+    static bool isAsyncEnabled() { return _asyncRing != nullptr; }
+    static void setDropPolicy(BTDropPolicy policy) { _dropPolicy = policy; }
+    static BTDropPolicy getDropPolicy() { return _dropPolicy; }
+    static BTLinkProfile getLinkProfile() { return _linkProfile; }
+    static uint32_t getDroppedOldestCount() { return _droppedOldest; }
+    static uint32_t getDroppedNewestCount() { return _droppedNewest; }
+    static size_t getQueuedBytes() { return _asyncUsed; }
+
+    // Offline backlog: while no BTLogger is connected, records are kept in the caller's buffer
+    // (already wire-encoded, no allocation) and, once it is full, in an optional flash partition.
+    // They are replayed at full MTU on connect. Call before begin() to capture the boot sequence.
+    static bool enableBacklog(uint8_t* buffer, size_t capacity, BTDropPolicy policy = BT_DROP_NEWEST,
+                              const char* spillPartitionLabel = nullptr) {
+        if (!buffer || capacity < sizeof(BTLoggerWireRecordHeader)) return false;
+        if (!_sendMutex) _sendMutex = xSemaphoreCreateMutex();
+
+        const esp_partition_t* partition = nullptr;
+        if (spillPartitionLabel) {
+            partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, spillPartitionLabel);
+            if (!partition) {
+                Serial.printf("BTLogger backlog: partition '%s' not found, RAM only\n", spillPartitionLabel);
+            }
+        }
+
+        xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        _backlog = buffer;
+        _backlogCapacity = capacity;
+        _backlogHead = 0;
+        _backlogTail = 0;
+        _backlogUsed = 0;
+        _backlogPolicy = policy;
+        _spillPartition = partition;
+        _spillHead = 0;
+        _spillTail = 0;
+        xSemaphoreGive(_sendMutex);
+        return true;
+    }
+
+    static bool isBacklogEnabled() { return _backlog != nullptr; }
+    static size_t getBacklogBytes() { return _backlogUsed + (_spillHead - _spillTail); }
+    static uint32_t getBacklogDroppedCount() { return _backlogDropped; }
+
+    // Retransmit: keep the last capacityBytes of sent records so BTLogger (wire version 5) can
+    // ask for the ones that never arrived. Without it a request is answered with a lost report,
+    // so the gap is still marked on BTLogger. Can be called before or after begin().
+    static bool enableRetransmit(size_t capacityBytes = BTLOGGER_HISTORY_DEFAULT_CAPACITY) {
+        if (_history) return true;
+        if (!_sendMutex) _sendMutex = xSemaphoreCreateMutex();
+
+        uint8_t* history = (uint8_t*)malloc(capacityBytes);
+        if (!history) {
+            Serial.printf("BTLogger retransmit: failed to allocate %d byte history\n", (int)capacityBytes);
+            return false;
+        }
+
+        xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        _historyCapacity = capacityBytes;
+        _historyHead = 0;
+        _historyUsed = 0;
+        _history = history;
+        xSemaphoreGive(_sendMutex);
+        return true;
+    }
+
+    static bool isRetransmitEnabled() { return _history != nullptr; }
+    static uint32_t getResentCount() { return _resentCount; }
+    static uint32_t getUnavailableCount() { return _unavailableCount; }  // Asked for but no longer held
+
+    // Flow control: records dropped here because BTLogger asked for fewer (wire version 6)
+    static uint32_t getFlowDroppedCount() { return _flowDropped; }
+    static bool isFlowLimited() { return _flowMinLevel > 0 || _flowRate > 0; }
+
+    // Tokenized mode: ESP_LOG calls send a format id and raw arguments instead of the formatted
+    // text, and BTLogger formats them when displayed. Needs a BTLogger speaking wire version 3;
+    // older ones keep receiving text. Format strings must stay valid (string literals are).
+    static void setTokenizedLogging(bool enabled) { _tokenizedEnabled = enabled; }
+    static bool isTokenizedLogging() { return _tokenizedEnabled; }
+    static uint32_t getTokenDroppedCount() { return _tokenDropped; }
+
+    // Send any records still waiting in the batch buffer
+    static void flush() {
+        if (!_sendMutex) return;
+
+        xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        flushBatchLocked();
+        xSemaphoreGive(_sendMutex);
+    }
+
     // Convenience methods for common log level scenarios
     static void setVerboseMode() {
         setBTLogLevel(BT_VERBOSE);
@@ -327,7 +619,23 @@ class BTLoggerSender {
         status += "- BTLogger Level: " + levelToString(_btLogLevel) + "\n";
         status += "- ESP Serial Level: " + espLevelToString(_espLogLevel) + "\n";
         status += "- Direct ESP_LOG messages: " + String(_directLogCount) + "\n";
-        status += "- Manual logs sent: " + String(_manualLogCount);
+        status += "- Manual logs sent: " + String(_manualLogCount) + "\n";
+        status += "- Notifications sent: " + String(_notificationCount) + "\n";
+        status += "- Wire format: " + String(_wireVersion > 0 ? "Compact v" + String(_wireVersion) : String("Legacy")) + "\n";
+        status += "- Batching: " + String(_batchingEnabled ? "On (" + String(_batchLatencyMs) + " ms)" : String("Off")) + "\n";
+        status += "- Compression: " + String(isCompressionActive() ? "On (" + String(getCompressionRatio(), 2) + "x)" : String(_compressionEnabled ? "Waiting for BTLogger" : "Off")) + "\n";
+        status += "- Tokenized: " + String(_tokenizedEnabled ? "On (" + String(_formatCount) + " formats)" : String("Off")) + "\n";
+        status += "- Retransmit: " + String(_history ? "On (" + String(_resentCount) + " resent, " + String(_unavailableCount) + " unavailable)" : String("Off")) + "\n";
+        status += "- Flow: " + String(isFlowLimited() ? "Level " + String(_flowMinLevel) + "+, " + String(_flowRate) + "/s" : String("Open")) +
+                  " (" + String(_flowDropped) + " dropped, " + String(_tagLevelCount) + " tag levels)\n";
+        status += "- Async: " + String(_asyncRing ? "On (" + String(_asyncUsed) + "/" + String(_asyncCapacity) + " bytes queued)" : String("Off"));
+        if (_asyncRing) {
+            status += "\n- Dropped: " + String(_droppedOldest) + " oldest, " + String(_droppedNewest) + " newest";
+            status += "\n- Queue peak: " + String(_asyncPeakUsed) + " bytes";
+            status += "\n- Queue delay: " +
+                      String(_queueDelayCount > 0 ? (uint32_t)(_queueDelayTotalMs / _queueDelayCount) : 0) + " ms avg, " +
+                      String(_queueDelayMaxMs) + " ms max";
+        }
         return status;
     }
 
@@ -339,6 +647,1264 @@ class BTLoggerSender {
     static uint32_t _manualLogCount;
     static BTLogLevel _btLogLevel;
     static esp_log_level_t _espLogLevel;
+    static BTLinkProfile _linkProfile;
+
+    static uint8_t* _backlog;
+    static size_t _backlogCapacity;
+    static size_t _backlogHead;
+    static size_t _backlogTail;
+    static size_t _backlogUsed;
+    static BTDropPolicy _backlogPolicy;
+    static uint32_t _backlogDropped;
+    static const esp_partition_t* _spillPartition;
+    static size_t _spillHead;  // Spill partition is filled linearly and reset once drained
+    static size_t _spillTail;
+    static esp_timer_handle_t _replayTimer;
+    static bool _linkReady;  // Connected and the wire format settled; live records may bypass the backlog
+    static uint8_t _wireVersion;
+    static uint8_t _frameBuffer[BTLOGGER_WIRE_MAX_FRAME];
+    static uint16_t _nextSequence;  // Of the next record sent on this connection
+
+    // Retransmit history ring, oldest entries overwritten
+    static uint8_t* _history;
+    static size_t _historyCapacity;
+    static size_t _historyHead;
+    static size_t _historyUsed;
+    static uint16_t _resendFirst[BTLOGGER_RESEND_QUEUE];
+    static uint16_t _resendCount[BTLOGGER_RESEND_QUEUE];
+    static uint8_t _resendQueued;
+    static uint32_t _resentCount;
+    static uint32_t _unavailableCount;
+
+    // Set by BTLogger's flow and level control writes (BLE task), read on every log call
+    static volatile uint8_t _flowMinLevel;
+    static volatile uint16_t _flowRate;
+    static uint32_t _flowWindowStart;
+    static uint16_t _flowWindowSent;
+    static volatile uint32_t _flowDropped;
+    static volatile uint8_t _remoteLevel;  // For all tags, BTLOGGER_WIRE_LEVEL_CLEAR when unset
+
+    // Per-tag levels by name; BTLOGGER_WIRE_LEVEL_CLEAR where unset
+    struct TagLevel {
+        char tag[sizeof(LogPacket::tag)];
+        uint8_t local;   // setTagLevel()
+        uint8_t remote;  // From BTLogger
+    };
+
+    // Tag pointer -> threshold, valid while its generation is current. The pointer is cleared
+    // while an entry is rewritten so a reader never pairs it with another tag's threshold.
+    struct TagCacheSlot {
+        const char* volatile tag;
+        volatile uint16_t entry;  // generation << 8 | threshold
+    };
+
+    static TagLevel _tagLevels[BTLOGGER_TAG_LEVELS];
+    static volatile uint8_t _tagLevelCount;
+    static TagCacheSlot _tagCache[BTLOGGER_TAG_CACHE_SLOTS];
+    static volatile uint8_t _tagGeneration;
+    static volatile esp_log_level_t _espGate;  // Most verbose level serial or any tag takes
+    static portMUX_TYPE _controlLock;
+
+    static uint32_t _notificationCount;
+    static SemaphoreHandle_t _sendMutex;
+    static esp_timer_handle_t _batchTimer;
+    static bool _batchingEnabled;
+    static uint16_t _batchLatencyMs;
+    static uint8_t _batchBuffer[BTLOGGER_COMPRESS_MAX_INPUT];
+    static BTLoggerBatch _batch;  // In _batchBuffer, limited to one notification at the peer MTU
+
+    static bool _compressionEnabled;
+    static uint8_t _peerFeatures;  // From the HELLO, cleared on disconnect
+    static uint8_t _compressBuffer[BTLOGGER_BATCH_MAX_PAYLOAD];
+    static uint8_t _compressWork[BTLOGGER_COMPRESS_WORK_SIZE(BTLOGGER_COMPRESS_MAX_INPUT)];
+    static uint16_t _compressTable[1 << BTLOGGER_COMPRESS_HASH_BITS];
+    static BTLoggerCompressor _compressor;
+    static uint32_t _compressedRawBytes;
+    static uint32_t _compressedWireBytes;
+
+    static uint8_t* _asyncRing;
+    static size_t _asyncCapacity;
+    static size_t _asyncHead;
+    static size_t _asyncTail;
+    static size_t _asyncUsed;
+    static portMUX_TYPE _asyncLock;
+    static TaskHandle_t _asyncTask;
+    static BTDropPolicy _dropPolicy;
+    static volatile uint32_t _droppedOldest;
+    static volatile uint32_t _droppedNewest;
+    static size_t _asyncPeakUsed;
+    static uint64_t _queueDelayTotalMs;  // Log call to send, sender task only
+    static uint32_t _queueDelayMaxMs;
+    static uint32_t _queueDelayCount;
+
+    // Format table for tokenized mode, keyed by format pointer; the text is kept in the arena
+    // and compared on every hit so a reused format buffer falls back to text
+    struct FormatEntry {
+        const char* format;
+        uint16_t offset;
+        uint8_t length;
+        uint8_t argCount;
+        uint8_t argKinds[BTLOGGER_TOKEN_MAX_ARGS];
+        bool tokenizable;
+    };
+
+    static bool _tokenizedEnabled;
+    static FormatEntry _formats[BTLOGGER_TOKEN_MAX_FORMATS];
+    static uint8_t _formatSlots[BTLOGGER_TOKEN_HASH_SLOTS];  // Format index + 1, 0 = empty
+    static char _formatArena[BTLOGGER_TOKEN_ARENA_BYTES];
+    static size_t _formatArenaUsed;
+    static uint16_t _formatCount;
+    static portMUX_TYPE _formatLock;
+    static uint8_t _formatAnnounced[BTLOGGER_TOKEN_MAX_FORMATS / 8];  // Sent on this connection
+    static uint32_t _tokenDropped;
+
+    struct LinkSettings {
+        uint16_t minInterval;
+        uint16_t maxInterval;
+        uint16_t latency;
+        uint16_t timeout;
+    };
+
+    static LinkSettings linkSettings(BTLinkProfile profile) {
+        switch (profile) {
+            case BT_LINK_LOW_LATENCY:
+                return {6, 12, 0, 400};
+            case BT_LINK_LOW_POWER:
+                return {80, 160, 4, 600};
+            case BT_LINK_HIGH_THROUGHPUT:
+            default:
+                return {12, 24, 0, 400};
+        }
+    }
+
+    // Request the profile's parameters on a fresh connection; BTLogger settles the final values
+    static void applyLinkProfile(esp_bd_addr_t address) {
+        LinkSettings settings = linkSettings(_linkProfile);
+        _server->updateConnParams(address, settings.minInterval, settings.maxInterval, settings.latency, settings.timeout);
+        if (_linkProfile != BT_LINK_LOW_POWER) {
+            esp_ble_gap_set_pkt_data_len(address, BTLOGGER_LINK_MAX_DATA_LENGTH);
+#if SOC_BLE_50_SUPPORTED
+            // BLE 5 controllers only; the classic ESP32 stays on 1M
+            esp_ble_gap_set_preferred_phy(address, 0, ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                          ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+        }
+    }
+
+    // Classify the arguments of a printf format; false if it cannot be tokenized
+    static bool parseFormat(const char* format, FormatEntry& entry) {
+        entry.argCount = 0;
+        for (const char* p = format; *p; p++) {
+            if (*p != '%') continue;
+            p++;
+            if (*p == '%') continue;
+
+            while (*p && strchr("-+ #0", *p)) p++;
+            if (*p == '*') {
+                if (entry.argCount >= BTLOGGER_TOKEN_MAX_ARGS) return false;
+                entry.argKinds[entry.argCount++] = BT_TOKEN_ARG_INT32;
+                p++;
+            }
+            while (*p >= '0' && *p <= '9') p++;
+            if (*p == '.') {
+                p++;
+                if (*p == '*') {
+                    if (entry.argCount >= BTLOGGER_TOKEN_MAX_ARGS) return false;
+                    entry.argKinds[entry.argCount++] = BT_TOKEN_ARG_INT32;
+                    p++;
+                }
+                while (*p >= '0' && *p <= '9') p++;
+            }
+
+            bool wide = false;  // 64-bit integer
+            if (*p == 'h') {
+                p++;
+                if (*p == 'h') p++;
+            } else if (*p == 'l') {
+                p++;
+                if (*p == 'l') {
+                    wide = true;
+                    p++;
+                } else if (*p == 'c' || *p == 's') {
+                    return false;  // Wide characters
+                }
+            } else if (*p == 'j') {
+                wide = true;
+                p++;
+            } else if (*p == 'z' || *p == 't') {
+                p++;
+            } else if (*p == 'L' || *p == 'q') {
+                return false;
+            }
+
+            uint8_t kind;
+            if (*p && strchr("diouxXc", *p)) {
+                kind = wide ? BT_TOKEN_ARG_INT64 : BT_TOKEN_ARG_INT32;
+            } else if (*p && strchr("fFeEgGaA", *p)) {
+                kind = BT_TOKEN_ARG_DOUBLE;
+            } else if (*p == 's') {
+                kind = BT_TOKEN_ARG_STRING;
+            } else if (*p == 'p') {
+                kind = BT_TOKEN_ARG_INT32;
+            } else {
+                return false;  // %n, or something we do not know how to carry
+            }
+
+            if (entry.argCount >= BTLOGGER_TOKEN_MAX_ARGS) return false;
+            entry.argKinds[entry.argCount++] = kind;
+        }
+        return true;
+    }
+
+    // Format id for a format string, registering it on first use; BTLOGGER_TOKEN_NONE means send text
+    static uint16_t lookupFormat(const char* format) {
+        uint32_t hash = (uint32_t)(((uintptr_t)format >> 2) * 2654435761u);
+        size_t slot = (hash >> 16) & (BTLOGGER_TOKEN_HASH_SLOTS - 1);
+
+        uint16_t index = BTLOGGER_TOKEN_NONE;
+        portENTER_CRITICAL_SAFE(&_formatLock);
+        for (size_t probe = 0; probe < BTLOGGER_TOKEN_HASH_SLOTS; probe++) {
+            uint8_t value = _formatSlots[slot];
+            if (value == 0) {
+                // First use of this pointer - copy the text and classify its arguments
+                size_t length = strnlen(format, 256);
+                if (_formatCount >= BTLOGGER_TOKEN_MAX_FORMATS || length > 255 ||
+                    _formatArenaUsed + length > sizeof(_formatArena)) {
+                    break;
+                }
+                FormatEntry& entry = _formats[_formatCount];
+                entry.format = format;
+                entry.offset = _formatArenaUsed;
+                entry.length = length;
+                entry.tokenizable = parseFormat(format, entry);
+                memcpy(_formatArena + _formatArenaUsed, format, length);
+                _formatArenaUsed += length;
+                index = _formatCount++;
+                _formatSlots[slot] = index + 1;
+                break;
+            }
+            if (_formats[value - 1].format == format) {
+                index = value - 1;
+                break;
+            }
+            slot = (slot + 1) & (BTLOGGER_TOKEN_HASH_SLOTS - 1);
+        }
+        portEXIT_CRITICAL_SAFE(&_formatLock);
+
+        if (index == BTLOGGER_TOKEN_NONE) return BTLOGGER_TOKEN_NONE;
+
+        // Entries never change once written, so they can be read without the lock
+        const FormatEntry& entry = _formats[index];
+        if (!entry.tokenizable || strncmp(format, _formatArena + entry.offset, entry.length) != 0 ||
+            format[entry.length] != '\0') {
+            return BTLOGGER_TOKEN_NONE;
+        }
+        return index;
+    }
+
+    // Write [formatId][args] into body; 0 if the arguments do not fit
+    static size_t encodeTokenized(uint16_t formatId, va_list args, uint8_t* body, size_t capacity) {
+        const FormatEntry& entry = _formats[formatId];
+        if (capacity < 2) return 0;
+        memcpy(body, &formatId, 2);
+        size_t length = 2;
+
+        for (uint8_t i = 0; i < entry.argCount; i++) {
+            switch (entry.argKinds[i]) {
+                case BT_TOKEN_ARG_INT32: {
+                    if (length + 4 > capacity) return 0;
+                    uint32_t value = va_arg(args, uint32_t);
+                    memcpy(body + length, &value, 4);
+                    length += 4;
+                    break;
+                }
+                case BT_TOKEN_ARG_INT64: {
+                    if (length + 8 > capacity) return 0;
+                    uint64_t value = va_arg(args, uint64_t);
+                    memcpy(body + length, &value, 8);
+                    length += 8;
+                    break;
+                }
+                case BT_TOKEN_ARG_DOUBLE: {
+                    if (length + 8 > capacity) return 0;
+                    double value = va_arg(args, double);
+                    memcpy(body + length, &value, 8);
+                    length += 8;
+                    break;
+                }
+                default: {
+                    const char* value = va_arg(args, const char*);
+                    if (!value) value = "(null)";
+                    size_t stringLength = strnlen(value, 255);
+                    if (length + 1 + stringLength > capacity) return 0;
+                    body[length++] = (uint8_t)stringLength;
+                    memcpy(body + length, value, stringLength);
+                    length += stringLength;
+                    break;
+                }
+            }
+        }
+        return length;
+    }
+
+    static uint16_t tokenFormatId(const char* body) {
+        uint16_t formatId;
+        memcpy(&formatId, body, 2);
+        return formatId;
+    }
+
+    // Send the dictionary frame for a format unless this connection already has it
+    static bool announceFormatLocked(uint16_t formatId) {
+        if (formatId >= _formatCount) return false;
+        if (_formatAnnounced[formatId / 8] & (1 << (formatId % 8))) return true;
+
+        const FormatEntry& entry = _formats[formatId];
+        size_t length = sizeof(BTLoggerWireFrameHeader) + 3 + entry.length;
+        uint16_t mtu = _server ? _server->getPeerMTU(_server->getConnId()) : 23;
+        if (length + 3 > mtu) {
+            return false;  // The receiver could never resolve this id
+        }
+
+        BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_DICT};
+        memcpy(_frameBuffer, &frame, sizeof(frame));
+        memcpy(_frameBuffer + sizeof(frame), &formatId, 2);
+        _frameBuffer[sizeof(frame) + 2] = entry.length;
+        memcpy(_frameBuffer + sizeof(frame) + 3, _formatArena + entry.offset, entry.length);
+        notifyLocked(_frameBuffer, length);
+
+        _formatAnnounced[formatId / 8] |= 1 << (formatId % 8);
+        return true;
+    }
+
+    // Hand a record to the async ring if enabled, otherwise send it on the calling task
+    static void submitRecord(uint32_t timestamp, uint8_t level, const char* tag, const char* message) {
+        submitRecord(timestamp, level, tag, message, strnlen(message, sizeof(LogPacket::message) - 1), 0);
+    }
+
+    // The message is text, or a tokenized argument block when flags has BTLOGGER_WIRE_FLAG_TOKENIZED
+    static void submitRecord(uint32_t timestamp, uint8_t level, const char* tag, const char* message, size_t messageLength,
+                             uint8_t flags) {
+        if (_asyncRing) {
+            enqueueRecord(timestamp, level, tag, message, messageLength, flags);
+        } else {
+            sendRecord(timestamp, level, tag, message, messageLength, flags);
+        }
+    }
+
+    // Hot path: copy into the ring under a short critical section, wake the sender task
+    static void enqueueRecord(uint32_t timestamp, uint8_t level, const char* tag, const char* message, size_t messageLength,
+                              uint8_t flags) {
+        BTLoggerQueuedRecord record;
+        record.timestamp = timestamp;
+        record.level = level;
+        record.flags = flags;
+        record.tagLength = (uint8_t)strnlen(tag, sizeof(LogPacket::tag) - 1);
+        record.messageLength = (uint16_t)messageLength;
+
+        size_t needed = sizeof(record) + record.tagLength + record.messageLength;
+        if (needed > _asyncCapacity) {
+            _droppedNewest++;
+            return;
+        }
+
+        bool accepted = true;
+        portENTER_CRITICAL_SAFE(&_asyncLock);
+        while (_asyncCapacity - _asyncUsed < needed) {
+            if (_dropPolicy == BT_DROP_NEWEST) {
+                accepted = false;
+                break;
+            }
+
+            // Drop the oldest queued record to make room
+            BTLoggerQueuedRecord oldest;
+            ringRead(_asyncTail, (uint8_t*)&oldest, sizeof(oldest));
+            size_t oldestSize = sizeof(oldest) + oldest.tagLength + oldest.messageLength;
+            _asyncTail = (_asyncTail + oldestSize) % _asyncCapacity;
+            _asyncUsed -= oldestSize;
+            _droppedOldest++;
+        }
+
+        if (accepted) {
+            ringWrite(_asyncHead, (const uint8_t*)&record, sizeof(record));
+            ringWrite(_asyncHead + sizeof(record), (const uint8_t*)tag, record.tagLength);
+            ringWrite(_asyncHead + sizeof(record) + record.tagLength, (const uint8_t*)message, record.messageLength);
+            _asyncHead = (_asyncHead + needed) % _asyncCapacity;
+            _asyncUsed += needed;
+            if (_asyncUsed > _asyncPeakUsed) {
+                _asyncPeakUsed = _asyncUsed;
+            }
+        } else {
+            _droppedNewest++;
+        }
+        portEXIT_CRITICAL_SAFE(&_asyncLock);
+
+        if (!accepted || !_asyncTask) return;
+
+        if (xPortInIsrContext()) {
+            BaseType_t higherPriorityTaskWoken = pdFALSE;
+            vTaskNotifyGiveFromISR(_asyncTask, &higherPriorityTaskWoken);
+            portYIELD_FROM_ISR(higherPriorityTaskWoken);
+        } else {
+            xTaskNotifyGive(_asyncTask);
+        }
+    }
+
+    // Pop the oldest record; tag and message are NUL terminated
+    static bool dequeueRecord(BTLoggerQueuedRecord& record, char* tag, char* message) {
+        bool found = false;
+        portENTER_CRITICAL_SAFE(&_asyncLock);
+        if (_asyncUsed > 0) {
+            ringRead(_asyncTail, (uint8_t*)&record, sizeof(record));
+            ringRead(_asyncTail + sizeof(record), (uint8_t*)tag, record.tagLength);
+            ringRead(_asyncTail + sizeof(record) + record.tagLength, (uint8_t*)message, record.messageLength);
+
+            size_t size = sizeof(record) + record.tagLength + record.messageLength;
+            _asyncTail = (_asyncTail + size) % _asyncCapacity;
+            _asyncUsed -= size;
+            found = true;
+        }
+        portEXIT_CRITICAL_SAFE(&_asyncLock);
+
+        if (found) {
+            tag[record.tagLength] = '\0';
+            message[record.messageLength] = '\0';
+        }
+        return found;
+    }
+
+    static void ringWrite(size_t offset, const uint8_t* data, size_t length) {
+        offset %= _asyncCapacity;
+        size_t first = length < _asyncCapacity - offset ? length : _asyncCapacity - offset;
+        memcpy(_asyncRing + offset, data, first);
+        memcpy(_asyncRing, data + first, length - first);
+    }
+
+    static void ringRead(size_t offset, uint8_t* data, size_t length) {
+        offset %= _asyncCapacity;
+        size_t first = length < _asyncCapacity - offset ? length : _asyncCapacity - offset;
+        memcpy(data, _asyncRing + offset, first);
+        memcpy(data + first, _asyncRing, length - first);
+    }
+
+    // Background task: drain the ring into BLE whenever producers signal new records
+    static void asyncSenderTask(void* parameter) {
+        BTLoggerQueuedRecord record;
+        char tag[sizeof(LogPacket::tag)];
+        char message[sizeof(LogPacket::message)];
+
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+            while (dequeueRecord(record, tag, message)) {
+                uint32_t delay = millis() - record.timestamp;
+                _queueDelayTotalMs += delay;
+                _queueDelayCount++;
+                if (delay > _queueDelayMaxMs) {
+                    _queueDelayMaxMs = delay;
+                }
+                if (canAccept()) {
+                    sendRecord(record.timestamp, record.level, tag, message, record.messageLength, record.flags);
+                }
+            }
+        }
+    }
+
+    // Records are accepted once the BLE service is up, or earlier when the backlog can hold them
+    static bool canAccept() { return (_initialized && _logCharacteristic) || _backlog; }
+
+    // Level (the tag's, else BTLogger's for all tags, else our own) and flow window, before any formatting
+    static bool admit(uint8_t level, const char* tag) {
+        uint8_t threshold = tagThreshold(tag);
+        if (threshold == BTLOGGER_WIRE_LEVEL_CLEAR) {
+            threshold = globalLevel();
+        }
+        if (level < threshold) {
+            return false;
+        }
+
+        bool allowed = level >= _flowMinLevel;
+        if (allowed && _flowRate > 0 && level < BT_WARN) {
+            portENTER_CRITICAL_SAFE(&_controlLock);
+            uint32_t now = millis();
+            if (now - _flowWindowStart >= 1000) {
+                _flowWindowStart = now;
+                _flowWindowSent = 0;
+            }
+            allowed = _flowWindowSent < _flowRate;
+            if (allowed) {
+                _flowWindowSent++;
+            }
+            portEXIT_CRITICAL_SAFE(&_controlLock);
+        }
+        if (!allowed) {
+            _flowDropped++;
+        }
+        return allowed;
+    }
+
+    static uint8_t globalLevel() { return _remoteLevel != BTLOGGER_WIRE_LEVEL_CLEAR ? _remoteLevel : (uint8_t)_btLogLevel; }
+
+    // The tag's own level, BTLOGGER_WIRE_LEVEL_CLEAR if it has none
+    static uint8_t tagThreshold(const char* tag) {
+        if (_tagLevelCount == 0 || !tag) {
+            return BTLOGGER_WIRE_LEVEL_CLEAR;
+        }
+
+        TagCacheSlot& slot = _tagCache[(((uintptr_t)tag >> 2) * 2654435761u >> 16) & (BTLOGGER_TAG_CACHE_SLOTS - 1)];
+        uint16_t entry = slot.entry;
+        if (slot.tag == tag && (entry >> 8) == _tagGeneration) {
+            return entry & 0xFF;
+        }
+
+        // First call from this tag pointer since the table changed: look it up by name
+        portENTER_CRITICAL_SAFE(&_controlLock);
+        uint8_t threshold = BTLOGGER_WIRE_LEVEL_CLEAR;
+        for (uint8_t i = 0; i < _tagLevelCount; i++) {
+            if (strncmp(_tagLevels[i].tag, tag, sizeof(_tagLevels[i].tag) - 1) == 0) {
+                threshold = _tagLevels[i].remote != BTLOGGER_WIRE_LEVEL_CLEAR ? _tagLevels[i].remote : _tagLevels[i].local;
+                break;
+            }
+        }
+        slot.tag = nullptr;
+        slot.entry = (uint16_t)(_tagGeneration << 8) | threshold;
+        slot.tag = tag;
+        portEXIT_CRITICAL_SAFE(&_controlLock);
+        return threshold;
+    }
+
+    static bool setTagLevelEntry(const char* tag, size_t tagLength, uint8_t level, bool remote) {
+        if (!tag) return false;
+        if (tagLength >= sizeof(TagLevel::tag)) {
+            tagLength = sizeof(TagLevel::tag) - 1;
+        }
+
+        bool stored = true;
+        portENTER_CRITICAL_SAFE(&_controlLock);
+        uint8_t index = 0;
+        while (index < _tagLevelCount &&
+               !(strncmp(_tagLevels[index].tag, tag, tagLength) == 0 && _tagLevels[index].tag[tagLength] == '\0')) {
+            index++;
+        }
+        if (index == _tagLevelCount && level != BTLOGGER_WIRE_LEVEL_CLEAR) {
+            stored = index < BTLOGGER_TAG_LEVELS;
+            if (stored) {
+                memcpy(_tagLevels[index].tag, tag, tagLength);
+                _tagLevels[index].tag[tagLength] = '\0';
+                _tagLevels[index].local = BTLOGGER_WIRE_LEVEL_CLEAR;
+                _tagLevels[index].remote = BTLOGGER_WIRE_LEVEL_CLEAR;
+                _tagLevelCount++;
+            }
+        }
+        if (stored && index < _tagLevelCount) {
+            TagLevel& entry = _tagLevels[index];
+            (remote ? entry.remote : entry.local) = level;
+            if (entry.local == BTLOGGER_WIRE_LEVEL_CLEAR && entry.remote == BTLOGGER_WIRE_LEVEL_CLEAR) {
+                entry = _tagLevels[--_tagLevelCount];
+            }
+            invalidateTagCacheLocked();
+        }
+        portEXIT_CRITICAL_SAFE(&_controlLock);
+        updateFloor();
+        return stored;
+    }
+
+    static void invalidateTagCacheLocked() {
+        if (++_tagGeneration == 0) {
+            memset(_tagCache, 0, sizeof(_tagCache));  // Wrapped; old entries would look current again
+        }
+    }
+
+    // Recompute the inline gate: the most verbose level serial, the global level or any tag takes
+    static void updateFloor() {
+        portENTER_CRITICAL_SAFE(&_controlLock);
+        uint8_t floor = globalLevel();
+        for (uint8_t i = 0; i < _tagLevelCount; i++) {
+            uint8_t level = _tagLevels[i].remote != BTLOGGER_WIRE_LEVEL_CLEAR ? _tagLevels[i].remote : _tagLevels[i].local;
+            floor = level < floor ? level : floor;
+        }
+        floor = floor > _flowMinLevel ? floor : _flowMinLevel;
+        esp_log_level_t btGate = floor > BT_ERROR ? ESP_LOG_NONE : (esp_log_level_t)(ESP_LOG_ERROR + BT_ERROR - floor);
+        _espGate = btGate > _espLogLevel ? btGate : _espLogLevel;
+        portEXIT_CRITICAL_SAFE(&_controlLock);
+    }
+
+    static void setRemoteLevel(const char* tag, size_t tagLength, uint8_t level) {
+        if (tagLength == 0) {
+            _remoteLevel = level;
+            updateFloor();
+            return;
+        }
+        setTagLevelEntry(tag, tagLength, level, true);
+    }
+
+    // Disconnected: BTLogger's limits and levels were for that connection
+    static void resetRemoteControl() {
+        portENTER_CRITICAL_SAFE(&_controlLock);
+        _flowMinLevel = 0;
+        _flowRate = 0;
+        _remoteLevel = BTLOGGER_WIRE_LEVEL_CLEAR;
+        for (uint8_t i = 0; i < _tagLevelCount;) {
+            _tagLevels[i].remote = BTLOGGER_WIRE_LEVEL_CLEAR;
+            if (_tagLevels[i].local == BTLOGGER_WIRE_LEVEL_CLEAR) {
+                _tagLevels[i] = _tagLevels[--_tagLevelCount];
+            } else {
+                i++;
+            }
+        }
+        invalidateTagCacheLocked();
+        portEXIT_CRITICAL_SAFE(&_controlLock);
+        updateFloor();
+    }
+
+    static bool backlogPendingLocked() { return _backlogUsed > 0 || _spillHead > _spillTail; }
+
+    // Store a record in wire format, written straight into the RAM ring or the flash spill
+    static void backlogAppendLocked(uint32_t timestamp, uint8_t level, const char* tag, const char* message,
+                                    size_t messageLength, uint8_t flags) {
+        BTLoggerWireRecordHeader record = {timestamp, level, (uint8_t)(flags | BTLOGGER_WIRE_FLAG_REPLAYED),
+                                           (uint8_t)strnlen(tag, sizeof(LogPacket::tag) - 1), (uint16_t)messageLength};
+        size_t needed = sizeof(record) + record.tagLength + record.messageLength;
+
+        // Once records spill to flash, later ones follow them there to keep the order
+        if (_spillPartition && (_spillHead > _spillTail || _backlogCapacity - _backlogUsed < needed)) {
+            if (!spillAppendLocked(record, tag, message)) {
+                _backlogDropped++;
+            }
+            return;
+        }
+
+        if (needed > _backlogCapacity) {
+            _backlogDropped++;
+            return;
+        }
+
+        while (_backlogCapacity - _backlogUsed < needed) {
+            if (_backlogPolicy == BT_DROP_NEWEST) {
+                _backlogDropped++;
+                return;
+            }
+
+            BTLoggerWireRecordHeader oldest;
+            backlogRead(_backlogTail, (uint8_t*)&oldest, sizeof(oldest));
+            size_t oldestSize = sizeof(oldest) + oldest.tagLength + oldest.messageLength;
+            _backlogTail = (_backlogTail + oldestSize) % _backlogCapacity;
+            _backlogUsed -= oldestSize;
+            _backlogDropped++;
+        }
+
+        backlogWrite(_backlogHead, (const uint8_t*)&record, sizeof(record));
+        backlogWrite(_backlogHead + sizeof(record), (const uint8_t*)tag, record.tagLength);
+        backlogWrite(_backlogHead + sizeof(record) + record.tagLength, (const uint8_t*)message, record.messageLength);
+        _backlogHead = (_backlogHead + needed) % _backlogCapacity;
+        _backlogUsed += needed;
+    }
+
+    static bool spillAppendLocked(const BTLoggerWireRecordHeader& record, const char* tag, const char* message) {
+        size_t needed = sizeof(record) + record.tagLength + record.messageLength;
+        if (_spillHead + needed > _spillPartition->size) return false;
+
+        // Erase each sector the first time the head enters it
+        size_t sector = (_spillHead + BTLOGGER_SPILL_SECTOR_SIZE - 1) / BTLOGGER_SPILL_SECTOR_SIZE * BTLOGGER_SPILL_SECTOR_SIZE;
+        for (; sector < _spillHead + needed; sector += BTLOGGER_SPILL_SECTOR_SIZE) {
+            if (esp_partition_erase_range(_spillPartition, sector, BTLOGGER_SPILL_SECTOR_SIZE) != ESP_OK) return false;
+        }
+
+        esp_partition_write(_spillPartition, _spillHead, &record, sizeof(record));
+        esp_partition_write(_spillPartition, _spillHead + sizeof(record), tag, record.tagLength);
+        esp_partition_write(_spillPartition, _spillHead + sizeof(record) + record.tagLength, message, record.messageLength);
+        _spillHead += needed;
+        return true;
+    }
+
+    // Oldest backlog record: RAM first, then the flash spill (which only holds newer records)
+    static bool backlogFrontLocked(BTLoggerWireRecordHeader& record) {
+        if (_backlogUsed > 0) {
+            backlogRead(_backlogTail, (uint8_t*)&record, sizeof(record));
+            return true;
+        }
+        if (_spillHead > _spillTail) {
+            esp_partition_read(_spillPartition, _spillTail, &record, sizeof(record));
+            return true;
+        }
+        return false;
+    }
+
+    // Copy the oldest record (header included) to destination and remove it
+    static void backlogPopLocked(uint8_t* destination, size_t length) {
+        if (_backlogUsed > 0) {
+            backlogRead(_backlogTail, destination, length);
+            _backlogTail = (_backlogTail + length) % _backlogCapacity;
+            _backlogUsed -= length;
+            return;
+        }
+
+        esp_partition_read(_spillPartition, _spillTail, destination, length);
+        _spillTail += length;
+        if (_spillTail >= _spillHead) {
+            _spillHead = 0;
+            _spillTail = 0;
+        }
+    }
+
+    static void backlogWrite(size_t offset, const uint8_t* data, size_t length) {
+        offset %= _backlogCapacity;
+        size_t first = length < _backlogCapacity - offset ? length : _backlogCapacity - offset;
+        memcpy(_backlog + offset, data, first);
+        memcpy(_backlog, data + first, length - first);
+    }
+
+    static void backlogRead(size_t offset, uint8_t* data, size_t length) {
+        offset %= _backlogCapacity;
+        size_t first = length < _backlogCapacity - offset ? length : _backlogCapacity - offset;
+        memcpy(data, _backlog + offset, first);
+        memcpy(data + first, _backlog, length - first);
+    }
+
+    // Send up to maxNotifications of backlog, packing whole records straight into full-MTU
+    // batch frames; returns true while records remain
+    static bool replayBacklogLocked(size_t maxNotifications) {
+        BTLoggerWireRecordHeader record;
+        size_t recordLength = 0;
+        for (size_t sent = 0; sent < maxNotifications && nextReplayableLocked(record, recordLength); sent++) {
+            if (_wireVersion >= BTLOGGER_WIRE_BATCH_VERSION) {
+                size_t limit = notificationLimit();
+
+                BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_BATCH};
+                memcpy(_batchBuffer, &frame, sizeof(frame));
+                size_t length = batchHeaderLength();
+                uint8_t count = 0;
+                while (count < 255 && length + recordLength <= limit) {
+                    backlogPopLocked(_batchBuffer + length, recordLength);
+                    length += recordLength;
+                    count++;
+                    if (!nextReplayableLocked(record, recordLength)) break;
+                }
+
+                if (count > 0) {
+                    sealBatchLocked(_batchBuffer, length, count);
+                    notifyBatchLocked(_batchBuffer, length, limit);
+                    continue;
+                }
+                // Too large for a batch at this MTU - fall through and send it on its own
+            }
+
+            BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_RECORD};
+            memcpy(_frameBuffer, &frame, sizeof(frame));
+            size_t recordStart = sizeof(frame) + sequenceLength();
+            backlogPopLocked(_frameBuffer + recordStart, recordLength);
+
+            if (_wireVersion > 0) {
+                sealRecordLocked(_frameBuffer, recordStart, recordLength);
+                notifyLocked(_frameBuffer, recordStart + recordLength);
+            } else {
+                // Legacy receivers get the fixed packet; the replayed flag cannot be carried
+                const char* body = (const char*)_frameBuffer + recordStart + sizeof(record);
+                LogPacket packet;
+                packet.timestamp = record.timestamp;
+                packet.level = record.level;
+                packet.length = record.messageLength;
+                memcpy(packet.tag, body, record.tagLength);
+                packet.tag[record.tagLength] = '\0';
+                memcpy(packet.message, body + record.tagLength, record.messageLength);
+                packet.message[record.messageLength] = '\0';
+                notifyLocked((uint8_t*)&packet, sizeof(LogPacket));
+            }
+        }
+        return backlogPendingLocked();
+    }
+
+    // Peek the oldest record the receiver can decode, discarding tokenized ones it cannot.
+    // A format sent here goes out ahead of the batch being packed, so ordering holds.
+    static bool nextReplayableLocked(BTLoggerWireRecordHeader& record, size_t& recordLength) {
+        while (backlogFrontLocked(record)) {
+            recordLength = sizeof(record) + record.tagLength + record.messageLength;
+            if (prepareReplayLocked(record, recordLength)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool prepareReplayLocked(const BTLoggerWireRecordHeader& record, size_t recordLength) {
+        if (!(record.flags & BTLOGGER_WIRE_FLAG_TOKENIZED)) return true;
+
+        uint16_t formatId = BTLOGGER_TOKEN_NONE;
+        if (record.messageLength >= 2) {
+            size_t offset = sizeof(record) + record.tagLength;
+            if (_backlogUsed > 0) {
+                backlogRead(_backlogTail + offset, (uint8_t*)&formatId, 2);
+            } else {
+                esp_partition_read(_spillPartition, _spillTail + offset, &formatId, 2);
+            }
+        }
+
+        if (_wireVersion >= BTLOGGER_WIRE_TOKEN_VERSION && announceFormatLocked(formatId)) {
+            return true;
+        }
+
+        uint8_t discard[sizeof(record) + 31 + 255];
+        backlogPopLocked(discard, recordLength);
+        _tokenDropped++;
+        return false;
+    }
+
+    // (Re)arm the replay; runs on the esp_timer task so the BLE callbacks never block on notify()
+    static void scheduleReplay(uint32_t delayMs) {
+        if (!_replayTimer) return;
+        esp_timer_stop(_replayTimer);
+        esp_timer_start_once(_replayTimer, delayMs > 0 ? (uint64_t)delayMs * 1000 : 1000);
+    }
+
+    static void replayTimerCallback(void* arg) {
+        if (!_sendMutex) return;
+
+        xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        bool more = false;
+        if (isConnected()) {
+            _linkReady = true;
+            // Resends first: BTLogger is waiting on them to close its gaps
+            if (_resendQueued > 0) {
+                flushBatchLocked();
+                more = serviceResendLocked(BTLOGGER_BACKLOG_REPLAY_BURST);
+            }
+            if (!more && _backlog && backlogPendingLocked()) {
+                flushBatchLocked();
+                more = replayBacklogLocked(BTLOGGER_BACKLOG_REPLAY_BURST);
+            }
+        }
+        xSemaphoreGive(_sendMutex);
+
+        if (more) {
+            scheduleReplay(0);
+        }
+    }
+
+    // Encode a record in the negotiated wire format and notify (or batch) it
+    static void sendRecord(uint32_t timestamp, uint8_t level, const char* tag, const char* message, size_t messageLength,
+                           uint8_t flags) {
+        if (!_sendMutex) return;
+
+        xSemaphoreTake(_sendMutex, portMAX_DELAY);
+
+        // Nobody listening yet, or older records still waiting to be replayed
+        if (_backlog && (!_linkReady || !isConnected() || backlogPendingLocked())) {
+            backlogAppendLocked(timestamp, level, tag, message, messageLength, flags);
+            xSemaphoreGive(_sendMutex);
+            return;
+        }
+
+        if (!_logCharacteristic) {
+            xSemaphoreGive(_sendMutex);  // Before begin(), and no backlog to keep it
+            return;
+        }
+
+        // Tokenized records need a v3 receiver that has been sent their format string
+        if ((flags & BTLOGGER_WIRE_FLAG_TOKENIZED) &&
+            (_wireVersion < BTLOGGER_WIRE_TOKEN_VERSION || !announceFormatLocked(tokenFormatId(message)))) {
+            _tokenDropped++;
+            xSemaphoreGive(_sendMutex);
+            return;
+        }
+
+        if (_wireVersion == 0) {
+            sendLegacyLocked(timestamp, level, tag, message, messageLength);
+        } else if (_batchingEnabled && _wireVersion >= BTLOGGER_WIRE_BATCH_VERSION) {
+            appendToBatchLocked(timestamp, level, flags, tag, message, messageLength);
+            if (level >= BT_ERROR) {
+                flushBatchLocked();
+            }
+        } else {
+            sendSingleLocked(timestamp, level, flags, tag, message, messageLength);
+        }
+
+        xSemaphoreGive(_sendMutex);
+    }
+
+    static void sendLegacyLocked(uint32_t timestamp, uint8_t level, const char* tag, const char* message, size_t messageLength) {
+        LogPacket packet;
+        packet.timestamp = timestamp;
+        packet.level = level;
+
+        packet.length = messageLength < sizeof(packet.message) - 1 ? messageLength : sizeof(packet.message) - 1;
+        memcpy(packet.message, message, packet.length);
+        packet.message[packet.length] = '\0';
+
+        strncpy(packet.tag, tag, sizeof(packet.tag) - 1);
+        packet.tag[sizeof(packet.tag) - 1] = '\0';
+
+        notifyLocked((uint8_t*)&packet, sizeof(LogPacket));
+    }
+
+    static void sendSingleLocked(uint32_t timestamp, uint8_t level, uint8_t flags, const char* tag, const char* message,
+                                 size_t messageLength) {
+        BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_RECORD};
+        memcpy(_frameBuffer, &frame, sizeof(frame));
+
+        size_t start = sizeof(frame) + sequenceLength();
+        size_t recordLength = btLoggerEncodeRecord(_frameBuffer + start, timestamp, level, flags, tag, message, messageLength);
+        sealRecordLocked(_frameBuffer, start, recordLength);
+        notifyLocked(_frameBuffer, start + recordLength);
+    }
+
+    static void appendToBatchLocked(uint32_t timestamp, uint8_t level, uint8_t flags, const char* tag, const char* message,
+                                    size_t messageLength) {
+        size_t recordLength = btLoggerRecordLength(tag, messageLength);
+
+        // Compressed batches may hold more raw bytes than one notification
+        size_t capacity = isCompressionActive() ? sizeof(_batchBuffer) : _batch.getLimit();
+
+        // Make room if this record would overflow the current batch
+        if (!_batch.isEmpty() && (_batch.getLength() + recordLength > capacity || _batch.getCount() == 255)) {
+            flushBatchLocked();
+        }
+
+        if (_batch.isEmpty()) {
+            size_t limit = notificationLimit();
+            capacity = isCompressionActive() ? sizeof(_batchBuffer) : limit;
+
+            // Too small to hold even this record as a batch - send it on its own
+            if (batchHeaderLength() + recordLength > limit) {
+                sendSingleLocked(timestamp, level, flags, tag, message, messageLength);
+                return;
+            }
+
+            // The first sequence is stamped now, so what is compressed is what will be sent
+            _batch.open(_wireVersion, batchHeaderLength(), limit);
+            stampBatchLocked(_batch.data(), 0);
+
+            if (_batchTimer) {
+                esp_timer_start_once(_batchTimer, (uint64_t)_batchLatencyMs * 1000);
+            }
+        }
+
+        // Past one MTU the batch is only kept if it still compresses into one notification
+        if (!_batch.add(timestamp, level, flags, tag, message, messageLength, isCompressionActive() ? &_compressor : nullptr,
+                        _compressBuffer)) {
+            flushBatchLocked();
+            appendToBatchLocked(timestamp, level, flags, tag, message, messageLength);  // Fits raw in a fresh batch
+            return;
+        }
+
+        if (_batch.getLength() + sizeof(BTLoggerWireRecordHeader) >= capacity) {
+            flushBatchLocked();
+        }
+    }
+
+    static void flushBatchLocked() {
+        if (_batch.isEmpty()) return;
+
+        if (_batchTimer) {
+            esp_timer_stop(_batchTimer);
+        }
+
+        if (_batch.needsSplit(_compressor, _compressBuffer)) {
+            sealBatchLocked(_batch.data(), _batch.getSplitLength(), _batch.getSplitCount());
+            notifyBatchLocked(_batch.data(), _batch.getSplitLength(), _batch.getLimit());
+            _batch.dropSplit(batchHeaderLength());
+        }
+
+        sealBatchLocked(_batch.data(), _batch.getLength(), _batch.getCount());
+        notifyBatchLocked(_batch.data(), _batch.getLength(), _batch.getLimit());
+        _batch.clear();
+    }
+
+    // Send a batch frame, compressed when the peer supports it and that makes it smaller.
+    // A frame longer than limit is only ever passed in when it is known to compress below it.
+    static void notifyBatchLocked(uint8_t* frame, size_t length, size_t limit) {
+        if (!isCompressionActive()) {
+            notifyLocked(frame, length);
+            return;
+        }
+
+        size_t packed = _compressor.compressFrame(frame, length, _compressBuffer,
+                                                  limit < sizeof(_compressBuffer) ? limit : sizeof(_compressBuffer));
+        _compressedRawBytes += length;
+        if (packed > 0 && packed < length) {
+            _compressedWireBytes += packed;
+            notifyLocked(_compressBuffer, packed);
+        } else {
+            _compressedWireBytes += length;
+            notifyLocked(frame, length);
+        }
+    }
+
+    // Largest notification at the MTU BTLogger negotiated for this connection
+    static size_t notificationLimit() {
+        uint16_t mtu = _server ? _server->getPeerMTU(_server->getConnId()) : 23;
+        size_t limit = mtu > 3 ? mtu - 3 : 20;
+        return limit > BTLOGGER_BATCH_MAX_PAYLOAD ? BTLOGGER_BATCH_MAX_PAYLOAD : limit;
+    }
+
+    static size_t sequenceLength() { return _wireVersion >= BTLOGGER_WIRE_SEQUENCE_VERSION ? 2 : 0; }
+    static size_t batchHeaderLength() { return sizeof(BTLoggerWireFrameHeader) + 1 + sequenceLength(); }
+
+    // Number the record of a record frame and keep a copy of it for resends
+    static void sealRecordLocked(uint8_t* frame, size_t recordOffset, size_t recordLength) {
+        if (sequenceLength() == 0) return;
+        uint16_t sequence = _nextSequence++;
+        memcpy(frame + sizeof(BTLoggerWireFrameHeader), &sequence, sizeof(sequence));
+        historyAppendLocked(sequence, frame + recordOffset, recordLength);
+    }
+
+    // Fill in a batch's count and first sequence
+    static void stampBatchLocked(uint8_t* frame, uint8_t count) {
+        frame[sizeof(BTLoggerWireFrameHeader)] = count;
+        if (sequenceLength() == 0) return;
+
+        uint16_t first = _nextSequence;
+        memcpy(frame + sizeof(BTLoggerWireFrameHeader) + 1, &first, sizeof(first));
+    }
+
+    // Stamp a batch, keeping a copy of each record for resends
+    static void sealBatchLocked(uint8_t* frame, size_t length, uint8_t count) {
+        stampBatchLocked(frame, count);
+        if (sequenceLength() == 0) return;
+
+        uint16_t first = _nextSequence;
+        size_t offset = batchHeaderLength();
+        for (uint8_t i = 0; i < count && offset + sizeof(BTLoggerWireRecordHeader) <= length; i++) {
+            BTLoggerWireRecordHeader record;
+            memcpy(&record, frame + offset, sizeof(record));
+            size_t recordLength = sizeof(record) + record.tagLength + record.messageLength;
+            historyAppendLocked(first + i, frame + offset, recordLength);
+            offset += recordLength;
+        }
+        _nextSequence = first + count;
+    }
+
+    static void historyAppendLocked(uint16_t sequence, const uint8_t* record, size_t length) {
+        size_t needed = sizeof(sequence) + length;
+        if (!_history || needed > _historyCapacity) return;
+
+        // The oldest entries make room
+        while (_historyCapacity - _historyUsed < needed) {
+            BTLoggerWireRecordHeader oldest;
+            historyRead(historyTail() + sizeof(sequence), (uint8_t*)&oldest, sizeof(oldest));
+            _historyUsed -= sizeof(sequence) + sizeof(oldest) + oldest.tagLength + oldest.messageLength;
+        }
+        historyWrite(_historyHead, (const uint8_t*)&sequence, sizeof(sequence));
+        historyWrite(_historyHead + sizeof(sequence), record, length);
+        _historyHead = (_historyHead + needed) % _historyCapacity;
+        _historyUsed += needed;
+    }
+
+    static size_t historyTail() { return (_historyHead + _historyCapacity - _historyUsed) % _historyCapacity; }
+
+    static void historyWrite(size_t offset, const uint8_t* data, size_t length) {
+        offset %= _historyCapacity;
+        size_t first = length < _historyCapacity - offset ? length : _historyCapacity - offset;
+        memcpy(_history + offset, data, first);
+        memcpy(_history, data + first, length - first);
+    }
+
+    static void historyRead(size_t offset, uint8_t* data, size_t length) {
+        offset %= _historyCapacity;
+        size_t first = length < _historyCapacity - offset ? length : _historyCapacity - offset;
+        memcpy(data, _history + offset, first);
+        memcpy(data + first, _history, length - first);
+    }
+
+    // Work through the oldest resend request: a lost frame for what the history no longer
+    // holds, then resend frames for the rest. Returns true while requests remain.
+    static bool serviceResendLocked(size_t maxNotifications) {
+        size_t sent = 0;
+        while (_resendQueued > 0 && sent < maxNotifications) {
+            uint16_t& first = _resendFirst[0];
+            uint16_t& count = _resendCount[0];
+
+            // Entries are in sequence order; skip to the first one asked for
+            size_t offset = _history ? historyTail() : 0;
+            size_t remaining = _history ? _historyUsed : 0;
+            uint16_t sequence = 0;
+            BTLoggerWireRecordHeader record;
+            bool found = false;
+            while (remaining > 0) {
+                historyRead(offset, (uint8_t*)&sequence, sizeof(sequence));
+                historyRead(offset + sizeof(sequence), (uint8_t*)&record, sizeof(record));
+                if ((uint16_t)(sequence - first) < count) {
+                    found = true;
+                    break;
+                }
+                size_t entryLength = sizeof(sequence) + sizeof(record) + record.tagLength + record.messageLength;
+                offset = (offset + entryLength) % _historyCapacity;
+                remaining -= entryLength;
+            }
+
+            uint16_t missing = found ? (uint16_t)(sequence - first) : count;
+            if (missing > 0) {
+                sendLostLocked(first, missing);
+                sent++;
+                first += missing;
+                count -= missing;
+            }
+
+            if (count > 0) {
+                // One resend frame of consecutive records from here
+                size_t limit = notificationLimit();
+                BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_RESEND};
+                memcpy(_batchBuffer, &frame, sizeof(frame));
+                memcpy(_batchBuffer + sizeof(frame) + 1, &first, sizeof(first));
+                size_t length = batchHeaderLength();
+                uint8_t packed = 0;
+                while (remaining > 0 && count > 0 && packed < 255) {
+                    historyRead(offset, (uint8_t*)&sequence, sizeof(sequence));
+                    historyRead(offset + sizeof(sequence), (uint8_t*)&record, sizeof(record));
+                    size_t recordLength = sizeof(record) + record.tagLength + record.messageLength;
+                    if (sequence != first || length + recordLength > limit) break;
+
+                    historyRead(offset + sizeof(sequence), _batchBuffer + length, recordLength);
+                    _batchBuffer[length + offsetof(BTLoggerWireRecordHeader, flags)] |= BTLOGGER_WIRE_FLAG_RESENT;
+                    length += recordLength;
+                    packed++;
+                    first++;
+                    count--;
+                    offset = (offset + sizeof(sequence) + recordLength) % _historyCapacity;
+                    remaining -= sizeof(sequence) + recordLength;
+                }
+
+                if (packed > 0) {
+                    _batchBuffer[sizeof(frame)] = packed;
+                    notifyBatchLocked(_batchBuffer, length, limit);
+                    _resentCount += packed;
+                } else {
+                    // Larger than a notification at this MTU: it cannot be resent
+                    sendLostLocked(first, 1);
+                    first++;
+                    count--;
+                }
+                sent++;
+            }
+
+            if (count == 0) {
+                _resendQueued--;
+                memmove(_resendFirst, _resendFirst + 1, _resendQueued * sizeof(_resendFirst[0]));
+                memmove(_resendCount, _resendCount + 1, _resendQueued * sizeof(_resendCount[0]));
+            }
+        }
+        return _resendQueued > 0;
+    }
+
+    static void sendLostLocked(uint16_t first, uint16_t count) {
+        uint8_t frame[sizeof(BTLoggerWireFrameHeader) + 4];
+        BTLoggerWireFrameHeader header = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_LOST};
+        memcpy(frame, &header, sizeof(header));
+        memcpy(frame + sizeof(header), &first, sizeof(first));
+        memcpy(frame + sizeof(header) + 2, &count, sizeof(count));
+        notifyLocked(frame, sizeof(frame));
+        _unavailableCount += count;
+    }
+
+    // New connection, or a new wire version on it: numbering starts over
+    static void resetSequenceLocked() {
+        _nextSequence = 0;
+        _historyHead = 0;
+        _historyUsed = 0;
+        _resendQueued = 0;
+    }
+
+    // ESP-IDF's own line layout, "I (1234) TAG: text"; a line longer than a record is formatted
+    // again from longFormat so serial still gets all of it
+    static void writeSerialLine(esp_log_level_t level, const char* tag, const char* line, size_t length,
+                                const char* longFormat, va_list longArgs) {
+        static const char letters[] = "NEWIDV";
+        char letter = level < sizeof(letters) - 1 ? letters[level] : '?';
+        if (!longFormat) {
+            esp_log_write(level, tag, "%c (%lu) %s: %.*s\n", letter, (unsigned long)esp_log_timestamp(), tag, (int)length, line);
+            return;
+        }
+        esp_log_write(level, tag, "%c (%lu) %s: ", letter, (unsigned long)esp_log_timestamp(), tag);
+        esp_log_writev(level, tag, longFormat, longArgs);
+        esp_log_write(level, tag, "\n");
+    }
+
+    static void notifyLocked(uint8_t* data, size_t length) {
+        _logCharacteristic->setValue(data, length);
+        _logCharacteristic->notify();
+        _notificationCount++;
+    }
+
+    // Latency deadline reached - push out whatever has been batched so far
+    static void batchTimerCallback(void* arg) {
+        flush();
+    }
+
+    // Handle control messages written by BTLogger
+    static void handleControlWrite(const uint8_t* data, size_t length) {
+        if (!data || length < 2 || data[0] != BTLOGGER_WIRE_MAGIC) {
+            BTLOGGER_DEBUG("Ignoring unknown control write (%d bytes)", (int)length);
+            return;
+        }
+
+        if (data[1] == BTLOGGER_WIRE_CTRL_HELLO && length >= 3) {
+            uint8_t peerVersion = data[2];
+            if (_sendMutex) xSemaphoreTake(_sendMutex, portMAX_DELAY);
+            flushBatchLocked();
+            _wireVersion = peerVersion < BTLOGGER_WIRE_VERSION ? peerVersion : BTLOGGER_WIRE_VERSION;
+            _peerFeatures = length >= 4 ? data[3] : 0;  // Older BTLogger sends no feature byte
+            resetSequenceLocked();
+            _compressedRawBytes = 0;
+            _compressedWireBytes = 0;
+            if (_sendMutex) xSemaphoreGive(_sendMutex);
+            scheduleReplay(0);
+            BTLOGGER_DEBUG("Protocol hello received - peer v%d, using wire version %d", peerVersion, _wireVersion);
+        } else if (data[1] == BTLOGGER_WIRE_CTRL_SYNC && length >= 3) {
+            sendSyncReply(data[2]);
+        } else if (data[1] == BTLOGGER_WIRE_CTRL_RESEND && length >= 6) {
+            uint16_t first;
+            uint16_t count;
+            memcpy(&first, data + 2, sizeof(first));
+            memcpy(&count, data + 4, sizeof(count));
+            if (_sendMutex) xSemaphoreTake(_sendMutex, portMAX_DELAY);
+            bool queued = count > 0 && _resendQueued < BTLOGGER_RESEND_QUEUE;
+            if (queued) {
+                _resendFirst[_resendQueued] = first;
+                _resendCount[_resendQueued] = count;
+                _resendQueued++;
+            }
+            if (_sendMutex) xSemaphoreGive(_sendMutex);
+            if (queued) {
+                scheduleReplay(0);  // Answered on the timer task, not in this BLE callback
+            }
+            BTLOGGER_DEBUG("Resend request for %u records from %u%s", count, first, queued ? "" : " ignored - queue full");
+        } else if (data[1] == BTLOGGER_WIRE_CTRL_FLOW && length >= 5) {
+            uint16_t rate;
+            memcpy(&rate, data + 3, sizeof(rate));
+            _flowMinLevel = data[2];
+            _flowRate = rate;
+            updateFloor();
+            BTLOGGER_DEBUG("Flow window: level %u and up, %u/s below WARN", data[2], rate);
+        } else if (data[1] == BTLOGGER_WIRE_CTRL_LEVEL && length >= 4 && length >= 4 + (size_t)data[3]) {
+            setRemoteLevel((const char*)data + 4, data[3], data[2]);
+            BTLOGGER_DEBUG("Level %u set for tag '%.*s'", data[2], (int)data[3], (const char*)data + 4);
+        }
+    }
+
+    // Answered straight away: BTLogger takes our clock to have been read halfway through its round trip
+    static void sendSyncReply(uint8_t sequence) {
+        if (_wireVersion < BTLOGGER_WIRE_SYNC_VERSION || !_logCharacteristic) {
+            return;
+        }
+
+        uint8_t reply[sizeof(BTLoggerWireFrameHeader) + 17];
+        if (_sendMutex) xSemaphoreTake(_sendMutex, portMAX_DELAY);
+        BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, _wireVersion, BTLOGGER_WIRE_FRAME_SYNC};
+        memcpy(reply, &frame, sizeof(frame));
+        reply[sizeof(frame)] = sequence;
+
+        // Record timestamps are the milliseconds of this same clock
+        uint64_t senderMicros = esp_timer_get_time();
+        struct timeval now;
+        gettimeofday(&now, nullptr);
+        uint64_t unixMillis = (uint64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+        if (unixMillis < BTLOGGER_WALL_CLOCK_MIN_MS) {
+            unixMillis = 0;
+        }
+        memcpy(reply + sizeof(frame) + 1, &senderMicros, sizeof(senderMicros));
+        memcpy(reply + sizeof(frame) + 9, &unixMillis, sizeof(unixMillis));
+
+        notifyLocked(reply, sizeof(reply));
+        if (_sendMutex) xSemaphoreGive(_sendMutex);
+    }
 
     // Convert ESP log level to BTLogger level
     static BTLogLevel espLevelToBTLevel(esp_log_level_t esp_level) {
@@ -396,6 +1962,13 @@ class BTLoggerSender {
         }
     }
 
+    // Log characteristic callbacks (control channel from BTLogger)
+    class LogCharacteristicCallbacks : public BLECharacteristicCallbacks {
+        void onWrite(BLECharacteristic* characteristic) override {
+            handleControlWrite(characteristic->getData(), characteristic->getLength());
+        }
+    };
+
     // BLE Server callbacks
     class ServerCallbacks : public BLEServerCallbacks {
         void onConnect(BLEServer* server) override {
@@ -404,9 +1977,26 @@ class BTLoggerSender {
             ESP_LOGI("BTLOGGER", "BTLogger device connected via BLE");
         }
 
+        void onConnect(BLEServer* server, esp_ble_gatts_cb_param_t* param) override {
+            BTLOGGER_DEBUG("Requesting link profile %d", _linkProfile);
+            applyLinkProfile(param->connect.remote_bda);
+            scheduleReplay(BTLOGGER_BACKLOG_HELLO_WAIT_MS);  // Brought forward by the HELLO
+        }
+
         void onDisconnect(BLEServer* server) override {
             BTLOGGER_DEBUG("BLE client disconnected - server has %d connections remaining", server->getConnectedCount());
             Serial.println("BTLogger disconnected - Restarting advertising...");
+            if (_sendMutex) {
+                xSemaphoreTake(_sendMutex, portMAX_DELAY);
+                _batch.clear();  // Nobody left to deliver the pending batch to
+                _wireVersion = 0;  // Renegotiate on the next connection
+                _peerFeatures = 0;
+                resetSequenceLocked();
+                _linkReady = false;
+                memset(_formatAnnounced, 0, sizeof(_formatAnnounced));  // New connection, new dictionary
+                xSemaphoreGive(_sendMutex);
+            }
+            resetRemoteControl();
             ESP_LOGW("BTLOGGER", "BTLogger device disconnected - restarting advertising");
             BTLOGGER_DEBUG("Restarting BLE advertising");
             BLEDevice::startAdvertising();
@@ -422,6 +2012,82 @@ uint32_t BTLoggerSender::_directLogCount = 0;
 uint32_t BTLoggerSender::_manualLogCount = 0;
 BTLogLevel BTLoggerSender::_btLogLevel = BT_INFO;
 esp_log_level_t BTLoggerSender::_espLogLevel = ESP_LOG_INFO;
+BTLinkProfile BTLoggerSender::_linkProfile = BT_LINK_HIGH_THROUGHPUT;
+uint8_t* BTLoggerSender::_backlog = nullptr;
+size_t BTLoggerSender::_backlogCapacity = 0;
+size_t BTLoggerSender::_backlogHead = 0;
+size_t BTLoggerSender::_backlogTail = 0;
+size_t BTLoggerSender::_backlogUsed = 0;
+BTDropPolicy BTLoggerSender::_backlogPolicy = BT_DROP_NEWEST;
+uint32_t BTLoggerSender::_backlogDropped = 0;
+const esp_partition_t* BTLoggerSender::_spillPartition = nullptr;
+size_t BTLoggerSender::_spillHead = 0;
+size_t BTLoggerSender::_spillTail = 0;
+esp_timer_handle_t BTLoggerSender::_replayTimer = nullptr;
+bool BTLoggerSender::_linkReady = false;
+uint8_t BTLoggerSender::_wireVersion = 0;
+uint8_t BTLoggerSender::_frameBuffer[BTLOGGER_WIRE_MAX_FRAME];
+uint16_t BTLoggerSender::_nextSequence = 0;
+uint8_t* BTLoggerSender::_history = nullptr;
+size_t BTLoggerSender::_historyCapacity = 0;
+size_t BTLoggerSender::_historyHead = 0;
+size_t BTLoggerSender::_historyUsed = 0;
+uint16_t BTLoggerSender::_resendFirst[BTLOGGER_RESEND_QUEUE];
+uint16_t BTLoggerSender::_resendCount[BTLOGGER_RESEND_QUEUE];
+uint8_t BTLoggerSender::_resendQueued = 0;
+uint32_t BTLoggerSender::_resentCount = 0;
+uint32_t BTLoggerSender::_unavailableCount = 0;
+volatile uint8_t BTLoggerSender::_flowMinLevel = 0;
+volatile uint16_t BTLoggerSender::_flowRate = 0;
+uint32_t BTLoggerSender::_flowWindowStart = 0;
+uint16_t BTLoggerSender::_flowWindowSent = 0;
+volatile uint32_t BTLoggerSender::_flowDropped = 0;
+volatile uint8_t BTLoggerSender::_remoteLevel = BTLOGGER_WIRE_LEVEL_CLEAR;
+BTLoggerSender::TagLevel BTLoggerSender::_tagLevels[BTLOGGER_TAG_LEVELS];
+volatile uint8_t BTLoggerSender::_tagLevelCount = 0;
+BTLoggerSender::TagCacheSlot BTLoggerSender::_tagCache[BTLOGGER_TAG_CACHE_SLOTS];
+volatile uint8_t BTLoggerSender::_tagGeneration = 0;
+volatile esp_log_level_t BTLoggerSender::_espGate = ESP_LOG_VERBOSE;
+portMUX_TYPE BTLoggerSender::_controlLock = portMUX_INITIALIZER_UNLOCKED;
+uint32_t BTLoggerSender::_notificationCount = 0;
+SemaphoreHandle_t BTLoggerSender::_sendMutex = nullptr;
+esp_timer_handle_t BTLoggerSender::_batchTimer = nullptr;
+bool BTLoggerSender::_batchingEnabled = true;
+uint16_t BTLoggerSender::_batchLatencyMs = BTLOGGER_BATCH_DEFAULT_LATENCY_MS;
+uint8_t BTLoggerSender::_batchBuffer[BTLOGGER_COMPRESS_MAX_INPUT];
+BTLoggerBatch BTLoggerSender::_batch(_batchBuffer, sizeof(_batchBuffer));
+bool BTLoggerSender::_compressionEnabled = false;
+uint8_t BTLoggerSender::_peerFeatures = 0;
+uint8_t BTLoggerSender::_compressBuffer[BTLOGGER_BATCH_MAX_PAYLOAD];
+uint8_t BTLoggerSender::_compressWork[BTLOGGER_COMPRESS_WORK_SIZE(BTLOGGER_COMPRESS_MAX_INPUT)];
+uint16_t BTLoggerSender::_compressTable[1 << BTLOGGER_COMPRESS_HASH_BITS];
+BTLoggerCompressor BTLoggerSender::_compressor(_compressWork, _compressTable, BTLOGGER_COMPRESS_MAX_INPUT,
+                                               BTLOGGER_COMPRESS_HASH_BITS);
+uint32_t BTLoggerSender::_compressedRawBytes = 0;
+uint32_t BTLoggerSender::_compressedWireBytes = 0;
+uint8_t* BTLoggerSender::_asyncRing = nullptr;
+size_t BTLoggerSender::_asyncCapacity = 0;
+size_t BTLoggerSender::_asyncHead = 0;
+size_t BTLoggerSender::_asyncTail = 0;
+size_t BTLoggerSender::_asyncUsed = 0;
+portMUX_TYPE BTLoggerSender::_asyncLock = portMUX_INITIALIZER_UNLOCKED;
+TaskHandle_t BTLoggerSender::_asyncTask = nullptr;
+BTDropPolicy BTLoggerSender::_dropPolicy = BT_DROP_OLDEST;
+volatile uint32_t BTLoggerSender::_droppedOldest = 0;
+volatile uint32_t BTLoggerSender::_droppedNewest = 0;
+size_t BTLoggerSender::_asyncPeakUsed = 0;
+uint64_t BTLoggerSender::_queueDelayTotalMs = 0;
+uint32_t BTLoggerSender::_queueDelayMaxMs = 0;
+uint32_t BTLoggerSender::_queueDelayCount = 0;
+bool BTLoggerSender::_tokenizedEnabled = false;
+BTLoggerSender::FormatEntry BTLoggerSender::_formats[BTLOGGER_TOKEN_MAX_FORMATS];
+uint8_t BTLoggerSender::_formatSlots[BTLOGGER_TOKEN_HASH_SLOTS] = {0};
+char BTLoggerSender::_formatArena[BTLOGGER_TOKEN_ARENA_BYTES];
+size_t BTLoggerSender::_formatArenaUsed = 0;
+uint16_t BTLoggerSender::_formatCount = 0;
+portMUX_TYPE BTLoggerSender::_formatLock = portMUX_INITIALIZER_UNLOCKED;
+uint8_t BTLoggerSender::_formatAnnounced[BTLOGGER_TOKEN_MAX_FORMATS / 8] = {0};
+uint32_t BTLoggerSender::_tokenDropped = 0;
 
 // Convenience macros (still available for manual use)
 #define BT_LOG_DEBUG(tag, msg) BTLoggerSender::debug(tag, msg)
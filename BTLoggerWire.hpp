@@ -0,0 +1,313 @@
+#pragma once
+
+/*
+ * BTLoggerWire - compact wire format shared by the BTLogger senders
+ *
+ * Included by BTLoggerSender.hpp and BTLoggerSender_ESPLog.hpp (copy it next to
+ * whichever one you use) and by BTLogger itself, so the record layout, the batch
+ * packing and the LZ compressor exist once. Plain C++, no Arduino or BLE headers:
+ * it also builds on the host (see bench/native).
+ *
+ * Frame:  [magic:1][version:1][type:1]
+ * Record: [timestamp:4][level:1][flags:1][tagLength:1][messageLength:2][tag...][message...]
+ * Batch (version 2+): [frame header][count:1][firstSequence:2 from version 5][record][record]...
+ * Compressed (peer feature): [frame header][innerType:1][rawLength:2][LZ4-style block]
+ * See BTLogger's LogProtocol.hpp for the rest of the format.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BTLOGGER_WIRE_MAGIC 0xB7
+#define BTLOGGER_WIRE_BATCH_VERSION 2     // First version that allows BATCH frames
+#define BTLOGGER_WIRE_TOKEN_VERSION 3     // First version that allows DICT frames and tokenized records
+#define BTLOGGER_WIRE_SYNC_VERSION 4      // First version that answers clock sync requests
+#define BTLOGGER_WIRE_SEQUENCE_VERSION 5  // First version that numbers records and resends them
+#define BTLOGGER_WIRE_FLOW_VERSION 6      // First version that follows flow and level control
+#define BTLOGGER_WIRE_FRAME_RECORD 0x01
+#define BTLOGGER_WIRE_FRAME_BATCH 0x02
+#define BTLOGGER_WIRE_FRAME_DICT 0x03
+#define BTLOGGER_WIRE_FRAME_COMPRESSED 0x04
+#define BTLOGGER_WIRE_FRAME_SYNC 0x05
+#define BTLOGGER_WIRE_FRAME_RESEND 0x06
+#define BTLOGGER_WIRE_FRAME_LOST 0x07
+#define BTLOGGER_WIRE_CTRL_HELLO 0x01
+#define BTLOGGER_WIRE_CTRL_SYNC 0x02
+#define BTLOGGER_WIRE_CTRL_RESEND 0x03
+#define BTLOGGER_WIRE_CTRL_FLOW 0x04
+#define BTLOGGER_WIRE_CTRL_LEVEL 0x05
+#define BTLOGGER_WIRE_FEATURE_COMPRESSION 0x01
+#define BTLOGGER_WIRE_FLAG_REPLAYED 0x01
+#define BTLOGGER_WIRE_FLAG_TOKENIZED 0x02
+#define BTLOGGER_WIRE_FLAG_RESENT 0x04
+#define BTLOGGER_WIRE_MAX_TAG 31       // Longest tag a record carries
+#define BTLOGGER_WIRE_MAX_MESSAGE 255  // Longest message a record carries
+
+// Largest notification payload (517 byte MTU - 3 byte ATT header)
+#define BTLOGGER_BATCH_MAX_PAYLOAD 514
+
+// Compression: matches may reach back into a dictionary both sides share - changing it breaks old firmware
+#define BTLOGGER_COMPRESS_MAX_INPUT 1024  // Largest raw batch a sender packs
+#define BTLOGGER_COMPRESS_HASH_BITS 9     // Sender match table, 2 bytes per slot
+#define BTLOGGER_COMPRESS_HEADER 6        // Frame header + innerType + rawLength
+#define BTLOGGER_COMPRESS_DICTIONARY \
+    "connected disconnected initialized starting complete failed error timeout received sending " \
+    "value status sensor temperature Free heap: bytes WiFi BLE ms "
+#define BTLOGGER_COMPRESS_WORK_SIZE(maxInput) (sizeof(BTLOGGER_COMPRESS_DICTIONARY) - 1 + (maxInput))
+
+struct __attribute__((packed)) BTLoggerWireFrameHeader {
+    uint8_t magic;
+    uint8_t version;
+    uint8_t type;
+};
+
+struct __attribute__((packed)) BTLoggerWireRecordHeader {
+    uint32_t timestamp;
+    uint8_t level;
+    uint8_t flags;
+    uint8_t tagLength;
+    uint16_t messageLength;
+};
+
+// Bytes one record takes on the wire
+inline size_t btLoggerRecordLength(const char* tag, size_t messageLength) {
+    return sizeof(BTLoggerWireRecordHeader) + strnlen(tag, BTLOGGER_WIRE_MAX_TAG) +
+           (messageLength < BTLOGGER_WIRE_MAX_MESSAGE ? messageLength : BTLOGGER_WIRE_MAX_MESSAGE);
+}
+
+// Write one record (header + tag + message) and return its encoded size
+inline size_t btLoggerEncodeRecord(uint8_t* buffer, uint32_t timestamp, uint8_t level, uint8_t flags, const char* tag,
+                                   const char* message, size_t messageLength) {
+    size_t tagLength = strnlen(tag, BTLOGGER_WIRE_MAX_TAG);
+    if (messageLength > BTLOGGER_WIRE_MAX_MESSAGE) {
+        messageLength = BTLOGGER_WIRE_MAX_MESSAGE;
+    }
+
+    BTLoggerWireRecordHeader record = {timestamp, level, flags, (uint8_t)tagLength, (uint16_t)messageLength};
+
+    size_t offset = 0;
+    memcpy(buffer + offset, &record, sizeof(record));
+    offset += sizeof(record);
+    memcpy(buffer + offset, tag, tagLength);
+    offset += tagLength;
+    memcpy(buffer + offset, message, messageLength);
+    offset += messageLength;
+    return offset;
+}
+
+/**
+ * Greedy LZ4-style compressor, one hash probe per position: fast rather than
+ * small. The dictionary goes in front of the input, so matches may reach back
+ * into it. The caller owns the buffers - work of BTLOGGER_COMPRESS_WORK_SIZE(maxInput)
+ * bytes, table of 1 << hashBits entries - and one compressor serves one task.
+ */
+class BTLoggerCompressor {
+   public:
+    BTLoggerCompressor(uint8_t* work, uint16_t* table, size_t maxInput, uint8_t hashBits)
+        : work(work), table(table), maxInput(maxInput), hashBits(hashBits) {}
+
+    // Block: [token][literal length...][literals][offset:2][match length...], the last sequence
+    // literals only. Bytes written to output; 0 if input is too long or output too small
+    size_t compress(const uint8_t* input, size_t length, uint8_t* output, size_t capacity) {
+        const size_t dictionaryLength = sizeof(BTLOGGER_COMPRESS_DICTIONARY) - 1;
+        if (!work || !table || length > maxInput || dictionaryLength + length > UINT16_MAX) return 0;
+        memcpy(work, BTLOGGER_COMPRESS_DICTIONARY, dictionaryLength);
+        memcpy(work + dictionaryLength, input, length);
+
+        memset(table, 0, sizeof(uint16_t) << hashBits);
+        for (size_t i = 0; i + 4 <= dictionaryLength; i++) {
+            table[hash(work + i)] = i + 1;
+        }
+
+        size_t end = dictionaryLength + length;
+        size_t anchor = dictionaryLength;
+        size_t position = dictionaryLength;
+        size_t out = 0;
+        while (position + 4 <= end) {
+            uint16_t& slot = table[hash(work + position)];
+            size_t candidate = slot;
+            slot = position + 1;
+            if (candidate == 0 || memcmp(work + candidate - 1, work + position, 4) != 0) {
+                position++;
+                continue;
+            }
+
+            size_t match = candidate - 1;
+            size_t matchLength = 4;
+            while (position + matchLength < end && work[match + matchLength] == work[position + matchLength]) {
+                matchLength++;
+            }
+            if (!emitSequence(output, capacity, out, work + anchor, position - anchor, position - match, matchLength)) {
+                return 0;
+            }
+            position += matchLength;
+            anchor = position;
+        }
+
+        if (!emitSequence(output, capacity, out, work + anchor, end - anchor, 0, 0)) return 0;
+        return out;
+    }
+
+    // Wrap the body of a frame in a COMPRESSED frame; its length, 0 if it would exceed capacity
+    size_t compressFrame(const uint8_t* frame, size_t length, uint8_t* output, size_t capacity) {
+        const size_t headerLength = sizeof(BTLoggerWireFrameHeader);
+        if (length <= headerLength || capacity <= BTLOGGER_COMPRESS_HEADER) return 0;
+        size_t rawLength = length - headerLength;
+
+        size_t blockLength =
+            compress(frame + headerLength, rawLength, output + BTLOGGER_COMPRESS_HEADER, capacity - BTLOGGER_COMPRESS_HEADER);
+        if (blockLength == 0) return 0;
+
+        BTLoggerWireFrameHeader header = {BTLOGGER_WIRE_MAGIC, frame[1], BTLOGGER_WIRE_FRAME_COMPRESSED};
+        memcpy(output, &header, sizeof(header));
+        output[headerLength] = frame[2];  // Inner frame type
+        uint16_t raw = rawLength;
+        memcpy(output + headerLength + 1, &raw, sizeof(raw));
+        return BTLOGGER_COMPRESS_HEADER + blockLength;
+    }
+
+   private:
+    uint8_t* work;    // Dictionary, then the input
+    uint16_t* table;  // Position + 1 of the last 4 bytes with each hash
+    size_t maxInput;
+    uint8_t hashBits;
+
+    uint16_t hash(const uint8_t* data) const {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return (value * 2654435761u) >> (32 - hashBits);
+    }
+
+    static bool emitLength(uint8_t* output, size_t capacity, size_t& out, size_t value) {
+        for (; value >= 255; value -= 255) {
+            if (out >= capacity) return false;
+            output[out++] = 255;
+        }
+        if (out >= capacity) return false;
+        output[out++] = value;
+        return true;
+    }
+
+    // matchLength 0 writes the final literals-only sequence
+    static bool emitSequence(uint8_t* output, size_t capacity, size_t& out, const uint8_t* literals, size_t literalLength,
+                             size_t distance, size_t matchLength) {
+        if (out >= capacity) return false;
+        size_t matchCode = matchLength >= 4 ? matchLength - 4 : 0;
+        output[out++] = (uint8_t)(((literalLength < 15 ? literalLength : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+        if (literalLength >= 15 && !emitLength(output, capacity, out, literalLength - 15)) return false;
+        if (out + literalLength > capacity) return false;
+        memcpy(output + out, literals, literalLength);
+        out += literalLength;
+
+        if (matchLength == 0) return true;
+        if (out + 2 > capacity) return false;
+        output[out++] = distance & 0xFF;
+        output[out++] = distance >> 8;
+        if (matchCode >= 15 && !emitLength(output, capacity, out, matchCode - 15)) return false;
+        return true;
+    }
+};
+
+/**
+ * A batch frame being filled, in a buffer the caller owns. Records are added
+ * up to one notification (limit), and past it only while the batch still
+ * compresses into one. The length last compressed plus the bytes added since
+ * as literals estimates that, so the batch is compressed again only once the
+ * estimate passes the limit: a few passes per batch rather than one per
+ * record. The count byte is kept up to date; anything else in the batch
+ * header (the first sequence) is the caller's.
+ */
+class BTLoggerBatch {
+   public:
+    BTLoggerBatch(uint8_t* buffer, size_t capacity)
+        : buffer(buffer), capacity(capacity), length(0), limit(0), count(0), checked(0), checkedCount(0), packed(0) {}
+
+    uint8_t* data() const { return buffer; }
+    size_t getLength() const { return length; }
+    size_t getLimit() const { return limit; }
+    uint8_t getCount() const { return count; }
+    bool isEmpty() const { return count == 0; }
+
+    // Start an empty batch whose records begin after headerLength bytes
+    void open(uint8_t version, size_t headerLength, size_t notificationLimit) {
+        BTLoggerWireFrameHeader frame = {BTLOGGER_WIRE_MAGIC, version, BTLOGGER_WIRE_FRAME_BATCH};
+        memcpy(buffer, &frame, sizeof(frame));
+        buffer[sizeof(frame)] = 0;
+        length = headerLength;
+        limit = notificationLimit;
+        count = 0;
+        checked = 0;
+    }
+
+    void clear() {
+        length = 0;
+        count = 0;
+    }
+
+    // Append one record; false (and nothing added) if the buffer is full, or the batch would
+    // pass the limit and no longer compress into it. compressor may be null without compression.
+    bool add(uint32_t timestamp, uint8_t level, uint8_t flags, const char* tag, const char* message, size_t messageLength,
+             BTLoggerCompressor* compressor, uint8_t* scratch) {
+        if (count == 255 || length + btLoggerRecordLength(tag, messageLength) > capacity) return false;
+
+        size_t start = length;
+        length += btLoggerEncodeRecord(buffer + length, timestamp, level, flags, tag, message, messageLength);
+        setCount(count + 1);
+
+        if (length > limit && !(compressor && fits(*compressor, scratch))) {
+            length = start;
+            setCount(count - 1);
+            return false;
+        }
+        return true;
+    }
+
+    // Whether the estimate let the batch grow past what compresses into one notification.
+    // If so the records last seen to fit are left counted as a batch of their own in the
+    // first getSplitLength() bytes: send those, then dropSplit(). The rest fit raw alone.
+    bool needsSplit(BTLoggerCompressor& compressor, uint8_t* scratch) {
+        if (length <= limit || checked >= length) return false;
+        if (compressor.compressFrame(buffer, length, scratch, limit) > 0) return false;
+        buffer[sizeof(BTLoggerWireFrameHeader)] = checkedCount;
+        return true;
+    }
+
+    size_t getSplitLength() const { return checked; }
+    uint8_t getSplitCount() const { return checkedCount; }
+
+    void dropSplit(size_t headerLength) {
+        size_t tailLength = length - checked;
+        memmove(buffer + headerLength, buffer + checked, tailLength);
+        length = headerLength + tailLength;
+        setCount(count - checkedCount);
+        checked = 0;
+    }
+
+   private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t length;
+    size_t limit;
+    uint8_t count;
+    size_t checked;  // Length when the batch was last compressed, 0 if not yet
+    uint8_t checkedCount;
+    size_t packed;  // Compressed length at that point
+
+    void setCount(uint8_t value) {
+        count = value;
+        buffer[sizeof(BTLoggerWireFrameHeader)] = value;
+    }
+
+    bool fits(BTLoggerCompressor& compressor, uint8_t* scratch) {
+        size_t added = length - checked;
+        if (checked > 0 && packed + added + added / 255 + 2 <= limit) return true;
+
+        size_t packedLength = compressor.compressFrame(buffer, length, scratch, limit);
+        if (packedLength == 0) return false;
+        checked = length;
+        checkedCount = count;
+        packed = packedLength;
+        return true;
+    }
+};
@@ -0,0 +1,425 @@
+/*
+ * BTLogger core microbenchmarks
+ *
+ * Runs the receive pipeline's portable stages on the host - wire decoding,
+ * compression and decompression, tokenized rendering, text line formatting,
+ * the ingest ring, the binary block writer and reader, the live filter and
+ * the metrics - and prints the time per operation and throughput of each.
+ * Frames are built with the senders' own encoders. Every benchmark also checks its
+ * output (records decoded, text rendered, sequence order), so the run fails
+ * if a change broke a stage instead of just making it faster.
+ *
+ * Build and run with:  pio run -e native -t exec
+ * Iteration counts are the BENCH_* defines below; override them from
+ * build_flags in platformio.ini. Host numbers are for comparing changes,
+ * not for predicting the ESP32's.
+ */
+
+#include <thread>
+#include "Core/BinaryLogFormat.hpp"
+#include "Core/DeviceRegistry.hpp"
+#include "Core/FormatDictionary.hpp"
+#include "Core/IngestRing.hpp"
+#include "Core/LiveFilter.hpp"
+#include "Core/LogLineFormat.hpp"
+#include "Core/LogProtocol.hpp"
+#include "Core/Metrics.hpp"
+#include "Core/TagRegistry.hpp"
+
+using namespace BTLogger::Core;
+
+#ifndef BENCH_DECODE_FRAMES
+#define BENCH_DECODE_FRAMES 200000
+#endif
+#ifndef BENCH_RENDER_RECORDS
+#define BENCH_RENDER_RECORDS 500000
+#endif
+#ifndef BENCH_RING_NOTIFICATIONS
+#define BENCH_RING_NOTIFICATIONS 500000
+#endif
+#ifndef BENCH_BLOCK_RECORDS
+#define BENCH_BLOCK_RECORDS 500000
+#endif
+#ifndef BENCH_FILTER_RECORDS
+#define BENCH_FILTER_RECORDS 1000000
+#endif
+#ifndef BENCH_METRIC_SAMPLES
+#define BENCH_METRIC_SAMPLES 5000000
+#endif
+
+#define BENCH_SAMPLE_PACKETS 64
+#define BENCH_FILE "btlogger_bench.blg"
+
+static const char* const MESSAGES[] = {
+    "WiFi connected, RSSI -61 dBm, channel 6",
+    "sensor temperature 23.4 C, humidity 41 %",
+    "Free heap: 183244 bytes, largest block 110592",
+    "request timeout after 5000 ms, retrying",
+    "BLE notification sent, 244 bytes, status ok",
+    "motor position 1024 target 2048 speed 300",
+};
+static const char* const TAGS[] = {"WIFI", "SENSOR", "SYS", "HTTP", "BLE", "MOTOR"};
+
+static int failures = 0;
+static DeviceId device = DEVICE_ID_UNKNOWN;
+static LogPacket samples[BENCH_SAMPLE_PACKETS];
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        Serial.printf("  FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+static void report(const char* name, uint64_t operations, uint64_t bytes, int64_t elapsedUs) {
+    double seconds = elapsedUs > 0 ? elapsedUs / 1000000.0 : 1e-6;
+    Serial.printf("%-18s %10llu ops %10.1f ns/op %12.0f ops/s", name, (unsigned long long)operations,
+                  elapsedUs * 1000.0 / (operations ? operations : 1), operations / seconds);
+    if (bytes > 0) {
+        Serial.printf(" %8.1f MB/s", bytes / seconds / 1000000.0);
+    }
+    Serial.println();
+}
+
+template <typename Body>
+static int64_t timed(Body body) {
+    int64_t start = esp_timer_get_time();
+    body();
+    return esp_timer_get_time() - start;
+}
+
+// A spread of the records a real sender produces
+static void fillSamples() {
+    for (int i = 0; i < BENCH_SAMPLE_PACKETS; i++) {
+        LogPacket& packet = samples[i];
+        packet.timestamp = 1000 + i * 7;
+        packet.level = i % 5;
+        strncpy(packet.tag, TAGS[i % 6], sizeof(packet.tag) - 1);
+        packet.tagId = TagRegistry::intern(packet.tag);  // As BluetoothManager does at ingest
+        snprintf(packet.message, sizeof(packet.message), "%s #%d", MESSAGES[(i * 5) % 6], i);
+        packet.length = strlen(packet.message);
+    }
+}
+
+// Frames built with the senders' own encoders (BTLoggerWire.hpp) at the version BTLogger speaks.
+// Records are numbered from wire version 5; the decoder takes any starting point, so they start at 0.
+static size_t buildRecord(uint8_t* out, const LogPacket& packet) {
+    BTLoggerWireFrameHeader header = {BTLOGGER_WIRE_MAGIC, BTLOGGER_WIRE_VERSION, BTLOGGER_WIRE_FRAME_RECORD};
+    memcpy(out, &header, sizeof(header));
+    size_t length = sizeof(header);
+    memset(out + length, 0, sizeof(uint16_t));
+    length += sizeof(uint16_t);
+    return length + btLoggerEncodeRecord(out + length, packet.timestamp, packet.level, 0, packet.tag, packet.message,
+                                         packet.length);
+}
+
+static size_t buildBatch(uint8_t* out, size_t capacity, int& records) {
+    const size_t headerLength = sizeof(BTLoggerWireFrameHeader) + 1 + sizeof(uint16_t);
+    BTLoggerBatch batch(out, capacity);
+    batch.open(BTLOGGER_WIRE_VERSION, headerLength, capacity);
+    memset(out + headerLength - sizeof(uint16_t), 0, sizeof(uint16_t));
+    for (records = 0;; records++) {
+        const LogPacket& packet = samples[records % BENCH_SAMPLE_PACKETS];
+        if (!batch.add(packet.timestamp, packet.level, 0, packet.tag, packet.message, packet.length, nullptr, nullptr)) {
+            break;
+        }
+    }
+    return batch.getLength();
+}
+
+// The senders' compressor, as they set it up
+static size_t buildCompressed(const uint8_t* frame, size_t length, uint8_t* out, size_t capacity) {
+    static uint8_t work[BTLOGGER_COMPRESS_WORK_SIZE(BTLOGGER_COMPRESS_MAX_INPUT)];
+    static uint16_t table[1 << BTLOGGER_COMPRESS_HASH_BITS];
+    BTLoggerCompressor compressor(work, table, BTLOGGER_COMPRESS_MAX_INPUT, BTLOGGER_COMPRESS_HASH_BITS);
+    return compressor.compressFrame(frame, length, out, capacity);
+}
+
+static void runDecode(const char* name, const uint8_t* frame, size_t length, int recordsPerFrame) {
+    uint64_t decoded = 0;
+    uint64_t textBytes = 0;
+    bool matched = true;
+    int64_t elapsed = timed([&]() {
+        for (uint32_t i = 0; i < BENCH_DECODE_FRAMES; i++) {
+            int index = 0;
+            LogProtocol::decode(frame, length, [&](const LogPacket& packet) {
+                matched &= strcmp(packet.message, samples[index++ % BENCH_SAMPLE_PACKETS].message) == 0;
+                textBytes += packet.length;
+                decoded++;
+            });
+        }
+    });
+    report(name, decoded, textBytes, elapsed);
+    check(decoded == (uint64_t)BENCH_DECODE_FRAMES * recordsPerFrame, "every record decoded");
+    check(matched, "decoded text matches what was sent");
+}
+
+static void benchDecode() {
+    uint8_t frame[INGEST_SLOT_PAYLOAD];
+    size_t length = buildRecord(frame, samples[0]);
+    runDecode("decode_record", frame, length, 1);
+
+    int records = 0;
+    length = buildBatch(frame, sizeof(frame), records);
+    runDecode("decode_batch", frame, length, records);
+
+    uint8_t compressed[INGEST_SLOT_PAYLOAD * 2];
+    size_t compressedLength = buildCompressed(frame, length, compressed, sizeof(compressed));
+    Serial.printf("  batch of %d records: %u bytes, compressed %u\n", records, (unsigned)length,
+                  (unsigned)compressedLength);
+    check(LogProtocol::getExpandedLength(compressed, compressedLength) == length, "compressed frame expands to the batch");
+    runDecode("decode_compressed", compressed, compressedLength, records);
+
+    // BTLogger's own compressor (the network relay's), dictionary and all, back through the decoder
+    LogCompressor compressor(WIRE_COMPRESS_MAX_RAW);
+    size_t rawLength = length - sizeof(WireFrameHeader);
+    WireFrameHeader header = {BTLOGGER_WIRE_MAGIC, BTLOGGER_WIRE_VERSION, WIRE_FRAME_COMPRESSED};
+    memcpy(compressed, &header, sizeof(header));
+    size_t offset = sizeof(header);
+    compressed[offset++] = frame[2];
+    memcpy(compressed + offset, &rawLength, sizeof(uint16_t));
+    offset += sizeof(uint16_t);
+    size_t blockLength = 0;
+    int64_t elapsed = timed([&]() {
+        for (uint32_t i = 0; i < BENCH_DECODE_FRAMES; i++) {
+            blockLength = compressor.compress(frame + sizeof(WireFrameHeader), rawLength, compressed + offset,
+                                              sizeof(compressed) - offset);
+        }
+    });
+    report("compress_batch", BENCH_DECODE_FRAMES, (uint64_t)BENCH_DECODE_FRAMES * rawLength, elapsed);
+    Serial.printf("  batch of %d records: %u bytes, relay compressor %u\n", records, (unsigned)length,
+                  (unsigned)(offset + blockLength));
+    check(blockLength > 0 && blockLength < rawLength, "relay compressor shrinks the batch");
+    runDecode("decode_relayed", compressed, offset + blockLength, records);
+}
+
+static void benchRender() {
+    static const char format[] = "sensor %d value %u status %s";
+    uint16_t entry = FormatDictionary::define(device, 1, format, sizeof(format) - 1);
+    check(entry == FormatDictionary::resolve(device, 1), "format resolves to its entry");
+
+    // [entry:2][int:4][unsigned:4][length:1][bytes]
+    char body[32];
+    size_t length = 0;
+    int32_t value = -5;
+    uint32_t reading = 1234;
+    memcpy(body + length, &entry, sizeof(entry));
+    length += sizeof(entry);
+    memcpy(body + length, &value, sizeof(value));
+    length += sizeof(value);
+    memcpy(body + length, &reading, sizeof(reading));
+    length += sizeof(reading);
+    body[length++] = 2;
+    memcpy(body + length, "ok", 2);
+    length += 2;
+
+    char text[256];
+    uint64_t bytes = 0;
+    int64_t elapsed = timed([&]() {
+        for (uint32_t i = 0; i < BENCH_RENDER_RECORDS; i++) {
+            bytes += FormatDictionary::render(body, length, text, sizeof(text));
+        }
+    });
+    report("render_tokenized", BENCH_RENDER_RECORDS, bytes, elapsed);
+    check(strcmp(text, "sensor -5 value 1234 status ok") == 0, "tokenized record renders its arguments");
+}
+
+// Text session lines, as SDCardManager writes them
+static void benchLines() {
+    char line[LOG_LINE_MAX_LENGTH];
+    uint64_t bytes = 0;
+    int64_t elapsed = timed([&]() {
+        for (uint32_t i = 0; i < BENCH_RENDER_RECORDS; i++) {
+            bytes += LogLineFormat::format(samples[i % BENCH_SAMPLE_PACKETS], line, sizeof(line));
+        }
+    });
+    report("format_line", BENCH_RENDER_RECORDS, bytes, elapsed);
+
+    char expected[LOG_LINE_MAX_LENGTH];
+    snprintf(expected, sizeof(expected), "1.000000,0,WIFI,%s\n", samples[0].message);
+    size_t length = LogLineFormat::format(samples[0], line, sizeof(line));
+    check(length == strlen(expected) && strcmp(line, expected) == 0, "record formats as a session line");
+    check(LogLineFormat::format(samples[0], line, 8) == 7 && strlen(line) == 7, "short buffer truncates the line");
+}
+
+// One BLE callback producer against the communications task consumer
+static void benchRing() {
+    IngestRing ring;
+    check(ring.initialize(), "ring allocated");
+
+    uint64_t retries = 0;
+    std::thread producer([&]() {
+        uint8_t payload[120];
+        memset(payload, 'x', sizeof(payload));
+        for (uint32_t sequence = 0; sequence < BENCH_RING_NOTIFICATIONS; sequence++) {
+            memcpy(payload, &sequence, sizeof(sequence));
+            while (!ring.push(device, payload, sizeof(payload))) {
+                retries++;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    bool ordered = true;
+    int64_t elapsed = timed([&]() {
+        while (expected < BENCH_RING_NOTIFICATIONS) {
+            const IngestSlot* slot = ring.front();
+            if (!slot) {
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t sequence;
+            memcpy(&sequence, slot->data, sizeof(sequence));
+            ordered &= sequence == expected && slot->length == 120;
+            expected++;
+            ring.pop();
+        }
+    });
+    producer.join();
+
+    report("ingest_ring", BENCH_RING_NOTIFICATIONS, (uint64_t)BENCH_RING_NOTIFICATIONS * 120, elapsed);
+    Serial.printf("  producer found the ring full %llu times, high water %lu of %u\n", (unsigned long long)retries,
+                  (unsigned long)ring.getHighWaterMark(), (unsigned)ring.capacity());
+    check(ordered, "notifications come out whole and in order");
+    check(ring.size() == 0, "ring drained");
+
+    // A disconnect still gets in behind a full ring, and comes out after the data
+    uint8_t payload[16] = {0};
+    while (ring.push(device, payload, sizeof(payload))) {
+    }
+    check(ring.pushEvent(device, INGEST_DISCONNECT), "disconnect queued behind a full ring");
+    size_t notifications = 0;
+    const IngestSlot* slot;
+    while ((slot = ring.front()) && slot->type == INGEST_NOTIFICATION) {
+        notifications++;
+        ring.pop();
+    }
+    check(notifications == ring.capacity() && slot && slot->type == INGEST_DISCONNECT, "disconnect comes after the data");
+    ring.pop();
+}
+
+static void benchBlocks() {
+    BinaryBlockWriter writer;
+    check(writer.initialize(), "block buffer allocated");
+
+    File out(BENCH_FILE, "wb");
+    check((bool)out, "bench file created");
+    BinaryLogFileHeader fileHeader;
+    BinaryBlockWriter::fillFileHeader(fileHeader, "bench");
+    writer.setSeed(fileHeader.blockSeed);
+    out.write(reinterpret_cast<const uint8_t*>(&fileHeader), sizeof(fileHeader));
+
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    uint32_t blocks = 0;
+    auto flushBlock = [&]() {
+        size_t blockLength = 0;
+        const uint8_t* block = writer.finish(blockLength);
+        out.write(block, blockLength);
+        outputBytes += blockLength;
+        blocks++;
+        writer.reset();
+    };
+    int64_t elapsed = timed([&]() {
+        for (uint32_t i = 0; i < BENCH_BLOCK_RECORDS; i++) {
+            const LogPacket& packet = samples[i % BENCH_SAMPLE_PACKETS];
+            if (!writer.append(packet)) {
+                flushBlock();
+                writer.append(packet);
+            }
+            inputBytes += packet.length + strlen(packet.tag);
+        }
+        if (!writer.isEmpty()) {
+            flushBlock();
+        }
+    });
+    out.close();
+    report("block_write", BENCH_BLOCK_RECORDS, inputBytes, elapsed);
+    Serial.printf("  %lu blocks, %.2f bytes on card per byte of tag and text\n", (unsigned long)blocks,
+                  inputBytes ? (double)outputBytes / inputBytes : 0);
+
+    // Read it back the way export and search do
+    File in(BENCH_FILE, "rb");
+    BinaryLogReader reader;
+    check(reader.open(in), "bench file opens as a binary log");
+
+    BinaryLogRecord record;
+    char line[400];
+    uint64_t records = 0;
+    uint64_t textBytes = 0;
+    bool matched = true;
+    elapsed = timed([&]() {
+        while (reader.next(record)) {
+            const LogPacket& packet = samples[records % BENCH_SAMPLE_PACKETS];
+            matched &= record.level == packet.level && strcmp(record.tag, packet.tag) == 0 &&
+                       record.messageLength == packet.length && memcmp(record.message, packet.message, packet.length) == 0;
+            textBytes += BinaryLogReader::formatTextLine(record, line, sizeof(line));
+            records++;
+        }
+    });
+    in.close();
+    remove(BENCH_FILE);
+
+    report("block_read_format", records, textBytes, elapsed);
+    check(records == BENCH_BLOCK_RECORDS, "every record read back");
+    check(reader.getSkippedBlocks() == 0, "no block failed its CRC");
+    check(matched, "records read back as written");
+}
+
+static void benchFilter() {
+    LiveFilter::reset();
+    LiveFilter::setMinLevel(1);
+    LiveFilter::setText("TIMEOUT");
+
+    uint64_t expected = 0;
+    for (int i = 0; i < BENCH_SAMPLE_PACKETS; i++) {
+        expected += samples[i].level >= 1 && strstr(samples[i].message, "timeout") != nullptr;
+    }
+
+    uint64_t accepted = 0;
+    uint64_t bytes = 0;
+    int64_t elapsed = timed([&]() {
+        for (uint32_t i = 0; i < BENCH_FILTER_RECORDS; i++) {
+            const LogPacket& packet = samples[i % BENCH_SAMPLE_PACKETS];
+            accepted += LiveFilter::accepts(packet, device, packet.message);
+            bytes += packet.length;
+        }
+    });
+    report("live_filter", BENCH_FILTER_RECORDS, bytes, elapsed);
+    check(accepted == expected * (BENCH_FILTER_RECORDS / BENCH_SAMPLE_PACKETS), "filter keeps exactly the matches");
+    LiveFilter::reset();
+}
+
+static void benchMetrics() {
+    Metrics::reset();
+    int64_t elapsed = timed([&]() {
+        for (uint32_t i = 0; i < BENCH_METRIC_SAMPLES; i++) {
+            Metrics::record(METRIC_HIST_RING_WAIT, i & 0x3FF);
+        }
+    });
+    report("metrics_record", BENCH_METRIC_SAMPLES, 0, elapsed);
+
+    MetricsSnapshot snapshot;
+    Metrics::snapshot(snapshot);
+    check(snapshot.getCount(METRIC_HIST_RING_WAIT) == BENCH_METRIC_SAMPLES, "every sample counted");
+    check(snapshot.maxUs[METRIC_HIST_RING_WAIT] == 0x3FF, "largest sample kept");
+    Metrics::reset();
+}
+
+int main() {
+    Metrics::setDumpInterval(0);
+    device = DeviceRegistry::registerDevice("bench", "00:00:00:00:00:00");
+    fillSamples();
+
+    benchDecode();
+    benchRender();
+    benchLines();
+    benchRing();
+    benchBlocks();
+    benchFilter();
+    benchMetrics();
+
+    Serial.printf("%s, %d check%s failed\n", failures ? "FAILED" : "OK", failures, failures == 1 ? "" : "s");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * BTLogger sender benchmark
+ *
+ * Synthetic load generator for measuring the BTLogger receive path. Every
+ * record carries a run id and a sequence number, so the receiver can count
+ * loss, duplicates and reordering and time each record from this log call
+ * to the card and the screen (see "Benchmarking" in README.md).
+ *
+ * Build and flash with:  pio run -e bench_sender -t upload
+ * Workload knobs are the BENCH_* defines below; override any of them from
+ * build_flags in platformio.ini (e.g. -DBENCH_RATE_HZ=1000).
+ *
+ * Record text (must match Core/BenchmarkMonitor.hpp):
+ *   "@B <run:4 hex> <sequence> <padding>"   one per workload record
+ *   "@B <run:4 hex> <sequence> END"         last record of a run
+ */
+
+#include <Arduino.h>
+#include <esp_system.h>
+#include "BTLoggerSender_ESPLog.hpp"
+
+// Workload
+#ifndef BENCH_RATE_HZ
+#define BENCH_RATE_HZ 200  // Records per second on average; 0 sends as fast as the sender accepts them
+#endif
+#ifndef BENCH_BURST
+#define BENCH_BURST 1  // Records logged back to back; bursts are spaced to keep the average rate
+#endif
+#ifndef BENCH_LENGTH_MIN
+#define BENCH_LENGTH_MIN 16  // Message length, uniform between min and max ...
+#endif
+#ifndef BENCH_LENGTH_MAX
+#define BENCH_LENGTH_MAX 80
+#endif
+#ifndef BENCH_LONG_PERCENT
+#define BENCH_LONG_PERCENT 5  // ... except this share, which are BENCH_LENGTH_LONG
+#endif
+#ifndef BENCH_LENGTH_LONG
+#define BENCH_LENGTH_LONG 200
+#endif
+#ifndef BENCH_TAGS
+#define BENCH_TAGS 8  // Distinct tags, picked at random
+#endif
+#ifndef BENCH_WARN_PERCENT
+#define BENCH_WARN_PERCENT 0  // WARN records raise toasts on the receiver
+#endif
+#ifndef BENCH_ERROR_PERCENT
+#define BENCH_ERROR_PERCENT 0  // ERROR records force a synced card commit
+#endif
+
+// Run control
+#ifndef BENCH_DURATION_S
+#define BENCH_DURATION_S 60
+#endif
+#ifndef BENCH_SETTLE_MS
+#define BENCH_SETTLE_MS 3000  // After connecting, so the first clock sync exchange is done
+#endif
+#ifndef BENCH_PAUSE_S
+#define BENCH_PAUSE_S 10  // Between runs; each run gets a new id
+#endif
+
+// Sender options
+#ifndef BENCH_ASYNC_BYTES
+#define BENCH_ASYNC_BYTES BTLOGGER_ASYNC_DEFAULT_CAPACITY  // 0 sends on the calling task
+#endif
+#ifndef BENCH_BATCHING
+#define BENCH_BATCHING 1
+#endif
+#ifndef BENCH_COMPRESSION
+#define BENCH_COMPRESSION 1
+#endif
+#ifndef BENCH_TOKENIZED
+#define BENCH_TOKENIZED 0
+#endif
+#ifndef BENCH_RETRANSMIT_BYTES
+#define BENCH_RETRANSMIT_BYTES 0  // History for resends; 0 leaves gaps as lost
+#endif
+
+#define BENCH_MAX_PADDING 220
+
+static const char* TAG = "BENCH";
+
+static char tags[BENCH_TAGS][8];
+static char padding[BENCH_MAX_PADDING + 1];
+
+static uint16_t runId = 0;
+static uint32_t sequence = 0;
+static unsigned long runStart = 0;
+static int64_t nextBurstUs = 0;
+static bool running = false;
+static unsigned long connectedSince = 0;
+static unsigned long idleSince = 0;
+
+static size_t pickLength() {
+    size_t length = BENCH_LENGTH_MIN;
+    if (BENCH_LONG_PERCENT > 0 && esp_random() % 100 < BENCH_LONG_PERCENT) {
+        length = BENCH_LENGTH_LONG;
+    } else if (BENCH_LENGTH_MAX > BENCH_LENGTH_MIN) {
+        length += esp_random() % (BENCH_LENGTH_MAX - BENCH_LENGTH_MIN + 1);
+    }
+
+    // The header takes about 16 characters of it
+    return length > 16 ? min((size_t)(length - 16), (size_t)BENCH_MAX_PADDING) : 0;
+}
+
+static void logRecord() {
+    const char* tag = tags[esp_random() % BENCH_TAGS];
+    int pad = pickLength();
+    uint32_t roll = esp_random() % 100;
+
+    if (roll < BENCH_ERROR_PERCENT) {
+        ESP_LOGE(tag, "@B %04x %lu %.*s", runId, (unsigned long)sequence, pad, padding);
+    } else if (roll < BENCH_ERROR_PERCENT + BENCH_WARN_PERCENT) {
+        ESP_LOGW(tag, "@B %04x %lu %.*s", runId, (unsigned long)sequence, pad, padding);
+    } else {
+        ESP_LOGI(tag, "@B %04x %lu %.*s", runId, (unsigned long)sequence, pad, padding);
+    }
+    sequence++;
+}
+
+static void startRun() {
+    runId = (uint16_t)(esp_random() & 0xFFFF);
+    sequence = 0;
+    runStart = millis();
+    nextBurstUs = esp_timer_get_time();
+    running = true;
+    Serial.printf("Benchmark run %04x: %d Hz, bursts of %d, %d-%d chars (%d%% %d), %d tags, %d s\n", runId,
+                  BENCH_RATE_HZ, BENCH_BURST, BENCH_LENGTH_MIN, BENCH_LENGTH_MAX, BENCH_LONG_PERCENT,
+                  BENCH_LENGTH_LONG, BENCH_TAGS, BENCH_DURATION_S);
+}
+
+static void finishRun() {
+    ESP_LOGI(TAG, "@B %04x %lu END", runId, (unsigned long)sequence);
+    BTLoggerSender::flush();
+    running = false;
+    idleSince = millis();
+
+    unsigned long elapsed = millis() - runStart;
+    Serial.printf("Benchmark run %04x done: %lu records in %lu ms (%.1f/s)\n", runId, (unsigned long)sequence, elapsed,
+                  elapsed > 0 ? sequence * 1000.0f / elapsed : 0.0f);
+    Serial.println(BTLoggerSender::getStatus());
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    for (int i = 0; i < BENCH_TAGS; i++) {
+        snprintf(tags[i], sizeof(tags[i]), "B%02d", i);
+    }
+    for (int i = 0; i < BENCH_MAX_PADDING; i++) {
+        padding[i] = 'a' + i % 26;
+    }
+    padding[BENCH_MAX_PADDING] = '\0';
+
+    if (BENCH_ASYNC_BYTES > 0) {
+        BTLoggerSender::enableAsync(BENCH_ASYNC_BYTES, BT_DROP_NEWEST);  // Losses show up as gaps, not overwrites
+    }
+    BTLoggerSender::setBatching(BENCH_BATCHING);
+    BTLoggerSender::setCompression(BENCH_COMPRESSION);
+    BTLoggerSender::setTokenizedLogging(BENCH_TOKENIZED);
+    if (BENCH_RETRANSMIT_BYTES > 0) {
+        BTLoggerSender::enableRetransmit(BENCH_RETRANSMIT_BYTES);
+    }
+
+    // Serial output would be the bottleneck
+    BTLoggerSender::begin("BTLogger_Bench", BT_INFO, ESP_LOG_NONE);
+}
+
+void loop() {
+    bool linked = BTLoggerSender::isConnected() && BTLoggerSender::getWireVersion() > 0;
+    if (!linked) {
+        if (running) {
+            Serial.println("Benchmark run interrupted - link lost");
+            finishRun();
+        }
+        connectedSince = 0;
+        delay(100);
+        return;
+    }
+    if (connectedSince == 0) {
+        connectedSince = millis();
+    }
+
+    if (!running) {
+        bool settled = millis() - connectedSince >= BENCH_SETTLE_MS;
+        bool rested = idleSince == 0 || millis() - idleSince >= BENCH_PAUSE_S * 1000UL;
+        if (settled && rested) {
+            startRun();
+        } else {
+            delay(10);
+        }
+        return;
+    }
+
+    if (millis() - runStart >= BENCH_DURATION_S * 1000UL) {
+        finishRun();
+        return;
+    }
+
+    // Keep the average rate over the run, without catching up in one big burst after a stall
+    int64_t now = esp_timer_get_time();
+    if (BENCH_RATE_HZ > 0 && now < nextBurstUs) {
+        int64_t wait = nextBurstUs - now;
+        if (wait > 2000) {
+            delay(wait / 1000 - 1);
+        } else {
+            delayMicroseconds(wait);
+        }
+        return;
+    }
+
+    for (int i = 0; i < BENCH_BURST; i++) {
+        logRecord();
+    }
+    if (BENCH_RATE_HZ > 0) {
+        nextBurstUs = max(nextBurstUs + (int64_t)BENCH_BURST * 1000000 / BENCH_RATE_HZ, now - 100000);
+    } else {
+        delay(0);
+    }
+}
@@ -3,21 +3,31 @@
 #include "UI/TouchManager.hpp"
 #include "UI/ToastManager.hpp"
 #include "UI/ScreenManager.hpp"
+#include "UI/RenderTarget.hpp"
 #include "UI/Screens/MainMenuScreen.hpp"
 #include "UI/Screens/LogViewerScreen.hpp"
 #include "UI/Screens/SystemInfoScreen.hpp"
+#include "UI/Screens/DiagnosticsScreen.hpp"
 #include "UI/Screens/DeviceManagerScreen.hpp"
 #include "UI/Screens/FileBrowserScreen.hpp"
+#include "UI/Screens/FileViewerScreen.hpp"
+#include "UI/Screens/SessionSearchScreen.hpp"
 #include "UI/Screens/SettingsScreen.hpp"
+#include "UI/Screens/LogFilterScreen.hpp"
+#include "UI/Screens/SenderLevelsScreen.hpp"
 #include "UI/CriticalErrorHandler.hpp"
 #include "Core/CoreTaskManager.hpp"
 #include "Core/BluetoothManager.hpp"
 #include "Core/SDCardManager.hpp"
+#include "Core/FormatDictionary.hpp"
+#include "Core/LiveFilter.hpp"
+#include "Core/SerialMirror.hpp"
+#include "Core/NetworkRelay.hpp"
 
 namespace BTLogger {
 
 BTLoggerApp::BTLoggerApp()
-    : coreTaskManager(nullptr), running(false), initialized(false), lastUpdate(0) {
+    : coreTaskManager(nullptr), logViewer(nullptr), running(false), initialized(false), firstRecordSeen(false), lastUpdate(0) {
 }
 
 BTLoggerApp::~BTLoggerApp() {
@@ -34,15 +44,66 @@ bool BTLoggerApp::initialize() {
         return true;
     }
 
-    Serial.begin(115200);
+    // The mirror's baud rate is a setting; the UART buffer has to be sized before begin()
+    Core::SerialMirror::loadSettings();
+    Serial.setTxBufferSize(SERIAL_MIRROR_TX_BUFFER);
+    Serial.begin(Core::SerialMirror::getBaud());
+    Core::NetworkRelay::loadSettings();
     Serial.println("=================================");
     Serial.println("BTLogger - Bluetooth Log Receiver");
     Serial.println("=================================");
 
     // Initialize hardware
     setupHardware();
-    lcd.init();
 
+    // Only what scanning needs; the display, touch and screens come up in start() once it runs
+    if (!initializeCore()) {
+        return false;
+    }
+
+    initialized = true;
+    Serial.println("BTLogger initialized successfully!");
+
+    return true;
+}
+
+void BTLoggerApp::start() {
+    if (!initialized) {
+        if (!initialize()) {
+            Serial.println("Failed to initialize BTLogger");
+            return;
+        }
+    }
+
+    running = true;
+    Serial.println("BTLogger started - Starting core tasks...");
+
+    // Core 0 first: the logger is usually powered up with its target, so scanning starts before anything else
+    // (the communications task's first update() starts it). The storage task mounts the card alongside it
+    coreTaskManager->start();
+    Core::SerialMirror::setCommandHandler([this](const char* line) {
+        coreTaskManager->handleSerialCommand(line);
+    });
+    Core::SerialMirror::begin();
+
+    // Then the UI on Core 1, while the card mounts; logging goes on without it if it fails
+    bool uiReady = initializeUI();
+    if (uiReady) {
+        coreTaskManager->startUI();
+    } else {
+        Serial.println("ERROR: UI initialization failed - logging continues without it");
+    }
+
+    // Wi-Fi last; it shares the radio with BLE
+    Core::NetworkRelay::begin();
+
+    // Show welcome toast
+    if (uiReady) {
+        UI::ToastManager::showSuccess("BTLogger Ready - Scanning for devices...");
+    }
+}
+
+bool BTLoggerApp::initializeCore() {
     // Initialize core task manager
     Serial.println("Initializing CoreTaskManager...");
     coreTaskManager = new Core::CoreTaskManager();
@@ -51,8 +112,31 @@ bool BTLoggerApp::initialize() {
         return false;
     }
 
+    // Set up callbacks for Bluetooth manager
+    if (coreTaskManager->getBluetoothManager()) {
+        coreTaskManager->getBluetoothManager()->setLogCallback([this](const Core::LogPacket& packet, Core::DeviceId deviceId) {
+            onLogReceived(packet, deviceId);
+        });
+
+        coreTaskManager->getBluetoothManager()->setConnectionCallback([this](Core::DeviceId deviceId, bool connected) {
+            onDeviceConnection(deviceId, connected);
+        });
+    }
+    return true;
+}
+
+bool BTLoggerApp::initializeUI() {
+    // The viewer is built up front so its scrollback fills from the first record on, visible or not
+    UI::ScreenManager::initialize(lcd);
+    auto viewer = new UI::Screens::LogViewerScreen();
+    UI::ScreenManager::registerScreen(viewer);
+    logViewer = viewer;
+
+    lcd.init();
+
     // Initialize UI systems (on Core 1)
     UI::UIScale::initialize();
+    UI::UIScale::loadFontMetrics(lcd);
     if (!UI::TouchManager::initialize(lcd)) {
         Serial.println("ERROR: Touch initialization failed");
         return false;
@@ -66,69 +150,69 @@ bool BTLoggerApp::initialize() {
         Serial.println("Touch calibration needed - can be done from Settings screen");
     }
 
-    // Initialize screen system
-    UI::ScreenManager::initialize(lcd);
-
-    // Register screens
+    // The rest are built on first navigation
     UI::ScreenManager::registerScreen(new UI::Screens::MainMenuScreen());
-    UI::ScreenManager::registerScreen(new UI::Screens::LogViewerScreen());
-    UI::ScreenManager::registerScreen(new UI::Screens::SystemInfoScreen());
-
-    // Create and connect DeviceManager to BluetoothManager
-    auto deviceManager = new UI::Screens::DeviceManagerScreen();
-    deviceManager->setBluetoothManager(coreTaskManager->getBluetoothManager());
-    UI::ScreenManager::registerScreen(deviceManager);
-
-    // Create and connect FileBrowser to SDCardManager
-    auto fileBrowser = new UI::Screens::FileBrowserScreen();
-    fileBrowser->setSDCardManager(coreTaskManager->getSDCardManager());
-    UI::ScreenManager::registerScreen(fileBrowser);
-
-    UI::ScreenManager::registerScreen(new UI::Screens::SettingsScreen());
+    UI::ScreenManager::registerScreen("SystemInfo", []() -> UI::Screen* {
+        return new UI::Screens::SystemInfoScreen();
+    });
+    UI::ScreenManager::registerScreen("Diagnostics", []() -> UI::Screen* {
+        return new UI::Screens::DiagnosticsScreen();
+    });
+
+    // DeviceManager, FileBrowser and SessionSearch are connected to their managers when built
+    Core::BluetoothManager* bluetooth = coreTaskManager->getBluetoothManager();
+    UI::ScreenManager::registerScreen("DeviceManager", [bluetooth]() -> UI::Screen* {
+        auto deviceManager = new UI::Screens::DeviceManagerScreen();
+        deviceManager->setBluetoothManager(bluetooth);
+        return deviceManager;
+    });
+    Core::SDCardManager* sdCard = coreTaskManager->getSDCardManager();
+    UI::ScreenManager::registerScreen("FileBrowser", [this, sdCard]() -> UI::Screen* {
+        auto fileBrowser = new UI::Screens::FileBrowserScreen();
+        fileBrowser->setSDCardManager(sdCard);
+        fileBrowser->setFileOperationCallback([this](const String& operation, const String& path) {
+            return onFileOperation(operation, path);
+        });
+        return fileBrowser;
+    });
+
+    // Storage results come back on the UI task
+    coreTaskManager->setUIEventCallback([](const char* event, const char* value) {
+        if (strcmp(event, "file_deleted") == 0) {
+            auto fileBrowser = static_cast<UI::Screens::FileBrowserScreen*>(UI::ScreenManager::getScreen("FileBrowser"));
+            if (fileBrowser) {
+                fileBrowser->onFileDeleted(strcmp(value, "success") == 0);
+            }
+        }
+    });
+    UI::ScreenManager::registerScreen("FileViewer", []() -> UI::Screen* {
+        return new UI::Screens::FileViewerScreen();
+    });
+    Core::CoreTaskManager* tasks = coreTaskManager;
+    UI::ScreenManager::registerScreen("SessionSearch", [tasks]() -> UI::Screen* {
+        auto sessionSearch = new UI::Screens::SessionSearchScreen();
+        sessionSearch->setCoreTaskManager(tasks);
+        return sessionSearch;
+    });
+
+    UI::ScreenManager::registerScreen("Settings", []() -> UI::Screen* {
+        return new UI::Screens::SettingsScreen();
+    });
+    UI::ScreenManager::registerScreen("LogFilter", []() -> UI::Screen* {
+        return new UI::Screens::LogFilterScreen();
+    });
+    UI::ScreenManager::registerScreen("SenderLevels", []() -> UI::Screen* {
+        return new UI::Screens::SenderLevelsScreen();
+    });
+
+    // Off-screen canvas sized to whatever memory the viewer left (RENDER_HEAP_RESERVE covers the lazy screens)
+    UI::RenderTarget::initialize(lcd);
 
     // Start with main menu
     UI::ScreenManager::navigateTo("MainMenu");
-
-    // Set up callbacks for Bluetooth manager
-    if (coreTaskManager->getBluetoothManager()) {
-        coreTaskManager->getBluetoothManager()->setLogCallback([this](const Core::LogPacket& packet, const String& deviceName) {
-            onLogReceived(packet, deviceName);
-        });
-
-        coreTaskManager->getBluetoothManager()->setConnectionCallback([this](const String& deviceName, bool connected) {
-            onDeviceConnection(deviceName, connected);
-        });
-    }
-
-    initialized = true;
-    Serial.println("BTLogger initialized successfully!");
-
     return true;
 }
 
-void BTLoggerApp::start() {
-    if (!initialized) {
-        if (!initialize()) {
-            Serial.println("Failed to initialize BTLogger");
-            return;
-        }
-    }
-
-    running = true;
-    Serial.println("BTLogger started - Starting core tasks...");
-
-    // Start the core task manager
-    coreTaskManager->start();
-
-    // Start scanning for devices
-    if (coreTaskManager->getBluetoothManager()) {
-        coreTaskManager->getBluetoothManager()->startScanning();
-    }
-
-    // Show welcome toast
-    UI::ToastManager::showSuccess("BTLogger Ready - Scanning for devices...");
-}
-
 void BTLoggerApp::stop() {
     if (!running) {
         return;
@@ -140,6 +224,8 @@ void BTLoggerApp::stop() {
     if (coreTaskManager) {
         coreTaskManager->stop();
     }
+    Core::SerialMirror::end();
+    Core::NetworkRelay::end();
 
     Serial.println("BTLogger stopped");
 }
@@ -168,54 +254,68 @@ void BTLoggerApp::handleInput() {
     // This is kept for compatibility but is no longer needed
 }
 
-void BTLoggerApp::onLogReceived(const Core::LogPacket& packet, const String& deviceName) {
-    // Save to SD card (this callback runs on communications core)
-    if (coreTaskManager->getSDCardManager()) {
-        coreTaskManager->getSDCardManager()->saveLogToSession(packet, deviceName);
+void BTLoggerApp::onLogReceived(const Core::LogPacket& packet, Core::DeviceId deviceId) {
+    if (!firstRecordSeen) {
+        firstRecordSeen = true;
+        Serial.printf("First record %lu ms after boot\n", millis());
     }
 
-    // Print to serial for debugging
-    Serial.printf("[%s] %s: %s\n", deviceName.c_str(), packet.tag, packet.message);
+    // Hand off to the storage task (runs on the communications task while it drains the ingest ring)
+    coreTaskManager->submitLog(packet, deviceId);
+
+    // Serial mirror and network relay only queue; they drop rather than hold up ingest
+    char rendered[sizeof(packet.message)];
+    const char* text = Core::FormatDictionary::messageText(packet, rendered, sizeof(rendered));
+    Core::SerialMirror::write(packet, deviceId, text);
+    Core::NetworkRelay::write(packet, deviceId, text);
+
+    // Records the live filter rejects stay out of the viewer's ring and its toasts
+    if (!Core::LiveFilter::accepts(packet, deviceId, text)) {
+        return;
+    }
 
-    // Send to LogViewer screen if it exists
-    auto screen = UI::ScreenManager::getScreen("LogViewer");
-    if (screen) {
-        // We know this is a LogViewerScreen based on the name
-        auto logViewer = static_cast<UI::Screens::LogViewerScreen*>(screen);
-        logViewer->addLogEntry(deviceName, packet.tag, packet.message, packet.level);
+    // Send to LogViewer screen once the UI has built it
+    UI::Screens::LogViewerScreen* viewer = logViewer;
+    if (viewer) {
+        viewer->addLogEntry(packet.timestamp, deviceId, packet.tagId, packet.message, packet.length, packet.level,
+                               packet.flags, packet.receivedUs);
     }
 
-    // Send message to UI task for toast notifications
-    Core::CoreMessage message(Core::MSG_LOG_RECEIVED, deviceName, String(packet.message), packet.level);
-    coreTaskManager->sendToUI(message);
+    // Send message to UI task for toast notifications (never stall ingest on a full queue)
+    if (packet.level >= 3) {  // WARN and ERROR, the levels the UI task shows toasts for
+        coreTaskManager->postToUI(Core::MSG_LOG_RECEIVED, text, nullptr, packet.level, deviceId | (packet.tagId << 8), 0);
+    }
 }
 
-void BTLoggerApp::onDeviceConnection(const String& deviceName, bool connected) {
+void BTLoggerApp::onDeviceConnection(Core::DeviceId deviceId, bool connected) {
+    String deviceName = Core::DeviceRegistry::getName(deviceId);
     if (connected) {
         Serial.printf("Device connected: %s\n", deviceName.c_str());
 
         // Start new logging session
-        if (coreTaskManager->getSDCardManager()) {
-            coreTaskManager->getSDCardManager()->startNewSession(deviceName);
-        }
+        coreTaskManager->sendToStorage(Core::StorageMessage(Core::STORAGE_SESSION_START, deviceId),
+                                       pdMS_TO_TICKS(STORAGE_CONTROL_TIMEOUT_MS));
 
         // Update status footer with connection info
         UI::ScreenManager::setStatusText("Connected: " + deviceName);
     } else {
         Serial.printf("Device disconnected: %s\n", deviceName.c_str());
 
-        // End current session
-        if (coreTaskManager->getSDCardManager()) {
-            coreTaskManager->getSDCardManager()->endCurrentSession();
-        }
+        // End this device's session; other devices keep logging
+        coreTaskManager->sendToStorage(Core::StorageMessage(Core::STORAGE_SESSION_END, deviceId),
+                                       pdMS_TO_TICKS(STORAGE_CONTROL_TIMEOUT_MS));
 
         // Update status footer
-        UI::ScreenManager::setStatusText("Disconnected - Scanning for devices...");
+        size_t remaining = coreTaskManager->getBluetoothManager()->getConnectedDeviceCount();
+        if (remaining > 0) {
+            UI::ScreenManager::setStatusText("Disconnected: " + deviceName + " (" + String(remaining) + " connected)");
+        } else {
+            UI::ScreenManager::setStatusText("Disconnected - Scanning for devices...");
+        }
     }
 
     // Send message to UI task for any additional processing if needed
-    Core::CoreMessage message(Core::MSG_DEVICE_CONNECTION, deviceName, "", connected ? 1 : 0);
-    coreTaskManager->sendToUI(message);
+    coreTaskManager->sendToUI(Core::CoreMessage(Core::MSG_DEVICE_CONNECTION, connected ? 1 : 0, deviceId));
 }
 
 void BTLoggerApp::onDeviceConnectRequest(const String& address) {
@@ -225,10 +325,10 @@ void BTLoggerApp::onDeviceConnectRequest(const String& address) {
     }
 }
 
-void BTLoggerApp::onFileOperation(const String& operation, const String& path) {
-    // Send file operation to communications task
-    Core::CoreMessage message(Core::MSG_FILE_OPERATION, operation, path);
-    coreTaskManager->sendToCommunications(message);
+bool BTLoggerApp::onFileOperation(const String& operation, const String& path) {
+    // Send file operation to the storage task
+    Core::StorageMessageType type = operation == "delete" ? Core::STORAGE_FILE_DELETE : Core::STORAGE_FILE_LOAD;
+    return coreTaskManager->sendToStorage(Core::StorageMessage(type, path), pdMS_TO_TICKS(STORAGE_CONTROL_TIMEOUT_MS));
 }
 
 void BTLoggerApp::setupHardware() {
@@ -265,7 +365,7 @@ void BTLoggerApp::updateLEDs() {
         bool hasSDCard = coreTaskManager &&
                          coreTaskManager->getSDCardManager() &&
                          coreTaskManager->getSDCardManager()->isCardPresent();
-        if (hasSDCard && !coreTaskManager->getSDCardManager()->getCurrentSessionFile().isEmpty()) {
+        if (hasSDCard && coreTaskManager->getSDCardManager()->getActiveSessionCount() > 0) {
             // Blink when actively logging
             digitalWrite(led_pin[2], ledState ? LOW : HIGH);
             ledState = !ledState;
@@ -6,6 +6,7 @@
 #define USE_BITBANG_TOUCH
 
 #include <Arduino.h>
+#include <atomic>
 #include "Hardware/ESP32_SPI_9341.h"
 #include "Core/CoreTaskManager.hpp"
 #include "Core/BluetoothManager.hpp"
@@ -16,6 +17,12 @@
 
 namespace BTLogger {
 
+namespace UI {
+namespace Screens {
+class LogViewerScreen;
+}
+}  // namespace UI
+
 // LED pin definitions
 const int led_pin[3] = {4, 16, 17};  // Red, Green, Blue LEDs
 
@@ -49,7 +56,7 @@ class BTLoggerApp {
 
     // Callbacks for UI integration
     void onDeviceConnectRequest(const String& address);
-    void onFileOperation(const String& operation, const String& path);
+    bool onFileOperation(const String& operation, const String& path);  // Queued for the storage task
 
    private:
     // Hardware
@@ -59,6 +66,7 @@ class BTLoggerApp {
     Core::BluetoothManager bluetoothManager;
     Core::SDCardManager sdCardManager;
     Core::CoreTaskManager* coreTaskManager;
+    std::atomic<UI::Screens::LogViewerScreen*> logViewer;  // Set by the UI once built, read on the communications task
 
     // UI subsystems
     UI::ScreenManager screenManager;
@@ -66,6 +74,7 @@ class BTLoggerApp {
     // State
     bool running;
     bool initialized;
+    bool firstRecordSeen;  // Communications task only
     unsigned long lastUpdate;
 
     // Internal methods
@@ -79,8 +88,8 @@ class BTLoggerApp {
     void handleError(const String& error);
 
     // Event handlers (these will be called from callbacks)
-    void onLogReceived(const Core::LogPacket& packet, const String& deviceName);
-    void onDeviceConnection(const String& deviceName, bool connected);
+    void onLogReceived(const Core::LogPacket& packet, Core::DeviceId deviceId);
+    void onDeviceConnection(Core::DeviceId deviceId, bool connected);
 };
 
 }  // namespace BTLogger
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "BenchmarkMonitor.hpp"
+#include "FormatDictionary.hpp"
+#include "DeviceRegistry.hpp"
+#include "Metrics.hpp"
+#include <esp_timer.h>
+
+namespace BTLogger {
+namespace Core {
+
+BenchmarkMonitor::Run BenchmarkMonitor::runs[DEVICE_REGISTRY_SLOTS];
+DeviceId BenchmarkMonitor::latest = DEVICE_ID_UNKNOWN;
+portMUX_TYPE BenchmarkMonitor::lock = portMUX_INITIALIZER_UNLOCKED;
+
+bool BenchmarkMonitor::observe(DeviceId device, const LogPacket& packet, int64_t arrivalUs) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return false;
+    }
+
+    // Cheap reject for everything else: the text, or the format of a tokenized record
+    const size_t prefixLength = sizeof(BENCH_RECORD_PREFIX) - 1;
+    char rendered[sizeof(LogPacket::message)];
+    const char* text = packet.message;
+    if (packet.flags & WIRE_RECORD_FLAG_TOKENIZED) {
+        uint16_t entry = FORMAT_ENTRY_NONE;
+        size_t formatLength = 0;
+        memcpy(&entry, packet.message, sizeof(entry));
+        const char* format = FormatDictionary::getFormat(entry, formatLength);
+        if (!format || formatLength < prefixLength || memcmp(format, BENCH_RECORD_PREFIX, prefixLength) != 0) {
+            return false;
+        }
+        text = FormatDictionary::messageText(packet, rendered, sizeof(rendered));
+    }
+    if (strncmp(text, BENCH_RECORD_PREFIX, prefixLength) != 0) {
+        return false;
+    }
+
+    uint16_t runId = 0;
+    uint32_t sequence = 0;
+    bool end = false;
+    if (!parse(text + prefixLength, runId, sequence, end)) {
+        return false;
+    }
+
+    bool started = false;
+    portENTER_CRITICAL(&lock);
+    Run& run = runs[device];
+    BenchmarkStatus& status = run.status;
+    if (!status.active && status.runId == runId && status.firstUs != 0) {
+        portEXIT_CRITICAL(&lock);
+        return true;  // Straggler of a run already reported
+    }
+    if (!status.active || status.runId != runId) {
+        startRun(run, device, runId, arrivalUs);
+        started = true;
+    }
+    status.lastUs = arrivalUs;
+
+    if (end) {
+        // The END record carries the number of records in the run
+        status.ended = true;
+        status.expected = max(status.expected, sequence);
+    } else if (sequence >= status.expected) {
+        // Newest so far; anything skipped counts as lost until it turns up
+        uint32_t advance = sequence + 1 - status.expected;
+        run.window = advance >= 64 ? 0 : run.window << advance;
+        run.window |= 1;
+        status.expected = sequence + 1;
+        status.received++;
+    } else {
+        uint32_t behind = status.expected - 1 - sequence;
+        uint64_t bit = behind < BENCH_REORDER_WINDOW ? 1ULL << behind : 0;
+        if (run.window & bit) {
+            status.duplicates++;
+        } else {
+            // Late; further back than the window it is taken as the missing one, not a duplicate
+            run.window |= bit;
+            status.reordered++;
+            status.received++;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    // Each run's latency percentiles start from zero
+    if (started) {
+        Metrics::reset();
+        Serial.printf("Benchmark run %04x started on %s\n", runId, DeviceRegistry::getName(device));
+    }
+    return true;
+}
+
+bool BenchmarkMonitor::parse(const char* text, uint16_t& runId, uint32_t& sequence, bool& end) {
+    char* next = nullptr;
+    unsigned long id = strtoul(text, &next, 16);
+    if (next == text || *next != ' ' || id > 0xFFFF) {
+        return false;
+    }
+    text = next + 1;
+    unsigned long value = strtoul(text, &next, 10);
+    if (next == text) {
+        return false;
+    }
+
+    runId = id;
+    sequence = value;
+    end = strncmp(next, " END", 4) == 0 && next[4] == '\0';
+    return true;
+}
+
+void BenchmarkMonitor::startRun(Run& run, DeviceId device, uint16_t runId, int64_t arrivalUs) {
+    memset(&run, 0, sizeof(Run));
+    run.status.device = device;
+    run.status.runId = runId;
+    run.status.active = true;
+    run.status.firstUs = arrivalUs;
+    run.status.lastUs = arrivalUs;
+    run.reportedUs = arrivalUs;
+    run.lastReport = millis();
+    latest = device;
+}
+
+void BenchmarkMonitor::update() {
+    int64_t nowUs = esp_timer_get_time();
+    for (int i = 0; i < DEVICE_REGISTRY_SLOTS; i++) {
+        // Work on a copy so the report is printed outside the lock
+        portENTER_CRITICAL(&lock);
+        Run run = runs[i];
+        bool done = run.status.active && (run.status.ended || nowUs - run.status.lastUs >= BENCH_IDLE_TIMEOUT_MS * 1000LL);
+        bool due = run.status.active && !done && millis() - run.lastReport >= BENCH_REPORT_INTERVAL_MS;
+        if (done) {
+            runs[i].status.active = false;
+        }
+        if (due) {
+            runs[i].lastReport = millis();
+            runs[i].reportedReceived = run.status.received;
+            runs[i].reportedUs = run.status.lastUs;
+        }
+        portEXIT_CRITICAL(&lock);
+
+        if (done) {
+            report(run, run.status.ended ? "end" : "timeout");
+        } else if (due) {
+            report(run, "progress");
+        }
+    }
+}
+
+void BenchmarkMonitor::report(const Run& run, const char* phase) {
+    const BenchmarkStatus& status = run.status;
+    MetricsSnapshot metrics;
+    Metrics::snapshot(metrics);
+
+    // Rate since the last report, next to the rate over the whole run
+    float recent = 0;
+    if (status.lastUs > run.reportedUs) {
+        recent = (status.received - run.reportedReceived) * 1000000.0f / (status.lastUs - run.reportedUs);
+    }
+
+    Serial.printf("bench,%04x,%s,%s,rx=%lu,expected=%lu,lost=%lu,dup=%lu,reorder=%lu,rate=%.1f,recent=%.1f",
+                  status.runId, DeviceRegistry::getName(status.device), phase, (unsigned long)status.received,
+                  (unsigned long)status.expected, (unsigned long)status.getLost(), (unsigned long)status.duplicates,
+                  (unsigned long)status.reordered, status.getRate(), recent);
+
+    const MetricHistogram latencies[] = {METRIC_HIST_SENDER_TO_RX, METRIC_HIST_RX_TO_SD, METRIC_HIST_RX_TO_PIXEL};
+    for (MetricHistogram histogram : latencies) {
+        Serial.printf(",%s=%lu/%lu/%lu", Metrics::getHistogramName(histogram),
+                      (unsigned long)metrics.getPercentileUs(histogram, 50),
+                      (unsigned long)metrics.getPercentileUs(histogram, 99), (unsigned long)metrics.maxUs[histogram]);
+    }
+    Serial.println();
+}
+
+bool BenchmarkMonitor::getStatus(BenchmarkStatus& status) {
+    if (latest >= DEVICE_REGISTRY_SLOTS) {
+        return false;
+    }
+    portENTER_CRITICAL(&lock);
+    status = runs[latest].status;
+    portEXIT_CRITICAL(&lock);
+    return true;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
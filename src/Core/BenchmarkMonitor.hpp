@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "DeviceRegistry.hpp"
+#include "LogProtocol.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Benchmark records (must match bench/sender/main.cpp):
+//   "@B <run:4 hex> <sequence> <padding>", and "@B <run> <sequence> END" to close a run
+#define BENCH_RECORD_PREFIX "@B "
+#define BENCH_REPORT_INTERVAL_MS 5000
+#define BENCH_IDLE_TIMEOUT_MS 5000  // A run that stops without its END record is closed after this
+#define BENCH_REORDER_WINDOW 64     // Sequences behind the newest that are checked for duplicates
+
+// One benchmark run, as received
+struct BenchmarkStatus {
+    DeviceId device;
+    uint16_t runId;
+    bool active;
+    bool ended;         // END seen; expected is exact from then on
+    uint32_t received;  // Unique records, END excluded
+    uint32_t duplicates;
+    uint32_t reordered;  // Arrived after a higher sequence
+    uint32_t expected;   // Highest sequence + 1, or the END record's count
+    int64_t firstUs;     // Arrival of the first and the latest record
+    int64_t lastUs;
+
+    uint32_t getLost() const { return expected > received ? expected - received : 0; }
+    float getRate() const { return received > 1 && lastUs > firstUs ? (received - 1) * 1000000.0f / (lastUs - firstUs) : 0; }
+};
+
+/**
+ * BenchmarkMonitor is the receiving half of the sender benchmark. It picks
+ * the benchmark's records out of the normal stream (they go on to the card
+ * and the screen like any other, so the whole path is measured) and checks
+ * their sequence numbers for loss, duplicates and reordering.
+ *
+ * A new run resets Metrics, so the latency percentiles reported with it -
+ * sender to receive, receive to card, receive to screen - cover just that
+ * run. Progress goes to the serial port every 5 seconds and a summary when
+ * the run ends.
+ *
+ * observe() runs on the communications task, update() on the storage task;
+ * status is safe from any task.
+ */
+class BenchmarkMonitor {
+   public:
+    // True if packet was a benchmark record; arrivalUs is its receive time
+    static bool observe(DeviceId device, const LogPacket& packet, int64_t arrivalUs);
+
+    // Progress reports and closing idle runs
+    static void update();
+
+    // Most recently started run
+    static bool getStatus(BenchmarkStatus& status);
+
+   private:
+    struct Run {
+        BenchmarkStatus status;
+        uint64_t window;  // Bit n: sequence expected - 1 - n has arrived
+        unsigned long lastReport;
+        uint32_t reportedReceived;
+        int64_t reportedUs;
+    };
+
+    static Run runs[DEVICE_REGISTRY_SLOTS];
+    static DeviceId latest;
+    static portMUX_TYPE lock;
+
+    static bool parse(const char* text, uint16_t& runId, uint32_t& sequence, bool& end);
+    static void startRun(Run& run, DeviceId device, uint16_t runId, int64_t arrivalUs);
+    static void report(const Run& run, const char* phase);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
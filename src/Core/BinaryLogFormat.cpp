@@ -0,0 +1,468 @@
+#include "BinaryLogFormat.hpp"
+#include "FormatDictionary.hpp"
+#include "LogProtocol.hpp"
+#include <stddef.h>
+
+namespace BTLogger {
+namespace Core {
+
+// Bytes a record entry needs besides its message: type, 5 byte delta, flags, 2 byte micros, tag id, 2 byte length
+static const size_t RECORD_MAX_OVERHEAD = 1 + 5 + 1 + 2 + 1 + 2;
+
+static size_t putVarint(uint8_t* out, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[length++] = value;
+    return length;
+}
+
+BinaryBlockWriter::BinaryBlockWriter()
+    : buffer(nullptr), seed(0), length(sizeof(BinaryLogBlockHeader)), recordCount(0), baseTimestamp(0), lastTimestamp(0),
+      tagCount(0), formatCount(0) {
+}
+
+BinaryBlockWriter::~BinaryBlockWriter() {
+    free(buffer);
+    buffer = nullptr;
+}
+
+bool BinaryBlockWriter::initialize() {
+    if (!buffer) {
+        buffer = static_cast<uint8_t*>(malloc(BINARY_LOG_BLOCK_SIZE));
+        if (!buffer) {
+            Serial.println("Failed to allocate binary log block");
+            return false;
+        }
+    }
+    reset();
+    return true;
+}
+
+void BinaryBlockWriter::reset() {
+    length = sizeof(BinaryLogBlockHeader);
+    recordCount = 0;
+    levelMask = 0;
+    tagBits = 0;
+    tagCount = 0;
+    memset(blockTags, 0, sizeof(blockTags));
+    formatCount = 0;
+}
+
+bool BinaryBlockWriter::append(const LogPacket& packet) {
+    if (!buffer || recordCount == UINT16_MAX) {
+        return false;
+    }
+
+    size_t tagLength = strnlen(packet.tag, sizeof(packet.tag) - 1);
+    size_t messageLength = min((size_t)packet.length, sizeof(packet.message) - 1);
+    bool tokenized = (packet.flags & WIRE_RECORD_FLAG_TOKENIZED) && messageLength >= 2;
+
+    // Work out which definitions this record still needs in the block; interned tags skip the name compare
+    bool interned = packet.tagId != TAG_ID_OTHER && packet.tagId < TAG_REGISTRY_SLOTS;
+    int tagId = interned ? blockTags[packet.tagId] - 1 : findTag(packet.tag);
+    size_t needed = RECORD_MAX_OVERHEAD + messageLength;
+    if (tagId < 0) {
+        if (tagCount >= BINARY_LOG_BLOCK_TAGS) return false;
+        needed += 3 + tagLength;
+    }
+
+    uint16_t entry = FORMAT_ENTRY_NONE;
+    const char* format = nullptr;
+    size_t formatLength = 0;
+    if (tokenized) {
+        memcpy(&entry, packet.message, sizeof(entry));
+        if (findFormat(entry) < 0) {
+            format = FormatDictionary::getFormat(entry, formatLength);
+            if (format) {
+                if (formatCount >= BINARY_LOG_BLOCK_FORMATS) return false;
+                needed += 4 + formatLength;
+            }
+        }
+    }
+    if (length + needed > BINARY_LOG_BLOCK_SIZE) {
+        return false;
+    }
+
+    if (recordCount == 0) {
+        baseTimestamp = packet.timestamp;
+        lastTimestamp = packet.timestamp;
+    }
+
+    if (tagId < 0) {
+        tagId = tagCount;
+        buffer[length++] = BINARY_ENTRY_TAG;
+        buffer[length++] = tagId;
+        tagOffsets[tagCount++] = length;
+        buffer[length++] = tagLength;
+        memcpy(buffer + length, packet.tag, tagLength);
+        length += tagLength;
+        if (interned) {
+            blockTags[packet.tagId] = tagId + 1;
+        }
+    }
+
+    if (format) {
+        buffer[length++] = BINARY_ENTRY_FORMAT;
+        memcpy(buffer + length, &entry, sizeof(entry));
+        length += sizeof(entry);
+        buffer[length++] = formatLength;
+        memcpy(buffer + length, format, formatLength);
+        length += formatLength;
+        formats[formatCount++] = entry;
+    }
+
+    // Zigzag so replayed records older than the previous one stay small
+    int32_t delta = (int32_t)(packet.timestamp - lastTimestamp);
+    uint8_t hasFlags = packet.flags ? BINARY_RECORD_HAS_FLAGS : 0;
+    uint8_t hasMicros = packet.micros ? BINARY_RECORD_HAS_MICROS : 0;
+    buffer[length++] = BINARY_ENTRY_RECORD | hasMicros | hasFlags | (packet.level & 0x07);
+    length += putVarint(buffer + length, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+    if (hasFlags) {
+        buffer[length++] = packet.flags;
+    }
+    if (hasMicros) {
+        length += putVarint(buffer + length, packet.micros);
+    }
+    buffer[length++] = tagId;
+    length += putVarint(buffer + length, messageLength);
+    memcpy(buffer + length, packet.message, messageLength);
+    length += messageLength;
+
+    lastTimestamp = packet.timestamp;
+    recordCount++;
+    levelMask |= 1 << (packet.level & 0x07);
+    tagBits |= interned ? hashBit(TagRegistry::getHash(packet.tagId)) : tagBit(packet.tag, tagLength);
+    return true;
+}
+
+const uint8_t* BinaryBlockWriter::finish(size_t& blockLength) {
+    BinaryLogBlockHeader header;
+    header.magic = BINARY_LOG_BLOCK_MAGIC;
+    header.payloadLength = length - sizeof(header);
+    header.recordCount = recordCount;
+    header.baseTimestamp = baseTimestamp;
+    header.levelMask = levelMask;
+    header.reserved = 0;
+    header.tagBits = tagBits;
+    header.crc = esp_rom_crc32_le(seed, buffer + sizeof(header), header.payloadLength);
+    header.crc = esp_rom_crc32_le(header.crc, &header.levelMask, offsetof(BinaryLogBlockHeader, crc) -
+                                                                  offsetof(BinaryLogBlockHeader, levelMask));
+    memcpy(buffer, &header, sizeof(header));
+
+    blockLength = length;
+    return buffer;
+}
+
+void BinaryBlockWriter::fillFileHeader(BinaryLogFileHeader& header, const char* deviceName, bool segment) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic));
+    header.version = BINARY_LOG_VERSION;
+    header.flags = segment ? BINARY_LOG_FLAG_SEGMENT : 0;
+    header.headerLength = sizeof(header);
+    header.startTime = millis();
+    strncpy(header.deviceName, deviceName ? deviceName : "", sizeof(header.deviceName) - 1);
+    header.blockSeed = esp_random() ^ header.startTime;
+}
+
+uint32_t BinaryBlockWriter::tagBit(const char* tag, size_t length) {
+    return hashBit(TagRegistry::hash(tag, length));
+}
+
+uint32_t BinaryBlockWriter::hashBit(uint32_t hash) {
+    // The tag's FNV-1a hash (as TagRegistry keeps it), folded to one of 32 bits
+    return 1UL << ((hash ^ (hash >> 5) ^ (hash >> 10)) & 31);
+}
+
+int BinaryBlockWriter::findTag(const char* tag) const {
+    size_t tagLength = strnlen(tag, 31);
+    for (uint8_t i = 0; i < tagCount; i++) {
+        uint16_t offset = tagOffsets[i];
+        if (buffer[offset] == tagLength && memcmp(buffer + offset + 1, tag, tagLength) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int BinaryBlockWriter::findFormat(uint16_t entry) const {
+    for (uint8_t i = 0; i < formatCount; i++) {
+        if (formats[i] == entry) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+BinaryLogReader::BinaryLogReader()
+    : file(nullptr), block(nullptr), payloadLength(0), offset(0), timestamp(0), skippedBlocks(0), limit(0),
+      contiguous(false), validLength(0), blockStart(0), filterLevels(0xFF), filterTags(0), filteredBlocks(0),
+      filteredRecords(0), tagsDefined(0),
+      formatCount(0) {
+    memset(&header, 0, sizeof(header));
+}
+
+BinaryLogReader::~BinaryLogReader() {
+    free(block);
+    block = nullptr;
+}
+
+bool BinaryLogReader::isBinaryLog(File& file) {
+    char magic[4];
+    size_t position = file.position();
+    bool binary = file.read(reinterpret_cast<uint8_t*>(magic), sizeof(magic)) == sizeof(magic) &&
+                  memcmp(magic, BINARY_LOG_MAGIC, sizeof(magic)) == 0;
+    file.seek(position);
+    return binary;
+}
+
+bool BinaryLogReader::open(File& source) {
+    file = &source;
+    file->seek(0);
+    memset(&header, 0, sizeof(header));
+    size_t got = file->read(reinterpret_cast<uint8_t*>(&header), sizeof(header));
+    if (got < BINARY_LOG_HEADER_V2_LENGTH || memcmp(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version > BINARY_LOG_VERSION || header.headerLength < BINARY_LOG_HEADER_V2_LENGTH ||
+        got < min((size_t)header.headerLength, sizeof(header))) {
+        Serial.println("Not a BTLogger binary log");
+        return false;
+    }
+    if (header.headerLength < sizeof(header)) {
+        header.blockSeed = 0;  // Older file; what was read past its header is block data
+    }
+    header.deviceName[sizeof(header.deviceName) - 1] = '\0';
+    file->seek(header.headerLength);
+
+    limit = file->size();
+    contiguous = false;
+    if (header.flags & BINARY_LOG_FLAG_SEGMENT) {
+        if (header.dataLength >= header.headerLength) {
+            limit = min(limit, (size_t)header.dataLength);
+        } else {
+            contiguous = true;
+        }
+    }
+    validLength = header.headerLength;
+
+    if (!block) {
+        block = static_cast<uint8_t*>(malloc(BINARY_LOG_BLOCK_SIZE));
+        if (!block) {
+            Serial.println("Failed to allocate binary log block");
+            return false;
+        }
+    }
+    payloadLength = 0;
+    offset = 0;
+    skippedBlocks = 0;
+    filterLevels = 0xFF;
+    filterTags = 0;
+    filteredBlocks = 0;
+    filteredRecords = 0;
+    return true;
+}
+
+bool BinaryLogReader::loadBlock() {
+    while (file->position() + sizeof(BinaryLogBlockHeader) <= limit) {
+        size_t start = file->position();
+        BinaryLogBlockHeader blockHeader;
+        if (file->read(reinterpret_cast<uint8_t*>(&blockHeader), sizeof(blockHeader)) != sizeof(blockHeader)) {
+            return false;
+        }
+
+        bool plausible = blockHeader.magic == BINARY_LOG_BLOCK_MAGIC &&
+                         blockHeader.payloadLength <= BINARY_LOG_BLOCK_SIZE - sizeof(blockHeader) &&
+                         start + sizeof(blockHeader) + blockHeader.payloadLength <= limit;
+        bool wanted = (blockHeader.levelMask & filterLevels) && (!filterTags || (blockHeader.tagBits & filterTags));
+        if (plausible && !wanted && !contiguous) {
+            // Nothing wanted here; taken on trust, as checking the CRC would mean reading it anyway
+            filteredBlocks++;
+            filteredRecords += blockHeader.recordCount;
+            file->seek(start + sizeof(blockHeader) + blockHeader.payloadLength);
+            continue;
+        }
+
+        bool valid = plausible && file->read(block, blockHeader.payloadLength) == blockHeader.payloadLength;
+        if (valid) {
+            uint32_t crc = esp_rom_crc32_le(header.blockSeed, block, blockHeader.payloadLength);
+            crc = esp_rom_crc32_le(crc, &blockHeader.levelMask,
+                                   offsetof(BinaryLogBlockHeader, crc) - offsetof(BinaryLogBlockHeader, levelMask));
+            valid = crc == blockHeader.crc;
+        }
+        if (valid && !wanted) {
+            // An open segment's end is only found by checking every block, wanted or not
+            filteredBlocks++;
+            filteredRecords += blockHeader.recordCount;
+            validLength = file->position();
+            continue;
+        }
+        if (valid) {
+            payloadLength = blockHeader.payloadLength;
+            offset = 0;
+            timestamp = blockHeader.baseTimestamp;
+            tagsDefined = 0;
+            formatCount = 0;
+            validLength = file->position();
+            blockStart = start;
+            return true;
+        }
+        if (contiguous) {
+            return false;
+        }
+
+        // Torn or corrupt: look for the next block one byte further on
+        if (blockHeader.magic == BINARY_LOG_BLOCK_MAGIC) {
+            skippedBlocks++;
+        }
+        file->seek(start + 1);
+    }
+    return false;
+}
+
+void BinaryLogReader::setBlockFilter(uint8_t levelMask, uint32_t tagBits) {
+    filterLevels = levelMask;
+    filterTags = tagBits;
+}
+
+uint32_t BinaryLogReader::takeFilteredRecords() {
+    uint32_t records = filteredRecords;
+    filteredRecords = 0;
+    return records;
+}
+
+bool BinaryLogReader::seek(size_t position) {
+    if (!file || position < header.headerLength || !file->seek(position)) {
+        return false;
+    }
+    payloadLength = 0;
+    offset = 0;
+    return true;
+}
+
+bool BinaryLogReader::readVarint(uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (offset >= payloadLength) {
+            return false;
+        }
+        uint8_t byte = block[offset++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BinaryLogReader::next(BinaryLogRecord& record) {
+    if (!file || !block) {
+        return false;
+    }
+
+    while (true) {
+        while (offset >= payloadLength) {
+            if (!loadBlock()) {
+                return false;
+            }
+        }
+
+        uint8_t type = block[offset++];
+        if (type == BINARY_ENTRY_TAG || type == BINARY_ENTRY_FORMAT) {
+            size_t idLength = type == BINARY_ENTRY_TAG ? 1 : 2;
+            if (offset + idLength + 1 > payloadLength) {
+                offset = payloadLength;
+                continue;
+            }
+            uint16_t id = block[offset];
+            if (idLength == 2) {
+                memcpy(&id, block + offset, sizeof(id));
+            }
+            offset += idLength;
+            uint16_t definition = offset;
+            offset += 1 + block[offset];
+            if (offset > payloadLength) {
+                continue;
+            }
+
+            if (type == BINARY_ENTRY_TAG && id < BINARY_LOG_BLOCK_TAGS) {
+                tagOffsets[id] = definition;
+                tagsDefined |= 1UL << id;
+            } else if (type == BINARY_ENTRY_FORMAT && formatCount < BINARY_LOG_BLOCK_FORMATS) {
+                formatEntries[formatCount] = id;
+                formatOffsets[formatCount++] = definition;
+            }
+            continue;
+        }
+
+        if (!(type & BINARY_ENTRY_RECORD)) {
+            offset = payloadLength;  // Unknown entry - the rest of the block cannot be parsed
+            continue;
+        }
+
+        uint32_t zigzag;
+        uint32_t messageLength;
+        if (!readVarint(zigzag)) {
+            continue;
+        }
+        timestamp += (int32_t)((zigzag >> 1) ^ -(int32_t)(zigzag & 1));
+        record.timestamp = timestamp;
+        record.level = type & 0x07;
+        record.flags = (type & BINARY_RECORD_HAS_FLAGS) && offset < payloadLength ? block[offset++] : 0;
+        uint32_t micros = 0;
+        if ((type & BINARY_RECORD_HAS_MICROS) && !readVarint(micros)) {
+            continue;
+        }
+        record.micros = micros;
+
+        uint8_t tagId = offset < payloadLength ? block[offset++] : 0xFF;
+        if (!readVarint(messageLength) || offset + messageLength > payloadLength) {
+            offset = payloadLength;
+            continue;
+        }
+
+        record.tag[0] = '\0';
+        if (tagId < BINARY_LOG_BLOCK_TAGS && (tagsDefined & (1UL << tagId))) {
+            uint8_t tagLength = min((size_t)block[tagOffsets[tagId]], sizeof(record.tag) - 1);
+            memcpy(record.tag, block + tagOffsets[tagId] + 1, tagLength);
+            record.tag[tagLength] = '\0';
+        }
+
+        const char* message = reinterpret_cast<const char*>(block + offset);
+        offset += messageLength;
+
+        if ((record.flags & WIRE_RECORD_FLAG_TOKENIZED) && messageLength >= 2) {
+            uint16_t entry;
+            memcpy(&entry, message, sizeof(entry));
+            const char* format = nullptr;
+            size_t formatLength = 0;
+            for (uint8_t i = 0; i < formatCount; i++) {
+                if (formatEntries[i] == entry) {
+                    format = reinterpret_cast<const char*>(block + formatOffsets[i] + 1);
+                    formatLength = block[formatOffsets[i]];
+                    break;
+                }
+            }
+            record.messageLength = FormatDictionary::renderFormat(format, formatLength, message + 2, messageLength - 2,
+                                                                  record.message, sizeof(record.message));
+        } else {
+            record.messageLength = min((size_t)messageLength, sizeof(record.message) - 1);
+            memcpy(record.message, message, record.messageLength);
+            record.message[record.messageLength] = '\0';
+        }
+        return true;
+    }
+}
+
+size_t BinaryLogReader::formatTextLine(const BinaryLogRecord& record, char* out, size_t capacity) {
+    int length = snprintf(out, capacity, "%lu.%03u%03u,%u,%s,%s\n", (unsigned long)(record.timestamp / 1000),
+                          (unsigned)(record.timestamp % 1000), (unsigned)record.micros, record.level, record.tag,
+                          record.message);
+    if (length <= 0) {
+        return 0;
+    }
+    return min((size_t)length, capacity - 1);
+}
+
+}  // namespace Core
+}  // namespace BTLogger
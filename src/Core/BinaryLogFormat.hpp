@@ -0,0 +1,206 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include "DeviceRegistry.hpp"
+#include "TagRegistry.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+struct LogPacket;
+
+/*
+ * Binary session file (.blg)
+ *
+ *   [file header][block][block]...
+ *
+ * Each block is self-contained so a reader can start at any block and
+ * a torn or corrupt one is skipped without losing the rest of the file:
+ *   [magic:2][payloadLength:2][recordCount:2][baseTimestamp:4][levelMask:1][reserved:1]
+ *   [tagBits:4][crc32:4][payload...]
+ * levelMask has a bit per level present and tagBits one bit per tag (by hash),
+ * so searches can pass over a block from its header alone. The CRC covers the
+ * payload followed by levelMask..tagBits, seeded with the file header's
+ * blockSeed, so blocks a deleted file left on reused clusters never check
+ * out in a new one. Payload entries:
+ *   TAG     [0x01][tagId:1][length:1][bytes]       before the first record using it
+ *   FORMAT  [0x02][entry:2][length:1][bytes]       before the first tokenized record using it
+ *   RECORD  [0x80 | hasMicros << 4 | hasFlags << 3 | level][delta varint][flags:1 if hasFlags]
+ *           [micros varint if hasMicros][tagId:1][messageLength varint][message...]
+ * Timestamps are milliseconds of the BTLogger time base (see ClockSync), with
+ * the microseconds below them in micros; delta is the zigzag varint difference to the
+ * previous record of the block (the first one to baseTimestamp). Tokenized
+ * messages keep their [entry:2][args...] body and are formatted on export.
+ */
+#define BINARY_LOG_MAGIC "BTLB"
+#define BINARY_LOG_VERSION 3  // 2 added micros, 3 blockSeed
+#define BINARY_LOG_BLOCK_MAGIC 0x1BB7
+#define BINARY_LOG_BLOCK_SIZE 4096  // Header included
+#define BINARY_LOG_BLOCK_TAGS 32
+#define BINARY_LOG_BLOCK_FORMATS 32
+#define BINARY_LOG_EXTENSION ".blg"
+
+// Segment files are preallocated to their full size; only dataLength bytes
+// are meaningful. dataLength stays 0 until the file is closed (or recovered),
+// and readers then stop at the first block that fails instead of resyncing,
+// since whatever follows is left over from the card.
+#define BINARY_LOG_FLAG_SEGMENT 0x01
+
+enum BinaryLogEntry : uint8_t {
+    BINARY_ENTRY_TAG = 0x01,
+    BINARY_ENTRY_FORMAT = 0x02,
+    BINARY_ENTRY_RECORD = 0x80
+};
+
+// Bits of a record entry's type byte besides BINARY_ENTRY_RECORD and the level
+#define BINARY_RECORD_HAS_FLAGS 0x08
+#define BINARY_RECORD_HAS_MICROS 0x10
+
+struct __attribute__((packed)) BinaryLogFileHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t flags;
+    uint16_t headerLength;  // Readers skip anything past the fields they know
+    uint32_t startTime;     // BTLogger millis() when the file was opened (the ClockSync time base)
+    char deviceName[DEVICE_NAME_LENGTH];
+    uint32_t dataLength;    // Segment files: header + blocks written, 0 while open
+    uint32_t blockSeed;     // CRC seed of the file's blocks, random per file; 0 (and absent) before version 3
+};
+
+// Header length of files written before blockSeed
+#define BINARY_LOG_HEADER_V2_LENGTH offsetof(BinaryLogFileHeader, blockSeed)
+
+struct __attribute__((packed)) BinaryLogBlockHeader {
+    uint16_t magic;
+    uint16_t payloadLength;
+    uint16_t recordCount;
+    uint32_t baseTimestamp;
+    uint8_t levelMask;
+    uint8_t reserved;
+    uint32_t tagBits;
+    uint32_t crc;
+};
+
+// One record as read back, message formatted
+struct BinaryLogRecord {
+    uint32_t timestamp;
+    uint16_t micros;
+    uint8_t level;
+    uint8_t flags;
+    char tag[32];
+    uint16_t messageLength;
+    char message[256];
+};
+
+/**
+ * BinaryBlockWriter assembles one block in memory. append() fails once the
+ * block is full; the caller then writes out finish() and starts over.
+ */
+class BinaryBlockWriter {
+   public:
+    BinaryBlockWriter();
+    ~BinaryBlockWriter();
+
+    bool initialize();
+    void reset();
+    void setSeed(uint32_t blockSeed) { seed = blockSeed; }  // The file header's blockSeed; kept across reset()
+    bool append(const LogPacket& packet);
+    bool isEmpty() const { return recordCount == 0; }
+    uint16_t getRecordCount() const { return recordCount; }
+    size_t getLength() const { return length; }
+
+    // Seal the block (header + CRC); returns its bytes and total length
+    const uint8_t* finish(size_t& blockLength);
+
+    static void fillFileHeader(BinaryLogFileHeader& header, const char* deviceName, bool segment = false);
+
+    // The tagBits bit of a tag
+    static uint32_t tagBit(const char* tag, size_t length);
+
+   private:
+    uint8_t* buffer;
+    uint32_t seed;
+    size_t length;  // Header space included
+    uint16_t recordCount;
+    uint32_t baseTimestamp;
+    uint32_t lastTimestamp;
+    uint8_t levelMask;
+    uint32_t tagBits;
+
+    uint8_t tagCount;
+    uint16_t tagOffsets[BINARY_LOG_BLOCK_TAGS];  // Of each definition's length byte in buffer
+    uint8_t blockTags[TAG_REGISTRY_SLOTS];       // Block tag + 1 by TagRegistry id, 0 until defined
+    uint8_t formatCount;
+    uint16_t formats[BINARY_LOG_BLOCK_FORMATS];
+
+    int findTag(const char* tag) const;
+    int findFormat(uint16_t entry) const;
+    static uint32_t hashBit(uint32_t hash);
+};
+
+/**
+ * BinaryLogReader walks the records of a .blg file in order, verifying each
+ * block and skipping the ones that fail.
+ */
+class BinaryLogReader {
+   public:
+    BinaryLogReader();
+    ~BinaryLogReader();
+
+    bool open(File& file);
+    bool next(BinaryLogRecord& record);
+    const BinaryLogFileHeader& getHeader() const { return header; }
+    uint32_t getBlockSeed() const { return header.blockSeed; }  // For appending to the file
+    uint32_t getSkippedBlocks() const { return skippedBlocks; }
+
+    // End of the last block read; for an unclosed segment, its recovered length once next() is done
+    size_t getValidLength() const { return validLength; }
+
+    // Blocks are self-contained, so reading can restart at any block start
+    size_t getBlockStart() const { return blockStart; }
+    bool seek(size_t position);
+
+    // Pass over blocks with none of these levels, or (if tagBits is set) none of these tags,
+    // without reading them. Their records are counted so line numbers stay right.
+    void setBlockFilter(uint8_t levelMask, uint32_t tagBits);
+    uint32_t getFilteredBlocks() const { return filteredBlocks; }
+
+    // Records passed over by the block filter since the last call
+    uint32_t takeFilteredRecords();
+
+    static bool isBinaryLog(File& file);
+
+    // The text session line for a record: "seconds.micros,level,tag,message\n"
+    static size_t formatTextLine(const BinaryLogRecord& record, char* out, size_t capacity);
+
+   private:
+    File* file;
+    BinaryLogFileHeader header;
+    uint8_t* block;
+    size_t payloadLength;
+    size_t offset;
+    uint32_t timestamp;
+    uint32_t skippedBlocks;
+    size_t limit;        // Blocks are only read below this file position
+    bool contiguous;     // Unclosed segment: stop at the first bad block
+    size_t validLength;
+    size_t blockStart;
+
+    uint8_t filterLevels;
+    uint32_t filterTags;
+    uint32_t filteredBlocks;
+    uint32_t filteredRecords;
+
+    // Offsets into the current block of its tag and format definitions
+    uint16_t tagOffsets[BINARY_LOG_BLOCK_TAGS];
+    uint32_t tagsDefined;  // Bit per tag id
+    uint16_t formatOffsets[BINARY_LOG_BLOCK_FORMATS];
+    uint16_t formatEntries[BINARY_LOG_BLOCK_FORMATS];
+    uint8_t formatCount;
+
+    bool loadBlock();
+    bool readVarint(uint32_t& value);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
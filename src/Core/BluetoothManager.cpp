@@ -1,4 +1,11 @@
 #include "BluetoothManager.hpp"
+#include "BenchmarkMonitor.hpp"
+#include "ClockSync.hpp"
+#include "DeliveryTracker.hpp"
+#include "FormatDictionary.hpp"
+#include "Metrics.hpp"
+#include "SenderControl.hpp"
+#include "TagRegistry.hpp"
 #include <esp_bt_main.h>
 #include <esp_bt_device.h>
 #include <esp_task_wdt.h>
@@ -9,6 +16,24 @@ namespace Core {
 // Static instance for callbacks
 BluetoothManager* BluetoothManager::instance = nullptr;
 
+static_assert(BT_MAX_CONNECTIONS <= INGEST_RING_CONTROL_SLOTS, "Every connection needs an ingest slot for its disconnect");
+
+// Requested connection parameters per LinkProfile
+struct LinkProfileSettings {
+    uint16_t minInterval;  // 1.25 ms units
+    uint16_t maxInterval;
+    uint16_t latency;
+    uint16_t timeout;  // 10 ms units
+    bool dataLengthExtension;
+    bool phy2M;
+};
+
+static const LinkProfileSettings LINK_PROFILES[] = {
+    {6, 12, 0, 400, true, true},      // LINK_PROFILE_LOW_LATENCY
+    {12, 24, 0, 400, true, true},     // LINK_PROFILE_HIGH_THROUGHPUT
+    {80, 160, 4, 600, false, false},  // LINK_PROFILE_LOW_POWER
+};
+
 // BLE Scan Callbacks
 class BTLoggerScanCallbacks : public BLEAdvertisedDeviceCallbacks {
    public:
@@ -40,17 +65,47 @@ class BTLoggerClientCallbacks : public BLEClientCallbacks {
 };
 
 BluetoothManager::BluetoothManager()
-    : scanner(nullptr), scanning(false), lastScanTime(0) {
+    : scanner(nullptr), connectedCount(0), availableMutex(nullptr), scanning(false), lastScanTime(0),
+      connectRequestQueue(nullptr), connectWorkQueue(nullptr), connectWorkerHandle(nullptr), workerBusy(false),
+      linkProfile(BT_DEFAULT_LINK_PROFILE), pendingDataLengthLink(-1), pendingSubscribeHandle(0), pendingSubscribeStatus(0) {
     // Set UUIDs for BTLogger communication
     targetServiceUUID = "12345678-1234-1234-1234-123456789ABC";
     logCharacteristicUUID = "87654321-4321-4321-4321-CBA987654321";
 
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        notifySources[i] = nullptr;
+        notifyGattcIfs[i] = 0;
+        notifyConnIds[i] = 0;
+        notifyHandles[i] = 0;
+        notifyIds[i] = DEVICE_ID_UNKNOWN;
+        attempts[i].state = CONN_IDLE;
+        attempts[i].client = nullptr;
+        attempts[i].characteristic = nullptr;
+        attempts[i].logHandle = 0;
+        attempts[i].deviceId = DEVICE_ID_UNKNOWN;
+        attempts[i].failures = 0;
+        attempts[i].abortRequested = false;
+        attempts[i].stateSince = 0;
+        attempts[i].retryAt = 0;
+        attempts[i].workerState = CONN_IDLE;
+        attempts[i].workerDone = false;
+        attempts[i].workerSuccess = false;
+        links[i].used = false;
+    }
+    portMUX_INITIALIZE(&linkMux);
+
     instance = this;
 }
 
 BluetoothManager::~BluetoothManager() {
     stopScanning();
 
+    // Let the connect worker finish its current call and exit on its own
+    if (connectWorkerHandle) {
+        uint8_t shutdown = BT_MAX_CONNECTIONS;
+        xQueueSend(connectWorkQueue, &shutdown, 0);
+    }
+
     // Disconnect all devices
     for (auto& device : connectedDevices) {
         if (device.client && device.connected) {
@@ -60,6 +115,9 @@ BluetoothManager::~BluetoothManager() {
     }
 
     connectedDevices.clear();
+    if (availableMutex) {
+        vSemaphoreDelete(availableMutex);
+    }
     instance = nullptr;
 }
 
@@ -73,8 +131,38 @@ bool BluetoothManager::initialize() {
     // Set BLE configuration for better connection reliability (community recommendations)
     BLEDevice::setMTU(517);  // Maximum MTU for better throughput
 
-    // Free up memory by limiting advertising data
-    BLEDevice::setCustomGapHandler(nullptr);
+    // Notifications are queued here and decoded on the communications task
+    if (!ingestRing.initialize()) {
+        return false;
+    }
+
+    availableMutex = xSemaphoreCreateMutex();
+    if (!availableMutex) {
+        Serial.println("Failed to create scan results mutex");
+        return false;
+    }
+
+    // Connection requests are handled by a state machine in update() plus a worker
+    // task that owns the blocking connect/discovery calls
+    connectRequestQueue = xQueueCreate(BT_CONNECT_QUEUE_LENGTH, sizeof(ConnectRequest));
+    connectWorkQueue = xQueueCreate(BT_MAX_CONNECTIONS, sizeof(uint8_t));
+    if (!connectRequestQueue || !connectWorkQueue) {
+        Serial.println("Failed to create connection queues");
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(connectWorkerTask, "BLE_Connect", BT_CONNECT_TASK_STACK_SIZE, this,
+                                BT_CONNECT_TASK_PRIORITY, &connectWorkerHandle, 0) != pdPASS) {
+        Serial.println("Failed to create connection worker task");
+        return false;
+    }
+
+    // Negotiated connection parameters and data length are reported through GAP events
+    BLEDevice::setCustomGapHandler(&gapEventHandler);
+
+    // Devices seen before reconnect without service discovery; their notifications
+    // arrive through the raw GATT client events
+    KnownDeviceCache::initialize();
+    BLEDevice::setCustomGattcHandler(&gattcEventHandler);
 
     // Create BLE scanner
     scanner = BLEDevice::getScan();
@@ -87,20 +175,22 @@ bool BluetoothManager::initialize() {
     return true;
 }
 
-void BluetoothManager::startScanning() {
-    if (scanning || !scanner) {
+void BluetoothManager::startScanning(uint32_t durationSeconds) {
+    // The communications task, the UI and the scan callback all get here; one of them wins
+    bool idle = false;
+    if (!scanner || !scanning.compare_exchange_strong(idle, true)) {
         return;
     }
 
-    Serial.println("Starting BLE scan...");
-    scanning = true;
+    Serial.printf("Starting BLE scan (%lu s)...\n", (unsigned long)durationSeconds);
     lastScanTime = millis();
 
     // Clear previous scan results
+    xSemaphoreTake(availableMutex, portMAX_DELAY);
     availableDevices.clear();
+    xSemaphoreGive(availableMutex);
 
-    // Start scan (5 seconds)
-    scanner->start(5, &scanCompleteCallback, false);
+    scanner->start(durationSeconds, &scanCompleteCallback, false);
 }
 
 void BluetoothManager::stopScanning() {
@@ -124,8 +214,8 @@ void BluetoothManager::onDeviceFound(BLEAdvertisedDevice advertisedDevice) {
     String deviceName = String(advertisedDevice.getName().c_str());
     String deviceAddress = String(advertisedDevice.getAddress().toString().c_str());
 
-    // Filter devices - look for BTLogger compatible devices
-    bool isTargetDevice = false;
+    // Filter devices - look for BTLogger compatible devices (anything we connected to before qualifies)
+    bool isTargetDevice = KnownDeviceCache::contains(deviceAddress.c_str());
 
     if (deviceName.length() > 0) {
         // Accept devices with these patterns
@@ -143,6 +233,7 @@ void BluetoothManager::onDeviceFound(BLEAdvertisedDevice advertisedDevice) {
 
         // Check if we already have this device
         bool alreadyExists = false;
+        xSemaphoreTake(availableMutex, portMAX_DELAY);
         for (auto& device : availableDevices) {
             String existingAddress = String(device.getAddress().toString().c_str());
             if (existingAddress.equals(deviceAddress)) {
@@ -150,146 +241,270 @@ void BluetoothManager::onDeviceFound(BLEAdvertisedDevice advertisedDevice) {
                 break;
             }
         }
-
         if (!alreadyExists) {
             availableDevices.push_back(advertisedDevice);
+        }
+        xSemaphoreGive(availableMutex);
+
+        // Auto-connect to every compatible device; the scan callback only queues the request,
+        // and update() enforces the connection limit, retries and backoff
+        if (!alreadyExists) {
+            Serial.printf("Auto-connecting to: %s\n", deviceName.c_str());
+            connectToDevice(deviceAddress);
+        }
+    }
+}
+
+bool BluetoothManager::connectToDevice(const String& address) {
+    if (!connectRequestQueue) {
+        return false;
+    }
+
+    // Safe from any task: the communications task picks the request up in update()
+    ConnectRequest request;
+    strncpy(request.address, address.c_str(), sizeof(request.address) - 1);
+    request.address[sizeof(request.address) - 1] = '\0';
+    request.disconnect = false;
+    if (xQueueSend(connectRequestQueue, &request, 0) != pdTRUE) {
+        Serial.printf("Connect queue full - dropping request for %s\n", address.c_str());
+        return false;
+    }
+    return true;
+}
+
+void BluetoothManager::processConnectRequests() {
+    ConnectRequest request;
+    while (xQueueReceive(connectRequestQueue, &request, 0) == pdTRUE) {
+        String address = request.address;
+
+        ConnectedDevice* existing = findDevice(address);
+        if (request.disconnect) {
+            // The link's disconnect event tears it down, behind whatever the device sent before it
+            if (existing && existing->client && existing->connected && existing->client->isConnected()) {
+                existing->client->disconnect();
+            } else if (existing) {
+                closeDevice(address);
+            }
+            continue;
+        }
+        if ((existing && existing->connected) || findAttempt(address)) {
+            continue;  // Already connected or in progress
+        }
+
+        BLEAdvertisedDevice advertised;
+        if (!findAdvertisedDevice(address, advertised)) {
+            Serial.printf("Device %s not found in scan results\n", address.c_str());
+            continue;
+        }
+
+        ConnectionAttempt* attempt = nullptr;
+        for (auto& candidate : attempts) {
+            if (candidate.state == CONN_IDLE) {
+                attempt = &candidate;
+                break;
+            }
+        }
+        if (!attempt) {
+            Serial.printf("No free connection slot for %s\n", address.c_str());
+            continue;
+        }
+
+        attempt->state = CONN_QUEUED;
+        attempt->address = address;
+        attempt->advertised = advertised;
+        attempt->client = nullptr;
+        attempt->characteristic = nullptr;
+        attempt->logHandle = 0;
+        attempt->deviceId = DEVICE_ID_UNKNOWN;
+        attempt->failures = 0;
+        attempt->stateSince = millis();
+        Serial.printf("Queued connection to %s\n", address.c_str());
+    }
+}
+
+void BluetoothManager::updateConnectionAttempts() {
+    unsigned long now = millis();
+
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        ConnectionAttempt& attempt = attempts[i];
+
+        switch (attempt.state) {
+            case CONN_QUEUED:
+                // One link setup at a time; the controller serializes them anyway
+                if (workerBusy) {
+                    break;
+                }
+                if (getConnectedDeviceCount() >= BT_MAX_CONNECTIONS) {
+                    Serial.printf("Connection limit reached (%d devices)\n", BT_MAX_CONNECTIONS);
+                    attempt.state = CONN_IDLE;
+                    break;
+                }
+                attempt.workerDone = false;
+                attempt.workerSuccess = false;
+                attempt.workerState = CONN_CONNECTING;
+                attempt.abortRequested = false;
+                attempt.state = CONN_CONNECTING;
+                attempt.stateSince = now;
+                workerBusy = true;
+                {
+                    uint8_t slot = i;
+                    xQueueSend(connectWorkQueue, &slot, 0);
+                }
+                break;
 
-            // Auto-connect to the first compatible device with retry logic
-            if (getConnectedDeviceCount() == 0) {
-                Serial.printf("Auto-connecting to: %s\n", deviceName.c_str());
-
-                // Retry connection up to 3 times (community best practice)
-                bool connectionSuccess = false;
-                for (int retry = 1; retry <= 3 && !connectionSuccess; retry++) {
-                    Serial.printf("Connection attempt %d/3...\n", retry);
-                    connectionSuccess = connectToDevice(deviceAddress);
-                    if (!connectionSuccess && retry < 3) {
-                        Serial.printf("Retry %d failed, waiting 2 seconds...\n", retry);
-                        delay(2000);  // Wait between retries
+            case CONN_CONNECTING:
+            case CONN_DISCOVERING:
+                attempt.state = attempt.workerState;
+                if (attempt.workerDone) {
+                    workerBusy = false;
+                    if (attempt.workerSuccess) {
+                        finishAttempt(attempt);
+                    } else {
+                        failAttempt(attempt, attempt.abortRequested ? "timed out" : "failed");
+                    }
+                } else if (!attempt.abortRequested && now - attempt.stateSince > BT_CONNECT_TIMEOUT_MS) {
+                    // Abort through the stack rather than killing the worker mid-call;
+                    // the worker reports back once the pending operation unwinds
+                    Serial.printf("Connection to %s timed out - aborting\n", attempt.address.c_str());
+                    attempt.abortRequested = true;
+                    if (attempt.client) {
+                        attempt.client->disconnect();
                     }
                 }
+                break;
 
-                if (!connectionSuccess) {
-                    Serial.println("All connection attempts failed - will retry on next scan");
+            case CONN_BACKOFF:
+                if ((long)(now - attempt.retryAt) >= 0) {
+                    attempt.state = CONN_QUEUED;
+                    attempt.stateSince = now;
                 }
-            }
+                break;
+
+            default:
+                break;
         }
     }
 }
 
-bool BluetoothManager::connectToDevice(const String& address) {
-    // Check if already connected
-    for (const auto& device : connectedDevices) {
-        if (device.address == address && device.connected) {
-            Serial.println("Device already connected");
-            return true;
-        }
+void BluetoothManager::finishAttempt(ConnectionAttempt& attempt) {
+    // Add to connected devices
+    ConnectedDevice newDevice;
+    newDevice.id = attempt.deviceId;
+    newDevice.name = DeviceRegistry::getName(attempt.deviceId);
+    newDevice.address = attempt.address;
+    newDevice.client = attempt.client;
+    newDevice.logCharacteristic = attempt.characteristic;
+    newDevice.logHandle = attempt.logHandle;
+    newDevice.connected = true;
+    newDevice.lastSeen = millis();
+
+    connectedDevices.push_back(newDevice);
+    connectedCount.fetch_add(1, std::memory_order_relaxed);
+    DeviceRegistry::setConnected(attempt.deviceId, true);
+    openLinkState(newDevice.id, newDevice.client);
+    ClockSync::begin(newDevice.id);
+    DeliveryTracker::begin(newDevice.id);
+    SenderControl::begin(newDevice.id);
+
+    Serial.printf("Successfully connected to: %s (%lu ms)\n", newDevice.name.c_str(), millis() - attempt.stateSince);
+    attempt.state = CONN_IDLE;
+    attempt.client = nullptr;
+
+    // Call connection callback
+    if (connectionCallback) {
+        connectionCallback(newDevice.id, true);
     }
+}
 
-    Serial.printf("Connecting to device: %s\n", address.c_str());
+void BluetoothManager::failAttempt(ConnectionAttempt& attempt, const char* reason) {
+    // Clean up client properly (community best practice)
+    detachNotifySource(attempt.deviceId);
+    if (attempt.client) {
+        attempt.client->disconnect();
+        delete attempt.client;
+        attempt.client = nullptr;
+    }
 
-    // Find the advertised device
-    BLEAdvertisedDevice* targetDevice = nullptr;
-    for (auto& device : availableDevices) {
-        String deviceAddress = String(device.getAddress().toString().c_str());
-        if (deviceAddress.equals(address)) {
-            targetDevice = &device;
-            break;
-        }
+    attempt.failures++;
+    if (attempt.failures >= BT_CONNECT_MAX_ATTEMPTS) {
+        Serial.printf("Connection to %s %s - giving up until next scan\n", attempt.address.c_str(), reason);
+        attempt.state = CONN_IDLE;
+        return;
     }
 
-    if (!targetDevice) {
-        Serial.println("Device not found in scan results");
-        return false;
+    // Exponential backoff keeps retries quick after a node reboot without hammering the stack
+    unsigned long backoff = min((unsigned long)BT_CONNECT_BACKOFF_MAX_MS,
+                                (unsigned long)BT_CONNECT_BACKOFF_BASE_MS << (attempt.failures - 1));
+    attempt.state = CONN_BACKOFF;
+    attempt.retryAt = millis() + backoff;
+    Serial.printf("Connection to %s %s (attempt %d/%d), retrying in %lu ms\n", attempt.address.c_str(), reason,
+                  attempt.failures, BT_CONNECT_MAX_ATTEMPTS, backoff);
+}
+
+void BluetoothManager::connectWorkerTask(void* parameter) {
+    BluetoothManager* manager = static_cast<BluetoothManager*>(parameter);
+    uint8_t slot;
+
+    // The blocking Bluedroid calls live here so the communications task never waits on them
+    while (xQueueReceive(manager->connectWorkQueue, &slot, portMAX_DELAY) == pdTRUE) {
+        if (slot >= BT_MAX_CONNECTIONS) {
+            break;  // Shutdown
+        }
+        ConnectionAttempt& attempt = manager->attempts[slot];
+        manager->openLink(attempt);
+        attempt.workerDone = true;
     }
 
+    manager->connectWorkerHandle = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void BluetoothManager::openLink(ConnectionAttempt& attempt) {
+    Serial.printf("Connecting to device: %s\n", attempt.address.c_str());
+
     // Create BLE client
-    BLEClient* client = BLEDevice::createClient();
-    client->setClientCallbacks(new BTLoggerClientCallbacks(address));
-
-    // Connect to device using FreeRTOS task with timeout (community proven solution)
-    Serial.println("Attempting BLE connection with task timeout...");
-
-    // Connection state variables
-    volatile bool connectionAttemptComplete = false;
-    volatile bool connectionResult = false;
-    TaskHandle_t connectionTaskHandle = NULL;
-
-    // Connection task parameters
-    struct ConnectionParams {
-        BLEClient* client;
-        BLEAdvertisedDevice* device;
-        volatile bool* complete;
-        volatile bool* result;
-    } connParams = {client, targetDevice, &connectionAttemptComplete, &connectionResult};
-
-    // Create connection task
-    xTaskCreate([](void* param) {
-        ConnectionParams* p = (ConnectionParams*)param;
-        Serial.println("Connection task started...");
-        *(p->result) = p->client->connect(p->device);
-        *(p->complete) = true;
-        Serial.printf("Connection task completed with result: %s\n", *(p->result) ? "SUCCESS" : "FAILED");
-        vTaskDelete(NULL);
-    },
-                "BLE_Connect", 8192, &connParams, 1, &connectionTaskHandle);
-
-    // Wait for connection with timeout
-    unsigned long startTime = millis();
-    const unsigned long TIMEOUT = 10000;  // 10 seconds
-
-    while (!connectionAttemptComplete && (millis() - startTime < TIMEOUT)) {
-        delay(100);
-        yield();  // Allow other tasks to run
-    }
-
-    bool connected = false;
-    if (connectionAttemptComplete) {
-        connected = connectionResult;
-        Serial.printf("Connection completed: %s\n", connected ? "SUCCESS" : "FAILED");
-    } else {
-        Serial.println("Connection timeout - killing task");
-        if (connectionTaskHandle != NULL) {
-            vTaskDelete(connectionTaskHandle);
-        }
-        connected = false;
-    }
-
-    if (!connected) {
-        Serial.println("Failed to connect to device - cleaning up client");
-        // Clean up client properly (community best practice)
-        if (client) {
-            delete client;
-            client = nullptr;
-        }
-        // Brief delay before allowing another connection attempt
-        delay(1000);
-        return false;
+    attempt.client = BLEDevice::createClient();
+    attempt.client->setClientCallbacks(new BTLoggerClientCallbacks(attempt.address));
+
+    if (!attempt.client->connect(&attempt.advertised) || attempt.abortRequested) {
+        return;
+    }
+
+    // Fast path: subscribe straight to the handles found on a previous connection
+    KnownDevice cached;
+    if (KnownDeviceCache::find(attempt.address.c_str(), cached) && cached.hasHandles()) {
+        if (subscribeCached(attempt, cached)) {
+            return;
+        }
+        KnownDeviceCache::invalidateHandles(attempt.address.c_str());
+        if (attempt.abortRequested || !attempt.client->isConnected()) {
+            return;
+        }
     }
 
+    attempt.workerState = CONN_DISCOVERING;
     Serial.println("Connected! Looking for service...");
 
     // Get the service
-    BLERemoteService* service = client->getService(targetServiceUUID.c_str());
-    if (!service) {
+    BLERemoteService* service = attempt.client->getService(targetServiceUUID.c_str());
+    if (!service || attempt.abortRequested) {
         Serial.println("Target service not found");
-        client->disconnect();
-        delete client;
-        return false;
+        return;
     }
 
-    Serial.println("Service found! Looking for characteristic...");
-
     // Get the characteristic
     BLERemoteCharacteristic* characteristic = service->getCharacteristic(logCharacteristicUUID.c_str());
     if (!characteristic) {
         Serial.println("Log characteristic not found");
-        client->disconnect();
-        delete client;
-        return false;
+        return;
     }
 
-    Serial.println("Characteristic found! Setting up notifications...");
+    // Resolve the device id once; every notification is tagged with it from here on
+    attempt.deviceId = DeviceRegistry::registerDevice(attempt.advertised.getName().c_str(), attempt.address.c_str());
+    if (!attachNotifySource(characteristic, attempt.deviceId)) {
+        Serial.println("No free notification slot");
+        return;
+    }
 
     // Register for notifications
     if (characteristic->canNotify()) {
@@ -297,53 +512,155 @@ bool BluetoothManager::connectToDevice(const String& address) {
         Serial.println("Notifications enabled");
     }
 
-    // Add to connected devices
-    ConnectedDevice newDevice;
-    newDevice.name = String(targetDevice->getName().c_str());
-    newDevice.address = address;
-    newDevice.client = client;
-    newDevice.connected = true;
-    newDevice.lastSeen = millis();
+    // Negotiate the wire format
+    sendHello(characteristic);
 
-    connectedDevices.push_back(newDevice);
+    attempt.characteristic = characteristic;
+    attempt.logHandle = characteristic->getHandle();
+    attempt.workerState = CONN_SUBSCRIBED;
+    attempt.workerSuccess = true;
 
-    // Call connection callback
-    if (connectionCallback) {
-        connectionCallback(newDevice.name, true);
+    rememberDevice(attempt, characteristic);
+}
+
+bool BluetoothManager::subscribeCached(ConnectionAttempt& attempt, const KnownDevice& cached) {
+    esp_gatt_if_t gattcIf = attempt.client->getGattcIf();
+    uint16_t connId = attempt.client->getConnId();
+
+    attempt.deviceId = DeviceRegistry::registerDevice(attempt.advertised.getName().c_str(), attempt.address.c_str());
+    if (!attachRawNotifySource(gattcIf, connId, cached.logHandle, attempt.deviceId)) {
+        Serial.println("No free notification slot");
+        return false;
     }
 
-    Serial.printf("Successfully connected to: %s\n", newDevice.name.c_str());
+    // Enable notifications on the cached CCCD and wait for the peer to accept the write;
+    // an error means the peer's GATT table changed and discovery has to run again
+    esp_ble_gattc_register_for_notify(gattcIf, *attempt.client->getPeerAddress().getNative(), cached.logHandle);
+
+    uint8_t enable[2] = {0x01, 0x00};
+    pendingSubscribeStatus = -1;
+    pendingSubscribeHandle = cached.cccdHandle;
+    ulTaskNotifyTake(pdTRUE, 0);
+    esp_err_t result = esp_ble_gattc_write_char_descr(gattcIf, connId, cached.cccdHandle, sizeof(enable), enable,
+                                                      ESP_GATT_WRITE_TYPE_RSP, ESP_GATT_AUTH_REQ_NONE);
+    bool accepted = result == ESP_OK && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BT_CACHED_SUBSCRIBE_TIMEOUT_MS)) > 0 &&
+                    pendingSubscribeStatus == ESP_GATT_OK;
+    pendingSubscribeHandle = 0;
+
+    if (!accepted) {
+        Serial.printf("Cached subscribe to %s failed - running discovery\n", attempt.address.c_str());
+        detachNotifySource(attempt.deviceId);
+        return false;
+    }
+
+    // Negotiate the wire format on the same handle
+    uint8_t hello[8];
+    size_t helloLength = LogProtocol::encodeHello(hello, sizeof(hello));
+    esp_ble_gattc_write_char(gattcIf, connId, cached.logHandle, helloLength, hello,
+                             ESP_GATT_WRITE_TYPE_NO_RSP, ESP_GATT_AUTH_REQ_NONE);
+
+    Serial.printf("Subscribed to %s using cached handles\n", attempt.address.c_str());
+    attempt.logHandle = cached.logHandle;
+    attempt.workerState = CONN_SUBSCRIBED;
+    attempt.workerSuccess = true;
+
+    KnownDeviceCache::store(cached);  // Refresh its LRU position
     return true;
 }
 
-void BluetoothManager::disconnectDevice(const String& address) {
-    for (auto it = connectedDevices.begin(); it != connectedDevices.end(); ++it) {
-        if (it->address == address) {
-            if (it->client && it->connected) {
-                it->client->disconnect();
-                delete it->client;
-            }
+void BluetoothManager::rememberDevice(ConnectionAttempt& attempt, BLERemoteCharacteristic* characteristic) {
+    KnownDevice device;
+    memset(&device, 0, sizeof(device));
+    strncpy(device.address, attempt.address.c_str(), sizeof(device.address) - 1);
+    strncpy(device.name, attempt.advertised.getName().c_str(), sizeof(device.name) - 1);
+    device.addressType = attempt.advertised.getAddressType();
+    device.logHandle = characteristic->getHandle();
 
-            // Call connection callback
-            if (connectionCallback) {
-                connectionCallback(it->name, false);
-            }
+    BLERemoteDescriptor* cccd = characteristic->getDescriptor(BLEUUID((uint16_t)0x2902));
+    device.cccdHandle = cccd ? cccd->getHandle() : 0;
 
-            connectedDevices.erase(it);
-            Serial.printf("Disconnected from device: %s\n", address.c_str());
+    KnownDeviceCache::store(device);
+}
+
+ConnectionState BluetoothManager::getConnectionState(const String& address) const {
+    for (const auto& device : connectedDevices) {
+        if (device.address == address && device.connected) {
+            return CONN_SUBSCRIBED;
+        }
+    }
+    for (const auto& attempt : attempts) {
+        if (attempt.state != CONN_IDLE && attempt.address == address) {
+            return attempt.state;
+        }
+    }
+    return CONN_IDLE;
+}
+
+BluetoothManager::ConnectionAttempt* BluetoothManager::findAttempt(const String& address) {
+    for (auto& attempt : attempts) {
+        if (attempt.state != CONN_IDLE && attempt.address == address) {
+            return &attempt;
+        }
+    }
+    return nullptr;
+}
+
+bool BluetoothManager::findAdvertisedDevice(const String& address, BLEAdvertisedDevice& found) {
+    bool success = false;
+    xSemaphoreTake(availableMutex, portMAX_DELAY);
+    for (auto& device : availableDevices) {
+        String deviceAddress = String(device.getAddress().toString().c_str());
+        if (deviceAddress.equals(address)) {
+            found = device;
+            success = true;
             break;
         }
     }
+    xSemaphoreGive(availableMutex);
+    return success;
+}
+
+void BluetoothManager::disconnectDevice(const String& address) {
+    if (!connectRequestQueue) {
+        return;
+    }
+
+    // Like connectToDevice(), handled by the communications task in update()
+    ConnectRequest request;
+    strncpy(request.address, address.c_str(), sizeof(request.address) - 1);
+    request.address[sizeof(request.address) - 1] = '\0';
+    request.disconnect = true;
+    if (xQueueSend(connectRequestQueue, &request, 0) != pdTRUE) {
+        Serial.printf("Connect queue full - dropping disconnect of %s\n", address.c_str());
+    }
 }
 
 void BluetoothManager::onDeviceDisconnected(const String& address) {
+    // Runs in the BLE stack task, the notify callbacks' producer: the disconnect goes into the ingest
+    // ring behind the device's last notifications, and the communications task closes the device
+    // once it has decoded them (processPendingData())
+    if (!ingestRing.pushEvent(DEVICE_ID_UNKNOWN, INGEST_DISCONNECT, reinterpret_cast<const uint8_t*>(address.c_str()),
+                              min(address.length(), (unsigned int)DEVICE_ADDRESS_LENGTH - 1))) {
+        Serial.printf("No ingest slot for the disconnect of %s\n", address.c_str());
+    }
+}
+
+void BluetoothManager::closeDevice(const String& address) {
     for (auto it = connectedDevices.begin(); it != connectedDevices.end(); ++it) {
         if (it->address == address) {
+            detachNotifySource(it->id);
+            closeLinkState(it->id);
+            ClockSync::end(it->id);
+            DeliveryTracker::end(it->id);
+            SenderControl::end(it->id);
+            logLostRecords(it->id);  // Still inside the session
             it->connected = false;
+            connectedCount.fetch_sub(1, std::memory_order_relaxed);
+            DeviceRegistry::setConnected(it->id, false);
 
             // Call connection callback
             if (connectionCallback) {
-                connectionCallback(it->name, false);
+                connectionCallback(it->id, false);
             }
 
             // Clean up
@@ -359,53 +676,512 @@ void BluetoothManager::onDeviceDisconnected(const String& address) {
 }
 
 void BluetoothManager::notifyCallback(BLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
-    if (BluetoothManager::instance) {
-        String deviceAddress = characteristic->getRemoteService()->getClient()->getPeerAddress().toString().c_str();
-        BluetoothManager::instance->processIncomingData(deviceAddress, data, length);
+    // Runs in the BLE stack task: only copy the bytes, decoding happens in processPendingData()
+    BluetoothManager* manager = BluetoothManager::instance;
+    if (!manager) {
+        return;
+    }
+
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if (manager->notifySources[i] == characteristic) {
+            manager->ingestRing.push(manager->notifyIds[i], data, length);
+            return;
+        }
+    }
+}
+
+void BluetoothManager::gattcEventHandler(esp_gattc_cb_event_t event, esp_gatt_if_t gattcIf, esp_ble_gattc_cb_param_t* param) {
+    // Runs in the Bluedroid task for every GATT client event; only cached subscriptions are handled here
+    BluetoothManager* manager = BluetoothManager::instance;
+    if (!manager) {
+        return;
+    }
+
+    if (event == ESP_GATTC_NOTIFY_EVT) {
+        for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+            if (manager->notifyHandles[i] == param->notify.handle && manager->notifyConnIds[i] == param->notify.conn_id &&
+                manager->notifyGattcIfs[i] == gattcIf) {
+                manager->ingestRing.push(manager->notifyIds[i], param->notify.value, param->notify.value_len);
+                return;
+            }
+        }
+    } else if (event == ESP_GATTC_WRITE_DESCR_EVT) {
+        if (manager->pendingSubscribeHandle != 0 && param->write.handle == manager->pendingSubscribeHandle) {
+            manager->pendingSubscribeStatus = param->write.status;
+            if (manager->connectWorkerHandle) {
+                xTaskNotifyGive(manager->connectWorkerHandle);
+            }
+        }
     }
 }
 
-void BluetoothManager::processIncomingData(const String& deviceAddress, uint8_t* data, size_t length) {
-    if (length < sizeof(LogPacket)) {
-        Serial.println("Received invalid log packet (too small)");
+void BluetoothManager::gapEventHandler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+    // Runs in the Bluedroid task alongside the library's own GAP handling (scan results etc.)
+    BluetoothManager* manager = BluetoothManager::instance;
+    if (!manager) {
         return;
     }
 
-    // Cast the data to LogPacket
-    LogPacket* packet = reinterpret_cast<LogPacket*>(data);
+    if (event == ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT) {
+        portENTER_CRITICAL(&manager->linkMux);
+        for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+            LinkState& link = manager->links[i];
+            if (link.used && memcmp(link.bda, param->update_conn_params.bda, sizeof(esp_bd_addr_t)) == 0) {
+                link.parameters.interval = param->update_conn_params.conn_int;
+                link.parameters.latency = param->update_conn_params.latency;
+                link.parameters.timeout = param->update_conn_params.timeout;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&manager->linkMux);
+    } else if (event == ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT) {
+        portENTER_CRITICAL(&manager->linkMux);
+        int pending = manager->pendingDataLengthLink;
+        if (pending >= 0 && manager->links[pending].used && param->pkt_data_lenth_cmpl.status == ESP_OK) {
+            manager->links[pending].parameters.txDataLength = param->pkt_data_lenth_cmpl.params.tx_len;
+        }
+        manager->pendingDataLengthLink = -1;
+        portEXIT_CRITICAL(&manager->linkMux);
+#if SOC_BLE_50_SUPPORTED
+    } else if (event == ESP_GAP_BLE_PHY_UPDATE_COMPLETE_EVT) {
+        portENTER_CRITICAL(&manager->linkMux);
+        for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+            LinkState& link = manager->links[i];
+            if (link.used && memcmp(link.bda, param->phy_update.bda, sizeof(esp_bd_addr_t)) == 0) {
+                link.parameters.phy = param->phy_update.tx_phy;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&manager->linkMux);
+#endif
+    }
+}
 
-    // Validate packet
-    if (packet->length > sizeof(packet->message) - 1) {
-        Serial.println("Received invalid log packet (message too long)");
+void BluetoothManager::openLinkState(DeviceId id, BLEClient* client) {
+    if (!client) {
         return;
     }
 
-    // Ensure null termination
-    packet->message[packet->length] = '\0';
-    packet->tag[sizeof(packet->tag) - 1] = '\0';
+    // Copied before taking the spinlock, which the registry's own lock must not nest in
+    char name[DEVICE_NAME_LENGTH];
+    strncpy(name, DeviceRegistry::getName(id), sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+
+    int link = -1;
+    portENTER_CRITICAL(&linkMux);
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if (!links[i].used) {
+            links[i].used = true;
+            memcpy(links[i].bda, *client->getPeerAddress().getNative(), sizeof(esp_bd_addr_t));
+            memcpy(links[i].name, name, sizeof(name));
+            links[i].parameters.deviceId = id;
+            links[i].parameters.interval = 0;
+            links[i].parameters.latency = 0;
+            links[i].parameters.timeout = 0;
+            links[i].parameters.mtu = client->getMTU();
+            links[i].parameters.txDataLength = 27;
+            links[i].parameters.phy = 1;
+            links[i].parameters.wireBytes = 0;
+            links[i].parameters.expandedBytes = 0;
+            links[i].parameters.compressed = false;
+            link = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&linkMux);
+
+    if (link >= 0) {
+        applyLinkProfile(link);
+    }
+}
 
-    // Find device name
-    String deviceName = "Unknown";
-    for (const auto& device : connectedDevices) {
-        if (device.address == deviceAddress) {
-            deviceName = device.name;
+void BluetoothManager::closeLinkState(DeviceId id) {
+    portENTER_CRITICAL(&linkMux);
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if (links[i].used && links[i].parameters.deviceId == id) {
+            links[i].used = false;
+            if (pendingDataLengthLink == i) {
+                pendingDataLengthLink = -1;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&linkMux);
+}
+
+void BluetoothManager::applyLinkProfile(int link) {
+    const LinkProfileSettings& settings = LINK_PROFILES[linkProfile];
+
+    esp_ble_conn_update_params_t update = {};
+    portENTER_CRITICAL(&linkMux);
+    bool used = links[link].used;
+    memcpy(update.bda, links[link].bda, sizeof(esp_bd_addr_t));
+    if (used && settings.dataLengthExtension) {
+        pendingDataLengthLink = link;
+    }
+    portEXIT_CRITICAL(&linkMux);
+    if (!used) {
+        return;
+    }
+
+    // The sender may also ask for its own preferences; whatever the controllers settle on
+    // comes back through gapEventHandler
+    update.min_int = settings.minInterval;
+    update.max_int = settings.maxInterval;
+    update.latency = settings.latency;
+    update.timeout = settings.timeout;
+    if (esp_ble_gap_update_conn_params(&update) != ESP_OK) {
+        Serial.println("Connection parameter update request failed");
+    }
+
+    if (settings.dataLengthExtension) {
+        esp_ble_gap_set_pkt_data_len(update.bda, BT_LINK_MAX_DATA_LENGTH);
+    }
+
+#if SOC_BLE_50_SUPPORTED
+    // Classic ESP32 controllers are 1M only; BLE 5 parts (C3/S3/C6) can switch to 2M
+    esp_ble_gap_phy_mask_t phyMask = settings.phy2M ? ESP_BLE_GAP_PHY_2M_PREF_MASK : ESP_BLE_GAP_PHY_1M_PREF_MASK;
+    esp_ble_gap_set_preferred_phy(update.bda, 0, phyMask, phyMask, ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+
+    Serial.printf("Requested %s link profile (%.2f-%.2f ms interval, latency %d)\n", getLinkProfileName(linkProfile),
+                  settings.minInterval * 1.25f, settings.maxInterval * 1.25f, settings.latency);
+}
+
+void BluetoothManager::setLinkProfile(LinkProfile profile) {
+    if (profile == linkProfile) {
+        return;
+    }
+
+    linkProfile = profile;
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        applyLinkProfile(i);
+    }
+}
+
+const char* BluetoothManager::getLinkProfileName(LinkProfile profile) {
+    switch (profile) {
+        case LINK_PROFILE_LOW_LATENCY:
+            return "low-latency";
+        case LINK_PROFILE_HIGH_THROUGHPUT:
+            return "high-throughput";
+        case LINK_PROFILE_LOW_POWER:
+            return "low-power";
+        default:
+            return "unknown";
+    }
+}
+
+bool BluetoothManager::getLinkParameters(DeviceId id, LinkParameters& parameters) const {
+    bool found = false;
+    portENTER_CRITICAL(&linkMux);
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if (links[i].used && links[i].parameters.deviceId == id) {
+            parameters = links[i].parameters;
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&linkMux);
+    return found;
+}
+
+std::vector<LinkParameters> BluetoothManager::getConnectedLinks() const {
+    std::vector<LinkParameters> result;
+    LinkParameters snapshot[BT_MAX_CONNECTIONS];
+    size_t count = 0;
+
+    portENTER_CRITICAL(&linkMux);
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if (links[i].used) {
+            snapshot[count++] = links[i].parameters;
+        }
+    }
+    portEXIT_CRITICAL(&linkMux);
+
+    result.assign(snapshot, snapshot + count);
+    return result;
+}
+
+bool BluetoothManager::attachNotifySource(BLERemoteCharacteristic* characteristic, DeviceId id) {
+    // The id is written before the pointer so the notify callback never sees a stale pairing
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if (!notifySources[i] && !notifyHandles[i]) {
+            notifyIds[i] = id;
+            notifySources[i] = characteristic;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BluetoothManager::attachRawNotifySource(esp_gatt_if_t gattcIf, uint16_t connId, uint16_t handle, DeviceId id) {
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if (!notifySources[i] && !notifyHandles[i]) {
+            notifyIds[i] = id;
+            notifyGattcIfs[i] = gattcIf;
+            notifyConnIds[i] = connId;
+            notifyHandles[i] = handle;
+            return true;
+        }
+    }
+    return false;
+}
+
+void BluetoothManager::detachNotifySource(DeviceId id) {
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if ((notifySources[i] || notifyHandles[i]) && notifyIds[i] == id) {
+            notifySources[i] = nullptr;
+            notifyHandles[i] = 0;
+        }
+    }
+}
+
+size_t BluetoothManager::processPendingData(size_t maxNotifications) {
+    size_t processed = 0;
+    while (processed < maxNotifications) {
+        const IngestSlot* slot = ingestRing.front();
+        if (!slot) {
+            break;
+        }
+
+        if (slot->type == INGEST_DISCONNECT) {
+            char address[DEVICE_ADDRESS_LENGTH];
+            memcpy(address, slot->data, slot->length);
+            address[slot->length] = '\0';
+            ingestRing.pop();
+            closeDevice(address);
+            processed++;
+            continue;
+        }
+        processIncomingData(slot->source, slot->data, slot->length, slot->arrivalUs);
+        ingestRing.pop();
+        processed++;
+    }
+    return processed;
+}
+
+void BluetoothManager::processIncomingData(DeviceId source, const uint8_t* data, size_t length, int64_t arrivalUs) {
+    // A single notification may carry a batch of records, a format for tokenized ones or a sync reply
+    // Version 5 frames number their records; duplicates are dropped here
+    uint16_t sequence = 0;
+    bool sequenced = false;
+    bool resent = false;
+
+    WireFormat format = LogProtocol::decode(
+        data, length,
+        [&](const LogPacket& packet) {
+            if (sequenced && !DeliveryTracker::onRecord(source, sequence++, resent)) {
+                return;
+            }
+            if (resent) {
+                Metrics::count(METRIC_RECORDS_RESENT);
+            }
+            if (!logCallback) {
+                return;
+            }
+
+            // Sender time becomes local time here, before any sink sees the record
+            LogPacket resolved = packet;
+            resolved.receivedUs = (uint32_t)arrivalUs;
+            resolved.tagId = TagRegistry::intern(resolved.tag);
+            int64_t decodedUs = ClockSync::now();
+            Metrics::count(METRIC_DECODED_RECORDS);
+            Metrics::record(METRIC_HIST_RING_WAIT, decodedUs - arrivalUs);
+            if (ClockSync::map(source, resolved, arrivalUs) == CLOCK_SOURCE_SYNC &&
+                !(packet.flags & WIRE_RECORD_FLAG_REPLAYED)) {
+                Metrics::record(METRIC_HIST_SENDER_TO_RX,
+                                arrivalUs - ((int64_t)resolved.timestamp * 1000 + resolved.micros));
+            }
+            if (packet.flags & WIRE_RECORD_FLAG_TOKENIZED) {
+                // Pin the record to the dictionary entry its id means right now
+                uint16_t formatId = FORMAT_ENTRY_NONE;
+                if (packet.length >= 2) {
+                    memcpy(&formatId, packet.message, sizeof(formatId));
+                    formatId = FormatDictionary::resolve(source, formatId);
+                }
+                if (packet.length < 2) {
+                    resolved.length = 2;
+                }
+                memcpy(resolved.message, &formatId, sizeof(formatId));
+            }
+            BenchmarkMonitor::observe(source, resolved, arrivalUs);
+            logCallback(resolved, source);
+        },
+        [&](uint16_t formatId, const char* text, size_t textLength) {
+            FormatDictionary::define(source, formatId, text, textLength);
+        },
+        [&](const WireSyncReply& reply) {
+            ClockSync::onReply(source, reply.sequence, reply.senderMicros, reply.unixMillis, arrivalUs);
+        },
+        [&](WireFrameType type, uint16_t firstSequence, uint16_t count) {
+            if (type == WIRE_FRAME_LOST) {
+                DeliveryTracker::onLost(source, firstSequence, count);
+                return;
+            }
+            sequence = firstSequence;
+            sequenced = true;
+            resent = type == WIRE_FRAME_RESEND;
+        });
+
+    if (format == WireFormat::INVALID) {
+        Metrics::count(METRIC_DECODE_ERRORS);
+        Serial.printf("Received invalid log packet (%d bytes)\n", length);
+        return;
+    }
+    logLostRecords(source);  // From a LOST frame
+
+    // Per-connection compression stats
+    size_t expandedLength = LogProtocol::getExpandedLength(data, length);
+    bool compressed = LogProtocol::isCompressed(data, length);
+    portENTER_CRITICAL(&linkMux);
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if (links[i].used && links[i].parameters.deviceId == source) {
+            links[i].parameters.wireBytes += length;
+            links[i].parameters.expandedBytes += expandedLength;
+            links[i].parameters.compressed |= compressed;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&linkMux);
+
+    for (auto& device : connectedDevices) {
+        if (device.id == source) {
+            device.wireFormat = format;
+            device.wireVersion = format == WireFormat::COMPACT ? data[1] : 0;
             break;
         }
     }
+}
 
-    // Call log callback
-    if (logCallback) {
-        logCallback(*packet, deviceName);
+void BluetoothManager::sendHello(BLERemoteCharacteristic* characteristic) {
+    if (!characteristic || !characteristic->canWrite()) {
+        Serial.println("Log characteristic not writable - staying on legacy format");
+        return;
+    }
+
+    // Offer the compact wire format; legacy senders simply ignore this write
+    uint8_t hello[8];
+    size_t helloLength = LogProtocol::encodeHello(hello, sizeof(hello));
+    characteristic->writeValue(hello, helloLength, false);
+    Serial.printf("Sent protocol hello (wire version %d)\n", BTLOGGER_WIRE_VERSION);
+}
+
+void BluetoothManager::sendSyncRequest(ConnectedDevice& device, uint8_t sequence) {
+    uint8_t request[4];
+    size_t requestLength = LogProtocol::encodeSyncRequest(request, sizeof(request), sequence);
+
+    // Without response: the reply is the acknowledgement, and the send time must not wait on one
+    writeControl(device, request, requestLength);
+}
+
+void BluetoothManager::sendResendRequest(ConnectedDevice& device, uint16_t firstSequence, uint16_t count) {
+    uint8_t request[8];
+    size_t requestLength = LogProtocol::encodeResendRequest(request, sizeof(request), firstSequence, count);
+    writeControl(device, request, requestLength);
+    Serial.printf("Asked %s to resend %u records from %u\n", device.name.c_str(), count, firstSequence);
+}
+
+void BluetoothManager::sendFlow(ConnectedDevice& device, const FlowWindow& window) {
+    uint8_t request[8];
+    size_t requestLength = LogProtocol::encodeFlow(request, sizeof(request), window.minLevel, window.rate);
+    writeControl(device, request, requestLength);
+    Serial.printf("Flow window for %s: level %u and up, %u/s below WARN\n", device.name.c_str(), window.minLevel, window.rate);
+}
+
+void BluetoothManager::sendLevel(ConnectedDevice& device, const char* tag, uint8_t level) {
+    uint8_t request[4 + sizeof(LogPacket::tag)];
+    size_t requestLength = LogProtocol::encodeLevel(request, sizeof(request), tag, level);
+    writeControl(device, request, requestLength);
+}
+
+void BluetoothManager::writeControl(ConnectedDevice& device, uint8_t* request, size_t requestLength) {
+    if (device.logCharacteristic) {
+        if (device.logCharacteristic->canWrite()) {
+            device.logCharacteristic->writeValue(request, requestLength, false);
+        }
+    } else if (device.client && device.logHandle) {
+        esp_ble_gattc_write_char(device.client->getGattcIf(), device.client->getConnId(), device.logHandle, requestLength,
+                                 request, ESP_GATT_WRITE_TYPE_NO_RSP, ESP_GATT_AUTH_REQ_NONE);
+    }
+}
+
+void BluetoothManager::logLostRecords(DeviceId id) {
+    uint16_t firstSequence;
+    uint16_t count;
+    while (DeliveryTracker::takeLost(id, firstSequence, count)) {
+        Metrics::count(METRIC_RECORDS_LOST, count);
+        Serial.printf("%s: %u records lost\n", DeviceRegistry::getName(id), count);
+        if (!logCallback) {
+            continue;
+        }
+
+        // A marker in place of the missing records, already in the local time base
+        int64_t nowUs = ClockSync::now();
+        LogPacket marker;
+        marker.timestamp = nowUs / 1000;
+        marker.micros = nowUs % 1000;
+        marker.receivedUs = (uint32_t)nowUs;
+        marker.level = 3;  // WARN
+        strncpy(marker.tag, BT_LOST_MARKER_TAG, sizeof(marker.tag) - 1);
+        marker.tagId = TagRegistry::intern(marker.tag);
+        marker.length = snprintf(marker.message, sizeof(marker.message), "--- %u records lost (sequence %u-%u) ---",
+                                 count, firstSequence, (uint16_t)(firstSequence + count - 1));
+        logCallback(marker, id);
     }
 }
 
 void BluetoothManager::update() {
     unsigned long currentTime = millis();
 
-    // Restart scanning if needed (every 30 seconds)
-    if (!scanning && (currentTime - lastScanTime > 30000)) {
-        if (getConnectedDeviceCount() == 0) {
-            startScanning();
+    // Advance pending connections (never blocks)
+    processConnectRequests();
+    updateConnectionAttempts();
+
+    // Clock sync requests that are due; legacy senders can't answer them
+    for (auto& device : connectedDevices) {
+        uint8_t sequence;
+        if (device.connected && device.wireFormat != WireFormat::LEGACY && ClockSync::takeRequest(device.id, sequence)) {
+            sendSyncRequest(device, sequence);
+        }
+    }
+
+    // Missing records to ask for again, and those given up on
+    for (auto& device : connectedDevices) {
+        uint16_t firstSequence;
+        uint16_t count;
+        while (device.connected && DeliveryTracker::takeRequest(device.id, firstSequence, count)) {
+            sendResendRequest(device, firstSequence, count);
+        }
+        logLostRecords(device.id);
+    }
+
+    // Flow window and tag levels for senders that follow them
+    for (auto& device : connectedDevices) {
+        if (!device.connected || device.wireVersion < BTLOGGER_WIRE_FLOW_VERSION) {
+            continue;
+        }
+        FlowWindow window;
+        if (SenderControl::takeFlow(device.id, window)) {
+            sendFlow(device, window);
+        }
+        char tag[sizeof(LogPacket::tag)];
+        uint8_t level;
+        while (SenderControl::takeLevel(device.id, tag, level)) {
+            sendLevel(device, tag, level);
+        }
+    }
+
+    // Restart scanning while there are free connection slots: short scans in quick
+    // succession while a known device is missing, a full scan every 30 seconds otherwise
+    if (!scanning && getConnectedDeviceCount() < BT_MAX_CONNECTIONS) {
+        unsigned long sinceLastScan = currentTime - lastScanTime;
+        if (lastScanTime == 0) {
+            Serial.printf("Scanning %lu ms after boot\n", currentTime);
+            startScanning(BT_SCAN_SECONDS);
+        } else if (sinceLastScan > BT_SCAN_INTERVAL_MS) {
+            startScanning(BT_SCAN_SECONDS);
+        } else if (sinceLastScan > BT_RECONNECT_SCAN_INTERVAL_MS && hasMissingKnownDevice()) {
+            startScanning(BT_RECONNECT_SCAN_SECONDS);
         }
     }
 
@@ -417,33 +1193,47 @@ void BluetoothManager::update() {
     }
 }
 
-size_t BluetoothManager::getConnectedDeviceCount() const {
-    size_t count = 0;
-    for (const auto& device : connectedDevices) {
-        if (device.connected) {
-            count++;
+bool BluetoothManager::hasMissingKnownDevice() {
+    KnownDevice known;
+    for (size_t i = 0; KnownDeviceCache::getEntry(i, known); i++) {
+        String address = known.address;
+        ConnectedDevice* device = findDevice(address);
+        if ((!device || !device->connected) && !findAttempt(address)) {
+            return true;
         }
     }
-    return count;
+    return false;
 }
 
 std::vector<String> BluetoothManager::getConnectedDeviceNames() const {
-    std::vector<String> names;
-    for (const auto& device : connectedDevices) {
-        if (device.connected) {
-            names.push_back(device.name);
+    // From the link states rather than connectedDevices, which only the communications task may walk
+    char snapshot[BT_MAX_CONNECTIONS][DEVICE_NAME_LENGTH];
+    size_t count = 0;
+
+    portENTER_CRITICAL(&linkMux);
+    for (int i = 0; i < BT_MAX_CONNECTIONS; i++) {
+        if (links[i].used) {
+            memcpy(snapshot[count++], links[i].name, DEVICE_NAME_LENGTH);
         }
     }
+    portEXIT_CRITICAL(&linkMux);
+
+    std::vector<String> names;
+    for (size_t i = 0; i < count; i++) {
+        names.push_back(snapshot[i]);
+    }
     return names;
 }
 
 std::vector<String> BluetoothManager::getAvailableDevices() const {
     std::vector<String> devices;
+    xSemaphoreTake(availableMutex, portMAX_DELAY);
     for (auto& device : const_cast<std::vector<BLEAdvertisedDevice>&>(availableDevices)) {
         String name = String(device.getName().c_str());
         String address = String(device.getAddress().toString().c_str());
         devices.push_back(name + " (" + address + ")");
     }
+    xSemaphoreGive(availableMutex);
     return devices;
 }
 
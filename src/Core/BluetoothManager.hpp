@@ -5,40 +5,107 @@
 #include <BLEClient.h>
 #include <BLEScan.h>
 #include <BLEAdvertisedDevice.h>
+#include <esp_gattc_api.h>
+#include <esp_gap_ble_api.h>
+#include <atomic>
 #include <functional>
 #include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "LogProtocol.hpp"
+#include "IngestRing.hpp"
+#include "DeviceRegistry.hpp"
+#include "KnownDeviceCache.hpp"
+#include "SenderControl.hpp"
 
 namespace BTLogger {
 namespace Core {
 
-// Log packet structure for communication
-struct LogPacket {
-    uint32_t timestamp;
-    uint8_t level;  // 0=DEBUG, 1=INFO, 2=WARN, 3=ERROR
-    uint16_t length;
-    char message[256];
-    char tag[32];
-
-    LogPacket() : timestamp(0), level(0), length(0) {
-        message[0] = '\0';
-        tag[0] = '\0';
-    }
+// Simultaneous client connections (bounded by the controller's BLE connection limit)
+#ifdef CONFIG_BTDM_CTRL_BLE_MAX_CONN
+#define BT_MAX_CONNECTIONS CONFIG_BTDM_CTRL_BLE_MAX_CONN
+#else
+#define BT_MAX_CONNECTIONS 3
+#endif
+
+// Scanning: full discovery scans, plus short frequent scans while a known device is missing
+#define BT_SCAN_SECONDS 5
+#define BT_SCAN_INTERVAL_MS 30000
+#define BT_RECONNECT_SCAN_SECONDS 1
+#define BT_RECONNECT_SCAN_INTERVAL_MS 1500
+
+// Connection manager configuration
+#define BT_CONNECT_QUEUE_LENGTH 8
+#define BT_CONNECT_TIMEOUT_MS 10000       // Abort a connect/discovery attempt after this long
+#define BT_CONNECT_BACKOFF_BASE_MS 250    // First retry delay, doubled per failure
+#define BT_CONNECT_BACKOFF_MAX_MS 30000
+#define BT_CONNECT_MAX_ATTEMPTS 6         // Give up until the device is seen by a new scan
+#define BT_CONNECT_TASK_STACK_SIZE 8192
+#define BT_CONNECT_TASK_PRIORITY 1
+#define BT_CACHED_SUBSCRIBE_TIMEOUT_MS 1000  // CCCD write response when using cached handles
+
+// Tag of the record logged where a sender's records went missing (see DeliveryTracker)
+#define BT_LOST_MARKER_TAG "BTLogger"
+
+// Link tuning requested from every connected sender (see LinkProfile)
+#define BT_DEFAULT_LINK_PROFILE LINK_PROFILE_HIGH_THROUGHPUT
+#define BT_LINK_MAX_DATA_LENGTH 251  // Data length extension: link layer payload bytes
+
+// Connection parameters requested after a link is up. Intervals are in 1.25 ms units,
+// supervision timeout in 10 ms units. 2M PHY is only requested on BLE 5 controllers.
+enum LinkProfile {
+    LINK_PROFILE_LOW_LATENCY,      // 7.5-15 ms interval, DLE, 2M PHY
+    LINK_PROFILE_HIGH_THROUGHPUT,  // 15-30 ms interval, DLE, 2M PHY (several packets per event)
+    LINK_PROFILE_LOW_POWER         // 100-200 ms interval, peripheral may skip 4 events, 1M PHY
+};
+
+// Negotiated values for one connection, as reported by the controller
+struct LinkParameters {
+    DeviceId deviceId;
+    uint16_t interval;      // 1.25 ms units, 0 until the first update completes
+    uint16_t latency;       // Connection events the peripheral may skip
+    uint16_t timeout;       // 10 ms units
+    uint16_t mtu;
+    uint16_t txDataLength;  // Link layer payload, 27 without DLE
+    uint8_t phy;            // 1 = 1M, 2 = 2M
+    uint32_t wireBytes;     // Notification bytes received on this connection
+    uint32_t expandedBytes; // The same after decompression
+    bool compressed;        // The sender has sent compressed frames
+
+    float getIntervalMs() const { return interval * 1.25f; }
+    float getCompressionRatio() const { return wireBytes > 0 ? (float)expandedBytes / wireBytes : 1.0f; }
+};
+
+// Per-device connection progress
+enum ConnectionState {
+    CONN_IDLE,
+    CONN_QUEUED,       // Waiting for the connect worker
+    CONN_CONNECTING,   // GAP connection in progress
+    CONN_DISCOVERING,  // Service/characteristic discovery and subscription
+    CONN_SUBSCRIBED,   // Receiving notifications
+    CONN_BACKOFF       // Failed, waiting before the next attempt
 };
 
 // Device connection info
 struct ConnectedDevice {
+    DeviceId id;  // Carried by every record from this device instead of name/address
     String name;
     String address;
     BLEClient* client;
+    BLERemoteCharacteristic* logCharacteristic;  // Null when subscribed through cached handles
+    uint16_t logHandle;
     bool connected;
     unsigned long lastSeen;
+    WireFormat wireFormat;  // Format of the last packet received from this device
+    uint8_t wireVersion;    // Compact frame version it sends, 0 for legacy
 
-    ConnectedDevice() : client(nullptr), connected(false), lastSeen(0) {}
+    ConnectedDevice() : id(DEVICE_ID_UNKNOWN), client(nullptr), logCharacteristic(nullptr), logHandle(0), connected(false), lastSeen(0), wireFormat(WireFormat::INVALID), wireVersion(0) {}
 };
 
 // Callback types
-using LogCallback = std::function<void(const LogPacket&, const String& deviceName)>;
-using ConnectionCallback = std::function<void(const String& deviceName, bool connected)>;
+using LogCallback = std::function<void(const LogPacket&, DeviceId deviceId)>;
+using ConnectionCallback = std::function<void(DeviceId deviceId, bool connected)>;
 
 class BluetoothManager {
    public:
@@ -47,29 +114,39 @@ class BluetoothManager {
 
     // Core functionality
     bool initialize();
-    void startScanning();
+    void startScanning(uint32_t durationSeconds = BT_SCAN_SECONDS);
     void stopScanning();
-    bool connectToDevice(const String& address);
-    void disconnectDevice(const String& address);
+    bool connectToDevice(const String& address);  // Queues a request, never blocks
+    void disconnectDevice(const String& address);  // Same; torn down once the link reports it is down
     void update();
 
+    // Decode notifications queued by the BLE callback; call from the communications task
+    size_t processPendingData(size_t maxNotifications = INGEST_RING_SLOTS);
+
     // Callbacks
     void setLogCallback(LogCallback callback) { logCallback = callback; }
     void setConnectionCallback(ConnectionCallback callback) { connectionCallback = callback; }
 
     // Status
     bool isScanning() const { return scanning; }
-    size_t getConnectedDeviceCount() const;
-    std::vector<String> getConnectedDeviceNames() const;
+    ConnectionState getConnectionState(const String& address) const;  // Communications task
+    size_t getConnectedDeviceCount() const { return connectedCount.load(std::memory_order_relaxed); }
+    std::vector<String> getConnectedDeviceNames() const;  // Snapshot, like getConnectedLinks()
     std::vector<String> getAvailableDevices() const;
+    const IngestRing& getIngestRing() const { return ingestRing; }
+    bool getLinkParameters(DeviceId id, LinkParameters& parameters) const;
+    std::vector<LinkParameters> getConnectedLinks() const;
 
     // Configuration
     void setTargetServiceUUID(const String& uuid) { targetServiceUUID = uuid; }
     void setLogCharacteristicUUID(const String& uuid) { logCharacteristicUUID = uuid; }
+    void setLinkProfile(LinkProfile profile);  // Re-applied to devices already connected
+    LinkProfile getLinkProfile() const { return linkProfile; }
+    static const char* getLinkProfileName(LinkProfile profile);
 
     // Public methods for callbacks (needed by BLE callback classes)
     void onDeviceFound(BLEAdvertisedDevice advertisedDevice);
-    void onDeviceDisconnected(const String& address);
+    void onDeviceDisconnected(const String& address);  // BLE stack task; only queues the disconnect
 
     // Static instance for callbacks
     static BluetoothManager* instance;
@@ -77,27 +154,115 @@ class BluetoothManager {
    private:
     // BLE objects
     BLEScan* scanner;
-    std::vector<ConnectedDevice> connectedDevices;
-    std::vector<BLEAdvertisedDevice> availableDevices;
+    std::vector<ConnectedDevice> connectedDevices;  // Communications task only; other tasks use the link snapshot
+    std::atomic<uint8_t> connectedCount;
+    std::vector<BLEAdvertisedDevice> availableDevices;  // Under availableMutex: the scan callback adds while others read
+    SemaphoreHandle_t availableMutex;
 
     // Configuration
     String targetServiceUUID;
     String logCharacteristicUUID;
-    bool scanning;
-    unsigned long lastScanTime;
+    std::atomic<bool> scanning;  // Claimed by startScanning() on whichever task calls it
+    unsigned long lastScanTime;  // 0 until the first scan, which update() starts
 
     // Callbacks
     LogCallback logCallback;
     ConnectionCallback connectionCallback;
 
+    // Raw notifications handed from the BLE callback to the communications task
+    IngestRing ingestRing;
+
+    // One in-flight or pending connection; owned by the communications task,
+    // the connect worker only touches the slot it was handed
+    struct ConnectionAttempt {
+        ConnectionState state;
+        String address;
+        BLEAdvertisedDevice advertised;
+        BLEClient* client;
+        BLERemoteCharacteristic* characteristic;
+        uint16_t logHandle;
+        DeviceId deviceId;
+        uint8_t failures;
+        bool abortRequested;
+        unsigned long stateSince;
+        unsigned long retryAt;
+        volatile ConnectionState workerState;  // Progress reported by the worker
+        volatile bool workerDone;
+        volatile bool workerSuccess;
+    };
+
+    struct ConnectRequest {
+        char address[DEVICE_ADDRESS_LENGTH];
+        bool disconnect;
+    };
+
+    ConnectionAttempt attempts[BT_MAX_CONNECTIONS];
+    QueueHandle_t connectRequestQueue;  // Addresses from the scan callback and UI
+    QueueHandle_t connectWorkQueue;     // Attempt slots handed to the worker
+    TaskHandle_t connectWorkerHandle;
+    bool workerBusy;
+
+    // Characteristic (or, for cached subscriptions, interface/connection/handle) -> device id,
+    // read by the notify callbacks without touching connectedDevices
+    BLERemoteCharacteristic* volatile notifySources[BT_MAX_CONNECTIONS];
+    volatile esp_gatt_if_t notifyGattcIfs[BT_MAX_CONNECTIONS];
+    volatile uint16_t notifyConnIds[BT_MAX_CONNECTIONS];
+    volatile uint16_t notifyHandles[BT_MAX_CONNECTIONS];  // Non-zero marks a cached subscription
+    volatile DeviceId notifyIds[BT_MAX_CONNECTIONS];
+
+    // Link tuning: one entry per live connection, written by the GAP callback and read by
+    // the communications and UI tasks under linkMux
+    struct LinkState {
+        bool used;
+        esp_bd_addr_t bda;
+        char name[DEVICE_NAME_LENGTH];
+        LinkParameters parameters;
+    };
+
+    LinkProfile linkProfile;
+    LinkState links[BT_MAX_CONNECTIONS];
+    volatile int pendingDataLengthLink;  // The length-complete event carries no address
+    mutable portMUX_TYPE linkMux;
+
+    // Pending CCCD write issued by the connect worker on the cached path
+    volatile uint16_t pendingSubscribeHandle;
+    volatile int pendingSubscribeStatus;
+
     // Internal methods
     void onDeviceConnected(const String& address);
-    void processIncomingData(const String& deviceAddress, uint8_t* data, size_t length);
+    void processConnectRequests();
+    void updateConnectionAttempts();
+    void finishAttempt(ConnectionAttempt& attempt);
+    void failAttempt(ConnectionAttempt& attempt, const char* reason);
+    void openLink(ConnectionAttempt& attempt);
+    ConnectionAttempt* findAttempt(const String& address);
+    bool findAdvertisedDevice(const String& address, BLEAdvertisedDevice& device);  // Copied out under the lock
+    void processIncomingData(DeviceId source, const uint8_t* data, size_t length, int64_t arrivalUs);
+    bool attachNotifySource(BLERemoteCharacteristic* characteristic, DeviceId id);
+    bool attachRawNotifySource(esp_gatt_if_t gattcIf, uint16_t connId, uint16_t handle, DeviceId id);
+    bool subscribeCached(ConnectionAttempt& attempt, const KnownDevice& cached);
+    void rememberDevice(ConnectionAttempt& attempt, BLERemoteCharacteristic* characteristic);
+    bool hasMissingKnownDevice();
+    void detachNotifySource(DeviceId id);
+    void closeDevice(const String& address);
+    void sendHello(BLERemoteCharacteristic* characteristic);
+    void sendSyncRequest(ConnectedDevice& device, uint8_t sequence);
+    void sendResendRequest(ConnectedDevice& device, uint16_t firstSequence, uint16_t count);
+    void sendFlow(ConnectedDevice& device, const FlowWindow& window);
+    void sendLevel(ConnectedDevice& device, const char* tag, uint8_t level);
+    void writeControl(ConnectedDevice& device, uint8_t* request, size_t requestLength);
+    void logLostRecords(DeviceId id);
     ConnectedDevice* findDevice(const String& address);
+    void openLinkState(DeviceId id, BLEClient* client);
+    void closeLinkState(DeviceId id);
+    void applyLinkProfile(int link);
 
     // Static callback wrappers
     static void scanCompleteCallback(BLEScanResults results);
     static void notifyCallback(BLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify);
+    static void connectWorkerTask(void* parameter);
+    static void gattcEventHandler(esp_gattc_cb_event_t event, esp_gatt_if_t gattcIf, esp_ble_gattc_cb_param_t* param);
+    static void gapEventHandler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param);
 };
 
 }  // namespace Core
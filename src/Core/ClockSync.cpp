@@ -0,0 +1,252 @@
+#include "ClockSync.hpp"
+#include <esp_timer.h>
+#include <sys/time.h>
+#include <time.h>
+
+namespace BTLogger {
+namespace Core {
+
+ClockSync::Link ClockSync::links[DEVICE_REGISTRY_SLOTS];
+volatile int64_t ClockSync::wallOffsetUs = 0;
+portMUX_TYPE ClockSync::lock = portMUX_INITIALIZER_UNLOCKED;
+
+int64_t ClockSync::now() {
+    return esp_timer_get_time();
+}
+
+void ClockSync::begin(DeviceId device) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return;
+    }
+
+    // Records may already have been mapped from arrival times; keep that estimate
+    portENTER_CRITICAL(&lock);
+    Link& link = links[device];
+    link.active = true;
+    link.sent = 0;
+    link.haveSample = false;
+    link.nextRequestUs = now();
+    portEXIT_CRITICAL(&lock);
+}
+
+void ClockSync::end(DeviceId device) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return;
+    }
+
+    // A new connection may be a rebooted sender with a new clock
+    portENTER_CRITICAL(&lock);
+    memset(&links[device], 0, sizeof(Link));
+    portEXIT_CRITICAL(&lock);
+}
+
+bool ClockSync::takeRequest(DeviceId device, uint8_t& sequence) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return false;
+    }
+
+    int64_t nowUs = now();
+    int64_t wallUs = 0;
+    bool taken = false;
+
+    portENTER_CRITICAL(&lock);
+    Link& link = links[device];
+    if (link.active && nowUs >= link.nextRequestUs) {
+        if (link.sent < CLOCK_SYNC_BURST) {
+            sequence = link.nextSequence++;
+            link.sentSequence[link.sent] = sequence;
+            link.sentAt[link.sent] = nowUs;
+            link.sent++;
+            link.nextRequestUs = nowUs + (link.sent < CLOCK_SYNC_BURST ? CLOCK_SYNC_SPACING_MS : CLOCK_SYNC_REPLY_TIMEOUT_MS) * 1000LL;
+            taken = true;
+        } else {
+            if (finishBurst(link, nowUs)) {
+                wallUs = toWallUs(nowUs);
+            }
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    // Card file dates and time() follow the sender's clock from here on
+    if (wallUs > 0) {
+        struct timeval tv;
+        tv.tv_sec = wallUs / 1000000;
+        tv.tv_usec = wallUs % 1000000;
+        settimeofday(&tv, nullptr);
+    }
+    return taken;
+}
+
+void ClockSync::onReply(DeviceId device, uint8_t sequence, uint64_t senderUs, uint64_t unixMs, int64_t arrivalUs) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return;
+    }
+
+    portENTER_CRITICAL(&lock);
+    Link& link = links[device];
+    for (uint8_t i = 0; link.active && i < link.sent; i++) {
+        if (link.sentSequence[i] != sequence) {
+            continue;
+        }
+
+        // The sender read its clock about halfway through the round trip
+        int64_t rtt = arrivalUs - link.sentAt[i];
+        if (rtt >= 0 && rtt <= CLOCK_SYNC_MAX_RTT_US && (!link.haveSample || rtt < link.sampleRttUs)) {
+            link.haveSample = true;
+            link.sampleLocalUs = link.sentAt[i] + rtt / 2;
+            link.sampleOffsetUs = link.sampleLocalUs - (int64_t)senderUs;
+            link.sampleRttUs = rtt;
+            link.sampleUnixMs = unixMs;
+        }
+        link.sentSequence[i] = (uint8_t)(sequence + 0x80);  // Answered; a duplicate can't count twice
+        break;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+bool ClockSync::finishBurst(Link& link, int64_t nowUs) {
+    link.sent = 0;
+    link.nextRequestUs = nowUs + CLOCK_SYNC_INTERVAL_MS * 1000LL;
+    if (!link.haveSample) {
+        return false;  // No replies: a sender without sync support, or a bad patch of radio
+    }
+    link.haveSample = false;
+
+    // The offset change since the last burst is the drift; smoothed, since each sample has jitter
+    int64_t span = link.sampleLocalUs - link.anchorUs;
+    if (link.source == CLOCK_SOURCE_SYNC && span >= CLOCK_SYNC_MIN_SKEW_SPAN_MS * 1000LL) {
+        int64_t measured = (link.sampleOffsetUs - link.offsetUs) * 1000000000LL / span;
+        int64_t skew = link.exchanges > 1 ? (link.skewPpb * 3LL + measured) / 4 : measured;
+        link.skewPpb = constrain(skew, (int64_t)-CLOCK_SYNC_MAX_SKEW_PPB, (int64_t)CLOCK_SYNC_MAX_SKEW_PPB);
+    }
+
+    link.source = CLOCK_SOURCE_SYNC;
+    link.offsetUs = link.sampleOffsetUs;
+    link.anchorUs = link.sampleLocalUs;
+    link.rttUs = link.sampleRttUs;
+    link.exchanges++;
+
+    // The sender's date at the moment it answered
+    if (link.sampleUnixMs < CLOCK_SYNC_MIN_WALL_MS) {
+        return false;
+    }
+    wallOffsetUs = (int64_t)link.sampleUnixMs * 1000 - link.sampleLocalUs;
+    return true;
+}
+
+int64_t ClockSync::offsetAt(const Link& link, int64_t localUs) {
+    if (link.source == CLOCK_SOURCE_SYNC) {
+        return link.offsetUs + (int64_t)link.skewPpb * (localUs - link.anchorUs) / 1000000000LL;
+    }
+    return arrivalOffset(link, localUs);
+}
+
+int64_t ClockSync::arrivalOffset(const Link& link, int64_t localUs) {
+    // Allowed to creep later in case the sender's clock runs slow
+    return link.arrivalOffsetUs + (localUs - link.arrivalSinceUs) * CLOCK_SYNC_ARRIVAL_DRIFT_PPB / 1000000000LL;
+}
+
+ClockSource ClockSync::map(DeviceId device, LogPacket& packet, int64_t arrivalUs) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return CLOCK_SOURCE_NONE;
+    }
+
+    // Sender timestamps are whole milliseconds; take the middle of the one it names
+    int64_t senderUs = (int64_t)packet.timestamp * 1000 + 500;
+    bool replayed = packet.flags & WIRE_RECORD_FLAG_REPLAYED;
+
+    portENTER_CRITICAL(&lock);
+    Link& link = links[device];
+
+    // Smallest arrival delay so far; backlog records sat in the sender and say nothing about it
+    if (!replayed && link.source != CLOCK_SOURCE_SYNC) {
+        int64_t candidate = arrivalUs - senderUs;
+        if (!link.haveArrival || candidate <= arrivalOffset(link, arrivalUs)) {
+            link.arrivalOffsetUs = candidate;
+            link.arrivalSinceUs = arrivalUs;
+            link.haveArrival = true;
+        }
+        link.source = CLOCK_SOURCE_ARRIVAL;
+    }
+
+    int64_t local = link.source == CLOCK_SOURCE_NONE ? arrivalUs : senderUs + offsetAt(link, arrivalUs);
+    if (local > arrivalUs) {
+        local = arrivalUs;  // Can't have been written after it arrived
+    }
+    if (!replayed) {
+        if (local < link.lastMappedUs) {
+            local = link.lastMappedUs;
+        }
+        link.lastMappedUs = local;
+    }
+    ClockSource source = link.source;
+    portEXIT_CRITICAL(&lock);
+
+    if (local < 0) {
+        local = 0;  // Written before this BTLogger booted
+    }
+    packet.timestamp = local / 1000;
+    packet.micros = local % 1000;
+    return source;
+}
+
+bool ClockSync::getStatus(DeviceId device, ClockSyncStatus& status) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return false;
+    }
+
+    int64_t nowUs = now();
+    portENTER_CRITICAL(&lock);
+    const Link& link = links[device];
+    status.source = link.source;
+    status.offsetUs = link.source == CLOCK_SOURCE_NONE ? 0 : offsetAt(link, nowUs);
+    status.skewPpb = link.skewPpb;
+    status.rttUs = link.rttUs;
+    status.exchanges = link.exchanges;
+    portEXIT_CRITICAL(&lock);
+    return status.source != CLOCK_SOURCE_NONE;
+}
+
+const char* ClockSync::getSourceName(ClockSource source) {
+    switch (source) {
+        case CLOCK_SOURCE_ARRIVAL:
+            return "Arrival";
+        case CLOCK_SOURCE_SYNC:
+            return "Synced";
+        default:
+            return "None";
+    }
+}
+
+size_t ClockSync::formatTime(int64_t localUs, char* out, size_t capacity, bool micros) {
+    if (!hasWallClock()) {
+        return formatLocalTime(localUs, out, capacity, micros);
+    }
+
+    int64_t wallUs = toWallUs(localUs);
+    time_t seconds = wallUs / 1000000;
+    uint32_t fraction = wallUs % 1000000;
+    struct tm parts;
+    gmtime_r(&seconds, &parts);
+    int length = micros ? snprintf(out, capacity, "%04d-%02d-%02d %02d:%02d:%02d.%06lu", parts.tm_year + 1900,
+                                   parts.tm_mon + 1, parts.tm_mday, parts.tm_hour, parts.tm_min, parts.tm_sec,
+                                   (unsigned long)fraction)
+                        : snprintf(out, capacity, "%04d-%02d-%02d %02d:%02d:%02d.%03lu", parts.tm_year + 1900,
+                                   parts.tm_mon + 1, parts.tm_mday, parts.tm_hour, parts.tm_min, parts.tm_sec,
+                                   (unsigned long)(fraction / 1000));
+    return length <= 0 ? 0 : min((size_t)length, capacity - 1);
+}
+
+size_t ClockSync::formatLocalTime(int64_t localUs, char* out, size_t capacity, bool micros) {
+    if (localUs < 0) {
+        localUs = 0;
+    }
+    unsigned long seconds = localUs / 1000000;
+    unsigned long fraction = localUs % 1000000;
+    int length = micros ? snprintf(out, capacity, "%lu.%06lu", seconds, fraction)
+                        : snprintf(out, capacity, "%lu.%03lu", seconds, fraction / 1000);
+    return length <= 0 ? 0 : min((size_t)length, capacity - 1);
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "DeviceRegistry.hpp"
+#include "LogProtocol.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Clock sync exchange timing
+#define CLOCK_SYNC_BURST 8              // Requests per exchange; the fastest reply wins
+#define CLOCK_SYNC_SPACING_MS 40        // Between the requests of a burst
+#define CLOCK_SYNC_REPLY_TIMEOUT_MS 500 // A burst ends this long after its last request
+#define CLOCK_SYNC_INTERVAL_MS 30000    // Drift correction
+#define CLOCK_SYNC_MAX_RTT_US 250000    // Slower round trips say too little to use
+#define CLOCK_SYNC_MIN_SKEW_SPAN_MS 10000  // Exchanges closer than this don't update the skew
+#define CLOCK_SYNC_MAX_SKEW_PPB 500000  // 500 ppm, well past any crystal
+#define CLOCK_SYNC_ARRIVAL_DRIFT_PPB 100000  // How fast the arrival estimate may creep later
+
+// Sender wall clocks before 2020-01-01 are taken as never set
+#define CLOCK_SYNC_MIN_WALL_MS 1577836800000ULL
+
+enum ClockSource : uint8_t {
+    CLOCK_SOURCE_NONE,     // Nothing received yet
+    CLOCK_SOURCE_ARRIVAL,  // Estimated from record arrival times (sender without sync support)
+    CLOCK_SOURCE_SYNC      // Measured with sync exchanges
+};
+
+// Per-connection estimate, as shown on the status screens
+struct ClockSyncStatus {
+    ClockSource source;
+    int64_t offsetUs;   // Local time minus sender time
+    int32_t skewPpb;    // Sender clock rate error, parts per billion
+    uint32_t rttUs;     // Round trip of the sample in use
+    uint32_t exchanges; // Sync bursts completed
+};
+
+/**
+ * ClockSync maps the timestamps of every connected device into one time
+ * base: this BTLogger's esp_timer microseconds since boot. Each connection
+ * starts with a burst of sync requests and repeats one every 30 seconds; the
+ * reply with the shortest round trip gives the offset (its midpoint is where
+ * the sender read its clock), and successive bursts give the rate at which
+ * the two crystals drift apart, so the mapping stays right between bursts.
+ * Senders that don't answer are estimated from arrival times instead: a
+ * record can't arrive before it was written, so the smallest arrival delay
+ * seen is the best offset available.
+ *
+ * Mapped times never run backwards for a device (replayed backlog excepted),
+ * and never lie after the moment the record arrived. A sender that knows the
+ * date hands it over in its replies; from then on local times can be shown
+ * as wall-clock time and the system clock is set for file dates.
+ *
+ * Request and reply handling run on the communications task; status and
+ * formatting are safe from any task.
+ */
+class ClockSync {
+   public:
+    // Local time base, microseconds since boot
+    static int64_t now();
+
+    static void begin(DeviceId device);  // Connection up: start the first burst
+    static void end(DeviceId device);
+
+    // Next request to send to device, if one is due; fills sequence
+    static bool takeRequest(DeviceId device, uint8_t& sequence);
+    static void onReply(DeviceId device, uint8_t sequence, uint64_t senderUs, uint64_t unixMs, int64_t arrivalUs);
+
+    // Rewrite a record's sender timestamp into the local time base (timestamp in ms plus micros);
+    // returns the estimate that was used
+    static ClockSource map(DeviceId device, LogPacket& packet, int64_t arrivalUs);
+
+    static bool getStatus(DeviceId device, ClockSyncStatus& status);
+    static const char* getSourceName(ClockSource source);
+
+    // Wall clock, from the first sender that knew it
+    static bool hasWallClock() { return wallOffsetUs != 0; }
+    static int64_t toWallUs(int64_t localUs) { return localUs + wallOffsetUs; }
+
+    // "2026-10-14 12:34:56.789" once the wall clock is known, seconds since boot ("1234.567") before
+    static size_t formatTime(int64_t localUs, char* out, size_t capacity, bool micros = false);
+    // Always seconds since boot, for times recorded before this boot
+    static size_t formatLocalTime(int64_t localUs, char* out, size_t capacity, bool micros = false);
+
+   private:
+    struct Link {
+        bool active;
+        ClockSource source;
+        int64_t offsetUs;    // At anchorUs
+        int64_t anchorUs;
+        int32_t skewPpb;
+        uint32_t rttUs;
+        uint32_t exchanges;
+        int64_t lastMappedUs;
+
+        // Burst in progress
+        uint8_t nextSequence;
+        uint8_t sent;
+        int64_t sentAt[CLOCK_SYNC_BURST];
+        uint8_t sentSequence[CLOCK_SYNC_BURST];
+        int64_t nextRequestUs;
+        bool haveSample;
+        int64_t sampleOffsetUs;
+        int64_t sampleLocalUs;
+        uint32_t sampleRttUs;
+        uint64_t sampleUnixMs;
+
+        // Arrival estimate
+        int64_t arrivalOffsetUs;
+        int64_t arrivalSinceUs;
+        bool haveArrival;
+    };
+
+    static Link links[DEVICE_REGISTRY_SLOTS];
+    static volatile int64_t wallOffsetUs;
+    static portMUX_TYPE lock;
+
+    static bool finishBurst(Link& link, int64_t nowUs);  // True if it brought a new wall clock
+    static int64_t offsetAt(const Link& link, int64_t localUs);
+    static int64_t arrivalOffset(const Link& link, int64_t localUs);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -1,23 +1,36 @@
 #include "CoreTaskManager.hpp"
 #include "BluetoothManager.hpp"
 #include "SDCardManager.hpp"
+#include "Metrics.hpp"
+#include "BenchmarkMonitor.hpp"
+#include "SenderControl.hpp"
+#include "NetworkRelay.hpp"
+#include "SerialMirror.hpp"
 #include "../UI/TouchManager.hpp"
 #include "../UI/ToastManager.hpp"
+#include "../UI/NotificationAggregator.hpp"
+#include "../UI/FrameScheduler.hpp"
 #include "../UI/ScreenManager.hpp"
+#include "../UI/RenderTarget.hpp"
 #include "../UI/UIScale.hpp"
+#include <esp_timer.h>
 
 namespace BTLogger {
 namespace Core {
 
 CoreTaskManager::CoreTaskManager()
-    : bluetoothManager(nullptr), sdCardManager(nullptr), communicationsTaskHandle(nullptr), uiTaskHandle(nullptr), managerMutex(nullptr), uiMessageQueue(nullptr), communicationsMessageQueue(nullptr), running(false), communicationsTaskRunning(false), uiTaskRunning(false) {
+    : bluetoothManager(nullptr), sdCardManager(nullptr), communicationsTaskHandle(nullptr), uiTaskHandle(nullptr), storageTaskHandle(nullptr), managerMutex(nullptr), uiMessageQueue(nullptr), communicationsMessageQueue(nullptr), storageMessageQueue(nullptr), uiQueueFullCount(0), communicationsQueueFullCount(0), search(nullptr), searchGeneration(0), exportJob(nullptr), lineCountJob(nullptr), running(false), communicationsTaskRunning(false), uiTaskRunning(false), storageTaskRunning(false) {
 }
 
 CoreTaskManager::~CoreTaskManager() {
     stop();
+    delete search;
+    delete exportJob;
+    delete lineCountJob;
+    search = nullptr;
 }
 
-bool CoreTaskManager::initialize() {
+bool CoreTaskManager::initialize(size_t queueDepth) {
     Serial.println("Initializing CoreTaskManager...");
 
     // Create synchronization objects
@@ -27,22 +40,25 @@ bool CoreTaskManager::initialize() {
         return false;
     }
 
+    // Payload pool for message text (sized so every queued message can carry one)
+    if (!messagePool.initialize(max((size_t)MESSAGE_POOL_BLOCKS, queueDepth * 2 + 4))) {
+        return false;
+    }
+
     // Create message queues
-    uiMessageQueue = xQueueCreate(10, sizeof(CoreMessage));
-    communicationsMessageQueue = xQueueCreate(10, sizeof(CoreMessage));
+    uiMessageQueue = xQueueCreate(queueDepth, sizeof(CoreMessage));
+    communicationsMessageQueue = xQueueCreate(queueDepth, sizeof(CoreMessage));
+    storageMessageQueue = xQueueCreate(STORAGE_QUEUE_LENGTH, sizeof(StorageMessage));
 
-    if (!uiMessageQueue || !communicationsMessageQueue) {
+    if (!uiMessageQueue || !communicationsMessageQueue || !storageMessageQueue) {
         Serial.println("Failed to create message queues");
         return false;
     }
 
-    // Initialize managers (on main core for now)
+    // Bluetooth first; the card is mounted by the storage task once it runs, so scanning never waits for it
     xSemaphoreTake(managerMutex, portMAX_DELAY);
 
     sdCardManager = new SDCardManager();
-    if (!sdCardManager->initialize()) {
-        Serial.println("WARNING: SD Card initialization failed - logging disabled");
-    }
 
     bluetoothManager = new BluetoothManager();
     if (!bluetoothManager->initialize()) {
@@ -75,7 +91,27 @@ void CoreTaskManager::start() {
         0  // Core 0
     );
 
-    // Create UI task on Core 1
+    // Create storage task on Core 0 (below communications so SD stalls never delay BLE)
+    xTaskCreatePinnedToCore(
+        storageTask,
+        "StorageTask",
+        STORAGE_TASK_STACK_SIZE,
+        this,
+        STORAGE_TASK_PRIORITY,
+        &storageTaskHandle,
+        0  // Core 0
+    );
+
+    running = true;
+    Serial.println("CoreTaskManager tasks started");
+}
+
+void CoreTaskManager::startUI() {
+    if (!running || uiTaskHandle) {
+        return;
+    }
+
+    // Create UI task on Core 1 (messages posted before it runs wait in its queue)
     xTaskCreatePinnedToCore(
         uiTask,
         "UITask",
@@ -85,9 +121,6 @@ void CoreTaskManager::start() {
         &uiTaskHandle,
         1  // Core 1
     );
-
-    running = true;
-    Serial.println("CoreTaskManager tasks started");
 }
 
 void CoreTaskManager::stop() {
@@ -103,10 +136,11 @@ void CoreTaskManager::stop() {
     CoreMessage shutdownMsg(MSG_SHUTDOWN);
     sendToUI(shutdownMsg);
     sendToCommunications(shutdownMsg);
+    sendToStorage(StorageMessage(STORAGE_SHUTDOWN), pdMS_TO_TICKS(STORAGE_CONTROL_TIMEOUT_MS));
 
     // Wait for tasks to finish
     unsigned long timeout = millis() + 5000;  // 5 second timeout
-    while ((communicationsTaskRunning || uiTaskRunning) && millis() < timeout) {
+    while ((communicationsTaskRunning || uiTaskRunning || storageTaskRunning) && millis() < timeout) {
         delay(100);
     }
 
@@ -130,6 +164,10 @@ void CoreTaskManager::stop() {
         vQueueDelete(communicationsMessageQueue);
         communicationsMessageQueue = nullptr;
     }
+    if (storageMessageQueue) {
+        vQueueDelete(storageMessageQueue);
+        storageMessageQueue = nullptr;
+    }
     if (managerMutex) {
         vSemaphoreDelete(managerMutex);
         managerMutex = nullptr;
@@ -138,14 +176,100 @@ void CoreTaskManager::stop() {
     Serial.println("CoreTaskManager stopped");
 }
 
-bool CoreTaskManager::sendToUI(const CoreMessage& message) {
-    if (!uiMessageQueue) return false;
-    return xQueueSend(uiMessageQueue, &message, pdMS_TO_TICKS(100)) == pdTRUE;
+bool CoreTaskManager::sendToUI(const CoreMessage& message, TickType_t timeout) {
+    bool sent = sendMessage(uiMessageQueue, message, timeout, uiQueueFullCount);
+    if (sent) {
+        UI::FrameScheduler::requestFrame();
+    } else {
+        Metrics::count(METRIC_UI_DROPPED);
+    }
+    return sent;
+}
+
+bool CoreTaskManager::sendToCommunications(const CoreMessage& message, TickType_t timeout) {
+    return sendMessage(communicationsMessageQueue, message, timeout, communicationsQueueFullCount);
+}
+
+bool CoreTaskManager::postToUI(MessageType type, const char* text1, const char* text2, uint32_t value1, uint32_t value2, TickType_t timeout) {
+    CoreMessage message(type, value1, value2);
+    message.payload = messagePool.acquireText(text1, text2);
+    if (message.payload == MESSAGE_NO_PAYLOAD) {
+        return false;
+    }
+    return sendToUI(message, timeout);
+}
+
+bool CoreTaskManager::postToCommunications(MessageType type, const char* text1, const char* text2, uint32_t value1, uint32_t value2, TickType_t timeout) {
+    CoreMessage message(type, value1, value2);
+    message.payload = messagePool.acquireText(text1, text2);
+    if (message.payload == MESSAGE_NO_PAYLOAD) {
+        return false;
+    }
+    return sendToCommunications(message, timeout);
 }
 
-bool CoreTaskManager::sendToCommunications(const CoreMessage& message) {
-    if (!communicationsMessageQueue) return false;
-    return xQueueSend(communicationsMessageQueue, &message, pdMS_TO_TICKS(100)) == pdTRUE;
+uint8_t CoreTaskManager::getQueueLoad(QueueHandle_t queue) {
+    if (!queue) {
+        return 0;
+    }
+    UBaseType_t waiting = uxQueueMessagesWaiting(queue);
+    UBaseType_t total = waiting + uxQueueSpacesAvailable(queue);
+    return total > 0 ? waiting * 100 / total : 0;
+}
+
+bool CoreTaskManager::sendMessage(QueueHandle_t queue, const CoreMessage& message, TickType_t timeout, uint32_t& fullCount) {
+    bool sent = false;
+    if (queue) {
+        if (uxQueueSpacesAvailable(queue) == 0) {
+            fullCount++;
+        }
+        sent = xQueueSend(queue, &message, timeout) == pdTRUE;
+    }
+
+    // The receiver never saw it, so the payload is still ours to free
+    if (!sent) {
+        messagePool.release(message.payload);
+    }
+    return sent;
+}
+
+bool CoreTaskManager::sendToStorage(const StorageMessage& message, TickType_t timeout) {
+    if (!storageMessageQueue) return false;
+
+    // Fast path: queue has room
+    bool sent = xQueueSend(storageMessageQueue, &message, 0) == pdTRUE;
+    if (!sent && timeout > 0) {
+        // Queue full - the storage task is stalled, account for the time we wait
+        int64_t waitStart = esp_timer_get_time();
+        sent = xQueueSend(storageMessageQueue, &message, timeout) == pdTRUE;
+        uint32_t waitedUs = (uint32_t)(esp_timer_get_time() - waitStart);
+
+        storageStats.blockedTimeMs += waitedUs / 1000;
+        if (waitedUs > storageStats.maxBlockedUs) {
+            storageStats.maxBlockedUs = waitedUs;
+        }
+    }
+
+    if (!sent) {
+        storageStats.dropped++;
+        return false;
+    }
+
+    storageStats.queued++;
+    uint32_t waiting = uxQueueMessagesWaiting(storageMessageQueue);
+    if (waiting > storageStats.highWaterMark) {
+        storageStats.highWaterMark = waiting;
+    }
+    Metrics::level(METRIC_LEVEL_STORAGE_QUEUE, waiting);
+    return true;
+}
+
+bool CoreTaskManager::submitLog(const LogPacket& packet, DeviceId deviceId) {
+    StorageMessage message(STORAGE_LOG, deviceId);
+    message.packet = packet;
+    bool sent = sendToStorage(message);
+    Metrics::count(sent ? METRIC_STORAGE_QUEUED : METRIC_STORAGE_DROPPED);
+    return sent;
 }
 
 void CoreTaskManager::communicationsTask(void* parameter) {
@@ -158,12 +282,18 @@ void CoreTaskManager::uiTask(void* parameter) {
     manager->runUILoop();
 }
 
+void CoreTaskManager::storageTask(void* parameter) {
+    CoreTaskManager* manager = static_cast<CoreTaskManager*>(parameter);
+    manager->runStorageLoop();
+}
+
 void CoreTaskManager::runCommunicationsLoop() {
     Serial.println("Communications task started on Core 0");
     communicationsTaskRunning = true;
 
     CoreMessage message;
     const TickType_t messageTimeout = pdMS_TO_TICKS(10);  // 10ms timeout
+    unsigned long lastFlowUpdate = 0;
 
     while (running) {
         // Process incoming messages
@@ -173,11 +303,24 @@ void CoreTaskManager::runCommunicationsLoop() {
                 break;
             }
             handleCommunicationsMessage(message);
+            messagePool.release(message.payload);
         }
 
         // Update managers (thread-safe)
         xSemaphoreTake(managerMutex, portMAX_DELAY);
         if (bluetoothManager) {
+            // Drain notifications queued by the BLE callback and fan them out to the sinks
+            bluetoothManager->processPendingData();
+
+            // Senders are asked to slow down before any of the queues they feed overflows
+            if (millis() - lastFlowUpdate >= FLOW_UPDATE_INTERVAL_MS) {
+                lastFlowUpdate = millis();
+                const IngestRing& ring = bluetoothManager->getIngestRing();
+                uint8_t load = ring.capacity() > 0 ? ring.size() * 100 / ring.capacity() : 0;
+                load = max(load, getQueueLoad(storageMessageQueue));
+                load = max(load, getQueueLoad(uiMessageQueue));
+                SenderControl::updateLoad(load);
+            }
             bluetoothManager->update();
         }
         xSemaphoreGive(managerMutex);
@@ -196,20 +339,31 @@ void CoreTaskManager::runUILoop() {
     uiTaskRunning = true;
 
     CoreMessage message;
-    const TickType_t messageTimeout = pdMS_TO_TICKS(10);  // 10ms timeout
+    bool shutdown = false;
+    UI::FrameScheduler::attach(xTaskGetCurrentTaskHandle());
+
+    while (running && !shutdown) {
+        // Sleep until a message, touch, new log data or a requested deadline
+        UI::FrameScheduler::waitForFrame();
+        int64_t frameStart = esp_timer_get_time();
 
-    while (running) {
         // Process incoming messages
-        if (xQueueReceive(uiMessageQueue, &message, messageTimeout) == pdTRUE) {
+        while (xQueueReceive(uiMessageQueue, &message, 0) == pdTRUE) {
             if (message.type == MSG_SHUTDOWN) {
                 Serial.println("UI task received shutdown message");
+                shutdown = true;
                 break;
             }
             handleUIMessage(message);
+            messagePool.release(message.payload);
+        }
+        if (shutdown) {
+            break;
         }
 
         // Update UI systems
         UI::TouchManager::update();
+        UI::NotificationAggregator::update();
         UI::ToastManager::update();
         UI::ScreenManager::update();
 
@@ -217,27 +371,93 @@ void CoreTaskManager::runUILoop() {
         UI::TouchManager::TouchPoint touch = UI::TouchManager::getTouch();
         UI::ScreenManager::handleTouch(touch.calx, touch.caly, touch.pressed);
 
-        // Small delay to prevent watchdog issues
-        vTaskDelay(pdMS_TO_TICKS(20));  // 50Hz UI update rate
+        // Follow a finger until it lifts
+        if (touch.pressed || UI::TouchManager::wasTapped()) {
+            UI::FrameScheduler::requestFrameIn(UI_TOUCH_POLL_MS);
+        }
+
+        // Let this frame's transfers complete before sleeping
+        UI::RenderTarget::finish();
+        Metrics::count(METRIC_UI_FRAMES);
+        Metrics::record(METRIC_HIST_UI_FRAME, esp_timer_get_time() - frameStart);
     }
+    UI::FrameScheduler::attach(nullptr);
 
     uiTaskRunning = false;
     Serial.println("UI task ended");
     vTaskDelete(nullptr);
 }
 
+void CoreTaskManager::runStorageLoop() {
+    Serial.println("Storage task started on Core 0");
+    storageTaskRunning = true;
+
+    // Mount and staged record replay run here, alongside BLE; records wait in the queue meanwhile and the
+    // slower directory and FAT walks follow from update() once sessions are open
+    unsigned long mountStart = millis();
+    if (sdCardManager->initialize()) {
+        Serial.printf("SD card ready %lu ms after boot (mount took %lu ms)\n", millis(), millis() - mountStart);
+    } else {
+        Serial.println("WARNING: SD Card initialization failed - logging disabled");
+    }
+
+    StorageMessage message;
+    const TickType_t messageTimeout = pdMS_TO_TICKS(100);  // Wake up for time-based commits
+    bool shutdown = false;
+
+    while (running && !shutdown) {
+        // While a search, export, line count or the reconcile runs, drain the queue between slices but still
+        // block a tick so IDLE0 gets to run
+        bool searching = (search && search->isRunning()) || isExporting() || isCountingLines() ||
+                         sdCardManager->hasBackgroundWork();
+        TickType_t timeout = searching ? 1 : messageTimeout;
+        while (xQueueReceive(storageMessageQueue, &message, timeout) == pdTRUE) {
+            if (message.type == STORAGE_SHUTDOWN) {
+                Serial.println("Storage task received shutdown message");
+                shutdown = true;
+                break;
+            }
+            handleStorageMessage(message);
+            if (!searching) {
+                break;
+            }
+            timeout = 0;
+        }
+
+        // Time-based commit of buffered log data
+        if (sdCardManager && !shutdown) {
+            sdCardManager->update();
+        }
+        if (search && search->isRunning() && !shutdown) {
+            stepSearchJob();
+        }
+        if (isExporting() && !shutdown) {
+            stepExportJob();
+        }
+        if (isCountingLines() && !shutdown) {
+            stepLineCount();
+        }
+        Metrics::update();
+        BenchmarkMonitor::update();
+    }
+
+    // Make sure everything buffered reaches the card
+    if (sdCardManager) {
+        sdCardManager->endAllSessions();
+    }
+
+    storageTaskRunning = false;
+    Serial.println("Storage task ended");
+    vTaskDelete(nullptr);
+}
+
 void CoreTaskManager::handleUIMessage(const CoreMessage& message) {
     switch (message.type) {
         case MSG_LOG_RECEIVED:
-            // Show toast for important logs
-            if (message.value1 >= 2) {  // WARN and ERROR levels
-                String levelStr = (message.value1 == 2) ? "WARN" : "ERROR";
-                String toastMsg = message.data1 + " " + levelStr + ": " + message.data2;
-                if (message.value1 == 3) {
-                    UI::ToastManager::showError(toastMsg);
-                } else {
-                    UI::ToastManager::showWarning(toastMsg);
-                }
+            // WARN and ERROR records become (rate-limited, coalesced) toasts
+            if (message.value1 >= 3) {
+                UI::NotificationAggregator::report(message.value1, message.value2 & 0xFF, message.value2 >> 8,
+                                                   messageText1(message));
             }
             break;
 
@@ -246,6 +466,25 @@ void CoreTaskManager::handleUIMessage(const CoreMessage& message) {
             // No need for toasts here anymore
             break;
 
+        case MSG_SEARCH_HIT:
+            // Hits of a search that has since been replaced or cancelled are dropped
+            if (message.value2 == searchGeneration && searchHitCallback) {
+                searchHitCallback(messageText2(message), message.value1, messageText1(message));
+            }
+            break;
+
+        case MSG_SEARCH_DONE:
+            if (message.value2 == searchGeneration && searchDoneCallback) {
+                searchDoneCallback(message.value1, messageText1(message));
+            }
+            break;
+
+        case MSG_UI_EVENT:
+            if (uiEventCallback) {
+                uiEventCallback(messageText1(message), messageText2(message));
+            }
+            break;
+
         default:
             break;
     }
@@ -253,22 +492,60 @@ void CoreTaskManager::handleUIMessage(const CoreMessage& message) {
 
 void CoreTaskManager::handleCommunicationsMessage(const CoreMessage& message) {
     switch (message.type) {
-        case MSG_FILE_OPERATION:
-            // Handle file operations on communications core
-            xSemaphoreTake(managerMutex, portMAX_DELAY);
-            if (sdCardManager) {
-                if (message.data1 == "load") {
-                    std::vector<String> lines = sdCardManager->loadLogFile(message.data2);
-                    // Send result back to UI
-                    CoreMessage result(MSG_UI_EVENT, "file_loaded", String(lines.size()));
-                    sendToUI(result);
-                } else if (message.data1 == "delete") {
-                    bool success = sdCardManager->deleteFile(message.data2);
-                    CoreMessage result(MSG_UI_EVENT, "file_deleted", success ? "success" : "failed");
-                    sendToUI(result);
-                }
+        case MSG_FILE_OPERATION: {
+            // File operations belong to the storage task
+            StorageMessageType type = strcmp(messageText1(message), "delete") == 0 ? STORAGE_FILE_DELETE : STORAGE_FILE_LOAD;
+            sendToStorage(StorageMessage(type, messageText2(message)), pdMS_TO_TICKS(STORAGE_CONTROL_TIMEOUT_MS));
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void CoreTaskManager::handleStorageMessage(const StorageMessage& message) {
+    // The storage task is the only one that drives SDCardManager
+    if (!sdCardManager) {
+        return;
+    }
+
+    switch (message.type) {
+        case STORAGE_LOG:
+            Metrics::count(sdCardManager->saveLogToSession(message.packet, message.deviceId) ? METRIC_SD_RECORDS
+                                                                                             : METRIC_SD_FAILED);
+            break;
+
+        case STORAGE_SESSION_START:
+            sdCardManager->startNewSession(message.deviceId);
+            break;
+
+        case STORAGE_SESSION_END:
+            sdCardManager->endSession(message.deviceId);
+            break;
+
+        case STORAGE_FILE_LOAD:
+            startLineCount(String(message.text));
+            break;
+
+        case STORAGE_FILE_DELETE: {
+            bool success = sdCardManager->deleteFile(String(message.text));
+            postToUI(MSG_UI_EVENT, "file_deleted", success ? "success" : "failed");
+            break;
+        }
+
+        case STORAGE_SEARCH_START:
+            startSearchJob(message.query);
+            break;
+
+        case STORAGE_EXPORT_START:
+            startExportJob(message);
+            break;
+
+        case STORAGE_EXPORT_CANCEL:
+            if (exportJob) {
+                exportJob->cancel();
             }
-            xSemaphoreGive(managerMutex);
             break;
 
         default:
@@ -276,6 +553,163 @@ void CoreTaskManager::handleCommunicationsMessage(const CoreMessage& message) {
     }
 }
 
+uint32_t CoreTaskManager::startSearch(const SearchQuery& query) {
+    StorageMessage message(STORAGE_SEARCH_START);
+    message.query = query;
+    message.query.id = ++searchGeneration;
+    if (!sendToStorage(message, pdMS_TO_TICKS(STORAGE_CONTROL_TIMEOUT_MS))) {
+        return 0;
+    }
+    return message.query.id;
+}
+
+void CoreTaskManager::startSearchJob(const SearchQuery& query) {
+    if (query.id != searchGeneration) {
+        return;  // Superseded while queued
+    }
+    if (!search) {
+        search = new LogSearch();
+        search->setHitCallback([this](const SearchHit& hit) {
+            // The storage task can afford to wait a little for the UI to catch up
+            postToUI(MSG_SEARCH_HIT, hit.text, hit.path, hit.line, search->getId(), pdMS_TO_TICKS(20));
+        });
+    }
+
+    // Search what is buffered too
+    sdCardManager->commit(false);
+
+    std::vector<String> files;
+    for (const FileInfo& info : sdCardManager->listLogFiles()) {
+        if (!info.isDirectory && (info.name.endsWith(".log") || info.name.endsWith(BINARY_LOG_EXTENSION))) {
+            files.push_back(info.path);
+        }
+    }
+    search->start(query, files);
+}
+
+void CoreTaskManager::stepSearchJob() {
+    const char* status;
+    if (search->getId() != searchGeneration) {
+        search->cancel();
+        status = "cancelled";
+    } else if (search->step(SEARCH_STEP_MS)) {
+        return;
+    } else {
+        status = search->isLimitReached() ? "limit" : "done";
+    }
+
+    Serial.printf("Search %lu %s: %lu hits, %lu lines read, %lu blocks/ranges skipped\n", (unsigned long)search->getId(),
+                  status, (unsigned long)search->getHits(), (unsigned long)search->getLinesScanned(),
+                  (unsigned long)search->getSkipped());
+    postToUI(MSG_SEARCH_DONE, status, "", search->getHits(), search->getId(), pdMS_TO_TICKS(STORAGE_CONTROL_TIMEOUT_MS));
+}
+
+bool CoreTaskManager::startExport(const String& path, const ExportRequest& request) {
+    StorageMessage message(STORAGE_EXPORT_START, path);
+    message.exportRequest = request;
+    return sendToStorage(message, pdMS_TO_TICKS(STORAGE_CONTROL_TIMEOUT_MS));
+}
+
+bool CoreTaskManager::cancelExport() {
+    return sendToStorage(StorageMessage(STORAGE_EXPORT_CANCEL), pdMS_TO_TICKS(STORAGE_CONTROL_TIMEOUT_MS));
+}
+
+void CoreTaskManager::handleSerialCommand(const char* line) {
+    String path;
+    ExportRequest request;
+    bool cancel;
+    if (NetworkRelay::handleCommand(line)) {
+        return;
+    }
+    if (!SessionExport::parseCommand(line, path, request, cancel)) {
+        Serial.printf("Unknown command: %s (list, export <path> [fromMs toMs [levelMask]], cancel, relay ...)\n", line);
+        return;
+    }
+    if (cancel) {
+        cancelExport();
+    } else {
+        startExport(path, request);
+    }
+}
+
+void CoreTaskManager::startExportJob(const StorageMessage& message) {
+    if (isExporting()) {
+        Serial.println("Export already running, cancel it first");
+        return;
+    }
+    if (!exportJob) {
+        exportJob = new SessionExport();
+    }
+
+    // Export what is buffered too
+    sdCardManager->commit(false);
+
+    const ExportRequest& request = message.exportRequest;
+    bool started;
+    if (request.list) {
+        std::vector<String> paths;
+        std::vector<uint32_t> sizes;
+        for (const FileInfo& info : sdCardManager->listLogFiles()) {
+            if (!info.isDirectory) {
+                paths.push_back(info.path);
+                sizes.push_back(info.size);
+            }
+        }
+        started = exportJob->startList(paths, sizes, Serial);
+    } else {
+        started = exportJob->start(String(message.text), request, Serial);
+    }
+
+    // The port is the export's until it is done; the mirror queues (then drops) meanwhile
+    if (started) {
+        SerialMirror::hold(true);
+    }
+}
+
+void CoreTaskManager::stepExportJob() {
+    // Logging first: wait while records are queuing up, and until the mirror is off the port
+    if (getQueueLoad(storageMessageQueue) >= EXPORT_MAX_QUEUE_LOAD || !SerialMirror::isHeld()) {
+        return;
+    }
+    if (exportJob->step(EXPORT_STEP_MS)) {
+        return;
+    }
+
+    SerialMirror::hold(false);
+    Serial.printf("Export done (status %u): %lu bytes\n", exportJob->getStatus(), (unsigned long)exportJob->getBytesSent());
+}
+
+void CoreTaskManager::startLineCount(const String& path) {
+    // A closed session is counted in the catalog already
+    const SessionCatalog& catalog = sdCardManager->getCatalog();
+    SessionRecord record;
+    int position = path.startsWith(sdCardManager->getLogDirectory() + "/") ? catalog.find(path.c_str()) : -1;
+    if (position >= 0 && catalog.getEntry(position, record) && !(record.flags & SESSION_RECORD_OPEN)) {
+        postToUI(MSG_UI_EVENT, "file_loaded", String(record.lines).c_str());
+        return;
+    }
+
+    // Otherwise from its sidecar, or counted a slice per loop so records keep flowing
+    if (!lineCountJob) {
+        lineCountJob = new LogFileReader();
+    }
+    if (!lineCountJob->open(path)) {
+        postToUI(MSG_UI_EVENT, "file_loaded", "0");
+        return;
+    }
+    if (lineCountJob->isIndexed()) {
+        stepLineCount();
+    }
+}
+
+void CoreTaskManager::stepLineCount() {
+    if (!lineCountJob->indexAhead(LOG_READER_CHECKPOINT_LINES)) {
+        return;
+    }
+    postToUI(MSG_UI_EVENT, "file_loaded", String(lineCountJob->getLineCount()).c_str());
+    lineCountJob->close();
+}
+
 void CoreTaskManager::cleanupTasks() {
     if (communicationsTaskHandle && communicationsTaskRunning) {
         vTaskDelete(communicationsTaskHandle);
@@ -288,6 +722,12 @@ void CoreTaskManager::cleanupTasks() {
         uiTaskHandle = nullptr;
         uiTaskRunning = false;
     }
+
+    if (storageTaskHandle && storageTaskRunning) {
+        vTaskDelete(storageTaskHandle);
+        storageTaskHandle = nullptr;
+        storageTaskRunning = false;
+    }
 }
 
 }  // namespace Core
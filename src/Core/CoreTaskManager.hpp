@@ -5,6 +5,13 @@
 #include <freertos/task.h>
 #include <freertos/semphr.h>
 #include <freertos/queue.h>
+#include <functional>
+#include <type_traits>
+#include "LogProtocol.hpp"
+#include "LogSearch.hpp"
+#include "SessionExport.hpp"
+#include "MessagePool.hpp"
+#include "DeviceRegistry.hpp"
 
 namespace BTLogger {
 namespace Core {
@@ -16,33 +23,93 @@ class SDCardManager;
 // Task priorities
 #define COMMUNICATIONS_TASK_PRIORITY 2
 #define UI_TASK_PRIORITY 3
+#define STORAGE_TASK_PRIORITY 1
 #define TASK_STACK_SIZE 8192
+#define STORAGE_TASK_STACK_SIZE 6144
+
+// Inter-core message queues: default depth and send timeout
+#define CORE_MESSAGE_QUEUE_DEPTH 32
+#define CORE_MESSAGE_SEND_TIMEOUT_MS 100
+
+// Storage queue: depth and how long producers may wait on a full queue
+#define STORAGE_QUEUE_LENGTH 32
+#define STORAGE_SEND_TIMEOUT_MS 5
+#define STORAGE_CONTROL_TIMEOUT_MS 100
 
 // Message types for inter-core communication
 enum MessageType {
     MSG_LOG_RECEIVED,
     MSG_DEVICE_CONNECTION,
-    MSG_UI_EVENT,
+    MSG_UI_EVENT,     // text1 event, text2 value ("file_deleted": "success" or "failed")
     MSG_FILE_OPERATION,
+    MSG_SEARCH_HIT,   // text1 line, text2 file, value1 line number, value2 search id
+    MSG_SEARCH_DONE,  // text1 "done", "limit" or "cancelled", value1 hits, value2 search id
     MSG_SHUTDOWN
 };
 
-// Message structure for inter-core communication
+// Message structure for inter-core communication (plain data, copied by value through
+// FreeRTOS queues). Text travels in a MessagePool block: ownership of the payload moves
+// to the receiving task once the message is queued, and that task releases it.
 struct CoreMessage {
     MessageType type;
-    String data1;
-    String data2;
+    uint16_t payload;  // MessagePool handle or MESSAGE_NO_PAYLOAD
     uint32_t value1;
     uint32_t value2;
 
-    CoreMessage() : type(MSG_SHUTDOWN), value1(0), value2(0) {}
-    CoreMessage(MessageType t, const String& d1 = "", const String& d2 = "", uint32_t v1 = 0, uint32_t v2 = 0)
-        : type(t), data1(d1), data2(d2), value1(v1), value2(v2) {}
+    CoreMessage() : type(MSG_SHUTDOWN), payload(MESSAGE_NO_PAYLOAD), value1(0), value2(0) {}
+    CoreMessage(MessageType t, uint32_t v1 = 0, uint32_t v2 = 0)
+        : type(t), payload(MESSAGE_NO_PAYLOAD), value1(v1), value2(v2) {}
+};
+
+static_assert(std::is_trivially_copyable<CoreMessage>::value, "CoreMessage is copied bytewise through queues");
+
+// Work items for the storage task (plain data, safe to copy through a FreeRTOS queue)
+enum StorageMessageType {
+    STORAGE_LOG,
+    STORAGE_SESSION_START,
+    STORAGE_SESSION_END,
+    STORAGE_FILE_LOAD,
+    STORAGE_FILE_DELETE,
+    STORAGE_SEARCH_START,
+    STORAGE_EXPORT_START,
+    STORAGE_EXPORT_CANCEL,
+    STORAGE_SHUTDOWN
+};
+
+struct StorageMessage {
+    StorageMessageType type;
+    DeviceId deviceId;  // Log and session messages
+    char text[96];      // File path
+    union {
+        LogPacket packet;   // STORAGE_LOG
+        SearchQuery query;  // STORAGE_SEARCH_START
+        ExportRequest exportRequest;  // STORAGE_EXPORT_START, path in text
+    };
+
+    StorageMessage() : type(STORAGE_SHUTDOWN), deviceId(DEVICE_ID_UNKNOWN), packet() { text[0] = '\0'; }
+    StorageMessage(StorageMessageType t, const String& value = "") : type(t), deviceId(DEVICE_ID_UNKNOWN), packet() {
+        strncpy(text, value.c_str(), sizeof(text) - 1);
+        text[sizeof(text) - 1] = '\0';
+    }
+    StorageMessage(StorageMessageType t, DeviceId device) : type(t), deviceId(device), packet() { text[0] = '\0'; }
+};
+
+static_assert(std::is_trivially_copyable<StorageMessage>::value, "StorageMessage is copied bytewise through queues");
+
+// Back-pressure metrics for the storage queue
+struct StorageStats {
+    uint32_t queued;
+    uint32_t dropped;
+    uint32_t highWaterMark;   // Most messages waiting at once
+    uint32_t blockedTimeMs;   // Total time producers spent waiting on a full queue
+    uint32_t maxBlockedUs;    // Longest single wait
+
+    StorageStats() : queued(0), dropped(0), highWaterMark(0), blockedTimeMs(0), maxBlockedUs(0) {}
 };
 
 /**
  * CoreTaskManager manages multithreaded operations across ESP32 cores
- * Core 0: Communications (Bluetooth, SD Card)
+ * Core 0: Communications (Bluetooth) and Storage (SD Card, lower priority)
  * Core 1: UI (Display, Touch, Menu)
  */
 class CoreTaskManager {
@@ -51,14 +118,50 @@ class CoreTaskManager {
     ~CoreTaskManager();
 
     // Core lifecycle
-    bool initialize();
-    void start();
+    bool initialize(size_t queueDepth = CORE_MESSAGE_QUEUE_DEPTH);
+    void start();    // Communications and storage tasks on Core 0
+    void startUI();  // UI task on Core 1, once the screens are set up
     void stop();
     bool isRunning() const { return running; }
 
-    // Inter-core communication
-    bool sendToUI(const CoreMessage& message);
-    bool sendToCommunications(const CoreMessage& message);
+    // Inter-core communication. On failure the message payload is released for the caller.
+    bool sendToUI(const CoreMessage& message, TickType_t timeout = pdMS_TO_TICKS(CORE_MESSAGE_SEND_TIMEOUT_MS));
+    bool sendToCommunications(const CoreMessage& message, TickType_t timeout = pdMS_TO_TICKS(CORE_MESSAGE_SEND_TIMEOUT_MS));
+
+    // Copy text into a pooled payload and send it
+    bool postToUI(MessageType type, const char* text1, const char* text2 = "", uint32_t value1 = 0, uint32_t value2 = 0,
+                  TickType_t timeout = pdMS_TO_TICKS(CORE_MESSAGE_SEND_TIMEOUT_MS));
+    bool postToCommunications(MessageType type, const char* text1, const char* text2 = "", uint32_t value1 = 0, uint32_t value2 = 0,
+                              TickType_t timeout = pdMS_TO_TICKS(CORE_MESSAGE_SEND_TIMEOUT_MS));
+
+    // Payload access for message handlers
+    const char* messageText1(const CoreMessage& message) const { return messagePool.firstText(message.payload); }
+    const char* messageText2(const CoreMessage& message) const { return messagePool.secondText(message.payload); }
+    bool sendToStorage(const StorageMessage& message, TickType_t timeout = pdMS_TO_TICKS(STORAGE_SEND_TIMEOUT_MS));
+    bool submitLog(const LogPacket& packet, DeviceId deviceId);
+
+    // Search stored sessions on the storage task. Starting a search cancels the previous one;
+    // results arrive through the callbacks, which run on the UI task.
+    using SearchHitCallback = std::function<void(const char* path, uint32_t line, const char* text)>;
+    using SearchDoneCallback = std::function<void(uint32_t hits, const char* status)>;
+    uint32_t startSearch(const SearchQuery& query);  // Returns the search id, 0 if it could not be queued
+    void cancelSearch() { searchGeneration++; }
+    void setSearchCallbacks(SearchHitCallback hit, SearchDoneCallback done) {
+        searchHitCallback = hit;
+        searchDoneCallback = done;
+    }
+
+    // Results of file operations and other storage events, on the UI task
+    using UIEventCallback = std::function<void(const char* event, const char* value)>;
+    void setUIEventCallback(UIEventCallback callback) { uiEventCallback = callback; }
+
+    // Bulk export to a PC, on the storage task (see SessionExport); one at a time
+    bool startExport(const String& path, const ExportRequest& request);
+    bool cancelExport();
+    bool isExporting() const { return exportJob && exportJob->isRunning(); }
+
+    // A line typed into the serial port: "list", "export ..." or "cancel"
+    void handleSerialCommand(const char* line);
 
     // Manager access (thread-safe)
     BluetoothManager* getBluetoothManager() const { return bluetoothManager; }
@@ -67,6 +170,11 @@ class CoreTaskManager {
     // Status
     bool isCommunicationsTaskRunning() const { return communicationsTaskRunning; }
     bool isUITaskRunning() const { return uiTaskRunning; }
+    bool isStorageTaskRunning() const { return storageTaskRunning; }
+    StorageStats getStorageStats() const { return storageStats; }
+    uint32_t getUIQueueFullCount() const { return uiQueueFullCount; }
+    uint32_t getCommunicationsQueueFullCount() const { return communicationsQueueFullCount; }
+    const MessagePool& getMessagePool() const { return messagePool; }
 
    private:
     // Core managers
@@ -76,28 +184,62 @@ class CoreTaskManager {
     // Task handles
     TaskHandle_t communicationsTaskHandle;
     TaskHandle_t uiTaskHandle;
+    TaskHandle_t storageTaskHandle;
 
     // Synchronization
     SemaphoreHandle_t managerMutex;
     QueueHandle_t uiMessageQueue;
     QueueHandle_t communicationsMessageQueue;
+    QueueHandle_t storageMessageQueue;
+    StorageStats storageStats;
+    MessagePool messagePool;
+    uint32_t uiQueueFullCount;
+    uint32_t communicationsQueueFullCount;
+
+    // Search job (owned by the storage task)
+    LogSearch* search;
+    volatile uint32_t searchGeneration;  // Bumped to start or cancel a search
+    SearchHitCallback searchHitCallback;
+    SearchDoneCallback searchDoneCallback;
+    UIEventCallback uiEventCallback;
+
+    // Export job (owned by the storage task)
+    SessionExport* exportJob;
+
+    // Line count of a loaded file the catalog and sidecar can't answer for (owned by the storage task)
+    LogFileReader* lineCountJob;
 
     // State
     bool running;
     bool communicationsTaskRunning;
     bool uiTaskRunning;
+    bool storageTaskRunning;
 
     // Task functions (static for FreeRTOS)
     static void communicationsTask(void* parameter);
     static void uiTask(void* parameter);
+    static void storageTask(void* parameter);
 
     // Internal task loops
     void runCommunicationsLoop();
     void runUILoop();
+    void runStorageLoop();
+
+    // Message helpers
+    bool sendMessage(QueueHandle_t queue, const CoreMessage& message, TickType_t timeout, uint32_t& fullCount);
+    static uint8_t getQueueLoad(QueueHandle_t queue);  // Percent full
 
     // Message handlers
     void handleUIMessage(const CoreMessage& message);
     void handleCommunicationsMessage(const CoreMessage& message);
+    void handleStorageMessage(const StorageMessage& message);
+    void startSearchJob(const SearchQuery& query);
+    void stepSearchJob();
+    void startExportJob(const StorageMessage& message);
+    void stepExportJob();
+    void startLineCount(const String& path);
+    void stepLineCount();
+    bool isCountingLines() const { return lineCountJob && lineCountJob->isOpen(); }
 
     // Cleanup
     void cleanupTasks();
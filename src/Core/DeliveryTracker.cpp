@@ -0,0 +1,252 @@
+#include "DeliveryTracker.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+DeliveryTracker::Link DeliveryTracker::links[DEVICE_REGISTRY_SLOTS];
+portMUX_TYPE DeliveryTracker::lock = portMUX_INITIALIZER_UNLOCKED;
+
+void DeliveryTracker::begin(DeviceId device) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return;
+    }
+
+    // Numbering starts over with every connection
+    portENTER_CRITICAL(&lock);
+    memset(&links[device], 0, sizeof(Link));
+    portEXIT_CRITICAL(&lock);
+}
+
+void DeliveryTracker::end(DeviceId device) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return;
+    }
+
+    // Nobody left to resend them; the lost ranges stay until taken
+    portENTER_CRITICAL(&lock);
+    Link& link = links[device];
+    for (Gap& gap : link.gaps) {
+        if (gap.count > 0) {
+            loseRange(link, gap.first, gap.count);
+            gap.count = 0;
+        }
+    }
+    link.started = false;
+    countOpenGaps(link);
+    portEXIT_CRITICAL(&lock);
+}
+
+bool DeliveryTracker::onRecord(DeviceId device, uint16_t sequence, bool resent) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return true;
+    }
+
+    portENTER_CRITICAL(&lock);
+    Link& link = links[device];
+    link.status.sequenced = true;
+
+    int16_t delta = (int16_t)(sequence - link.expected);
+    bool keep = true;
+    if (!resent && !link.started) {
+        link.started = true;
+        link.expected = sequence + 1;
+    } else if (!resent && delta >= 0) {
+        if (delta > 0) {
+            openGap(link, link.expected, delta);
+        }
+        link.expected = sequence + 1;
+    } else if (fillGap(link, sequence)) {
+        link.status.recovered++;
+    } else if (!resent && -delta > DELIVERY_MAX_RESEND) {
+        link.expected = sequence + 1;  // Sender started over
+    } else {
+        link.status.duplicates++;
+        keep = false;
+    }
+    if (keep) {
+        link.status.received++;
+    }
+    portEXIT_CRITICAL(&lock);
+    return keep;
+}
+
+void DeliveryTracker::onLost(DeviceId device, uint16_t firstSequence, uint16_t count) {
+    if (device >= DEVICE_REGISTRY_SLOTS || count == 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&lock);
+    Link& link = links[device];
+    for (Gap& gap : link.gaps) {
+        if (gap.count == 0) {
+            continue;
+        }
+
+        // Overlap, relative to the start of the gap
+        int32_t start = (int16_t)(firstSequence - gap.first);
+        int32_t low = max(start, (int32_t)0);
+        int32_t high = min(start + (int32_t)count, (int32_t)gap.count);
+        if (low >= high) {
+            continue;
+        }
+        loseRange(link, gap.first + low, high - low);
+
+        if (low == 0) {
+            gap.first += high;
+            gap.count -= high;
+        } else {
+            uint16_t after = gap.count - high;
+            gap.count = low;
+            if (after > 0) {
+                openGap(link, gap.first + high, after);
+                link.status.gaps--;  // Same gap, split in two
+                link.status.missing -= after;
+            }
+        }
+    }
+    countOpenGaps(link);
+    portEXIT_CRITICAL(&lock);
+}
+
+bool DeliveryTracker::takeRequest(DeviceId device, uint16_t& firstSequence, uint16_t& count) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return false;
+    }
+
+    unsigned long now = millis();
+    bool taken = false;
+
+    portENTER_CRITICAL(&lock);
+    Link& link = links[device];
+    for (Gap& gap : link.gaps) {
+        if (gap.count == 0 || (long)(now - gap.requestAt) < 0) {
+            continue;
+        }
+        if (gap.attempts >= DELIVERY_RESEND_ATTEMPTS) {
+            loseRange(link, gap.first, gap.count);
+            gap.count = 0;
+            continue;
+        }
+        gap.attempts++;
+        gap.requestAt = now + DELIVERY_RESEND_TIMEOUT_MS;
+        firstSequence = gap.first;
+        count = gap.count;
+        taken = true;
+        break;
+    }
+    countOpenGaps(link);
+    portEXIT_CRITICAL(&lock);
+    return taken;
+}
+
+bool DeliveryTracker::takeLost(DeviceId device, uint16_t& firstSequence, uint16_t& count) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&lock);
+    Link& link = links[device];
+    bool taken = link.lostCount > 0;
+    if (taken) {
+        firstSequence = link.lost[0].first;
+        count = link.lost[0].count;
+        memmove(link.lost, link.lost + 1, (link.lostCount - 1) * sizeof(Range));
+        link.lostCount--;
+    }
+    portEXIT_CRITICAL(&lock);
+    return taken;
+}
+
+bool DeliveryTracker::getStatus(DeviceId device, DeliveryStatus& status) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&lock);
+    status = links[device].status;
+    portEXIT_CRITICAL(&lock);
+    return status.sequenced;
+}
+
+void DeliveryTracker::openGap(Link& link, uint16_t first, uint16_t count) {
+    link.status.gaps++;
+    link.status.missing += count;
+    if (count > DELIVERY_MAX_RESEND) {
+        loseRange(link, first, count);
+        return;
+    }
+
+    for (Gap& gap : link.gaps) {
+        if (gap.count == 0) {
+            gap.first = first;
+            gap.count = count;
+            gap.attempts = 0;
+            gap.requestAt = millis();  // Asked for straight away
+            countOpenGaps(link);
+            return;
+        }
+    }
+    loseRange(link, first, count);  // Too many open at once
+}
+
+bool DeliveryTracker::fillGap(Link& link, uint16_t sequence) {
+    for (Gap& gap : link.gaps) {
+        uint16_t offset = sequence - gap.first;
+        if (offset >= gap.count) {
+            continue;
+        }
+
+        if (offset == 0) {
+            gap.first++;
+            gap.count--;
+        } else if (offset == gap.count - 1) {
+            gap.count--;
+        } else {
+            // Resends come in order, so a record from the middle is rare; split around it
+            uint16_t after = gap.count - offset - 1;
+            uint16_t start = sequence + 1;
+            gap.count = offset;
+            bool placed = false;
+            for (Gap& slot : link.gaps) {
+                if (slot.count == 0) {
+                    slot = gap;
+                    slot.first = start;
+                    slot.count = after;
+                    placed = true;
+                    break;
+                }
+            }
+            if (!placed) {
+                loseRange(link, start, after);
+            }
+        }
+        countOpenGaps(link);
+        return true;
+    }
+    return false;
+}
+
+void DeliveryTracker::loseRange(Link& link, uint16_t first, uint16_t count) {
+    link.status.lost += count;
+
+    // Folded into the last one when the markers are not being taken fast enough
+    if (link.lostCount < DELIVERY_MAX_LOST) {
+        link.lost[link.lostCount].first = first;
+        link.lost[link.lostCount].count = count;
+        link.lostCount++;
+    } else {
+        Range& last = link.lost[DELIVERY_MAX_LOST - 1];
+        last.count = min((uint32_t)UINT16_MAX, (uint32_t)last.count + count);
+    }
+}
+
+void DeliveryTracker::countOpenGaps(Link& link) {
+    uint16_t open = 0;
+    for (const Gap& gap : link.gaps) {
+        open += gap.count > 0;
+    }
+    link.status.openGaps = open;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include "DeviceRegistry.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Gap recovery
+#define DELIVERY_MAX_GAPS 8               // Open gaps per connection; more are given up at once
+#define DELIVERY_MAX_LOST 8               // Lost ranges waiting to be marked in the log
+#define DELIVERY_RESEND_TIMEOUT_MS 1500   // A gap still open this long after a request is asked for again ...
+#define DELIVERY_RESEND_ATTEMPTS 3        // ... this many times in all, then taken as lost
+#define DELIVERY_MAX_RESEND 1024          // Larger gaps outrun any sender history and are not asked for
+
+// Per-connection delivery counts, as shown on the diagnostics screen
+struct DeliveryStatus {
+    bool sequenced;       // The sender numbers its records (wire version 5+)
+    uint16_t openGaps;
+    uint32_t received;    // Unique records
+    uint32_t gaps;        // Gaps detected
+    uint32_t missing;     // Records found missing
+    uint32_t recovered;   // Missing records that were resent
+    uint32_t lost;        // Missing records given up on
+    uint32_t duplicates;  // Dropped
+};
+
+/**
+ * DeliveryTracker checks the sequence numbers of each connection's records.
+ * A jump forward opens a gap; the communications task asks the sender to
+ * resend it (takeRequest) and the records that come back close it. What the
+ * sender no longer has, or what stays missing after a few requests, is lost:
+ * takeLost hands the range over so a marker can go into the stored log, and
+ * the gaps still open when a device disconnects are lost the same way.
+ *
+ * Sequence numbers are 16 bits and wrap; a record more than
+ * DELIVERY_MAX_RESEND behind the newest is taken as the sender starting over.
+ *
+ * Everything runs on the communications task; status is safe from any task.
+ */
+class DeliveryTracker {
+   public:
+    static void begin(DeviceId device);
+    static void end(DeviceId device);  // Open gaps become lost
+
+    // A record arrived, resent in answer to a request or not; false for a duplicate to drop
+    static bool onRecord(DeviceId device, uint16_t sequence, bool resent);
+
+    // The sender has no copy of these records left
+    static void onLost(DeviceId device, uint16_t firstSequence, uint16_t count);
+
+    // Next resend request to send to device, if one is due
+    static bool takeRequest(DeviceId device, uint16_t& firstSequence, uint16_t& count);
+
+    // Next range given up on, to mark in the log
+    static bool takeLost(DeviceId device, uint16_t& firstSequence, uint16_t& count);
+
+    static bool getStatus(DeviceId device, DeliveryStatus& status);
+
+   private:
+    struct Gap {
+        uint16_t first;
+        uint16_t count;  // 0 for a free slot
+        uint8_t attempts;
+        unsigned long requestAt;
+    };
+
+    struct Range {
+        uint16_t first;
+        uint16_t count;
+    };
+
+    struct Link {
+        DeliveryStatus status;
+        bool started;
+        uint16_t expected;  // Newest sequence + 1
+        Gap gaps[DELIVERY_MAX_GAPS];
+        Range lost[DELIVERY_MAX_LOST];
+        uint8_t lostCount;
+    };
+
+    static Link links[DEVICE_REGISTRY_SLOTS];
+    static portMUX_TYPE lock;
+
+    static void openGap(Link& link, uint16_t first, uint16_t count);
+    static bool fillGap(Link& link, uint16_t sequence);
+    static void loseRange(Link& link, uint16_t first, uint16_t count);
+    static void countOpenGaps(Link& link);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,107 @@
+#include "DeviceRegistry.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Static member definitions
+DeviceRegistry::Entry DeviceRegistry::entries[DEVICE_REGISTRY_SLOTS] = {{"Unknown", "", false}};
+std::atomic<uint32_t> DeviceRegistry::storedRecords[DEVICE_REGISTRY_SLOTS] = {};
+uint8_t DeviceRegistry::count = 1;
+uint8_t DeviceRegistry::nextRecycle = 1;
+portMUX_TYPE DeviceRegistry::lock = portMUX_INITIALIZER_UNLOCKED;
+
+DeviceId DeviceRegistry::registerDevice(const char* name, const char* address) {
+    if (!address || !address[0]) {
+        return DEVICE_ID_UNKNOWN;
+    }
+
+    // Reconnects keep their id so stored records and sessions stay attributed
+    for (uint8_t i = 1; i < count; i++) {
+        if (strcmp(entries[i].address, address) == 0) {
+            return i;
+        }
+    }
+
+    DeviceId id = allocateSlot();
+    if (id == DEVICE_ID_UNKNOWN) {
+        Serial.println("Device registry full - logging as Unknown");
+        return DEVICE_ID_UNKNOWN;
+    }
+
+    // Identical firmware on several nodes advertises the same name: append the last address bytes
+    char uniqueName[DEVICE_NAME_LENGTH];
+    strncpy(uniqueName, (name && name[0]) ? name : address, sizeof(uniqueName) - 1);
+    uniqueName[sizeof(uniqueName) - 1] = '\0';
+    if (nameInUse(uniqueName, id)) {
+        size_t addressLength = strlen(address);
+        const char* tail = addressLength >= 5 ? address + addressLength - 5 : address;  // "ee:ff"
+        char suffix[8];
+        snprintf(suffix, sizeof(suffix), "_%c%c%c%c", tail[0], tail[1], tail[3], tail[4]);
+        size_t room = sizeof(uniqueName) - 1 - strlen(suffix);
+        uniqueName[min(strlen(uniqueName), room)] = '\0';
+        strcat(uniqueName, suffix);
+    }
+
+    // Readers may hold the name pointer; publish the slot under the lock
+    portENTER_CRITICAL(&lock);
+    strcpy(entries[id].name, uniqueName);
+    strncpy(entries[id].address, address, DEVICE_ADDRESS_LENGTH - 1);
+    entries[id].address[DEVICE_ADDRESS_LENGTH - 1] = '\0';
+    entries[id].connected = false;
+    portEXIT_CRITICAL(&lock);
+
+    Serial.printf("Registered device %d: %s (%s)\n", id, entries[id].name, entries[id].address);
+    return id;
+}
+
+void DeviceRegistry::setConnected(DeviceId id, bool connected) {
+    if (id != DEVICE_ID_UNKNOWN && id < count) {
+        entries[id].connected = connected;
+    }
+}
+
+const char* DeviceRegistry::getName(DeviceId id) {
+    return id < count ? entries[id].name : entries[DEVICE_ID_UNKNOWN].name;
+}
+
+const char* DeviceRegistry::getAddress(DeviceId id) {
+    return id < count ? entries[id].address : "";
+}
+
+bool DeviceRegistry::isConnected(DeviceId id) {
+    return id < count && entries[id].connected;
+}
+
+void DeviceRegistry::addStoredRecords(DeviceId id, int32_t delta) {
+    if (id != DEVICE_ID_UNKNOWN && id < DEVICE_REGISTRY_SLOTS) {
+        storedRecords[id].fetch_add((uint32_t)delta, std::memory_order_relaxed);
+    }
+}
+
+DeviceId DeviceRegistry::allocateSlot() {
+    if (count < DEVICE_REGISTRY_SLOTS) {
+        return count++;
+    }
+
+    // Table full: recycle the next slot whose device is not connected and is no longer in any LogStore
+    for (uint8_t tries = 1; tries < DEVICE_REGISTRY_SLOTS; tries++) {
+        DeviceId candidate = nextRecycle;
+        nextRecycle = nextRecycle + 1 < DEVICE_REGISTRY_SLOTS ? nextRecycle + 1 : 1;
+        if (!entries[candidate].connected && storedRecords[candidate].load(std::memory_order_relaxed) == 0) {
+            return candidate;
+        }
+    }
+    return DEVICE_ID_UNKNOWN;
+}
+
+bool DeviceRegistry::nameInUse(const char* name, DeviceId except) {
+    for (uint8_t i = 1; i < count; i++) {
+        if (i != except && strcmp(entries[i].name, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
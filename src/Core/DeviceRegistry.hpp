@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include <atomic>
+
+namespace BTLogger {
+namespace Core {
+
+// Device registry configuration
+#define DEVICE_REGISTRY_SLOTS 16
+#define DEVICE_NAME_LENGTH 32
+#define DEVICE_ADDRESS_LENGTH 18  // "aa:bb:cc:dd:ee:ff"
+#define DEVICE_ID_UNKNOWN 0       // Slot 0 always resolves to "Unknown"
+
+// Small integer handle carried by every log record instead of name/address strings
+typedef uint8_t DeviceId;
+
+/**
+ * DeviceRegistry maps BLE devices to small integer ids. An id is resolved once
+ * at connect time (the same address always gets the same id back), after which
+ * ingest, storage and UI pass the id around and look the name up on demand.
+ * Once the table is full, the slot of a device that is disconnected and has
+ * no records left in a LogStore is recycled: its id and name then belong to
+ * the new device, and anything else still holding the old id (a live filter,
+ * search hits) shows the new name. A name pointer stays readable either way.
+ */
+class DeviceRegistry {
+   public:
+    // Look up or allocate the id for a device; names shared by different addresses get a suffix
+    static DeviceId registerDevice(const char* name, const char* address);
+    static void setConnected(DeviceId id, bool connected);
+
+    static const char* getName(DeviceId id);
+    static const char* getAddress(DeviceId id);
+    static bool isConnected(DeviceId id);
+    static size_t size() { return count; }
+
+    // LogStore counts the records it holds per device, so their slot is not recycled under them
+    static void addStoredRecords(DeviceId id, int32_t delta);
+
+   private:
+    struct Entry {
+        char name[DEVICE_NAME_LENGTH];
+        char address[DEVICE_ADDRESS_LENGTH];
+        bool connected;
+    };
+
+    static Entry entries[DEVICE_REGISTRY_SLOTS];
+    static std::atomic<uint32_t> storedRecords[DEVICE_REGISTRY_SLOTS];
+    static uint8_t count;
+    static uint8_t nextRecycle;
+    static portMUX_TYPE lock;
+
+    static DeviceId allocateSlot();
+    static bool nameInUse(const char* name, DeviceId except);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,181 @@
+#include "DirectoryIndex.hpp"
+#include "../Hardware/SharedSPIBus.hpp"
+#include <SD.h>
+#include <string.h>
+#include <strings.h>
+
+namespace BTLogger {
+namespace Core {
+
+DirectoryIndex::DirectoryIndex()
+    : entries(nullptr), order(nullptr), entryCapacity(0), count(0), arena(nullptr), arenaCapacity(0), arenaUsed(0), skipped(0), scanning(false) {
+}
+
+DirectoryIndex::~DirectoryIndex() {
+    close();
+    heap_caps_free(entries);
+    heap_caps_free(order);
+    heap_caps_free(arena);
+}
+
+bool DirectoryIndex::allocate() {
+    if (entries) {
+        return true;
+    }
+
+    bool hasPsram = psramFound();
+    size_t capacity = hasPsram ? DIR_INDEX_PSRAM_ENTRIES : DIR_INDEX_ENTRIES;
+    size_t arenaBytes = hasPsram ? DIR_INDEX_PSRAM_ARENA_BYTES : DIR_INDEX_ARENA_BYTES;
+    uint32_t caps = hasPsram ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : MALLOC_CAP_8BIT;
+
+    entries = static_cast<StoredEntry*>(heap_caps_malloc(capacity * sizeof(StoredEntry), caps));
+    order = static_cast<uint16_t*>(heap_caps_malloc(capacity * sizeof(uint16_t), caps));
+    arena = static_cast<char*>(heap_caps_malloc(arenaBytes, caps));
+    if (!entries || !order || !arena) {
+        Serial.printf("Failed to allocate directory index (%d entries)\n", capacity);
+        heap_caps_free(entries);
+        heap_caps_free(order);
+        heap_caps_free(arena);
+        entries = nullptr;
+        order = nullptr;
+        arena = nullptr;
+        return false;
+    }
+
+    entryCapacity = capacity;
+    arenaCapacity = arenaBytes;
+    return true;
+}
+
+bool DirectoryIndex::begin(const String& dirPath) {
+    close();
+    count = 0;
+    arenaUsed = 0;
+    skipped = 0;
+    path = dirPath;
+
+    if (!allocate()) {
+        return false;
+    }
+
+    Hardware::SharedSPIBus::Hold bus;
+    dir = SD.open(path);
+    if (!dir || !dir.isDirectory()) {
+        Serial.printf("Failed to open directory: %s\n", path.c_str());
+        dir.close();
+        return false;
+    }
+    scanning = true;
+    return true;
+}
+
+bool DirectoryIndex::step(size_t maxEntries) {
+    if (!scanning) {
+        return false;
+    }
+
+    // The card is shared with session commits; hold the bus for the whole slice
+    Hardware::SharedSPIBus::Hold bus;
+    for (size_t i = 0; i < maxEntries; i++) {
+        File entry = dir.openNextFile();
+        if (!entry) {
+            close();
+            return false;
+        }
+
+        // Some cores report the full path
+        const char* name = entry.name();
+        const char* slash = strrchr(name, '/');
+        if (slash) {
+            name = slash + 1;
+        }
+        insert(name, strnlen(name, DIR_INDEX_NAME_LENGTH), entry.size(), entry.isDirectory());
+        entry.close();
+    }
+    return true;
+}
+
+void DirectoryIndex::close() {
+    if (scanning) {
+        Hardware::SharedSPIBus::Hold bus;
+        dir.close();
+    }
+    scanning = false;
+}
+
+void DirectoryIndex::insert(const char* name, size_t nameLength, uint32_t size, bool isDirectory) {
+    if (nameLength == 0) {
+        return;
+    }
+    if (count >= entryCapacity || arenaUsed + nameLength + 1 > arenaCapacity) {
+        skipped++;
+        return;
+    }
+
+    StoredEntry& stored = entries[count];
+    stored.nameOffset = arenaUsed;
+    stored.nameLength = nameLength;
+    stored.size = size;
+    stored.isDirectory = isDirectory;
+    memcpy(arena + arenaUsed, name, nameLength);
+    arena[arenaUsed + nameLength] = '\0';
+    arenaUsed += nameLength + 1;
+
+    // Binary search for the slot, then shift only the small order indices
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (compare(entries[order[mid]], stored) <= 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    memmove(order + low + 1, order + low, (count - low) * sizeof(uint16_t));
+    order[low] = count;
+    count++;
+}
+
+int DirectoryIndex::compare(const StoredEntry& a, const StoredEntry& b) const {
+    if (a.isDirectory != b.isDirectory) {
+        return a.isDirectory ? -1 : 1;
+    }
+    return strcasecmp(arena + a.nameOffset, arena + b.nameOffset);
+}
+
+bool DirectoryIndex::getEntry(size_t position, DirectoryEntry& entry) const {
+    if (position >= count) {
+        return false;
+    }
+    const StoredEntry& stored = entries[order[position]];
+    entry.name = arena + stored.nameOffset;
+    entry.size = stored.size;
+    entry.isDirectory = stored.isDirectory;
+    return true;
+}
+
+String DirectoryIndex::getEntryPath(size_t position) const {
+    DirectoryEntry entry;
+    if (!getEntry(position, entry)) {
+        return String();
+    }
+    String fullPath = path;
+    if (!fullPath.endsWith("/")) {
+        fullPath += "/";
+    }
+    fullPath += entry.name;
+    return fullPath;
+}
+
+int DirectoryIndex::find(const char* name) const {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(arena + entries[order[i]].nameOffset, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+namespace BTLogger {
+namespace Core {
+
+// Directory listing capacity (internal RAM vs PSRAM boards)
+#define DIR_INDEX_ENTRIES 512
+#define DIR_INDEX_ARENA_BYTES (16 * 1024)
+#define DIR_INDEX_PSRAM_ENTRIES 8192
+#define DIR_INDEX_PSRAM_ARENA_BYTES (256 * 1024)
+#define DIR_INDEX_STEP_ENTRIES 16  // Entries read per step()
+#define DIR_INDEX_NAME_LENGTH 64
+
+struct DirectoryEntry {
+    const char* name;  // Valid until the next begin()
+    uint32_t size;
+    bool isDirectory;
+};
+
+/**
+ * DirectoryIndex lists a directory a few entries at a time and keeps them
+ * sorted as they arrive: directories first, then by name. Each entry is
+ * placed with a binary search as it is read, so a partly scanned listing is
+ * already in order and can be shown while the rest comes in.
+ *
+ * Names live in one arena and the order in an array of small indices, both
+ * allocated once (in PSRAM when the board has it) and reused for every
+ * listing, so memory does not grow with the directory. Entries past the
+ * capacity are counted but not kept.
+ */
+class DirectoryIndex {
+   public:
+    DirectoryIndex();
+    ~DirectoryIndex();
+
+    // Opens path and clears the listing; step() does the reading
+    bool begin(const String& path);
+    // Reads up to maxEntries more; false once the directory is exhausted
+    bool step(size_t maxEntries = DIR_INDEX_STEP_ENTRIES);
+    void close();
+
+    bool isScanning() const { return scanning; }
+    size_t size() const { return count; }
+    size_t getSkipped() const { return skipped; }  // Entries that did not fit
+    const String& getPath() const { return path; }
+
+    // Position in sorted order
+    bool getEntry(size_t position, DirectoryEntry& entry) const;
+    String getEntryPath(size_t position) const;
+    // Position of a name, or -1
+    int find(const char* name) const;
+
+   private:
+    struct StoredEntry {
+        uint32_t nameOffset;
+        uint32_t size;
+        uint8_t nameLength;
+        bool isDirectory;
+    };
+
+    StoredEntry* entries;
+    uint16_t* order;  // Sorted positions -> entries
+    size_t entryCapacity;
+    size_t count;
+    char* arena;
+    size_t arenaCapacity;
+    size_t arenaUsed;
+    size_t skipped;
+
+    File dir;
+    String path;
+    bool scanning;
+
+    bool allocate();
+    void insert(const char* name, size_t nameLength, uint32_t size, bool isDirectory);
+    int compare(const StoredEntry& a, const StoredEntry& b) const;
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,233 @@
+#include "FormatDictionary.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Static member definitions
+FormatDictionary::Entry FormatDictionary::entries[FORMAT_DICTIONARY_ENTRIES];
+char FormatDictionary::arena[FORMAT_DICTIONARY_ARENA_BYTES];
+size_t FormatDictionary::arenaUsed = 0;
+uint16_t FormatDictionary::count = 0;
+portMUX_TYPE FormatDictionary::lock = portMUX_INITIALIZER_UNLOCKED;
+
+uint16_t FormatDictionary::define(DeviceId device, uint16_t formatId, const char* format, size_t length) {
+    if (!format || length > 255) {
+        return FORMAT_ENTRY_NONE;
+    }
+
+    uint16_t index = FORMAT_ENTRY_NONE;
+    bool full = false;
+
+    portENTER_CRITICAL(&lock);
+    uint16_t existing = findCurrent(device, formatId);
+    if (existing != FORMAT_ENTRY_NONE && entries[existing].length == length &&
+        memcmp(arena + entries[existing].offset, format, length) == 0) {
+        index = existing;  // Re-announced after a reconnect
+    } else if (count >= FORMAT_DICTIONARY_ENTRIES || arenaUsed + length > sizeof(arena)) {
+        full = true;
+    } else {
+        // Entries are never rewritten; an id that now means something else gets a new one
+        if (existing != FORMAT_ENTRY_NONE) {
+            entries[existing].current = false;
+        }
+        index = count;
+        Entry& entry = entries[index];
+        entry.offset = arenaUsed;
+        entry.formatId = formatId;
+        entry.length = length;
+        entry.device = device;
+        entry.current = true;
+        memcpy(arena + arenaUsed, format, length);
+        arenaUsed += length;
+        count++;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (full) {
+        Serial.printf("Format dictionary full - format %d from %s will not render\n", formatId,
+                      DeviceRegistry::getName(device));
+    }
+    return index;
+}
+
+uint16_t FormatDictionary::resolve(DeviceId device, uint16_t formatId) {
+    portENTER_CRITICAL(&lock);
+    uint16_t index = findCurrent(device, formatId);
+    portEXIT_CRITICAL(&lock);
+    return index;
+}
+
+uint16_t FormatDictionary::findCurrent(DeviceId device, uint16_t formatId) {
+    // Newest first: recent formats are the ones records refer to
+    for (uint16_t i = count; i > 0; i--) {
+        const Entry& entry = entries[i - 1];
+        if (entry.current && entry.device == device && entry.formatId == formatId) {
+            return i - 1;
+        }
+    }
+    return FORMAT_ENTRY_NONE;
+}
+
+size_t FormatDictionary::render(const char* body, size_t length, char* out, size_t capacity) {
+    if (!out || capacity == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+
+    uint16_t index = FORMAT_ENTRY_NONE;
+    if (body && length >= 2) {
+        memcpy(&index, body, sizeof(index));
+    }
+    // Entries are immutable once count covers them
+    if (index >= count) {
+        return snprintf(out, capacity, "[unknown format]");
+    }
+
+    return renderFormat(arena + entries[index].offset, entries[index].length, body + 2, length - 2, out, capacity);
+}
+
+const char* FormatDictionary::getFormat(uint16_t entry, size_t& length) {
+    if (entry >= count) {
+        return nullptr;
+    }
+    length = entries[entry].length;
+    return arena + entries[entry].offset;
+}
+
+size_t FormatDictionary::renderFormat(const char* format, size_t formatLength, const char* args, size_t argsLength,
+                                      char* out, size_t capacity) {
+    if (!out || capacity == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+    if (!format) {
+        return snprintf(out, capacity, "[unknown format]");
+    }
+
+    const char* end = format + formatLength;
+    size_t argOffset = 0;
+    size_t written = 0;
+
+    auto append = [&](int result) {
+        if (result > 0) {
+            written += result;
+            if (written >= capacity) {
+                written = capacity - 1;
+            }
+        }
+    };
+    auto takeArg = [&](void* value, size_t size) {
+        if (argOffset + size > argsLength) {
+            return false;
+        }
+        memcpy(value, args + argOffset, size);
+        argOffset += size;
+        return true;
+    };
+
+    const char* p = format;
+    while (p < end && written < capacity - 1) {
+        if (*p != '%') {
+            out[written++] = *p++;
+            continue;
+        }
+        if (p + 1 < end && p[1] == '%') {
+            out[written++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Rebuild the conversion with '*' values inlined and only the length modifier we pass
+        char spec[32];
+        size_t specLength = 0;
+        spec[specLength++] = *p++;
+        bool ok = true;
+
+        while (p < end && strchr("-+ #0", *p) && specLength < 8) {
+            spec[specLength++] = *p++;
+        }
+        for (int part = 0; part < 2 && ok; part++) {
+            if (part == 1) {
+                if (p >= end || *p != '.') break;
+                spec[specLength++] = *p++;
+            }
+            if (p < end && *p == '*') {
+                int32_t value;
+                ok = takeArg(&value, sizeof(value));
+                if (ok) specLength += snprintf(spec + specLength, 12, "%d", (int)value);
+                p++;
+            } else {
+                while (p < end && *p >= '0' && *p <= '9' && specLength < 20) {
+                    spec[specLength++] = *p++;
+                }
+            }
+        }
+
+        bool wide = false;
+        while (p < end && strchr("hlljzt", *p)) {
+            if (*p == 'j' || (*p == 'l' && p + 1 < end && p[1] == 'l')) {
+                wide = true;
+            }
+            p++;
+        }
+        if (p >= end || !ok) {
+            append(snprintf(out + written, capacity - written, "<?>"));
+            break;
+        }
+
+        char conversion = *p++;
+        if (wide && strchr("diouxX", conversion)) {
+            spec[specLength++] = 'l';
+            spec[specLength++] = 'l';
+        }
+        spec[specLength++] = conversion;
+        spec[specLength] = '\0';
+
+        int result = -1;
+        if (strchr("diouxXc", conversion)) {
+            if (wide) {
+                int64_t value;
+                if (takeArg(&value, sizeof(value))) result = snprintf(out + written, capacity - written, spec, (long long)value);
+            } else {
+                int32_t value;
+                if (takeArg(&value, sizeof(value))) {
+                    result = strchr("di", conversion) ? snprintf(out + written, capacity - written, spec, (int)value)
+                                                      : snprintf(out + written, capacity - written, spec, (unsigned)value);
+                }
+            }
+        } else if (strchr("fFeEgGaA", conversion)) {
+            double value;
+            if (takeArg(&value, sizeof(value))) result = snprintf(out + written, capacity - written, spec, value);
+        } else if (conversion == 'p') {
+            uint32_t value;
+            if (takeArg(&value, sizeof(value))) result = snprintf(out + written, capacity - written, spec, (void*)(uintptr_t)value);
+        } else if (conversion == 's') {
+            uint8_t stringLength;
+            char text[256];
+            if (takeArg(&stringLength, sizeof(stringLength)) && takeArg(text, stringLength)) {
+                text[stringLength] = '\0';
+                result = snprintf(out + written, capacity - written, spec, text);
+            }
+        }
+
+        if (result < 0) {
+            append(snprintf(out + written, capacity - written, "<?>"));
+            break;
+        }
+        append(result);
+    }
+
+    out[written] = '\0';
+    return written;
+}
+
+const char* FormatDictionary::messageText(const LogPacket& packet, char* scratch, size_t capacity) {
+    if (!(packet.flags & WIRE_RECORD_FLAG_TOKENIZED)) {
+        return packet.message;
+    }
+    render(packet.message, packet.length, scratch, capacity);
+    return scratch;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include "DeviceRegistry.hpp"
+#include "LogProtocol.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Format dictionary configuration
+#define FORMAT_DICTIONARY_ENTRIES 256
+#define FORMAT_DICTIONARY_ARENA_BYTES (12 * 1024)
+#define FORMAT_ENTRY_NONE 0xFFFF
+#define FORMAT_MAX_ARGS 12
+
+/**
+ * FormatDictionary keeps the format strings tokenized senders announce, so
+ * their records can stay as [formatId][args] until someone looks at them.
+ * Sender format ids are per device and per connection; on arrival a record's
+ * id is swapped for the index of a dictionary entry, which never changes or
+ * goes away, so stored records render the same later even if the sender
+ * reuses the id. Thread-safe.
+ */
+class FormatDictionary {
+   public:
+    // Record a DICT frame; returns the entry now current for (device, formatId)
+    static uint16_t define(DeviceId device, uint16_t formatId, const char* format, size_t length);
+
+    // Entry for a sender format id, FORMAT_ENTRY_NONE if it was never defined
+    static uint16_t resolve(DeviceId device, uint16_t formatId);
+
+    // Format a tokenized body whose id has been resolved ([entry:2][args...]); returns the text length
+    static size_t render(const char* body, size_t length, char* out, size_t capacity);
+
+    // Same for a format held elsewhere (e.g. read back from a log file); args excludes the id
+    static size_t renderFormat(const char* format, size_t formatLength, const char* args, size_t argsLength, char* out,
+                               size_t capacity);
+
+    // Text of an entry, nullptr if unknown
+    static const char* getFormat(uint16_t entry, size_t& length);
+
+    // Printable message of a packet: the text itself, or rendered into scratch when tokenized
+    static const char* messageText(const LogPacket& packet, char* scratch, size_t capacity);
+
+    static size_t size() { return count; }
+
+   private:
+    struct Entry {
+        uint16_t offset;
+        uint16_t formatId;
+        uint8_t length;
+        DeviceId device;
+        bool current;  // Latest definition of formatId for this device
+    };
+
+    static Entry entries[FORMAT_DICTIONARY_ENTRIES];
+    static char arena[FORMAT_DICTIONARY_ARENA_BYTES];
+    static size_t arenaUsed;
+    static uint16_t count;
+    static portMUX_TYPE lock;
+
+    static uint16_t findCurrent(DeviceId device, uint16_t formatId);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
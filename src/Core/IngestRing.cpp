@@ -0,0 +1,102 @@
+#include "IngestRing.hpp"
+#include "Metrics.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+IngestRing::IngestRing()
+    : slots(nullptr), slotCount(0), head(0), tail(0), droppedCount(0), highWaterMark(0) {
+}
+
+IngestRing::~IngestRing() {
+    free(slots);
+    slots = nullptr;
+}
+
+bool IngestRing::initialize(size_t count) {
+    if (slots) {
+        return true;
+    }
+
+    // One slot is kept empty to tell a full ring from an empty one
+    slots = static_cast<IngestSlot*>(malloc((count + 1 + INGEST_RING_CONTROL_SLOTS) * sizeof(IngestSlot)));
+    if (!slots) {
+        Serial.printf("Failed to allocate ingest ring (%u slots)\n", (unsigned)count);
+        return false;
+    }
+
+    slotCount = count + 1 + INGEST_RING_CONTROL_SLOTS;
+    head.store(0);
+    tail.store(0);
+    Serial.printf("Ingest ring ready: %u slots, %u bytes\n", (unsigned)count, (unsigned)(slotCount * sizeof(IngestSlot)));
+    return true;
+}
+
+bool IngestRing::push(DeviceId source, const uint8_t* data, size_t length) {
+    // Notifications leave the control slots free
+    if (!data || length == 0 || !write(source, INGEST_NOTIFICATION, data, length, capacity())) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        Metrics::count(METRIC_RX_DROPPED);
+        return false;
+    }
+
+    size_t used = size();
+    if (used > highWaterMark.load(std::memory_order_relaxed)) {
+        highWaterMark.store(used, std::memory_order_relaxed);
+    }
+    Metrics::count(METRIC_RX_NOTIFICATIONS);
+    Metrics::count(METRIC_RX_BYTES, length);
+    Metrics::level(METRIC_LEVEL_INGEST_RING, used);
+    return true;
+}
+
+bool IngestRing::pushEvent(DeviceId source, IngestSlotType type, const uint8_t* data, size_t length) {
+    return write(source, type, data, length, slotCount - 1);
+}
+
+bool IngestRing::write(DeviceId source, IngestSlotType type, const uint8_t* data, size_t length, size_t limit) {
+    if (!slots || length > INGEST_SLOT_PAYLOAD || size() >= limit) {
+        return false;
+    }
+
+    size_t currentHead = head.load(std::memory_order_relaxed);
+    IngestSlot& slot = slots[currentHead];
+    slot.source = source;
+    slot.type = type;
+    slot.length = length;
+    slot.arrivalUs = esp_timer_get_time();
+    if (length > 0) {
+        memcpy(slot.data, data, length);
+    }
+
+    head.store((currentHead + 1) % slotCount, std::memory_order_release);
+    return true;
+}
+
+const IngestSlot* IngestRing::front() const {
+    size_t currentTail = tail.load(std::memory_order_relaxed);
+    if (!slots || currentTail == head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &slots[currentTail];
+}
+
+void IngestRing::pop() {
+    size_t currentTail = tail.load(std::memory_order_relaxed);
+    if (!slots || currentTail == head.load(std::memory_order_acquire)) {
+        return;
+    }
+    tail.store((currentTail + 1) % slotCount, std::memory_order_release);
+}
+
+size_t IngestRing::size() const {
+    if (slotCount == 0) {
+        return 0;
+    }
+    size_t currentHead = head.load(std::memory_order_acquire);
+    size_t currentTail = tail.load(std::memory_order_acquire);
+    return (currentHead + slotCount - currentTail) % slotCount;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
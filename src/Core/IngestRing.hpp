@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include <atomic>
+#include "DeviceRegistry.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Ingest ring configuration
+#define INGEST_RING_SLOTS 32
+#define INGEST_SLOT_PAYLOAD 514  // Largest notification payload (517 byte MTU - 3)
+#define INGEST_RING_CONTROL_SLOTS 4  // On top of the notification slots, so a disconnect always finds room
+
+enum IngestSlotType : uint8_t {
+    INGEST_NOTIFICATION,
+    INGEST_DISCONNECT  // The source's link went down; everything it sent is ahead of this slot
+};
+
+// One raw notification (or link event) waiting to be decoded
+struct IngestSlot {
+    DeviceId source;  // Device that sent the notification
+    IngestSlotType type;
+    uint16_t length;
+    int64_t arrivalUs;  // ClockSync::now() when the BLE stack handed it over
+    uint8_t data[INGEST_SLOT_PAYLOAD];
+};
+
+/**
+ * IngestRing is a fixed-capacity single-producer/single-consumer ring of raw
+ * notifications. The BLE notify callback pushes, the communications task drains.
+ * Neither side blocks or allocates; pushes into a full ring are dropped and counted.
+ * Link events from the same BLE task go through the ring too, so they reach the
+ * communications task in order with the data, and have slots of their own.
+ */
+class IngestRing {
+   public:
+    IngestRing();
+    ~IngestRing();
+
+    bool initialize(size_t slotCount = INGEST_RING_SLOTS);
+
+    // Producer side (BLE callback context)
+    bool push(DeviceId source, const uint8_t* data, size_t length);
+    bool pushEvent(DeviceId source, IngestSlotType type, const uint8_t* data = nullptr, size_t length = 0);
+
+    // Consumer side: peek at the oldest slot, then release it when done
+    const IngestSlot* front() const;
+    void pop();
+
+    // Status
+    size_t size() const;
+    size_t capacity() const { return slotCount > 0 ? slotCount - 1 - INGEST_RING_CONTROL_SLOTS : 0; }  // Notifications
+    uint32_t getDroppedCount() const { return droppedCount.load(std::memory_order_relaxed); }
+    uint32_t getHighWaterMark() const { return highWaterMark.load(std::memory_order_relaxed); }
+
+   private:
+    IngestSlot* slots;
+    size_t slotCount;
+
+    std::atomic<size_t> head;  // Next slot to write (producer owned)
+    std::atomic<size_t> tail;  // Next slot to read (consumer owned)
+    std::atomic<uint32_t> droppedCount;
+    std::atomic<uint32_t> highWaterMark;
+
+    bool write(DeviceId source, IngestSlotType type, const uint8_t* data, size_t length, size_t limit);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,152 @@
+#include "KnownDeviceCache.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Static member definitions
+KnownDevice KnownDeviceCache::entries[KNOWN_DEVICE_SLOTS];
+size_t KnownDeviceCache::count = 0;
+uint32_t KnownDeviceCache::useCounter = 0;
+bool KnownDeviceCache::initialized = false;
+Preferences KnownDeviceCache::preferences;
+portMUX_TYPE KnownDeviceCache::lock = portMUX_INITIALIZER_UNLOCKED;
+
+void KnownDeviceCache::initialize() {
+    if (initialized) {
+        return;
+    }
+
+    load();
+    initialized = true;
+    Serial.printf("Known device cache: %d devices\n", count);
+}
+
+bool KnownDeviceCache::find(const char* address, KnownDevice& device) {
+    portENTER_CRITICAL(&lock);
+    int index = indexOf(address);
+    if (index >= 0) {
+        device = entries[index];
+    }
+    portEXIT_CRITICAL(&lock);
+    return index >= 0;
+}
+
+bool KnownDeviceCache::contains(const char* address) {
+    portENTER_CRITICAL(&lock);
+    bool found = indexOf(address) >= 0;
+    portEXIT_CRITICAL(&lock);
+    return found;
+}
+
+void KnownDeviceCache::store(const KnownDevice& device) {
+    portENTER_CRITICAL(&lock);
+    int index = indexOf(device.address);
+    if (index < 0) {
+        if (count < KNOWN_DEVICE_SLOTS) {
+            index = count++;
+        } else {
+            // Replace the least recently used device
+            index = 0;
+            for (size_t i = 1; i < count; i++) {
+                if (entries[i].lastUsed < entries[index].lastUsed) {
+                    index = i;
+                }
+            }
+        }
+    }
+    entries[index] = device;
+    entries[index].lastUsed = ++useCounter;
+    portEXIT_CRITICAL(&lock);
+
+    save();
+}
+
+void KnownDeviceCache::invalidateHandles(const char* address) {
+    portENTER_CRITICAL(&lock);
+    int index = indexOf(address);
+    if (index >= 0) {
+        entries[index].logHandle = 0;
+        entries[index].cccdHandle = 0;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (index >= 0) {
+        Serial.printf("Cached GATT handles for %s invalidated\n", address);
+        save();
+    }
+}
+
+void KnownDeviceCache::clear() {
+    portENTER_CRITICAL(&lock);
+    count = 0;
+    portEXIT_CRITICAL(&lock);
+
+    preferences.begin("bt_known", false);
+    preferences.clear();
+    preferences.end();
+}
+
+bool KnownDeviceCache::getEntry(size_t index, KnownDevice& device) {
+    portENTER_CRITICAL(&lock);
+    bool valid = index < count;
+    if (valid) {
+        device = entries[index];
+    }
+    portEXIT_CRITICAL(&lock);
+    return valid;
+}
+
+int KnownDeviceCache::indexOf(const char* address) {
+    if (!address) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(entries[i].address, address) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void KnownDeviceCache::save() {
+    KnownDevice snapshot[KNOWN_DEVICE_SLOTS];
+    portENTER_CRITICAL(&lock);
+    size_t snapshotCount = count;
+    memcpy(snapshot, entries, sizeof(KnownDevice) * snapshotCount);
+    portEXIT_CRITICAL(&lock);
+
+    preferences.begin("bt_known", false);
+    preferences.putInt("version", KNOWN_DEVICE_CACHE_VERSION);
+    preferences.putUChar("count", snapshotCount);
+    size_t bytesWritten = preferences.putBytes("devices", snapshot, sizeof(KnownDevice) * snapshotCount);
+    preferences.end();
+
+    if (snapshotCount > 0 && bytesWritten != sizeof(KnownDevice) * snapshotCount) {
+        Serial.println("Failed to save known device cache");
+    }
+}
+
+void KnownDeviceCache::load() {
+    preferences.begin("bt_known", true);  // Read-only mode
+    int storedVersion = preferences.getInt("version", 0);
+    size_t storedCount = preferences.getUChar("count", 0);
+
+    count = 0;
+    if (storedVersion == KNOWN_DEVICE_CACHE_VERSION && storedCount > 0 && storedCount <= KNOWN_DEVICE_SLOTS) {
+        size_t expected = sizeof(KnownDevice) * storedCount;
+        if (preferences.getBytes("devices", entries, expected) == expected) {
+            count = storedCount;
+        }
+    }
+    preferences.end();
+
+    // Make sure strings are terminated and the use counter continues past stored values
+    for (size_t i = 0; i < count; i++) {
+        entries[i].address[DEVICE_ADDRESS_LENGTH - 1] = '\0';
+        entries[i].name[DEVICE_NAME_LENGTH - 1] = '\0';
+        useCounter = max(useCounter, entries[i].lastUsed);
+    }
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include "DeviceRegistry.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Known device cache configuration
+#define KNOWN_DEVICE_SLOTS 8
+#define KNOWN_DEVICE_CACHE_VERSION 1  // Bump when KnownDevice changes layout
+
+// A previously connected device and the GATT handles found for it
+struct KnownDevice {
+    char address[DEVICE_ADDRESS_LENGTH];
+    char name[DEVICE_NAME_LENGTH];
+    uint8_t addressType;
+    uint16_t logHandle;   // Log characteristic value handle
+    uint16_t cccdHandle;  // Its Client Characteristic Configuration descriptor
+    uint32_t lastUsed;    // Connect counter, the least recently used entry is replaced
+
+    bool hasHandles() const { return logHandle != 0 && cccdHandle != 0; }
+};
+
+/**
+ * KnownDeviceCache remembers devices we have connected to, persisted in NVS.
+ * Reconnects use it to recognise a node as soon as it advertises and to
+ * subscribe with the cached handles instead of running service discovery.
+ * Thread-safe; NVS writes happen outside the lock.
+ */
+class KnownDeviceCache {
+   public:
+    static void initialize();
+
+    static bool find(const char* address, KnownDevice& device);
+    static bool contains(const char* address);
+    static void store(const KnownDevice& device);
+    static void invalidateHandles(const char* address);
+    static void clear();
+
+    static size_t size() { return count; }
+    static bool getEntry(size_t index, KnownDevice& device);
+
+   private:
+    static KnownDevice entries[KNOWN_DEVICE_SLOTS];
+    static size_t count;
+    static uint32_t useCounter;
+    static bool initialized;
+    static Preferences preferences;
+    static portMUX_TYPE lock;
+
+    static int indexOf(const char* address);
+    static void save();
+    static void load();
+};
+
+}  // namespace Core
+}  // namespace BTLogger
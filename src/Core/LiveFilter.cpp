@@ -0,0 +1,135 @@
+#include "LiveFilter.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Static member definitions
+LiveFilter::Rules LiveFilter::staged = {0, LIVE_FILTER_DEVICES_ALL, 0, 0, true, ""};
+LiveFilter::Rules LiveFilter::active = {0, LIVE_FILTER_DEVICES_ALL, 0, 0, true, ""};
+SubstringMatcher LiveFilter::matcher;
+volatile bool LiveFilter::changed = false;
+uint32_t LiveFilter::rejected = 0;
+portMUX_TYPE LiveFilter::lock = portMUX_INITIALIZER_UNLOCKED;
+
+bool LiveFilter::accepts(const LogPacket& packet, DeviceId deviceId, const char* text) {
+    if (changed) {
+        compile();
+    }
+
+    // Cheapest checks first
+    uint64_t tagBit = packet.tagId != TAG_ID_OTHER && packet.tagId < TAG_REGISTRY_SLOTS ? (1ULL << packet.tagId) : 0;
+    bool pass = packet.level >= active.minLevel &&
+                (deviceId >= DEVICE_REGISTRY_SLOTS || (active.deviceMask & (1 << deviceId))) &&
+                !(active.denyTags & tagBit) &&
+                (!active.allowTags || (active.allowTags & tagBit)) &&
+                (matcher.isEmpty() || matcher.matches(text, strlen(text)));
+    if (!pass) {
+        rejected++;
+    }
+    return pass;
+}
+
+void LiveFilter::compile() {
+    portENTER_CRITICAL(&lock);
+    active = staged;
+    changed = false;
+    portEXIT_CRITICAL(&lock);
+
+    matcher.setPattern(active.text, active.ignoreCase);
+}
+
+void LiveFilter::setMinLevel(uint8_t level) {
+    portENTER_CRITICAL(&lock);
+    staged.minLevel = level;
+    changed = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+uint8_t LiveFilter::getMinLevel() {
+    return staged.minLevel;
+}
+
+void LiveFilter::setDeviceVisible(DeviceId id, bool visible) {
+    if (id >= DEVICE_REGISTRY_SLOTS) {
+        return;
+    }
+    portENTER_CRITICAL(&lock);
+    if (visible) {
+        staged.deviceMask |= (1 << id);
+    } else {
+        staged.deviceMask &= ~(1 << id);
+    }
+    changed = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+bool LiveFilter::isDeviceVisible(DeviceId id) {
+    return id >= DEVICE_REGISTRY_SLOTS || (staged.deviceMask & (1 << id));
+}
+
+void LiveFilter::setTagRule(TagId tagId, LiveTagRule rule) {
+    if (tagId == TAG_ID_OTHER || tagId >= TAG_REGISTRY_SLOTS) {
+        return;
+    }
+    uint64_t bit = 1ULL << tagId;
+    portENTER_CRITICAL(&lock);
+    staged.allowTags = rule == LIVE_TAG_ALLOW ? (staged.allowTags | bit) : (staged.allowTags & ~bit);
+    staged.denyTags = rule == LIVE_TAG_DENY ? (staged.denyTags | bit) : (staged.denyTags & ~bit);
+    changed = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+LiveTagRule LiveFilter::getTagRule(TagId tagId) {
+    if (tagId == TAG_ID_OTHER || tagId >= TAG_REGISTRY_SLOTS) {
+        return LIVE_TAG_ANY;
+    }
+    uint64_t bit = 1ULL << tagId;
+    portENTER_CRITICAL(&lock);
+    LiveTagRule rule = (staged.allowTags & bit) ? LIVE_TAG_ALLOW : (staged.denyTags & bit) ? LIVE_TAG_DENY : LIVE_TAG_ANY;
+    portEXIT_CRITICAL(&lock);
+    return rule;
+}
+
+void LiveFilter::setText(const char* text, bool ignoreCase) {
+    portENTER_CRITICAL(&lock);
+    strncpy(staged.text, text ? text : "", sizeof(staged.text) - 1);
+    staged.text[sizeof(staged.text) - 1] = '\0';
+    staged.ignoreCase = ignoreCase;
+    changed = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+String LiveFilter::getText() {
+    char text[SEARCH_TEXT_LENGTH];
+    portENTER_CRITICAL(&lock);
+    memcpy(text, staged.text, sizeof(text));
+    portEXIT_CRITICAL(&lock);
+    return String(text);
+}
+
+void LiveFilter::reset() {
+    portENTER_CRITICAL(&lock);
+    resetRules(staged);
+    changed = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+bool LiveFilter::isActive() {
+    portENTER_CRITICAL(&lock);
+    bool filtering = staged.minLevel > 0 || staged.deviceMask != LIVE_FILTER_DEVICES_ALL || staged.allowTags ||
+                     staged.denyTags || staged.text[0];
+    portEXIT_CRITICAL(&lock);
+    return filtering;
+}
+
+void LiveFilter::resetRules(Rules& rules) {
+    rules.minLevel = 0;
+    rules.deviceMask = LIVE_FILTER_DEVICES_ALL;
+    rules.allowTags = 0;
+    rules.denyTags = 0;
+    rules.ignoreCase = true;
+    rules.text[0] = '\0';
+}
+
+}  // namespace Core
+}  // namespace BTLogger
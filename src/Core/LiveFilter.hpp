@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include "DeviceRegistry.hpp"
+#include "LogProtocol.hpp"
+#include "SubstringMatcher.hpp"
+#include "TagRegistry.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Live filter configuration
+#define LIVE_FILTER_DEVICES_ALL 0xFFFF  // Bit per DeviceId (DEVICE_REGISTRY_SLOTS)
+
+enum LiveTagRule {
+    LIVE_TAG_ANY,    // Follows the allow list, if there is one
+    LIVE_TAG_ALLOW,  // Once any tag is allowed, only allowed tags pass
+    LIVE_TAG_DENY
+};
+
+/**
+ * LiveFilter decides which incoming records reach the realtime view and its
+ * toasts; storage always gets every record. Rules are a level threshold, tag
+ * allow/deny sets, a device mask and an optional message substring. Tag sets
+ * are bitmasks over TagRegistry ids, which every record carries from ingest,
+ * so a record costs no string work unless there is a substring to match;
+ * TAG_ID_OTHER has no rule of its own.
+ *
+ * Rules may be changed from any task. Changes are staged and picked up by the
+ * next accepts() on the communications task, which compiles them into the
+ * copy it matches against without holding the lock.
+ */
+class LiveFilter {
+   public:
+    // Called from the communications task only; text is the rendered message
+    static bool accepts(const LogPacket& packet, DeviceId deviceId, const char* text);
+
+    static void setMinLevel(uint8_t level);
+    static uint8_t getMinLevel();
+    static void setDeviceVisible(DeviceId id, bool visible);
+    static bool isDeviceVisible(DeviceId id);
+    static void setTagRule(TagId tagId, LiveTagRule rule);
+    static LiveTagRule getTagRule(TagId tagId);
+    static void setText(const char* text, bool ignoreCase = true);
+    static String getText();
+    static void reset();
+    static bool isActive();  // Anything filtered at all
+
+    static uint32_t getRejectedCount() { return rejected; }
+
+   private:
+    struct Rules {
+        uint8_t minLevel;
+        uint16_t deviceMask;
+        uint64_t allowTags;
+        uint64_t denyTags;
+        bool ignoreCase;
+        char text[SEARCH_TEXT_LENGTH];
+    };
+
+    static Rules staged;   // Written by setters under the lock
+    static Rules active;   // Communications task copy
+    static SubstringMatcher matcher;
+    static volatile bool changed;
+
+    static uint32_t rejected;
+    static portMUX_TYPE lock;
+
+    static void compile();
+    static void resetRules(Rules& rules);
+};
+
+static_assert(TAG_REGISTRY_SLOTS <= 64, "LiveFilter keeps tag rules in 64 bit masks");
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,353 @@
+#include "LogFileReader.hpp"
+#include <algorithm>
+
+namespace BTLogger {
+namespace Core {
+
+LogFileReader::LogFileReader()
+    : binary(false), fileSize(0), buffer(nullptr), bufferStart(0), bufferLength(0), bufferPos(0), blockStart(0),
+      lineIndex(0), indexedLines(0), reachedEnd(false), hasLevelTotals(false), pages(nullptr), lastPage(0) {
+}
+
+LogFileReader::~LogFileReader() {
+    close();
+    free(buffer);
+    buffer = nullptr;
+    free(pages);
+    pages = nullptr;
+}
+
+bool LogFileReader::open(const String& path) {
+    close();
+
+    file = SD.open(path, FILE_READ);
+    if (!file) {
+        Serial.printf("Failed to open file: %s\n", path.c_str());
+        return false;
+    }
+    fileSize = file.size();
+    binary = BinaryLogReader::isBinaryLog(file);
+
+    size_t dataStart = 0;
+    if (binary) {
+        if (!binaryReader.open(file)) {
+            close();
+            return false;
+        }
+        dataStart = binaryReader.getHeader().headerLength;
+        blockStart = 0;
+    } else {
+        if (!buffer) {
+            buffer = static_cast<uint8_t*>(malloc(LOG_READER_BLOCK_SIZE));
+            if (!buffer) {
+                Serial.println("Failed to allocate log reader buffer");
+                close();
+                return false;
+            }
+        }
+        bufferStart = 0;
+        bufferLength = 0;
+        bufferPos = 0;
+    }
+
+    checkpoints.clear();
+    checkpoints.push_back({(uint32_t)dataStart, 0});
+    lineIndex = 0;
+    indexedLines = 0;
+    reachedEnd = false;
+    loadIndex(path);
+    if (pages) {
+        for (uint8_t i = 0; i < LOG_READER_PAGE_COUNT; i++) {
+            pages[i].count = 0;
+        }
+    }
+    return true;
+}
+
+void LogFileReader::close() {
+    if (file) {
+        file.close();
+    }
+    checkpoints.clear();
+    checkpoints.shrink_to_fit();
+    timeMarks.clear();
+    timeMarks.shrink_to_fit();
+    hasLevelTotals = false;
+    fileSize = 0;
+}
+
+void LogFileReader::loadIndex(const String& path) {
+    std::vector<SessionIndexEntry> entries;
+    bool complete = false;
+    if (!SessionIndexWriter::load(path, entries, complete) || entries.empty()) {
+        return;
+    }
+
+    timeMarks.reserve(entries.size());
+    for (const SessionIndexEntry& entry : entries) {
+        // An index that doesn't fit this file is stale; use what agrees with it
+        if (entry.position > fileSize) {
+            complete = false;
+            break;
+        }
+        noteCheckpoint(entry.position, entry.line);
+        timeMarks.push_back({entry.timestamp, entry.line});
+    }
+
+    if (complete) {
+        const SessionIndexEntry& end = entries.back();
+        memcpy(levelTotals, end.levelCounts, sizeof(levelTotals));
+        hasLevelTotals = true;
+        indexedLines = end.line;
+        reachedEnd = true;
+    }
+    Serial.printf("Loaded index of %s: %d entries\n", path.c_str(), entries.size());
+}
+
+size_t LogFileReader::findLineAt(uint32_t timestamp) const {
+    // Last mark at or before the time
+    auto it = std::upper_bound(timeMarks.begin(), timeMarks.end(), timestamp,
+                               [](uint32_t value, const TimeMark& mark) { return value < mark.timestamp; });
+    return it == timeMarks.begin() ? 0 : (it - 1)->line;
+}
+
+bool LogFileReader::getLevelCounts(uint32_t counts[SESSION_INDEX_LEVELS]) const {
+    if (!hasLevelTotals) {
+        return false;
+    }
+    memcpy(counts, levelTotals, sizeof(levelTotals));
+    return true;
+}
+
+bool LogFileReader::nextLine(char* out, size_t capacity, size_t* length) {
+    size_t lineLength = 0;
+    if (!readLine(out, capacity, lineLength)) {
+        return false;
+    }
+    if (length) {
+        *length = lineLength;
+    }
+    return true;
+}
+
+const char* LogFileReader::getLine(size_t index) {
+    if (!pages) {
+        pages = static_cast<Page*>(malloc(sizeof(Page) * LOG_READER_PAGE_COUNT));
+        if (!pages) {
+            Serial.println("Failed to allocate log reader pages");
+            return nullptr;
+        }
+        for (uint8_t i = 0; i < LOG_READER_PAGE_COUNT; i++) {
+            pages[i].count = 0;
+        }
+    }
+
+    for (uint8_t i = 0; i < LOG_READER_PAGE_COUNT; i++) {
+        Page& page = pages[i];
+        if (page.count > 0 && index >= page.firstLine && index < page.firstLine + page.count) {
+            lastPage = i;
+            return page.text + page.offsets[index - page.firstLine];
+        }
+    }
+    if (!file || (reachedEnd && index >= indexedLines)) {
+        return nullptr;
+    }
+
+    // Replace the page not used last; start half a page early so scrolling back usually hits too
+    lastPage = (lastPage + 1) % LOG_READER_PAGE_COUNT;
+    Page& page = pages[lastPage];
+    size_t first = index - index % (LOG_READER_PAGE_LINES / 2);
+    if (!loadPage(page, first) || index >= page.firstLine + page.count) {
+        // Lines too long to reach index from the aligned start
+        if (!loadPage(page, index)) {
+            return nullptr;
+        }
+    }
+    return index < page.firstLine + page.count ? page.text + page.offsets[index - page.firstLine] : nullptr;
+}
+
+bool LogFileReader::indexAhead(size_t maxLines) {
+    if (!file || reachedEnd) {
+        return reachedEnd;
+    }
+    // Continue from the furthest point known
+    if (lineIndex < checkpoints.back().line && !reposition(checkpoints.back())) {
+        return false;
+    }
+    size_t length;
+    for (size_t i = 0; i < maxLines; i++) {
+        if (!readLine(nullptr, 0, length)) {
+            break;
+        }
+    }
+    return reachedEnd;
+}
+
+bool LogFileReader::readLine(char* out, size_t capacity, size_t& length) {
+    if (!file) {
+        return false;
+    }
+
+    if (binary) {
+        BinaryLogRecord record;
+        bool found = binaryReader.next(record);
+        lineIndex += binaryReader.takeFilteredRecords();
+        if (!found) {
+            reachedEnd = true;
+            indexedLines = lineIndex;
+            return false;
+        }
+        // The first record of each block is a place reading can restart from
+        if (binaryReader.getBlockStart() != blockStart) {
+            blockStart = binaryReader.getBlockStart();
+            noteCheckpoint(blockStart, lineIndex);
+        }
+        char line[LOG_READER_LINE_LENGTH];
+        length = BinaryLogReader::formatTextLine(record, line, sizeof(line));
+        if (length > 0 && line[length - 1] == '\n') {
+            line[--length] = '\0';
+        }
+        if (out && capacity > 0) {
+            length = min(length, capacity - 1);
+            memcpy(out, line, length);
+            out[length] = '\0';
+        }
+    } else {
+        size_t start;
+        if (!readTextLine(out, capacity, length, start)) {
+            reachedEnd = true;
+            indexedLines = lineIndex;
+            return false;
+        }
+        if (lineIndex % LOG_READER_CHECKPOINT_LINES == 0) {
+            noteCheckpoint(start, lineIndex);
+        }
+    }
+
+    lineIndex++;
+    indexedLines = max(indexedLines, lineIndex);
+    return true;
+}
+
+bool LogFileReader::readTextLine(char* out, size_t capacity, size_t& length, size_t& start) {
+    start = bufferStart + bufferPos;
+    size_t total = 0;
+    size_t copied = 0;
+
+    while (true) {
+        if (bufferPos >= bufferLength) {
+            bufferStart += bufferLength;
+            bufferLength = file.read(buffer, LOG_READER_BLOCK_SIZE);
+            bufferPos = 0;
+            if (bufferLength == 0) {
+                break;  // End of file; a last line without newline still counts
+            }
+        }
+
+        // Scan the buffer for the end of the line in one go
+        const uint8_t* begin = buffer + bufferPos;
+        const uint8_t* newline = static_cast<const uint8_t*>(memchr(begin, '\n', bufferLength - bufferPos));
+        size_t span = newline ? newline - begin : bufferLength - bufferPos;
+        for (size_t i = 0; i < span; i++) {
+            if (begin[i] == '\r') {
+                continue;
+            }
+            if (out && copied + 1 < capacity) {
+                out[copied++] = begin[i];
+            }
+            total++;
+        }
+        bufferPos += span;
+
+        if (newline) {
+            bufferPos++;
+            if (total > 0) {
+                break;
+            }
+            start = bufferStart + bufferPos;  // Empty lines are skipped
+        }
+    }
+
+    if (out && capacity > 0) {
+        out[copied] = '\0';
+    }
+    length = out ? copied : total;
+    return total > 0;
+}
+
+bool LogFileReader::seekLine(size_t line) {
+    if (!file) {
+        return false;
+    }
+    if (line == lineIndex) {
+        return true;
+    }
+
+    // Last checkpoint at or before line; jump there unless we are already closer
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), line,
+                               [](size_t value, const Checkpoint& checkpoint) { return value < checkpoint.line; });
+    const Checkpoint& checkpoint = *(it - 1);
+    if ((line < lineIndex || checkpoint.line > lineIndex) && !reposition(checkpoint)) {
+        return false;
+    }
+
+    size_t length;
+    while (lineIndex < line) {
+        if (!readLine(nullptr, 0, length)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LogFileReader::reposition(const Checkpoint& checkpoint) {
+    if (binary) {
+        if (!binaryReader.seek(checkpoint.position)) {
+            return false;
+        }
+        blockStart = checkpoint.position;  // Re-reading its block must not register it again
+    } else {
+        if (!file.seek(checkpoint.position)) {
+            return false;
+        }
+        bufferStart = checkpoint.position;
+        bufferLength = 0;
+        bufferPos = 0;
+    }
+    lineIndex = checkpoint.line;
+    return true;
+}
+
+void LogFileReader::noteCheckpoint(size_t position, size_t line) {
+    // Only lines past the end of the index add to it
+    if (line > checkpoints.back().line) {
+        checkpoints.push_back({(uint32_t)position, (uint32_t)line});
+    }
+}
+
+bool LogFileReader::loadPage(Page& page, size_t firstLine) {
+    page.count = 0;
+    if (!seekLine(firstLine)) {
+        return false;
+    }
+    page.firstLine = firstLine;
+
+    char line[LOG_READER_LINE_LENGTH];
+    size_t used = 0;
+    size_t length;
+    while (page.count < LOG_READER_PAGE_LINES) {
+        if (!readLine(line, sizeof(line), length)) {
+            break;
+        }
+        if (used + length + 1 > sizeof(page.text)) {
+            break;  // Page full; this line starts the next one
+        }
+        page.offsets[page.count++] = used;
+        memcpy(page.text + used, line, length + 1);
+        used += length + 1;
+    }
+    return page.count > 0;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
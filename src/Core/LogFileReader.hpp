@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+#include <vector>
+#include "BinaryLogFormat.hpp"
+#include "SessionIndex.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Streaming reader configuration
+#define LOG_READER_BLOCK_SIZE 4096       // Text files are read a block at a time
+#define LOG_READER_LINE_LENGTH 320       // Longer lines are truncated
+#define LOG_READER_CHECKPOINT_LINES 64   // Text lines between index checkpoints
+#define LOG_READER_PAGE_LINES 32
+#define LOG_READER_PAGE_BYTES 4096
+#define LOG_READER_PAGE_COUNT 2
+
+/**
+ * LogFileReader reads session files of either format as text lines without
+ * loading them. Lines come out in order from nextLine(), or by index from
+ * getLine(), which serves a small cache of pages. Seeking uses a sparse index
+ * of (file position, line) checkpoints built as the file is read, so RAM
+ * stays bounded whatever the file size. A sidecar index written with the file
+ * seeds that index, so seeking doesn't have to scan from the start. The pages
+ * are only allocated once getLine() is used. Use from a single task.
+ */
+class LogFileReader {
+   public:
+    LogFileReader();
+    ~LogFileReader();
+
+    bool open(const String& path);
+    void close();
+    bool isOpen() const { return (bool)file; }
+    bool isBinary() const { return binary; }
+    const BinaryLogFileHeader* getBinaryHeader() const { return binary ? &binaryReader.getHeader() : nullptr; }
+    size_t getFileSize() const { return fileSize; }
+
+    // Sequential reading; returns false at the end of the file
+    bool nextLine(char* out, size_t capacity, size_t* length = nullptr);
+    bool rewind() { return seekLine(0); }
+    bool seekLine(size_t line);
+    size_t getNextLineIndex() const { return lineIndex; }
+
+    // Binary files only: skip whole blocks without these levels/tags (see BinaryLogReader).
+    // Meant for sequential scans; nextLine() then jumps over the lines of skipped blocks.
+    void setBlockFilter(uint8_t levelMask, uint32_t tagBits) { binaryReader.setBlockFilter(levelMask, tagBits); }
+    uint32_t getFilteredBlocks() const { return binaryReader.getFilteredBlocks(); }
+
+    // Line by index (valid until the next call), nullptr past the end
+    const char* getLine(size_t index);
+
+    // Index up to maxLines further lines; returns true once the whole file is indexed
+    bool indexAhead(size_t maxLines);
+    bool isIndexed() const { return reachedEnd; }
+    size_t getLineCount() const { return indexedLines; }  // Exact once isIndexed()
+
+    // From the sidecar index: the line of the last entry at or before a record time (within
+    // SESSION_INDEX_BUCKET_MS of it), and per-level record totals of a closed file
+    size_t findLineAt(uint32_t timestamp) const;
+    uint32_t getStartTime() const { return timeMarks.empty() ? 0 : timeMarks.front().timestamp; }
+    bool getLevelCounts(uint32_t counts[SESSION_INDEX_LEVELS]) const;
+
+   private:
+    struct Checkpoint {
+        uint32_t position;  // Text: line start; binary: block start
+        uint32_t line;
+    };
+
+    struct Page {
+        size_t firstLine;
+        uint16_t count;
+        uint16_t offsets[LOG_READER_PAGE_LINES];
+        char text[LOG_READER_PAGE_BYTES];
+    };
+
+    File file;
+    bool binary;
+    size_t fileSize;
+
+    // Text block buffer
+    uint8_t* buffer;
+    size_t bufferStart;  // File position of buffer[0]
+    size_t bufferLength;
+    size_t bufferPos;
+
+    BinaryLogReader binaryReader;
+    size_t blockStart;
+
+    std::vector<Checkpoint> checkpoints;
+
+    struct TimeMark {
+        uint32_t timestamp;
+        uint32_t line;
+    };
+    std::vector<TimeMark> timeMarks;
+    uint32_t levelTotals[SESSION_INDEX_LEVELS];
+    bool hasLevelTotals;
+    size_t lineIndex;     // Index of the line nextLine() returns next
+    size_t indexedLines;
+    bool reachedEnd;
+
+    Page* pages;  // LOG_READER_PAGE_COUNT, allocated on first getLine()
+    uint8_t lastPage;
+
+    bool readLine(char* out, size_t capacity, size_t& length);
+    bool readTextLine(char* out, size_t capacity, size_t& length, size_t& start);
+    bool reposition(const Checkpoint& checkpoint);
+    void noteCheckpoint(size_t position, size_t line);
+    bool loadPage(Page& page, size_t firstLine);
+    void loadIndex(const String& path);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,18 @@
+#include "LogLineFormat.hpp"
+#include "FormatDictionary.hpp"
+#include <stdio.h>
+
+namespace BTLogger {
+namespace Core {
+
+size_t LogLineFormat::format(const LogPacket& packet, char* line, size_t capacity) {
+    // Tokenized records are rendered here
+    char rendered[sizeof(LogPacket::message)];
+    const char* message = FormatDictionary::messageText(packet, rendered, sizeof(rendered));
+    int length = snprintf(line, capacity, "%lu.%03u%03u,%u,%s,%s\n", (unsigned long)(packet.timestamp / 1000),
+                          (unsigned)(packet.timestamp % 1000), (unsigned)packet.micros, packet.level, packet.tag, message);
+    return length <= 0 ? 0 : min((size_t)length, capacity - 1);
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "LogProtocol.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+#define LOG_LINE_MAX_LENGTH (sizeof(LogPacket::message) + sizeof(LogPacket::tag) + 32)  // Terminator included
+
+/**
+ * LogLineFormat writes one record as a line of a text session file:
+ *   seconds.millismicros,level,tag,message
+ * Tokenized records are rendered first. Portable, so the host bench runs it.
+ */
+class LogLineFormat {
+   public:
+    // Characters written (terminated, newline included); 0 if nothing fit
+    static size_t format(const LogPacket& packet, char* line, size_t capacity);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
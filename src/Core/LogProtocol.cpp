@@ -0,0 +1,369 @@
+#include "LogProtocol.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+WireFormat LogProtocol::decode(const uint8_t* data, size_t length, const PacketHandler& onPacket,
+                               const DictionaryHandler& onDictionary, const SyncHandler& onSync,
+                               const SequenceHandler& onSequence) {
+    if (!data || length == 0) {
+        return WireFormat::INVALID;
+    }
+
+    // Compact frames are identified by their magic byte and a known version
+    if (length >= sizeof(WireFrameHeader) && data[0] == BTLOGGER_WIRE_MAGIC &&
+        data[1] >= 1 && data[1] <= BTLOGGER_WIRE_VERSION) {
+        if (decodeCompact(data, length, onPacket, onDictionary, onSync, onSequence)) {
+            return WireFormat::COMPACT;
+        }
+    }
+
+    // Fall back to the legacy fixed struct (a legacy timestamp may start with the magic byte)
+    LogPacket packet;
+    if (decodeLegacy(data, length, packet)) {
+        if (onPacket) {
+            onPacket(packet);
+        }
+        return WireFormat::LEGACY;
+    }
+
+    return WireFormat::INVALID;
+}
+
+size_t LogProtocol::encodeHello(uint8_t* buffer, size_t capacity) {
+    if (!buffer || capacity < 4) {
+        return 0;
+    }
+
+    // Older senders only read the first three bytes
+    buffer[0] = BTLOGGER_WIRE_MAGIC;
+    buffer[1] = WIRE_CTRL_HELLO;
+    buffer[2] = BTLOGGER_WIRE_VERSION;
+    buffer[3] = WIRE_FEATURE_COMPRESSION;
+    return 4;
+}
+
+size_t LogProtocol::encodeSyncRequest(uint8_t* buffer, size_t capacity, uint8_t sequence) {
+    if (!buffer || capacity < 3) {
+        return 0;
+    }
+
+    buffer[0] = BTLOGGER_WIRE_MAGIC;
+    buffer[1] = WIRE_CTRL_SYNC;
+    buffer[2] = sequence;
+    return 3;
+}
+
+size_t LogProtocol::encodeResendRequest(uint8_t* buffer, size_t capacity, uint16_t firstSequence, uint16_t count) {
+    if (!buffer || capacity < 6) {
+        return 0;
+    }
+
+    buffer[0] = BTLOGGER_WIRE_MAGIC;
+    buffer[1] = WIRE_CTRL_RESEND;
+    memcpy(buffer + 2, &firstSequence, sizeof(firstSequence));
+    memcpy(buffer + 4, &count, sizeof(count));
+    return 6;
+}
+
+size_t LogProtocol::encodeFlow(uint8_t* buffer, size_t capacity, uint8_t minLevel, uint16_t rate) {
+    if (!buffer || capacity < 5) {
+        return 0;
+    }
+
+    buffer[0] = BTLOGGER_WIRE_MAGIC;
+    buffer[1] = WIRE_CTRL_FLOW;
+    buffer[2] = minLevel;
+    memcpy(buffer + 3, &rate, sizeof(rate));
+    return 5;
+}
+
+size_t LogProtocol::encodeLevel(uint8_t* buffer, size_t capacity, const char* tag, uint8_t level) {
+    size_t tagLength = tag ? strnlen(tag, sizeof(LogPacket::tag) - 1) : 0;
+    if (!buffer || capacity < 4 + tagLength) {
+        return 0;
+    }
+
+    buffer[0] = BTLOGGER_WIRE_MAGIC;
+    buffer[1] = WIRE_CTRL_LEVEL;
+    buffer[2] = level;
+    buffer[3] = tagLength;
+    memcpy(buffer + 4, tag, tagLength);
+    return 4 + tagLength;
+}
+
+bool LogProtocol::isCompressed(const uint8_t* data, size_t length) {
+    return data && length >= sizeof(WireFrameHeader) + 3 && data[0] == BTLOGGER_WIRE_MAGIC &&
+           data[2] == WIRE_FRAME_COMPRESSED;
+}
+
+size_t LogProtocol::getExpandedLength(const uint8_t* data, size_t length) {
+    if (!isCompressed(data, length)) {
+        return length;
+    }
+    uint16_t rawLength;
+    memcpy(&rawLength, data + sizeof(WireFrameHeader) + 1, sizeof(rawLength));
+    return sizeof(WireFrameHeader) + rawLength;
+}
+
+bool LogProtocol::decodeCompact(const uint8_t* data, size_t length, const PacketHandler& onPacket,
+                                const DictionaryHandler& onDictionary, const SyncHandler& onSync,
+                                const SequenceHandler& onSequence) {
+    WireFrameHeader frame;
+    memcpy(&frame, data, sizeof(frame));
+    size_t offset = sizeof(WireFrameHeader);
+    bool sequenced = frame.version >= BTLOGGER_WIRE_SEQUENCE_VERSION;
+    uint16_t firstSequence = 0;
+
+    if (frame.type == WIRE_FRAME_RECORD) {
+        if (sequenced) {
+            if (length < offset + sizeof(firstSequence)) {
+                return false;
+            }
+            memcpy(&firstSequence, data + offset, sizeof(firstSequence));
+            offset += sizeof(firstSequence);
+        }
+
+        // The frame must contain exactly one record, nothing more and nothing less
+        LogPacket packet;
+        if (!readRecord(data, length, offset, &packet) || offset != length) {
+            return false;
+        }
+        if (sequenced && onSequence) {
+            onSequence(WIRE_FRAME_RECORD, firstSequence, 1);
+        }
+        if (onPacket) {
+            onPacket(packet);
+        }
+        return true;
+    }
+
+    if (frame.type == WIRE_FRAME_COMPRESSED) {
+        if (frame.version < BTLOGGER_WIRE_BATCH_VERSION || length < offset + 3) {
+            return false;
+        }
+        uint8_t innerType = data[offset];
+        uint16_t rawLength;
+        memcpy(&rawLength, data + offset + 1, sizeof(rawLength));
+        if (innerType == WIRE_FRAME_COMPRESSED || rawLength == 0 || rawLength > WIRE_COMPRESS_MAX_RAW) {
+            return false;
+        }
+
+        // Rebuild the inner frame and decode it like any other
+        uint8_t expanded[sizeof(WireFrameHeader) + WIRE_COMPRESS_MAX_RAW];
+        expanded[0] = frame.magic;
+        expanded[1] = frame.version;
+        expanded[2] = innerType;
+        if (!decompress(data + offset + 3, length - offset - 3, expanded + sizeof(WireFrameHeader), rawLength)) {
+            return false;
+        }
+        return decodeCompact(expanded, sizeof(WireFrameHeader) + rawLength, onPacket, onDictionary, onSync, onSequence);
+    }
+
+    if (frame.type == WIRE_FRAME_SYNC) {
+        if (frame.version < BTLOGGER_WIRE_SYNC_VERSION || length != offset + sizeof(WireSyncReply)) {
+            return false;
+        }
+        WireSyncReply reply;
+        memcpy(&reply, data + offset, sizeof(reply));
+        if (onSync) {
+            onSync(reply);
+        }
+        return true;
+    }
+
+    if (frame.type == WIRE_FRAME_DICT) {
+        if (frame.version < BTLOGGER_WIRE_TOKEN_VERSION || length < offset + 3) {
+            return false;
+        }
+        uint16_t formatId;
+        memcpy(&formatId, data + offset, sizeof(formatId));
+        uint8_t formatLength = data[offset + 2];
+        if (offset + 3 + formatLength != length) {
+            return false;
+        }
+        if (onDictionary) {
+            onDictionary(formatId, reinterpret_cast<const char*>(data + offset + 3), formatLength);
+        }
+        return true;
+    }
+
+    if (frame.type == WIRE_FRAME_LOST) {
+        uint16_t count;
+        if (!sequenced || length != offset + sizeof(firstSequence) + sizeof(count)) {
+            return false;
+        }
+        memcpy(&firstSequence, data + offset, sizeof(firstSequence));
+        memcpy(&count, data + offset + sizeof(firstSequence), sizeof(count));
+        if (onSequence) {
+            onSequence(WIRE_FRAME_LOST, firstSequence, count);
+        }
+        return true;
+    }
+
+    // A RESEND frame is a batch of records sent again
+    bool resend = frame.type == WIRE_FRAME_RESEND && sequenced;
+    if ((frame.type != WIRE_FRAME_BATCH && !resend) || frame.version < BTLOGGER_WIRE_BATCH_VERSION ||
+        length < offset + 1 + (sequenced ? sizeof(firstSequence) : 0)) {
+        return false;
+    }
+
+    uint8_t count = data[offset++];
+    if (count == 0) {
+        return false;
+    }
+    if (sequenced) {
+        memcpy(&firstSequence, data + offset, sizeof(firstSequence));
+        offset += sizeof(firstSequence);
+    }
+
+    // Validate the whole batch before emitting anything so a corrupt frame is dropped as a unit
+    size_t recordsStart = offset;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!readRecord(data, length, offset, nullptr)) {
+            return false;
+        }
+    }
+    if (offset != length) {
+        return false;
+    }
+
+    if (sequenced && onSequence) {
+        onSequence((WireFrameType)frame.type, firstSequence, count);
+    }
+
+    offset = recordsStart;
+    LogPacket packet;
+    for (uint8_t i = 0; i < count; i++) {
+        readRecord(data, length, offset, &packet);
+        if (onPacket) {
+            onPacket(packet);
+        }
+    }
+    return true;
+}
+
+bool LogProtocol::decompress(const uint8_t* data, size_t length, uint8_t* output, size_t outputLength) {
+    static const char dictionary[] = WIRE_COMPRESS_DICTIONARY;
+    const size_t dictionaryLength = sizeof(dictionary) - 1;
+
+    // Extended lengths continue while the byte is 255
+    auto readLength = [&](size_t& offset, size_t& value) {
+        uint8_t byte;
+        do {
+            if (offset >= length) {
+                return false;
+            }
+            byte = data[offset++];
+            value += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    size_t offset = 0;
+    size_t written = 0;
+    while (offset < length) {
+        uint8_t token = data[offset++];
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(offset, literalLength)) {
+            return false;
+        }
+        if (offset + literalLength > length || written + literalLength > outputLength) {
+            return false;
+        }
+        memcpy(output + written, data + offset, literalLength);
+        offset += literalLength;
+        written += literalLength;
+
+        if (offset == length) {
+            break;  // Last sequence carries literals only
+        }
+
+        if (offset + 2 > length) {
+            return false;
+        }
+        size_t distance = data[offset] | (data[offset + 1] << 8);
+        offset += 2;
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(offset, matchLength)) {
+            return false;
+        }
+        matchLength += 4;
+        if (distance == 0 || distance > written + dictionaryLength || written + matchLength > outputLength) {
+            return false;
+        }
+
+        // Byte by byte: a match may overlap its own output or start in the dictionary
+        for (size_t i = 0; i < matchLength; i++, written++) {
+            output[written] = distance > written ? dictionary[dictionaryLength + written - distance]
+                                                 : output[written - distance];
+        }
+    }
+    return written == outputLength;
+}
+
+bool LogProtocol::readRecord(const uint8_t* data, size_t length, size_t& offset, LogPacket* packet) {
+    if (length < offset + sizeof(WireRecordHeader)) {
+        return false;
+    }
+
+    WireRecordHeader record;
+    memcpy(&record, data + offset, sizeof(record));
+    size_t bodyOffset = offset + sizeof(WireRecordHeader);
+
+    if (bodyOffset + record.tagLength + record.messageLength > length) {
+        return false;
+    }
+    if (record.tagLength > sizeof(LogPacket::tag) - 1 || record.messageLength > sizeof(LogPacket::message) - 1) {
+        return false;
+    }
+
+    if (packet) {
+        packet->timestamp = record.timestamp;
+        packet->level = record.level;
+        packet->length = record.messageLength;
+        packet->flags = record.flags;
+
+        memcpy(packet->tag, data + bodyOffset, record.tagLength);
+        packet->tag[record.tagLength] = '\0';
+
+        memcpy(packet->message, data + bodyOffset + record.tagLength, record.messageLength);
+        packet->message[record.messageLength] = '\0';
+    }
+
+    offset = bodyOffset + record.tagLength + record.messageLength;
+    return true;
+}
+
+bool LogProtocol::decodeLegacy(const uint8_t* data, size_t length, LogPacket& packet) {
+    if (length < LEGACY_PACKET_SIZE) {
+        return false;
+    }
+
+    memcpy(static_cast<void*>(&packet), data, LEGACY_PACKET_SIZE);
+    packet.flags = 0;
+
+    // Validate packet
+    if (packet.length > sizeof(packet.message) - 1) {
+        return false;
+    }
+
+    // Ensure null termination
+    packet.message[packet.length] = '\0';
+    packet.tag[sizeof(packet.tag) - 1] = '\0';
+    return true;
+}
+
+LogCompressor::LogCompressor(size_t maxInput)
+    : work(static_cast<uint8_t*>(malloc(BTLOGGER_COMPRESS_WORK_SIZE(maxInput)))),
+      table(static_cast<uint16_t*>(malloc(sizeof(uint16_t) << WIRE_COMPRESS_HASH_BITS))),
+      compressor(work, table, maxInput, WIRE_COMPRESS_HASH_BITS) {}
+
+LogCompressor::~LogCompressor() {
+    free(work);
+    free(table);
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include "../../BTLoggerWire.hpp"
+#include <stddef.h>
+#include <functional>
+
+namespace BTLogger {
+namespace Core {
+
+// Log packet structure for communication (legacy fixed-size wire format)
+struct LogPacket {
+    uint32_t timestamp;
+    uint8_t level;  // 0=VERBOSE, 1=DEBUG, 2=INFO, 3=WARN, 4=ERROR
+    uint16_t length;
+    char message[256];
+    char tag[32];
+    uint8_t flags;  // WIRE_RECORD_FLAG_* from compact records; not part of the legacy wire layout
+    uint16_t micros;  // Sub-millisecond part of timestamp once mapped by ClockSync (0-999)
+    uint32_t receivedUs;  // Low 32 bits of ClockSync::now() at BLE receive, for latency metrics
+    uint8_t tagId;  // TagRegistry id of tag, set at ingest (0 until then)
+
+    LogPacket() : timestamp(0), level(0), length(0), flags(0), micros(0), receivedUs(0), tagId(0) {
+        message[0] = '\0';
+        tag[0] = '\0';
+    }
+};
+
+/*
+ * Compact wire format (BTLoggerWire.hpp holds what the senders share with us)
+ *
+ * Every notification in the compact format starts with a frame header:
+ *   [magic:1][version:1][type:1]
+ * A RECORD frame carries one length-prefixed record:
+ *   [timestamp:4][level:1][flags:1][tagLength:1][messageLength:2][tag...][message...]
+ * A BATCH frame (version 2+) packs several records into one notification:
+ *   [count:1][record][record]...
+ * A DICT frame (version 3+) defines a format string for tokenized records:
+ *   [formatId:2][formatLength:1][format...]
+ * A COMPRESSED frame (only after BTLogger offered WIRE_FEATURE_COMPRESSION) wraps
+ * the body of another frame in an LZ4-style block whose matches may reach back
+ * into WIRE_COMPRESS_DICTIONARY:
+ *   [innerType:1][rawLength:2][token][literal length...][literals][offset:2][match length...]...
+ * All integers are little-endian, strings are not NUL terminated.
+ * Record flags: REPLAYED marks a record the sender held in its offline backlog;
+ * its timestamp is the original one, not the time of delivery. TOKENIZED marks a
+ * message made of [formatId:2][args...] instead of text, rendered on the receiver.
+ * Arguments follow the conversions of the format in order: d i o u x X c p and
+ * '*' widths/precisions as 4 bytes (8 with ll or j), floating point as an 8 byte
+ * double, s as [length:1][bytes]. A format id stays valid until the sender disconnects.
+ * RESENT marks a record delivered late in answer to a resend request.
+ *
+ * Negotiation: after subscribing, BTLogger writes a HELLO control message
+ *   [magic:1][WIRE_CTRL_HELLO:1][maxVersion:1][features:1]
+ * to the log characteristic. Senders that understand it switch to the compact
+ * format; older senders ignore it and keep sending the legacy LogPacket.
+ *
+ * Clock sync (version 4+): BTLogger writes [magic:1][WIRE_CTRL_SYNC:1][sequence:1]
+ * and the sender answers at once with a SYNC frame
+ *   [sequence:1][senderMicros:8][unixMillis:8]
+ * senderMicros is the esp_timer clock its record timestamps are the milliseconds
+ * of; unixMillis is its wall clock, 0 if it has never been set.
+ *
+ * Sequencing (version 5+): records are numbered per connection from 0, modulo
+ * 2^16. RECORD frames become [sequence:2][record] and BATCH frames
+ * [count:1][firstSequence:2][record]..., the records of a batch numbered in order.
+ * BTLogger asks for records it missed with [magic:1][WIRE_CTRL_RESEND:1][firstSequence:2][count:2];
+ * the sender answers with RESEND frames, laid out like a batch and flagged RESENT,
+ * for what it still has and a LOST frame [firstSequence:2][count:2] for what it has not.
+ *
+ * Flow and level control (version 6+): BTLogger writes
+ *   [magic:1][WIRE_CTRL_FLOW:1][minLevel:1][rate:2]
+ * when it is falling behind or has caught up. The sender drops records below
+ * minLevel at the source, and sends at most rate records per second below WARN
+ * (0 for no limit). WARN and ERROR are never held back by rate.
+ *   [magic:1][WIRE_CTRL_LEVEL:1][level:1][tagLength:1][tag...]
+ * sets the sender's level for one tag, or for everything with an empty tag;
+ * WIRE_LEVEL_CLEAR removes a tag's own level again.
+ */
+#define BTLOGGER_WIRE_VERSION 6  // Newest we speak; the first version of each feature is in BTLoggerWire.hpp
+#define WIRE_LEVEL_CLEAR 0xFF
+
+enum WireFrameType : uint8_t {
+    WIRE_FRAME_RECORD = 0x01,
+    WIRE_FRAME_BATCH = 0x02,
+    WIRE_FRAME_DICT = 0x03,
+    WIRE_FRAME_COMPRESSED = 0x04,
+    WIRE_FRAME_SYNC = 0x05,
+    WIRE_FRAME_RESEND = 0x06,
+    WIRE_FRAME_LOST = 0x07
+};
+
+enum WireControlOp : uint8_t {
+    WIRE_CTRL_HELLO = 0x01,
+    WIRE_CTRL_SYNC = 0x02,
+    WIRE_CTRL_RESEND = 0x03,
+    WIRE_CTRL_FLOW = 0x04,
+    WIRE_CTRL_LEVEL = 0x05
+};
+
+// Optional capabilities offered in the HELLO features byte
+enum WireFeature : uint8_t {
+    WIRE_FEATURE_COMPRESSION = 0x01
+};
+
+// Shared by every compressing sender - changing it breaks old firmware
+#define WIRE_COMPRESS_DICTIONARY BTLOGGER_COMPRESS_DICTIONARY
+#define WIRE_COMPRESS_MAX_RAW BTLOGGER_COMPRESS_MAX_INPUT
+#define WIRE_COMPRESS_HASH_BITS 10  // LogCompressor's match table, 2 bytes per slot
+
+enum WireRecordFlag : uint8_t {
+    WIRE_RECORD_FLAG_REPLAYED = 0x01,
+    WIRE_RECORD_FLAG_TOKENIZED = 0x02,
+    WIRE_RECORD_FLAG_RESENT = 0x04
+};
+
+// Bytes of LogPacket sent by legacy senders (everything before flags)
+static const size_t LEGACY_PACKET_SIZE = offsetof(LogPacket, flags);
+
+struct __attribute__((packed)) WireFrameHeader {
+    uint8_t magic;
+    uint8_t version;
+    uint8_t type;
+};
+
+struct __attribute__((packed)) WireRecordHeader {
+    uint32_t timestamp;
+    uint8_t level;
+    uint8_t flags;  // WireRecordFlag bits, 0 in version 1
+    uint8_t tagLength;
+    uint16_t messageLength;
+};
+
+struct __attribute__((packed)) WireSyncReply {
+    uint8_t sequence;
+    uint64_t senderMicros;
+    uint64_t unixMillis;
+};
+
+// Largest compact frame a sender will produce for a single record, its sequence number included
+static const size_t WIRE_MAX_RECORD_FRAME = sizeof(WireFrameHeader) + sizeof(uint16_t) + sizeof(WireRecordHeader) +
+                                            (sizeof(LogPacket::tag) - 1) + (sizeof(LogPacket::message) - 1);
+
+enum class WireFormat : uint8_t {
+    INVALID,
+    LEGACY,
+    COMPACT
+};
+
+/**
+ * LogProtocol encodes control messages and decodes incoming log notifications
+ * in either the compact or the legacy fixed-size format
+ */
+class LogProtocol {
+   public:
+    using PacketHandler = std::function<void(const LogPacket&)>;
+    using DictionaryHandler = std::function<void(uint16_t formatId, const char* format, size_t length)>;
+    using SyncHandler = std::function<void(const WireSyncReply& reply)>;
+    // Records a RECORD, BATCH or RESEND frame carries (before its records are passed on),
+    // or that a LOST frame says are gone
+    using SequenceHandler = std::function<void(WireFrameType type, uint16_t firstSequence, uint16_t count)>;
+
+    // Decode one notification, calling onPacket for every record it carries, onDictionary
+    // for a format definition, onSync for a clock sync reply and onSequence for the record
+    // numbers of a version 5 frame; returns the detected format
+    static WireFormat decode(const uint8_t* data, size_t length, const PacketHandler& onPacket,
+                             const DictionaryHandler& onDictionary = nullptr, const SyncHandler& onSync = nullptr,
+                             const SequenceHandler& onSequence = nullptr);
+
+    // Build the HELLO control message advertising our highest wire version and features
+    static size_t encodeHello(uint8_t* buffer, size_t capacity);
+    static size_t encodeSyncRequest(uint8_t* buffer, size_t capacity, uint8_t sequence);
+    static size_t encodeResendRequest(uint8_t* buffer, size_t capacity, uint16_t firstSequence, uint16_t count);
+    static size_t encodeFlow(uint8_t* buffer, size_t capacity, uint8_t minLevel, uint16_t rate);
+    static size_t encodeLevel(uint8_t* buffer, size_t capacity, const char* tag, uint8_t level);
+
+    // Bytes a notification stands for once decompressed (its own length if not compressed)
+    static size_t getExpandedLength(const uint8_t* data, size_t length);
+    static bool isCompressed(const uint8_t* data, size_t length);
+
+    // Expand one LZ block (matches may reach into WIRE_COMPRESS_DICTIONARY) to exactly outputLength bytes
+    static bool decompress(const uint8_t* data, size_t length, uint8_t* output, size_t outputLength);
+
+   private:
+    static bool decodeCompact(const uint8_t* data, size_t length, const PacketHandler& onPacket,
+                              const DictionaryHandler& onDictionary, const SyncHandler& onSync,
+                              const SequenceHandler& onSequence);
+    static bool readRecord(const uint8_t* data, size_t length, size_t& offset, LogPacket* packet);
+    static bool decodeLegacy(const uint8_t* data, size_t length, LogPacket& packet);
+};
+
+/**
+ * LogCompressor writes the LZ block LogProtocol::decompress() reads, with
+ * the shared dictionary in front, for what BTLogger itself sends on (the
+ * network relay). It is the senders' BTLoggerCompressor on buffers allocated
+ * once, with a larger match table; one instance per task.
+ */
+class LogCompressor {
+   public:
+    explicit LogCompressor(size_t maxInput);
+    ~LogCompressor();
+
+    bool isReady() const { return work && table; }
+
+    // Bytes written to output; 0 if input is too long or output too small
+    size_t compress(const uint8_t* input, size_t length, uint8_t* output, size_t capacity) {
+        return isReady() ? compressor.compress(input, length, output, capacity) : 0;
+    }
+
+   private:
+    uint8_t* work;
+    uint16_t* table;
+    BTLoggerCompressor compressor;
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,200 @@
+#include "LogSearch.hpp"
+#include "BinaryLogFormat.hpp"
+#include <ctype.h>
+
+namespace BTLogger {
+namespace Core {
+
+// Lines processed between budget checks
+static const int SEARCH_LINES_PER_CHECK = 32;
+
+LogSearch::LogSearch() : fileIndex(0), running(false), fileOpen(false), indexPosition(0), hits(0), linesScanned(0), skipped(0) {
+    memset(&query, 0, sizeof(query));
+}
+
+bool LogSearch::start(const SearchQuery& newQuery, const std::vector<String>& fileList) {
+    cancel();
+
+    query = newQuery;
+    query.tag[sizeof(query.tag) - 1] = '\0';
+    query.device[sizeof(query.device) - 1] = '\0';
+    query.text[sizeof(query.text) - 1] = '\0';
+    if (query.levelMask == 0) {
+        query.levelMask = SEARCH_LEVEL_ALL;
+    }
+    matcher.setPattern(query.text, query.ignoreCase);
+
+    files.clear();
+    for (const String& path : fileList) {
+        if (query.device[0] && !isDeviceFile(path)) {
+            continue;
+        }
+        files.push_back(path);
+    }
+
+    fileIndex = 0;
+    hits = 0;
+    linesScanned = 0;
+    skipped = 0;
+    running = true;
+    Serial.printf("Search %lu: %d files\n", (unsigned long)query.id, files.size());
+    return true;
+}
+
+void LogSearch::cancel() {
+    closeFile();
+    running = false;
+}
+
+bool LogSearch::step(uint32_t budgetMs) {
+    unsigned long start = millis();
+    char line[LOG_READER_LINE_LENGTH];
+    size_t length;
+
+    while (running && millis() - start < budgetMs) {
+        if (!fileOpen && !openNextFile()) {
+            running = false;
+            break;
+        }
+
+        for (int i = 0; i < SEARCH_LINES_PER_CHECK; i++) {
+            if (!index.empty()) {
+                skipIndexedRanges();
+            }
+            if (!reader.nextLine(line, sizeof(line), &length)) {
+                skipped += reader.getFilteredBlocks();
+                closeFile();
+                break;
+            }
+            size_t lineNumber = reader.getNextLineIndex() - 1;  // Filtered blocks may have been passed
+            linesScanned++;
+
+            // Text files name their device in the header
+            if (line[0] == '#') {
+                if (query.device[0] && strncmp(line, "# Device: ", 10) == 0 && strcmp(line + 10, query.device) != 0) {
+                    closeFile();
+                    break;
+                }
+                continue;
+            }
+
+            uint8_t level;
+            if (!matchLine(line, length, level)) {
+                continue;
+            }
+            hits++;
+            if (hitCallback) {
+                SearchHit hit = {files[fileIndex - 1].c_str(), (uint32_t)lineNumber, level, line};
+                hitCallback(hit);
+            }
+            if (isLimitReached()) {
+                cancel();
+                break;
+            }
+        }
+    }
+    return running;
+}
+
+bool LogSearch::openNextFile() {
+    while (fileIndex < files.size()) {
+        const String& path = files[fileIndex++];
+        if (!reader.open(path)) {
+            continue;
+        }
+
+        if (reader.isBinary()) {
+            const BinaryLogFileHeader* header = reader.getBinaryHeader();
+            if (query.device[0] && header && strcmp(header->deviceName, query.device) != 0) {
+                reader.close();
+                continue;
+            }
+            size_t tagLength = strlen(query.tag);
+            reader.setBlockFilter(query.levelMask, tagLength ? BinaryBlockWriter::tagBit(query.tag, tagLength) : 0);
+        } else if (query.levelMask != SEARCH_LEVEL_ALL) {
+            // Level counts let whole stretches of a text file go unread
+            bool complete;
+            SessionIndexWriter::load(path, index, complete);
+            indexPosition = 0;
+        }
+        fileOpen = true;
+        return true;
+    }
+    return false;
+}
+
+void LogSearch::closeFile() {
+    if (fileOpen) {
+        reader.close();
+        fileOpen = false;
+    }
+    index.clear();
+}
+
+bool LogSearch::isDeviceFile(const String& path) const {
+    // Session files are named <device>_<time>..., with spaces and dots replaced
+    String name = path.substring(path.lastIndexOf('/') + 1);
+    String device = query.device;
+    device.replace(" ", "_");
+    device.replace(".", "_");
+    return name.startsWith(device + "_");
+}
+
+void LogSearch::skipIndexedRanges() {
+    while (indexPosition + 1 < index.size()) {
+        const SessionIndexEntry& from = index[indexPosition];
+        const SessionIndexEntry& to = index[indexPosition + 1];
+        size_t next = reader.getNextLineIndex();
+        if (next >= to.line) {
+            indexPosition++;
+            continue;
+        }
+        if (next != from.line) {
+            return;
+        }
+
+        bool wanted = false;
+        for (uint8_t level = 0; level < SESSION_INDEX_LEVELS; level++) {
+            if ((query.levelMask & (1 << level)) && to.levelCounts[level] != from.levelCounts[level]) {
+                wanted = true;
+                break;
+            }
+        }
+        if (wanted) {
+            return;
+        }
+        if (!reader.seekLine(to.line)) {
+            index.clear();  // Index doesn't match the file; read on without it
+            return;
+        }
+        skipped++;
+        indexPosition++;
+    }
+}
+
+bool LogSearch::matchLine(char* line, size_t length, uint8_t& level) {
+    // "seconds.micros,level,tag,message"
+    char* comma = strchr(line, ',');
+    if (!comma || comma[1] < '0' || comma[1] > '9' || comma[2] != ',') {
+        return false;
+    }
+    level = comma[1] - '0';
+    if (!(query.levelMask & (1 << level))) {
+        return false;
+    }
+
+    const char* tag = comma + 3;
+    const char* tagEnd = strchr(tag, ',');
+    if (!tagEnd) {
+        return false;
+    }
+    if (query.tag[0] && (strlen(query.tag) != (size_t)(tagEnd - tag) || strncmp(tag, query.tag, tagEnd - tag) != 0)) {
+        return false;
+    }
+
+    const char* message = tagEnd + 1;
+    return matcher.matches(message, line + length - message);
+}
+
+}  // namespace Core
+}  // namespace BTLogger
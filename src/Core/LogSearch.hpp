@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include "DeviceRegistry.hpp"
+#include "LogFileReader.hpp"
+#include "SessionIndex.hpp"
+#include "SubstringMatcher.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Search configuration
+#define SEARCH_TAG_LENGTH 32
+#define SEARCH_LEVEL_ALL 0x1F
+#define SEARCH_STEP_MS 15     // Storage task time slice per step
+#define SEARCH_MAX_HITS 500   // The job stops once this many are found
+
+// What to look for; filters left empty match everything (plain data, sent through the storage queue)
+struct SearchQuery {
+    uint32_t id;        // Set by CoreTaskManager::startSearch()
+    uint8_t levelMask;  // Bit per level, 1 << level
+    bool ignoreCase;    // Message text only
+    char tag[SEARCH_TAG_LENGTH];
+    char device[DEVICE_NAME_LENGTH];
+    char text[SEARCH_TEXT_LENGTH];
+};
+
+struct SearchHit {
+    const char* path;
+    uint32_t line;  // LogFileReader line number
+    uint8_t level;
+    const char* text;  // Whole line, "seconds,level,tag,message"
+};
+
+/**
+ * LogSearch runs a query over a list of session files a slice at a time,
+ * so the storage task can keep logging in between. Files of other devices
+ * are passed over by name, binary blocks by their level/tag summary and text
+ * file ranges by the level counts in the sidecar index. Hits go to the
+ * callback as they are found.
+ */
+class LogSearch {
+   public:
+    using HitCallback = std::function<void(const SearchHit& hit)>;
+
+    LogSearch();
+
+    void setHitCallback(HitCallback callback) { hitCallback = callback; }
+
+    bool start(const SearchQuery& query, const std::vector<String>& files);
+    bool step(uint32_t budgetMs);  // Returns true while there is more to do
+    void cancel();
+
+    bool isRunning() const { return running; }
+    uint32_t getId() const { return query.id; }
+    uint32_t getHits() const { return hits; }
+    bool isLimitReached() const { return hits >= SEARCH_MAX_HITS; }
+    size_t getFilesSearched() const { return fileIndex; }
+    size_t getFileCount() const { return files.size(); }
+    uint32_t getLinesScanned() const { return linesScanned; }
+    uint32_t getSkipped() const { return skipped; }  // Blocks and index ranges not read
+
+   private:
+    SearchQuery query;
+    SubstringMatcher matcher;
+    HitCallback hitCallback;
+    std::vector<String> files;
+    size_t fileIndex;
+    bool running;
+
+    LogFileReader reader;
+    bool fileOpen;
+    std::vector<SessionIndexEntry> index;
+    size_t indexPosition;
+
+    uint32_t hits;
+    uint32_t linesScanned;
+    uint32_t skipped;
+
+    bool openNextFile();
+    void closeFile();
+    bool isDeviceFile(const String& path) const;
+    void skipIndexedRanges();
+    bool matchLine(char* line, size_t length, uint8_t& level);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,185 @@
+#include "LogStore.hpp"
+#include <esp_heap_caps.h>
+#include "FormatDictionary.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+LogStore::LogStore()
+    : records(nullptr), recordCapacity(0), head(0), count(0), nextSequence(0),
+      arena(nullptr), arenaCapacity(0), arenaHead(0), arenaUsed(0),
+      inPsram(false), mutex(nullptr) {
+}
+
+LogStore::~LogStore() {
+    clear();  // Hands its devices' slots back to the registry
+    free(records);
+    free(arena);
+    if (mutex) {
+        vSemaphoreDelete(mutex);
+    }
+}
+
+bool LogStore::initialize(size_t maxRecords, size_t arenaBytes) {
+    if (records) {
+        return true;
+    }
+
+    bool hasPsram = psramFound();
+    if (maxRecords == 0) {
+        maxRecords = hasPsram ? LOG_STORE_PSRAM_RECORDS : LOG_STORE_RECORDS;
+    }
+    if (arenaBytes == 0) {
+        arenaBytes = hasPsram ? LOG_STORE_PSRAM_ARENA_BYTES : LOG_STORE_ARENA_BYTES;
+    }
+
+    mutex = xSemaphoreCreateMutex();
+    bool recordsInPsram = false;
+    bool arenaInPsram = false;
+    records = static_cast<StoredRecord*>(allocate(maxRecords * sizeof(StoredRecord), hasPsram, recordsInPsram));
+    arena = static_cast<uint8_t*>(allocate(arenaBytes, hasPsram, arenaInPsram));
+    if (!mutex || !records || !arena) {
+        Serial.printf("Failed to allocate log store (%d records, %d byte arena)\n", maxRecords, arenaBytes);
+        free(records);
+        free(arena);
+        records = nullptr;
+        arena = nullptr;
+        return false;
+    }
+
+    recordCapacity = maxRecords;
+    arenaCapacity = arenaBytes;
+    inPsram = recordsInPsram && arenaInPsram;
+
+    Serial.printf("Log store ready: %d records, %d KB arena in %s\n",
+                  recordCapacity, arenaCapacity / 1024, inPsram ? "PSRAM" : "internal RAM");
+    return true;
+}
+
+size_t LogStore::add(uint32_t timestamp, uint8_t level, DeviceId deviceId, TagId tagId, const char* message) {
+    if (!message) {
+        message = "";
+    }
+    return add(timestamp, level, deviceId, tagId, message, strnlen(message, LOG_STORE_MAX_MESSAGE), 0);
+}
+
+size_t LogStore::add(uint32_t timestamp, uint8_t level, DeviceId deviceId, TagId tagId, const char* message,
+                     size_t messageLength, uint8_t flags) {
+    if (!records) {
+        return 0;
+    }
+
+    if (!message) {
+        messageLength = 0;
+    }
+    messageLength = min(messageLength, min((size_t)LOG_STORE_MAX_MESSAGE, arenaCapacity));
+    size_t evicted = 0;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+
+    // Make room in both rings
+    while (count > 0 && (count == recordCapacity || arenaCapacity - arenaUsed < messageLength)) {
+        evictOldest();
+        evicted++;
+    }
+
+    StoredRecord& record = records[(head + count) % recordCapacity];
+    record.timestamp = timestamp;
+    record.level = level;
+    record.flags = flags;
+    record.deviceId = deviceId;
+    record.tagId = tagId;
+    record.arenaOffset = arenaHead;
+    record.messageLength = messageLength;
+
+    // Copy the message into the arena, wrapping at the end
+    size_t first = min(messageLength, arenaCapacity - arenaHead);
+    memcpy(arena + arenaHead, message, first);
+    memcpy(arena, message + first, messageLength - first);
+    arenaHead = (arenaHead + messageLength) % arenaCapacity;
+    arenaUsed += messageLength;
+
+    count++;
+    nextSequence++;
+    DeviceRegistry::addStoredRecords(deviceId, 1);
+
+    xSemaphoreGive(mutex);
+    return evicted;
+}
+
+void LogStore::clear() {
+    if (!records) {
+        return;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < count; i++) {
+        DeviceRegistry::addStoredRecords(records[(head + i) % recordCapacity].deviceId, -1);
+    }
+    head = 0;
+    count = 0;
+    arenaHead = 0;
+    arenaUsed = 0;
+    xSemaphoreGive(mutex);
+}
+
+bool LogStore::getRecord(size_t index, LogRecordView& view) const {
+    if (!records) {
+        return false;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (index >= count) {
+        xSemaphoreGive(mutex);
+        return false;
+    }
+
+    const StoredRecord& record = records[(head + index) % recordCapacity];
+    bool tokenized = record.flags & WIRE_RECORD_FLAG_TOKENIZED;
+    view.timestamp = record.timestamp;
+    view.sequence = nextSequence - count + index;
+    view.level = record.level;
+    view.deviceId = record.deviceId;
+    view.tagId = record.tagId;
+    view.deviceName = DeviceRegistry::getName(record.deviceId);
+    view.tag = TagRegistry::getName(record.tagId);
+    view.messageLength = record.messageLength;
+
+    size_t first = min((size_t)record.messageLength, arenaCapacity - record.arenaOffset);
+    memcpy(view.message, arena + record.arenaOffset, first);
+    memcpy(view.message + first, arena, record.messageLength - first);
+    view.message[record.messageLength] = '\0';
+
+    xSemaphoreGive(mutex);
+
+    // Tokenized records are formatted only now, when someone reads them
+    if (tokenized) {
+        char body[LOG_STORE_MAX_MESSAGE + 1];
+        memcpy(body, view.message, view.messageLength);
+        view.messageLength = FormatDictionary::render(body, view.messageLength, view.message, sizeof(view.message));
+    }
+    return true;
+}
+
+void LogStore::evictOldest() {
+    StoredRecord& oldest = records[head];
+    DeviceRegistry::addStoredRecords(oldest.deviceId, -1);
+    arenaUsed -= oldest.messageLength;
+    head = (head + 1) % recordCapacity;
+    count--;
+}
+
+void* LogStore::allocate(size_t bytes, bool preferPsram, bool& placedInPsram) {
+    if (preferPsram) {
+        void* memory = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (memory) {
+            placedInPsram = true;
+            return memory;
+        }
+    }
+    placedInPsram = false;
+    return malloc(bytes);
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "DeviceRegistry.hpp"
+#include "TagRegistry.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Log store capacity (internal RAM vs PSRAM boards)
+#define LOG_STORE_RECORDS 1000
+#define LOG_STORE_ARENA_BYTES (48 * 1024)
+#define LOG_STORE_PSRAM_RECORDS 20000
+#define LOG_STORE_PSRAM_ARENA_BYTES (1024 * 1024)
+
+#define LOG_STORE_MAX_MESSAGE 255
+
+// A stored record as handed out to readers (message copied, names interned)
+struct LogRecordView {
+    uint32_t timestamp;
+    uint32_t sequence;  // Monotonic across evictions
+    uint8_t level;
+    DeviceId deviceId;
+    TagId tagId;
+    const char* deviceName;
+    const char* tag;
+    uint16_t messageLength;
+    char message[LOG_STORE_MAX_MESSAGE + 1];
+};
+
+/**
+ * LogStore is a fixed-capacity ring of compact log records. Devices are kept
+ * as DeviceRegistry ids and tags as TagRegistry ids, message bytes live in
+ * one contiguous ring arena. Adding is O(1) and evicts the oldest records when either ring is full.
+ * Storage is allocated once, in PSRAM when the board has it. Thread-safe.
+ */
+class LogStore {
+   public:
+    LogStore();
+    ~LogStore();
+
+    // Zero sizes pick the defaults for this board (PSRAM or internal RAM)
+    bool initialize(size_t maxRecords = 0, size_t arenaBytes = 0);
+    bool isInitialized() const { return records != nullptr; }
+
+    // Returns how many old records were evicted to make room
+    size_t add(uint32_t timestamp, uint8_t level, DeviceId deviceId, TagId tagId, const char* message);
+    // Raw message bytes with their wire flags; tokenized bodies are kept as-is and rendered by getRecord()
+    size_t add(uint32_t timestamp, uint8_t level, DeviceId deviceId, TagId tagId, const char* message,
+               size_t messageLength, uint8_t flags);
+    void clear();
+
+    // Index 0 is the oldest record still held
+    bool getRecord(size_t index, LogRecordView& view) const;
+    size_t size() const { return count; }
+    size_t capacity() const { return recordCapacity; }
+    uint32_t getTotalAdded() const { return nextSequence; }
+    bool isInPsram() const { return inPsram; }
+
+   private:
+    struct StoredRecord {
+        uint32_t timestamp;
+        uint32_t arenaOffset;
+        uint16_t messageLength;
+        uint8_t level;
+        uint8_t flags;  // WireRecordFlag bits
+        DeviceId deviceId;
+        TagId tagId;
+    };
+
+    StoredRecord* records;
+    size_t recordCapacity;
+    size_t head;  // Index of the oldest record
+    size_t count;
+    uint32_t nextSequence;
+
+    uint8_t* arena;
+    size_t arenaCapacity;
+    size_t arenaHead;  // Next free byte
+    size_t arenaUsed;
+
+    bool inPsram;
+    SemaphoreHandle_t mutex;
+
+    void evictOldest();
+    static void* allocate(size_t bytes, bool preferPsram, bool& placedInPsram);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,107 @@
+#include "MessagePool.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+MessagePool::MessagePool()
+    : blocks(nullptr), freeList(nullptr), blockCount(0), freeCount(0), exhaustedCount(0), lock(portMUX_INITIALIZER_UNLOCKED) {
+}
+
+MessagePool::~MessagePool() {
+    free(blocks);
+    free(freeList);
+}
+
+bool MessagePool::initialize(size_t count) {
+    if (blocks) {
+        return true;
+    }
+
+    blocks = static_cast<uint8_t*>(malloc(count * MESSAGE_PAYLOAD_SIZE));
+    freeList = static_cast<uint16_t*>(malloc(count * sizeof(uint16_t)));
+    if (!blocks || !freeList) {
+        Serial.printf("Failed to allocate message pool (%d blocks)\n", count);
+        free(blocks);
+        free(freeList);
+        blocks = nullptr;
+        freeList = nullptr;
+        return false;
+    }
+
+    blockCount = count;
+    freeCount = count;
+    for (size_t i = 0; i < count; i++) {
+        freeList[i] = i;
+    }
+    return true;
+}
+
+uint16_t MessagePool::acquire() {
+    uint16_t handle = MESSAGE_NO_PAYLOAD;
+
+    portENTER_CRITICAL_SAFE(&lock);
+    if (freeCount > 0) {
+        handle = freeList[--freeCount];
+    } else {
+        exhaustedCount++;
+    }
+    portEXIT_CRITICAL_SAFE(&lock);
+
+    return handle;
+}
+
+void MessagePool::release(uint16_t handle) {
+    if (handle >= blockCount) {
+        return;
+    }
+
+    portENTER_CRITICAL_SAFE(&lock);
+    if (freeCount < blockCount) {
+        freeList[freeCount++] = handle;
+    }
+    portEXIT_CRITICAL_SAFE(&lock);
+}
+
+uint16_t MessagePool::acquireText(const char* first, const char* second) {
+    uint16_t handle = acquire();
+    uint8_t* data = blockData(handle);
+    if (!data) {
+        return MESSAGE_NO_PAYLOAD;
+    }
+
+    // Layout: [first]\0[second]\0, the first string is capped so the second always fits a little
+    char* text = reinterpret_cast<char*>(data);
+    size_t firstLength = strnlen(first ? first : "", MESSAGE_PAYLOAD_SIZE / 4);
+    memcpy(text, first ? first : "", firstLength);
+    text[firstLength] = '\0';
+
+    size_t remaining = MESSAGE_PAYLOAD_SIZE - firstLength - 1;
+    size_t secondLength = strnlen(second ? second : "", remaining - 1);
+    memcpy(text + firstLength + 1, second ? second : "", secondLength);
+    text[firstLength + 1 + secondLength] = '\0';
+
+    return handle;
+}
+
+const char* MessagePool::firstText(uint16_t handle) const {
+    uint8_t* data = blockData(handle);
+    return data ? reinterpret_cast<const char*>(data) : "";
+}
+
+const char* MessagePool::secondText(uint16_t handle) const {
+    const char* first = firstText(handle);
+    if (!blockData(handle)) {
+        return "";
+    }
+    return first + strlen(first) + 1;
+}
+
+uint8_t* MessagePool::blockData(uint16_t handle) const {
+    if (!blocks || handle >= blockCount) {
+        return nullptr;
+    }
+    return blocks + (size_t)handle * MESSAGE_PAYLOAD_SIZE;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+namespace BTLogger {
+namespace Core {
+
+// Payload pool configuration
+#define MESSAGE_POOL_BLOCKS 48
+#define MESSAGE_PAYLOAD_SIZE 320  // Fits a device name/tag plus a full log message
+#define MESSAGE_NO_PAYLOAD 0xFFFF
+
+/**
+ * MessagePool hands out fixed-size payload blocks for inter-core messages.
+ * A block is referenced by a 16-bit handle: the sender acquires and fills it,
+ * ownership moves to the receiver once the message is queued, and the receiver
+ * releases it after handling. Never touches the heap after initialize().
+ */
+class MessagePool {
+   public:
+    MessagePool();
+    ~MessagePool();
+
+    bool initialize(size_t blockCount = MESSAGE_POOL_BLOCKS);
+
+    // Ownership
+    uint16_t acquire();
+    void release(uint16_t handle);
+
+    // Store two NUL-terminated strings in a block (truncated to fit)
+    uint16_t acquireText(const char* first, const char* second = "");
+    const char* firstText(uint16_t handle) const;
+    const char* secondText(uint16_t handle) const;
+
+    // Status
+    size_t available() const { return freeCount; }
+    size_t capacity() const { return blockCount; }
+    uint32_t getExhaustedCount() const { return exhaustedCount; }
+
+   private:
+    uint8_t* blocks;
+    uint16_t* freeList;
+    size_t blockCount;
+    size_t freeCount;
+    uint32_t exhaustedCount;
+    mutable portMUX_TYPE lock;
+
+    uint8_t* blockData(uint16_t handle) const;
+};
+
+}  // namespace Core
+}  // namespace BTLogger
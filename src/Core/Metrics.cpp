@@ -0,0 +1,216 @@
+#include "Metrics.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+std::atomic<uint32_t> Metrics::counters[METRIC_COUNTERS];
+std::atomic<uint32_t> Metrics::levels[METRIC_LEVELS];
+std::atomic<uint32_t> Metrics::buckets[METRIC_HISTOGRAMS][METRICS_HISTOGRAM_BUCKETS];
+std::atomic<uint32_t> Metrics::maxUs[METRIC_HISTOGRAMS];
+
+uint32_t Metrics::dumpIntervalMs = METRICS_DUMP_INTERVAL_MS;
+unsigned long Metrics::lastDump = 0;
+bool Metrics::headerPrinted = false;
+MetricsSnapshot Metrics::lastSnapshot = {};
+
+uint32_t MetricsSnapshot::getCount(MetricHistogram histogram) const {
+    uint32_t total = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        total += histograms[histogram][i];
+    }
+    return total;
+}
+
+uint32_t MetricsSnapshot::getPercentileUs(MetricHistogram histogram, uint8_t percent) const {
+    uint32_t total = getCount(histogram);
+    if (total == 0) {
+        return 0;
+    }
+
+    // Top of the bucket the percentile falls in; the largest value seen is a tighter bound for the last one
+    uint32_t wanted = max((uint32_t)1, (uint32_t)(((uint64_t)total * percent + 99) / 100));
+    uint32_t seen = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        seen += histograms[histogram][i];
+        if (seen >= wanted) {
+            uint32_t upper = i == 0 ? 1 : i >= 32 ? UINT32_MAX : (1UL << i);
+            return i == METRICS_HISTOGRAM_BUCKETS - 1 ? maxUs[histogram] : min(upper, maxUs[histogram]);
+        }
+    }
+    return maxUs[histogram];
+}
+
+float MetricsSnapshot::getRate(MetricCounter counter, const MetricsSnapshot& earlier) const {
+    int64_t span = timeUs - earlier.timeUs;
+    if (span <= 0) {
+        return 0;
+    }
+    // A reset in between leaves only what was counted since
+    uint32_t delta = counters[counter] >= earlier.counters[counter] ? counters[counter] - earlier.counters[counter]
+                                                                    : counters[counter];
+    return delta * 1000000.0f / span;
+}
+
+void Metrics::snapshot(MetricsSnapshot& out) {
+    out.timeUs = esp_timer_get_time();
+    for (int i = 0; i < METRIC_COUNTERS; i++) {
+        out.counters[i] = counters[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < METRIC_LEVELS; i++) {
+        out.levels[i] = levels[i].load(std::memory_order_relaxed);
+    }
+    for (int h = 0; h < METRIC_HISTOGRAMS; h++) {
+        for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+            out.histograms[h][i] = buckets[h][i].load(std::memory_order_relaxed);
+        }
+        out.maxUs[h] = maxUs[h].load(std::memory_order_relaxed);
+    }
+}
+
+void Metrics::reset() {
+    for (int i = 0; i < METRIC_COUNTERS; i++) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < METRIC_LEVELS; i++) {
+        levels[i].store(0, std::memory_order_relaxed);
+    }
+    for (int h = 0; h < METRIC_HISTOGRAMS; h++) {
+        for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+            buckets[h][i].store(0, std::memory_order_relaxed);
+        }
+        maxUs[h].store(0, std::memory_order_relaxed);
+    }
+    snapshot(lastSnapshot);
+}
+
+void Metrics::update() {
+    if (dumpIntervalMs == 0 || millis() - lastDump < dumpIntervalMs) {
+        return;
+    }
+    lastDump = millis();
+
+    MetricsSnapshot now;
+    snapshot(now);
+    if (!headerPrinted) {
+        dumpHeader(Serial);
+        headerPrinted = true;
+    }
+    dump(Serial, now, lastSnapshot);
+    lastSnapshot = now;
+}
+
+void Metrics::dumpHeader(Print& out) {
+    out.print("metrics,uptime_ms");
+    for (int i = 0; i < METRIC_COUNTERS; i++) {
+        out.printf(",%s", getCounterName((MetricCounter)i));
+    }
+    out.print(",rx_per_s,rx_bytes_per_s,records_per_s,sd_bytes_per_s,ui_fps");
+    for (int i = 0; i < METRIC_LEVELS; i++) {
+        out.printf(",%s_max", getLevelName((MetricLevel)i));
+    }
+    for (int i = 0; i < METRIC_HISTOGRAMS; i++) {
+        const char* name = getHistogramName((MetricHistogram)i);
+        out.printf(",%s_n,%s_p50_us,%s_p99_us,%s_max_us", name, name, name, name);
+    }
+    out.println();
+}
+
+void Metrics::dump(Print& out, const MetricsSnapshot& now, const MetricsSnapshot& earlier) {
+    out.printf("metrics,%lu", (unsigned long)(now.timeUs / 1000));
+    for (int i = 0; i < METRIC_COUNTERS; i++) {
+        out.printf(",%lu", (unsigned long)now.counters[i]);
+    }
+    out.printf(",%.1f,%.0f,%.1f,%.0f,%.1f", now.getRate(METRIC_RX_NOTIFICATIONS, earlier),
+               now.getRate(METRIC_RX_BYTES, earlier), now.getRate(METRIC_DECODED_RECORDS, earlier),
+               now.getRate(METRIC_SD_BYTES, earlier), now.getRate(METRIC_UI_FRAMES, earlier));
+    for (int i = 0; i < METRIC_LEVELS; i++) {
+        out.printf(",%lu", (unsigned long)now.levels[i]);
+    }
+    for (int i = 0; i < METRIC_HISTOGRAMS; i++) {
+        MetricHistogram histogram = (MetricHistogram)i;
+        out.printf(",%lu,%lu,%lu,%lu", (unsigned long)now.getCount(histogram),
+                   (unsigned long)now.getPercentileUs(histogram, 50), (unsigned long)now.getPercentileUs(histogram, 99),
+                   (unsigned long)now.maxUs[i]);
+    }
+    out.println();
+}
+
+const char* Metrics::getCounterName(MetricCounter counter) {
+    switch (counter) {
+        case METRIC_RX_NOTIFICATIONS:
+            return "rx";
+        case METRIC_RX_BYTES:
+            return "rx_bytes";
+        case METRIC_RX_DROPPED:
+            return "rx_dropped";
+        case METRIC_DECODED_RECORDS:
+            return "records";
+        case METRIC_DECODE_ERRORS:
+            return "decode_errors";
+        case METRIC_RECORDS_RESENT:
+            return "records_resent";
+        case METRIC_RECORDS_LOST:
+            return "records_lost";
+        case METRIC_STORAGE_QUEUED:
+            return "storage_queued";
+        case METRIC_STORAGE_DROPPED:
+            return "storage_dropped";
+        case METRIC_SD_RECORDS:
+            return "sd_records";
+        case METRIC_SD_BYTES:
+            return "sd_bytes";
+        case METRIC_SD_FAILED:
+            return "sd_failed";
+        case METRIC_UI_RECORDS:
+            return "ui_records";
+        case METRIC_UI_FRAMES:
+            return "ui_frames";
+        case METRIC_UI_DROPPED:
+            return "ui_dropped";
+        case METRIC_SERIAL_BYTES:
+            return "serial_bytes";
+        case METRIC_SERIAL_DROPPED:
+            return "serial_dropped";
+        case METRIC_RELAY_BYTES:
+            return "relay_bytes";
+        case METRIC_RELAY_DROPPED:
+            return "relay_dropped";
+        default:
+            return "?";
+    }
+}
+
+const char* Metrics::getLevelName(MetricLevel metric) {
+    switch (metric) {
+        case METRIC_LEVEL_INGEST_RING:
+            return "ingest_ring";
+        case METRIC_LEVEL_STORAGE_QUEUE:
+            return "storage_queue";
+        case METRIC_LEVEL_WRITE_BUFFER:
+            return "write_buffer";
+        default:
+            return "?";
+    }
+}
+
+const char* Metrics::getHistogramName(MetricHistogram histogram) {
+    switch (histogram) {
+        case METRIC_HIST_SENDER_TO_RX:
+            return "sender_to_rx";
+        case METRIC_HIST_RING_WAIT:
+            return "ring_wait";
+        case METRIC_HIST_RX_TO_SD:
+            return "rx_to_sd";
+        case METRIC_HIST_SD_WRITE:
+            return "sd_write";
+        case METRIC_HIST_RX_TO_PIXEL:
+            return "rx_to_pixel";
+        case METRIC_HIST_UI_FRAME:
+            return "ui_frame";
+        default:
+            return "?";
+    }
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include <atomic>
+
+namespace BTLogger {
+namespace Core {
+
+// Histograms have one bucket per power of two microseconds: bucket 0 is under 1us,
+// bucket n holds [2^(n-1), 2^n) and the last one everything from ~8.4 s up
+#define METRICS_HISTOGRAM_BUCKETS 24
+#define METRICS_DUMP_INTERVAL_MS 10000  // Serial CSV dump; 0 turns it off
+
+// Monotonic event counts, one set per stage of the ingest path
+enum MetricCounter : uint8_t {
+    METRIC_RX_NOTIFICATIONS,  // BLE notifications copied into the ingest ring
+    METRIC_RX_BYTES,
+    METRIC_RX_DROPPED,        // Ring full
+    METRIC_DECODED_RECORDS,
+    METRIC_DECODE_ERRORS,     // Notifications that were not a valid frame
+    METRIC_RECORDS_RESENT,    // Missing records the sender delivered again
+    METRIC_RECORDS_LOST,      // Missing records given up on (marked in the log)
+    METRIC_STORAGE_QUEUED,    // Records handed to the storage task
+    METRIC_STORAGE_DROPPED,   // Records lost to a full storage queue
+    METRIC_SD_RECORDS,        // Records in a write-back buffer or block
+    METRIC_SD_BYTES,          // Bytes committed to the card
+    METRIC_SD_FAILED,         // Records the card could not take
+    METRIC_UI_RECORDS,        // Records added to the viewer
+    METRIC_UI_FRAMES,
+    METRIC_UI_DROPPED,        // Messages lost to a full UI queue
+    METRIC_SERIAL_BYTES,      // Written to the serial mirror's UART
+    METRIC_SERIAL_DROPPED,    // Records the serial mirror had no room for
+    METRIC_RELAY_BYTES,       // Frame bytes the network relay sent
+    METRIC_RELAY_DROPPED,     // Records the network relay had no room for
+    METRIC_COUNTERS
+};
+
+// Queue depths; only the high-water mark is kept
+enum MetricLevel : uint8_t {
+    METRIC_LEVEL_INGEST_RING,    // Notifications waiting
+    METRIC_LEVEL_STORAGE_QUEUE,  // Messages waiting
+    METRIC_LEVEL_WRITE_BUFFER,   // Bytes waiting in one session's write-back buffer
+    METRIC_LEVELS
+};
+
+enum MetricHistogram : uint8_t {
+    METRIC_HIST_SENDER_TO_RX,  // Sender log call to BLE receive (synced links only)
+    METRIC_HIST_RING_WAIT,     // BLE receive to decode
+    METRIC_HIST_RX_TO_SD,      // BLE receive to commit, oldest record of each commit
+    METRIC_HIST_SD_WRITE,      // One commit's write and sync
+    METRIC_HIST_RX_TO_PIXEL,   // BLE receive to drawn, oldest record of each repaint
+    METRIC_HIST_UI_FRAME,      // One UI frame, message handling to transfers done
+    METRIC_HISTOGRAMS
+};
+
+// A copy of every metric at one moment; two of them give rates
+struct MetricsSnapshot {
+    int64_t timeUs;
+    uint32_t counters[METRIC_COUNTERS];
+    uint32_t levels[METRIC_LEVELS];
+    uint32_t histograms[METRIC_HISTOGRAMS][METRICS_HISTOGRAM_BUCKETS];
+    uint32_t maxUs[METRIC_HISTOGRAMS];
+
+    uint32_t getCount(MetricHistogram histogram) const;
+    uint32_t getPercentileUs(MetricHistogram histogram, uint8_t percent) const;
+    float getRate(MetricCounter counter, const MetricsSnapshot& earlier) const;  // Per second
+};
+
+/**
+ * Metrics holds lock-free counters, high-water marks and latency histograms
+ * for the whole path from a sender's log call to the card and the screen.
+ * Recording an event is one relaxed atomic add (and a count-leading-zeros
+ * for histograms), cheap enough to stay on in production. Readers take a
+ * snapshot; percentiles are read from the power-of-two buckets, so they
+ * are exact to within a factor of two.
+ *
+ * Safe from any task or the BLE callbacks.
+ */
+class Metrics {
+   public:
+    static void count(MetricCounter counter, uint32_t amount = 1) {
+        counters[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    static void level(MetricLevel metric, uint32_t value) {
+        uint32_t seen = levels[metric].load(std::memory_order_relaxed);
+        while (value > seen && !levels[metric].compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    static void record(MetricHistogram histogram, int64_t elapsedUs) {
+        uint32_t us = elapsedUs <= 0 ? 0 : elapsedUs >= UINT32_MAX ? UINT32_MAX : (uint32_t)elapsedUs;
+        uint32_t bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+        buckets[histogram][bucket < METRICS_HISTOGRAM_BUCKETS ? bucket : METRICS_HISTOGRAM_BUCKETS - 1].fetch_add(
+            1, std::memory_order_relaxed);
+        uint32_t seen = maxUs[histogram].load(std::memory_order_relaxed);
+        while (us > seen && !maxUs[histogram].compare_exchange_weak(seen, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    static void snapshot(MetricsSnapshot& out);
+    static void reset();
+
+    // Writes a CSV line of totals, rates since the previous dump and percentiles every
+    // METRICS_DUMP_INTERVAL_MS; call from a low-priority task
+    static void update();
+    static void setDumpInterval(uint32_t intervalMs) { dumpIntervalMs = intervalMs; }
+    static void dump(Print& out, const MetricsSnapshot& now, const MetricsSnapshot& earlier);
+    static void dumpHeader(Print& out);
+
+    static const char* getCounterName(MetricCounter counter);
+    static const char* getLevelName(MetricLevel metric);
+    static const char* getHistogramName(MetricHistogram histogram);
+
+   private:
+    static std::atomic<uint32_t> counters[METRIC_COUNTERS];
+    static std::atomic<uint32_t> levels[METRIC_LEVELS];
+    static std::atomic<uint32_t> buckets[METRIC_HISTOGRAMS][METRICS_HISTOGRAM_BUCKETS];
+    static std::atomic<uint32_t> maxUs[METRIC_HISTOGRAMS];
+
+    static uint32_t dumpIntervalMs;
+    static unsigned long lastDump;
+    static bool headerPrinted;
+    static MetricsSnapshot lastSnapshot;
+};
+
+}  // namespace Core
+}  // namespace BTLogger
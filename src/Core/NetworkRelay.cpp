@@ -0,0 +1,587 @@
+#include "NetworkRelay.hpp"
+#include <esp_coexist.h>
+#include "Metrics.hpp"
+#include "SenderControl.hpp"
+#include "SerialMirror.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Header in front of the largest frame
+#define NETWORK_RELAY_FRAME_CAPACITY (NETWORK_RELAY_HEADER_SIZE + NETWORK_RELAY_BATCH_SIZE)
+
+uint8_t* NetworkRelay::ring = nullptr;
+std::atomic<uint32_t> NetworkRelay::head(0);
+std::atomic<uint32_t> NetworkRelay::tail(0);
+std::atomic<uint32_t> NetworkRelay::dropped(0);
+uint32_t NetworkRelay::records = 0;
+uint32_t NetworkRelay::highWaterMark = 0;
+uint32_t NetworkRelay::unreported = 0;
+uint32_t NetworkRelay::announced = 0;
+uint8_t* NetworkRelay::batch = nullptr;
+size_t NetworkRelay::batchLength = 0;
+unsigned long NetworkRelay::batchStarted = 0;
+uint8_t* NetworkRelay::frame = nullptr;
+LogCompressor* NetworkRelay::compressor = nullptr;
+WiFiClient NetworkRelay::client;
+WiFiUDP NetworkRelay::udp;
+uint32_t NetworkRelay::sequence = 0;
+uint32_t NetworkRelay::backoffMs = NETWORK_RELAY_BACKOFF_MIN_MS;
+unsigned long NetworkRelay::nextAttempt = 0;
+unsigned long NetworkRelay::lastAnnounce = 0;
+unsigned long NetworkRelay::lastSent = 0;
+bool NetworkRelay::linkUp = false;
+std::atomic<uint32_t> NetworkRelay::frames(0);
+std::atomic<uint32_t> NetworkRelay::rawBytes(0);
+std::atomic<uint32_t> NetworkRelay::bytesOut(0);
+std::atomic<uint32_t> NetworkRelay::reconnects(0);
+volatile bool NetworkRelay::enabled = false;
+volatile NetworkRelayState NetworkRelay::state = RELAY_OFF;
+volatile bool NetworkRelay::running = false;
+volatile bool NetworkRelay::settingsChanged = true;
+TaskHandle_t NetworkRelay::taskHandle = nullptr;
+portMUX_TYPE NetworkRelay::settingsLock = portMUX_INITIALIZER_UNLOCKED;
+NetworkRelay::Settings NetworkRelay::settings = {};
+NetworkRelay::Settings NetworkRelay::active = {};
+Preferences NetworkRelay::preferences;
+
+void NetworkRelay::loadSettings() {
+    preferences.begin("net_relay", true);  // Read-only mode
+    bool storedEnabled = preferences.getBool("enabled", false);
+    String storedSsid = preferences.getString("ssid", "");
+    String storedPassword = preferences.getString("password", "");
+    String storedHost = preferences.getString("host", "");
+    uint16_t storedPort = preferences.getUShort("port", NETWORK_RELAY_DEFAULT_PORT);
+    bool storedUdp = preferences.getBool("udp", false);
+    preferences.end();
+
+    portENTER_CRITICAL(&settingsLock);
+    strncpy(settings.ssid, storedSsid.c_str(), sizeof(settings.ssid) - 1);
+    strncpy(settings.password, storedPassword.c_str(), sizeof(settings.password) - 1);
+    strncpy(settings.host, storedHost.c_str(), sizeof(settings.host) - 1);
+    settings.port = storedPort;
+    settings.udp = storedUdp;
+    settingsChanged = true;
+    portEXIT_CRITICAL(&settingsLock);
+    enabled = storedEnabled;
+}
+
+bool NetworkRelay::begin() {
+    if (!enabled) {
+        state = RELAY_OFF;
+        return true;
+    }
+    if (taskHandle) {
+        if (running) {
+            return true;
+        }
+        stopTask();  // Still on its way out from being turned off
+        if (taskHandle) {
+            return false;
+        }
+    }
+
+    // Kept once allocated: the communications task may be in write() when the relay is turned off
+    if (!ring) {
+        ring = static_cast<uint8_t*>(malloc(NETWORK_RELAY_RING_SIZE));
+        batch = static_cast<uint8_t*>(malloc(NETWORK_RELAY_BATCH_SIZE));
+        frame = static_cast<uint8_t*>(malloc(NETWORK_RELAY_FRAME_CAPACITY));
+        compressor = new LogCompressor(NETWORK_RELAY_BATCH_SIZE);
+        if (!ring || !batch || !frame || !compressor->isReady()) {
+            Serial.println("Failed to allocate network relay buffers");
+            free(ring);
+            free(batch);
+            free(frame);
+            delete compressor;
+            ring = batch = frame = nullptr;
+            compressor = nullptr;
+            return false;
+        }
+        head.store(0);
+        tail.store(0);
+    }
+
+    portENTER_CRITICAL(&settingsLock);
+    bool configured = settings.ssid[0] != '\0' && settings.host[0] != '\0';
+    settingsChanged = true;
+    portEXIT_CRITICAL(&settingsLock);
+    state = configured ? RELAY_JOINING : RELAY_UNCONFIGURED;
+
+    running = true;
+    if (xTaskCreatePinnedToCore(relayTask, "NetworkRelay", NETWORK_RELAY_TASK_STACK_SIZE, nullptr,
+                                NETWORK_RELAY_TASK_PRIORITY, &taskHandle, 0) != pdPASS) {
+        Serial.println("Failed to start network relay task");
+        running = false;
+        state = RELAY_OFF;
+        return false;
+    }
+
+    Serial.printf("Network relay ready: %d byte ring, %s\n", NETWORK_RELAY_RING_SIZE, getStateName(state));
+    return true;
+}
+
+void NetworkRelay::end() {
+    stopTask();
+    if (taskHandle || !ring) {
+        return;
+    }
+
+    // Only once the communications task has stopped calling write()
+    free(ring);
+    free(batch);
+    free(frame);
+    delete compressor;
+    ring = batch = frame = nullptr;
+    compressor = nullptr;
+}
+
+void NetworkRelay::write(const LogPacket& packet, DeviceId device, const char* text) {
+    NetworkRelayState current = state;
+    if (!ring || !running || current == RELAY_OFF || current == RELAY_UNCONFIGURED) {
+        return;
+    }
+
+    // Say what was lost before the next record, once there is room for it
+    uint8_t buffer[512];
+    if (unreported > 0) {
+        size_t payloadLength = SerialMirror::renderDroppedPayload(unreported, buffer + 3, sizeof(buffer) - 3);
+        if (!push(buffer, renderEntry(SERIAL_MIRROR_FRAME_DROPPED, buffer + 3, payloadLength, buffer, sizeof(buffer)))) {
+            unreported++;
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            Metrics::count(METRIC_RELAY_DROPPED);
+            return;
+        }
+        unreported = 0;
+    }
+
+    if (device < DEVICE_REGISTRY_SLOTS && !(announced & (1UL << device))) {
+        size_t payloadLength = SerialMirror::renderDevicePayload(device, buffer + 3, sizeof(buffer) - 3);
+        if (push(buffer, renderEntry(SERIAL_MIRROR_FRAME_DEVICE, buffer + 3, payloadLength, buffer, sizeof(buffer)))) {
+            announced |= 1UL << device;
+        }
+    }
+
+    // RECORD payload straight into place behind the entry header
+    size_t length = SerialMirror::renderRecordPayload(packet, device, text, buffer + 3, sizeof(buffer) - 3);
+    if (length > 0 && push(buffer, renderEntry(SERIAL_MIRROR_FRAME_RECORD, buffer + 3, length, buffer, sizeof(buffer)))) {
+        records++;
+        return;
+    }
+    unreported++;
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    Metrics::count(METRIC_RELAY_DROPPED);
+}
+
+void NetworkRelay::setEnabled(bool next) {
+    if (next == enabled) {
+        return;
+    }
+    enabled = next;
+    saveSettings();
+    if (enabled) {
+        begin();
+        return;
+    }
+
+    // The task winds down on its own; begin() waits for it if turned on again meanwhile
+    running = false;
+    state = RELAY_OFF;
+    if (taskHandle) {
+        xTaskNotifyGive(taskHandle);
+    }
+}
+
+bool NetworkRelay::setNetwork(const char* ssid, const char* password) {
+    if (!ssid || strlen(ssid) >= NETWORK_RELAY_SSID_LENGTH || strlen(password ? password : "") >= NETWORK_RELAY_PASSWORD_LENGTH) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&settingsLock);
+    strncpy(settings.ssid, ssid, sizeof(settings.ssid) - 1);
+    strncpy(settings.password, password ? password : "", sizeof(settings.password) - 1);
+    settingsChanged = true;
+    portEXIT_CRITICAL(&settingsLock);
+    saveSettings();
+    return true;
+}
+
+bool NetworkRelay::setCollector(const char* host, uint16_t port, bool udp) {
+    if (!host || strlen(host) >= NETWORK_RELAY_HOST_LENGTH || port == 0) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&settingsLock);
+    strncpy(settings.host, host, sizeof(settings.host) - 1);
+    settings.port = port;
+    settings.udp = udp;
+    settingsChanged = true;
+    portEXIT_CRITICAL(&settingsLock);
+    saveSettings();
+    return true;
+}
+
+const char* NetworkRelay::getStateName(NetworkRelayState value) {
+    switch (value) {
+        case RELAY_OFF:
+            return "Off";
+        case RELAY_UNCONFIGURED:
+            return "Not set up";
+        case RELAY_JOINING:
+            return "Joining Wi-Fi";
+        case RELAY_CONNECTING:
+            return "Connecting";
+        case RELAY_STREAMING:
+            return "Streaming";
+        default:
+            return "?";
+    }
+}
+
+NetworkRelayStats NetworkRelay::getStats() {
+    NetworkRelayStats stats;
+    stats.state = state;
+    stats.records = records;
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.frames = frames.load(std::memory_order_relaxed);
+    stats.rawBytes = rawBytes.load(std::memory_order_relaxed);
+    stats.bytes = bytesOut.load(std::memory_order_relaxed);
+    stats.reconnects = reconnects.load(std::memory_order_relaxed);
+    stats.highWaterMark = highWaterMark;
+    return stats;
+}
+
+bool NetworkRelay::handleCommand(const char* line) {
+    if (strncmp(line, "relay", 5) != 0 || (line[5] != ' ' && line[5] != '\0')) {
+        return false;
+    }
+    const char* arguments = line + 5;
+    while (*arguments == ' ') {
+        arguments++;
+    }
+
+    char first[NETWORK_RELAY_HOST_LENGTH];
+    char second[NETWORK_RELAY_PASSWORD_LENGTH] = "";
+    char transport[8] = "tcp";
+    unsigned int port = NETWORK_RELAY_DEFAULT_PORT;
+    if (strcmp(arguments, "on") == 0 || strcmp(arguments, "off") == 0) {
+        setEnabled(strcmp(arguments, "on") == 0);
+    } else if (sscanf(arguments, "wifi %32s %64s", first, second) >= 1) {
+        if (!setNetwork(first, second)) {
+            Serial.println("Relay: SSID or password too long");
+            return true;
+        }
+    } else if (sscanf(arguments, "server %63s %u %7s", first, &port, transport) >= 1) {
+        if ((strcmp(transport, "tcp") != 0 && strcmp(transport, "udp") != 0) || port > UINT16_MAX ||
+            !setCollector(first, port, strcmp(transport, "udp") == 0)) {
+            Serial.println("Relay: relay server <host> [port] [tcp|udp]");
+            return true;
+        }
+    } else if (arguments[0] != '\0' && strcmp(arguments, "status") != 0) {
+        Serial.println("Relay: relay on|off|status, relay wifi <ssid> [password], relay server <host> [port] [tcp|udp]");
+        return true;
+    }
+
+    // Every command answers with where things stand
+    Settings shown;
+    portENTER_CRITICAL(&settingsLock);
+    shown = settings;
+    portEXIT_CRITICAL(&settingsLock);
+    NetworkRelayStats stats = getStats();
+    Serial.printf("Relay %s: wifi \"%s\", %s %s:%u, %lu records, %lu dropped, %lu frames, %lu bytes (%.1fx), %lu connects\n",
+                  getStateName(stats.state), shown.ssid, shown.udp ? "udp" : "tcp", shown.host, shown.port,
+                  (unsigned long)stats.records, (unsigned long)stats.dropped, (unsigned long)stats.frames,
+                  (unsigned long)stats.bytes, stats.bytes ? (float)stats.rawBytes / stats.bytes : 0.0f,
+                  (unsigned long)stats.reconnects);
+    return true;
+}
+
+bool NetworkRelay::push(const uint8_t* data, size_t length) {
+    uint32_t currentHead = head.load(std::memory_order_relaxed);
+    uint32_t used = currentHead - tail.load(std::memory_order_acquire);
+    if (length == 0 || length > NETWORK_RELAY_RING_SIZE - used) {
+        return false;
+    }
+
+    // Wraps at most once
+    size_t offset = currentHead & (NETWORK_RELAY_RING_SIZE - 1);
+    size_t first = min(length, (size_t)NETWORK_RELAY_RING_SIZE - offset);
+    memcpy(ring + offset, data, first);
+    memcpy(ring, data + first, length - first);
+    head.store(currentHead + length, std::memory_order_release);
+
+    if (used + length > highWaterMark) {
+        highWaterMark = used + length;
+    }
+    return true;
+}
+
+size_t NetworkRelay::renderEntry(uint8_t type, const uint8_t* payload, size_t length, uint8_t* out, size_t capacity) {
+    if (length + 3 > capacity) {
+        return 0;
+    }
+
+    out[0] = type;
+    out[1] = length & 0xFF;
+    out[2] = length >> 8;
+    if (payload != out + 3) {
+        memmove(out + 3, payload, length);
+    }
+    return length + 3;
+}
+
+void NetworkRelay::saveSettings() {
+    Settings saved;
+    portENTER_CRITICAL(&settingsLock);
+    saved = settings;
+    portEXIT_CRITICAL(&settingsLock);
+
+    preferences.begin("net_relay", false);
+    preferences.putBool("enabled", enabled);
+    preferences.putString("ssid", saved.ssid);
+    preferences.putString("password", saved.password);
+    preferences.putString("host", saved.host);
+    preferences.putUShort("port", saved.port);
+    preferences.putBool("udp", saved.udp);
+    preferences.end();
+}
+
+void NetworkRelay::stopTask() {
+    if (!taskHandle) {
+        state = RELAY_OFF;
+        return;
+    }
+
+    // A connect attempt can take its whole timeout before the task notices
+    running = false;
+    xTaskNotifyGive(taskHandle);
+    unsigned long timeout = millis() + NETWORK_RELAY_CONNECT_TIMEOUT_MS + 500;
+    while (taskHandle && millis() < timeout) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+}
+
+void NetworkRelay::relayTask(void* parameter) {
+    while (running) {
+        if (settingsChanged) {
+            applySettings();
+        }
+        if (active.ssid[0] == '\0' || active.host[0] == '\0') {
+            state = RELAY_UNCONFIGURED;
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NETWORK_RELAY_IDLE_MS));
+            continue;
+        }
+
+        unsigned long now = millis();
+        if (WiFi.status() != WL_CONNECTED) {
+            if (linkUp) {
+                disconnect();
+            }
+            state = RELAY_JOINING;  // Wi-Fi reconnects on its own
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NETWORK_RELAY_IDLE_MS));
+            continue;
+        }
+
+        if (!linkUp) {
+            state = RELAY_CONNECTING;
+            if ((long)(now - nextAttempt) < 0) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(NETWORK_RELAY_IDLE_MS));
+                continue;
+            }
+            if (!connect()) {
+                nextAttempt = millis() + backoffMs;
+                backoffMs = min(backoffMs * 2, (uint32_t)NETWORK_RELAY_BACKOFF_MAX_MS);
+                continue;
+            }
+        }
+        state = RELAY_STREAMING;
+
+        // Device names first on a new link, then again now and then for UDP listeners that came late
+        if (lastAnnounce == 0 || (active.udp && now - lastAnnounce >= NETWORK_RELAY_ANNOUNCE_MS)) {
+            if (!announceDevices()) {
+                disconnect();
+                continue;
+            }
+        }
+
+        size_t limit = active.udp ? NETWORK_RELAY_DATAGRAM_SIZE - NETWORK_RELAY_HEADER_SIZE : NETWORK_RELAY_BATCH_SIZE;
+        bool full = fillBatch(limit);
+        if (!flushDue(full)) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        // A batch that didn't go out stays for the next link
+        if (sendFrame(batch, batchLength)) {
+            batchLength = 0;
+        } else {
+            disconnect();
+        }
+    }
+
+    disconnect();
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+    state = RELAY_OFF;
+    taskHandle = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void NetworkRelay::applySettings() {
+    portENTER_CRITICAL(&settingsLock);
+    active = settings;
+    settingsChanged = false;
+    portEXIT_CRITICAL(&settingsLock);
+
+    disconnect();
+    backoffMs = NETWORK_RELAY_BACKOFF_MIN_MS;
+    nextAttempt = millis();
+    if (active.ssid[0] == '\0') {
+        WiFi.disconnect(true);
+        return;
+    }
+
+    // Bluetooth wins the radio when both want it, and Wi-Fi sleeps between beacons to leave it time
+    WiFi.mode(WIFI_STA);
+    WiFi.setSleep(true);
+    esp_coex_preference_set(ESP_COEX_PREFER_BT);
+    WiFi.setAutoReconnect(true);
+    WiFi.begin(active.ssid, active.password[0] ? active.password : nullptr);
+    Serial.printf("Network relay joining \"%s\"\n", active.ssid);
+}
+
+bool NetworkRelay::connect() {
+    if (!active.udp) {
+        if (!client.connect(active.host, active.port, NETWORK_RELAY_CONNECT_TIMEOUT_MS)) {
+            Serial.printf("Network relay: no collector at %s:%u, retry in %lu ms\n", active.host, active.port,
+                          (unsigned long)backoffMs);
+            return false;
+        }
+        client.setNoDelay(true);  // Frames are already batched
+    }
+
+    Serial.printf("Network relay streaming to %s:%u over %s\n", active.host, active.port, active.udp ? "UDP" : "TCP");
+    linkUp = true;
+    lastAnnounce = 0;
+    reconnects.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void NetworkRelay::disconnect() {
+    if (linkUp && !active.udp) {
+        client.stop();
+    }
+    if (linkUp) {
+        nextAttempt = millis() + backoffMs;
+    }
+    linkUp = false;
+}
+
+void NetworkRelay::copyOut(uint32_t position, uint8_t* out, size_t length) {
+    size_t offset = position & (NETWORK_RELAY_RING_SIZE - 1);
+    size_t first = min(length, (size_t)NETWORK_RELAY_RING_SIZE - offset);
+    memcpy(out, ring + offset, first);
+    memcpy(out + first, ring, length - first);
+}
+
+bool NetworkRelay::fillBatch(size_t limit) {
+    // Whole entries only; the communications task always pushes them whole
+    while (true) {
+        uint32_t currentTail = tail.load(std::memory_order_relaxed);
+        uint32_t waiting = head.load(std::memory_order_acquire) - currentTail;
+        if (waiting < 3) {
+            return false;
+        }
+
+        uint8_t header[3];
+        copyOut(currentTail, header, sizeof(header));
+        size_t entryLength = 3 + (header[1] | (header[2] << 8));
+        if (batchLength + entryLength > limit) {
+            return true;
+        }
+
+        if (batchLength == 0) {
+            batchStarted = millis();
+        }
+        copyOut(currentTail, batch + batchLength, entryLength);
+        batchLength += entryLength;
+        tail.store(currentTail + entryLength, std::memory_order_release);
+    }
+}
+
+bool NetworkRelay::flushDue(bool full) {
+    if (batchLength == 0) {
+        return false;
+    }
+
+    uint32_t used = head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    if (used * 100 >= (uint32_t)NETWORK_RELAY_RING_SIZE * NETWORK_RELAY_URGENT_PERCENT) {
+        return true;
+    }
+
+    // While BLE ingest is busy, fewer and fuller bursts leave the radio to it
+    unsigned long now = millis();
+    if (SenderControl::getState() != FLOW_OPEN) {
+        return now - lastSent >= NETWORK_RELAY_BUSY_BATCH_MS && (full || now - batchStarted >= NETWORK_RELAY_BUSY_BATCH_MS);
+    }
+    return full || now - batchStarted >= NETWORK_RELAY_BATCH_MS;
+}
+
+bool NetworkRelay::sendFrame(const uint8_t* raw, size_t length) {
+    // Stored as they are when compression doesn't pay
+    uint8_t* payload = frame + NETWORK_RELAY_HEADER_SIZE;
+    size_t payloadLength = compressor->compress(raw, length, payload, length > 0 ? length - 1 : 0);
+    uint8_t flags = NETWORK_RELAY_FLAG_COMPRESSED;
+    if (payloadLength == 0) {
+        memcpy(payload, raw, length);
+        payloadLength = length;
+        flags = 0;
+    }
+
+    uint16_t rawLength = length;
+    uint16_t wireLength = payloadLength;
+    frame[0] = NETWORK_RELAY_MAGIC_0;
+    frame[1] = NETWORK_RELAY_MAGIC_1;
+    frame[2] = NETWORK_RELAY_VERSION;
+    frame[3] = flags;
+    memcpy(frame + 4, &sequence, 4);
+    memcpy(frame + 8, &rawLength, 2);
+    memcpy(frame + 10, &wireLength, 2);
+    size_t total = NETWORK_RELAY_HEADER_SIZE + payloadLength;
+
+    bool sent;
+    if (active.udp) {
+        sent = udp.beginPacket(active.host, active.port) && udp.write(frame, total) == total && udp.endPacket();
+    } else {
+        sent = client.write(frame, total) == total;
+    }
+    if (!sent) {
+        Serial.println("Network relay: send failed, reconnecting");
+        return false;
+    }
+
+    // Backoff starts over once a link has carried something
+    sequence++;
+    lastSent = millis();
+    backoffMs = NETWORK_RELAY_BACKOFF_MIN_MS;
+    frames.fetch_add(1, std::memory_order_relaxed);
+    rawBytes.fetch_add(length, std::memory_order_relaxed);
+    bytesOut.fetch_add(total, std::memory_order_relaxed);
+    Metrics::count(METRIC_RELAY_BYTES, total);
+    return true;
+}
+
+bool NetworkRelay::announceDevices() {
+    uint8_t names[DEVICE_REGISTRY_SLOTS * (4 + DEVICE_NAME_LENGTH)];
+    size_t length = 0;
+    for (DeviceId id = 1; id < DeviceRegistry::size() && id < DEVICE_REGISTRY_SLOTS; id++) {
+        uint8_t payload[1 + DEVICE_NAME_LENGTH];
+        size_t payloadLength = SerialMirror::renderDevicePayload(id, payload, sizeof(payload));
+        length += renderEntry(SERIAL_MIRROR_FRAME_DEVICE, payload, payloadLength, names + length, sizeof(names) - length);
+    }
+
+    lastAnnounce = millis() | 1;  // Never 0, which means "not yet"
+    return length == 0 || sendFrame(names, length);
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <WiFiUdp.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include "DeviceRegistry.hpp"
+#include "LogProtocol.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Network relay configuration
+#define NETWORK_RELAY_RING_SIZE 16384      // Power of two; what rides out a reconnect
+#define NETWORK_RELAY_BATCH_SIZE 4096      // Raw bytes per TCP frame, before compression
+#define NETWORK_RELAY_DATAGRAM_SIZE 1400   // Whole UDP frame, so datagrams are never fragmented
+#define NETWORK_RELAY_BATCH_MS 250         // Longest a record waits for its frame ...
+#define NETWORK_RELAY_BUSY_BATCH_MS 1000   // ... while BLE ingest is under flow control
+#define NETWORK_RELAY_URGENT_PERCENT 75    // Ring this full sends at once, busy or not
+#define NETWORK_RELAY_BACKOFF_MIN_MS 1000
+#define NETWORK_RELAY_BACKOFF_MAX_MS 30000
+#define NETWORK_RELAY_CONNECT_TIMEOUT_MS 1000
+#define NETWORK_RELAY_ANNOUNCE_MS 10000    // UDP has no connect, so device names go out again this often
+#define NETWORK_RELAY_DEFAULT_PORT 5140
+#define NETWORK_RELAY_TASK_STACK_SIZE 4096
+#define NETWORK_RELAY_TASK_PRIORITY 1
+#define NETWORK_RELAY_IDLE_MS 50
+#define NETWORK_RELAY_SSID_LENGTH 33
+#define NETWORK_RELAY_PASSWORD_LENGTH 65
+#define NETWORK_RELAY_HOST_LENGTH 64
+
+/*
+ * Relay stream, frames back to back on TCP or one per UDP datagram:
+ *   [0xB7][0x52][version:1][flags:1][sequence:4][rawLength:2][length:2][payload...]
+ * With FLAG_COMPRESSED the payload is an LZ block as in the COMPRESSED wire
+ * frame (LogProtocol::decompress, same dictionary) that expands to rawLength
+ * bytes; otherwise it is those bytes as they are. sequence counts frames
+ * from boot, so a collector sees lost datagrams. The raw bytes are entries
+ * laid out like the serial mirror's frames without magic and sum:
+ *   [type:1][length:2][payload...]
+ * with the RECORD, DEVICE and DROPPED payloads of SerialMirror.hpp. Every
+ * TCP connection starts with a DEVICE entry for each device seen so far.
+ */
+#define NETWORK_RELAY_MAGIC_0 0xB7
+#define NETWORK_RELAY_MAGIC_1 0x52
+#define NETWORK_RELAY_VERSION 1
+#define NETWORK_RELAY_FLAG_COMPRESSED 0x01
+#define NETWORK_RELAY_HEADER_SIZE 12
+
+enum NetworkRelayState : uint8_t {
+    RELAY_OFF,
+    RELAY_UNCONFIGURED,  // No network or collector set
+    RELAY_JOINING,       // Waiting for Wi-Fi
+    RELAY_CONNECTING,    // Waiting for the collector, backing off between attempts
+    RELAY_STREAMING
+};
+
+struct NetworkRelayStats {
+    NetworkRelayState state;
+    uint32_t records;     // Taken into the ring
+    uint32_t dropped;     // No room in the ring
+    uint32_t frames;      // Sent
+    uint32_t rawBytes;    // Entry bytes in the frames sent
+    uint32_t bytes;       // Frame bytes sent
+    uint32_t reconnects;  // Connections to the collector made
+    uint32_t highWaterMark;
+};
+
+/**
+ * NetworkRelay forwards every received record, from all devices, to a
+ * collector on the network. Like the serial mirror, the communications task
+ * only copies the record into a ring; a low-priority task batches the ring
+ * into compressed frames and sends them over TCP or UDP, and when the link
+ * is down records wait in the ring until it is full, then the newest are
+ * dropped and counted. Connections are retried with exponential backoff.
+ *
+ * BLE and Wi-Fi share one radio. Wi-Fi is brought up with modem sleep and
+ * the coexistence arbiter set to prefer Bluetooth, and the relay sends in
+ * few large bursts: while senders are under flow control (BLE ingest is
+ * busy) frames go out at most once per NETWORK_RELAY_BUSY_BATCH_MS, unless
+ * the ring itself is filling up.
+ *
+ * Network, collector and on/off are kept in NVS and set over the serial
+ * port ("relay ..."). write() is for the communications task only; the
+ * rest is safe from any task.
+ */
+class NetworkRelay {
+   public:
+    static void loadSettings();
+    static bool begin();  // Starts Wi-Fi and the relay task when enabled; a no-op otherwise
+    static void end();
+
+    static void write(const LogPacket& packet, DeviceId device, const char* text);
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return enabled; }
+    static bool setNetwork(const char* ssid, const char* password);
+    static bool setCollector(const char* host, uint16_t port, bool udp);
+
+    static NetworkRelayState getState() { return state; }
+    static const char* getStateName(NetworkRelayState state);
+    static NetworkRelayStats getStats();
+
+    // "relay on|off|status", "relay wifi <ssid> [password]", "relay server <host> [port] [tcp|udp]"; false if not a relay command
+    static bool handleCommand(const char* line);
+
+   private:
+    static uint8_t* ring;
+    static std::atomic<uint32_t> head;  // Written by the communications task
+    static std::atomic<uint32_t> tail;  // Written by the relay task
+    static std::atomic<uint32_t> dropped;
+    static uint32_t records;
+    static uint32_t highWaterMark;
+    static uint32_t unreported;  // Dropped since the stream last said so
+    static uint32_t announced;   // Devices (bit per DeviceId) whose DEVICE entry went into the ring
+
+    // Relay task only
+    static uint8_t* batch;
+    static size_t batchLength;
+    static unsigned long batchStarted;
+    static uint8_t* frame;
+    static LogCompressor* compressor;
+    static WiFiClient client;
+    static WiFiUDP udp;
+    static uint32_t sequence;
+    static uint32_t backoffMs;
+    static unsigned long nextAttempt;
+    static unsigned long lastAnnounce;
+    static unsigned long lastSent;
+    static bool linkUp;  // Collector reachable; a new link starts with the device names
+
+    static std::atomic<uint32_t> frames;
+    static std::atomic<uint32_t> rawBytes;
+    static std::atomic<uint32_t> bytesOut;
+    static std::atomic<uint32_t> reconnects;
+
+    struct Settings {
+        char ssid[NETWORK_RELAY_SSID_LENGTH];
+        char password[NETWORK_RELAY_PASSWORD_LENGTH];
+        char host[NETWORK_RELAY_HOST_LENGTH];
+        uint16_t port;
+        bool udp;
+    };
+
+    static volatile bool enabled;
+    static volatile NetworkRelayState state;
+    static volatile bool running;
+    static volatile bool settingsChanged;  // The relay task picks them up and starts over
+    static TaskHandle_t taskHandle;
+    static portMUX_TYPE settingsLock;
+    static Settings settings;  // As set, under settingsLock
+    static Settings active;    // The relay task's copy
+    static Preferences preferences;
+
+    static bool push(const uint8_t* data, size_t length);
+    static size_t renderEntry(uint8_t type, const uint8_t* payload, size_t length, uint8_t* out, size_t capacity);
+    static void saveSettings();
+    static void stopTask();
+
+    static void relayTask(void* parameter);
+    static void applySettings();
+    static bool connect();
+    static void disconnect();
+    static void copyOut(uint32_t position, uint8_t* out, size_t length);
+    static bool fillBatch(size_t limit);  // True if the batch is full
+    static bool flushDue(bool full);
+    static bool sendFrame(const uint8_t* raw, size_t length);
+    static bool announceDevices();
+};
+
+static_assert((NETWORK_RELAY_RING_SIZE & (NETWORK_RELAY_RING_SIZE - 1)) == 0, "NETWORK_RELAY_RING_SIZE must be a power of two");
+static_assert(DEVICE_REGISTRY_SLOTS <= 32, "NetworkRelay keeps announced devices in a 32 bit mask");
+
+}  // namespace Core
+}  // namespace BTLogger
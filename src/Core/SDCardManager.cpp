@@ -1,6 +1,12 @@
 #include "SDCardManager.hpp"
-#include "BluetoothManager.hpp"  // For LogPacket
+#include "LogProtocol.hpp"  // For LogPacket
+#include "LogLineFormat.hpp"
+#include "ClockSync.hpp"
+#include "Metrics.hpp"
+#include "../Hardware/SharedSPIBus.hpp"
+#include <esp_timer.h>
 #include <time.h>
+#include <stddef.h>
 
 namespace BTLogger {
 namespace Core {
@@ -11,21 +17,54 @@ namespace Core {
 SDCardManager::SDCardManager()
     : csPin(SD_CS_PIN), logDirectory("/logs"), maxFileSize(1024 * 1024),  // 1MB
       maxFilesPerSession(10),
-      currentFileSize(0),
-      currentFileNumber(0) {
+      logFormat(SD_DEFAULT_LOG_FORMAT),
+      segmentFiles(SD_SEGMENT_FILES),
+      activeSessionCount(0),
+      endedDevices(0),
+      writeBufferSize(SD_WRITE_BUFFER_SIZE),
+      commitIntervalMs(SD_COMMIT_INTERVAL_MS),
+      commitCount(0),
+      cardBytes(0),
+      usedBytes(0),
+      logQuota(SD_LOG_QUOTA_BYTES),
+      minFreeBytes(SD_MIN_FREE_BYTES),
+      lastRetentionCheck(0),
+      retentionBehind(false),
+      retentionStuck(false),
+      evictedCount(0),
+      usageMeasured(false),
+      lastRecordTime(0),
+      ready(false),
+      mounted(false) {
+    portMUX_INITIALIZE(&spaceLock);
 }
 
 SDCardManager::~SDCardManager() {
-    endCurrentSession();
+    endAllSessions();
+    for (auto& session : sessions) {
+        free(session.writeBuffer);
+        session.writeBuffer = nullptr;
+    }
 }
 
 bool SDCardManager::initialize() {
-    Serial.print("Initializing SD card...");
+    bool success = mount();
+    ready = true;
+    return success;
+}
 
-    // Use VSPI for SD card to avoid conflict - touch will use software SPI
-    SPIClass spi = SPIClass(VSPI);
+bool SDCardManager::mount() {
+    // Before anything can overwrite what the last boot staged
+    WriteAheadStage::initialize();
+
+    Serial.print("Initializing SD card...");
 
-    if (!SD.begin(csPin, spi, 80000000)) {
+    // VSPI for the SD card; the bus object outlives this call and may be shared (see SharedSPIBus).
+    // The UI may be bringing up touch meanwhile, so the mount holds the bus
+    Hardware::SharedSPIBus::lock();
+    bool begun = SD.begin(csPin, Hardware::SharedSPIBus::get(), 80000000, "/sd", SD_MAX_OPEN_FILES);
+    Hardware::SharedSPIBus::unlock();
+    if (!begun) {
         Serial.println("Card Mount Failed");
         return false;
     }
@@ -35,6 +74,7 @@ bool SDCardManager::initialize() {
         Serial.println("No SD card attached");
         return false;
     }
+    mounted = true;
 
     Serial.print("SD Card Type: ");
     if (cardType == CARD_MMC) {
@@ -51,41 +91,84 @@ bool SDCardManager::initialize() {
     uint64_t cardSize = SD.cardSize() / (1024 * 1024);
     Serial.printf("SD Card Size: %lluMB\n", cardSize);
 
+    // The first session's write-back buffer is allocated up front; further ones on demand
+    if (!sessions[0].writeBuffer) {
+        sessions[0].writeBuffer = static_cast<uint8_t*>(malloc(writeBufferSize));
+        if (!sessions[0].writeBuffer) {
+            Serial.println("Failed to allocate SD write buffer");
+            return false;
+        }
+    }
+
     // Ensure log directory exists
     if (!ensureDirectoryExists(logDirectory)) {
         Serial.println("Failed to create log directory");
         return false;
     }
 
+    // Staged records go back first, before new sessions overwrite the stage; a segment reset before its
+    // first commit then isn't removed as empty by the reconcile
+    catalog.load(logDirectory);
+    replayStagedRecords();
+
+    // Both walks take seconds on a big card, so they run later from update() and records are stored meanwhile.
+    // Until the FAT walk, the logs stand in for what is used (SD.totalBytes() would walk the FAT as well)
+    uint64_t logBytes = catalog.getStoredBytes();
+    portENTER_CRITICAL(&spaceLock);
+    cardBytes = SD.cardSize();
+    usedBytes = logBytes;
+    portEXIT_CRITICAL(&spaceLock);
+    beginReconcile();
     return true;
 }
 
 bool SDCardManager::isCardPresent() const {
-    return SD.cardType() != CARD_NONE;
+    return mounted && SD.cardType() != CARD_NONE;
 }
 
-bool SDCardManager::startNewSession(const String& deviceName) {
-    endCurrentSession();
+bool SDCardManager::startNewSession(DeviceId deviceId) {
+    endSession(deviceId);
+    endedDevices &= ~(1UL << deviceId);
+    String deviceName = DeviceRegistry::getName(deviceId);
 
     if (!isCardPresent()) {
         Serial.println("No SD card present for logging");
         return false;
     }
 
-    currentDeviceName = deviceName;
-    currentFileNumber = 1;
-    currentFileSize = 0;
-
-    currentSessionFile = generateLogFileName(deviceName, currentFileNumber);
+    SessionStream* session = nullptr;
+    for (auto& candidate : sessions) {
+        if (!candidate.active) {
+            session = &candidate;
+            break;
+        }
+    }
+    if (!session) {
+        Serial.printf("No free session slot for %s (max %d)\n", deviceName.c_str(), SD_MAX_SESSIONS);
+        return false;
+    }
 
-    Serial.printf("Starting new session: %s\n", currentSessionFile.c_str());
+    // Buffers stay allocated once created so reconnects don't fragment the heap
+    if (!session->writeBuffer) {
+        session->writeBuffer = static_cast<uint8_t*>(malloc(writeBufferSize));
+        if (!session->writeBuffer) {
+            Serial.println("Failed to allocate SD write buffer - writing through");
+        }
+    }
 
-    // Create the initial log file
-    currentFile = SD.open(currentSessionFile, FILE_WRITE);
-    if (!currentFile) {
-        Serial.printf("Failed to create log file: %s\n", currentSessionFile.c_str());
-        return false;
+    // Binary sessions fall back to text if the block can't be allocated
+    session->format = logFormat;
+    if (session->format == LOG_FORMAT_BINARY && !session->blocks.initialize()) {
+        session->format = LOG_FORMAT_TEXT;
     }
+    session->segmented = segmentFiles && session->format == LOG_FORMAT_BINARY;
+
+    session->deviceId = deviceId;
+    session->deviceName = deviceName;
+    session->fileNumber = 1;
+    session->sessionFile = generateLogFileName(deviceName, session->fileNumber, session->format);
+
+    Serial.printf("Starting new session: %s\n", session->sessionFile.c_str());
 
     // Write session header
     String header = String("# BTLogger Session Started\n");
@@ -93,100 +176,673 @@ bool SDCardManager::startNewSession(const String& deviceName) {
     header += "# Time: " + formatTimestamp(millis()) + "\n";
     header += "# Format: timestamp,level,tag,message\n\n";
 
-    currentFile.print(header);
-    currentFile.flush();
-    currentFileSize = header.length();
+    if (!openSessionFile(*session, header)) {
+        return false;
+    }
 
-    Serial.printf("Session started: %s\n", currentSessionFile.c_str());
+    session->active = true;
+    activeSessionCount++;
+    Serial.printf("Session started: %s\n", session->sessionFile.c_str());
     return true;
 }
 
-void SDCardManager::endCurrentSession() {
-    if (currentFile) {
-        String footer = "\n# Session ended: " + formatTimestamp(millis()) + "\n";
-        currentFile.print(footer);
-        currentFile.close();
-        Serial.printf("Session ended: %s\n", currentSessionFile.c_str());
+void SDCardManager::endSession(DeviceId deviceId) {
+    endedDevices |= 1UL << deviceId;
+    SessionStream* session = findSession(deviceId);
+    if (!session) {
+        return;
+    }
+
+    closeSessionFile(*session, "\n# Session ended: " + formatTimestamp(millis()) + "\n");
+    WriteAheadStage::closeFile(slotOf(*session));
+    Serial.printf("Session ended: %s\n", session->sessionFile.c_str());
+
+    // A segment created ahead of a rotation that never came
+    if (session->spareFile) {
+        session->spareFile.close();
+        if (SD.remove(session->spareFileName)) {
+            addUsedSpace(-(int64_t)clusterRound(maxFileSize));
+        }
+        session->spareFileName = "";
     }
 
-    currentSessionFile = "";
-    currentDeviceName = "";
-    currentFileSize = 0;
-    currentFileNumber = 0;
+    session->active = false;
+    session->deviceId = DEVICE_ID_UNKNOWN;
+    session->sessionFile = "";
+    session->deviceName = "";
+    session->fileSize = 0;
+    session->fileNumber = 0;
+    session->pendingSinceUs = 0;
+    activeSessionCount--;
 }
 
-bool SDCardManager::saveLogToSession(const LogPacket& packet, const String& deviceName) {
-    if (!currentFile || currentDeviceName != deviceName) {
-        if (!startNewSession(deviceName)) {
+void SDCardManager::endAllSessions() {
+    for (auto& session : sessions) {
+        if (session.active) {
+            endSession(session.deviceId);
+        }
+    }
+}
+
+bool SDCardManager::saveLogToSession(const LogPacket& packet, DeviceId deviceId) {
+    SessionStream* session = findSession(deviceId);
+    if (!session) {
+        // After its session ended a device only logs again in a new one it starts; a stray record
+        // must not leave a file of its own
+        if (endedDevices & (1UL << deviceId)) {
+            return false;
+        }
+        if (!startNewSession(deviceId)) {
             return false;
         }
+        session = findSession(deviceId);
+    }
+
+    // Check if we need to rotate the file; a segment rotates before a block would run past its preallocation
+    unsigned long reserve = session->segmented ? BINARY_LOG_BLOCK_SIZE : 0;
+    if (session->fileSize + reserve > maxFileSize) {
+        if (!rotateLogFile(*session)) {
+            return false;
+        }
+    }
+    if (session->pendingSinceUs == 0) {
+        session->pendingSinceUs = packet.receivedUs;
+    }
+    lastRecordTime = millis();
+
+    if (session->format == LOG_FORMAT_BINARY) {
+        if (!session->blocks.append(packet)) {
+            // Block full - write it out and start the next one
+            if (!flushBlock(*session) || !session->blocks.append(packet)) {
+                Serial.println("Failed to write log entry to SD card");
+                return false;
+            }
+        }
+        // The block is only written out later, so its position is where the next block starts
+        session->index.noteRecord(session->fileSize, packet.timestamp, packet.level,
+                                  session->blocks.getRecordCount() == 1);
+        stageRecord(*session, packet);
+        if (packet.level >= 4) {
+            commitSession(*session, true);
+        }
+        return true;
+    }
+
+    // Format log entry straight into a line buffer (no String churn)
+    char logEntry[LOG_LINE_MAX_LENGTH];
+    size_t entryLength = LogLineFormat::format(packet, logEntry, sizeof(logEntry));
+    if (entryLength == 0) {
+        return false;
+    }
+
+    // Queue in the session's write-back buffer
+    if (!appendToBuffer(*session, logEntry, entryLength)) {
+        Serial.println("Failed to write log entry to SD card");
+        return false;
+    }
+    session->index.noteRecord(session->fileSize, packet.timestamp, packet.level);
+    uint32_t lines = SessionIndexWriter::countLines(logEntry, entryLength);
+    if (lines > 1) {
+        session->index.noteLines(lines - 1);  // Message with embedded newlines
+    }
+    session->fileSize += entryLength;
+    stageRecord(*session, packet);
+
+    // Errors are committed right away so they survive a crash or power loss
+    if (packet.level >= 4) {
+        commitSession(*session, true);
+    }
+    return true;
+}
+
+String SDCardManager::getSessionFile(DeviceId deviceId) const {
+    for (const auto& session : sessions) {
+        if (session.active && session.deviceId == deviceId) {
+            return session.sessionFile;
+        }
+    }
+    return "";
+}
+
+void SDCardManager::update() {
+    if (reconcileDir) {
+        stepReconcile();
+    }
+
+    unsigned long now = millis();
+    for (auto& session : sessions) {
+        bool pending = session.writeBufferLength > 0 || !session.blocks.isEmpty();
+        if (session.active && pending && now - session.lastCommitTime >= commitIntervalMs) {
+            commitSession(session, true);
+        }
+        if (session.active) {
+            prepareNextSegment(session);
+        }
+    }
+
+    // The FAT walk holds the volume for its whole length, so it waits for a pause in logging
+    if (mounted && !usageMeasured && !reconcileDir && now - lastRecordTime >= SD_USAGE_IDLE_MS &&
+        getPendingBytes() == 0) {
+        measureUsage();
+    }
+
+    // One eviction per call while over budget, so logging in between is never held up for long.
+    // Not before the reconcile has found every file
+    if (!reconcileDir && (retentionBehind || now - lastRetentionCheck >= SD_RETENTION_INTERVAL_MS)) {
+        lastRetentionCheck = now;
+        retentionBehind = enforceRetention();
     }
+}
+
+bool SDCardManager::commit(bool sync) {
+    bool success = true;
+    for (auto& session : sessions) {
+        if (session.active && !commitSession(session, sync)) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+size_t SDCardManager::getPendingBytes() const {
+    size_t pending = 0;
+    for (const auto& session : sessions) {
+        pending += session.writeBufferLength;
+        if (!session.blocks.isEmpty()) {
+            pending += session.blocks.getLength();
+        }
+    }
+    return pending;
+}
 
-    // Check if we need to rotate the file
-    if (currentFileSize > maxFileSize) {
-        if (!rotateLogFile()) {
+bool SDCardManager::setWriteBufferSize(size_t size) {
+    // Keep the buffer a whole number of sectors
+    size = max((size_t)SD_SECTOR_SIZE, size - (size % SD_SECTOR_SIZE));
+
+    commit();
+    for (auto& session : sessions) {
+        if (!session.writeBuffer) {
+            continue;
+        }
+        uint8_t* buffer = static_cast<uint8_t*>(realloc(session.writeBuffer, size));
+        if (!buffer) {
+            Serial.printf("Failed to resize SD write buffer to %d bytes\n", size);
             return false;
         }
+        session.writeBuffer = buffer;
     }
 
-    // Format log entry
-    String logEntry = formatTimestamp(packet.timestamp) + ",";
-    logEntry += String(packet.level) + ",";
-    logEntry += String(packet.tag) + ",";
-    logEntry += String(packet.message) + "\n";
+    writeBufferSize = size;
+    return true;
+}
 
-    // Write to file
-    size_t written = currentFile.print(logEntry);
-    currentFile.flush();
+SessionStream* SDCardManager::findSession(DeviceId deviceId) {
+    for (auto& session : sessions) {
+        if (session.active && session.deviceId == deviceId) {
+            return &session;
+        }
+    }
+    return nullptr;
+}
 
-    if (written > 0) {
-        currentFileSize += written;
+bool SDCardManager::openSessionFile(SessionStream& session, const String& header) {
+    if (session.spareFile && session.spareFileName == session.sessionFile) {
+        // Preallocated ahead of time - rotation costs no allocation
+        session.file = session.spareFile;
+        session.spareFile = File();
+        session.spareFileName = "";
+    } else if (session.segmented) {
+        createSegment(session.sessionFile, session.deviceName, session.file);
+    } else {
+        session.file = SD.open(session.sessionFile, FILE_WRITE);
+    }
+    if (!session.file) {
+        Serial.printf("Failed to create log file: %s\n", session.sessionFile.c_str());
+        return false;
+    }
+    session.fileOffset = 0;
+    session.writeBufferLength = 0;
+    session.lastCommitTime = millis();
+    // A segment's space was accounted when it was created; the index gets a cluster
+    session.allocated = session.segmented ? clusterRound(maxFileSize) : 0;
+    addUsedSpace(SD_CLUSTER_BYTES);
+
+    // Binary files carry a fixed header instead of the text comments
+    if (session.format == LOG_FORMAT_BINARY) {
+        BinaryLogFileHeader fileHeader;
+        BinaryBlockWriter::fillFileHeader(fileHeader, session.deviceName.c_str(), session.segmented);
+        session.blocks.setSeed(fileHeader.blockSeed);
+        session.blocks.reset();
+        appendToBuffer(session, reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+        commitSession(session, true);
+        session.fileSize = sizeof(fileHeader);
+        session.index.open(session.sessionFile);
+        catalog.add(session.sessionFile.c_str(), session.deviceName.c_str(), session.file.size());
+        WriteAheadStage::setFile(slotOf(session), session.sessionFile.c_str());
         return true;
     }
 
-    Serial.println("Failed to write log entry to SD card");
-    return false;
+    appendToBuffer(session, header.c_str(), header.length());
+    commitSession(session, true);
+    session.fileSize = header.length();
+    if (session.index.open(session.sessionFile)) {
+        session.index.noteLines(SessionIndexWriter::countLines(header.c_str(), header.length()));
+    }
+    catalog.add(session.sessionFile.c_str(), session.deviceName.c_str(), session.file.size());
+    WriteAheadStage::setFile(slotOf(session), session.sessionFile.c_str());
+    return true;
 }
 
-std::vector<String> SDCardManager::loadLogFile(const String& path) {
-    std::vector<String> lines;
+void SDCardManager::closeSessionFile(SessionStream& session, const String& footer) {
+    if (session.file) {
+        if (session.format == LOG_FORMAT_TEXT) {
+            appendToBuffer(session, footer.c_str(), footer.length());
+            session.index.noteLines(SessionIndexWriter::countLines(footer.c_str(), footer.length()));
+        }
+        commitSession(session, true);
+        if (session.segmented) {
+            finalizeSegment(session);
+        }
+        session.index.close(session.fileOffset);
+        session.file.close();
+        catalog.update(session.sessionFile.c_str(), session.fileOffset, session.index, false);
+        catalog.save();
+    }
+}
 
-    if (!isCardPresent()) {
-        return lines;
+bool SDCardManager::createSegment(const String& path, const String& deviceName, File& file) {
+    unsigned long start = millis();
+    file = SD.open(path, FILE_WRITE);
+    if (!file) {
+        return false;
     }
 
-    File file = SD.open(path, FILE_READ);
+    // A provisional header marks the file as ours for recovery. Seeking past
+    // the end and writing the last byte makes FatFs allocate the whole chain
+    // in one go; the contents are not cleared. Blocks a deleted file left
+    // there fail the CRC under this file's seed, and the first block header
+    // is zeroed as well, so a spare that is never written reads as empty.
+    BinaryLogFileHeader header;
+    BinaryBlockWriter::fillFileHeader(header, deviceName.c_str(), true);
+    BinaryLogBlockHeader noBlock;
+    memset(&noBlock, 0, sizeof(noBlock));
+    bool success = file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+                   file.write(reinterpret_cast<const uint8_t*>(&noBlock), sizeof(noBlock)) == sizeof(noBlock);
+    if (success && maxFileSize > sizeof(header)) {
+        uint8_t last = 0;
+        success = file.seek(maxFileSize - 1) && file.write(&last, 1) == 1;
+    }
+    file.flush();
+    file.seek(0);
+
+    if (!success) {
+        Serial.printf("Failed to preallocate %s - file will grow as it is written\n", path.c_str());
+    } else {
+        addUsedSpace(clusterRound(maxFileSize));
+        Serial.printf("Preallocated %s (%lu bytes, %lu ms)\n", path.c_str(), maxFileSize, millis() - start);
+    }
+    return true;
+}
+
+void SDCardManager::prepareNextSegment(SessionStream& session) {
+    // Once half a segment is used there is plenty of time to create the next one
+    if (!session.segmented || session.spareFile || session.fileSize < maxFileSize / 2) {
+        return;
+    }
+
+    String path = generateLogFileName(session.deviceName, session.fileNumber + 1, session.format);
+    if (createSegment(path, session.deviceName, session.spareFile)) {
+        session.spareFileName = path;
+    }
+}
+
+void SDCardManager::finalizeSegment(SessionStream& session) {
+    // Everything has been committed, so the file offset is the data length
+    uint32_t dataLength = session.fileOffset;
+    if (!session.file.seek(offsetof(BinaryLogFileHeader, dataLength)) ||
+        session.file.write(reinterpret_cast<const uint8_t*>(&dataLength), sizeof(dataLength)) != sizeof(dataLength)) {
+        Serial.printf("Failed to record segment length for %s\n", session.sessionFile.c_str());
+    }
+    session.file.flush();
+}
+
+void SDCardManager::beginReconcile() {
+    // The one walk of the log directory per boot; browsing uses the catalog from here on
+    reconcileDir = SD.open(logDirectory);
+    if (!reconcileDir || !reconcileDir.isDirectory()) {
+        Serial.printf("Failed to open directory: %s\n", logDirectory.c_str());
+        reconcileDir = File();
+        return;
+    }
+    catalog.beginReconcile();  // Sessions started during the walk are added as seen
+}
+
+void SDCardManager::stepReconcile() {
+    for (int i = 0; i < SD_RECONCILE_STEP_FILES; i++) {
+        File entry = reconcileDir.openNextFile();
+        if (!entry) {
+            reconcileDir.close();
+            reconcileDir = File();
+            catalog.endReconcile();
+            catalog.save();
+            Serial.printf("Session catalog: %d files%s\n", catalog.size(), catalog.isComplete() ? "" : " (incomplete)");
+            return;
+        }
+        String name = entry.name();
+        FileInfo info(name, logDirectory + "/" + name, entry.size(), entry.isDirectory(), "");
+        entry.close();
+        reconcileEntry(info);
+    }
+}
+
+void SDCardManager::reconcileEntry(const FileInfo& info) {
+    bool binary = info.name.endsWith(BINARY_LOG_EXTENSION);
+    if (info.isDirectory || !(binary || info.name.endsWith(".log"))) {
+        return;
+    }
+    // Written by this boot: an open segment has no length yet and a spare no records, neither needs recovery
+    if (isSessionFile(info.path)) {
+        catalog.markSeen(info.name.c_str());
+        return;
+    }
+
+    bool recovered = false;
+    if (binary && !recoverSegment(info, recovered)) {
+        return;  // Empty segment, removed
+    }
+    // Files the catalog doesn't know, or that were still open when it was saved, are read again
+    if (!catalog.markSeen(info.name.c_str()) || recovered) {
+        catalog.scanFile(info.path, info.size);
+    }
+}
+
+bool SDCardManager::isSessionFile(const String& path) const {
+    for (const auto& session : sessions) {
+        if (session.active && (path == session.sessionFile || path == session.spareFileName)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SDCardManager::measureUsage() {
+    // The only full FAT walk; from here on usage is tracked from what we write and delete
+    unsigned long start = millis();
+    uint64_t used = SD.usedBytes();
+    uint64_t total = SD.totalBytes();  // Cached by the walk above
+    portENTER_CRITICAL(&spaceLock);
+    cardBytes = total;
+    usedBytes = used;
+    portEXIT_CRITICAL(&spaceLock);
+    usageMeasured = true;
+    Serial.printf("SD usage: %lluMB of %lluMB (%lu ms), logs %lluMB\n", used / (1024 * 1024), total / (1024 * 1024),
+                  millis() - start, catalog.getStoredBytes() / (1024 * 1024));
+}
+
+bool SDCardManager::recoverSegment(const FileInfo& info, bool& recovered) {
+    File file = SD.open(info.path, FILE_READ);
     if (!file) {
-        Serial.printf("Failed to open file: %s\n", path.c_str());
-        return lines;
+        return true;
+    }
+    BinaryLogReader reader;
+    if (!reader.open(file) || !(reader.getHeader().flags & BINARY_LOG_FLAG_SEGMENT) ||
+        reader.getHeader().dataLength != 0) {
+        file.close();
+        return true;
     }
 
-    String currentLine = "";
-    while (file.available()) {
-        char c = file.read();
-        if (c == '\n') {
-            if (currentLine.length() > 0) {
-                lines.push_back(currentLine);
-                currentLine = "";
-            }
-        } else if (c != '\r') {
-            currentLine += c;
+    // Unclosed: keep the blocks that made it, up to the first torn one
+    BinaryLogRecord record;
+    uint32_t records = 0;
+    while (reader.next(record)) {
+        records++;
+    }
+    uint32_t dataLength = reader.getValidLength();
+    file.close();
+
+    if (records == 0) {
+        // Never written to (e.g. created ahead of a rotation)
+        SD.remove(info.path);
+        SD.remove(SessionIndexWriter::pathFor(info.path));
+        Serial.printf("Removed empty segment %s\n", info.path.c_str());
+        return false;
+    }
+
+    file = SD.open(info.path, "r+");
+    if (file && file.seek(offsetof(BinaryLogFileHeader, dataLength))) {
+        file.write(reinterpret_cast<const uint8_t*>(&dataLength), sizeof(dataLength));
+        Serial.printf("Recovered segment %s: %lu records, %lu bytes\n", info.path.c_str(), (unsigned long)records,
+                      (unsigned long)dataLength);
+        recovered = true;
+    }
+    file.close();
+    return true;
+}
+
+bool SDCardManager::inLogDirectory(const String& path) const {
+    return path.startsWith(logDirectory + "/") && path.indexOf('/', logDirectory.length() + 1) < 0;
+}
+
+bool SDCardManager::commitSession(SessionStream& session, bool sync) {
+    Hardware::SharedSPIBus::Hold bus;  // Other bus users wait out the whole commit
+    int64_t startUs = esp_timer_get_time();
+    bool pending = session.writeBufferLength > 0 || !session.blocks.isEmpty();
+    session.lastCommitTime = millis();
+    // The open binary block goes out with the rest (written through when there is no buffer)
+    bool success = session.file && flushBlock(session);
+    if (!session.file || !session.writeBuffer) {
+        session.writeBufferLength = 0;
+        session.pendingSinceUs = 0;  // Written through, nothing was waiting
+        return success;
+    }
+
+    if (session.writeBufferLength > 0) {
+        success = writeBlock(session, session.writeBufferLength) && success;
+    }
+    // After the data, so index entries never point past what is on the card
+    session.index.flush();
+    if (sync) {
+        session.file.flush();
+        if (success) {
+            WriteAheadStage::committed(slotOf(session));  // Durable now; drop the staged copies
         }
+    }
+    // Text files take more clusters as they grow
+    uint64_t allocated = clusterRound(session.fileOffset);
+    if (allocated > session.allocated) {
+        addUsedSpace(allocated - session.allocated);
+        session.allocated = allocated;
+    }
+    catalog.update(session.sessionFile.c_str(), session.fileOffset, session.index, true);
 
-        // Limit to prevent memory issues
-        if (lines.size() > 1000) {
-            break;
+    int64_t endUs = esp_timer_get_time();
+    if (pending) {
+        Metrics::record(METRIC_HIST_SD_WRITE, endUs - startUs);
+    }
+    if (success && session.pendingSinceUs != 0) {
+        Metrics::record(METRIC_HIST_RX_TO_SD, (uint32_t)endUs - session.pendingSinceUs);
+        session.pendingSinceUs = 0;
+    }
+    return success;
+}
+
+void SDCardManager::stageRecord(SessionStream& session, const LogPacket& packet) {
+    int slot = slotOf(session);
+    while (!WriteAheadStage::stage(slot, packet)) {
+        // Full: the session holding the front back commits, the others keep their buffers
+        int oldest = WriteAheadStage::getOldestSlot();
+        size_t used = WriteAheadStage::getUsed();
+        if (oldest >= 0 && sessions[oldest].active && commitSession(sessions[oldest], true) &&
+            WriteAheadStage::getUsed() < used) {
+            continue;
+        }
+        if (WriteAheadStage::getUsed() == 0) {
+            return;
+        }
+        WriteAheadStage::discardOldest();
+    }
+
+    // A session's group commit is as large as its share of the stage, not its whole write-back buffer
+    size_t sessionCount = activeSessionCount;
+    size_t share = WAL_STAGE_BYTES / max(sessionCount, (size_t)1);
+    if (WriteAheadStage::getUsed(slot) >= share) {
+        commitSession(session, true);
+    }
+}
+
+void SDCardManager::replayStagedRecords() {
+    if (!WriteAheadStage::hasPending()) {
+        return;
+    }
+
+    for (int slot = 0; slot < WAL_STAGE_SLOTS; slot++) {
+        String path = WriteAheadStage::getFile(slot);
+        if (path.isEmpty()) {
+            continue;
+        }
+        if (!SD.exists(path)) {
+            Serial.printf("Staged records for %s dropped - file is gone\n", path.c_str());
+            continue;
+        }
+
+        size_t count = path.endsWith(BINARY_LOG_EXTENSION) ? replayBinary(slot, path) : replayText(slot, path);
+        if (count > 0) {
+            Serial.printf("Replayed %d staged records into %s\n", count, path.c_str());
+        }
+    }
+
+    // The files are still marked open in the catalog, so the reconcile reads them again
+    WriteAheadStage::clear();
+}
+
+size_t SDCardManager::replayText(int slot, const String& path) {
+    File file = SD.open(path, FILE_APPEND);
+    if (!file) {
+        return 0;
+    }
+
+    char line[LOG_LINE_MAX_LENGTH];
+    size_t count = WriteAheadStage::replay(slot, [&](const LogPacket& packet) {
+        size_t length = LogLineFormat::format(packet, line, sizeof(line));
+        file.write(reinterpret_cast<const uint8_t*>(line), length);
+    });
+    if (count > 0) {
+        file.printf("# Replayed %u records staged before a reset\n", (unsigned)count);
+    }
+    file.close();
+    return count;
+}
+
+size_t SDCardManager::replayBinary(int slot, const String& path) {
+    File file = SD.open(path, "r+");
+    BinaryLogReader reader;
+    if (!file || !reader.open(file)) {
+        file.close();
+        return 0;
+    }
+
+    // A segment left open continues after its last good block, where recovery would cut it
+    bool segment = reader.getHeader().flags & BINARY_LOG_FLAG_SEGMENT;
+    uint32_t end = segment ? reader.getHeader().dataLength : file.size();
+    if (segment && end == 0) {
+        BinaryLogRecord record;
+        while (reader.next(record)) {
         }
+        end = reader.getValidLength();
     }
 
-    // Add the last line if it doesn't end with newline
-    if (currentLine.length() > 0) {
-        lines.push_back(currentLine);
+    BinaryBlockWriter blocks;
+    blocks.setSeed(reader.getBlockSeed());
+    if (!blocks.initialize() || !file.seek(end)) {
+        file.close();
+        return 0;
+    }
+    auto writeBlock = [&]() {
+        size_t length = 0;
+        const uint8_t* block = blocks.finish(length);
+        end += file.write(block, length);
+        blocks.reset();
+    };
+    size_t count = WriteAheadStage::replay(slot, [&](const LogPacket& packet) {
+        if (!blocks.append(packet)) {
+            writeBlock();
+            blocks.append(packet);
+        }
+    });
+    if (!blocks.isEmpty()) {
+        writeBlock();
     }
 
+    // Closes the segment out, so recovery leaves it alone
+    if (segment && count > 0 && file.seek(offsetof(BinaryLogFileHeader, dataLength))) {
+        file.write(reinterpret_cast<const uint8_t*>(&end), sizeof(end));
+    }
     file.close();
-    Serial.printf("Loaded %d lines from %s\n", lines.size(), path.c_str());
-    return lines;
+    return count;
+}
+
+bool SDCardManager::appendToBuffer(SessionStream& session, const char* data, size_t length) {
+    if (!session.file) {
+        return false;
+    }
+    if (!session.writeBuffer) {
+        // No buffer available - write through
+        size_t written = session.file.write(reinterpret_cast<const uint8_t*>(data), length);
+        session.fileOffset += written;
+        Metrics::count(METRIC_SD_BYTES, written);
+        return written == length;
+    }
+
+    while (length > 0) {
+        size_t space = writeBufferSize - session.writeBufferLength;
+        size_t chunk = min(space, length);
+        memcpy(session.writeBuffer + session.writeBufferLength, data, chunk);
+        session.writeBufferLength += chunk;
+        data += chunk;
+        length -= chunk;
+
+        if (session.writeBufferLength == writeBufferSize) {
+            // Write up to the next sector boundary in the file so full blocks stay sector aligned
+            size_t aligned = session.writeBufferLength - ((session.fileOffset + session.writeBufferLength) % SD_SECTOR_SIZE);
+            if (!writeBlock(session, aligned)) {
+                return false;
+            }
+        }
+    }
+    Metrics::level(METRIC_LEVEL_WRITE_BUFFER, session.writeBufferLength);
+    return true;
+}
+
+bool SDCardManager::flushBlock(SessionStream& session) {
+    if (session.format != LOG_FORMAT_BINARY || session.blocks.isEmpty()) {
+        return true;
+    }
+
+    size_t blockLength = 0;
+    const uint8_t* block = session.blocks.finish(blockLength);
+    bool success = appendToBuffer(session, reinterpret_cast<const char*>(block), blockLength);
+    session.fileSize += blockLength;
+    session.blocks.reset();
+    return success;
+}
+
+bool SDCardManager::writeBlock(SessionStream& session, size_t length) {
+    size_t written = session.file.write(session.writeBuffer, length);
+    session.fileOffset += written;
+    commitCount++;
+    Metrics::count(METRIC_SD_BYTES, written);
+
+    // Keep whatever did not make it into this block
+    session.writeBufferLength -= written;
+    if (session.writeBufferLength > 0) {
+        memmove(session.writeBuffer, session.writeBuffer + written, session.writeBufferLength);
+    }
+
+    if (written != length) {
+        Serial.printf("SD write short: %d of %d bytes\n", written, length);
+        return false;
+    }
+    return true;
 }
 
 bool SDCardManager::saveLogFile(const String& path, const std::vector<String>& lines) {
@@ -209,12 +865,92 @@ bool SDCardManager::saveLogFile(const String& path, const std::vector<String>& l
     return true;
 }
 
+bool SDCardManager::exportAsText(const String& path, const String& outputPath) {
+    if (!isCardPresent()) {
+        return false;
+    }
+
+    File input = SD.open(path, FILE_READ);
+    if (!input) {
+        Serial.printf("Failed to open file: %s\n", path.c_str());
+        return false;
+    }
+
+    BinaryLogReader reader;
+    if (!reader.open(input)) {
+        input.close();
+        return false;
+    }
+
+    String output = outputPath;
+    if (output.length() == 0) {
+        output = path.endsWith(BINARY_LOG_EXTENSION) ? path.substring(0, path.length() - strlen(BINARY_LOG_EXTENSION)) : path;
+        output += ".log";
+    }
+    File file = SD.open(output, FILE_WRITE);
+    if (!file) {
+        Serial.printf("Failed to create file: %s\n", output.c_str());
+        input.close();
+        return false;
+    }
+
+    // Same layout as a text session file
+    const BinaryLogFileHeader& header = reader.getHeader();
+    file.print("# BTLogger Session Started\n");
+    file.print(String("# Device: ") + header.deviceName + "\n");
+    char startTime[24];
+    ClockSync::formatLocalTime((int64_t)header.startTime * 1000, startTime, sizeof(startTime));
+    file.print(String("# Time: ") + startTime + "\n");
+    file.print("# Format: timestamp,level,tag,message\n\n");
+
+    BinaryLogRecord record;
+    char line[sizeof(record.message) + sizeof(record.tag) + 32];
+    uint32_t count = 0;
+    while (reader.next(record)) {
+        size_t length = BinaryLogReader::formatTextLine(record, line, sizeof(line));
+        file.write(reinterpret_cast<const uint8_t*>(line), length);
+        count++;
+    }
+    if (reader.getSkippedBlocks() > 0) {
+        file.printf("# Skipped %lu damaged blocks\n", (unsigned long)reader.getSkippedBlocks());
+    }
+
+    size_t outputSize = file.size();
+    file.close();
+    input.close();
+    if (inLogDirectory(output)) {
+        catalog.scanFile(output, outputSize);
+        catalog.save();
+    }
+    Serial.printf("Exported %lu records from %s to %s\n", (unsigned long)count, path.c_str(), output.c_str());
+    return true;
+}
+
 bool SDCardManager::deleteFile(const String& path) {
     if (!isCardPresent()) {
         return false;
     }
 
+    // FATFS doesn't lock open files; removing one under a session would corrupt the volume
+    if (isSessionFile(path)) {
+        Serial.printf("Not deleting %s: a session is writing it\n", path.c_str());
+        return false;
+    }
+
+    File file = SD.open(path, FILE_READ);
+    uint64_t size = file ? file.size() : 0;
+    file.close();
+
     if (SD.remove(path)) {
+        uint64_t freed = clusterRound(size);
+        String index = SessionIndexWriter::pathFor(path);
+        if (index != path && SD.exists(index) && SD.remove(index)) {
+            freed += SD_CLUSTER_BYTES;
+        }
+        addUsedSpace(-(int64_t)freed);
+        if (inLogDirectory(path) && catalog.remove(path.c_str())) {
+            catalog.save();
+        }
         Serial.printf("Deleted file: %s\n", path.c_str());
         return true;
     }
@@ -271,7 +1007,17 @@ std::vector<FileInfo> SDCardManager::listDirectory(const String& path) {
 }
 
 std::vector<FileInfo> SDCardManager::listLogFiles() {
-    return listDirectory(logDirectory);
+    if (!catalog.isComplete()) {
+        return listDirectory(logDirectory);
+    }
+
+    std::vector<FileInfo> files;
+    SessionRecord record;
+    files.reserve(catalog.size());
+    for (size_t i = 0; catalog.getEntry(i, record); i++) {
+        files.push_back(FileInfo(record.name, logDirectory + "/" + record.name, (unsigned long)record.size, false, ""));
+    }
+    return files;
 }
 
 FileInfo SDCardManager::getFileInfo(const String& path) {
@@ -290,93 +1036,166 @@ FileInfo SDCardManager::getFileInfo(const String& path) {
     info.path = path;
     info.size = file.size();
     info.isDirectory = file.isDirectory();
-    info.lastModified = formatTimestamp(file.getLastWrite());
+    info.lastModified = formatFileDate(file.getLastWrite());
 
     file.close();
     return info;
 }
 
-unsigned long SDCardManager::getTotalSpace() const {
-    if (!isCardPresent()) {
-        return 0;
+uint64_t SDCardManager::getTotalSpace() const {
+    portENTER_CRITICAL(&spaceLock);
+    uint64_t total = cardBytes;
+    portEXIT_CRITICAL(&spaceLock);
+    return total;
+}
+
+uint64_t SDCardManager::getUsedSpace() const {
+    portENTER_CRITICAL(&spaceLock);
+    uint64_t used = usedBytes;
+    portEXIT_CRITICAL(&spaceLock);
+    return used;
+}
+
+uint64_t SDCardManager::getFreeSpace() const {
+    portENTER_CRITICAL(&spaceLock);
+    uint64_t free = cardBytes > usedBytes ? cardBytes - usedBytes : 0;
+    portEXIT_CRITICAL(&spaceLock);
+    return free;
+}
+
+void SDCardManager::addUsedSpace(int64_t bytes) {
+    portENTER_CRITICAL(&spaceLock);
+    if (bytes < 0 && (uint64_t)-bytes > usedBytes) {
+        usedBytes = 0;
+    } else {
+        usedBytes += bytes;
     }
-    return SD.totalBytes();
+    portEXIT_CRITICAL(&spaceLock);
 }
 
-unsigned long SDCardManager::getUsedSpace() const {
-    if (!isCardPresent()) {
-        return 0;
+uint64_t SDCardManager::clusterRound(uint64_t bytes) {
+    return (bytes + SD_CLUSTER_BYTES - 1) / SD_CLUSTER_BYTES * SD_CLUSTER_BYTES;
+}
+
+bool SDCardManager::enforceRetention() {
+    if (!catalog.isLoaded() || getTotalSpace() == 0) {
+        return false;
+    }
+
+    const char* reason = nullptr;
+    if (logQuota > 0 && catalog.getStoredBytes() > logQuota) {
+        reason = "quota";
+    } else if (getFreeSpace() < minFreeBytes) {
+        reason = "free space";
+    }
+    if (!reason) {
+        retentionStuck = false;
+        return false;
     }
-    return SD.usedBytes();
+
+    if (!evictOldest(nullptr, reason)) {
+        if (!retentionStuck) {
+            Serial.printf("Retention: over %s with no closed session left to remove\n", reason);
+            retentionStuck = true;
+        }
+        return false;
+    }
+    return true;
 }
 
-unsigned long SDCardManager::getFreeSpace() const {
-    if (!isCardPresent()) {
-        return 0;
+bool SDCardManager::evictOldest(const char* deviceName, const char* reason) {
+    SessionRecord oldest;
+    if (!catalog.getOldest(oldest, deviceName)) {
+        return false;
     }
-    return SD.totalBytes() - SD.usedBytes();
+
+    String path = logDirectory + "/" + oldest.name;
+    if (!deleteFile(path)) {
+        if (SD.exists(path)) {
+            return false;
+        }
+        // Already gone from the card
+        catalog.remove(oldest.name);
+        catalog.save();
+    }
+    evictedCount++;
+    Serial.printf("Retention (%s): removed %s, %lluMB free\n", reason, oldest.name, getFreeSpace() / (1024 * 1024));
+    return true;
 }
 
 String SDCardManager::generateSessionFileName(const String& deviceName) {
-    return generateLogFileName(deviceName, 1);
+    return generateLogFileName(deviceName, 1, logFormat);
 }
 
-String SDCardManager::generateLogFileName(const String& deviceName, int fileNumber) {
+String SDCardManager::generateLogFileName(const String& deviceName, int fileNumber, LogFileFormat format) {
     String safeName = deviceName;
     safeName.replace(" ", "_");
     safeName.replace(".", "_");
 
-    String timestamp = formatTimestamp(millis());
-    timestamp.replace(":", "-");
-    timestamp.replace(" ", "_");
+    // Whole seconds: the date and time once known, seconds since boot before
+    String timestamp;
+    if (ClockSync::hasWallClock()) {
+        time_t seconds = ClockSync::toWallUs(ClockSync::now()) / 1000000;
+        struct tm parts;
+        gmtime_r(&seconds, &parts);
+        char text[20];
+        strftime(text, sizeof(text), "%Y%m%d-%H%M%S", &parts);
+        timestamp = text;
+    } else {
+        timestamp = String(millis() / 1000);
+    }
 
     String filename = logDirectory + "/" + safeName + "_" + timestamp;
     if (fileNumber > 1) {
         filename += "_" + String(fileNumber);
     }
-    filename += ".log";
+    filename += format == LOG_FORMAT_BINARY ? BINARY_LOG_EXTENSION : ".log";
 
     return filename;
 }
 
-bool SDCardManager::rotateLogFile() {
-    if (currentFileNumber >= maxFilesPerSession) {
-        Serial.println("Maximum files per session reached");
-        return false;
-    }
-
+bool SDCardManager::rotateLogFile(SessionStream& session) {
     // Close current file
-    closeCurrentFile();
+    closeSessionFile(session, "# File closed: " + formatTimestamp(millis()) + "\n");
 
     // Create new file
-    currentFileNumber++;
-    currentSessionFile = generateLogFileName(currentDeviceName, currentFileNumber);
-
-    currentFile = SD.open(currentSessionFile, FILE_WRITE);
-    if (!currentFile) {
-        Serial.printf("Failed to create rotated log file: %s\n", currentSessionFile.c_str());
-        return false;
-    }
+    session.fileNumber++;
+    session.sessionFile = session.spareFile ? session.spareFileName
+                                            : generateLogFileName(session.deviceName, session.fileNumber, session.format);
 
     // Write rotation header
     String header = String("# Log file rotated\n");
-    header += "# File: " + String(currentFileNumber) + " of session\n";
+    header += "# File: " + String(session.fileNumber) + " of session\n";
     header += "# Time: " + formatTimestamp(millis()) + "\n\n";
 
-    currentFile.print(header);
-    currentFile.flush();
-    currentFileSize = header.length();
+    if (!openSessionFile(session, header)) {
+        return false;
+    }
 
-    Serial.printf("Rotated to new log file: %s\n", currentSessionFile.c_str());
+    Serial.printf("Rotated to new log file: %s\n", session.sessionFile.c_str());
+
+    // Logging never stops at the file limit; the device's oldest file makes room instead
+    if (session.fileNumber > maxFilesPerSession) {
+        evictOldest(session.deviceName.c_str(), "file limit");
+    }
     return true;
 }
 
 String SDCardManager::formatTimestamp(unsigned long timestamp) {
-    // Convert milliseconds to seconds
-    time_t time = timestamp / 1000;
+    // Milliseconds of the local time base, as a date once a sender has told us the wall clock
+    char text[32];
+    ClockSync::formatTime((int64_t)timestamp * 1000, text, sizeof(text));
+    return String(text);
+}
 
-    // Simple timestamp format
-    return String(time);
+String SDCardManager::formatFileDate(time_t seconds) {
+    // FAT dates come from the system clock, which is only right once ClockSync has set it
+    struct tm parts;
+    gmtime_r(&seconds, &parts);
+    char text[24];
+    snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d", parts.tm_year + 1900, parts.tm_mon + 1, parts.tm_mday,
+             parts.tm_hour, parts.tm_min);
+    return String(text);
 }
 
 String SDCardManager::formatFileSize(unsigned long bytes) {
@@ -403,13 +1222,5 @@ bool SDCardManager::ensureDirectoryExists(const String& path) {
     return createDirectory(path);
 }
 
-void SDCardManager::closeCurrentFile() {
-    if (currentFile) {
-        String footer = "# File closed: " + formatTimestamp(millis()) + "\n";
-        currentFile.print(footer);
-        currentFile.close();
-    }
-}
-
 }  // namespace Core
 }  // namespace BTLogger
\ No newline at end of file
@@ -5,6 +5,12 @@
 #include <SPI.h>
 #include <vector>
 #include <functional>
+#include "DeviceRegistry.hpp"
+#include "BinaryLogFormat.hpp"
+#include "LogFileReader.hpp"
+#include "SessionIndex.hpp"
+#include "SessionCatalog.hpp"
+#include "WriteAheadStage.hpp"
 
 namespace BTLogger {
 namespace Core {
@@ -12,6 +18,35 @@ namespace Core {
 // Forward declaration for LogPacket
 struct LogPacket;
 
+// Write-back buffer defaults
+#define SD_SECTOR_SIZE 512
+#define SD_WRITE_BUFFER_SIZE (8 * 1024)
+#define SD_COMMIT_INTERVAL_MS 1000
+
+// Concurrent per-device session streams (one per BLE connection)
+#define SD_MAX_SESSIONS 4
+// Files FATFS can hold open: each session's file, its spare segment and its .idx sidecar, plus the
+// viewer or search reading one, an export writing one and a catalog save or rescan (default is 5)
+#define SD_MAX_OPEN_FILES (SD_MAX_SESSIONS * 3 + 3)
+
+// On-card session format for new files
+enum LogFileFormat {
+    LOG_FORMAT_TEXT,   // timestamp,level,tag,message lines (.log)
+    LOG_FORMAT_BINARY  // Checksummed record blocks, see BinaryLogFormat.hpp (.blg)
+};
+#define SD_DEFAULT_LOG_FORMAT LOG_FORMAT_BINARY
+
+// Retention: the oldest closed session files are deleted to stay within the quota and keep free space
+#define SD_LOG_QUOTA_BYTES 0ULL                   // Log directory limit, 0 for none
+#define SD_MIN_FREE_BYTES (16ULL * 1024 * 1024)  // Free space kept for new files
+#define SD_RETENTION_INTERVAL_MS 2000
+#define SD_CLUSTER_BYTES (32 * 1024)  // Space accounting rounds files up to this (a typical FAT32 cluster)
+#define SD_RECONCILE_STEP_FILES 4      // Log directory entries checked per update() while the boot-time walk runs
+#define SD_USAGE_IDLE_MS 3000          // The FAT walk for used space waits for this long without records
+
+// Binary sessions preallocate each file to maxFileSize so logging never waits on FAT cluster allocation
+#define SD_SEGMENT_FILES true
+
 // File structure for browsing
 struct FileInfo {
     String name;
@@ -25,41 +60,104 @@ struct FileInfo {
         : name(n), path(p), size(s), isDirectory(isDir), lastModified(modified) {}
 };
 
+// Open log file and write-back buffer for one device
+struct SessionStream {
+    DeviceId deviceId;
+    String deviceName;
+    String sessionFile;
+    File file;
+    unsigned long fileSize;
+    int fileNumber;
+
+    // Write-back buffer (committed on full, interval, ERROR records and file close)
+    uint8_t* writeBuffer;
+    size_t writeBufferLength;
+    unsigned long fileOffset;  // Bytes already written to file
+    unsigned long lastCommitTime;
+    uint32_t pendingSinceUs;  // receivedUs of the oldest record not yet committed, 0 if none
+    bool active;
+
+    LogFileFormat format;
+    BinaryBlockWriter blocks;  // Block being filled, binary sessions only
+    SessionIndexWriter index;  // Sidecar index of the current file
+
+    unsigned long allocated;  // Card space accounted for the file so far
+
+    // Preallocated segment mode; the next segment is created ahead of rotation
+    bool segmented;
+    File spareFile;
+    String spareFileName;
+
+    SessionStream() : deviceId(DEVICE_ID_UNKNOWN), fileSize(0), fileNumber(0), writeBuffer(nullptr), writeBufferLength(0),
+                      fileOffset(0), lastCommitTime(0), pendingSinceUs(0), active(false), format(LOG_FORMAT_TEXT), allocated(0), segmented(false) {}
+};
+
 class SDCardManager {
    public:
     SDCardManager();
     ~SDCardManager();
 
-    // Initialization
+    // Initialization (mount, staged record replay and catalog; the storage task runs it once it starts).
+    // The directory reconcile and the usage walk follow from update() while sessions already log
     bool initialize();
+    bool isReady() const { return ready; }  // initialize() has finished, mounted or not
+    bool hasBackgroundWork() const { return reconcileDir; }  // update() wants to be called often
     bool isCardPresent() const;
 
-    // Session management
-    bool startNewSession(const String& deviceName);
-    void endCurrentSession();
-    bool saveLogToSession(const LogPacket& packet, const String& deviceName);
-    String getCurrentSessionFile() const { return currentSessionFile; }
+    // Session management (one session per device, up to SD_MAX_SESSIONS at once)
+    bool startNewSession(DeviceId deviceId);
+    void endSession(DeviceId deviceId);
+    void endAllSessions();
+    bool saveLogToSession(const LogPacket& packet, DeviceId deviceId);
+    String getSessionFile(DeviceId deviceId) const;
+    size_t getActiveSessionCount() const { return activeSessionCount; }
+
+    // Write-back buffers: commit pending data if the interval elapsed (call periodically)
+    void update();
+    bool commit(bool sync = true);
 
     // File operations
-    std::vector<String> loadLogFile(const String& path);
     bool saveLogFile(const String& path, const std::vector<String>& lines);
     bool deleteFile(const String& path);
+
+    // Write a binary session file out in the text format (default: same name with .log)
+    bool exportAsText(const String& path, const String& outputPath = "");
     bool createDirectory(const String& path);
 
     // File browsing
     std::vector<FileInfo> listDirectory(const String& path = "/");
-    std::vector<FileInfo> listLogFiles();
+    std::vector<FileInfo> listLogFiles();  // From the session catalog once it is complete
+    const SessionCatalog& getCatalog() const { return catalog; }
     FileInfo getFileInfo(const String& path);
 
-    // Storage info
-    unsigned long getTotalSpace() const;
-    unsigned long getUsedSpace() const;
-    unsigned long getFreeSpace() const;
+    // Storage info; used space is estimated from the catalog until the one FAT walk (once logging pauses),
+    // then tracked from our own writes
+    uint64_t getTotalSpace() const;
+    uint64_t getUsedSpace() const;
+    uint64_t getFreeSpace() const;
+
+    // Retention, run from update()
+    void setQuota(uint64_t bytes) { logQuota = bytes; }  // 0 for no limit besides free space
+    uint64_t getQuota() const { return logQuota; }
+    void setMinFreeSpace(uint64_t bytes) { minFreeBytes = bytes; }
+    uint64_t getLogBytes() const { return catalog.getStoredBytes(); }
+    uint32_t getEvictedCount() const { return evictedCount; }
 
     // Configuration
-    void setLogDirectory(const String& dir) { logDirectory = dir; }
+    void setLogDirectory(const String& dir) { logDirectory = dir; }  // Before initialize()
+    const String& getLogDirectory() const { return logDirectory; }
     void setMaxFileSize(unsigned long maxSize) { maxFileSize = maxSize; }
-    void setMaxFiles(int maxFiles) { maxFilesPerSession = maxFiles; }
+    void setMaxFiles(int maxFiles) { maxFilesPerSession = maxFiles; }  // Past it each rotation evicts the device's oldest file
+    bool setWriteBufferSize(size_t size);
+    void setCommitInterval(unsigned long intervalMs) { commitIntervalMs = intervalMs; }
+    void setLogFormat(LogFileFormat format) { logFormat = format; }  // Applies from the next file
+    LogFileFormat getLogFormat() const { return logFormat; }
+    void setSegmentFiles(bool enabled) { segmentFiles = enabled; }  // Binary format only, from the next session
+    bool isSegmentFiles() const { return segmentFiles; }
+
+    // Write statistics
+    uint32_t getCommitCount() const { return commitCount; }
+    size_t getPendingBytes() const;
 
    private:
     // Configuration
@@ -67,23 +165,79 @@ class SDCardManager {
     String logDirectory;
     unsigned long maxFileSize;
     int maxFilesPerSession;
-
-    // Current session
-    String currentSessionFile;
-    String currentDeviceName;
-    File currentFile;
-    unsigned long currentFileSize;
-    int currentFileNumber;
+    LogFileFormat logFormat;
+    bool segmentFiles;
+
+    // Open sessions
+    SessionStream sessions[SD_MAX_SESSIONS];
+    volatile size_t activeSessionCount;
+    uint32_t endedDevices;  // Bit per DeviceId whose session was ended and not started again
+
+    // Write-back buffer settings shared by all sessions
+    size_t writeBufferSize;
+    unsigned long commitIntervalMs;
+    uint32_t commitCount;
+
+    // Sessions in logDirectory, kept up to date as files are written
+    SessionCatalog catalog;
+
+    // Space accounting and retention
+    uint64_t cardBytes;
+    uint64_t usedBytes;
+    mutable portMUX_TYPE spaceLock;
+    uint64_t logQuota;
+    uint64_t minFreeBytes;
+    unsigned long lastRetentionCheck;
+    bool retentionBehind;  // Still over budget after the last eviction
+    bool retentionStuck;   // Over budget with nothing left to evict
+    uint32_t evictedCount;
+    bool usageMeasured;
+    unsigned long lastRecordTime;
+
+    // The boot-time walk of the log directory, a few entries per update()
+    File reconcileDir;
+
+    volatile bool ready;
+    volatile bool mounted;
 
     // Internal methods
+    bool mount();
     String generateSessionFileName(const String& deviceName);
-    String generateLogFileName(const String& deviceName, int fileNumber);
-    bool rotateLogFile();
+    String generateLogFileName(const String& deviceName, int fileNumber, LogFileFormat format);
+    bool rotateLogFile(SessionStream& session);
     String formatTimestamp(unsigned long timestamp);
+    String formatFileDate(time_t seconds);
     String formatFileSize(unsigned long bytes);
     bool ensureDirectoryExists(const String& path);
-    void closeCurrentFile();
+    SessionStream* findSession(DeviceId deviceId);
+    bool openSessionFile(SessionStream& session, const String& header);
+    bool flushBlock(SessionStream& session);
+    bool createSegment(const String& path, const String& deviceName, File& file);
+    void prepareNextSegment(SessionStream& session);
+    void finalizeSegment(SessionStream& session);
+    void beginReconcile();
+    void stepReconcile();
+    void reconcileEntry(const FileInfo& info);
+    bool isSessionFile(const String& path) const;
+    void measureUsage();
+    bool recoverSegment(const FileInfo& info, bool& recovered);
+    bool inLogDirectory(const String& path) const;
+    void addUsedSpace(int64_t bytes);
+    static uint64_t clusterRound(uint64_t bytes);
+    bool enforceRetention();
+    bool evictOldest(const char* deviceName, const char* reason);
+    void closeSessionFile(SessionStream& session, const String& footer);
+    bool commitSession(SessionStream& session, bool sync);
+    bool appendToBuffer(SessionStream& session, const char* data, size_t length);
+    int slotOf(const SessionStream& session) const { return &session - sessions; }
+    void stageRecord(SessionStream& session, const LogPacket& packet);
+    void replayStagedRecords();
+    size_t replayText(int slot, const String& path);
+    size_t replayBinary(int slot, const String& path);
+    bool writeBlock(SessionStream& session, size_t length);
 };
 
+static_assert(DEVICE_REGISTRY_SLOTS <= 32, "SDCardManager keeps ended sessions in a 32 bit mask");
+
 }  // namespace Core
 }  // namespace BTLogger
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "SenderControl.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+SenderControl::TagLevel SenderControl::levels[SENDER_CONTROL_MAX_TAGS];
+FlowWindow SenderControl::sent[DEVICE_REGISTRY_SLOTS];
+uint32_t SenderControl::connected = 0;
+volatile FlowState SenderControl::state = FLOW_OPEN;
+volatile uint8_t SenderControl::load = 0;
+unsigned long SenderControl::lowSince = 0;
+portMUX_TYPE SenderControl::lock = portMUX_INITIALIZER_UNLOCKED;
+
+void SenderControl::begin(DeviceId device) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return;
+    }
+
+    // A sender starts out open and without tag levels
+    uint32_t bit = 1UL << device;
+    portENTER_CRITICAL(&lock);
+    connected |= bit;
+    sent[device] = {0, 0};
+    for (TagLevel& entry : levels) {
+        if (entry.used && entry.level != WIRE_LEVEL_CLEAR) {
+            entry.pending |= bit;
+        } else {
+            entry.pending &= ~bit;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void SenderControl::end(DeviceId device) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return;
+    }
+
+    uint32_t bit = 1UL << device;
+    portENTER_CRITICAL(&lock);
+    connected &= ~bit;
+    for (TagLevel& entry : levels) {
+        entry.pending &= ~bit;
+        if (entry.used && entry.level == WIRE_LEVEL_CLEAR && entry.pending == 0) {
+            entry.used = false;  // Nobody left to tell
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void SenderControl::updateLoad(uint8_t percent) {
+    unsigned long now = millis();
+    load = percent;
+
+    // Tighten at once, open up one step at a time after a quiet spell
+    FlowState next = state;
+    if (percent >= FLOW_SATURATED_PERCENT) {
+        next = FLOW_SATURATED;
+    } else if (percent >= FLOW_BUSY_PERCENT && state == FLOW_OPEN) {
+        next = FLOW_BUSY;
+    } else if (percent >= FLOW_RELEASE_PERCENT || state == FLOW_OPEN) {
+        lowSince = now;
+    } else if (now - lowSince >= FLOW_RELEASE_MS) {
+        next = (FlowState)(state - 1);
+    }
+
+    if (next != state) {
+        Serial.printf("Flow control: %s -> %s (load %u%%)\n", getStateName(state), getStateName(next), percent);
+        state = next;
+        lowSince = now;
+    }
+}
+
+FlowWindow SenderControl::getWindow() {
+    switch (state) {
+        case FLOW_BUSY:
+            return {FLOW_BUSY_MIN_LEVEL, 0};
+        case FLOW_SATURATED:
+            return {FLOW_BUSY_MIN_LEVEL, FLOW_SATURATED_RATE};
+        default:
+            return {0, 0};
+    }
+}
+
+const char* SenderControl::getStateName(FlowState state) {
+    switch (state) {
+        case FLOW_OPEN:
+            return "open";
+        case FLOW_BUSY:
+            return "busy";
+        case FLOW_SATURATED:
+            return "saturated";
+        default:
+            return "?";
+    }
+}
+
+bool SenderControl::takeFlow(DeviceId device, FlowWindow& window) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return false;
+    }
+
+    FlowWindow current = getWindow();
+    portENTER_CRITICAL(&lock);
+    bool changed = sent[device] != current;
+    sent[device] = current;
+    portEXIT_CRITICAL(&lock);
+
+    window = current;
+    return changed;
+}
+
+bool SenderControl::setLevel(const char* tag, uint8_t level) {
+    if (!tag) {
+        tag = "";
+    }
+
+    bool stored = true;
+    portENTER_CRITICAL(&lock);
+    TagLevel* entry = findLevel(tag);
+    if (!entry && level != WIRE_LEVEL_CLEAR) {
+        for (TagLevel& slot : levels) {
+            if (!slot.used) {
+                entry = &slot;
+                strncpy(entry->tag, tag, sizeof(entry->tag) - 1);
+                entry->tag[sizeof(entry->tag) - 1] = '\0';
+                entry->used = true;
+                break;
+            }
+        }
+        stored = entry != nullptr;
+    }
+    if (entry) {
+        entry->level = level;
+        entry->pending = connected;
+        if (level == WIRE_LEVEL_CLEAR && entry->pending == 0) {
+            entry->used = false;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (!stored) {
+        Serial.printf("Sender levels: no room for tag %s\n", tag);
+    }
+    return stored;
+}
+
+uint8_t SenderControl::getLevel(const char* tag) {
+    portENTER_CRITICAL(&lock);
+    TagLevel* entry = findLevel(tag ? tag : "");
+    uint8_t level = entry ? entry->level : WIRE_LEVEL_CLEAR;
+    portEXIT_CRITICAL(&lock);
+    return level;
+}
+
+bool SenderControl::takeLevel(DeviceId device, char* tag, uint8_t& level) {
+    if (device >= DEVICE_REGISTRY_SLOTS) {
+        return false;
+    }
+
+    uint32_t bit = 1UL << device;
+    bool taken = false;
+    portENTER_CRITICAL(&lock);
+    for (TagLevel& entry : levels) {
+        if (!entry.used || !(entry.pending & bit)) {
+            continue;
+        }
+        strcpy(tag, entry.tag);
+        level = entry.level;
+        entry.pending &= ~bit;
+        if (entry.level == WIRE_LEVEL_CLEAR && entry.pending == 0) {
+            entry.used = false;  // Every sender has been told
+        }
+        taken = true;
+        break;
+    }
+    portEXIT_CRITICAL(&lock);
+    return taken;
+}
+
+SenderControl::TagLevel* SenderControl::findLevel(const char* tag) {
+    for (TagLevel& entry : levels) {
+        if (entry.used && strcmp(entry.tag, tag) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include "DeviceRegistry.hpp"
+#include "LogProtocol.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Flow control: load is the fullest of the ingest ring, the storage queue and the UI queue, in percent
+#define FLOW_UPDATE_INTERVAL_MS 250
+#define FLOW_BUSY_PERCENT 50        // Senders drop VERBOSE and DEBUG ...
+#define FLOW_SATURATED_PERCENT 85   // ... and cap the rest below WARN at FLOW_SATURATED_RATE
+#define FLOW_RELEASE_PERCENT 25     // Under this for FLOW_RELEASE_MS, step back one state
+#define FLOW_RELEASE_MS 3000
+#define FLOW_BUSY_MIN_LEVEL 2       // INFO
+#define FLOW_SATURATED_RATE 50      // Records per second, per sender
+
+// Tag levels pushed to every sender (wire version 6+)
+#define SENDER_CONTROL_MAX_TAGS 16
+
+enum FlowState : uint8_t {
+    FLOW_OPEN,
+    FLOW_BUSY,
+    FLOW_SATURATED
+};
+
+// What senders are asked to hold to; all zero while open
+struct FlowWindow {
+    uint8_t minLevel;  // Records below it are dropped at the source
+    uint16_t rate;     // Records per second below WARN, 0 for no limit
+
+    bool operator==(const FlowWindow& other) const { return minLevel == other.minLevel && rate == other.rate; }
+    bool operator!=(const FlowWindow& other) const { return !(*this == other); }
+};
+
+/**
+ * SenderControl is what BTLogger tells its senders. When the ingest ring,
+ * the storage queue or the UI queue fills up it advertises a flow window,
+ * so senders drop DEBUG at the source instead of the receiver dropping
+ * whatever line happens to meet a full queue; once the load has stayed low
+ * for a while the window opens again one step at a time.
+ *
+ * It also holds the tag levels set on the Sender Levels screen. They apply
+ * to every connected sender and are sent again to each one that connects.
+ *
+ * The communications task updates the load and takes what is due for each
+ * device (takeFlow, takeLevel); levels can be set from any task.
+ */
+class SenderControl {
+   public:
+    static void begin(DeviceId device);  // Connection up: the current window and every tag level go out again
+    static void end(DeviceId device);
+
+    static void updateLoad(uint8_t percent);
+    static FlowState getState() { return state; }
+    static FlowWindow getWindow();
+    static uint8_t getLoad() { return load; }
+    static const char* getStateName(FlowState state);
+
+    // Window to send to device, if it changed since the last one it got
+    static bool takeFlow(DeviceId device, FlowWindow& window);
+
+    // Level for tag, or for all tags with an empty one; WIRE_LEVEL_CLEAR removes it
+    static bool setLevel(const char* tag, uint8_t level);
+    static uint8_t getLevel(const char* tag);  // WIRE_LEVEL_CLEAR when none is set
+
+    // Next level change to send to device; tag has room for sizeof(LogPacket::tag) bytes
+    static bool takeLevel(DeviceId device, char* tag, uint8_t& level);
+
+   private:
+    struct TagLevel {
+        char tag[sizeof(LogPacket::tag)];  // Empty for the level of all tags
+        uint8_t level;
+        bool used;
+        uint32_t pending;  // Devices (bit per DeviceId) still to be told
+    };
+
+    static TagLevel levels[SENDER_CONTROL_MAX_TAGS];
+    static FlowWindow sent[DEVICE_REGISTRY_SLOTS];
+    static uint32_t connected;  // Bit per DeviceId
+    static volatile FlowState state;
+    static volatile uint8_t load;
+    static unsigned long lowSince;
+    static portMUX_TYPE lock;
+
+    static TagLevel* findLevel(const char* tag);
+};
+
+static_assert(DEVICE_REGISTRY_SLOTS <= 32, "SenderControl keeps pending devices in a 32 bit mask");
+
+}  // namespace Core
+}  // namespace BTLogger
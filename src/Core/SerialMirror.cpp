@@ -0,0 +1,399 @@
+#include "SerialMirror.hpp"
+#include "ClockSync.hpp"
+#include "Metrics.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+uint8_t* SerialMirror::ring = nullptr;
+std::atomic<uint32_t> SerialMirror::head(0);
+std::atomic<uint32_t> SerialMirror::tail(0);
+std::atomic<uint32_t> SerialMirror::dropped(0);
+std::atomic<uint32_t> SerialMirror::bytesOut(0);
+uint32_t SerialMirror::records = 0;
+uint32_t SerialMirror::highWaterMark = 0;
+uint32_t SerialMirror::unreported = 0;
+uint32_t SerialMirror::announced = 0;
+SerialMirrorFormat SerialMirror::writtenFormat = SERIAL_MIRROR_OFF;
+volatile SerialMirrorFormat SerialMirror::format = SERIAL_MIRROR_TEXT;
+volatile uint32_t SerialMirror::baud = SERIAL_MIRROR_DEFAULT_BAUD;
+volatile uint32_t SerialMirror::appliedBaud = SERIAL_MIRROR_DEFAULT_BAUD;
+TaskHandle_t SerialMirror::taskHandle = nullptr;
+volatile bool SerialMirror::running = false;
+volatile bool SerialMirror::holdRequested = false;
+volatile bool SerialMirror::parked = false;
+Preferences SerialMirror::preferences;
+SerialMirror::CommandHandler SerialMirror::commandHandler;
+char SerialMirror::commandLine[SERIAL_MIRROR_COMMAND_LENGTH];
+size_t SerialMirror::commandLength = 0;
+
+static const uint32_t supportedBauds[] = {115200, 230400, 460800, 921600, 2000000};
+
+void SerialMirror::loadSettings() {
+    preferences.begin("serial_mirror", true);  // Read-only mode
+    uint8_t storedFormat = preferences.getUChar("format", SERIAL_MIRROR_TEXT);
+    uint32_t storedBaud = preferences.getUInt("baud", SERIAL_MIRROR_DEFAULT_BAUD);
+    preferences.end();
+
+    format = storedFormat < SERIAL_MIRROR_FORMATS ? (SerialMirrorFormat)storedFormat : SERIAL_MIRROR_TEXT;
+    baud = SERIAL_MIRROR_DEFAULT_BAUD;
+    for (uint32_t supported : supportedBauds) {
+        if (supported == storedBaud) {
+            baud = storedBaud;
+        }
+    }
+    appliedBaud = baud;
+}
+
+bool SerialMirror::begin() {
+    if (ring) {
+        return true;
+    }
+
+    ring = static_cast<uint8_t*>(malloc(SERIAL_MIRROR_RING_SIZE));
+    if (!ring) {
+        Serial.printf("Failed to allocate serial mirror ring (%d bytes)\n", SERIAL_MIRROR_RING_SIZE);
+        return false;
+    }
+    head.store(0);
+    tail.store(0);
+
+    running = true;
+    if (xTaskCreatePinnedToCore(mirrorTask, "SerialMirror", SERIAL_MIRROR_TASK_STACK_SIZE, nullptr,
+                                SERIAL_MIRROR_TASK_PRIORITY, &taskHandle, 0) != pdPASS) {
+        Serial.println("Failed to start serial mirror task");
+        running = false;
+        free(ring);
+        ring = nullptr;
+        return false;
+    }
+
+    Serial.printf("Serial mirror ready: %s at %lu baud, %d byte ring\n", getFormatName(format), (unsigned long)baud,
+                  SERIAL_MIRROR_RING_SIZE);
+    return true;
+}
+
+void SerialMirror::end() {
+    if (!ring) {
+        return;
+    }
+
+    // The task frees nothing; wait for it to leave the ring alone
+    running = false;
+    if (taskHandle) {
+        xTaskNotifyGive(taskHandle);
+    }
+    unsigned long timeout = millis() + 500;
+    while (taskHandle && millis() < timeout) {
+        vTaskDelay(pdMS_TO_TICKS(5));
+    }
+    if (!taskHandle) {
+        free(ring);
+        ring = nullptr;
+    }
+}
+
+void SerialMirror::write(const LogPacket& packet, DeviceId device, const char* text) {
+    SerialMirrorFormat current = format;
+    if (!ring || !running || current == SERIAL_MIRROR_OFF) {
+        return;
+    }
+    if (current != writtenFormat) {
+        writtenFormat = current;
+        announced = 0;
+    }
+
+    // Say what was lost before the next record, once there is room for it
+    uint8_t buffer[512];
+    if (unreported > 0) {
+        size_t length;
+        if (current == SERIAL_MIRROR_BINARY) {
+            size_t payloadLength = renderDroppedPayload(unreported, buffer + 5, sizeof(buffer) - 6);
+            length = renderFrame(SERIAL_MIRROR_FRAME_DROPPED, buffer + 5, payloadLength, buffer, sizeof(buffer));
+        } else {
+            length = snprintf((char*)buffer, sizeof(buffer), "[serial mirror] %lu records dropped\n", (unsigned long)unreported);
+        }
+        if (!push(buffer, length)) {
+            unreported++;
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            Metrics::count(METRIC_SERIAL_DROPPED);
+            return;
+        }
+        unreported = 0;
+    }
+
+    if (current == SERIAL_MIRROR_BINARY && device < DEVICE_REGISTRY_SLOTS && !(announced & (1UL << device))) {
+        size_t payloadLength = renderDevicePayload(device, buffer + 5, sizeof(buffer) - 6);
+        if (push(buffer, renderFrame(SERIAL_MIRROR_FRAME_DEVICE, buffer + 5, payloadLength, buffer, sizeof(buffer)))) {
+            announced |= 1UL << device;
+        }
+    }
+
+    size_t length = current == SERIAL_MIRROR_BINARY ? renderRecord(packet, device, text, buffer, sizeof(buffer))
+                                                    : renderText(packet, device, text, (char*)buffer, sizeof(buffer));
+    if (length > 0 && push(buffer, length)) {
+        records++;
+        return;
+    }
+    unreported++;
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    Metrics::count(METRIC_SERIAL_DROPPED);
+}
+
+void SerialMirror::setFormat(SerialMirrorFormat next) {
+    if (next >= SERIAL_MIRROR_FORMATS || next == format) {
+        return;
+    }
+    format = next;
+    saveSettings();
+}
+
+const char* SerialMirror::getFormatName(SerialMirrorFormat value) {
+    switch (value) {
+        case SERIAL_MIRROR_OFF:
+            return "Off";
+        case SERIAL_MIRROR_TEXT:
+            return "Text";
+        case SERIAL_MIRROR_TIMESTAMPED:
+            return "Timestamped";
+        case SERIAL_MIRROR_BINARY:
+            return "Binary";
+        default:
+            return "?";
+    }
+}
+
+void SerialMirror::setBaud(uint32_t next) {
+    if (next == baud) {
+        return;
+    }
+    baud = next;
+    saveSettings();
+    if (taskHandle) {
+        xTaskNotifyGive(taskHandle);
+    }
+}
+
+uint32_t SerialMirror::stepBaud(uint32_t current, bool up) {
+    const size_t count = sizeof(supportedBauds) / sizeof(supportedBauds[0]);
+    for (size_t i = 0; i < count; i++) {
+        if (supportedBauds[i] == current) {
+            if (up) {
+                return supportedBauds[i + 1 < count ? i + 1 : i];
+            }
+            return supportedBauds[i > 0 ? i - 1 : 0];
+        }
+    }
+    return SERIAL_MIRROR_DEFAULT_BAUD;
+}
+
+void SerialMirror::hold(bool held) {
+    holdRequested = held;
+    if (taskHandle) {
+        xTaskNotifyGive(taskHandle);
+    }
+}
+
+SerialMirrorStats SerialMirror::getStats() {
+    SerialMirrorStats stats;
+    stats.records = records;
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.bytes = bytesOut.load(std::memory_order_relaxed);
+    stats.highWaterMark = highWaterMark;
+    return stats;
+}
+
+bool SerialMirror::push(const uint8_t* data, size_t length) {
+    uint32_t currentHead = head.load(std::memory_order_relaxed);
+    uint32_t used = currentHead - tail.load(std::memory_order_acquire);
+    if (length == 0 || length > SERIAL_MIRROR_RING_SIZE - used) {
+        return false;
+    }
+
+    // Wraps at most once
+    size_t offset = currentHead & (SERIAL_MIRROR_RING_SIZE - 1);
+    size_t first = min(length, (size_t)SERIAL_MIRROR_RING_SIZE - offset);
+    memcpy(ring + offset, data, first);
+    memcpy(ring, data + first, length - first);
+    head.store(currentHead + length, std::memory_order_release);
+
+    if (used == 0 && taskHandle) {
+        xTaskNotifyGive(taskHandle);  // It sleeps while the ring is empty
+    }
+    if (used + length > highWaterMark) {
+        highWaterMark = used + length;
+    }
+    return true;
+}
+
+size_t SerialMirror::renderText(const LogPacket& packet, DeviceId device, const char* text, char* out, size_t capacity) {
+    int length;
+    if (format == SERIAL_MIRROR_TIMESTAMPED) {
+        static const char levels[] = "VDIWE";
+        char time[32];
+        ClockSync::formatTime((int64_t)packet.timestamp * 1000 + packet.micros, time, sizeof(time), true);
+        length = snprintf(out, capacity, "%s %c [%s] %s: %s\n", time, packet.level < 5 ? levels[packet.level] : '?',
+                          DeviceRegistry::getName(device), packet.tag, text);
+    } else {
+        length = snprintf(out, capacity, "[%s] %s: %s\n", DeviceRegistry::getName(device), packet.tag, text);
+    }
+
+    // A line cut short still ends the line
+    if (length < 0) {
+        return 0;
+    }
+    if ((size_t)length >= capacity) {
+        out[capacity - 2] = '\n';
+        return capacity - 1;
+    }
+    return length;
+}
+
+size_t SerialMirror::renderFrame(uint8_t type, const uint8_t* payload, size_t length, uint8_t* out, size_t capacity) {
+    if (length + 6 > capacity) {
+        return 0;
+    }
+
+    out[0] = SERIAL_MIRROR_MAGIC_0;
+    out[1] = SERIAL_MIRROR_MAGIC_1;
+    out[2] = type;
+    out[3] = length & 0xFF;
+    out[4] = length >> 8;
+    if (payload != out + 5) {
+        memmove(out + 5, payload, length);
+    }
+
+    uint8_t sum = 0;
+    for (size_t i = 2; i < length + 5; i++) {
+        sum += out[i];
+    }
+    out[length + 5] = sum;
+    return length + 6;
+}
+
+size_t SerialMirror::renderRecord(const LogPacket& packet, DeviceId device, const char* text, uint8_t* out, size_t capacity) {
+    // Payload straight into place behind the frame header
+    if (capacity < 6) {
+        return 0;
+    }
+    size_t length = renderRecordPayload(packet, device, text, out + 5, capacity - 6);
+    return length > 0 ? renderFrame(SERIAL_MIRROR_FRAME_RECORD, out + 5, length, out, capacity) : 0;
+}
+
+size_t SerialMirror::renderRecordPayload(const LogPacket& packet, DeviceId device, const char* text, uint8_t* out,
+                                         size_t capacity) {
+    size_t tagLength = strnlen(packet.tag, sizeof(packet.tag) - 1);
+    size_t textLength = strnlen(text, sizeof(packet.message) - 1);
+    size_t length = 10 + tagLength + textLength;
+    if (length > capacity) {
+        return 0;
+    }
+
+    // Formatted, so the tokenized flag no longer applies
+    out[0] = device;
+    out[1] = packet.level;
+    out[2] = packet.flags & ~WIRE_RECORD_FLAG_TOKENIZED;
+    memcpy(out + 3, &packet.timestamp, 4);
+    memcpy(out + 7, &packet.micros, 2);
+    out[9] = tagLength;
+    memcpy(out + 10, packet.tag, tagLength);
+    memcpy(out + 10 + tagLength, text, textLength);
+    return length;
+}
+
+size_t SerialMirror::renderDevicePayload(DeviceId device, uint8_t* out, size_t capacity) {
+    const char* name = DeviceRegistry::getName(device);
+    size_t nameLength = strnlen(name, DEVICE_NAME_LENGTH);
+    if (1 + nameLength > capacity) {
+        return 0;
+    }
+
+    out[0] = device;
+    memcpy(out + 1, name, nameLength);
+    return 1 + nameLength;
+}
+
+size_t SerialMirror::renderDroppedPayload(uint32_t count, uint8_t* out, size_t capacity) {
+    if (capacity < sizeof(count)) {
+        return 0;
+    }
+    memcpy(out, &count, sizeof(count));
+    return sizeof(count);
+}
+
+void SerialMirror::saveSettings() {
+    preferences.begin("serial_mirror", false);
+    preferences.putUChar("format", format);
+    preferences.putUInt("baud", baud);
+    preferences.end();
+}
+
+void SerialMirror::mirrorTask(void* parameter) {
+    while (running) {
+        readCommands();
+        drain();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SERIAL_MIRROR_IDLE_MS));
+    }
+
+    taskHandle = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void SerialMirror::drain() {
+    while (running) {
+        // Chunks go out whole, so between two of them the port can be handed over
+        parked = holdRequested;
+        if (parked) {
+            return;
+        }
+
+        uint32_t currentTail = tail.load(std::memory_order_relaxed);
+        uint32_t waiting = head.load(std::memory_order_acquire) - currentTail;
+
+        // A new rate once everything queued at the old one has gone out
+        if (waiting == 0) {
+            if (appliedBaud != baud) {
+                Serial.flush();
+                appliedBaud = baud;
+                Serial.updateBaudRate(appliedBaud);
+            }
+            return;
+        }
+
+        // Never more than the UART buffer has room for, so this task doesn't hold the port either
+        int room = Serial.availableForWrite() - SERIAL_MIRROR_TX_RESERVE;
+        if (room <= 0) {
+            vTaskDelay(1);
+            continue;
+        }
+
+        size_t offset = currentTail & (SERIAL_MIRROR_RING_SIZE - 1);
+        size_t chunk = min((size_t)waiting, (size_t)SERIAL_MIRROR_RING_SIZE - offset);
+        chunk = min(chunk, (size_t)room);
+        size_t written = Serial.write(ring + offset, chunk);
+        tail.store(currentTail + written, std::memory_order_release);
+        bytesOut.fetch_add(written, std::memory_order_relaxed);
+        Metrics::count(METRIC_SERIAL_BYTES, written);
+    }
+}
+
+void SerialMirror::readCommands() {
+    while (Serial.available() > 0) {
+        int c = Serial.read();
+        if (c < 0) {
+            break;
+        }
+        if (c == '\r' || c == '\n') {
+            if (commandLength > 0 && commandHandler) {
+                commandLine[commandLength] = '\0';
+                commandHandler(commandLine);
+            }
+            commandLength = 0;
+        } else if (commandLength < sizeof(commandLine) - 1) {
+            commandLine[commandLength++] = (char)c;
+        }
+    }
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <functional>
+#include "DeviceRegistry.hpp"
+#include "LogProtocol.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Serial mirror configuration
+#define SERIAL_MIRROR_RING_SIZE 16384  // Power of two
+#define SERIAL_MIRROR_TX_BUFFER 2048   // UART driver buffer, set before Serial.begin()
+#define SERIAL_MIRROR_TX_RESERVE 256   // Left free for everyone else's Serial.print
+#define SERIAL_MIRROR_DEFAULT_BAUD 115200
+#define SERIAL_MIRROR_TASK_STACK_SIZE 3072
+#define SERIAL_MIRROR_TASK_PRIORITY 1
+#define SERIAL_MIRROR_IDLE_MS 20
+#define SERIAL_MIRROR_COMMAND_LENGTH 128  // Longest command line read from the port
+
+/*
+ * Binary mirror stream, for a PC-side tool:
+ *   [0xB7][0x5E][type:1][length:2][payload...][sum:1]
+ * sum is the low byte of the sum of type, length and payload. A reader
+ * resyncs on the two magic bytes, so other serial output in between (boot
+ * messages, metrics dumps) only costs the frames it lands in. Payloads:
+ *   RECORD   [device:1][level:1][flags:1][timestamp:4][micros:2][tagLength:1][tag...][message...]
+ *   DEVICE   [device:1][name...]       before the first record of each device
+ *   DROPPED  [count:4]                 records the mirror had no room for
+ * Tokenized records are sent formatted, so the stream stands on its own.
+ * Session exports (SessionExport.hpp) use the same framing.
+ */
+#define SERIAL_MIRROR_MAGIC_0 0xB7
+#define SERIAL_MIRROR_MAGIC_1 0x5E
+#define SERIAL_MIRROR_FRAME_RECORD 0x01
+#define SERIAL_MIRROR_FRAME_DEVICE 0x02
+#define SERIAL_MIRROR_FRAME_DROPPED 0x03
+
+enum SerialMirrorFormat : uint8_t {
+    SERIAL_MIRROR_OFF,
+    SERIAL_MIRROR_TEXT,         // "[device] tag: message"
+    SERIAL_MIRROR_TIMESTAMPED,  // "12.345678 I [device] tag: message"
+    SERIAL_MIRROR_BINARY,
+    SERIAL_MIRROR_FORMATS
+};
+
+struct SerialMirrorStats {
+    uint32_t records;  // Taken into the ring
+    uint32_t dropped;  // No room in the ring
+    uint32_t bytes;    // Written to the UART
+    uint32_t highWaterMark;  // Most bytes waiting at once
+};
+
+/**
+ * SerialMirror copies every received record to the USB serial port. The
+ * communications task only renders the line into a ring of its own, and a
+ * low-priority task writes it out no faster than the UART takes it; when the
+ * port can't keep up the newest records are dropped and counted, and the
+ * stream says how many are missing once there is room again. Ingest never
+ * waits on the UART.
+ *
+ * Lines typed into the port go to the command handler, on the mirror task.
+ * A bulk export holds the mirror to have the port to itself for a while.
+ *
+ * Format and baud rate are kept in NVS. write() is for the communications
+ * task only; the rest is safe from any task.
+ */
+class SerialMirror {
+   public:
+    static void loadSettings();  // Before Serial.begin(), which wants getBaud()
+    static bool begin();
+    static void end();
+
+    static void write(const LogPacket& packet, DeviceId device, const char* text);
+
+    static void setFormat(SerialMirrorFormat format);
+    static SerialMirrorFormat getFormat() { return format; }
+    static const char* getFormatName(SerialMirrorFormat format);
+
+    static void setBaud(uint32_t baud);  // Applied by the mirror task once what is queued has gone out
+    static uint32_t getBaud() { return baud; }
+    static uint32_t stepBaud(uint32_t baud, bool up);  // Neighbour in the supported rates
+
+    static SerialMirrorStats getStats();
+
+    // Stop writing until released; records keep queuing, then drop. isHeld() once nothing is in flight.
+    static void hold(bool held);
+    static bool isHeld() { return holdRequested && (parked || !taskHandle); }
+
+    using CommandHandler = std::function<void(const char* line)>;
+    static void setCommandHandler(CommandHandler handler) { commandHandler = handler; }  // Before begin()
+
+    // One frame into out (payload may already sit at out + 5); 0 if it doesn't fit
+    static size_t renderFrame(uint8_t type, const uint8_t* payload, size_t length, uint8_t* out, size_t capacity);
+
+    // Payloads of the binary stream into out; 0 if they don't fit. NetworkRelay frames the same ones.
+    static size_t renderRecordPayload(const LogPacket& packet, DeviceId device, const char* text, uint8_t* out, size_t capacity);
+    static size_t renderDevicePayload(DeviceId device, uint8_t* out, size_t capacity);
+    static size_t renderDroppedPayload(uint32_t count, uint8_t* out, size_t capacity);
+
+   private:
+    static uint8_t* ring;
+    static std::atomic<uint32_t> head;  // Written by the communications task
+    static std::atomic<uint32_t> tail;  // Written by the mirror task
+    static std::atomic<uint32_t> dropped;
+    static std::atomic<uint32_t> bytesOut;
+    static uint32_t records;
+    static uint32_t highWaterMark;
+    static uint32_t unreported;  // Dropped since the stream last said so
+    static uint32_t announced;   // Devices (bit per DeviceId) whose DEVICE frame went out
+    static SerialMirrorFormat writtenFormat;  // Of the last write(); a switch to binary announces every device again
+
+    static volatile SerialMirrorFormat format;
+    static volatile uint32_t baud;
+    static volatile uint32_t appliedBaud;
+    static TaskHandle_t taskHandle;
+    static volatile bool running;
+    static volatile bool holdRequested;
+    static volatile bool parked;  // The mirror task has seen holdRequested
+    static Preferences preferences;
+
+    static CommandHandler commandHandler;
+    static char commandLine[SERIAL_MIRROR_COMMAND_LENGTH];
+    static size_t commandLength;
+
+    static bool push(const uint8_t* data, size_t length);
+    static size_t renderText(const LogPacket& packet, DeviceId device, const char* text, char* out, size_t capacity);
+    static size_t renderRecord(const LogPacket& packet, DeviceId device, const char* text, uint8_t* out, size_t capacity);
+    static void saveSettings();
+
+    static void mirrorTask(void* parameter);
+    static void drain();
+    static void readCommands();
+};
+
+static_assert((SERIAL_MIRROR_RING_SIZE & (SERIAL_MIRROR_RING_SIZE - 1)) == 0, "SERIAL_MIRROR_RING_SIZE must be a power of two");
+static_assert(DEVICE_REGISTRY_SLOTS <= 32, "SerialMirror keeps announced devices in a 32 bit mask");
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,541 @@
+#include "SessionCatalog.hpp"
+#include "BinaryLogFormat.hpp"
+#include "../Hardware/SharedSPIBus.hpp"
+#include <SD.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+namespace BTLogger {
+namespace Core {
+
+SessionCatalog::SessionCatalog()
+    : records(nullptr), capacity(0), front(0), count(0), buckets(nullptr), bucketMask(0), dirtyFrom(0), savedCount(0), baseSlot(0),
+      savedBase(0), storedBytes(0), dropped(0), generation(0) {
+    mutex = xSemaphoreCreateMutex();
+}
+
+SessionCatalog::~SessionCatalog() {
+    heap_caps_free(records);
+    heap_caps_free(buckets);
+    vSemaphoreDelete(mutex);
+}
+
+bool SessionCatalog::allocate() {
+    if (records) {
+        return true;
+    }
+
+    bool hasPsram = psramFound();
+    size_t entries = hasPsram ? SESSION_CATALOG_PSRAM_ENTRIES : SESSION_CATALOG_ENTRIES;
+    uint32_t caps = hasPsram ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : MALLOC_CAP_8BIT;
+    // At most half the buckets in use keeps the probes short
+    size_t bucketCount = 1;
+    while (bucketCount < entries * 2) {
+        bucketCount <<= 1;
+    }
+    records = static_cast<SessionRecord*>(heap_caps_malloc(entries * sizeof(SessionRecord), caps));
+    buckets = static_cast<uint16_t*>(heap_caps_malloc(bucketCount * sizeof(uint16_t), caps));
+    if (!records || !buckets) {
+        Serial.printf("Failed to allocate session catalog (%d entries)\n", entries);
+        heap_caps_free(records);
+        heap_caps_free(buckets);
+        records = nullptr;
+        buckets = nullptr;
+        return false;
+    }
+    capacity = entries;
+    bucketMask = bucketCount - 1;
+    memset(buckets, 0xFF, bucketCount * sizeof(uint16_t));
+    return true;
+}
+
+String SessionCatalog::catalogPath() const {
+    return directory + "/" + SESSION_CATALOG_FILE;
+}
+
+bool SessionCatalog::load(const String& dir) {
+    directory = dir;
+    clear();
+    if (!allocate()) {
+        directory = "";
+        return false;
+    }
+
+    Hardware::SharedSPIBus::Hold bus;
+    File file = SD.open(catalogPath(), FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    SessionCatalogHeader header;
+    bool valid = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+                 memcmp(header.magic, SESSION_CATALOG_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == SESSION_CATALOG_VERSION && header.recordSize == sizeof(SessionRecord) &&
+                 header.count <= capacity;
+    if (valid) {
+        size_t length = header.count * sizeof(SessionRecord);
+        valid = file.seek(sizeof(header) + header.first * sizeof(SessionRecord)) &&
+                file.read(reinterpret_cast<uint8_t*>(records), length) == length;
+    }
+    file.close();
+
+    if (!valid) {
+        Serial.println("Session catalog unreadable - rebuilding");
+        return false;
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    front = 0;
+    count = header.count;
+    dirtyFrom = count;
+    savedCount = count;
+    baseSlot = header.first;
+    savedBase = baseSlot;
+    storedBytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        storedBytes += records[i].stored;
+    }
+    rebuildHash();
+    generation++;
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+bool SessionCatalog::save() {
+    if (!isLoaded()) {
+        return false;
+    }
+
+    // One save at a time, and no removal while one runs; the bus lock is recursive
+    Hardware::SharedSPIBus::Hold bus;
+    String path = catalogPath();
+    File file = SD.open(path, "r+");
+    size_t fileSlots = file && file.size() >= sizeof(SessionCatalogHeader)
+                           ? (file.size() - sizeof(SessionCatalogHeader)) / sizeof(SessionRecord)
+                           : 0;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    size_t total = count;
+    size_t from = min(dirtyFrom, total);
+    bool changed = dirtyFrom < total || savedCount != total || savedBase != baseSlot;
+    // Start over when the file is short of the records kept, or mostly dropped slots
+    bool rewrite = !file || baseSlot + from > fileSlots ||
+                   (baseSlot > SESSION_CATALOG_COMPACT_SLOTS && baseSlot > total);
+    if (rewrite) {
+        baseSlot = 0;
+        from = 0;
+        changed = true;
+    }
+    uint32_t base = baseSlot;
+    dirtyFrom = total;
+    savedCount = total;
+    savedBase = base;
+    xSemaphoreGive(mutex);
+
+    if (!changed) {
+        file.close();
+        return true;
+    }
+    if (rewrite) {
+        file.close();
+        file = SD.open(path, FILE_WRITE);
+    }
+    if (!file) {
+        Serial.printf("Failed to save session catalog: %s\n", path.c_str());
+        return false;
+    }
+
+    SessionCatalogHeader header;
+    memcpy(header.magic, SESSION_CATALOG_MAGIC, sizeof(header.magic));
+    header.version = SESSION_CATALOG_VERSION;
+    header.reserved = 0;
+    header.recordSize = sizeof(SessionRecord);
+    header.first = base;
+    header.count = total;
+    bool success = file.seek(0) && file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header);
+
+    // Copied out a few at a time so readers are never held up by the card
+    SessionRecord chunk[SESSION_CATALOG_SAVE_CHUNK];
+    success = success && file.seek(sizeof(header) + (base + from) * sizeof(SessionRecord));
+    for (size_t i = from; success && i < total; i += SESSION_CATALOG_SAVE_CHUNK) {
+        size_t n = min((size_t)SESSION_CATALOG_SAVE_CHUNK, total - i);
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        for (size_t j = 0; j < n; j++) {
+            chunk[j] = at(i + j);
+        }
+        xSemaphoreGive(mutex);
+
+        for (size_t j = 0; j < n; j++) {
+            chunk[j].flags &= ~SESSION_RECORD_SEEN;
+        }
+        size_t length = n * sizeof(SessionRecord);
+        success = file.write(reinterpret_cast<const uint8_t*>(chunk), length) == length;
+    }
+    file.close();
+
+    if (!success) {
+        Serial.println("Failed to write session catalog");
+        markDirty(0);
+    }
+    return success;
+}
+
+void SessionCatalog::clear() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    front = 0;
+    count = 0;
+    if (buckets) {
+        memset(buckets, 0xFF, (bucketMask + 1) * sizeof(uint16_t));
+    }
+    dirtyFrom = 0;
+    savedCount = 0;
+    baseSlot = 0;
+    savedBase = 0;
+    storedBytes = 0;
+    dropped = 0;
+    generation++;
+    xSemaphoreGive(mutex);
+}
+
+void SessionCatalog::markDirty(size_t index) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (index < dirtyFrom) {
+        dirtyFrom = index;
+    }
+    generation++;
+    xSemaphoreGive(mutex);
+}
+
+const char* SessionCatalog::baseName(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+uint32_t SessionCatalog::hashOf(const char* name) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < SESSION_CATALOG_NAME_LENGTH && name[i]; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+int SessionCatalog::indexOf(const char* name) const {
+    for (size_t bucket = hashOf(name) & bucketMask; buckets[bucket] != SESSION_CATALOG_EMPTY_SLOT;
+         bucket = (bucket + 1) & bucketMask) {
+        size_t slot = buckets[bucket];
+        if (strncmp(records[slot].name, name, SESSION_CATALOG_NAME_LENGTH) == 0) {
+            return (slot + capacity - front) % capacity;
+        }
+    }
+    return -1;
+}
+
+void SessionCatalog::hashInsert(size_t slot) {
+    size_t bucket = hashOf(records[slot].name) & bucketMask;
+    while (buckets[bucket] != SESSION_CATALOG_EMPTY_SLOT) {
+        bucket = (bucket + 1) & bucketMask;
+    }
+    buckets[bucket] = slot;
+}
+
+void SessionCatalog::hashErase(size_t slot) {
+    size_t bucket = hashOf(records[slot].name) & bucketMask;
+    while (buckets[bucket] != slot) {
+        if (buckets[bucket] == SESSION_CATALOG_EMPTY_SLOT) {
+            return;
+        }
+        bucket = (bucket + 1) & bucketMask;
+    }
+
+    // Pull later entries of the probe run back into the hole, so lookups never stop short
+    size_t next = bucket;
+    while (true) {
+        next = (next + 1) & bucketMask;
+        if (buckets[next] == SESSION_CATALOG_EMPTY_SLOT) {
+            break;
+        }
+        size_t home = hashOf(records[buckets[next]].name) & bucketMask;
+        bool stays = bucket <= next ? (home > bucket && home <= next) : (home > bucket || home <= next);
+        if (!stays) {
+            buckets[bucket] = buckets[next];
+            bucket = next;
+        }
+    }
+    buckets[bucket] = SESSION_CATALOG_EMPTY_SLOT;
+}
+
+void SessionCatalog::rebuildHash() {
+    memset(buckets, 0xFF, (bucketMask + 1) * sizeof(uint16_t));
+    for (size_t i = 0; i < count; i++) {
+        hashInsert(slotOf(i));
+    }
+}
+
+bool SessionCatalog::add(const char* name, const char* device, uint32_t stored) {
+    name = baseName(name);
+    if (!records || strlen(name) >= SESSION_CATALOG_NAME_LENGTH) {
+        dropped++;
+        return false;
+    }
+
+    SessionRecord record;
+    memset(&record, 0, sizeof(record));
+    strncpy(record.name, name, sizeof(record.name) - 1);
+    strncpy(record.device, device, sizeof(record.device) - 1);
+    record.stored = stored;
+    record.flags = SESSION_RECORD_OPEN | SESSION_RECORD_SEEN;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int index = indexOf(name);
+    if (index < 0 && count == capacity) {
+        // Full: forget the oldest file, it is still on the card
+        removeAt(0);
+        dropped++;
+    }
+    place(index, record);
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+void SessionCatalog::place(int index, const SessionRecord& record) {
+    if (index < 0) {
+        index = count++;
+        at(index) = record;
+        hashInsert(slotOf(index));
+    } else {
+        storedBytes -= at(index).stored;
+        at(index) = record;
+    }
+    storedBytes += record.stored;
+    if ((size_t)index < dirtyFrom) {
+        dirtyFrom = index;
+    }
+    generation++;
+}
+
+void SessionCatalog::removeAt(size_t index) {
+    storedBytes -= at(index).stored;
+    hashErase(slotOf(index));
+    if (index == 0) {
+        // The rest stay in their slots; only the first slot moves, here and in the file
+        front = slotOf(1);
+        count--;
+        baseSlot++;
+        if (dirtyFrom > 0) {
+            dirtyFrom--;
+        }
+    } else {
+        for (size_t i = index; i + 1 < count; i++) {
+            hashErase(slotOf(i + 1));
+            at(i) = at(i + 1);
+            hashInsert(slotOf(i));
+        }
+        count--;
+        if (index < dirtyFrom) {
+            dirtyFrom = index;
+        }
+    }
+    generation++;
+}
+
+void SessionCatalog::update(const char* name, uint32_t size, const SessionIndexWriter& index, bool open) {
+    name = baseName(name);
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int position = records ? indexOf(name) : -1;
+    if (position >= 0) {
+        SessionRecord& record = at(position);
+        record.size = size;
+        if (size > record.stored) {
+            storedBytes += size - record.stored;  // Text files grow as they are written
+            record.stored = size;
+        }
+        record.lines = index.getLineCount();
+        record.startTime = index.getFirstTimestamp();
+        record.endTime = index.getLastTimestamp();
+        memcpy(record.levelCounts, index.getLevelCounts(), sizeof(record.levelCounts));
+        record.flags = open ? (record.flags | SESSION_RECORD_OPEN) : (record.flags & ~SESSION_RECORD_OPEN);
+        if ((size_t)position < dirtyFrom) {
+            dirtyFrom = position;
+        }
+        generation++;
+    }
+    xSemaphoreGive(mutex);
+}
+
+bool SessionCatalog::remove(const char* name) {
+    name = baseName(name);
+
+    // Waits out a save in progress, whose slots would shift under it
+    Hardware::SharedSPIBus::Hold bus;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int index = records ? indexOf(name) : -1;
+    if (index >= 0) {
+        removeAt(index);
+    }
+    xSemaphoreGive(mutex);
+    return index >= 0;
+}
+
+void SessionCatalog::beginReconcile() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (size_t i = 0; i < count; i++) {
+        at(i).flags &= ~SESSION_RECORD_SEEN;
+    }
+    xSemaphoreGive(mutex);
+}
+
+bool SessionCatalog::markSeen(const char* name) {
+    name = baseName(name);
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int index = records ? indexOf(name) : -1;
+    bool current = index >= 0 && !(at(index).flags & SESSION_RECORD_OPEN);
+    if (index >= 0) {
+        at(index).flags |= SESSION_RECORD_SEEN;
+    }
+    xSemaphoreGive(mutex);
+    return current;
+}
+
+void SessionCatalog::endReconcile() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    // Gone from the front only moves the first slot; the rest close up in one pass
+    while (count > 0 && !(at(0).flags & SESSION_RECORD_SEEN)) {
+        removeAt(0);
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!(at(i).flags & SESSION_RECORD_SEEN)) {
+            storedBytes -= at(i).stored;
+            continue;
+        }
+        if (kept != i) {
+            at(kept) = at(i);
+            dirtyFrom = min(dirtyFrom, kept);
+        }
+        kept++;
+    }
+    if (kept != count) {
+        count = kept;
+        rebuildHash();
+        generation++;
+    }
+    xSemaphoreGive(mutex);
+}
+
+bool SessionCatalog::scanFile(const String& path, uint32_t fileSize) {
+    const char* name = baseName(path.c_str());
+    if (!records || strlen(name) >= SESSION_CATALOG_NAME_LENGTH) {
+        return false;
+    }
+
+    SessionRecord record;
+    memset(&record, 0, sizeof(record));
+    strncpy(record.name, name, sizeof(record.name) - 1);
+    record.size = fileSize;
+    record.stored = fileSize;
+    record.flags = SESSION_RECORD_SEEN;
+
+    File file = SD.open(path, FILE_READ);
+    if (!file) {
+        return false;
+    }
+    if (path.endsWith(BINARY_LOG_EXTENSION)) {
+        BinaryLogFileHeader header;
+        if (file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+            memcmp(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic)) == 0) {
+            memcpy(record.device, header.deviceName, sizeof(record.device) - 1);
+            if ((header.flags & BINARY_LOG_FLAG_SEGMENT) && header.dataLength != 0) {
+                record.size = header.dataLength;
+            }
+        }
+    } else {
+        // Text sessions name the device in the header comments
+        for (int i = 0; i < 4 && file.available(); i++) {
+            String line = file.readStringUntil('\n');
+            if (line.startsWith("# Device: ")) {
+                line.substring(10).toCharArray(record.device, sizeof(record.device));
+                break;
+            }
+        }
+    }
+    file.close();
+
+    // Totals from the first and last index entries, without loading the rest
+    File index = SD.open(SessionIndexWriter::pathFor(path), FILE_READ);
+    if (index) {
+        SessionIndexHeader header;
+        SessionIndexEntry entry;
+        size_t entries = index.size() > sizeof(header) ? (index.size() - sizeof(header)) / sizeof(entry) : 0;
+        if (entries > 0 && index.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+            memcmp(header.magic, SESSION_INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+            index.read(reinterpret_cast<uint8_t*>(&entry), sizeof(entry)) == sizeof(entry)) {
+            record.startTime = entry.timestamp;
+            if (index.seek(sizeof(header) + (entries - 1) * sizeof(entry)) &&
+                index.read(reinterpret_cast<uint8_t*>(&entry), sizeof(entry)) == sizeof(entry)) {
+                record.endTime = entry.timestamp;
+                record.lines = entry.line;
+                memcpy(record.levelCounts, entry.levelCounts, sizeof(record.levelCounts));
+            }
+        }
+        index.close();
+    }
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int position = indexOf(name);
+    bool fits = position >= 0 || count < capacity;
+    if (fits) {
+        place(position, record);
+    }
+    xSemaphoreGive(mutex);
+
+    if (!fits) {
+        dropped++;
+    }
+    return fits;
+}
+
+bool SessionCatalog::getEntry(size_t position, SessionRecord& record) const {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool found = position < count;
+    if (found) {
+        record = at(count - 1 - position);
+    }
+    xSemaphoreGive(mutex);
+    return found;
+}
+
+uint64_t SessionCatalog::getStoredBytes() const {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint64_t bytes = storedBytes;
+    xSemaphoreGive(mutex);
+    return bytes;
+}
+
+bool SessionCatalog::getOldest(SessionRecord& record, const char* device) const {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool found = false;
+    for (size_t i = 0; i < count && !found; i++) {
+        const SessionRecord& candidate = at(i);
+        if (!(candidate.flags & SESSION_RECORD_OPEN) &&
+            (!device || strncmp(candidate.device, device, sizeof(candidate.device)) == 0)) {
+            record = candidate;
+            found = true;
+        }
+    }
+    xSemaphoreGive(mutex);
+    return found;
+}
+
+int SessionCatalog::find(const char* name) const {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    int index = records ? indexOf(baseName(name)) : -1;
+    size_t total = count;
+    xSemaphoreGive(mutex);
+    return index >= 0 ? (int)(total - 1 - index) : -1;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "DeviceRegistry.hpp"
+#include "SessionIndex.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Catalog of the session files in the log directory, persisted next to them
+#define SESSION_CATALOG_FILE "catalog.bin"
+#define SESSION_CATALOG_MAGIC "BTLC"
+#define SESSION_CATALOG_VERSION 2
+#define SESSION_CATALOG_ENTRIES 128  // Internal RAM boards
+#define SESSION_CATALOG_PSRAM_ENTRIES 4096
+#define SESSION_CATALOG_NAME_LENGTH 48
+#define SESSION_CATALOG_SAVE_CHUNK 4  // Records copied out per lock when saving
+#define SESSION_CATALOG_COMPACT_SLOTS 64  // Unused slots at the front of the file before it is rewritten
+#define SESSION_CATALOG_EMPTY_SLOT 0xFFFF  // Free bucket in the name table
+
+// Record flags
+#define SESSION_RECORD_OPEN 0x01  // Still being written; the totals are from the last commit
+#define SESSION_RECORD_SEEN 0x80  // Found on the card by the current reconcile (not persisted)
+
+// One session file, as the catalog knows it
+struct __attribute__((packed)) SessionRecord {
+    char name[SESSION_CATALOG_NAME_LENGTH];  // File name within the log directory
+    char device[DEVICE_NAME_LENGTH];
+    uint32_t startTime;  // Timestamps of the first and last record
+    uint32_t endTime;
+    uint32_t size;    // Bytes of log data; a segment's used length, not its preallocation
+    uint32_t stored;  // Bytes the file takes on the card
+    uint32_t lines;
+    uint32_t levelCounts[SESSION_INDEX_LEVELS];
+    uint8_t flags;
+};
+
+struct __attribute__((packed)) SessionCatalogHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t recordSize;
+    uint32_t first;  // Slot of the oldest record, so dropping it only rewrites the header
+    uint32_t count;
+};
+
+/**
+ * SessionCatalog keeps one record per session file so the log directory can
+ * be listed without walking the card and opening every file. The writer
+ * adds a record when it opens a file and refreshes it on every commit; the
+ * table is saved to the card as files close, and only from the first record
+ * that changed, so a rotation rewrites a record or two rather than the
+ * whole catalog. Dropping the oldest file only moves the first slot.
+ *
+ * Records are kept in the order files were created, in a ring so the oldest
+ * drops without moving the rest, and read newest first. A hash of the names
+ * finds a record without scanning. Thread-safe: the storage task writes, any
+ * task may read a copy; a mutex rather than a spinlock, since listing and
+ * removal walk the table.
+ */
+class SessionCatalog {
+   public:
+    SessionCatalog();
+    ~SessionCatalog();
+
+    // Reads the saved catalog of directory; false if there is none or it doesn't match this build
+    bool load(const String& directory);
+    bool save();
+    void clear();
+
+    // Writer side
+    bool add(const char* name, const char* device, uint32_t stored);
+    void update(const char* name, uint32_t size, const SessionIndexWriter& index, bool open);
+    bool remove(const char* name);
+
+    // Start-of-boot reconcile against a walk of the directory
+    void beginReconcile();
+    bool markSeen(const char* name);    // False if the record is missing or was left open
+    bool scanFile(const String& path, uint32_t fileSize);  // Rebuild a record from the file and its index
+    void endReconcile();                // Drops records whose file is gone
+
+    // Reader side; position 0 is the newest file
+    size_t size() const { return count; }
+    bool getEntry(size_t position, SessionRecord& record) const;
+    int find(const char* name) const;  // Position, or -1
+    uint32_t getGeneration() const { return generation; }  // Changes with every update
+    bool isLoaded() const { return records != nullptr && !directory.isEmpty(); }
+    bool isComplete() const { return isLoaded() && dropped == 0; }  // False once files didn't fit
+    uint64_t getStoredBytes() const;  // Card space taken by the files listed
+    // Oldest file that is not being written, of device if given
+    bool getOldest(SessionRecord& record, const char* device = nullptr) const;
+
+    static const char* baseName(const char* path);
+
+   private:
+    SessionRecord* records;
+    size_t capacity;
+    size_t front;  // Slot of the oldest record
+    volatile size_t count;
+    uint16_t* buckets;  // Name hash to record slot, linear probing
+    size_t bucketMask;
+    size_t dirtyFrom;  // First record that differs from the saved copy
+    size_t savedCount;
+    uint32_t baseSlot;  // File slot of records[0]
+    uint32_t savedBase;
+    uint64_t storedBytes;
+    size_t dropped;
+    volatile uint32_t generation;
+    String directory;
+    SemaphoreHandle_t mutex;
+
+    bool allocate();
+    size_t slotOf(size_t index) const { return (front + index) % capacity; }
+    SessionRecord& at(size_t index) const { return records[slotOf(index)]; }
+    int indexOf(const char* name) const;
+    static uint32_t hashOf(const char* name);
+    void hashInsert(size_t slot);
+    void hashErase(size_t slot);
+    void rebuildHash();
+    void removeAt(size_t index);
+    void place(int index, const SessionRecord& record);
+    void markDirty(size_t index);
+    String catalogPath() const;
+};
+
+static_assert(SESSION_CATALOG_PSRAM_ENTRIES < SESSION_CATALOG_EMPTY_SLOT, "SessionCatalog buckets hold 16 bit slots");
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,360 @@
+#include "SessionExport.hpp"
+#include "BinaryLogFormat.hpp"
+#include "SerialMirror.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// File bytes in one DATA frame, after the frame header, offset and checksum
+#define EXPORT_DATA_BYTES (EXPORT_FRAME_BYTES - 5 - 4 - 1)
+
+SessionExport::SessionExport()
+    : out(nullptr), running(false), ending(false), status(EXPORT_OK), rangeIndex(0), position(0), bytesSent(0),
+      totalBytes(0), crc(0), listIndex(0), frame(nullptr), frameLength(0), frameSent(0), chunk(nullptr), chunkStart(0),
+      chunkLength(0), chunkUsed(0) {
+}
+
+SessionExport::~SessionExport() {
+    if (file) {
+        file.close();
+    }
+    free(frame);
+    free(chunk);
+}
+
+bool SessionExport::start(const String& path, const ExportRequest& request, Print& target) {
+    if (running || !allocate()) {
+        return false;
+    }
+
+    out = &target;
+    ranges.clear();
+    listPaths.clear();
+    listSizes.clear();
+    rangeIndex = 0;
+    listIndex = 0;
+    bytesSent = 0;
+    totalBytes = 0;
+    crc = 0;
+    status = EXPORT_OK;
+    ending = false;
+    running = true;
+
+    file = SD.open(path, FILE_READ);
+    uint8_t flags = 0;
+    uint32_t fileSize = file ? file.size() : 0;
+    if (!file) {
+        status = EXPORT_NOT_FOUND;
+    } else {
+        uint32_t dataStart = 0;
+        uint32_t limit = dataLimit(path, dataStart);
+        if (dataStart > 0) {
+            addRange(0, dataStart);  // Binary file header, so the slice is a readable .blg
+        }
+
+        bool slice = request.fromMs != 0 || request.toMs != 0 || (request.levelMask & EXPORT_LEVEL_ALL) != EXPORT_LEVEL_ALL;
+        if (slice && planSlice(path, request, dataStart, limit)) {
+            flags |= EXPORT_FLAG_SLICE;
+        } else {
+            flags |= slice ? EXPORT_FLAG_NO_INDEX : 0;
+            addRange(dataStart, limit);
+        }
+        for (const Range& range : ranges) {
+            totalBytes += range.end - range.start;
+        }
+    }
+
+    uint8_t* payload = frame + 5;
+    size_t pathLength = min(path.length(), (unsigned int)255);
+    payload[0] = flags;
+    memcpy(payload + 1, &fileSize, 4);
+    memcpy(payload + 5, &totalBytes, 4);
+    payload[9] = pathLength;
+    memcpy(payload + 10, path.c_str(), pathLength);
+    queueFrame(EXPORT_FRAME_BEGIN, 10 + pathLength);
+
+    Serial.printf("Export %s: %lu of %lu bytes in %d ranges\n", path.c_str(), (unsigned long)totalBytes,
+                  (unsigned long)fileSize, (int)ranges.size());
+    return true;
+}
+
+bool SessionExport::startList(const std::vector<String>& paths, const std::vector<uint32_t>& sizes, Print& target) {
+    if (running || !allocate()) {
+        return false;
+    }
+
+    out = &target;
+    ranges.clear();
+    listPaths = paths;
+    listSizes = sizes;
+    listIndex = 0;
+    bytesSent = 0;
+    totalBytes = 0;
+    crc = 0;
+    status = EXPORT_OK;
+    ending = false;
+    running = true;
+    frameLength = 0;
+    frameSent = 0;
+    return true;
+}
+
+bool SessionExport::step(uint32_t budgetMs) {
+    if (!running) {
+        return false;
+    }
+
+    unsigned long started = millis();
+    while (millis() - started < budgetMs) {
+        // Whole frames only: a write the driver buffers in one go can't be split by another task's print
+        if (frameSent < frameLength) {
+            int room = out->availableForWrite();
+            if (room < 0 || (size_t)room < frameLength - frameSent) {
+                return true;
+            }
+            frameSent += out->write(frame + frameSent, frameLength - frameSent);
+            continue;
+        }
+
+        if (ending) {
+            finish();
+            return false;
+        }
+        if (!nextFrame()) {
+            queueEnd();
+        }
+    }
+    return true;
+}
+
+void SessionExport::cancel() {
+    if (!running || ending) {
+        return;
+    }
+
+    // The frame on its way still goes out whole, then END
+    status = EXPORT_CANCELLED;
+    rangeIndex = ranges.size();
+    chunkUsed = chunkLength;
+    listIndex = listPaths.size();
+}
+
+bool SessionExport::parseCommand(const char* line, String& path, ExportRequest& request, bool& cancel) {
+    request = ExportRequest();
+    request.levelMask = EXPORT_LEVEL_ALL;
+    request.target = EXPORT_TO_SERIAL;
+    cancel = false;
+
+    char name[96];
+    unsigned long fromMs = 0;
+    unsigned long toMs = 0;
+    int levels = EXPORT_LEVEL_ALL;
+    if (strcmp(line, "cancel") == 0) {
+        cancel = true;
+        return true;
+    }
+    if (strcmp(line, "list") == 0) {
+        request.list = true;
+        return true;
+    }
+    int fields = sscanf(line, "export %95s %lu %lu %i", name, &fromMs, &toMs, &levels);
+    if (fields < 1) {
+        return false;
+    }
+
+    path = name;
+    request.fromMs = fromMs;
+    request.toMs = toMs;
+    request.levelMask = levels & EXPORT_LEVEL_ALL;
+    return true;
+}
+
+bool SessionExport::allocate() {
+    if (!frame) {
+        frame = static_cast<uint8_t*>(malloc(EXPORT_FRAME_BYTES));
+    }
+    if (!chunk) {
+        chunk = static_cast<uint8_t*>(malloc(EXPORT_CHUNK_SIZE));
+    }
+    if (!frame || !chunk) {
+        Serial.println("Failed to allocate export buffer");
+        return false;
+    }
+    frameLength = 0;
+    frameSent = 0;
+    chunkLength = 0;
+    chunkUsed = 0;
+    return true;
+}
+
+uint32_t SessionExport::dataLimit(const String& path, uint32_t& dataStart) {
+    dataStart = 0;
+    uint32_t size = file.size();
+    if (!BinaryLogReader::isBinaryLog(file)) {
+        return size;
+    }
+
+    BinaryLogFileHeader header;
+    file.seek(0);
+    if (file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) != sizeof(header)) {
+        return size;
+    }
+    dataStart = min((uint32_t)header.headerLength, size);
+    if (!(header.flags & BINARY_LOG_FLAG_SEGMENT)) {
+        return size;
+    }
+    uint32_t dataLength = header.dataLength;
+    if (dataLength >= header.headerLength) {
+        return min(dataLength, size);  // Closed
+    }
+
+    // Segment still open: preallocated, so check block by block from the last indexed one
+    // (what follows the tail may be an old file's blocks, which only the CRC tells apart)
+    std::vector<SessionIndexEntry> entries;
+    bool complete = false;
+    uint32_t end = dataStart;
+    if (SessionIndexWriter::load(path, entries, complete) && !entries.empty()) {
+        end = max(end, entries.back().position);
+    }
+    BinaryLogReader reader;
+    BinaryLogRecord record;
+    if (reader.open(file) && reader.seek(end)) {
+        while (reader.next(record)) {
+        }
+        end = max(end, (uint32_t)reader.getValidLength());
+    }
+    return min(end, size);
+}
+
+bool SessionExport::planSlice(const String& path, const ExportRequest& request, uint32_t dataStart, uint32_t limit) {
+    std::vector<SessionIndexEntry> entries;
+    bool complete = false;
+    if (!SessionIndexWriter::load(path, entries, complete) || entries.empty()) {
+        return false;
+    }
+
+    uint32_t toMs = request.toMs != 0 ? request.toMs : UINT32_MAX;
+    // Records of a wanted level between two entries (counts are of the records before each)
+    auto wanted = [&](const SessionIndexEntry* before, const SessionIndexEntry* after) {
+        for (int level = 0; level < SESSION_INDEX_LEVELS; level++) {
+            uint32_t count = after ? after->levelCounts[level] - (before ? before->levelCounts[level] : 0) : 1;
+            if ((request.levelMask & (1 << level)) && count > 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Ahead of the first entry: records older than it, counted in its level counts
+    if (entries[0].position > dataStart && request.fromMs <= entries[0].timestamp &&
+        wanted(nullptr, &entries[0])) {
+        addRange(dataStart, min(entries[0].position, limit));
+    }
+
+    // Between entries; past the last one nothing is counted yet, so it goes if the time fits
+    for (size_t i = 0; i < entries.size(); i++) {
+        const SessionIndexEntry& entry = entries[i];
+        const SessionIndexEntry* next = i + 1 < entries.size() ? &entries[i + 1] : nullptr;
+        uint32_t start = max(entry.position, dataStart);
+        uint32_t end = min(next ? next->position : limit, limit);
+        uint32_t lastMs = next ? next->timestamp : UINT32_MAX;
+        if (start >= end || entry.timestamp > toMs || lastMs < request.fromMs) {
+            continue;
+        }
+        if (wanted(&entry, next)) {
+            addRange(start, end);
+        }
+    }
+    return true;
+}
+
+void SessionExport::addRange(uint32_t start, uint32_t end) {
+    if (start >= end) {
+        return;
+    }
+    if (!ranges.empty() && ranges.back().end == start) {
+        ranges.back().end = end;  // Neighbours go out as one
+        return;
+    }
+    ranges.push_back({start, end});
+}
+
+bool SessionExport::nextFrame() {
+    uint8_t* payload = frame + 5;
+
+    if (listIndex < listPaths.size()) {
+        const String& path = listPaths[listIndex];
+        size_t pathLength = min(path.length(), (unsigned int)255);
+        memcpy(payload, &listSizes[listIndex], 4);
+        memcpy(payload + 4, path.c_str(), pathLength);
+        queueFrame(EXPORT_FRAME_LIST, 4 + pathLength);
+        listIndex++;
+        return true;
+    }
+
+    // One large read, then frames from it until it is used up
+    if (chunkUsed >= chunkLength) {
+        if (rangeIndex >= ranges.size()) {
+            return false;
+        }
+
+        const Range& range = ranges[rangeIndex];
+        if (position < range.start || position >= range.end) {
+            position = range.start;
+        }
+        if (!file.seek(position)) {
+            status = EXPORT_READ_FAILED;
+            return false;
+        }
+        size_t wantedBytes = min((uint32_t)EXPORT_CHUNK_SIZE, range.end - position);
+        if (file.read(chunk, wantedBytes) != wantedBytes) {
+            status = EXPORT_READ_FAILED;
+            return false;
+        }
+
+        chunkStart = position;
+        chunkLength = wantedBytes;
+        chunkUsed = 0;
+        position += wantedBytes;
+        if (position >= range.end) {
+            rangeIndex++;
+        }
+    }
+
+    size_t bytes = min((size_t)EXPORT_DATA_BYTES, chunkLength - chunkUsed);
+    uint32_t offset = chunkStart + chunkUsed;
+    memcpy(payload, &offset, 4);
+    memcpy(payload + 4, chunk + chunkUsed, bytes);
+    crc = esp_rom_crc32_le(crc, payload + 4, bytes);
+    queueFrame(EXPORT_FRAME_DATA, 4 + bytes);
+    bytesSent += bytes;
+    chunkUsed += bytes;
+    return true;
+}
+
+void SessionExport::queueFrame(uint8_t type, size_t payloadLength) {
+    frameLength = SerialMirror::renderFrame(type, frame + 5, payloadLength, frame, EXPORT_FRAME_BYTES);
+    frameSent = 0;
+}
+
+void SessionExport::queueEnd() {
+    uint8_t* payload = frame + 5;
+    payload[0] = status;
+    memcpy(payload + 1, &bytesSent, 4);
+    memcpy(payload + 5, &crc, 4);
+    queueFrame(EXPORT_FRAME_END, 9);
+    ending = true;
+}
+
+void SessionExport::finish() {
+    if (file) {
+        file.close();
+    }
+    listPaths.clear();
+    listSizes.clear();
+    running = false;
+    ending = false;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
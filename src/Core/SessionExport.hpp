@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+#include <vector>
+#include "SessionIndex.hpp"
+#include "SerialMirror.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Export configuration
+#define EXPORT_CHUNK_SIZE (16 * 1024)  // One card read, sent as several DATA frames
+#define EXPORT_FRAME_BYTES (SERIAL_MIRROR_TX_BUFFER - SERIAL_MIRROR_TX_RESERVE)  // Largest frame, one UART write
+#define EXPORT_STEP_MS 10              // Storage task time slice per step
+#define EXPORT_MAX_QUEUE_LOAD 25       // Percent of the storage queue; above it the export waits for ingest
+#define EXPORT_LEVEL_ALL 0x1F
+
+/*
+ * Export stream, in the serial mirror's framing (SerialMirror.hpp):
+ *   BEGIN  0x10  [flags:1][fileSize:4][bytes:4][pathLength:1][path...]
+ *   DATA   0x11  [fileOffset:4][bytes...]     the file's own bytes, unchanged
+ *   END    0x12  [status:1][bytes:4][crc32:4] CRC of every DATA byte, in order
+ *   LIST   0x13  [fileSize:4][path...]        one per session, then END
+ * A slice is the file with index ranges left out; binary slices keep the
+ * file header, so the result reads like any .blg with gaps. The file's
+ * offset in each DATA frame tells where the pieces came from.
+ */
+#define EXPORT_FRAME_BEGIN 0x10
+#define EXPORT_FRAME_DATA 0x11
+#define EXPORT_FRAME_END 0x12
+#define EXPORT_FRAME_LIST 0x13
+
+#define EXPORT_FLAG_SLICE 0x01     // Ranges were picked from the index
+#define EXPORT_FLAG_NO_INDEX 0x02  // A slice was asked for, but without an index the whole file went
+
+enum ExportStatus : uint8_t {
+    EXPORT_OK,
+    EXPORT_CANCELLED,
+    EXPORT_READ_FAILED,
+    EXPORT_NOT_FOUND
+};
+
+enum ExportTarget : uint8_t {
+    EXPORT_TO_SERIAL
+};
+
+// What to send (plain data, sent through the storage queue with the path)
+struct ExportRequest {
+    uint32_t fromMs;    // BTLogger time base; both 0 for the whole file
+    uint32_t toMs;
+    uint8_t levelMask;  // Bit per level, 1 << level
+    ExportTarget target;
+    bool list;          // List the sessions instead
+};
+
+/**
+ * SessionExport ships a session file (or a slice of it, picked from its
+ * sidecar index by time and level) to a PC as it is on the card: large
+ * reads, no re-formatting, framed so the other end can check it. Like
+ * LogSearch it runs a slice at a time on the storage task. Each frame goes to
+ * the UART driver in a single write, once its buffer has room for all of it,
+ * so lines other tasks print can only land between frames and logging goes
+ * on meanwhile.
+ */
+class SessionExport {
+   public:
+    SessionExport();
+    ~SessionExport();
+
+    bool start(const String& path, const ExportRequest& request, Print& out);
+    bool startList(const std::vector<String>& paths, const std::vector<uint32_t>& sizes, Print& out);
+    bool step(uint32_t budgetMs);  // Returns true while there is more to do
+    void cancel();
+
+    bool isRunning() const { return running; }
+    uint32_t getBytesSent() const { return bytesSent; }
+    uint32_t getTotalBytes() const { return totalBytes; }
+    ExportStatus getStatus() const { return status; }
+
+    // "export <path> [fromMs toMs [levelMask]]", "list" or "cancel"; false for anything else
+    static bool parseCommand(const char* line, String& path, ExportRequest& request, bool& cancel);
+
+   private:
+    struct Range {
+        uint32_t start;
+        uint32_t end;
+    };
+
+    Print* out;
+    File file;
+    bool running;
+    bool ending;  // END queued, nothing left after it
+    ExportStatus status;
+
+    std::vector<Range> ranges;
+    size_t rangeIndex;
+    uint32_t position;
+    uint32_t bytesSent;
+    uint32_t totalBytes;
+    uint32_t crc;
+
+    std::vector<String> listPaths;
+    std::vector<uint32_t> listSizes;
+    size_t listIndex;
+
+    uint8_t* frame;  // The frame being written out
+    size_t frameLength;
+    size_t frameSent;
+
+    uint8_t* chunk;  // Last card read, going out a DATA frame at a time
+    uint32_t chunkStart;
+    size_t chunkLength;
+    size_t chunkUsed;
+
+    bool allocate();
+    uint32_t dataLimit(const String& path, uint32_t& dataStart);
+    bool planSlice(const String& path, const ExportRequest& request, uint32_t dataStart, uint32_t limit);
+    void addRange(uint32_t start, uint32_t end);
+    bool nextFrame();
+    void queueFrame(uint8_t type, size_t payloadLength);  // Payload already at frame + 5
+    void queueEnd();
+    void finish();
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,150 @@
+#include "SessionIndex.hpp"
+#include <stddef.h>
+
+namespace BTLogger {
+namespace Core {
+
+SessionIndexWriter::SessionIndexWriter()
+    : lineCount(0), recordCount(0), firstTimestamp(0), lastTimestamp(0), lastEntryLine(0), lastBucket(0), hasEntry(false), checkpointDue(false),
+      pendingCount(0) {
+    memset(levelCounts, 0, sizeof(levelCounts));
+}
+
+bool SessionIndexWriter::open(const String& logPath) {
+    lineCount = 0;
+    memset(levelCounts, 0, sizeof(levelCounts));
+    recordCount = 0;
+    firstTimestamp = 0;
+    lastTimestamp = 0;
+    lastEntryLine = 0;
+    lastBucket = 0;
+    hasEntry = false;
+    checkpointDue = false;
+    pendingCount = 0;
+
+    String path = pathFor(logPath);
+    file = SD.open(path, FILE_WRITE);
+    if (!file) {
+        Serial.printf("Failed to create index: %s\n", path.c_str());
+        return false;
+    }
+
+    SessionIndexHeader header;
+    memcpy(header.magic, SESSION_INDEX_MAGIC, sizeof(header.magic));
+    header.version = SESSION_INDEX_VERSION;
+    header.flags = 0;
+    header.lineSpacing = SESSION_INDEX_LINE_SPACING;
+    header.bucketMs = SESSION_INDEX_BUCKET_MS;
+    file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    return true;
+}
+
+void SessionIndexWriter::close(uint32_t endPosition) {
+    if (!file) {
+        return;
+    }
+
+    // The end entry carries the totals
+    addEntry(endPosition, lastTimestamp);
+    flush();
+
+    uint8_t flags = SESSION_INDEX_FLAG_COMPLETE;
+    file.seek(offsetof(SessionIndexHeader, flags));
+    file.write(&flags, sizeof(flags));
+    file.close();
+}
+
+void SessionIndexWriter::noteRecord(uint32_t position, uint32_t timestamp, uint8_t level, bool checkpoint) {
+    uint32_t bucket = timestamp / SESSION_INDEX_BUCKET_MS;
+    if (!hasEntry || lineCount - lastEntryLine >= SESSION_INDEX_LINE_SPACING || bucket != lastBucket) {
+        checkpointDue = true;
+    }
+    if (checkpointDue && checkpoint) {
+        addEntry(position, timestamp);
+        lastEntryLine = lineCount;
+        lastBucket = bucket;
+        hasEntry = true;
+        checkpointDue = false;
+    }
+
+    if (recordCount++ == 0) {
+        firstTimestamp = timestamp;
+    }
+    lineCount++;
+    levelCounts[min(level, (uint8_t)(SESSION_INDEX_LEVELS - 1))]++;
+    lastTimestamp = timestamp;
+}
+
+void SessionIndexWriter::addEntry(uint32_t position, uint32_t timestamp) {
+    if (pendingCount == SESSION_INDEX_PENDING && !flush()) {
+        pendingCount = 0;  // Index writes failing; drop rather than stall logging
+    }
+    SessionIndexEntry& entry = pending[pendingCount++];
+    entry.position = position;
+    entry.line = lineCount;
+    entry.timestamp = timestamp;
+    memcpy(entry.levelCounts, levelCounts, sizeof(levelCounts));
+}
+
+bool SessionIndexWriter::flush() {
+    if (!file || pendingCount == 0) {
+        return true;
+    }
+    size_t length = pendingCount * sizeof(SessionIndexEntry);
+    size_t written = file.write(reinterpret_cast<const uint8_t*>(pending), length);
+    pendingCount = 0;
+    return written == length;
+}
+
+String SessionIndexWriter::pathFor(const String& logPath) {
+    int dot = logPath.lastIndexOf('.');
+    int slash = logPath.lastIndexOf('/');
+    String base = dot > slash ? logPath.substring(0, dot) : logPath;
+    return base + SESSION_INDEX_EXTENSION;
+}
+
+bool SessionIndexWriter::load(const String& logPath, std::vector<SessionIndexEntry>& entries, bool& complete) {
+    entries.clear();
+    complete = false;
+
+    File file = SD.open(pathFor(logPath), FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    SessionIndexHeader header;
+    if (file.size() < sizeof(header) || file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, SESSION_INDEX_MAGIC, sizeof(header.magic)) != 0 || header.version > SESSION_INDEX_VERSION) {
+        file.close();
+        return false;
+    }
+
+    size_t count = (file.size() - sizeof(header)) / sizeof(SessionIndexEntry);
+    entries.resize(count);
+    size_t length = count * sizeof(SessionIndexEntry);
+    if (file.read(reinterpret_cast<uint8_t*>(entries.data()), length) != length) {
+        entries.clear();
+        file.close();
+        return false;
+    }
+    complete = header.flags & SESSION_INDEX_FLAG_COMPLETE;
+    file.close();
+    return true;
+}
+
+uint32_t SessionIndexWriter::countLines(const char* text, size_t length) {
+    uint32_t lines = 0;
+    bool content = false;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '\n') {
+            lines += content;
+            content = false;
+        } else if (text[i] != '\r') {
+            content = true;
+        }
+    }
+    return lines + content;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
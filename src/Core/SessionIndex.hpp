@@ -0,0 +1,95 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+#include <vector>
+
+namespace BTLogger {
+namespace Core {
+
+/*
+ * Sidecar index (.idx) kept next to each session file:
+ *   [header][entry][entry]...
+ * An entry is written every SESSION_INDEX_LINE_SPACING lines and whenever a
+ * record falls into a new SESSION_INDEX_BUCKET_MS time bucket. It gives a
+ * place reading can start from (a line start, or a block start in binary
+ * files), the line number there and per-level record counts up to it. The
+ * last entry of a complete index is the end of the file.
+ */
+#define SESSION_INDEX_MAGIC "BTLI"
+#define SESSION_INDEX_VERSION 1
+#define SESSION_INDEX_EXTENSION ".idx"
+#define SESSION_INDEX_LINE_SPACING 256
+#define SESSION_INDEX_BUCKET_MS 10000
+#define SESSION_INDEX_PENDING 16  // Entries held until the next commit
+#define SESSION_INDEX_LEVELS 5
+#define SESSION_INDEX_FLAG_COMPLETE 0x01
+
+struct __attribute__((packed)) SessionIndexHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t flags;
+    uint16_t lineSpacing;
+    uint32_t bucketMs;
+};
+
+struct __attribute__((packed)) SessionIndexEntry {
+    uint32_t position;
+    uint32_t line;
+    uint32_t timestamp;  // Of the record at line (the last record for the end entry)
+    uint32_t levelCounts[SESSION_INDEX_LEVELS];
+};
+
+/**
+ * SessionIndexWriter builds the index of one file while it is written. The
+ * caller reports every record, and any other lines, in file order.
+ */
+class SessionIndexWriter {
+   public:
+    SessionIndexWriter();
+
+    bool open(const String& logPath);
+    void close(uint32_t endPosition);
+    bool isOpen() const { return (bool)file; }
+
+    // A record about to be stored at position; checkpoint is false if reading can't start there
+    void noteRecord(uint32_t position, uint32_t timestamp, uint8_t level, bool checkpoint = true);
+    void noteLines(uint32_t count) { lineCount += count; }
+
+    bool flush();
+
+    // Totals of the file so far
+    uint32_t getLineCount() const { return lineCount; }
+    uint32_t getRecordCount() const { return recordCount; }
+    const uint32_t* getLevelCounts() const { return levelCounts; }
+    uint32_t getFirstTimestamp() const { return firstTimestamp; }
+    uint32_t getLastTimestamp() const { return lastTimestamp; }
+
+    static String pathFor(const String& logPath);
+
+    // Read the index of a log file; false if it has none
+    static bool load(const String& logPath, std::vector<SessionIndexEntry>& entries, bool& complete);
+
+    // Lines of a text chunk as LogFileReader counts them (empty lines don't count)
+    static uint32_t countLines(const char* text, size_t length);
+
+   private:
+    File file;
+    uint32_t lineCount;
+    uint32_t levelCounts[SESSION_INDEX_LEVELS];
+    uint32_t recordCount;
+    uint32_t firstTimestamp;
+    uint32_t lastTimestamp;
+    uint32_t lastEntryLine;
+    uint32_t lastBucket;
+    bool hasEntry;
+    bool checkpointDue;  // Binary files wait for the next block start
+
+    SessionIndexEntry pending[SESSION_INDEX_PENDING];
+    uint8_t pendingCount;
+
+    void addEntry(uint32_t position, uint32_t timestamp);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
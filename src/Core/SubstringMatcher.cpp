@@ -0,0 +1,52 @@
+#include "SubstringMatcher.hpp"
+#include <ctype.h>
+
+namespace BTLogger {
+namespace Core {
+
+SubstringMatcher::SubstringMatcher() : patternLength(0), ignoreCase(false) {
+    pattern[0] = '\0';
+}
+
+void SubstringMatcher::setPattern(const char* text, bool caseless) {
+    ignoreCase = caseless;
+    patternLength = text ? strnlen(text, sizeof(pattern) - 1) : 0;
+    for (size_t i = 0; i < patternLength; i++) {
+        pattern[i] = ignoreCase ? tolower((uint8_t)text[i]) : text[i];
+    }
+    pattern[patternLength] = '\0';
+
+    // Bad character shifts for the last byte of each window
+    memset(shift, patternLength, sizeof(shift));
+    for (size_t i = 0; i + 1 < patternLength; i++) {
+        uint8_t c = pattern[i];
+        shift[c] = patternLength - 1 - i;
+        if (ignoreCase) {
+            shift[toupper(c)] = patternLength - 1 - i;
+        }
+    }
+}
+
+bool SubstringMatcher::matches(const char* text, size_t length) const {
+    if (patternLength == 0) {
+        return true;
+    }
+    size_t last = patternLength - 1;
+    for (size_t i = 0; i + patternLength <= length; i += shift[(uint8_t)text[i + last]]) {
+        size_t j = last;
+        while (true) {
+            char c = ignoreCase ? tolower((uint8_t)text[i + j]) : text[i + j];
+            if (c != pattern[j]) {
+                break;
+            }
+            if (j == 0) {
+                return true;
+            }
+            j--;
+        }
+    }
+    return false;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
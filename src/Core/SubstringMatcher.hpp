@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+#define SEARCH_TEXT_LENGTH 64  // Longest pattern, terminator included
+
+/**
+ * SubstringMatcher finds a fixed pattern with Boyer-Moore-Horspool, so most
+ * of a message is skipped over rather than compared.
+ */
+class SubstringMatcher {
+   public:
+    SubstringMatcher();
+
+    void setPattern(const char* pattern, bool ignoreCase);
+    bool matches(const char* text, size_t length) const;
+    bool isEmpty() const { return patternLength == 0; }
+
+   private:
+    char pattern[SEARCH_TEXT_LENGTH];
+    size_t patternLength;
+    bool ignoreCase;
+    uint8_t shift[256];
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,84 @@
+#include "TagRegistry.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Id 0 is the catch-all, its name first in the arena
+TagRegistry::Entry TagRegistry::entries[TAG_REGISTRY_SLOTS] = {{0, 0, 7}};
+char TagRegistry::arena[TAG_REGISTRY_ARENA_BYTES] = "(other)";
+size_t TagRegistry::arenaUsed = 8;
+std::atomic<uint8_t> TagRegistry::buckets[TAG_REGISTRY_BUCKETS] = {};
+std::atomic<uint8_t> TagRegistry::count(1);
+portMUX_TYPE TagRegistry::lock = portMUX_INITIALIZER_UNLOCKED;
+
+TagId TagRegistry::intern(const char* tag) {
+    size_t length = strnlen(tag, TAG_REGISTRY_NAME_LENGTH);
+    uint32_t tagHash = hash(tag, length);
+    size_t bucket;
+    TagId id = lookup(tag, length, tagHash, bucket);
+    if (id != TAG_ID_OTHER) {
+        return id;
+    }
+
+    // Look again under the lock: another task may have just added it
+    portENTER_CRITICAL(&lock);
+    id = lookup(tag, length, tagHash, bucket);
+    uint8_t next = count.load(std::memory_order_relaxed);
+    if (id == TAG_ID_OTHER && next < TAG_REGISTRY_SLOTS && arenaUsed + length + 1 <= sizeof(arena)) {
+        Entry& entry = entries[next];
+        entry.hash = tagHash;
+        entry.offset = arenaUsed;
+        entry.length = length;
+        memcpy(arena + arenaUsed, tag, length);
+        arena[arenaUsed + length] = '\0';
+        arenaUsed += length + 1;
+
+        // Entry first, then the bucket that leads to it
+        id = next;
+        buckets[bucket].store(id, std::memory_order_release);
+        count.store(next + 1, std::memory_order_release);
+    }
+    portEXIT_CRITICAL(&lock);
+    return id;
+}
+
+TagId TagRegistry::find(const char* tag) {
+    size_t length = strnlen(tag, TAG_REGISTRY_NAME_LENGTH);
+    size_t bucket;
+    return lookup(tag, length, hash(tag, length), bucket);
+}
+
+const char* TagRegistry::getName(TagId id) {
+    return id < size() ? arena + entries[id].offset : arena;
+}
+
+uint32_t TagRegistry::getHash(TagId id) {
+    return id < size() ? entries[id].hash : 0;
+}
+
+uint32_t TagRegistry::hash(const char* tag, size_t length) {
+    uint32_t value = 2166136261u;
+    for (size_t i = 0; i < length && tag[i]; i++) {
+        value = (value ^ (uint8_t)tag[i]) * 16777619u;
+    }
+    return value;
+}
+
+TagId TagRegistry::lookup(const char* tag, size_t length, uint32_t tagHash, size_t& bucket) {
+    // Linear probing; tags are never removed, so the first empty bucket ends the search
+    bucket = tagHash & (TAG_REGISTRY_BUCKETS - 1);
+    while (true) {
+        TagId id = buckets[bucket].load(std::memory_order_acquire);
+        if (id == TAG_ID_OTHER) {
+            return TAG_ID_OTHER;
+        }
+        const Entry& entry = entries[id];
+        if (entry.hash == tagHash && entry.length == length && memcmp(arena + entry.offset, tag, length) == 0) {
+            return id;
+        }
+        bucket = (bucket + 1) & (TAG_REGISTRY_BUCKETS - 1);
+    }
+}
+
+}  // namespace Core
+}  // namespace BTLogger
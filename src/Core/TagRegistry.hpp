@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../Hardware/Platform.hpp"
+#include <atomic>
+
+namespace BTLogger {
+namespace Core {
+
+// Tag registry configuration
+#define TAG_REGISTRY_SLOTS 64            // Ids, "(other)" included; the live filter keeps a bit per id
+#define TAG_REGISTRY_BUCKETS 128         // Power of two, twice the slots
+#define TAG_REGISTRY_ARENA_BYTES 1024    // Every name back to back, NUL terminated
+#define TAG_REGISTRY_NAME_LENGTH 31      // Longest tag a record carries
+#define TAG_ID_OTHER 0                   // Not interned (yet), or no room left
+
+// Small integer handle for a tag, set on every record at ingest
+typedef uint8_t TagId;
+
+/**
+ * TagRegistry interns record tags to small ids: once at ingest, after which
+ * the filter, viewer, toasts and block writer compare and index by id and
+ * look the name up only to show it. A fixed open-addressing table over a
+ * name arena, so nothing is allocated per tag; ids and names stay valid for
+ * the whole boot.
+ *
+ * Lookups are lock-free from any task; adding a tag takes a short lock.
+ */
+class TagRegistry {
+   public:
+    static TagId intern(const char* tag);  // TAG_ID_OTHER once the table or arena is full
+    static TagId find(const char* tag);    // Without adding; TAG_ID_OTHER if not known
+
+    static const char* getName(TagId id);
+    static uint32_t getHash(TagId id);
+    static uint8_t size() { return count.load(std::memory_order_acquire); }
+
+    // FNV-1a over at most length bytes (stops at a NUL), as kept for every id
+    static uint32_t hash(const char* tag, size_t length);
+
+   private:
+    struct Entry {
+        uint32_t hash;
+        uint16_t offset;  // Of the name in arena
+        uint8_t length;
+    };
+
+    static Entry entries[TAG_REGISTRY_SLOTS];
+    static char arena[TAG_REGISTRY_ARENA_BYTES];
+    static size_t arenaUsed;
+    static std::atomic<uint8_t> buckets[TAG_REGISTRY_BUCKETS];  // Id, or TAG_ID_OTHER for an empty bucket
+    static std::atomic<uint8_t> count;
+    static portMUX_TYPE lock;
+
+    static TagId lookup(const char* tag, size_t length, uint32_t tagHash, size_t& bucket);
+};
+
+static_assert((TAG_REGISTRY_BUCKETS & (TAG_REGISTRY_BUCKETS - 1)) == 0, "TAG_REGISTRY_BUCKETS must be a power of two");
+static_assert(TAG_REGISTRY_BUCKETS > TAG_REGISTRY_SLOTS, "TagRegistry needs an empty bucket to end every probe");
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,283 @@
+#include "WriteAheadStage.hpp"
+#include "FormatDictionary.hpp"
+#include "TagRegistry.hpp"
+#include <esp_system.h>
+#include <string.h>
+#include <atomic>
+
+namespace BTLogger {
+namespace Core {
+
+// Static member definitions; the stage itself is left alone by the startup code
+RTC_NOINIT_ATTR WriteAheadStage::Stage WriteAheadStage::stageMemory;
+WriteAheadStage::RingState WriteAheadStage::state = {};
+size_t WriteAheadStage::pendingRecords = 0;
+uint32_t WriteAheadStage::discarded = 0;
+uint32_t WriteAheadStage::slotBytes[WAL_STAGE_SLOTS] = {};
+
+void WriteAheadStage::initialize() {
+    // RTC memory holds noise after power-on
+    esp_reset_reason_t reason = esp_reset_reason();
+    size_t records = 0;
+    bool kept = reason != ESP_RST_POWERON && stageMemory.magic == WAL_STAGE_MAGIC && stageMemory.current < 2;
+    if (kept) {
+        state = stageMemory.rings[stageMemory.current];
+        kept = state.check == headerCheck(state) && validate(records);
+    }
+
+    if (!kept || records == 0) {
+        clear();
+        return;
+    }
+
+    pendingRecords = records;
+    for (auto& file : stageMemory.files) {
+        file[WAL_PATH_LENGTH - 1] = '\0';
+    }
+    Serial.printf("Write-ahead stage: %d records from before the reset (reason %d)\n", records, (int)reason);
+}
+
+void WriteAheadStage::clear() {
+    memset(&stageMemory, 0, offsetof(Stage, data));
+    stageMemory.magic = WAL_STAGE_MAGIC;
+    state = {};
+    state.nextSequence = 1;
+    pendingRecords = 0;
+    memset(slotBytes, 0, sizeof(slotBytes));
+    publish();
+}
+
+uint32_t WriteAheadStage::headerCheck(const RingState& ring) {
+    return (WAL_STAGE_MAGIC ^ ring.head ^ (ring.tail << 8) ^ (ring.used << 16) ^ ring.nextSequence) * 2654435761u;
+}
+
+void WriteAheadStage::publish() {
+    // Fill the copy not in effect, then switch to it with a single store
+    uint32_t next = stageMemory.current == 0 ? 1 : 0;
+    state.check = headerCheck(state);
+    stageMemory.rings[next] = state;
+    std::atomic_thread_fence(std::memory_order_release);
+    stageMemory.current = next;
+}
+
+WriteAheadStage::StagedRecord* WriteAheadStage::recordAt(uint32_t offset) {
+    return reinterpret_cast<StagedRecord*>(stageMemory.data + offset);
+}
+
+bool WriteAheadStage::skipPadding() {
+    RingState& stage = state;
+    if (stage.used > 0 && (stage.tail + sizeof(StagedRecord) > WAL_STAGE_BYTES || recordAt(stage.tail)->length == 0)) {
+        uint32_t padding = WAL_STAGE_BYTES - stage.tail;
+        if (padding > stage.used) {
+            return false;
+        }
+        stage.used -= padding;
+        stage.tail = 0;
+    }
+    return true;
+}
+
+bool WriteAheadStage::validate(size_t& records) {
+    const RingState& stage = state;
+    if (stage.head >= WAL_STAGE_BYTES || stage.tail >= WAL_STAGE_BYTES || stage.used > WAL_STAGE_BYTES) {
+        return false;
+    }
+
+    // Walk the ring the way truncation would, checking every entry fits its bounds
+    uint32_t offset = stage.tail;
+    uint32_t remaining = stage.used;
+    while (remaining > 0) {
+        if (offset + sizeof(StagedRecord) > WAL_STAGE_BYTES || recordAt(offset)->length == 0) {
+            uint32_t padding = WAL_STAGE_BYTES - offset;
+            if (offset == 0 || padding > remaining) {
+                return false;
+            }
+            remaining -= padding;
+            offset = 0;
+            continue;
+        }
+
+        const StagedRecord* record = recordAt(offset);
+        if (record->length < sizeof(StagedRecord) || record->length > remaining || record->length % 4 != 0 ||
+            record->slot >= WAL_STAGE_SLOTS || record->tagLength >= sizeof(LogPacket::tag) ||
+            record->messageLength >= sizeof(LogPacket::message) ||
+            sizeof(StagedRecord) + record->tagLength + record->messageLength > record->length) {
+            return false;
+        }
+        records++;
+        offset = (offset + record->length) % WAL_STAGE_BYTES;
+        remaining -= record->length;
+    }
+    return offset == stage.head;
+}
+
+void WriteAheadStage::setFile(int slot, const char* path) {
+    if (slot < 0 || slot >= WAL_STAGE_SLOTS) {
+        return;
+    }
+    strncpy(stageMemory.files[slot], path, WAL_PATH_LENGTH - 1);
+    stageMemory.files[slot][WAL_PATH_LENGTH - 1] = '\0';
+}
+
+void WriteAheadStage::closeFile(int slot) {
+    if (slot >= 0 && slot < WAL_STAGE_SLOTS) {
+        stageMemory.files[slot][0] = '\0';
+    }
+}
+
+const char* WriteAheadStage::getFile(int slot) {
+    return slot >= 0 && slot < WAL_STAGE_SLOTS ? stageMemory.files[slot] : "";
+}
+
+bool WriteAheadStage::stage(int slot, const LogPacket& packet) {
+    if (slot < 0 || slot >= WAL_STAGE_SLOTS) {
+        return true;
+    }
+
+    // Tokenized records are staged rendered; the format table doesn't survive the reset
+    char rendered[sizeof(LogPacket::message)];
+    const char* message = packet.message;
+    uint8_t flags = packet.flags;
+    if (flags & WIRE_RECORD_FLAG_TOKENIZED) {
+        message = FormatDictionary::messageText(packet, rendered, sizeof(rendered));
+        flags &= ~WIRE_RECORD_FLAG_TOKENIZED;
+    }
+    size_t messageLength = strnlen(message, sizeof(LogPacket::message) - 1);
+    size_t tagLength = strnlen(packet.tag, sizeof(LogPacket::tag) - 1);
+    uint32_t need = (sizeof(StagedRecord) + tagLength + messageLength + 3) & ~3u;
+
+    RingState& stage = state;
+    uint32_t head = stage.used == 0 ? 0 : stage.head;
+    uint32_t used = stage.used;
+    uint32_t padding = head + need > WAL_STAGE_BYTES ? WAL_STAGE_BYTES - head : 0;
+    if (need + padding > WAL_STAGE_BYTES - used) {
+        return false;
+    }
+    if (padding > 0) {
+        recordAt(head)->length = 0;
+        used += padding;
+        head = 0;
+    }
+
+    StagedRecord header;
+    header.length = need;
+    header.slot = slot;
+    header.level = packet.level;
+    header.flags = flags;
+    header.tagLength = tagLength;
+    header.messageLength = messageLength;
+    header.timestamp = packet.timestamp;
+    header.sequence = stage.nextSequence;
+
+    uint8_t* entry = stageMemory.data + head;
+    memcpy(entry, &header, sizeof(header));
+    memcpy(entry + sizeof(header), packet.tag, tagLength);
+    memcpy(entry + sizeof(header) + tagLength, message, messageLength);
+
+    // Published after the entry, so a reset mid-append finds the previous state
+    if (stage.used == 0) {
+        stage.tail = 0;
+    }
+    stage.head = (head + need) % WAL_STAGE_BYTES;
+    stage.used = used + need;
+    stage.nextSequence++;
+    slotBytes[slot] += need;
+    publish();
+    return true;
+}
+
+void WriteAheadStage::committed(int slot) {
+    if (slot < 0 || slot >= WAL_STAGE_SLOTS) {
+        return;
+    }
+
+    RingState& stage = state;
+    stageMemory.committedSequence[slot] = stage.nextSequence - 1;
+    slotBytes[slot] = 0;
+
+    // Drop from the front up to the first record still waiting on another session
+    while (stage.used > 0 && skipPadding() && stage.used > 0) {
+        const StagedRecord* record = recordAt(stage.tail);
+        if (record->sequence > stageMemory.committedSequence[record->slot]) {
+            break;
+        }
+        stage.tail = (stage.tail + record->length) % WAL_STAGE_BYTES;
+        stage.used -= record->length;
+    }
+    if (stage.used == 0) {
+        stage.head = 0;
+        stage.tail = 0;
+    }
+    publish();
+}
+
+void WriteAheadStage::discardOldest() {
+    RingState& stage = state;
+    if (stage.used == 0 || !skipPadding() || stage.used == 0) {
+        return;
+    }
+    const StagedRecord* record = recordAt(stage.tail);
+    if (record->sequence > stageMemory.committedSequence[record->slot]) {
+        slotBytes[record->slot] -= min(slotBytes[record->slot], (uint32_t)record->length);
+    }
+    stage.tail = (stage.tail + record->length) % WAL_STAGE_BYTES;
+    stage.used -= record->length;
+    discarded++;
+    publish();
+}
+
+size_t WriteAheadStage::getUsed() {
+    return state.used;
+}
+
+size_t WriteAheadStage::getUsed(int slot) {
+    return slot >= 0 && slot < WAL_STAGE_SLOTS ? slotBytes[slot] : 0;
+}
+
+int WriteAheadStage::getOldestSlot() {
+    if (state.used == 0 || !skipPadding() || state.used == 0) {
+        return -1;
+    }
+    return recordAt(state.tail)->slot;
+}
+
+size_t WriteAheadStage::replay(int slot, const ReplayCallback& callback) {
+    if (slot < 0 || slot >= WAL_STAGE_SLOTS || pendingRecords == 0) {
+        return 0;
+    }
+
+    const RingState& stage = state;
+    uint32_t offset = stage.tail;
+    uint32_t remaining = stage.used;
+    size_t count = 0;
+    LogPacket packet;
+    while (remaining > 0) {
+        if (offset + sizeof(StagedRecord) > WAL_STAGE_BYTES || recordAt(offset)->length == 0) {
+            remaining -= WAL_STAGE_BYTES - offset;
+            offset = 0;
+            continue;
+        }
+
+        const StagedRecord* record = recordAt(offset);
+        if (record->slot == slot && record->sequence > stageMemory.committedSequence[slot]) {
+            const uint8_t* body = stageMemory.data + offset + sizeof(StagedRecord);
+            packet.timestamp = record->timestamp;
+            packet.level = record->level;
+            packet.flags = record->flags;
+            memcpy(packet.tag, body, record->tagLength);
+            packet.tag[record->tagLength] = '\0';
+            packet.tagId = TagRegistry::intern(packet.tag);
+            memcpy(packet.message, body + record->tagLength, record->messageLength);
+            packet.message[record->messageLength] = '\0';
+            packet.length = record->messageLength;
+            callback(packet);
+            count++;
+        }
+        offset = (offset + record->length) % WAL_STAGE_BYTES;
+        remaining -= record->length;
+    }
+    return count;
+}
+
+}  // namespace Core
+}  // namespace BTLogger
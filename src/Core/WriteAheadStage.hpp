@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "LogProtocol.hpp"
+
+namespace BTLogger {
+namespace Core {
+
+// Staging ring in RTC slow memory, which survives panics, watchdog and brownout resets (not power loss).
+// The 8KB of RTC slow memory caps it below the write-back buffers, so it also bounds what a session buffers
+#define WAL_STAGE_BYTES (6 * 1024)
+#define WAL_STAGE_SLOTS 4  // One per session stream, matches SD_MAX_SESSIONS
+#define WAL_PATH_LENGTH 64
+#define WAL_STAGE_MAGIC 0x4C415742  // "BWAL"
+
+/**
+ * WriteAheadStage keeps a copy of every record still sitting in an SD
+ * write-back buffer. Records are appended as they are queued for the card
+ * and dropped once a synced commit of their session has put them there, so
+ * what is left after a reset is exactly the tail the card never got; the
+ * next boot replays it into the session file it belonged to.
+ *
+ * Each session commits once it has its share of the ring staged; if the
+ * ring fills anyway the session holding its oldest record commits, and only
+ * if that doesn't help is the oldest record given up. Ring state changes are
+ * built in a spare copy of the header and published by one store, so a reset
+ * at any point leaves either the old or the new state. Storage task only.
+ */
+class WriteAheadStage {
+   public:
+    using ReplayCallback = std::function<void(const LogPacket& packet)>;
+
+    // Checks what the last boot left; call before any session opens
+    static void initialize();
+
+    static void setFile(int slot, const char* path);  // Session slot opened (or rotated to) path
+    static void closeFile(int slot);
+    static bool stage(int slot, const LogPacket& packet);  // False if the ring is full
+    static void committed(int slot);                       // Everything staged for slot is on the card
+    static void discardOldest();
+
+    // Left over from before the reset: the file each slot was writing and its records not on the card
+    static bool hasPending() { return pendingRecords > 0; }
+    static const char* getFile(int slot);
+    static size_t replay(int slot, const ReplayCallback& callback);
+    static void clear();
+
+    static size_t getUsed();
+    static size_t getUsed(int slot);  // Staged for slot and not yet committed
+    static int getOldestSlot();       // Slot of the record at the front, -1 if empty
+    static uint32_t getDiscarded() { return discarded; }
+
+   private:
+    struct __attribute__((packed)) StagedRecord {
+        uint16_t length;  // Whole entry, padded to 4 bytes; 0 marks the wrap to the start
+        uint8_t slot;
+        uint8_t level;
+        uint8_t flags;
+        uint8_t tagLength;
+        uint16_t messageLength;
+        uint32_t timestamp;
+        uint32_t sequence;
+    };
+
+    struct RingState {
+        uint32_t head;  // Byte offsets into data
+        uint32_t tail;
+        uint32_t used;
+        uint32_t nextSequence;
+        uint32_t check;  // Of the fields above, so a never-written copy is ignored
+    };
+
+    struct Stage {
+        uint32_t magic;
+        uint32_t current;  // Which copy of the ring state is in effect; flipped last by publish()
+        RingState rings[2];
+        uint32_t committedSequence[WAL_STAGE_SLOTS];
+        char files[WAL_STAGE_SLOTS][WAL_PATH_LENGTH];
+        uint8_t data[WAL_STAGE_BYTES];
+    };
+
+    static Stage stageMemory;
+    static RingState state;  // Working copy of the published ring state
+    static size_t pendingRecords;
+    static uint32_t discarded;
+    static uint32_t slotBytes[WAL_STAGE_SLOTS];
+
+    static uint32_t headerCheck(const RingState& ring);
+    static void publish();
+    static StagedRecord* recordAt(uint32_t offset);
+    static bool skipPadding();
+    static bool validate(size_t& records);
+};
+
+}  // namespace Core
+}  // namespace BTLogger
@@ -0,0 +1,183 @@
+#pragma once
+
+/*
+ * Host stand-ins for the Arduino and ESP-IDF calls the portable core makes,
+ * for BTLOGGER_NATIVE builds only (see Platform.hpp). They behave like the
+ * originals as far as the core relies on: a monotonic millis()/micros(),
+ * a portMUX that may be taken again by the task holding it, the zlib CRC
+ * the ROM implements, esp_random() and a File over stdio.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+using std::max;
+using std::min;
+
+#define constrain(amount, low, high) ((amount) < (low) ? (low) : ((amount) > (high) ? (high) : (amount)))
+
+// Timing, from the first call
+inline int64_t esp_timer_get_time() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+inline unsigned long millis() { return (unsigned long)(esp_timer_get_time() / 1000); }
+inline unsigned long micros() { return (unsigned long)esp_timer_get_time(); }
+inline void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+inline uint32_t esp_random() {
+    static std::mt19937 generator{std::random_device{}()};
+    return generator();
+}
+
+// Critical sections; one thread at a time, nesting allowed as on the ESP32
+struct portMUX_TYPE {
+    std::recursive_mutex mutex;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) ((mux)->mutex.lock())
+#define portEXIT_CRITICAL(mux) ((mux)->mutex.unlock())
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
+#define portENTER_CRITICAL_SAFE(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_SAFE(mux) portEXIT_CRITICAL(mux)
+
+// There is no PSRAM; every capability is the one heap
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+inline void* heap_caps_malloc(size_t size, [[maybe_unused]] uint32_t caps) { return malloc(size); }
+inline void* heap_caps_realloc(void* pointer, size_t size, [[maybe_unused]] uint32_t caps) { return realloc(pointer, size); }
+inline void heap_caps_free(void* pointer) { free(pointer); }
+
+// Same polynomial and pre/post inversion as the ROM's little-endian CRC32
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* data, uint32_t length) {
+    static const struct Table {
+        uint32_t entries[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    value = value & 1 ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+                }
+                entries[i] = value;
+            }
+        }
+    } table;
+
+    crc = ~crc;
+    for (uint32_t i = 0; i < length; i++) {
+        crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * String keeps the handful of Arduino String calls the core makes.
+ */
+class String {
+   public:
+    String() = default;
+    String(const char* text) : value(text ? text : "") {}
+    String(const std::string& text) : value(text) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.length(); }
+    bool isEmpty() const { return value.empty(); }
+
+    String& operator+=(const String& other) {
+        value += other.value;
+        return *this;
+    }
+    String operator+(const String& other) const { return String(value + other.value); }
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator!=(const String& other) const { return value != other.value; }
+
+   private:
+    std::string value;
+};
+
+/**
+ * Print writes to a stdio stream; Serial is stdout.
+ */
+class Print {
+   public:
+    explicit Print(FILE* stream = stdout) : stream(stream) {}
+
+    size_t write(uint8_t c) { return fputc(c, stream) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* data, size_t length) { return fwrite(data, 1, length, stream); }
+
+    size_t print(const char* text) { return fputs(text, stream) < 0 ? 0 : strlen(text); }
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(long value) { return printf("%ld", value); }
+    size_t print(unsigned long value) { return printf("%lu", value); }
+    size_t print(int value) { return print((long)value); }
+    size_t print(unsigned int value) { return print((unsigned long)value); }
+    size_t print(double value, int digits = 2) { return printf("%.*f", digits, value); }
+
+    size_t println() { return print('\n'); }
+    template <typename T>
+    size_t println(const T& value) {
+        size_t written = print(value);
+        return written + println();
+    }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int written = vfprintf(stream, format, args);
+        va_end(args);
+        return written < 0 ? 0 : written;
+    }
+
+   private:
+    FILE* stream;
+};
+
+inline Print Serial;
+
+/**
+ * File is a stdio file, shared between copies like the Arduino one.
+ */
+class File {
+   public:
+    File() = default;
+    File(const char* path, const char* mode) : handle(fopen(path, mode), [](FILE* f) {
+        if (f) fclose(f);
+    }) {}
+
+    explicit operator bool() const { return handle && handle.get(); }
+
+    size_t read(uint8_t* buffer, size_t length) { return *this ? fread(buffer, 1, length, handle.get()) : 0; }
+    size_t write(const uint8_t* buffer, size_t length) { return *this ? fwrite(buffer, 1, length, handle.get()) : 0; }
+    bool seek(uint32_t position) { return *this && fseek(handle.get(), position, SEEK_SET) == 0; }
+    size_t position() const { return *this ? ftell(handle.get()) : 0; }
+    size_t size() const {
+        if (!*this) return 0;
+        long here = ftell(handle.get());
+        fseek(handle.get(), 0, SEEK_END);
+        long end = ftell(handle.get());
+        fseek(handle.get(), here, SEEK_SET);
+        return end;
+    }
+    int available() const { return size() - position(); }
+    void flush() {
+        if (*this) fflush(handle.get());
+    }
+    void close() { handle.reset(); }
+
+   private:
+    std::shared_ptr<FILE> handle;
+};
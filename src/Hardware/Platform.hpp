@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+ * The little of Arduino and ESP-IDF the portable core uses: timing, Serial,
+ * portMUX critical sections, heap_caps allocation, the ROM CRC, esp_random()
+ * and File.
+ *
+ * On the device this is just the framework headers. Built with
+ * BTLOGGER_NATIVE (the native environment in platformio.ini) it is
+ * HostPlatform.hpp instead, so decoding, the rings, the block format and
+ * filtering run on a PC.
+ */
+#ifdef BTLOGGER_NATIVE
+#include "HostPlatform.hpp"
+#else
+#include <Arduino.h>
+#include <FS.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#endif
@@ -0,0 +1,39 @@
+#include "SharedSPIBus.hpp"
+
+namespace BTLogger {
+namespace Hardware {
+
+// Static member definitions
+SPIClass* SharedSPIBus::bus = nullptr;
+SemaphoreHandle_t SharedSPIBus::mutex = nullptr;
+
+SPIClass& SharedSPIBus::get() {
+    // Created on first use during setup, before any task shares it
+    if (!bus) {
+        bus = new SPIClass(VSPI);
+        getMutex();
+    }
+    return *bus;
+}
+
+SemaphoreHandle_t SharedSPIBus::getMutex() {
+    if (!mutex) {
+        mutex = xSemaphoreCreateRecursiveMutex();
+    }
+    return mutex;
+}
+
+void SharedSPIBus::lock() {
+    xSemaphoreTakeRecursive(getMutex(), portMAX_DELAY);
+}
+
+bool SharedSPIBus::tryLock() {
+    return xSemaphoreTakeRecursive(getMutex(), 0) == pdTRUE;
+}
+
+void SharedSPIBus::unlock() {
+    xSemaphoreGiveRecursive(getMutex());
+}
+
+}  // namespace Hardware
+}  // namespace BTLogger
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+namespace BTLogger {
+namespace Hardware {
+
+/**
+ * SharedSPIBus is the VSPI bus the SD card sits on, kept for the whole boot
+ * so other devices can share it. Single SPI transactions are already
+ * serialized by SPIClass; the lock here covers bursts of them (a session
+ * commit), so an occasional user like the touch controller can read only
+ * while the card is idle instead of waiting behind a long write.
+ */
+class SharedSPIBus {
+   public:
+    static SPIClass& get();
+
+    static void lock();
+    static bool tryLock();  // Never blocks
+    static void unlock();
+
+    // Holds the bus for a scope
+    struct Hold {
+        Hold() { SharedSPIBus::lock(); }
+        ~Hold() { SharedSPIBus::unlock(); }
+    };
+
+   private:
+    static SPIClass* bus;
+    static SemaphoreHandle_t mutex;
+
+    static SemaphoreHandle_t getMutex();
+};
+
+}  // namespace Hardware
+}  // namespace BTLogger
@@ -0,0 +1,60 @@
+#include "FrameScheduler.hpp"
+
+namespace BTLogger {
+namespace UI {
+
+// Static member definitions
+TaskHandle_t FrameScheduler::task = nullptr;
+unsigned long FrameScheduler::lastFrame = 0;
+unsigned long FrameScheduler::deadline = 0;
+bool FrameScheduler::hasDeadline = false;
+uint32_t FrameScheduler::frames = 0;
+
+void FrameScheduler::requestFrame() {
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void IRAM_ATTR FrameScheduler::requestFrameFromISR() {
+    if (task) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+void FrameScheduler::requestFrameIn(uint32_t ms) {
+    unsigned long due = millis() + ms;
+    if (!hasDeadline || (long)(due - deadline) < 0) {
+        deadline = due;
+        hasDeadline = true;
+    }
+}
+
+void FrameScheduler::waitForFrame() {
+    unsigned long now = millis();
+    uint32_t sleep = UI_IDLE_FRAME_MS;
+    if (hasDeadline) {
+        sleep = (long)(deadline - now) > 0 ? deadline - now : 0;
+    }
+
+    // Wakeups arriving together (a burst of log lines) collapse into one frame
+    if (sleep > 0) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleep));
+    }
+    now = millis();
+    if (now - lastFrame < UI_MIN_FRAME_MS) {
+        vTaskDelay(pdMS_TO_TICKS(UI_MIN_FRAME_MS - (now - lastFrame)));
+        ulTaskNotifyTake(pdTRUE, 0);
+    }
+
+    lastFrame = millis();
+    hasDeadline = false;
+    frames++;
+}
+
+}  // namespace UI
+}  // namespace BTLogger
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace BTLogger {
+namespace UI {
+
+// UI frame pacing
+#define UI_MIN_FRAME_MS 16     // Frames never run closer together than this
+#define UI_IDLE_FRAME_MS 1000  // Longest sleep with nothing requested (a safety net, not a tick)
+#define UI_TOUCH_POLL_MS 20    // Frame interval while the panel is touched
+
+/**
+ * FrameScheduler lets the UI task sleep until there is something to draw.
+ * Anything that changes what is on screen wakes it: new messages or log
+ * data from other tasks, the touch interrupt, or a deadline requested by the
+ * frame that just ran (toast timeouts, periodic refreshes). Deadlines are
+ * cleared at the start of each frame, so whatever still needs a later frame
+ * asks again.
+ */
+class FrameScheduler {
+   public:
+    static void attach(TaskHandle_t uiTask) { task = uiTask; }
+
+    // Wake the UI task for a frame; any task
+    static void requestFrame();
+    static void IRAM_ATTR requestFrameFromISR();
+
+    // Run another frame within ms; UI task only
+    static void requestFrameIn(uint32_t ms);
+
+    // Block until a frame is due, then start it
+    static void waitForFrame();
+
+    static uint32_t getFrameCount() { return frames; }
+
+   private:
+    static TaskHandle_t task;
+    static unsigned long lastFrame;
+    static unsigned long deadline;
+    static bool hasDeadline;
+    static uint32_t frames;
+};
+
+}  // namespace UI
+}  // namespace BTLogger
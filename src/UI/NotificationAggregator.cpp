@@ -0,0 +1,124 @@
+#include "NotificationAggregator.hpp"
+#include "ToastManager.hpp"
+#include "FrameScheduler.hpp"
+
+namespace BTLogger {
+namespace UI {
+
+// Static member definitions
+NotificationAggregator::Slot NotificationAggregator::slots[NOTIFY_SLOTS] = {};
+unsigned long NotificationAggregator::lastShown = 0;
+uint32_t NotificationAggregator::reported = 0;
+uint32_t NotificationAggregator::shown = 0;
+
+void NotificationAggregator::report(uint8_t level, Core::DeviceId deviceId, Core::TagId tagId, const char* text) {
+    unsigned long now = millis();
+    Slot& slot = findSlot(deviceId, tagId, now);
+
+    if (slot.pending == 0) {
+        slot.firstPending = now;
+        slot.level = level;
+    } else if (level > slot.level) {
+        slot.level = level;
+    }
+    slot.pending++;
+    slot.lastSeen = now;
+    strncpy(slot.text, text, sizeof(slot.text) - 1);
+    slot.text[sizeof(slot.text) - 1] = '\0';
+    reported++;
+
+    // A quiet tag shows right away if the toast hasn't just changed
+    if (slot.pending == 1 && now - lastShown >= NOTIFY_CADENCE_MS) {
+        refill(slot, now);
+        if (slot.tokens > 0) {
+            showSlot(slot, now);
+        }
+    }
+}
+
+void NotificationAggregator::update() {
+    unsigned long now = millis();
+    bool cadenceDue = now - lastShown >= NOTIFY_CADENCE_MS;
+
+    // Errors before warnings, then whatever has waited longest
+    Slot* next = nullptr;
+    unsigned long wait = 0;  // Until the next slot could be shown, 0 if none is waiting
+    for (Slot& slot : slots) {
+        if (!slot.used || slot.pending == 0) {
+            continue;
+        }
+        refill(slot, now);
+        if (slot.tokens == 0) {
+            unsigned long refillIn = NOTIFY_REFILL_MS - (now - slot.lastRefill);
+            wait = wait ? min(wait, refillIn) : refillIn;
+            continue;
+        }
+        if (!next || slot.level > next->level || (slot.level == next->level && slot.firstPending < next->firstPending)) {
+            next = &slot;
+        }
+    }
+
+    if (next && cadenceDue) {
+        showSlot(*next, now);  // Others may still be waiting: look again after a cadence
+        FrameScheduler::requestFrameIn(NOTIFY_CADENCE_MS);
+    } else if (next) {
+        FrameScheduler::requestFrameIn(NOTIFY_CADENCE_MS - (now - lastShown));
+    } else if (wait) {
+        FrameScheduler::requestFrameIn(wait);
+    }
+}
+
+NotificationAggregator::Slot& NotificationAggregator::findSlot(Core::DeviceId deviceId, Core::TagId tagId, unsigned long now) {
+    Slot* reuse = nullptr;
+    for (Slot& slot : slots) {
+        if (slot.used && slot.deviceId == deviceId && slot.tagId == tagId) {
+            return slot;
+        }
+        // Prefer a free slot, then the longest idle one with nothing pending
+        if (!reuse || reuseRank(slot) < reuseRank(*reuse) ||
+            (reuseRank(slot) == reuseRank(*reuse) && slot.lastSeen < reuse->lastSeen)) {
+            reuse = &slot;
+        }
+    }
+
+    Slot& slot = *reuse;
+    slot.tagId = tagId;
+    slot.deviceId = deviceId;
+    slot.tokens = NOTIFY_BURST;
+    slot.pending = 0;
+    slot.lastRefill = now;
+    slot.used = true;
+    return slot;
+}
+
+void NotificationAggregator::refill(Slot& slot, unsigned long now) {
+    while (slot.tokens < NOTIFY_BURST && now - slot.lastRefill >= NOTIFY_REFILL_MS) {
+        slot.tokens++;
+        slot.lastRefill += NOTIFY_REFILL_MS;
+    }
+    if (slot.tokens == NOTIFY_BURST) {
+        slot.lastRefill = now;
+    }
+}
+
+void NotificationAggregator::showSlot(Slot& slot, unsigned long now) {
+    char message[TOAST_MESSAGE_LENGTH];
+    bool error = slot.level >= 4;
+    if (slot.pending == 1) {
+        snprintf(message, sizeof(message), "%s %s: %s", Core::DeviceRegistry::getName(slot.deviceId),
+                 error ? "ERROR" : "WARN", slot.text);
+    } else {
+        unsigned long seconds = max(1UL, (now - slot.firstPending + 500) / 1000);
+        snprintf(message, sizeof(message), "%c: %s x%lu in %lus", error ? 'E' : 'W', Core::TagRegistry::getName(slot.tagId),
+                 (unsigned long)slot.pending, seconds);
+    }
+    ToastManager::show(message, error ? ToastManager::ERROR : ToastManager::WARNING);
+
+    slot.tokens--;
+    slot.pending = 0;
+    lastShown = now;
+    shown++;
+}
+
+}  // namespace UI
+}  // namespace BTLogger
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../Core/DeviceRegistry.hpp"
+#include "../Core/TagRegistry.hpp"
+
+namespace BTLogger {
+namespace UI {
+
+// Notification aggregation configuration
+#define NOTIFY_SLOTS 8             // Tag/device pairs tracked at once
+#define NOTIFY_TEXT_LENGTH 48
+#define NOTIFY_BURST 2             // Toasts one tag may show back to back
+#define NOTIFY_REFILL_MS 3000      // After that, one toast per tag this often
+#define NOTIFY_CADENCE_MS 500      // The toast changes at most this often
+
+/**
+ * NotificationAggregator turns WARN/ERROR records into toasts without
+ * letting a storm of them take over the display. Records are counted per
+ * tag and device; each tag spends a token per toast from a small bucket, and
+ * what arrives while it has none is shown later as one summary
+ * ("E: SENSOR x37 in 2s"). The toast is replaced at most every
+ * NOTIFY_CADENCE_MS, errors first. UI task only; nothing is allocated.
+ */
+class NotificationAggregator {
+   public:
+    static void report(uint8_t level, Core::DeviceId deviceId, Core::TagId tagId, const char* text);
+    static void update();
+
+    static uint32_t getReported() { return reported; }
+    static uint32_t getShown() { return shown; }
+
+   private:
+    struct Slot {
+        char text[NOTIFY_TEXT_LENGTH];  // Latest message
+        Core::DeviceId deviceId;
+        Core::TagId tagId;
+        uint8_t level;                  // Highest level pending
+        uint8_t tokens;
+        bool used;
+        uint32_t pending;               // Records since the last toast
+        unsigned long firstPending;
+        unsigned long lastRefill;
+        unsigned long lastSeen;
+    };
+
+    static Slot slots[NOTIFY_SLOTS];
+    static unsigned long lastShown;
+    static uint32_t reported;
+    static uint32_t shown;
+
+    static Slot& findSlot(Core::DeviceId deviceId, Core::TagId tagId, unsigned long now);
+    static void refill(Slot& slot, unsigned long now);
+    static int reuseRank(const Slot& slot) { return (slot.used ? 2 : 0) + (slot.pending ? 1 : 0); }
+    static void showSlot(Slot& slot, unsigned long now);
+};
+
+}  // namespace UI
+}  // namespace BTLogger
@@ -0,0 +1,158 @@
+#include "RenderTarget.hpp"
+#include "Screen.hpp"
+#include <esp_heap_caps.h>
+
+namespace BTLogger {
+namespace UI {
+
+// Static member definitions
+lgfx::LGFX_Device* RenderTarget::lcd = nullptr;
+lgfx::LGFX_Sprite* RenderTarget::canvas[2] = {nullptr, nullptr};
+int RenderTarget::canvasCount = 0;
+int RenderTarget::composing = 0;
+uint8_t RenderTarget::inFlight[2] = {0, 0};
+bool RenderTarget::writing = false;
+RenderTarget::Mode RenderTarget::mode = RenderTarget::DIRECT;
+
+void RenderTarget::initialize(lgfx::LGFX_Device& display) {
+    lcd = &display;
+    mode = DIRECT;
+    canvasCount = 0;
+
+    if (!RENDER_TARGET_ENABLED) {
+        Serial.println("Render target disabled - drawing directly");
+        return;
+    }
+
+    size_t pixels = (size_t)lcd->width() * lcd->height();
+    size_t internalFree = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    size_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_DMA);
+
+    if (psramFound() && ESP.getFreePsram() >= pixels * 2 && createCanvas(0, 16, true)) {
+        mode = PSRAM_16BIT;
+    } else if (internalFree >= pixels * 4 + RENDER_HEAP_RESERVE && largestBlock >= pixels * 2 &&
+               createCanvas(0, 16, false)) {
+        mode = createCanvas(1, 16, false) ? DMA_16BIT_DOUBLE : DMA_16BIT;
+    } else if (internalFree >= pixels * 2 + RENDER_HEAP_RESERVE && largestBlock >= pixels * 2 &&
+               createCanvas(0, 16, false)) {
+        mode = DMA_16BIT;
+    } else if (internalFree >= pixels + RENDER_HEAP_RESERVE && largestBlock >= pixels &&
+               createCanvas(0, 8, false)) {
+        mode = INTERNAL_8BIT;
+    }
+
+    Serial.printf("Render target: %s (%u bytes internal free)\n", getModeName(), (unsigned)internalFree);
+}
+
+void RenderTarget::cleanup() {
+    finish();
+    for (int i = 0; i < canvasCount; i++) {
+        canvas[i]->deleteSprite();
+        delete canvas[i];
+        canvas[i] = nullptr;
+    }
+    canvasCount = 0;
+    mode = DIRECT;
+}
+
+bool RenderTarget::createCanvas(int index, int depth, bool psram) {
+    auto sprite = new lgfx::LGFX_Sprite(lcd);
+    sprite->setPsram(psram);
+    sprite->setColorDepth(depth);
+    if (!sprite->createSprite(lcd->width(), lcd->height())) {
+        delete sprite;
+        return false;
+    }
+    canvas[index] = sprite;
+    canvasCount = index + 1;
+    return true;
+}
+
+void RenderTarget::getRows(Region region, int& top, int& rows) {
+    int footerTop = lcd->height() - Screen::FOOTER_HEIGHT;
+    int bottom = lcd->height();
+
+    top = (region & HEADER) ? 0 : (region & CONTENT) ? Screen::HEADER_HEIGHT
+                                                     : footerTop;
+    if (!(region & FOOTER)) {
+        bottom = (region & CONTENT) ? footerTop : Screen::HEADER_HEIGHT;
+    }
+    rows = bottom - top;
+}
+
+lgfx::LovyanGFX& RenderTarget::begin(Region region) {
+    if (mode == DIRECT) {
+        return *lcd;
+    }
+
+    // Any canvas whose copy of these rows is not still being sent will do
+    for (int i = 0; i < canvasCount; i++) {
+        if (!(inFlight[i] & region)) {
+            composing = i;
+            return *canvas[i];
+        }
+    }
+
+    lcd->waitDMA();
+    inFlight[0] = inFlight[1] = 0;
+    composing = 0;
+    return *canvas[0];
+}
+
+void RenderTarget::present(Region region) {
+    if (mode == DIRECT) {
+        return;
+    }
+
+    int top, rows;
+    getRows(region, top, rows);
+    if (rows <= 0) {
+        return;
+    }
+
+    if (!writing) {
+        lcd->startWrite();
+        writing = true;
+    }
+
+    int width = lcd->width();
+    auto sprite = canvas[composing];
+    if (mode == INTERNAL_8BIT) {
+        auto pixels = (const lgfx::rgb332_t*)sprite->getBuffer() + (size_t)top * width;
+        lcd->pushImage(0, top, width, rows, pixels);
+    } else {
+        auto pixels = (const lgfx::swap565_t*)sprite->getBuffer() + (size_t)top * width;
+        if (mode == PSRAM_16BIT) {
+            lcd->pushImage(0, top, width, rows, pixels);
+        } else {
+            lcd->pushImageDMA(0, top, width, rows, pixels);
+            inFlight[composing] |= region;
+        }
+    }
+}
+
+void RenderTarget::finish() {
+    if (writing) {
+        lcd->endWrite();
+        writing = false;
+    }
+    inFlight[0] = inFlight[1] = 0;
+}
+
+const char* RenderTarget::getModeName() {
+    switch (mode) {
+        case PSRAM_16BIT:
+            return "16-bit PSRAM canvas";
+        case DMA_16BIT:
+            return "16-bit DMA canvas";
+        case DMA_16BIT_DOUBLE:
+            return "16-bit DMA canvas, double buffered";
+        case INTERNAL_8BIT:
+            return "8-bit canvas";
+        default:
+            return "direct";
+    }
+}
+
+}  // namespace UI
+}  // namespace BTLogger
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+
+namespace BTLogger {
+namespace UI {
+
+// Off-screen composition
+#define RENDER_TARGET_ENABLED true
+#define RENDER_HEAP_RESERVE (64 * 1024)  // Internal heap left for BLE, queues and the log store
+
+/**
+ * RenderTarget composes full redraws off-screen and sends them to the panel
+ * in one bulk transfer, so screen switches and page scrolls appear at once
+ * instead of being painted line by line.
+ *
+ * The canvas is one sprite the size of the display, split into row bands
+ * (header, content, footer). Callers draw with the same absolute coordinates
+ * as on the panel: begin() a region, redraw all of it, then present() it.
+ * Bands are disjoint rows, so the next band can be composed while the last
+ * one is still going out by DMA.
+ *
+ * The buffering mode follows the memory at startup: a PSRAM canvas (pushed
+ * synchronously, the SPI DMA cannot read PSRAM), one or two 16-bit canvases
+ * in internal RAM pushed by DMA, an 8-bit canvas, or none at all, in which
+ * case begin() hands back the display and drawing works as before.
+ */
+class RenderTarget {
+   public:
+    enum Region : uint8_t {
+        HEADER = 1,
+        CONTENT = 2,
+        FOOTER = 4,
+        BODY = HEADER | CONTENT,
+        FULL = HEADER | CONTENT | FOOTER
+    };
+
+    enum Mode {
+        DIRECT,
+        PSRAM_16BIT,
+        DMA_16BIT,
+        DMA_16BIT_DOUBLE,
+        INTERNAL_8BIT
+    };
+
+    // Call after the big allocations so the budget sees what is left
+    static void initialize(lgfx::LGFX_Device& display);
+    static void cleanup();
+
+    // Surface to redraw the region on; the display when unbuffered
+    static lgfx::LovyanGFX& begin(Region region);
+    static void present(Region region);
+
+    // Wait for transfers and release the bus; end of each UI frame
+    static void finish();
+
+    static bool isBuffered() { return mode != DIRECT; }
+    static Mode getMode() { return mode; }
+    static const char* getModeName();
+
+   private:
+    static lgfx::LGFX_Device* lcd;
+    static lgfx::LGFX_Sprite* canvas[2];
+    static int canvasCount;
+    static int composing;
+    static uint8_t inFlight[2];  // Regions of each canvas still being sent
+    static bool writing;
+    static Mode mode;
+
+    static bool createCanvas(int index, int depth, bool psram);
+    static void getRows(Region region, int& top, int& rows);
+};
+
+}  // namespace UI
+}  // namespace BTLogger
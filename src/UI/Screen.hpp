@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include <LovyanGFX.hpp>
 #include <functional>
+#include "FrameScheduler.hpp"
 
 namespace BTLogger {
 namespace UI {
@@ -38,7 +39,10 @@ class Screen {
     // State
     bool isActive() const { return active; }
     String getName() const { return screenName; }
-    void markForRedraw() { needsRedraw = true; }
+    void markForRedraw() {
+        needsRedraw = true;
+        FrameScheduler::requestFrame();
+    }
 
    protected:
     String screenName;
@@ -1,5 +1,7 @@
 #include "ScreenManager.hpp"
 #include "UIScale.hpp"
+#include "FrameScheduler.hpp"
+#include "RenderTarget.hpp"
 
 namespace BTLogger {
 namespace UI {
@@ -8,6 +10,7 @@ namespace UI {
 bool ScreenManager::initialized = false;
 lgfx::LGFX_Device* ScreenManager::lcd = nullptr;
 std::map<String, Screen*> ScreenManager::screens;
+std::map<String, ScreenManager::ScreenFactory> ScreenManager::factories;
 std::vector<String> ScreenManager::navigationStack;
 Screen* ScreenManager::currentScreen = nullptr;
 String ScreenManager::statusText = "Ready";
@@ -31,10 +34,13 @@ void ScreenManager::cleanup() {
     }
 
     for (auto& pair : screens) {
-        pair.second->cleanup();
-        delete pair.second;
+        if (pair.second) {
+            pair.second->cleanup();
+            delete pair.second;
+        }
     }
     screens.clear();
+    factories.clear();
     navigationStack.clear();
 
     initialized = false;
@@ -45,18 +51,21 @@ void ScreenManager::registerScreen(Screen* screen) {
         return;
     }
 
-    screen->initialize(*lcd);
-    screen->setNavigationCallback([](const String& screenName) {
-        ScreenManager::navigateTo(screenName);
-    });
-    screen->setBackCallback([]() {
-        ScreenManager::goBack();
-    });
-
+    setUp(screen);
     screens[screen->getName()] = screen;
     Serial.printf("Registered screen: %s\n", screen->getName().c_str());
 }
 
+void ScreenManager::registerScreen(const String& screenName, ScreenFactory factory) {
+    if (!factory || !initialized) {
+        return;
+    }
+
+    screens[screenName] = nullptr;
+    factories[screenName] = factory;
+    Serial.printf("Registered screen: %s (built on first use)\n", screenName.c_str());
+}
+
 void ScreenManager::navigateTo(const String& screenName) {
     Serial.printf("ScreenManager::navigateTo called with: %s\n", screenName.c_str());
 
@@ -70,6 +79,10 @@ void ScreenManager::navigateTo(const String& screenName) {
         return;
     }
 
+    if (!build(screenName)) {
+        return;
+    }
+
     // Push current screen to stack if we have one
     if (currentScreen) {
         navigationStack.push_back(currentScreen->getName());
@@ -103,6 +116,7 @@ void ScreenManager::setStatusText(const String& status) {
     if (statusText != status) {
         statusText = status;
         footerNeedsRedraw = true;
+        FrameScheduler::requestFrame();
     }
 }
 
@@ -148,32 +162,64 @@ void ScreenManager::drawStatusFooter() {
         return;
     }
 
+    auto& gfx = RenderTarget::begin(RenderTarget::FOOTER);
     int footerY = lcd->height() - Screen::FOOTER_HEIGHT;
 
     // Draw footer background
-    lcd->fillRect(0, footerY, lcd->width(), Screen::FOOTER_HEIGHT, 0x0000);
-    lcd->drawFastHLine(0, footerY, lcd->width(), 0x8410);  // Gray line
+    gfx.fillRect(0, footerY, lcd->width(), Screen::FOOTER_HEIGHT, 0x0000);
+    gfx.drawFastHLine(0, footerY, lcd->width(), 0x8410);  // Gray line
 
     // Draw status text
-    lcd->setTextColor(0x8410);  // Gray
-    lcd->setTextSize(UIScale::scale(1));
-    lcd->setCursor(UIScale::scale(5), footerY + UIScale::scale(5));
-    lcd->print(statusText.substring(0, 35));  // Limit length to fit screen
+    gfx.setTextColor(0x8410);  // Gray
+    gfx.setTextSize(UIScale::scale(1));
+    gfx.setCursor(UIScale::scale(5), footerY + UIScale::scale(5));
+    gfx.print(statusText.substring(0, 35));  // Limit length to fit screen
 
     // Draw back button indicator if we can go back
     if (!navigationStack.empty()) {
-        lcd->setTextColor(0xFFFF);  // White
-        lcd->setCursor(lcd->width() - UIScale::scale(30), footerY + UIScale::scale(5));
-        lcd->print("< BACK");
+        gfx.setTextColor(0xFFFF);  // White
+        gfx.setCursor(lcd->width() - UIScale::scale(30), footerY + UIScale::scale(5));
+        gfx.print("< BACK");
     }
+
+    RenderTarget::present(RenderTarget::FOOTER);
+}
+
+void ScreenManager::setUp(Screen* screen) {
+    screen->initialize(*lcd);
+    screen->setNavigationCallback([](const String& screenName) {
+        ScreenManager::navigateTo(screenName);
+    });
+    screen->setBackCallback([]() {
+        ScreenManager::goBack();
+    });
+}
+
+Screen* ScreenManager::build(const String& screenName) {
+    auto it = screens.find(screenName);
+    if (it == screens.end()) {
+        return nullptr;
+    }
+    if (!it->second) {
+        // Only the entry's value changes; the map itself stays as registered
+        it->second = factories[screenName]();
+        if (!it->second) {
+            Serial.printf("Failed to build screen: %s\n", screenName.c_str());
+            return nullptr;
+        }
+        setUp(it->second);
+        Serial.printf("Built screen: %s\n", screenName.c_str());
+    }
+    return it->second;
 }
 
 void ScreenManager::switchToScreen(const String& screenName) {
     auto it = screens.find(screenName);
-    if (it != screens.end()) {
+    if (it != screens.end() && it->second) {
         currentScreen = it->second;
         currentScreen->activate();
         footerNeedsRedraw = true;  // Ensure footer is drawn for new screen
+        FrameScheduler::requestFrame();  // Navigation happens late in a frame; draw in the next one
     }
 }
 
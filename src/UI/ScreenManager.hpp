@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 #include <LovyanGFX.hpp>
+#include <functional>
 #include <map>
 #include <vector>
 #include "Screen.hpp"
@@ -10,19 +11,24 @@ namespace BTLogger {
 namespace UI {
 
 /**
- * ScreenManager handles navigation between different UI screens
+ * ScreenManager handles navigation between different UI screens. Screens
+ * registered with a factory are built the first time they are navigated
+ * to, so boot doesn't pay for screens nobody opens.
  */
 class ScreenManager {
    public:
+    using ScreenFactory = std::function<Screen*()>;
+
     static void initialize(lgfx::LGFX_Device& display);
     static void cleanup();
 
     // Screen management
     static void registerScreen(Screen* screen);
+    static void registerScreen(const String& screenName, ScreenFactory factory);
     static void navigateTo(const String& screenName);
     static void goBack();
     static void setStatusText(const String& status);
-    static Screen* getScreen(const String& screenName);
+    static Screen* getScreen(const String& screenName);  // nullptr until built
 
     // Main loop
     static void update();
@@ -35,7 +41,8 @@ class ScreenManager {
    private:
     static bool initialized;
     static lgfx::LGFX_Device* lcd;
-    static std::map<String, Screen*> screens;
+    static std::map<String, Screen*> screens;  // Every name is in from registration; lazy ones hold nullptr until built
+    static std::map<String, ScreenFactory> factories;
     static std::vector<String> navigationStack;
     static Screen* currentScreen;
     static String statusText;
@@ -43,6 +50,8 @@ class ScreenManager {
 
     static void drawStatusFooter();
     static void switchToScreen(const String& screenName);
+    static void setUp(Screen* screen);
+    static Screen* build(const String& screenName);
 };
 
 }  // namespace UI
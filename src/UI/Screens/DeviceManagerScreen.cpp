@@ -2,6 +2,7 @@
 #include "../UIScale.hpp"
 #include "../TouchManager.hpp"
 #include "../ScreenManager.hpp"
+#include "../../Core/ClockSync.hpp"
 
 namespace BTLogger {
 namespace UI {
@@ -50,6 +51,7 @@ void DeviceManagerScreen::update() {
         refreshDeviceList();
         lastRefresh = millis();
     }
+    FrameScheduler::requestFrameIn(REFRESH_INTERVAL - min((unsigned long)REFRESH_INTERVAL, millis() - lastRefresh) + 1);
 
     if (needsRedraw) {
         drawHeader();
@@ -142,6 +144,8 @@ void DeviceManagerScreen::refreshDeviceList() {
         }
     }
 
+    links = bluetoothManager->getConnectedLinks();
+
     updateDeviceList();
     markForRedraw();
 
@@ -228,6 +232,8 @@ void DeviceManagerScreen::drawDeviceList() {
     int infoAreaHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
     lcd->fillRect(0, infoAreaY, lcd->width(), infoAreaHeight, 0x0000);
 
+    drawLinkInfo();
+
     if (devices.empty()) {
         lcd->setTextColor(0x8410);  // Gray
         lcd->setTextSize(UIScale::getGeneralTextSize());
@@ -263,12 +269,61 @@ void DeviceManagerScreen::drawDeviceList() {
         if (scrollOffset < (int)devices.size() - maxVisibleDevices) {
             lcd->setTextColor(0xFFFF);
             lcd->setTextSize(UIScale::getGeneralTextSize());
-            lcd->setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
+            lcd->setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - getLinkInfoHeight() - UIScale::scale(15));
             lcd->print("v");
         }
     }
 }
 
+int DeviceManagerScreen::getLinkInfoHeight() const {
+    // Profile line plus one line per connected device
+    return links.empty() ? 0 : (links.size() + 1) * LINK_INFO_LINE_HEIGHT;
+}
+
+void DeviceManagerScreen::drawLinkInfo() {
+    if (!lcd || links.empty() || !bluetoothManager) return;
+
+    int y = lcd->height() - FOOTER_HEIGHT - getLinkInfoHeight();
+    lcd->drawFastHLine(0, y - 1, lcd->width(), 0x8410);
+    lcd->setTextSize(1);
+
+    lcd->setTextColor(0x8410);
+    lcd->setCursor(UIScale::scale(10), y + 1);
+    lcd->printf("Link profile: %s", Core::BluetoothManager::getLinkProfileName(bluetoothManager->getLinkProfile()));
+
+    // Interval/latency come from the controller once the update completes
+    lcd->setTextColor(0xFFFF);
+    char line[64];
+    for (const auto& link : links) {
+        y += LINK_INFO_LINE_HEIGHT;
+        const char* name = Core::DeviceRegistry::getName(link.deviceId);
+        if (link.interval) {
+            snprintf(line, sizeof(line), "%.*s %.1fms L%d MTU%d DLE%d %dM", link.compressed ? 6 : 10, name, link.getIntervalMs(),
+                     link.latency, link.mtu, link.txDataLength, link.phy);
+        } else {
+            snprintf(line, sizeof(line), "%.*s -- L- MTU%d DLE%d %dM", link.compressed ? 6 : 10, name, link.mtu,
+                     link.txDataLength, link.phy);
+        }
+        // Compression ratio of what this sender delivered so far
+        if (link.compressed) {
+            size_t used = strlen(line);
+            snprintf(line + used, sizeof(line) - used, " x%.1f", link.getCompressionRatio());
+        }
+        // Clock alignment: half the sync round trip bounds the error; "?" while only estimated from arrivals
+        Core::ClockSyncStatus clock;
+        if (Core::ClockSync::getStatus(link.deviceId, clock)) {
+            size_t used = strlen(line);
+            if (clock.source == Core::CLOCK_SOURCE_SYNC) {
+                snprintf(line + used, sizeof(line) - used, " T%.1f", clock.rttUs / 2000.0f);
+            } else {
+                snprintf(line + used, sizeof(line) - used, " T?");
+            }
+        }
+        lcd->setCursor(UIScale::scale(10), y + 1);
+        lcd->print(line);
+    }
+}
+
 void DeviceManagerScreen::handleScrolling(int x, int y, bool wasTapped) {
     if (!wasTapped || devices.size() <= maxVisibleDevices) return;
 
@@ -299,7 +354,7 @@ void DeviceManagerScreen::updateDeviceList() {
     int buttonSpacing = UIScale::scale(40);
     int buttonWidth = lcd->width() - UIScale::scale(20);
 
-    maxVisibleDevices = (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(20)) / buttonSpacing;
+    maxVisibleDevices = (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - getLinkInfoHeight() - UIScale::scale(20)) / buttonSpacing;
 
     for (size_t i = 0; i < devices.size() && i < MAX_DEVICES; i++) {
         int visibleIndex = i - scrollOffset;
@@ -343,35 +398,20 @@ String DeviceManagerScreen::clipText(const String& text, int maxWidth, int textS
         return text;  // Text fits, no clipping needed
     }
 
-    // Calculate how many characters we can fit with "..." at the end
-    int ellipsisWidth = UIScale::calculateTextWidth("...", textSize);
+    // Leave room for "..." and cut in one measuring pass
+    int ellipsisWidth = UIScale::calculateTextWidth("...", 3, textSize);
     int availableWidth = maxWidth - ellipsisWidth;
 
     if (availableWidth <= 0) {
         return "...";  // Not enough space for anything
     }
 
-    // Binary search to find the maximum number of characters that fit
-    int left = 0, right = text.length();
-    int bestFit = 0;
-
-    while (left <= right) {
-        int mid = (left + right) / 2;
-        int midWidth = UIScale::calculateTextWidth(text.substring(0, mid), textSize);
-
-        if (midWidth <= availableWidth) {
-            bestFit = mid;
-            left = mid + 1;
-        } else {
-            right = mid - 1;
-        }
-    }
-
-    if (bestFit == 0) {
+    size_t fit = UIScale::fitTextLength(text.c_str(), text.length(), textSize, availableWidth);
+    if (fit == 0) {
         return "...";
     }
 
-    return text.substring(0, bestFit) + "...";
+    return text.substring(0, fit) + "...";
 }
 
 String DeviceManagerScreen::formatDeviceInfo(const DeviceInfo& device) {
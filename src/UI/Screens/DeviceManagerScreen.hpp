@@ -50,6 +50,7 @@ class DeviceManagerScreen : public Screen {
 
     // Device data
     std::vector<DeviceInfo> devices;
+    std::vector<Core::LinkParameters> links;  // Negotiated parameters of connected devices
     Core::BluetoothManager* bluetoothManager;
     int scrollOffset;
     int maxVisibleDevices;
@@ -61,11 +62,14 @@ class DeviceManagerScreen : public Screen {
     static const int MAX_DEVICES = 20;
     static const int DEVICE_BUTTON_HEIGHT = 35;
     static const int REFRESH_INTERVAL = 3000;  // 3 seconds
+    static const int LINK_INFO_LINE_HEIGHT = 10;
 
     void createControlButtons();
     void updateDeviceList();
     void drawHeader();
     void drawDeviceList();
+    void drawLinkInfo();
+    int getLinkInfoHeight() const;
     void handleScrolling(int x, int y, bool wasTapped);
     void connectToDevice(const String& address);
     void disconnectFromDevice(const String& address);
@@ -0,0 +1,293 @@
+#include "DiagnosticsScreen.hpp"
+#include "../UIScale.hpp"
+#include "../TouchManager.hpp"
+#include "../ScreenManager.hpp"
+#include "../RenderTarget.hpp"
+#include "../../Core/BenchmarkMonitor.hpp"
+#include "../../Core/SenderControl.hpp"
+#include "../../Core/SerialMirror.hpp"
+#include "../../Core/NetworkRelay.hpp"
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+DiagnosticsScreen::DiagnosticsScreen() : Screen("Diagnostics"),
+                                         backButton(nullptr),
+                                         resetButton(nullptr),
+                                         dumpButton(nullptr),
+                                         lastTouchState(false),
+                                         lastUpdate(0),
+                                         previous() {
+}
+
+DiagnosticsScreen::~DiagnosticsScreen() {
+    cleanup();
+}
+
+void DiagnosticsScreen::activate() {
+    Screen::activate();
+
+    if (!backButton) {
+        createButtons();
+    }
+
+    Core::Metrics::snapshot(previous);
+    ScreenManager::setStatusText("Ingest diagnostics");
+}
+
+void DiagnosticsScreen::deactivate() {
+    Screen::deactivate();
+}
+
+void DiagnosticsScreen::update() {
+    if (!active) return;
+
+    if (needsRedraw) {
+        drawHeader();
+    }
+    if (needsRedraw || millis() - lastUpdate > 1000) {
+        drawMetrics();
+        needsRedraw = false;
+        lastUpdate = millis();
+    }
+    FrameScheduler::requestFrameIn(1000 - min(1000UL, millis() - lastUpdate) + 1);
+
+    // Update buttons
+    if (backButton) backButton->update();
+    if (resetButton) resetButton->update();
+    if (dumpButton) dumpButton->update();
+}
+
+void DiagnosticsScreen::handleTouch(int x, int y, bool touched) {
+    if (!active) return;
+
+    if (touched || lastTouchState) {
+        // Handle button touches
+        if (backButton) backButton->handleTouch(x, y, touched);
+        if (resetButton) resetButton->handleTouch(x, y, touched);
+        if (dumpButton) dumpButton->handleTouch(x, y, touched);
+
+        lastTouchState = touched;
+    }
+}
+
+void DiagnosticsScreen::cleanup() {
+    delete backButton;
+    delete resetButton;
+    delete dumpButton;
+
+    backButton = nullptr;
+    resetButton = nullptr;
+    dumpButton = nullptr;
+}
+
+void DiagnosticsScreen::createButtons() {
+    if (!lcd) return;
+
+    int buttonHeight = UIScale::scale(35);
+    int buttonY = UIScale::scale(15);
+
+    // BACK, RESET, DUMP share the full width
+    int totalWidth = lcd->width();
+    int buttonWidth = totalWidth / 3;
+
+    backButton = new Widgets::Button(*lcd, 0, buttonY, buttonWidth, buttonHeight, "BACK");
+    backButton->setCallback([this]() {
+        goBack();
+    });
+
+    resetButton = new Widgets::Button(*lcd, buttonWidth, buttonY, buttonWidth, buttonHeight, "RESET");
+    resetButton->setCallback([this]() {
+        Core::Metrics::reset();
+        Core::Metrics::snapshot(previous);
+        ScreenManager::setStatusText("Metrics reset");
+        markForRedraw();
+    });
+
+    dumpButton = new Widgets::Button(*lcd, buttonWidth * 2, buttonY, totalWidth - buttonWidth * 2, buttonHeight, "DUMP");
+    dumpButton->setCallback([this]() {
+        Core::MetricsSnapshot now;
+        Core::Metrics::snapshot(now);
+        Core::Metrics::dumpHeader(Serial);
+        Core::Metrics::dump(Serial, now, previous);
+        ScreenManager::setStatusText("Metrics printed to serial");
+    });
+}
+
+void DiagnosticsScreen::drawHeader() {
+    if (!lcd) return;
+
+    auto& gfx = RenderTarget::begin(RenderTarget::HEADER);
+    gfx.fillRect(0, 0, lcd->width(), HEADER_HEIGHT, 0x0000);
+
+    if (backButton) backButton->draw(gfx);
+    if (resetButton) resetButton->draw(gfx);
+    if (dumpButton) dumpButton->draw(gfx);
+
+    gfx.drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+    RenderTarget::present(RenderTarget::HEADER);
+}
+
+void DiagnosticsScreen::drawMetrics() {
+    if (!lcd) return;
+
+    Core::MetricsSnapshot now;
+    Core::Metrics::snapshot(now);
+
+    auto& gfx = RenderTarget::begin(RenderTarget::CONTENT);
+
+    int areaY = HEADER_HEIGHT;
+    int areaHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
+    gfx.fillRect(0, areaY, lcd->width(), areaHeight, 0x0000);
+
+    gfx.setTextColor(0xFFFF);  // White
+    gfx.setTextSize(UIScale::scale(1));
+
+    int x = UIScale::scale(10);
+    int y = areaY + UIScale::scale(6);
+    int lineHeight = UIScale::scale(12);
+
+    // Throughput since the last refresh
+    gfx.setCursor(x, y);
+    gfx.printf("RX %.1f/s %.1fKB/s  Records %.1f/s", now.getRate(Core::METRIC_RX_NOTIFICATIONS, previous),
+               now.getRate(Core::METRIC_RX_BYTES, previous) / 1024, now.getRate(Core::METRIC_DECODED_RECORDS, previous));
+    y += lineHeight;
+
+    gfx.setCursor(x, y);
+    gfx.printf("SD %.1fKB/s  UI %.1f fps", now.getRate(Core::METRIC_SD_BYTES, previous) / 1024,
+               now.getRate(Core::METRIC_UI_FRAMES, previous));
+    y += lineHeight;
+
+    // Anything lost on the way, in red
+    uint32_t drops[] = {now.counters[Core::METRIC_RX_DROPPED], now.counters[Core::METRIC_DECODE_ERRORS],
+                        now.counters[Core::METRIC_STORAGE_DROPPED], now.counters[Core::METRIC_SD_FAILED],
+                        now.counters[Core::METRIC_UI_DROPPED]};
+    bool anyDrops = false;
+    for (uint32_t drop : drops) {
+        anyDrops |= drop > 0;
+    }
+    gfx.setTextColor(anyDrops ? 0xF800 : 0xFFFF);
+    gfx.setCursor(x, y);
+    gfx.printf("Lost ring %lu bad %lu queue %lu sd %lu ui %lu", (unsigned long)drops[0], (unsigned long)drops[1],
+               (unsigned long)drops[2], (unsigned long)drops[3], (unsigned long)drops[4]);
+    gfx.setTextColor(0xFFFF);
+    y += lineHeight;
+
+    // Gaps on the link: resent by the sender, or given up on
+    uint32_t linkLost = now.counters[Core::METRIC_RECORDS_LOST];
+    gfx.setTextColor(linkLost > 0 ? 0xF800 : 0xFFFF);
+    gfx.setCursor(x, y);
+    gfx.printf("Link resent %lu lost %lu  Flow %s %u%%", (unsigned long)now.counters[Core::METRIC_RECORDS_RESENT],
+               (unsigned long)linkLost, Core::SenderControl::getStateName(Core::SenderControl::getState()),
+               Core::SenderControl::getLoad());
+    gfx.setTextColor(0xFFFF);
+    y += lineHeight;
+
+    gfx.setCursor(x, y);
+    gfx.printf("Peak ring %lu queue %lu buffer %luB", (unsigned long)now.levels[Core::METRIC_LEVEL_INGEST_RING],
+               (unsigned long)now.levels[Core::METRIC_LEVEL_STORAGE_QUEUE],
+               (unsigned long)now.levels[Core::METRIC_LEVEL_WRITE_BUFFER]);
+    y += lineHeight;
+
+    // Serial mirror: what the UART keeps up with, and what it could not
+    uint32_t serialDropped = now.counters[Core::METRIC_SERIAL_DROPPED];
+    gfx.setTextColor(serialDropped > 0 ? 0xF800 : 0xFFFF);
+    gfx.setCursor(x, y);
+    gfx.printf("Serial %s %lu %.1fKB/s dropped %lu",
+               Core::SerialMirror::getFormatName(Core::SerialMirror::getFormat()),
+               (unsigned long)Core::SerialMirror::getBaud(), now.getRate(Core::METRIC_SERIAL_BYTES, previous) / 1024,
+               (unsigned long)serialDropped);
+    gfx.setTextColor(0xFFFF);
+    y += lineHeight;
+
+    // Network relay, once turned on: link state, rate and how well batches compress
+    if (Core::NetworkRelay::isEnabled()) {
+        Core::NetworkRelayStats relay = Core::NetworkRelay::getStats();
+        gfx.setTextColor(relay.dropped > 0 ? 0xF800 : 0xFFFF);
+        gfx.setCursor(x, y);
+        gfx.printf("Relay %s %.1fKB/s %.1fx dropped %lu", Core::NetworkRelay::getStateName(relay.state),
+                   now.getRate(Core::METRIC_RELAY_BYTES, previous) / 1024,
+                   relay.bytes ? (float)relay.rawBytes / relay.bytes : 0.0f, (unsigned long)relay.dropped);
+        gfx.setTextColor(0xFFFF);
+        y += lineHeight;
+    }
+
+    // Latest sender benchmark run, if one was seen
+    Core::BenchmarkStatus bench;
+    if (Core::BenchmarkMonitor::getStatus(bench)) {
+        gfx.setTextColor(bench.active ? 0x07E0 : 0x8410);  // Green while running
+        gfx.setCursor(x, y);
+        gfx.printf("Bench %04x %lu rx %.1f/s lost %lu dup %lu late %lu", bench.runId, (unsigned long)bench.received,
+                   bench.getRate(), (unsigned long)bench.getLost(), (unsigned long)bench.duplicates,
+                   (unsigned long)bench.reordered);
+        gfx.setTextColor(0xFFFF);
+        y += lineHeight;
+    }
+    y += UIScale::scale(4);
+
+    // Latency table
+    gfx.setTextColor(0x8410);  // Gray
+    gfx.setCursor(x, y);
+    gfx.print("Latency");
+    gfx.setCursor(UIScale::scale(120), y);
+    gfx.print("p50");
+    gfx.setCursor(UIScale::scale(180), y);
+    gfx.print("p99");
+    gfx.setCursor(UIScale::scale(240), y);
+    gfx.print("max");
+    gfx.setTextColor(0xFFFF);
+    y += lineHeight;
+
+    drawLatency(gfx, y, "Sender>RX", now, Core::METRIC_HIST_SENDER_TO_RX);
+    y += lineHeight;
+    drawLatency(gfx, y, "RX>decode", now, Core::METRIC_HIST_RING_WAIT);
+    y += lineHeight;
+    drawLatency(gfx, y, "RX>card", now, Core::METRIC_HIST_RX_TO_SD);
+    y += lineHeight;
+    drawLatency(gfx, y, "Card write", now, Core::METRIC_HIST_SD_WRITE);
+    y += lineHeight;
+    drawLatency(gfx, y, "RX>screen", now, Core::METRIC_HIST_RX_TO_PIXEL);
+    y += lineHeight;
+    drawLatency(gfx, y, "UI frame", now, Core::METRIC_HIST_UI_FRAME);
+
+    RenderTarget::present(RenderTarget::CONTENT);
+    previous = now;
+}
+
+void DiagnosticsScreen::drawLatency(lgfx::LovyanGFX& gfx, int y, const char* label, const Core::MetricsSnapshot& now,
+                                    Core::MetricHistogram histogram) {
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.print(label);
+    if (now.getCount(histogram) == 0) {
+        gfx.setCursor(UIScale::scale(120), y);
+        gfx.print("-");
+        return;
+    }
+
+    // Percentiles are over everything since boot or the last reset
+    char text[16];
+    formatMicros(now.getPercentileUs(histogram, 50), text, sizeof(text));
+    gfx.setCursor(UIScale::scale(120), y);
+    gfx.print(text);
+    formatMicros(now.getPercentileUs(histogram, 99), text, sizeof(text));
+    gfx.setCursor(UIScale::scale(180), y);
+    gfx.print(text);
+    formatMicros(now.maxUs[histogram], text, sizeof(text));
+    gfx.setCursor(UIScale::scale(240), y);
+    gfx.print(text);
+}
+
+void DiagnosticsScreen::formatMicros(uint32_t us, char* out, size_t capacity) {
+    if (us < 1000) {
+        snprintf(out, capacity, "%luus", (unsigned long)us);
+    } else if (us < 1000000) {
+        snprintf(out, capacity, "%.1fms", us / 1000.0f);
+    } else {
+        snprintf(out, capacity, "%.2fs", us / 1000000.0f);
+    }
+}
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../Screen.hpp"
+#include "../Widgets/Button.hpp"
+#include "../../Core/Metrics.hpp"
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+/**
+ * Diagnostics screen: ingest rates, drops, queue high-water marks and
+ * latency percentiles for each stage, refreshed once a second
+ */
+class DiagnosticsScreen : public Screen {
+   public:
+    DiagnosticsScreen();
+    virtual ~DiagnosticsScreen();
+
+    // Screen interface
+    void activate() override;
+    void deactivate() override;
+    void update() override;
+    void handleTouch(int x, int y, bool touched) override;
+    void cleanup() override;
+
+   private:
+    // UI Elements
+    Widgets::Button* backButton;
+    Widgets::Button* resetButton;
+    Widgets::Button* dumpButton;
+
+    bool lastTouchState;
+    unsigned long lastUpdate;
+    Core::MetricsSnapshot previous;  // Rates are since the last refresh
+
+    void createButtons();
+    void drawHeader();
+    void drawMetrics();
+    void drawLatency(lgfx::LovyanGFX& gfx, int y, const char* label, const Core::MetricsSnapshot& now,
+                     Core::MetricHistogram histogram);
+
+    static void formatMicros(uint32_t us, char* out, size_t capacity);
+};
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
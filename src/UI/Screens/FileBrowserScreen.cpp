@@ -1,6 +1,8 @@
 #include "FileBrowserScreen.hpp"
+#include "FileViewerScreen.hpp"
 #include "../UIScale.hpp"
 #include "../ScreenManager.hpp"
+#include "../RenderTarget.hpp"
 #include "../TouchManager.hpp"
 
 namespace BTLogger {
@@ -11,12 +13,14 @@ FileBrowserScreen::FileBrowserScreen() : Screen("FileBrowser"),
                                          backButton(nullptr),
                                          refreshButton(nullptr),
                                          deleteButton(nullptr),
+                                         fileList(nullptr),
                                          sdCardManager(nullptr),
                                          currentPath("/"),
-                                         scrollOffset(0),
-                                         maxVisibleFiles(0),
                                          lastTouchState(false),
-                                         selectedFileIndex(-1) {
+                                         lastScanDraw(0),
+                                         useCatalog(false),
+                                         catalogGeneration(0),
+                                         waitingForCard(false) {
 }
 
 FileBrowserScreen::~FileBrowserScreen() {
@@ -28,6 +32,7 @@ void FileBrowserScreen::activate() {
 
     if (!backButton) {
         createControlButtons();
+        createFileList();
     }
 
     refreshFileList();
@@ -36,11 +41,24 @@ void FileBrowserScreen::activate() {
 
 void FileBrowserScreen::deactivate() {
     Screen::deactivate();
+    directory.close();
 }
 
 void FileBrowserScreen::update() {
     if (!active) return;
 
+    if (waitingForCard) {
+        if (sdCardManager->isReady()) {
+            refreshFileList();
+        } else {
+            FrameScheduler::requestFrameIn(FILE_SCAN_REDRAW_MS);
+        }
+    } else if (directory.isScanning()) {
+        scanStep();
+    } else if (useCatalog) {
+        checkCatalog();
+    }
+
     if (needsRedraw) {
         drawFileList();
         needsRedraw = false;
@@ -51,10 +69,7 @@ void FileBrowserScreen::update() {
     if (refreshButton) refreshButton->update();
     if (deleteButton) deleteButton->update();
 
-    // Update file buttons
-    for (auto button : fileButtons) {
-        if (button) button->update();
-    }
+    if (fileList) fileList->update();
 }
 
 void FileBrowserScreen::handleTouch(int x, int y, bool touched) {
@@ -71,12 +86,7 @@ void FileBrowserScreen::handleTouch(int x, int y, bool touched) {
         if (refreshButton) refreshButton->handleTouch(x, y, touched);
         if (deleteButton) deleteButton->handleTouch(x, y, touched);
 
-        // Handle file buttons
-        for (auto button : fileButtons) {
-            if (button) {
-                button->handleTouch(x, y, touched);
-            }
-        }
+        if (fileList) fileList->handleTouch(x, y, touched);
 
         lastTouchState = touched;
     }
@@ -86,16 +96,13 @@ void FileBrowserScreen::cleanup() {
     delete backButton;
     delete refreshButton;
     delete deleteButton;
-
-    for (auto button : fileButtons) {
-        delete button;
-    }
-    fileButtons.clear();
+    delete fileList;
 
     backButton = nullptr;
     refreshButton = nullptr;
     deleteButton = nullptr;
-    files.clear();
+    fileList = nullptr;
+    directory.close();
 }
 
 void FileBrowserScreen::setSDCardManager(Core::SDCardManager* sdManager) {
@@ -120,7 +127,7 @@ void FileBrowserScreen::createControlButtons() {
                                      buttonWidth, buttonHeight, "BACK");
     backButton->setCallback([this]() {
         Serial.println("Back button pressed in FileBrowser");
-        goBack();
+        navigateUp();
     });
     currentX += buttonWidth;
 
@@ -147,187 +154,306 @@ void FileBrowserScreen::createControlButtons() {
                   lcd->width());
 }
 
+void FileBrowserScreen::createFileList() {
+    fileList = new Widgets::VirtualList(*lcd);
+    fileList->setSource(this);
+
+    int buttonSpacing = UIScale::scale(35);
+    int visibleRows = (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(20)) / buttonSpacing;
+    fileList->setLayout(UIScale::scale(10), HEADER_HEIGHT + UIScale::scale(10), UIScale::scale(FILE_BUTTON_HEIGHT),
+                        buttonSpacing, visibleRows, UIScale::scale(5));
+}
+
 void FileBrowserScreen::refreshFileList() {
     if (!sdCardManager) {
         ScreenManager::setStatusText("SD Card not available");
         return;
     }
 
-    if (!sdCardManager->isCardPresent()) {
-        files.clear();
-        updateFileList();
+    selectedName = "";
+
+    // Boot mounts the card in the background
+    waitingForCard = !sdCardManager->isReady();
+    if (waitingForCard) {
+        directory.close();
+        fileList->scrollTo(0);
+        fileList->refresh();
         markForRedraw();
-        ScreenManager::setStatusText("SD Card not inserted");
+        ScreenManager::setStatusText("SD card starting...");
+        FrameScheduler::requestFrameIn(FILE_SCAN_REDRAW_MS);
         return;
     }
 
-    // Get file list from SD card manager
-    files.clear();
+    // The log directory needs no reading while the catalog covers it
+    const Core::SessionCatalog& catalog = sdCardManager->getCatalog();
+    useCatalog = catalog.isComplete() && currentPath == sdCardManager->getLogDirectory();
+    if (useCatalog) {
+        directory.close();
+        catalogGeneration = catalog.getGeneration();
+        fileList->scrollTo(0);
+        fileList->refresh();
+        markForRedraw();
+        ScreenManager::setStatusText(String(catalog.size()) + " sessions");
+        return;
+    }
 
-    // Add example files for demonstration
-    files.emplace_back("logs", "/logs", true);
-    files.emplace_back("config.txt", "/config.txt", false, 1024);
-    files.emplace_back("session_001.log", "/logs/session_001.log", false, 15360);
-    files.emplace_back("session_002.log", "/logs/session_002.log", false, 8192);
-    files.emplace_back("backup", "/backup", true);
-    files.emplace_back("settings.json", "/settings.json", false, 512);
+    if (!sdCardManager->isCardPresent() || !directory.begin(currentPath)) {
+        directory.close();
+        fileList->scrollTo(0);
+        fileList->refresh();
+        markForRedraw();
+        ScreenManager::setStatusText(sdCardManager->isCardPresent() ? "Cannot open " + currentPath : "SD Card not inserted");
+        return;
+    }
 
-    updateFileList();
+    // The listing fills in over the next frames
+    fileList->scrollTo(0);
+    fileList->refresh();
+    lastScanDraw = millis();
     markForRedraw();
-    ScreenManager::setStatusText(String("Found ") + files.size() + " items");
+    ScreenManager::setStatusText("Reading " + currentPath + "...");
 }
 
-void FileBrowserScreen::updateFileList() {
-    // Clear existing file buttons
-    for (auto button : fileButtons) {
-        delete button;
+void FileBrowserScreen::scanStep() {
+    bool more = directory.step();
+    fileList->refresh();
+
+    // Entries land in sorted order, so the visible rows may change on any step
+    if (!more || millis() - lastScanDraw >= FILE_SCAN_REDRAW_MS) {
+        lastScanDraw = millis();
+        markForRedraw();
     }
-    fileButtons.clear();
 
-    // Calculate layout
-    int startY = HEADER_HEIGHT + UIScale::scale(10);
-    int buttonHeight = UIScale::scale(FILE_BUTTON_HEIGHT);
-    int buttonSpacing = UIScale::scale(35);
-    int buttonWidth = lcd->width() - UIScale::scale(20);
+    if (more) {
+        FrameScheduler::requestFrame();
+        return;
+    }
+
+    String status = String("Found ") + directory.size() + " items";
+    if (directory.getSkipped() > 0) {
+        status += String(", ") + directory.getSkipped() + " not shown";
+    }
+    ScreenManager::setStatusText(status);
+}
 
-    maxVisibleFiles = (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(20)) / buttonSpacing;
+void FileBrowserScreen::checkCatalog() {
+    // Open sessions update on every commit; follow along at the scan cadence
+    uint32_t generation = sdCardManager->getCatalog().getGeneration();
+    if (generation == catalogGeneration || millis() - lastScanDraw < FILE_SCAN_REDRAW_MS) {
+        return;
+    }
+    catalogGeneration = generation;
+    lastScanDraw = millis();
+    fileList->refresh();
+    markForRedraw();
+}
 
-    // Create buttons for visible files
-    for (size_t i = 0; i < files.size() && i < MAX_FILES; i++) {
-        int visibleIndex = i - scrollOffset;
-        if (visibleIndex >= 0 && visibleIndex < maxVisibleFiles) {
-            int buttonY = startY + (visibleIndex * buttonSpacing);
+size_t FileBrowserScreen::getRowCount() {
+    return useCatalog ? sdCardManager->getCatalog().size() : directory.size();
+}
 
-            String buttonText = formatFileInfo(files[i]);
-            auto fileButton = new Widgets::Button(*lcd, UIScale::scale(10), buttonY,
-                                                  buttonWidth, buttonHeight, buttonText);
+void FileBrowserScreen::bindRow(size_t index, Widgets::VirtualList::Row& row) {
+    int width = lcd->width() - UIScale::scale(20);
 
-            // Capture file index for callback
-            size_t fileIndex = i;
+    if (useCatalog) {
+        Core::SessionRecord session;
+        if (!sdCardManager->getCatalog().getEntry(index, session)) {
+            return;
+        }
+        row.setCells(&width, 1);
+        Widgets::Button* button = row.cell(0);
+        button->setText(formatSessionInfo(session));
+        if (selectedName == session.name) {
+            button->setColors(0xFFE0, 0xFFE8, 0x8410, 0x0000);  // Yellow when selected
+        } else if (session.flags & SESSION_RECORD_OPEN) {
+            button->setColors(0x07E0, 0x07E8, 0x8410, 0x0000);  // Green while being written
+        } else {
+            button->setColors(0x8410, 0x8418, 0x4208, 0xFFFF);  // Gray for files
+        }
+        return;
+    }
 
-            fileButton->setCallback([this, fileIndex]() {
-                selectFile(fileIndex);
-            });
+    Core::DirectoryEntry entry;
+    if (!directory.getEntry(index, entry)) {
+        return;
+    }
 
-            // Color based on file type and selection
-            if ((int)i == selectedFileIndex) {
-                fileButton->setColors(0xFFE0, 0xFFE8, 0x8410, 0x0000);  // Yellow when selected
-            } else if (files[i].isDirectory) {
-                fileButton->setColors(0x07FF, 0x07F8, 0x8410, 0x0000);  // Cyan for directories
-            } else {
-                fileButton->setColors(0x8410, 0x8418, 0x4208, 0xFFFF);  // Gray for files
-            }
+    row.setCells(&width, 1);
+    Widgets::Button* button = row.cell(0);
+    button->setText(formatFileInfo(entry));
 
-            fileButtons.push_back(fileButton);
-        }
+    // Color based on file type and selection
+    if (!entry.isDirectory && selectedName == entry.name) {
+        button->setColors(0xFFE0, 0xFFE8, 0x8410, 0x0000);  // Yellow when selected
+    } else if (entry.isDirectory) {
+        button->setColors(0x07FF, 0x07F8, 0x8410, 0x0000);  // Cyan for directories
+    } else {
+        button->setColors(0x8410, 0x8418, 0x4208, 0xFFFF);  // Gray for files
     }
 }
 
+void FileBrowserScreen::onRowTapped(size_t index, int cell) {
+    selectFile(index);
+}
 void FileBrowserScreen::drawFileList() {
     if (!lcd) return;
 
-    // Clear entire screen first
-    lcd->fillScreen(0x0000);
+    // Compose the whole page off-screen
+    auto& gfx = RenderTarget::begin(RenderTarget::BODY);
+    gfx.fillScreen(0x0000);
 
     // Draw header with control buttons
-    if (backButton) backButton->draw();
-    if (refreshButton) refreshButton->draw();
-    if (deleteButton) deleteButton->draw();
+    if (backButton) backButton->draw(gfx);
+    if (refreshButton) refreshButton->draw(gfx);
+    if (deleteButton) deleteButton->draw(gfx);
 
     // Draw header line
-    lcd->drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+    gfx.drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
 
     int infoAreaY = HEADER_HEIGHT;
     int infoAreaHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
 
-    if (files.empty()) {
-        lcd->setTextColor(0x8410);  // Gray
-        lcd->setTextSize(UIScale::getGeneralTextSize());
-        lcd->setCursor(UIScale::scale(10), infoAreaY + UIScale::scale(20));
+    if (getRowCount() == 0) {
+        gfx.setTextColor(0x8410);  // Gray
+        gfx.setTextSize(UIScale::getGeneralTextSize());
+        gfx.setCursor(UIScale::scale(10), infoAreaY + UIScale::scale(20));
 
         if (!sdCardManager) {
-            lcd->print("SD Card Manager not available");
+            gfx.print("SD Card Manager not available");
+        } else if (waitingForCard) {
+            gfx.print("SD card starting...");
         } else if (!sdCardManager->isCardPresent()) {
-            lcd->print("SD Card not inserted");
+            gfx.print("SD Card not inserted");
+        } else if (directory.isScanning()) {
+            gfx.print("Reading directory...");
         } else {
-            lcd->print("No files found");
-            lcd->setCursor(UIScale::scale(10), infoAreaY + UIScale::scale(40));
-            lcd->print("Directory is empty");
+            gfx.print("No files found");
+            gfx.setCursor(UIScale::scale(10), infoAreaY + UIScale::scale(40));
+            gfx.print("Directory is empty");
         }
+        RenderTarget::present(RenderTarget::BODY);
         return;
     }
 
     // Draw file buttons
-    for (auto button : fileButtons) {
-        if (button) {
-            button->draw();
-        }
-    }
+    fileList->draw(gfx);
 
     // Draw scroll indicators
-    if (files.size() > maxVisibleFiles) {
+    if (fileList->canScrollUp() || fileList->canScrollDown()) {
         int indicatorX = lcd->width() - UIScale::scale(10);
 
-        if (scrollOffset > 0) {
-            lcd->setTextColor(0xFFFF);
-            lcd->setTextSize(UIScale::getGeneralTextSize());
-            lcd->setCursor(indicatorX, infoAreaY + UIScale::scale(5));
-            lcd->print("^");
+        if (fileList->canScrollUp()) {
+            gfx.setTextColor(0xFFFF);
+            gfx.setTextSize(UIScale::getGeneralTextSize());
+            gfx.setCursor(indicatorX, infoAreaY + UIScale::scale(5));
+            gfx.print("^");
         }
 
-        if (scrollOffset < (int)files.size() - maxVisibleFiles) {
-            lcd->setTextColor(0xFFFF);
-            lcd->setTextSize(UIScale::getGeneralTextSize());
-            lcd->setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
-            lcd->print("v");
+        if (fileList->canScrollDown()) {
+            gfx.setTextColor(0xFFFF);
+            gfx.setTextSize(UIScale::getGeneralTextSize());
+            gfx.setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
+            gfx.print("v");
         }
     }
+
+    RenderTarget::present(RenderTarget::BODY);
 }
 
-void FileBrowserScreen::selectFile(int index) {
-    if (index < 0 || index >= (int)files.size()) return;
+void FileBrowserScreen::selectFile(size_t index) {
+    if (useCatalog) {
+        Core::SessionRecord session;
+        if (!sdCardManager->getCatalog().getEntry(index, session)) return;
+
+        // A second tap opens it
+        if (selectedName == session.name) {
+            FileViewerScreen::showFile(sdCardManager->getLogDirectory() + "/" + session.name);
+            navigateTo("FileViewer");
+            return;
+        }
+
+        selectedName = session.name;
+        String status = String(session.device[0] ? session.device : session.name) + ": " + session.lines + " lines";
+        if (session.levelCounts[SESSION_INDEX_LEVELS - 1] > 0) {
+            status += String(", ") + session.levelCounts[SESSION_INDEX_LEVELS - 1] + " errors";
+        }
+        ScreenManager::setStatusText(status);
+        fileList->refresh();
+        markForRedraw();
+        return;
+    }
 
-    selectedFileIndex = index;
-    const FileInfo& file = files[index];
+    Core::DirectoryEntry entry;
+    if (!directory.getEntry(index, entry)) return;
 
-    Serial.printf("Selected file: %s\n", file.name.c_str());
+    Serial.printf("Selected file: %s\n", entry.name);
 
-    if (file.isDirectory) {
-        // Navigate to directory (placeholder)
-        ScreenManager::setStatusText("Dir: " + file.name);
-    } else {
-        // Show file info
-        String info = file.name + " (" + formatFileSize(file.size) + ")";
-        ScreenManager::setStatusText(info);
+    if (entry.isDirectory) {
+        navigateToDirectory(directory.getEntryPath(index));
+        return;
+    }
+
+    if (selectedName == entry.name) {
+        FileViewerScreen::showFile(directory.getEntryPath(index));
+        navigateTo("FileViewer");
+        return;
     }
 
-    updateFileList();
+    // Show file info
+    selectedName = entry.name;
+    ScreenManager::setStatusText(selectedName + " (" + formatFileSize(entry.size) + ")");
+    fileList->refresh();
     markForRedraw();
 }
-
 void FileBrowserScreen::deleteSelectedFile() {
-    if (selectedFileIndex < 0 || selectedFileIndex >= (int)files.size()) {
+    int position = -1;
+    if (!selectedName.isEmpty() && sdCardManager) {
+        position = useCatalog ? sdCardManager->getCatalog().find(selectedName.c_str()) : directory.find(selectedName.c_str());
+    }
+    if (position < 0) {
         ScreenManager::setStatusText("No file selected");
         return;
     }
 
-    const FileInfo& file = files[selectedFileIndex];
+    if (!sdCardManager || !fileOperationCallback) {
+        ScreenManager::setStatusText("Cannot delete - SD unavailable");
+        return;
+    }
+    if (!deletingName.isEmpty()) {
+        ScreenManager::setStatusText("Still deleting " + deletingName);
+        return;
+    }
 
-    if (sdCardManager) {
-        // Placeholder for actual deletion
-        Serial.printf("Deleting file: %s\n", file.path.c_str());
-        ScreenManager::setStatusText("File deleted: " + file.name);
+    // The storage task refuses files a session is writing; say so before asking
+    Core::SessionRecord session;
+    if (useCatalog && sdCardManager->getCatalog().getEntry(position, session) && (session.flags & SESSION_RECORD_OPEN)) {
+        ScreenManager::setStatusText("Still being written: " + selectedName);
+        return;
+    }
 
-        // Remove from list and refresh
-        files.erase(files.begin() + selectedFileIndex);
-        selectedFileIndex = -1;
-        updateFileList();
-        markForRedraw();
-    } else {
-        ScreenManager::setStatusText("Cannot delete - SD unavailable");
+    String path = useCatalog ? sdCardManager->getLogDirectory() + "/" + selectedName : directory.getEntryPath(position);
+    if (!fileOperationCallback("delete", path)) {
+        ScreenManager::setStatusText("Storage busy - try again");
+        return;
     }
+    deletingName = selectedName;
+    ScreenManager::setStatusText("Deleting " + deletingName + "...");
 }
 
+void FileBrowserScreen::onFileDeleted(bool success) {
+    String deleted = deletingName;
+    deletingName = "";
+    if (!active) {
+        return;
+    }
+
+    if (success) {
+        refreshFileList();
+        ScreenManager::setStatusText("File deleted: " + deleted);
+    } else {
+        ScreenManager::setStatusText("Delete failed: " + deleted);
+    }
+}
 // Helper function to clip text with ellipsis if it's too long
 String FileBrowserScreen::clipText(const String& text, int maxWidth, int textSize) {
     if (!lcd) return text;
@@ -337,41 +463,33 @@ String FileBrowserScreen::clipText(const String& text, int maxWidth, int textSiz
         return text;  // Text fits, no clipping needed
     }
 
-    // Calculate how many characters we can fit with "..." at the end
-    int ellipsisWidth = UIScale::calculateTextWidth("...", textSize);
+    // Leave room for "..." and cut in one measuring pass
+    int ellipsisWidth = UIScale::calculateTextWidth("...", 3, textSize);
     int availableWidth = maxWidth - ellipsisWidth;
 
     if (availableWidth <= 0) {
         return "...";  // Not enough space for anything
     }
 
-    // Binary search to find the maximum number of characters that fit
-    int left = 0, right = text.length();
-    int bestFit = 0;
-
-    while (left <= right) {
-        int mid = (left + right) / 2;
-        int midWidth = UIScale::calculateTextWidth(text.substring(0, mid), textSize);
-
-        if (midWidth <= availableWidth) {
-            bestFit = mid;
-            left = mid + 1;
-        } else {
-            right = mid - 1;
-        }
-    }
-
-    if (bestFit == 0) {
+    size_t fit = UIScale::fitTextLength(text.c_str(), text.length(), textSize, availableWidth);
+    if (fit == 0) {
         return "...";
     }
 
-    return text.substring(0, bestFit) + "...";
+    return text.substring(0, fit) + "...";
 }
 
-String FileBrowserScreen::formatFileInfo(const FileInfo& file) {
+String FileBrowserScreen::formatFileInfo(const Core::DirectoryEntry& file) {
     String prefix = file.isDirectory ? "[DIR] " : "";
     String suffix = file.isDirectory ? "" : " (" + formatFileSize(file.size) + ")";
+    return formatRow(prefix, file.name, suffix);
+}
+
+String FileBrowserScreen::formatSessionInfo(const Core::SessionRecord& session) {
+    return formatRow("", session.name, " (" + formatFileSize(session.size) + ", " + session.lines + "L)");
+}
 
+String FileBrowserScreen::formatRow(const String& prefix, const String& name, const String& suffix) {
     // Calculate available width for file name
     int buttonWidth = lcd->width() - UIScale::scale(20);  // Account for margins
     int prefixWidth = UIScale::calculateTextWidth(prefix, UIScale::getButtonTextSize());
@@ -379,11 +497,10 @@ String FileBrowserScreen::formatFileInfo(const FileInfo& file) {
     int availableForName = buttonWidth - prefixWidth - suffixWidth - UIScale::scale(16);  // Account for button padding
 
     // Clip file name if necessary
-    String clippedName = clipText(file.name, availableForName, UIScale::getButtonTextSize());
+    String clippedName = clipText(name, availableForName, UIScale::getButtonTextSize());
 
     return prefix + clippedName + suffix;
 }
-
 String FileBrowserScreen::formatFileSize(size_t bytes) {
     if (bytes < 1024) {
         return String(bytes) + "B";
@@ -395,7 +512,7 @@ String FileBrowserScreen::formatFileSize(size_t bytes) {
 }
 
 void FileBrowserScreen::handleScrolling(int x, int y, bool wasTapped) {
-    if (!wasTapped || files.size() <= maxVisibleFiles) return;
+    if (!wasTapped || !fileList || (!fileList->canScrollUp() && !fileList->canScrollDown())) return;
 
     int infoAreaY = HEADER_HEIGHT;
     int infoAreaHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
@@ -408,30 +525,30 @@ void FileBrowserScreen::handleScrolling(int x, int y, bool wasTapped) {
         }
     }
 }
-
 void FileBrowserScreen::scrollUp() {
-    if (scrollOffset > 0) {
-        scrollOffset--;
-        updateFileList();
+    if (fileList->scrollBy(-1)) {
         markForRedraw();
     }
 }
-
 void FileBrowserScreen::scrollDown() {
-    int maxScroll = std::max(0, (int)files.size() - maxVisibleFiles);
-    if (scrollOffset < maxScroll) {
-        scrollOffset++;
-        updateFileList();
+    if (fileList->scrollBy(1)) {
         markForRedraw();
     }
 }
-
 void FileBrowserScreen::navigateToDirectory(const String& dirPath) {
-    // Placeholder for directory navigation
     currentPath = dirPath;
     refreshFileList();
 }
 
+void FileBrowserScreen::navigateUp() {
+    if (currentPath == "/" || currentPath.isEmpty()) {
+        goBack();
+        return;
+    }
+
+    int slash = currentPath.lastIndexOf('/');
+    navigateToDirectory(slash > 0 ? currentPath.substring(0, slash) : String("/"));
+}
 }  // namespace Screens
 }  // namespace UI
 }  // namespace BTLogger
\ No newline at end of file
@@ -2,17 +2,26 @@
 
 #include "../Screen.hpp"
 #include "../Widgets/Button.hpp"
+#include "../Widgets/VirtualList.hpp"
 #include "../../Core/SDCardManager.hpp"
-#include <vector>
+#include "../../Core/DirectoryIndex.hpp"
+#include <functional>
 
 namespace BTLogger {
 namespace UI {
 namespace Screens {
 
+#define FILE_SCAN_REDRAW_MS 250  // Repaint cadence while a listing is still being read
+
 /**
- * File browser screen for SD card files
+ * File browser screen for SD card files. The log directory is listed from
+ * the session catalog, newest first, without touching the card; any other
+ * directory is read a slice per frame into a sorted index. Both are shown
+ * through a recycled list, so large directories open at once and scroll
+ * without allocating. Tapping the selected file again opens it in the
+ * FileViewer.
  */
-class FileBrowserScreen : public Screen {
+class FileBrowserScreen : public Screen, private Widgets::VirtualList::Source {
    public:
     FileBrowserScreen();
     virtual ~FileBrowserScreen();
@@ -26,49 +35,55 @@ class FileBrowserScreen : public Screen {
     // SD Card integration
     void setSDCardManager(Core::SDCardManager* sdManager);
 
-   private:
-    struct FileInfo {
-        String name;
-        String path;
-        bool isDirectory;
-        size_t size;
-
-        FileInfo(const String& n, const String& p, bool dir, size_t s = 0)
-            : name(n), path(p), isDirectory(dir), size(s) {}
-    };
+    // Deletes go to the storage task; the result comes back through onFileDeleted()
+    using FileOperationCallback = std::function<bool(const String& operation, const String& path)>;
+    void setFileOperationCallback(FileOperationCallback callback) { fileOperationCallback = callback; }
+    void onFileDeleted(bool success);
 
+   private:
     // UI Elements
     Widgets::Button* backButton;
     Widgets::Button* refreshButton;
     Widgets::Button* deleteButton;
-
-    // File list buttons (dynamically created)
-    std::vector<Widgets::Button*> fileButtons;
+    Widgets::VirtualList* fileList;
 
     // File data
-    std::vector<FileInfo> files;
+    Core::DirectoryIndex directory;
     Core::SDCardManager* sdCardManager;
     String currentPath;
-    int scrollOffset;
-    int maxVisibleFiles;
+    String selectedName;
+    String deletingName;  // Waiting on the storage task
+    FileOperationCallback fileOperationCallback;
     bool lastTouchState;
-    int selectedFileIndex;
+    unsigned long lastScanDraw;
+    bool useCatalog;  // Listing the log directory from the session catalog
+    uint32_t catalogGeneration;
+    bool waitingForCard;  // Opened while the storage task was still mounting; lists once it is done
 
     // Constants
-    static const int MAX_FILES = 50;
     static const int FILE_BUTTON_HEIGHT = 30;
 
+    // VirtualList::Source
+    size_t getRowCount() override;
+    void bindRow(size_t index, Widgets::VirtualList::Row& row) override;
+    void onRowTapped(size_t index, int cell) override;
+
     void createControlButtons();
+    void createFileList();
     void refreshFileList();
-    void updateFileList();
+    void scanStep();
+    void checkCatalog();
     void drawFileList();
     void handleScrolling(int x, int y, bool wasTapped);
-    void selectFile(int index);
+    void selectFile(size_t index);
     void deleteSelectedFile();
     void navigateToDirectory(const String& dirPath);
+    void navigateUp();
     void scrollUp();
     void scrollDown();
-    String formatFileInfo(const FileInfo& file);
+    String formatFileInfo(const Core::DirectoryEntry& file);
+    String formatSessionInfo(const Core::SessionRecord& session);
+    String formatRow(const String& prefix, const String& name, const String& suffix);
     String formatFileSize(size_t bytes);
     String clipText(const String& text, int maxWidth, int textSize);
 };
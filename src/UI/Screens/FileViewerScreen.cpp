@@ -0,0 +1,258 @@
+#include "FileViewerScreen.hpp"
+#include "FileBrowserScreen.hpp"
+#include "../UIScale.hpp"
+#include "../ScreenManager.hpp"
+#include "../RenderTarget.hpp"
+#include "../TouchManager.hpp"
+#include "../../Hardware/SharedSPIBus.hpp"
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+String FileViewerScreen::pendingPath;
+size_t FileViewerScreen::pendingLine = 0;
+
+FileViewerScreen::FileViewerScreen() : Screen("FileViewer"),
+                                       backButton(nullptr),
+                                       topButton(nullptr),
+                                       endButton(nullptr),
+                                       topLine(0),
+                                       visibleLines(1),
+                                       lineHeight(LINE_HEIGHT),
+                                       lastTouchState(false),
+                                       lastCountDraw(0) {
+}
+
+FileViewerScreen::~FileViewerScreen() {
+    cleanup();
+}
+
+void FileViewerScreen::showFile(const String& filePath, size_t line) {
+    pendingPath = filePath;
+    pendingLine = line;
+}
+
+void FileViewerScreen::activate() {
+    Screen::activate();
+
+    if (!backButton) {
+        createControlButtons();
+    }
+
+    // Text size may have changed in Settings since the last visit
+    lineHeight = max(UIScale::scale(LINE_HEIGHT), 8 * UIScale::getGeneralTextSize() + 2);
+    visibleLines = max(1, (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(10)) / lineHeight);
+
+    openFile();
+}
+
+void FileViewerScreen::deactivate() {
+    Screen::deactivate();
+
+    // Pages and the read buffer stay allocated; only the file is let go
+    Hardware::SharedSPIBus::Hold bus;
+    reader.close();
+}
+
+void FileViewerScreen::update() {
+    if (!active) return;
+
+    if (reader.isOpen() && !reader.isIndexed()) {
+        countStep();
+    }
+
+    if (needsRedraw) {
+        drawLines();
+        needsRedraw = false;
+    }
+
+    if (backButton) backButton->update();
+    if (topButton) topButton->update();
+    if (endButton) endButton->update();
+}
+
+void FileViewerScreen::handleTouch(int x, int y, bool touched) {
+    if (!active) return;
+
+    bool wasTapped = TouchManager::wasTapped();
+
+    if (wasTapped) {
+        handleScrolling(x, y, wasTapped);
+    }
+
+    if (touched || lastTouchState) {
+        if (backButton) backButton->handleTouch(x, y, touched);
+        if (topButton) topButton->handleTouch(x, y, touched);
+        if (endButton) endButton->handleTouch(x, y, touched);
+
+        lastTouchState = touched;
+    }
+}
+
+void FileViewerScreen::cleanup() {
+    delete backButton;
+    delete topButton;
+    delete endButton;
+
+    backButton = nullptr;
+    topButton = nullptr;
+    endButton = nullptr;
+
+    Hardware::SharedSPIBus::Hold bus;
+    reader.close();
+}
+
+void FileViewerScreen::createControlButtons() {
+    if (!lcd) return;
+
+    int buttonHeight = UIScale::scale(35);
+    int buttonY = UIScale::scale(15);
+    int buttonWidth = lcd->width() / 3;
+
+    backButton = new Widgets::Button(*lcd, 0, buttonY, buttonWidth, buttonHeight, "BACK");
+    backButton->setCallback([this]() {
+        goBack();
+    });
+
+    topButton = new Widgets::Button(*lcd, buttonWidth, buttonY, buttonWidth, buttonHeight, "TOP");
+    topButton->setCallback([this]() {
+        scrollTo(0);
+    });
+
+    // Takes the remaining width (handles any rounding)
+    endButton = new Widgets::Button(*lcd, buttonWidth * 2, buttonY, lcd->width() - buttonWidth * 2, buttonHeight, "END");
+    endButton->setCallback([this]() {
+        // To the last line counted so far; the rest follows as counting goes on
+        size_t lines = reader.getLineCount();
+        scrollTo(lines > (size_t)visibleLines ? lines - visibleLines : 0);
+    });
+}
+
+void FileViewerScreen::openFile() {
+    path = pendingPath;
+    topLine = 0;
+    lastCountDraw = millis();
+
+    bool opened;
+    {
+        Hardware::SharedSPIBus::Hold bus;
+        opened = !path.isEmpty() && reader.open(path);
+    }
+    if (!opened) {
+        ScreenManager::setStatusText(path.isEmpty() ? "No file selected" : "Cannot open " + path);
+        markForRedraw();
+        return;
+    }
+
+    scrollTo(pendingLine);
+    updateStatus();
+}
+
+void FileViewerScreen::countStep() {
+    {
+        Hardware::SharedSPIBus::Hold bus;
+        reader.indexAhead(FILE_VIEWER_INDEX_LINES);
+    }
+
+    if (reader.isIndexed() || millis() - lastCountDraw >= FILE_SCAN_REDRAW_MS) {
+        lastCountDraw = millis();
+        updateStatus();
+        markForRedraw();  // The last page may have been short before
+    }
+    if (!reader.isIndexed()) {
+        FrameScheduler::requestFrame();
+    }
+}
+
+void FileViewerScreen::drawLines() {
+    if (!lcd) return;
+
+    auto& gfx = RenderTarget::begin(RenderTarget::BODY);
+    gfx.fillScreen(0x0000);
+
+    if (backButton) backButton->draw(gfx);
+    if (topButton) topButton->draw(gfx);
+    if (endButton) endButton->draw(gfx);
+
+    gfx.drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+
+    int textSize = UIScale::getGeneralTextSize();
+    int x = UIScale::scale(4);
+    int maxWidth = lcd->width() - x * 2;
+    int y = HEADER_HEIGHT + UIScale::scale(5);
+    gfx.setTextSize(textSize);
+    gfx.setTextColor(0xFFFF);
+
+    if (!reader.isOpen()) {
+        gfx.setTextColor(0x8410);  // Gray
+        gfx.setCursor(UIScale::scale(10), y + UIScale::scale(15));
+        gfx.print(path.isEmpty() ? "No file selected" : "Cannot open file");
+        RenderTarget::present(RenderTarget::BODY);
+        return;
+    }
+
+    {
+        // Each line is drawn before the next read, which may replace its page
+        Hardware::SharedSPIBus::Hold bus;
+        for (int i = 0; i < visibleLines; i++) {
+            const char* line = reader.getLine(topLine + i);
+            if (!line) {
+                break;
+            }
+            size_t length = UIScale::fitTextLength(line, strlen(line), textSize, maxWidth);
+            gfx.setCursor(x, y + i * lineHeight);
+            gfx.write(reinterpret_cast<const uint8_t*>(line), length);
+        }
+    }
+
+    RenderTarget::present(RenderTarget::BODY);
+}
+
+void FileViewerScreen::scrollTo(size_t line) {
+    // Once the count is known nothing scrolls past the last page
+    if (reader.isIndexed()) {
+        size_t lines = reader.getLineCount();
+        size_t last = lines > (size_t)visibleLines ? lines - visibleLines : 0;
+        line = min(line, last);
+    } else if (line > topLine) {
+        Hardware::SharedSPIBus::Hold bus;
+        if (!reader.getLine(line)) {
+            return;  // Ran into the end while still counting
+        }
+    }
+
+    topLine = line;
+    updateStatus();
+    markForRedraw();
+}
+
+void FileViewerScreen::handleScrolling(int x, int y, bool wasTapped) {
+    if (!wasTapped || !reader.isOpen()) return;
+
+    int infoAreaY = HEADER_HEIGHT;
+    int infoAreaHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
+    size_t page = max(1, visibleLines - 1);  // One line of context stays in view
+
+    if (y >= infoAreaY && y < lcd->height() - FOOTER_HEIGHT) {
+        if (y < infoAreaY + infoAreaHeight / 2) {
+            scrollTo(topLine > page ? topLine - page : 0);
+        } else {
+            scrollTo(topLine + page);
+        }
+    }
+}
+
+void FileViewerScreen::updateStatus() {
+    if (!reader.isOpen()) return;
+
+    String status = String("Line ") + (topLine + 1) + " of " + reader.getLineCount();
+    if (!reader.isIndexed()) {
+        status += "+";
+    }
+    ScreenManager::setStatusText(status);
+}
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../Screen.hpp"
+#include "../Widgets/Button.hpp"
+#include "../../Core/LogFileReader.hpp"
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+#define FILE_VIEWER_INDEX_LINES 256  // Lines counted per frame while the total is still unknown
+
+/**
+ * Read-only view of one session file of either format, paged through
+ * LogFileReader so a file of any size opens at once and scrolls anywhere
+ * with bounded RAM. The line count comes from the sidecar index when there
+ * is one and is otherwise counted a slice per frame. Taps on the upper or
+ * lower half of the text page up or down.
+ */
+class FileViewerScreen : public Screen {
+   public:
+    FileViewerScreen();
+    virtual ~FileViewerScreen();
+
+    void activate() override;
+    void deactivate() override;
+    void update() override;
+    void handleTouch(int x, int y, bool touched) override;
+    void cleanup() override;
+
+    // The file shown the next time the screen opens, from line on
+    static void showFile(const String& path, size_t line = 0);
+
+   private:
+    // UI Elements
+    Widgets::Button* backButton;
+    Widgets::Button* topButton;
+    Widgets::Button* endButton;
+
+    Core::LogFileReader reader;
+    String path;
+    size_t topLine;
+    int visibleLines;
+    int lineHeight;
+    bool lastTouchState;
+    unsigned long lastCountDraw;
+
+    static String pendingPath;
+    static size_t pendingLine;
+
+    // Constants
+    static const int LINE_HEIGHT = 12;
+
+    void createControlButtons();
+    void openFile();
+    void countStep();
+    void drawLines();
+    void scrollTo(size_t line);
+    void handleScrolling(int x, int y, bool wasTapped);
+    void updateStatus();
+};
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
@@ -0,0 +1,278 @@
+#include "LogFilterScreen.hpp"
+#include "../UIScale.hpp"
+#include "../ScreenManager.hpp"
+#include "../RenderTarget.hpp"
+#include "../TouchManager.hpp"
+#include "../../Core/DeviceRegistry.hpp"
+#include "../../Core/LiveFilter.hpp"
+#include "../../Core/TagRegistry.hpp"
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+using Core::LiveFilter;
+using Core::TagRegistry;
+
+LogFilterScreen::LogFilterScreen() : Screen("LogFilter"),
+                                     backButton(nullptr),
+                                     scrollOffset(0),
+                                     maxVisibleRows(0),
+                                     lastTouchState(false),
+                                     rowsChanged(false),
+                                     shownTags(0),
+                                     shownDevices(0) {
+}
+
+LogFilterScreen::~LogFilterScreen() {
+    cleanup();
+}
+
+void LogFilterScreen::activate() {
+    Screen::activate();
+
+    if (!backButton) {
+        int buttonHeight = UIScale::scale(35);
+        int buttonY = UIScale::scale(15);
+
+        backButton = new Widgets::Button(*lcd, 0, buttonY,
+                                         lcd->width(), buttonHeight, "BACK");
+        backButton->setCallback([this]() {
+            goBack();
+        });
+    }
+
+    createRows();
+    layoutRows();
+    ScreenManager::setStatusText(LiveFilter::isActive() ? "Live view filtered" : "Live view shows everything");
+}
+
+void LogFilterScreen::deactivate() {
+    Screen::deactivate();
+}
+
+void LogFilterScreen::update() {
+    if (!active) return;
+
+    // Tags and devices keep turning up while logs arrive
+    if (TagRegistry::size() != shownTags || Core::DeviceRegistry::size() != shownDevices) {
+        rowsChanged = true;
+    }
+    if (rowsChanged) {
+        rowsChanged = false;
+        createRows();
+        layoutRows();
+        needsRedraw = true;
+    }
+
+    if (needsRedraw) {
+        drawRows();
+        needsRedraw = false;
+    }
+
+    if (backButton) backButton->update();
+    for (auto button : rowButtons) {
+        if (button) button->update();
+    }
+}
+
+void LogFilterScreen::handleTouch(int x, int y, bool touched) {
+    if (!active) return;
+
+    bool wasTapped = TouchManager::wasTapped();
+    if (wasTapped) {
+        handleScrolling(x, y, wasTapped);
+    }
+
+    if (touched || lastTouchState) {
+        if (backButton) backButton->handleTouch(x, y, touched);
+        for (auto button : rowButtons) {
+            if (button) button->handleTouch(x, y, touched);
+        }
+        lastTouchState = touched;
+    }
+}
+
+void LogFilterScreen::cleanup() {
+    delete backButton;
+    backButton = nullptr;
+
+    for (auto button : rowButtons) {
+        delete button;
+    }
+    rowButtons.clear();
+    rows.clear();
+}
+
+void LogFilterScreen::createRows() {
+    rows.clear();
+
+    rows.emplace_back(String("Min level: ") + getLevelName(LiveFilter::getMinLevel()), [this](bool increase) {
+        uint8_t level = LiveFilter::getMinLevel();
+        if (increase && level < 4) {
+            LiveFilter::setMinLevel(level + 1);
+        } else if (!increase && level > 0) {
+            LiveFilter::setMinLevel(level - 1);
+        }
+        changed();
+    });
+
+    String text = LiveFilter::getText();
+    if (text.length() > 0) {
+        rows.emplace_back("Text \"" + text + "\": clear", [this]() {
+            LiveFilter::setText("");
+            changed();
+        });
+    }
+
+    shownDevices = Core::DeviceRegistry::size();
+    for (uint8_t id = 1; id < shownDevices; id++) {
+        bool visible = LiveFilter::isDeviceVisible(id);
+        rows.emplace_back(String(Core::DeviceRegistry::getName(id)) + (visible ? ": shown" : ": hidden"), [this, id, visible]() {
+            LiveFilter::setDeviceVisible(id, !visible);
+            changed();
+        });
+    }
+
+    // Tap cycles any -> only -> hide
+    shownTags = TagRegistry::size();
+    for (uint8_t id = 1; id < shownTags; id++) {
+        Core::LiveTagRule rule = LiveFilter::getTagRule(id);
+        const char* state = rule == Core::LIVE_TAG_ALLOW ? ": only" : rule == Core::LIVE_TAG_DENY ? ": hide" : ": any";
+        rows.emplace_back(String("Tag ") + TagRegistry::getName(id) + state, [this, id, rule]() {
+            Core::LiveTagRule next = rule == Core::LIVE_TAG_ANY ? Core::LIVE_TAG_ALLOW : rule == Core::LIVE_TAG_ALLOW ? Core::LIVE_TAG_DENY : Core::LIVE_TAG_ANY;
+            LiveFilter::setTagRule(id, next);
+            changed();
+        });
+    }
+
+    rows.emplace_back("Reset filters", [this]() {
+        LiveFilter::reset();
+        changed();
+    });
+
+    // Levels that cut records at the sender, not just in this view
+    rows.emplace_back("Sender levels >", [this]() {
+        navigateTo("SenderLevels");
+    });
+}
+
+void LogFilterScreen::layoutRows() {
+    for (auto button : rowButtons) {
+        delete button;
+    }
+    rowButtons.clear();
+
+    int startY = HEADER_HEIGHT + UIScale::scale(10);
+    int buttonHeight = UIScale::scale(ROW_BUTTON_HEIGHT);
+    int buttonSpacing = UIScale::scale(ROW_SPACING);
+    int totalWidth = lcd->width() - UIScale::scale(20);
+
+    maxVisibleRows = (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(20)) / buttonSpacing;
+    scrollOffset = std::min(scrollOffset, std::max(0, (int)rows.size() - maxVisibleRows));
+
+    for (size_t i = 0; i < rows.size(); i++) {
+        int visibleIndex = i - scrollOffset;
+        if (visibleIndex < 0 || visibleIndex >= maxVisibleRows) {
+            continue;
+        }
+        int buttonY = startY + (visibleIndex * buttonSpacing);
+        size_t rowIndex = i;
+
+        if (rows[i].adjust) {
+            int labelWidth = totalWidth * 0.5f;
+            int buttonWidth = totalWidth * 0.2f;
+            int buttonGap = UIScale::scale(5);
+
+            auto labelButton = new Widgets::Button(*lcd, UIScale::scale(10), buttonY,
+                                                   labelWidth, buttonHeight, rows[i].label);
+            labelButton->setColors(0x0000, 0x0000, 0x8410, 0xFFFF);  // Read-only appearance
+            rowButtons.push_back(labelButton);
+
+            auto minusButton = new Widgets::Button(*lcd, UIScale::scale(10) + labelWidth + buttonGap, buttonY,
+                                                   buttonWidth, buttonHeight, "-");
+            minusButton->setCallback([this, rowIndex]() {
+                if (rowIndex < rows.size() && rows[rowIndex].adjust) rows[rowIndex].adjust(false);
+            });
+            minusButton->setColors(0x8000, 0xA000, 0x8410, 0xFFFF);
+            rowButtons.push_back(minusButton);
+
+            auto plusButton = new Widgets::Button(*lcd, UIScale::scale(10) + labelWidth + buttonGap + buttonWidth + buttonGap, buttonY,
+                                                  buttonWidth, buttonHeight, "+");
+            plusButton->setCallback([this, rowIndex]() {
+                if (rowIndex < rows.size() && rows[rowIndex].adjust) rows[rowIndex].adjust(true);
+            });
+            plusButton->setColors(0x03E0, 0x07E0, 0x8410, 0xFFFF);
+            rowButtons.push_back(plusButton);
+        } else {
+            auto rowButton = new Widgets::Button(*lcd, UIScale::scale(10), buttonY,
+                                                 totalWidth, buttonHeight, rows[i].label);
+            rowButton->setCallback([this, rowIndex]() {
+                if (rowIndex < rows.size() && rows[rowIndex].callback) rows[rowIndex].callback();
+            });
+            rowButton->setColors(0x001F, 0x051F, 0x8410, 0xFFFF);
+            rowButtons.push_back(rowButton);
+        }
+    }
+}
+
+void LogFilterScreen::drawRows() {
+    if (!lcd) return;
+
+    auto& gfx = RenderTarget::begin(RenderTarget::BODY);
+    gfx.fillScreen(0x0000);
+    if (backButton) backButton->draw(gfx);
+    gfx.drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+
+    for (auto button : rowButtons) {
+        if (button) button->draw(gfx);
+    }
+
+    // Scroll indicators
+    if ((int)rows.size() > maxVisibleRows) {
+        int indicatorX = lcd->width() - UIScale::scale(10);
+        gfx.setTextColor(0xFFFF);
+        gfx.setTextSize(UIScale::getGeneralTextSize());
+        if (scrollOffset > 0) {
+            gfx.setCursor(indicatorX, HEADER_HEIGHT + UIScale::scale(5));
+            gfx.print("^");
+        }
+        if (scrollOffset < (int)rows.size() - maxVisibleRows) {
+            gfx.setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
+            gfx.print("v");
+        }
+    }
+
+    RenderTarget::present(RenderTarget::BODY);
+}
+
+void LogFilterScreen::handleScrolling(int x, int y, bool wasTapped) {
+    if (!wasTapped || (int)rows.size() <= maxVisibleRows) return;
+
+    // Taps on the right edge scroll, the rest go to the rows
+    if (x < lcd->width() - UIScale::scale(20) || y < HEADER_HEIGHT || y >= lcd->height() - FOOTER_HEIGHT) return;
+
+    int middle = HEADER_HEIGHT + (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT) / 2;
+    int maxScroll = (int)rows.size() - maxVisibleRows;
+    if (y < middle && scrollOffset > 0) {
+        scrollOffset--;
+        rowsChanged = true;
+    } else if (y >= middle && scrollOffset < maxScroll) {
+        scrollOffset++;
+        rowsChanged = true;
+    }
+}
+
+void LogFilterScreen::changed() {
+    rowsChanged = true;
+    ScreenManager::setStatusText(LiveFilter::isActive() ? "Live view filtered" : "Live view shows everything");
+}
+
+const char* LogFilterScreen::getLevelName(uint8_t level) {
+    static const char* names[] = {"VERBOSE", "DEBUG", "INFO", "WARN", "ERROR"};
+    return level < 5 ? names[level] : "?";
+}
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
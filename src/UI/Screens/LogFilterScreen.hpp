@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../Screen.hpp"
+#include "../Widgets/Button.hpp"
+#include <vector>
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+/**
+ * Filter screen for the realtime log view: level threshold, which devices
+ * are shown and show-only/hide rules for the tags seen so far. Changes apply
+ * to records arriving from then on; storage is never filtered.
+ */
+class LogFilterScreen : public Screen {
+   public:
+    LogFilterScreen();
+    virtual ~LogFilterScreen();
+
+    void activate() override;
+    void deactivate() override;
+    void update() override;
+    void handleTouch(int x, int y, bool touched) override;
+    void cleanup() override;
+
+   private:
+    struct FilterRow {
+        String label;
+        std::function<void()> callback;     // Tap
+        std::function<void(bool)> adjust;   // -/+ pair instead, true for +
+
+        FilterRow(const String& l, std::function<void()> cb) : label(l), callback(cb) {}
+        FilterRow(const String& l, std::function<void(bool)> adj) : label(l), adjust(adj) {}
+    };
+
+    // UI Elements
+    Widgets::Button* backButton;
+    std::vector<Widgets::Button*> rowButtons;
+    std::vector<FilterRow> rows;
+
+    int scrollOffset;
+    int maxVisibleRows;
+    bool lastTouchState;
+    bool rowsChanged;  // Rebuilt in update(), never from a button's own callback
+    uint8_t shownTags;
+    uint8_t shownDevices;
+
+    // Constants
+    static const int ROW_BUTTON_HEIGHT = 35;
+    static const int ROW_SPACING = 45;
+
+    void createRows();
+    void layoutRows();
+    void drawRows();
+    void handleScrolling(int x, int y, bool wasTapped);
+    void changed();
+
+    static const char* getLevelName(uint8_t level);
+};
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
@@ -2,6 +2,11 @@
 #include "../UIScale.hpp"
 #include "../TouchManager.hpp"
 #include "../ScreenManager.hpp"
+#include "../ToastManager.hpp"
+#include "../RenderTarget.hpp"
+#include "../../Core/ClockSync.hpp"
+#include "../../Core/LiveFilter.hpp"
+#include "../../Core/Metrics.hpp"
 
 namespace BTLogger {
 namespace UI {
@@ -11,16 +16,40 @@ LogViewerScreen::LogViewerScreen() : Screen("LogViewer"),
                                      backButton(nullptr),
                                      clearButton(nullptr),
                                      pauseButton(nullptr),
+                                     filterButton(nullptr),
                                      scrollOffset(0),
                                      maxVisibleLines(0),
                                      paused(false),
-                                     lastTouchState(false) {
+                                     lastTouchState(false),
+                                     headerNeedsRedraw(true),
+                                     logsNeedRedraw(true),
+                                     newEntriesPending(false),
+                                     pendingReceivedUs(0),
+                                     renderedTotal(0),
+                                     renderedLines(0),
+                                     lineHeight(LINE_HEIGHT),
+                                     scrollAreaTop(HEADER_HEIGHT),
+                                     scrollAreaHeight(0),
+                                     hardwareScrollLines(0),
+                                     toastWasVisible(false),
+                                     gfx(nullptr) {
+    for (int i = 0; i < LAYOUT_CACHE_SIZE; i++) {
+        layoutCache[i].valid = false;
+    }
 }
 
 LogViewerScreen::~LogViewerScreen() {
     cleanup();
 }
 
+void LogViewerScreen::initialize(lgfx::LGFX_Device& display) {
+    Screen::initialize(display);
+    gfx = lcd;
+
+    // Allocate scrollback up front (PSRAM when available)
+    logStore.initialize();
+}
+
 void LogViewerScreen::activate() {
     Screen::activate();
 
@@ -31,12 +60,12 @@ void LogViewerScreen::activate() {
 
         // Calculate button widths to divide the full screen width
         int totalWidth = lcd->width();
-        int buttonCount = 3;  // BACK, CLEAR, PAUSE
+        int buttonCount = 4;  // BACK, CLEAR, FILTER, PAUSE
         int buttonWidth = totalWidth / buttonCount;
 
         int currentX = 0;
 
-        // Create back button - takes 1/3 of width
+        // Create back button - takes 1/4 of width
         backButton = new Widgets::Button(*lcd, currentX, buttonY,
                                          buttonWidth, buttonHeight, "BACK");
         backButton->setCallback([this]() {
@@ -45,7 +74,7 @@ void LogViewerScreen::activate() {
         });
         currentX += buttonWidth;
 
-        // Create clear button - takes 1/3 of width
+        // Create clear button - takes 1/4 of width
         clearButton = new Widgets::Button(*lcd, currentX, buttonY,
                                           buttonWidth, buttonHeight, "CLEAR");
         clearButton->setCallback([this]() {
@@ -53,6 +82,14 @@ void LogViewerScreen::activate() {
         });
         currentX += buttonWidth;
 
+        // Create filter button - takes 1/4 of width
+        filterButton = new Widgets::Button(*lcd, currentX, buttonY,
+                                           buttonWidth, buttonHeight, "FILTER");
+        filterButton->setCallback([this]() {
+            navigateTo("LogFilter");
+        });
+        currentX += buttonWidth;
+
         // Create pause button - takes remaining width (handles any rounding)
         int remainingWidth = totalWidth - currentX;
         pauseButton = new Widgets::Button(*lcd, currentX, buttonY,
@@ -60,24 +97,31 @@ void LogViewerScreen::activate() {
         pauseButton->setCallback([this]() {
             paused = !paused;
             pauseButton->setText(paused ? "RESUME" : "PAUSE");
+            headerNeedsRedraw = true;
+            logsNeedRedraw = true;  // Catch up with anything that arrived while paused
             ScreenManager::setStatusText(paused ? "Logging paused" : "Logging resumed");
         });
 
-        Serial.printf("LogViewer buttons: BACK(%d-%d), CLEAR(%d-%d), PAUSE(%d-%d), screen width: %d\n",
+        Serial.printf("LogViewer buttons: BACK(%d-%d), CLEAR(%d-%d), FILTER(%d-%d), PAUSE(%d-%d), screen width: %d\n",
                       backButton->getX(), backButton->getX() + backButton->getWidth(),
                       clearButton->getX(), clearButton->getX() + clearButton->getWidth(),
+                      filterButton->getX(), filterButton->getX() + filterButton->getWidth(),
                       pauseButton->getX(), pauseButton->getX() + pauseButton->getWidth(),
                       lcd->width());
     }
 
     // Calculate visible lines
-    int contentHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
-    maxVisibleLines = contentHeight / UIScale::scale(LINE_HEIGHT);
+    layoutLogArea();
+
+    // Filtered views say so on the button
+    filterButton->setText(Core::LiveFilter::isActive() ? "FILTER*" : "FILTER");
 
-    ScreenManager::setStatusText("Log Viewer - Real-time logs");
+    ScreenManager::setStatusText(Core::LiveFilter::isActive() ? "Log Viewer - Filtered" : "Log Viewer - Real-time logs");
 }
 
 void LogViewerScreen::deactivate() {
+    // Other screens draw without knowing about the scroll offset
+    setHardwareScroll(0);
     Screen::deactivate();
 }
 
@@ -85,14 +129,42 @@ void LogViewerScreen::update() {
     if (!active) return;
 
     if (needsRedraw) {
+        headerNeedsRedraw = true;
+        logsNeedRedraw = true;
+        needsRedraw = false;
+    }
+
+    // Toasts are drawn on top of the log area: use full repaints while one is up
+    // and clean up once it disappears
+    bool toastVisible = ToastManager::isVisible();
+    if (toastVisible != toastWasVisible) {
+        logsNeedRedraw = true;
+        toastWasVisible = toastVisible;
+    }
+
+    if (headerNeedsRedraw) {
         drawHeader();
+        headerNeedsRedraw = false;
+    }
+
+    // Everything that arrived since the last frame is rendered in one go
+    uint32_t receivedUs = newEntriesPending ? pendingReceivedUs : 0;
+    if (logsNeedRedraw) {
+        newEntriesPending = false;
         drawLogs();
-        needsRedraw = false;
+        logsNeedRedraw = false;
+    } else if (newEntriesPending) {
+        newEntriesPending = false;
+        appendNewLines();
+    }
+    if (receivedUs != 0) {
+        Core::Metrics::record(Core::METRIC_HIST_RX_TO_PIXEL, (uint32_t)Core::ClockSync::now() - receivedUs);
     }
 
     // Update buttons
     if (backButton) backButton->update();
     if (clearButton) clearButton->update();
+    if (filterButton) filterButton->update();
     if (pauseButton) pauseButton->update();
 }
 
@@ -110,6 +182,7 @@ void LogViewerScreen::handleTouch(int x, int y, bool touched) {
         // Handle button touches
         if (backButton) backButton->handleTouch(x, y, touched);
         if (clearButton) clearButton->handleTouch(x, y, touched);
+        if (filterButton) filterButton->handleTouch(x, y, touched);
         if (pauseButton) pauseButton->handleTouch(x, y, touched);
 
         lastTouchState = touched;
@@ -120,164 +193,347 @@ void LogViewerScreen::cleanup() {
     delete backButton;
     delete clearButton;
     delete pauseButton;
+    delete filterButton;
 
     backButton = nullptr;
     clearButton = nullptr;
     pauseButton = nullptr;
+    filterButton = nullptr;
 
-    logEntries.clear();
+    logStore.clear();
 }
 
-void LogViewerScreen::addLogEntry(const String& deviceName, const String& tag, const String& message, int level) {
-    // Add new log entry
-    logEntries.emplace_back(deviceName, tag, message, level);
+void LogViewerScreen::addLogEntry(Core::DeviceId deviceId, const char* tag, const char* message, int level) {
+    addLogEntry(Core::ClockSync::now() / 1000, deviceId, Core::TagRegistry::intern(tag), message,
+                strnlen(message, LOG_STORE_MAX_MESSAGE), level, 0);
+}
 
-    // Limit log entries to prevent memory issues
-    if (logEntries.size() > MAX_LOG_ENTRIES) {
-        logEntries.erase(logEntries.begin());
-        // Adjust scroll offset if needed
-        if (scrollOffset > 0) {
-            scrollOffset--;
-        }
-    }
+void LogViewerScreen::addLogEntry(uint32_t timestamp, Core::DeviceId deviceId, Core::TagId tagId, const char* message,
+                                  size_t messageLength, int level, uint8_t flags, uint32_t receivedUs) {
+    // Add new log entry (O(1), evicts the oldest entries once full; tokenized ones are formatted when drawn)
+    size_t evicted = logStore.add(timestamp, level, deviceId, tagId, message, messageLength, flags);
+
+    // Keep the view on the same entries when older ones are evicted
+    scrollOffset = std::max(0, scrollOffset - (int)evicted);
 
     // Auto-scroll to bottom if not paused and not manually scrolled
-    if (!paused && scrollOffset >= (int)logEntries.size() - maxVisibleLines) {
-        scrollOffset = std::max(0, (int)logEntries.size() - maxVisibleLines);
+    int total = logStore.size();
+    if (!paused && scrollOffset >= total - 1 - maxVisibleLines) {
+        scrollOffset = std::max(0, total - maxVisibleLines);
     }
 
-    markForRedraw();
+    // Rendered on the next UI frame, coalesced with any other arrivals
+    Core::Metrics::count(Core::METRIC_UI_RECORDS);
+    if (!newEntriesPending) {
+        pendingReceivedUs = active ? receivedUs : 0;
+        newEntriesPending = true;
+        if (active) FrameScheduler::requestFrame();
+    }
 }
 
 void LogViewerScreen::clearLogs() {
-    logEntries.clear();
+    logStore.clear();
     scrollOffset = 0;
-    markForRedraw();
+    logsNeedRedraw = true;
+}
+
+void LogViewerScreen::layoutLogArea() {
+    if (!lcd) return;
+
+    // The scroll area holds a whole number of lines; the remainder goes to the info strip
+    lineHeight = UIScale::scale(LINE_HEIGHT);
+    int available = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(INFO_STRIP_HEIGHT);
+    maxVisibleLines = std::max(1, available / lineHeight);
+    scrollAreaTop = HEADER_HEIGHT;
+    scrollAreaHeight = maxVisibleLines * lineHeight;
 }
 
 void LogViewerScreen::drawHeader() {
     if (!lcd) return;
 
+    auto& gfx = RenderTarget::begin(RenderTarget::HEADER);
+
     // Clear header area
-    lcd->fillRect(0, 0, lcd->width(), HEADER_HEIGHT, 0x0000);
+    gfx.fillRect(0, 0, lcd->width(), HEADER_HEIGHT, 0x0000);
 
     // Draw buttons - no title anymore
-    if (backButton) backButton->draw();
-    if (clearButton) clearButton->draw();
-    if (pauseButton) pauseButton->draw();
+    if (backButton) backButton->draw(gfx);
+    if (clearButton) clearButton->draw(gfx);
+    if (filterButton) filterButton->draw(gfx);
+    if (pauseButton) pauseButton->draw(gfx);
 
     // Draw separator line
-    lcd->drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+    gfx.drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+
+    RenderTarget::present(RenderTarget::HEADER);
 }
 
 void LogViewerScreen::drawLogs() {
     if (!lcd) return;
 
+    layoutLogArea();
+
+    // A full repaint always starts from an unscrolled panel
+    setHardwareScroll(0);
+
+    // Compose the page off-screen and send it in one transfer
+    gfx = &RenderTarget::begin(RenderTarget::CONTENT);
+
     int logAreaY = HEADER_HEIGHT;
     int logAreaHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
 
     // Clear log area
-    lcd->fillRect(0, logAreaY, lcd->width(), logAreaHeight, 0x0000);
-
-    if (logEntries.empty()) {
-        lcd->setTextColor(0x8410);  // Gray
-        lcd->setTextSize(UIScale::getGeneralTextSize());
-        lcd->setCursor(UIScale::scale(10), logAreaY + UIScale::scale(20));
-        lcd->print("No log entries");
-        lcd->setCursor(UIScale::scale(10), logAreaY + UIScale::scale(40));
-        lcd->print("Waiting for devices...");
+    gfx->fillRect(0, logAreaY, lcd->width(), logAreaHeight, 0x0000);
+
+    renderedTotal = logStore.getTotalAdded();
+    renderedLines = 0;
+
+    int total = logStore.size();
+    if (total == 0) {
+        gfx->setTextColor(0x8410);  // Gray
+        gfx->setTextSize(UIScale::getGeneralTextSize());
+        gfx->setCursor(UIScale::scale(10), logAreaY + UIScale::scale(20));
+        gfx->print("No log entries");
+        gfx->setCursor(UIScale::scale(10), logAreaY + UIScale::scale(40));
+        gfx->print("Waiting for devices...");
+        RenderTarget::present(RenderTarget::CONTENT);
+        gfx = lcd;
         return;
     }
 
-    // Calculate visible entries
-    maxVisibleLines = logAreaHeight / UIScale::scale(LINE_HEIGHT);
-
     int startIndex = scrollOffset;
-    int endIndex = std::min((int)logEntries.size(), startIndex + maxVisibleLines);
+    int endIndex = std::min(total, startIndex + maxVisibleLines);
 
     // Draw log entries
+    Core::LogRecordView entry;
     for (int i = startIndex; i < endIndex; i++) {
-        const LogEntry& entry = logEntries[i];
-        int yPos = logAreaY + ((i - startIndex) * UIScale::scale(LINE_HEIGHT));
-
-        // Format: [LEVEL] Device: Tag: Message
-        String levelStr = getLevelString(entry.level);
-        uint16_t levelColor = getLevelColor(entry.level);
-
-        int generalTextSize = UIScale::getGeneralTextSize();
-        lcd->setTextSize(generalTextSize);
-        int xPos = UIScale::scale(2);
-
-        // Draw level indicator
-        lcd->setTextColor(levelColor);
-        lcd->setCursor(xPos, yPos);
-        lcd->print("[" + levelStr + "]");
-        xPos += UIScale::calculateTextWidth("[WARN]", generalTextSize) + UIScale::scale(5);
-
-        // Draw device name (abbreviated if too long)
-        lcd->setTextColor(0x07FF);  // Cyan for device name
-        lcd->setCursor(xPos, yPos);
-        String deviceName = entry.deviceName;
-        int maxDeviceWidth = UIScale::scale(60);
-        while (UIScale::calculateTextWidth(deviceName + ":", generalTextSize) > maxDeviceWidth && deviceName.length() > 1) {
-            deviceName = deviceName.substring(0, deviceName.length() - 1);
-        }
-        if (deviceName != entry.deviceName) deviceName += "~";
-        lcd->print(deviceName + ":");
-        xPos += UIScale::calculateTextWidth(deviceName + ":", generalTextSize) + UIScale::scale(5);
-
-        // Draw tag (abbreviated if needed)
-        lcd->setTextColor(0xFFE0);  // Yellow for tag
-        lcd->setCursor(xPos, yPos);
-        String tag = entry.tag;
-        int maxTagWidth = UIScale::scale(45);
-        while (UIScale::calculateTextWidth(tag + ":", generalTextSize) > maxTagWidth && tag.length() > 1) {
-            tag = tag.substring(0, tag.length() - 1);
-        }
-        if (tag != entry.tag) tag += "~";
-        lcd->print(tag + ":");
-        xPos += UIScale::calculateTextWidth(tag + ":", generalTextSize) + UIScale::scale(5);
-
-        // Draw message (truncated to fit)
-        lcd->setTextColor(0xFFFF);  // White for message
-        lcd->setCursor(xPos, yPos);
-        String message = entry.message;
-        int remainingWidth = lcd->width() - xPos - UIScale::scale(5);
-        while (UIScale::calculateTextWidth(message, generalTextSize) > remainingWidth && message.length() > 1) {
-            message = message.substring(0, message.length() - 1);
+        if (!logStore.getRecord(i, entry)) {
+            break;
         }
-        if (message != entry.message) message += "~";
-        lcd->print(message);
+        drawLogLine(i - startIndex, entry);
+        renderedLines++;
     }
 
-    // Draw scroll indicators
-    if (logEntries.size() > maxVisibleLines) {
-        int indicatorX = lcd->width() - UIScale::scale(8);
-
-        if (scrollOffset > 0) {
-            lcd->setTextColor(0xFFFF);
-            lcd->setTextSize(UIScale::getGeneralTextSize());
-            lcd->setCursor(indicatorX, logAreaY + UIScale::scale(2));
-            lcd->print("^");
-        }
+    drawInfoStrip();
+    RenderTarget::present(RenderTarget::CONTENT);
+    gfx = lcd;
+}
 
-        if (scrollOffset < (int)logEntries.size() - maxVisibleLines) {
-            lcd->setTextColor(0xFFFF);
-            lcd->setTextSize(UIScale::getGeneralTextSize());
-            lcd->setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(10));
-            lcd->print("v");
+void LogViewerScreen::appendNewLines() {
+    if (!lcd) return;
+
+    uint32_t totalAdded = logStore.getTotalAdded();
+    int newCount = totalAdded - renderedTotal;
+    int total = logStore.size();
+    if (newCount <= 0) {
+        return;
+    }
+
+    // Away from the tail the visible lines don't change, only the counter does
+    if (!isAtTail()) {
+        renderedTotal = totalAdded;
+        drawInfoStrip();
+        return;
+    }
+
+    // Too much changed, the empty placeholder is showing, or a toast covers the area
+    bool fitsBelow = renderedLines + newCount <= maxVisibleLines;
+    bool fullPage = renderedLines == maxVisibleLines;
+    if (newCount > total || newCount >= maxVisibleLines || renderedLines == 0 || toastWasVisible || (!fitsBelow && !fullPage)) {
+        drawLogs();
+        return;
+    }
+
+    int firstSlot;
+    if (fitsBelow) {
+        // Screen not full yet: new lines go straight under the existing ones
+        firstSlot = renderedLines;
+        renderedLines += newCount;
+    } else {
+        // Scroll the panel itself, then repaint only the line slots that wrapped to the bottom
+        setHardwareScroll(hardwareScrollLines + newCount);
+        firstSlot = maxVisibleLines - newCount;
+    }
+
+    Core::LogRecordView entry;
+    for (int i = 0; i < newCount; i++) {
+        if (!logStore.getRecord(total - newCount + i, entry)) {
+            break;
         }
+        drawLogLine(firstSlot + i, entry);
+    }
+
+    renderedTotal = totalAdded;
+    drawInfoStrip();
+}
+
+void LogViewerScreen::drawLogLine(int slot, const Core::LogRecordView& entry) {
+    int yPos = slotY(slot);
+
+    // Clear the slot (it may hold a line that just scrolled out)
+    gfx->fillRect(0, yPos, lcd->width(), lineHeight, 0x0000);
+
+    // Format: [LEVEL] Device: Tag: Message
+    const LineLayout& layout = getLineLayout(entry);
+    gfx->setTextSize(UIScale::getGeneralTextSize());
+
+    // Draw level indicator
+    gfx->setTextColor(layout.levelColor);
+    gfx->setCursor(UIScale::scale(2), yPos);
+    gfx->print("[");
+    gfx->print(getLevelString(entry.level));
+    gfx->print("]");
+
+    // Draw device name (abbreviated if too long)
+    gfx->setTextColor(0x07FF);  // Cyan for device name
+    gfx->setCursor(layout.deviceX, yPos);
+    printClipped(entry.deviceName, layout.deviceChars, layout.truncated & LAYOUT_CUT_DEVICE, ":");
+
+    // Draw tag (abbreviated if needed)
+    gfx->setTextColor(0xFFE0);  // Yellow for tag
+    gfx->setCursor(layout.tagX, yPos);
+    printClipped(entry.tag, layout.tagChars, layout.truncated & LAYOUT_CUT_TAG, ":");
+
+    // Draw message (truncated to fit)
+    gfx->setTextColor(0xFFFF);  // White for message
+    gfx->setCursor(layout.messageX, yPos);
+    printClipped(entry.message, layout.messageChars, layout.truncated & LAYOUT_CUT_MESSAGE, "");
+}
+
+const LogViewerScreen::LineLayout& LogViewerScreen::getLineLayout(const Core::LogRecordView& entry) {
+    LineLayout& layout = layoutCache[entry.sequence % LAYOUT_CACHE_SIZE];
+    uint16_t generation = UIScale::getLayoutGeneration();
+    if (layout.valid && layout.sequence == entry.sequence && layout.generation == generation) {
+        return layout;
     }
 
+    // Measure once per entry and scale setting; the cut points are reused on every redraw
+    int textSize = UIScale::getGeneralTextSize();
+    int gap = UIScale::scale(5);
+    int colonWidth = UIScale::glyphWidth(':', textSize);
+    int tildeWidth = UIScale::glyphWidth('~', textSize);
+
+    layout.sequence = entry.sequence;
+    layout.generation = generation;
+    layout.levelColor = getLevelColor(entry.level);
+    layout.truncated = 0;
+
+    int xPos = UIScale::scale(2) + UIScale::calculateTextWidth((size_t)6, textSize) + gap;  // Width of "[WARN]"
+
+    // Device name and tag keep at least one character, like the old shrink loops
+    int fittedWidth;
+    size_t deviceLength = strlen(entry.deviceName);
+    size_t deviceChars = UIScale::fitTextLength(entry.deviceName, deviceLength, textSize, UIScale::scale(60) - colonWidth, &fittedWidth);
+    if (deviceChars == 0 && deviceLength > 0) {
+        deviceChars = 1;
+        fittedWidth = UIScale::glyphWidth(entry.deviceName[0], textSize);
+    }
+    if (deviceChars < deviceLength) layout.truncated |= LAYOUT_CUT_DEVICE;
+    layout.deviceX = xPos;
+    layout.deviceChars = deviceChars;
+    xPos += fittedWidth + ((layout.truncated & LAYOUT_CUT_DEVICE) ? tildeWidth : 0) + colonWidth + gap;
+
+    size_t tagLength = strlen(entry.tag);
+    size_t tagChars = UIScale::fitTextLength(entry.tag, tagLength, textSize, UIScale::scale(45) - colonWidth, &fittedWidth);
+    if (tagChars == 0 && tagLength > 0) {
+        tagChars = 1;
+        fittedWidth = UIScale::glyphWidth(entry.tag[0], textSize);
+    }
+    if (tagChars < tagLength) layout.truncated |= LAYOUT_CUT_TAG;
+    layout.tagX = xPos;
+    layout.tagChars = tagChars;
+    xPos += fittedWidth + ((layout.truncated & LAYOUT_CUT_TAG) ? tildeWidth : 0) + colonWidth + gap;
+
+    size_t messageLength = entry.messageLength;
+    int remainingWidth = lcd->width() - xPos - UIScale::scale(5);
+    size_t messageChars = UIScale::fitTextLength(entry.message, messageLength, textSize, remainingWidth);
+    messageChars = std::min(messageLength, std::max((size_t)1, messageChars));
+    if (messageChars < messageLength) layout.truncated |= LAYOUT_CUT_MESSAGE;
+    layout.messageX = xPos;
+    layout.messageChars = messageChars;
+
+    layout.valid = true;
+    return layout;
+}
+
+void LogViewerScreen::printClipped(const char* text, size_t chars, bool truncated, const char* suffix) {
+    // Prints a prefix of text straight from the record, no temporary String
+    gfx->write((const uint8_t*)text, chars);
+    if (truncated) gfx->print("~");
+    gfx->print(suffix);
+}
+
+void LogViewerScreen::drawInfoStrip() {
+    // Lives below the scroll area, so hardware scrolling never moves it
+    int stripY = scrollAreaTop + scrollAreaHeight;
+    int stripHeight = lcd->height() - FOOTER_HEIGHT - stripY;
+    if (stripHeight <= 0) return;
+
+    gfx->fillRect(0, stripY, lcd->width(), stripHeight, 0x0000);
+    gfx->setTextSize(UIScale::getGeneralTextSize());
+
     // Draw log counter in corner
-    lcd->setTextColor(0x8410);  // Gray
-    lcd->setTextSize(UIScale::getGeneralTextSize());
-    lcd->setCursor(UIScale::scale(2), lcd->height() - FOOTER_HEIGHT - UIScale::scale(12));
-    lcd->print(String(logEntries.size()) + "/" + String(MAX_LOG_ENTRIES));
+    int total = logStore.size();
+    gfx->setTextColor(0x8410);  // Gray
+    gfx->setCursor(UIScale::scale(2), stripY + 1);
+    gfx->print(String(total) + "/" + String(logStore.capacity()));
+
+    // Time of the bottom line, so lines from different devices can be lined up
+    Core::LogRecordView entry;
+    int last = std::min(total, scrollOffset + maxVisibleLines) - 1;
+    if (last >= 0 && logStore.getRecord(last, entry)) {
+        char time[32];
+        Core::ClockSync::formatTime((int64_t)entry.timestamp * 1000, time, sizeof(time));
+        const char* clock = strchr(time, ' ');  // Time of day only, the date doesn't fit
+        gfx->setCursor(gfx->getCursorX() + UIScale::scale(10), stripY + 1);
+        gfx->print(clock ? clock + 1 : time);
+    }
+
+    // Draw scroll indicators
+    if (total > maxVisibleLines) {
+        gfx->setTextColor(0xFFFF);
+        gfx->setCursor(lcd->width() - UIScale::scale(20), stripY + 1);
+        gfx->print(scrollOffset > 0 ? "^" : " ");
+        gfx->setCursor(lcd->width() - UIScale::scale(10), stripY + 1);
+        gfx->print(scrollOffset < total - maxVisibleLines ? "v" : " ");
+    }
+}
+
+void LogViewerScreen::setHardwareScroll(int lines) {
+    if (!lcd || maxVisibleLines <= 0 || scrollAreaHeight <= 0) return;
+
+    hardwareScrollLines = ((lines % maxVisibleLines) + maxVisibleLines) % maxVisibleLines;
+
+    // Fixed top (header), scrolling middle (log lines), fixed bottom (info strip + footer)
+    int topFixed = scrollAreaTop;
+    int bottomFixed = lcd->height() - scrollAreaTop - scrollAreaHeight;
+    int start = scrollAreaTop + hardwareScrollLines * lineHeight;
+
+    lcd->startWrite();
+    lcd->writeCommand(CMD_VSCRDEF);
+    lcd->writeData(topFixed >> 8);
+    lcd->writeData(topFixed & 0xFF);
+    lcd->writeData(scrollAreaHeight >> 8);
+    lcd->writeData(scrollAreaHeight & 0xFF);
+    lcd->writeData(bottomFixed >> 8);
+    lcd->writeData(bottomFixed & 0xFF);
+    lcd->writeCommand(CMD_VSCRSADD);
+    lcd->writeData(start >> 8);
+    lcd->writeData(start & 0xFF);
+    lcd->endWrite();
+}
+
+int LogViewerScreen::slotY(int slot) const {
+    // Panel memory row that is currently shown at visible line 'slot'
+    return scrollAreaTop + ((slot + hardwareScrollLines) % maxVisibleLines) * lineHeight;
+}
+
+bool LogViewerScreen::isAtTail() const {
+    return !paused && scrollOffset >= std::max(0, (int)logStore.size() - maxVisibleLines);
 }
 
 void LogViewerScreen::handleScrolling(int x, int y, bool wasTapped) {
-    if (!wasTapped || logEntries.size() <= maxVisibleLines) return;
+    if (!wasTapped || (int)logStore.size() <= maxVisibleLines) return;
 
     // Check for scroll in log area
     if (y >= HEADER_HEIGHT && y < lcd->height() - FOOTER_HEIGHT) {
@@ -295,15 +551,15 @@ void LogViewerScreen::handleScrolling(int x, int y, bool wasTapped) {
 void LogViewerScreen::scrollUp() {
     if (scrollOffset > 0) {
         scrollOffset--;
-        markForRedraw();
+        logsNeedRedraw = true;
     }
 }
 
 void LogViewerScreen::scrollDown() {
-    int maxScroll = std::max(0, (int)logEntries.size() - maxVisibleLines);
+    int maxScroll = std::max(0, (int)logStore.size() - maxVisibleLines);
     if (scrollOffset < maxScroll) {
         scrollOffset++;
-        markForRedraw();
+        logsNeedRedraw = true;
     }
 }
 
@@ -324,7 +580,7 @@ uint16_t LogViewerScreen::getLevelColor(int level) {
     }
 }
 
-String LogViewerScreen::getLevelString(int level) {
+const char* LogViewerScreen::getLevelString(int level) {
     switch (level) {
         case 0:
             return "V";
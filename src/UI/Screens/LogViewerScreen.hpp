@@ -3,7 +3,7 @@
 #include "../Screen.hpp"
 #include "../Widgets/Button.hpp"
 #include "../../Core/BluetoothManager.hpp"
-#include <vector>
+#include "../../Core/LogStore.hpp"
 
 namespace BTLogger {
 namespace UI {
@@ -18,51 +18,94 @@ class LogViewerScreen : public Screen {
     virtual ~LogViewerScreen();
 
     // Screen interface
+    void initialize(lgfx::LGFX_Device& display) override;
     void activate() override;
     void deactivate() override;
     void update() override;
     void handleTouch(int x, int y, bool touched) override;
     void cleanup() override;
 
-    // Log integration
-    void addLogEntry(const String& deviceName, const String& tag, const String& message, int level);
+    // Log integration (safe to call from the communications task)
+    void addLogEntry(Core::DeviceId deviceId, const char* tag, const char* message, int level);
+    // timestamp is in ms of the ClockSync time base, as the sender's record was mapped to;
+    // receivedUs is the packet's, for the receive-to-screen latency metric (0 if unknown)
+    void addLogEntry(uint32_t timestamp, Core::DeviceId deviceId, Core::TagId tagId, const char* message,
+                     size_t messageLength, int level, uint8_t flags, uint32_t receivedUs = 0);
     void clearLogs();
 
    private:
-    struct LogEntry {
-        String deviceName;
-        String tag;
-        String message;
-        int level;
-        unsigned long timestamp;
-
-        LogEntry(const String& dev, const String& t, const String& msg, int lvl)
-            : deviceName(dev), tag(t), message(msg), level(lvl), timestamp(millis()) {}
-    };
-
     // UI Elements
     Widgets::Button* backButton;
     Widgets::Button* clearButton;
     Widgets::Button* pauseButton;
+    Widgets::Button* filterButton;
 
     // Log data
-    std::vector<LogEntry> logEntries;
+    Core::LogStore logStore;
     int scrollOffset;
     int maxVisibleLines;
     bool paused;
     bool lastTouchState;
 
+    // Incremental rendering state
+    bool headerNeedsRedraw;
+    bool logsNeedRedraw;
+    volatile bool newEntriesPending;  // Set by addLogEntry() from the communications task
+    volatile uint32_t pendingReceivedUs;  // receivedUs of the oldest entry not drawn yet, 0 if unknown
+    uint32_t renderedTotal;           // logStore.getTotalAdded() at the last render
+    int renderedLines;                // Line slots currently showing an entry
+    int lineHeight;
+    int scrollAreaTop;
+    int scrollAreaHeight;             // Always a whole number of lines
+    int hardwareScrollLines;          // ILI9341 vertical scroll offset, in lines
+    bool toastWasVisible;
+    lgfx::LovyanGFX* gfx;             // Where lines are drawn: the panel, or the canvas during a full repaint
+
+    // Truncated layout of one entry, valid for a single UIScale layout generation
+    struct LineLayout {
+        uint32_t sequence;
+        uint16_t generation;
+        uint16_t levelColor;
+        int16_t deviceX;
+        int16_t tagX;
+        int16_t messageX;
+        uint16_t messageChars;
+        uint8_t deviceChars;
+        uint8_t tagChars;
+        uint8_t truncated;  // LAYOUT_CUT_* bits
+        bool valid;
+    };
+
+    static const int LAYOUT_CACHE_SIZE = 64;  // Direct-mapped by sequence, covers several screens
+    static const uint8_t LAYOUT_CUT_DEVICE = 0x01;
+    static const uint8_t LAYOUT_CUT_TAG = 0x02;
+    static const uint8_t LAYOUT_CUT_MESSAGE = 0x04;
+    LineLayout layoutCache[LAYOUT_CACHE_SIZE];
+
     // Constants
-    static const int MAX_LOG_ENTRIES = 100;
     static const int LINE_HEIGHT = 12;
+    static const int INFO_STRIP_HEIGHT = 10;  // Entry counter and scroll arrows below the lines
+
+    // ILI9341 vertical scrolling commands
+    static const uint8_t CMD_VSCRDEF = 0x33;
+    static const uint8_t CMD_VSCRSADD = 0x37;
 
+    void layoutLogArea();
     void drawHeader();
     void drawLogs();
+    void appendNewLines();
+    void drawLogLine(int slot, const Core::LogRecordView& entry);
+    const LineLayout& getLineLayout(const Core::LogRecordView& entry);
+    void printClipped(const char* text, size_t chars, bool truncated, const char* suffix);
+    void drawInfoStrip();
+    void setHardwareScroll(int lines);
+    int slotY(int slot) const;
+    bool isAtTail() const;
     void scrollUp();
     void scrollDown();
     void handleScrolling(int x, int y, bool wasTapped);
     uint16_t getLevelColor(int level);
-    String getLevelString(int level);
+    const char* getLevelString(int level);
 };
 
 }  // namespace Screens
@@ -2,6 +2,7 @@
 #include "../UIScale.hpp"
 #include "../TouchManager.hpp"
 #include "../ScreenManager.hpp"
+#include "../RenderTarget.hpp"
 #include <algorithm>
 
 namespace BTLogger {
@@ -12,8 +13,10 @@ MainMenuScreen::MainMenuScreen() : Screen("MainMenu"),
                                    logViewerButton(nullptr),
                                    deviceManagerButton(nullptr),
                                    fileBrowserButton(nullptr),
+                                   searchButton(nullptr),
                                    settingsButton(nullptr),
                                    systemInfoButton(nullptr),
+                                   diagnosticsButton(nullptr),
                                    scrollOffset(0),
                                    maxScrollOffset(0),
                                    lastTouchState(false) {
@@ -47,8 +50,10 @@ void MainMenuScreen::update() {
     if (logViewerButton) logViewerButton->update();
     if (deviceManagerButton) deviceManagerButton->update();
     if (fileBrowserButton) fileBrowserButton->update();
+    if (searchButton) searchButton->update();
     if (settingsButton) settingsButton->update();
     if (systemInfoButton) systemInfoButton->update();
+    if (diagnosticsButton) diagnosticsButton->update();
 }
 
 void MainMenuScreen::handleTouch(int x, int y, bool touched) {
@@ -66,8 +71,10 @@ void MainMenuScreen::handleTouch(int x, int y, bool touched) {
         if (logViewerButton) logViewerButton->handleTouch(x, y, touched);
         if (deviceManagerButton) deviceManagerButton->handleTouch(x, y, touched);
         if (fileBrowserButton) fileBrowserButton->handleTouch(x, y, touched);
+        if (searchButton) searchButton->handleTouch(x, y, touched);
         if (settingsButton) settingsButton->handleTouch(x, y, touched);
         if (systemInfoButton) systemInfoButton->handleTouch(x, y, touched);
+        if (diagnosticsButton) diagnosticsButton->handleTouch(x, y, touched);
 
         lastTouchState = touched;
     }
@@ -77,14 +84,18 @@ void MainMenuScreen::cleanup() {
     delete logViewerButton;
     delete deviceManagerButton;
     delete fileBrowserButton;
+    delete searchButton;
     delete settingsButton;
     delete systemInfoButton;
+    delete diagnosticsButton;
 
     logViewerButton = nullptr;
     deviceManagerButton = nullptr;
     fileBrowserButton = nullptr;
+    searchButton = nullptr;
     settingsButton = nullptr;
     systemInfoButton = nullptr;
+    diagnosticsButton = nullptr;
 }
 
 void MainMenuScreen::createButtons() {
@@ -117,20 +128,34 @@ void MainMenuScreen::createButtons() {
         this->navigateTo("FileBrowser");
     });
 
-    settingsButton = new Widgets::Button(*lcd, buttonX, startY + buttonSpacing * 3, buttonWidth, buttonHeight, "SETTINGS");
+    searchButton = new Widgets::Button(*lcd, buttonX, startY + buttonSpacing * 3, buttonWidth, buttonHeight, "SEARCH LOGS");
+    searchButton->setCallback([this]() {
+        Serial.println("Search Logs button pressed!");
+        ScreenManager::setStatusText("Opening Search...");
+        this->navigateTo("SessionSearch");
+    });
+
+    settingsButton = new Widgets::Button(*lcd, buttonX, startY + buttonSpacing * 4, buttonWidth, buttonHeight, "SETTINGS");
     settingsButton->setCallback([this]() {
         Serial.println("Settings button pressed!");
         ScreenManager::setStatusText("Opening Settings...");
         this->navigateTo("Settings");
     });
 
-    systemInfoButton = new Widgets::Button(*lcd, buttonX, startY + buttonSpacing * 4, buttonWidth, buttonHeight, "SYSTEM INFO");
+    systemInfoButton = new Widgets::Button(*lcd, buttonX, startY + buttonSpacing * 5, buttonWidth, buttonHeight, "SYSTEM INFO");
     systemInfoButton->setCallback([this]() {
         Serial.println("System Info button pressed!");
         ScreenManager::setStatusText("Opening System Info...");
         this->navigateTo("SystemInfo");
     });
 
+    diagnosticsButton = new Widgets::Button(*lcd, buttonX, startY + buttonSpacing * 6, buttonWidth, buttonHeight, "DIAGNOSTICS");
+    diagnosticsButton->setCallback([this]() {
+        Serial.println("Diagnostics button pressed!");
+        ScreenManager::setStatusText("Opening Diagnostics...");
+        this->navigateTo("Diagnostics");
+    });
+
     // Calculate scroll limits
     maxScrollOffset = std::max(0, BUTTON_COUNT - VISIBLE_BUTTONS);
 
@@ -140,30 +165,33 @@ void MainMenuScreen::createButtons() {
 void MainMenuScreen::drawMenu() {
     if (!lcd) return;
 
-    // Clear screen
-    lcd->fillScreen(0x0000);
+    // Compose the whole page off-screen
+    auto& gfx = RenderTarget::begin(RenderTarget::BODY);
+    gfx.fillScreen(0x0000);
 
     // No title anymore - just update button positions and draw visible ones
-    updateButtonPositions();
+    updateButtonPositions(gfx);
 
     // Draw scroll indicators
     if (maxScrollOffset > 0) {
         int indicatorX = lcd->width() - UIScale::scale(15);
 
         if (scrollOffset > 0) {
-            lcd->setTextColor(0xFFFF);
-            lcd->setTextSize(1);
-            lcd->setCursor(indicatorX, UIScale::scale(10));
-            lcd->print("^");
+            gfx.setTextColor(0xFFFF);
+            gfx.setTextSize(1);
+            gfx.setCursor(indicatorX, UIScale::scale(10));
+            gfx.print("^");
         }
 
         if (scrollOffset < maxScrollOffset) {
-            lcd->setTextColor(0xFFFF);
-            lcd->setTextSize(1);
-            lcd->setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
-            lcd->print("v");
+            gfx.setTextColor(0xFFFF);
+            gfx.setTextSize(1);
+            gfx.setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
+            gfx.print("v");
         }
     }
+
+    RenderTarget::present(RenderTarget::BODY);
 }
 
 void MainMenuScreen::handleScrolling(int x, int y, bool wasTapped) {
@@ -187,14 +215,15 @@ void MainMenuScreen::handleScrolling(int x, int y, bool wasTapped) {
     }
 }
 
-void MainMenuScreen::updateButtonPositions() {
+void MainMenuScreen::updateButtonPositions(lgfx::LovyanGFX& gfx) {
     if (!lcd) return;
 
     int startY = UIScale::scale(15);  // Start higher since no title
     int buttonSpacing = UIScale::scale(45);
     int buttonX = (lcd->width() - UIScale::scale(200)) / 2;
 
-    Widgets::Button* buttons[] = {logViewerButton, deviceManagerButton, fileBrowserButton, settingsButton, systemInfoButton};
+    Widgets::Button* buttons[] = {logViewerButton, deviceManagerButton, fileBrowserButton, searchButton, settingsButton,
+                                  systemInfoButton, diagnosticsButton};
 
     for (int i = 0; i < BUTTON_COUNT; i++) {
         if (buttons[i]) {
@@ -203,7 +232,7 @@ void MainMenuScreen::updateButtonPositions() {
 
             // Only draw if visible (starts from top of screen now)
             if (newY >= UIScale::scale(5) && newY < lcd->height() - FOOTER_HEIGHT) {
-                buttons[i]->draw();
+                buttons[i]->draw(gfx);
             }
         }
     }
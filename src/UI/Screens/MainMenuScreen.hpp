@@ -27,13 +27,15 @@ class MainMenuScreen : public Screen {
     Widgets::Button* logViewerButton;
     Widgets::Button* deviceManagerButton;
     Widgets::Button* fileBrowserButton;
+    Widgets::Button* searchButton;
     Widgets::Button* settingsButton;
     Widgets::Button* systemInfoButton;
+    Widgets::Button* diagnosticsButton;
 
     // Scrolling
     int scrollOffset;
     int maxScrollOffset;
-    static const int BUTTON_COUNT = 5;
+    static const int BUTTON_COUNT = 7;
     static const int VISIBLE_BUTTONS = 4;
 
     bool lastTouchState;
@@ -41,7 +43,7 @@ class MainMenuScreen : public Screen {
     void createButtons();
     void drawMenu();
     void handleScrolling(int x, int y, bool wasTapped);
-    void updateButtonPositions();
+    void updateButtonPositions(lgfx::LovyanGFX& gfx);
     void scrollUp();
     void scrollDown();
 };
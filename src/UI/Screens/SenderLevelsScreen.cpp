@@ -0,0 +1,237 @@
+#include "SenderLevelsScreen.hpp"
+#include "../UIScale.hpp"
+#include "../ScreenManager.hpp"
+#include "../RenderTarget.hpp"
+#include "../TouchManager.hpp"
+#include "../../Core/SenderControl.hpp"
+#include "../../Core/TagRegistry.hpp"
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+using Core::SenderControl;
+using Core::TagRegistry;
+
+SenderLevelsScreen::SenderLevelsScreen() : Screen("SenderLevels"),
+                                           backButton(nullptr),
+                                           scrollOffset(0),
+                                           maxVisibleRows(0),
+                                           lastTouchState(false),
+                                           rowsChanged(false),
+                                           shownTags(0),
+                                           shownFlowState(Core::FLOW_OPEN) {
+}
+
+SenderLevelsScreen::~SenderLevelsScreen() {
+    cleanup();
+}
+
+void SenderLevelsScreen::activate() {
+    Screen::activate();
+
+    if (!backButton) {
+        int buttonHeight = UIScale::scale(35);
+        int buttonY = UIScale::scale(15);
+
+        backButton = new Widgets::Button(*lcd, 0, buttonY,
+                                         lcd->width(), buttonHeight, "BACK");
+        backButton->setCallback([this]() {
+            goBack();
+        });
+    }
+
+    createRows();
+    layoutRows();
+    updateStatus();
+}
+
+void SenderLevelsScreen::deactivate() {
+    Screen::deactivate();
+}
+
+void SenderLevelsScreen::update() {
+    if (!active) return;
+
+    // New tags keep turning up, and the flow state follows the load
+    if (TagRegistry::size() != shownTags) {
+        rowsChanged = true;
+    }
+    if (SenderControl::getState() != shownFlowState) {
+        updateStatus();
+    }
+    if (rowsChanged) {
+        rowsChanged = false;
+        createRows();
+        layoutRows();
+        updateStatus();
+        needsRedraw = true;
+    }
+
+    if (needsRedraw) {
+        drawRows();
+        needsRedraw = false;
+    }
+
+    if (backButton) backButton->update();
+    for (auto button : rowButtons) {
+        if (button) button->update();
+    }
+}
+
+void SenderLevelsScreen::handleTouch(int x, int y, bool touched) {
+    if (!active) return;
+
+    bool wasTapped = TouchManager::wasTapped();
+    if (wasTapped) {
+        handleScrolling(x, y, wasTapped);
+    }
+
+    if (touched || lastTouchState) {
+        if (backButton) backButton->handleTouch(x, y, touched);
+        for (auto button : rowButtons) {
+            if (button) button->handleTouch(x, y, touched);
+        }
+        lastTouchState = touched;
+    }
+}
+
+void SenderLevelsScreen::cleanup() {
+    delete backButton;
+    backButton = nullptr;
+
+    for (auto button : rowButtons) {
+        delete button;
+    }
+    rowButtons.clear();
+    rows.clear();
+}
+
+void SenderLevelsScreen::createRows() {
+    rows.clear();
+
+    uint8_t all = SenderControl::getLevel("");
+    rows.emplace_back(String("All tags: ") + getLevelName(all), [this, all]() {
+        SenderControl::setLevel("", nextLevel(all));
+        rowsChanged = true;
+    });
+
+    // Tap cycles sender's own -> VERBOSE -> ... -> ERROR
+    shownTags = TagRegistry::size();
+    for (uint8_t id = 1; id < shownTags; id++) {
+        String tag = TagRegistry::getName(id);
+        uint8_t level = SenderControl::getLevel(tag.c_str());
+        rows.emplace_back("Tag " + tag + ": " + getLevelName(level), [this, tag, level]() {
+            SenderControl::setLevel(tag.c_str(), nextLevel(level));
+            rowsChanged = true;
+        });
+    }
+
+    rows.emplace_back("Reset levels", [this]() {
+        SenderControl::setLevel("", WIRE_LEVEL_CLEAR);
+        for (uint8_t id = 1; id < TagRegistry::size(); id++) {
+            SenderControl::setLevel(TagRegistry::getName(id), WIRE_LEVEL_CLEAR);
+        }
+        rowsChanged = true;
+    });
+}
+
+void SenderLevelsScreen::layoutRows() {
+    for (auto button : rowButtons) {
+        delete button;
+    }
+    rowButtons.clear();
+
+    int startY = HEADER_HEIGHT + UIScale::scale(10);
+    int buttonHeight = UIScale::scale(ROW_BUTTON_HEIGHT);
+    int buttonSpacing = UIScale::scale(ROW_SPACING);
+    int totalWidth = lcd->width() - UIScale::scale(20);
+
+    maxVisibleRows = (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(20)) / buttonSpacing;
+    scrollOffset = std::min(scrollOffset, std::max(0, (int)rows.size() - maxVisibleRows));
+
+    for (size_t i = 0; i < rows.size(); i++) {
+        int visibleIndex = i - scrollOffset;
+        if (visibleIndex < 0 || visibleIndex >= maxVisibleRows) {
+            continue;
+        }
+        int buttonY = startY + (visibleIndex * buttonSpacing);
+        size_t rowIndex = i;
+
+        auto rowButton = new Widgets::Button(*lcd, UIScale::scale(10), buttonY,
+                                             totalWidth, buttonHeight, rows[i].label);
+        rowButton->setCallback([this, rowIndex]() {
+            if (rowIndex < rows.size() && rows[rowIndex].callback) rows[rowIndex].callback();
+        });
+        rowButton->setColors(0x001F, 0x051F, 0x8410, 0xFFFF);
+        rowButtons.push_back(rowButton);
+    }
+}
+
+void SenderLevelsScreen::drawRows() {
+    if (!lcd) return;
+
+    auto& gfx = RenderTarget::begin(RenderTarget::BODY);
+    gfx.fillScreen(0x0000);
+    if (backButton) backButton->draw(gfx);
+    gfx.drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+
+    for (auto button : rowButtons) {
+        if (button) button->draw(gfx);
+    }
+
+    // Scroll indicators
+    if ((int)rows.size() > maxVisibleRows) {
+        int indicatorX = lcd->width() - UIScale::scale(10);
+        gfx.setTextColor(0xFFFF);
+        gfx.setTextSize(UIScale::getGeneralTextSize());
+        if (scrollOffset > 0) {
+            gfx.setCursor(indicatorX, HEADER_HEIGHT + UIScale::scale(5));
+            gfx.print("^");
+        }
+        if (scrollOffset < (int)rows.size() - maxVisibleRows) {
+            gfx.setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
+            gfx.print("v");
+        }
+    }
+
+    RenderTarget::present(RenderTarget::BODY);
+}
+
+void SenderLevelsScreen::handleScrolling(int x, int y, bool wasTapped) {
+    if (!wasTapped || (int)rows.size() <= maxVisibleRows) return;
+
+    // Taps on the right edge scroll, the rest go to the rows
+    if (x < lcd->width() - UIScale::scale(20) || y < HEADER_HEIGHT || y >= lcd->height() - FOOTER_HEIGHT) return;
+
+    int middle = HEADER_HEIGHT + (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT) / 2;
+    int maxScroll = (int)rows.size() - maxVisibleRows;
+    if (y < middle && scrollOffset > 0) {
+        scrollOffset--;
+        rowsChanged = true;
+    } else if (y >= middle && scrollOffset < maxScroll) {
+        scrollOffset++;
+        rowsChanged = true;
+    }
+}
+
+void SenderLevelsScreen::updateStatus() {
+    shownFlowState = SenderControl::getState();
+    ScreenManager::setStatusText(String("Flow ") + SenderControl::getStateName(SenderControl::getState()) + ", load " +
+                                 String(SenderControl::getLoad()) + "%");
+}
+
+uint8_t SenderLevelsScreen::nextLevel(uint8_t level) {
+    if (level == WIRE_LEVEL_CLEAR) return 0;
+    return level >= 4 ? WIRE_LEVEL_CLEAR : level + 1;
+}
+
+const char* SenderLevelsScreen::getLevelName(uint8_t level) {
+    static const char* names[] = {"VERBOSE", "DEBUG", "INFO", "WARN", "ERROR"};
+    if (level == WIRE_LEVEL_CLEAR) return "sender's own";
+    return level < 5 ? names[level] : "?";
+}
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
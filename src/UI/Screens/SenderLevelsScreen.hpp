@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../Screen.hpp"
+#include "../Widgets/Button.hpp"
+#include <vector>
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+/**
+ * Levels pushed to the senders (wire version 6+): one for all tags and one
+ * per tag seen so far. Unlike the live filter these cut records at the
+ * source, so they never reach the card either. Also shows the flow window
+ * BTLogger currently advertises.
+ */
+class SenderLevelsScreen : public Screen {
+   public:
+    SenderLevelsScreen();
+    virtual ~SenderLevelsScreen();
+
+    void activate() override;
+    void deactivate() override;
+    void update() override;
+    void handleTouch(int x, int y, bool touched) override;
+    void cleanup() override;
+
+   private:
+    struct LevelRow {
+        String label;
+        std::function<void()> callback;
+
+        LevelRow(const String& l, std::function<void()> cb) : label(l), callback(cb) {}
+    };
+
+    // UI Elements
+    Widgets::Button* backButton;
+    std::vector<Widgets::Button*> rowButtons;
+    std::vector<LevelRow> rows;
+
+    int scrollOffset;
+    int maxVisibleRows;
+    bool lastTouchState;
+    bool rowsChanged;  // Rebuilt in update(), never from a button's own callback
+    uint8_t shownTags;
+    uint8_t shownFlowState;
+
+    // Constants
+    static const int ROW_BUTTON_HEIGHT = 35;
+    static const int ROW_SPACING = 45;
+
+    void createRows();
+    void layoutRows();
+    void drawRows();
+    void handleScrolling(int x, int y, bool wasTapped);
+    void updateStatus();
+
+    // Sender's own -> VERBOSE -> ... -> ERROR -> sender's own
+    static uint8_t nextLevel(uint8_t level);
+    static const char* getLevelName(uint8_t level);
+};
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
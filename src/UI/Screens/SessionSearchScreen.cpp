@@ -0,0 +1,399 @@
+#include "SessionSearchScreen.hpp"
+#include "FileBrowserScreen.hpp"
+#include "FileViewerScreen.hpp"
+#include "../UIScale.hpp"
+#include "../ScreenManager.hpp"
+#include "../RenderTarget.hpp"
+#include "../TouchManager.hpp"
+#include "../../Core/DeviceRegistry.hpp"
+#include "../../Core/LiveFilter.hpp"
+#include "../../Core/TagRegistry.hpp"
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+using Core::DeviceRegistry;
+using Core::TagRegistry;
+
+SessionSearchScreen::SessionSearchScreen() : Screen("SessionSearch"),
+                                             backButton(nullptr),
+                                             searchButton(nullptr),
+                                             resultList(nullptr),
+                                             coreTaskManager(nullptr),
+                                             minLevel(4),
+                                             tagId(TAG_ID_OTHER),
+                                             deviceId(DEVICE_ID_UNKNOWN),
+                                             useText(false),
+                                             totalHits(0),
+                                             searching(false),
+                                             hitsChanged(false),
+                                             lastTouchState(false),
+                                             lastHitDraw(0) {
+}
+
+SessionSearchScreen::~SessionSearchScreen() {
+    cleanup();
+}
+
+void SessionSearchScreen::activate() {
+    Screen::activate();
+
+    if (!backButton) {
+        createControls();
+    }
+
+    // The text comes from the live filter, which may have changed meanwhile
+    filterText = Core::LiveFilter::getText();
+    if (filterText.isEmpty()) {
+        useText = false;
+    }
+
+    // Registries only grow while running, but a reused id may now name another tag
+    if (tagId >= TagRegistry::size()) tagId = TAG_ID_OTHER;
+    if (deviceId >= DeviceRegistry::size()) deviceId = DEVICE_ID_UNKNOWN;
+
+    resultList->refresh();
+    markForRedraw();
+
+    if (!searching && hits.empty()) {
+        ScreenManager::setStatusText("Search Logs - tap a row to change it");
+    }
+}
+
+void SessionSearchScreen::deactivate() {
+    // The search goes on; hits are waiting when the viewer comes back here
+    Screen::deactivate();
+}
+
+void SessionSearchScreen::update() {
+    if (!active) return;
+
+    // Hits stream in faster than is worth repainting
+    if (hitsChanged) {
+        if (millis() - lastHitDraw >= FILE_SCAN_REDRAW_MS) {
+            hitsChanged = false;
+            lastHitDraw = millis();
+            resultList->refresh();
+            markForRedraw();
+        } else {
+            FrameScheduler::requestFrameIn(FILE_SCAN_REDRAW_MS);
+        }
+    }
+
+    if (needsRedraw) {
+        drawScreen();
+        needsRedraw = false;
+    }
+
+    if (backButton) backButton->update();
+    if (searchButton) searchButton->update();
+
+    if (resultList) resultList->update();
+}
+
+void SessionSearchScreen::handleTouch(int x, int y, bool touched) {
+    if (!active) return;
+
+    bool wasTapped = TouchManager::wasTapped();
+
+    if (wasTapped) {
+        handleScrolling(x, y, wasTapped);
+    }
+
+    if (touched || lastTouchState) {
+        if (backButton) backButton->handleTouch(x, y, touched);
+        if (searchButton) searchButton->handleTouch(x, y, touched);
+
+        if (resultList) resultList->handleTouch(x, y, touched);
+
+        lastTouchState = touched;
+    }
+}
+
+void SessionSearchScreen::cleanup() {
+    // Nothing may call back into a deleted screen
+    if (coreTaskManager) {
+        coreTaskManager->setSearchCallbacks(nullptr, nullptr);
+        if (searching) {
+            coreTaskManager->cancelSearch();
+        }
+    }
+    searching = false;
+
+    delete backButton;
+    delete searchButton;
+    delete resultList;
+
+    backButton = nullptr;
+    searchButton = nullptr;
+    resultList = nullptr;
+}
+
+void SessionSearchScreen::createControls() {
+    if (!lcd) return;
+
+    int buttonHeight = UIScale::scale(35);
+    int buttonY = UIScale::scale(15);
+    int buttonWidth = lcd->width() / 2;
+
+    backButton = new Widgets::Button(*lcd, 0, buttonY, buttonWidth, buttonHeight, "BACK");
+    backButton->setCallback([this]() {
+        goBack();
+    });
+
+    // Takes the remaining width (handles any rounding)
+    searchButton = new Widgets::Button(*lcd, buttonWidth, buttonY, lcd->width() - buttonWidth, buttonHeight, "SEARCH");
+    searchButton->setCallback([this]() {
+        if (searching) {
+            stopSearch();
+        } else {
+            startSearch();
+        }
+    });
+
+    resultList = new Widgets::VirtualList(*lcd);
+    resultList->setSource(this);
+
+    int buttonSpacing = UIScale::scale(35);
+    int visibleRows = (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(20)) / buttonSpacing;
+    resultList->setLayout(UIScale::scale(10), HEADER_HEIGHT + UIScale::scale(10), UIScale::scale(ROW_BUTTON_HEIGHT),
+                          buttonSpacing, visibleRows, UIScale::scale(5));
+}
+
+size_t SessionSearchScreen::getQueryRowCount() const {
+    // Without a keyboard the text to find is the live filter's, when it has one
+    return filterText.isEmpty() ? ROW_TEXT : ROW_TEXT + 1;
+}
+
+String SessionSearchScreen::getQueryLabel(size_t row) const {
+    switch (row) {
+        case ROW_LEVEL:
+            return String("Level: ") + getLevelName(minLevel) + (minLevel > 0 ? " and up" : "");
+        case ROW_TAG:
+            return String("Tag: ") + (tagId == TAG_ID_OTHER ? "any" : TagRegistry::getName(tagId));
+        case ROW_DEVICE:
+            return String("Device: ") + (deviceId == DEVICE_ID_UNKNOWN ? "any" : DeviceRegistry::getName(deviceId));
+        default:
+            return useText ? "Text \"" + filterText + "\"" : String("Text: any");
+    }
+}
+
+void SessionSearchScreen::cycleQueryRow(size_t row) {
+    switch (row) {
+        case ROW_LEVEL:
+            minLevel = minLevel > 0 ? minLevel - 1 : 4;
+            break;
+        case ROW_TAG:
+            tagId = tagId + 1 < TagRegistry::size() ? tagId + 1 : TAG_ID_OTHER;
+            break;
+        case ROW_DEVICE:
+            deviceId = deviceId + 1 < DeviceRegistry::size() ? deviceId + 1 : DEVICE_ID_UNKNOWN;
+            break;
+        default:
+            useText = !useText;
+            break;
+    }
+}
+
+size_t SessionSearchScreen::getRowCount() {
+    return getQueryRowCount() + hits.size();
+}
+
+void SessionSearchScreen::bindRow(size_t index, Widgets::VirtualList::Row& row) {
+    int width = lcd->width() - UIScale::scale(20);
+    row.setCells(&width, 1);
+    Widgets::Button* button = row.cell(0);
+
+    size_t queryRows = getQueryRowCount();
+    if (index < queryRows) {
+        button->setText(getQueryLabel(index));
+        button->setColors(0x07FF, 0x07F8, 0x8410, 0x0000);  // Cyan for the query
+        return;
+    }
+
+    const Hit& hit = hits[index - queryRows];
+    const String& path = files[hit.file];
+    int slash = path.lastIndexOf('/');
+
+    // "name:line" then the line without its timestamp
+    String label = path.substring(slash + 1) + ":" + (hit.line + 1) + " ";
+    const char* text = strchr(hit.text, ',');
+    label += text ? text + 1 : hit.text;
+
+    int textSize = UIScale::getButtonTextSize();
+    size_t length = UIScale::fitTextLength(label.c_str(), label.length(), textSize, width - UIScale::scale(16));
+    button->setText(label.substring(0, length));
+    button->setColors(0x8410, 0x8418, 0x4208, 0xFFFF);  // Gray like the file list
+}
+
+void SessionSearchScreen::onRowTapped(size_t index, int cell) {
+    size_t queryRows = getQueryRowCount();
+    if (index < queryRows) {
+        cycleQueryRow(index);
+        resultList->refresh();
+        markForRedraw();
+        return;
+    }
+
+    const Hit& hit = hits[index - queryRows];
+    FileViewerScreen::showFile(files[hit.file], hit.line);
+    navigateTo("FileViewer");
+}
+
+void SessionSearchScreen::startSearch() {
+    if (!coreTaskManager) {
+        ScreenManager::setStatusText("Search not available");
+        return;
+    }
+
+    Core::SearchQuery query = {};
+    query.levelMask = SEARCH_LEVEL_ALL & ~((1 << minLevel) - 1);
+    query.ignoreCase = true;
+    if (tagId != TAG_ID_OTHER) {
+        strncpy(query.tag, TagRegistry::getName(tagId), sizeof(query.tag) - 1);
+    }
+    if (deviceId != DEVICE_ID_UNKNOWN) {
+        strncpy(query.device, DeviceRegistry::getName(deviceId), sizeof(query.device) - 1);
+    }
+    if (useText) {
+        strncpy(query.text, filterText.c_str(), sizeof(query.text) - 1);
+    }
+
+    hits.clear();
+    files.clear();
+    totalHits = 0;
+
+    // Registered first: the storage task may answer before startSearch returns
+    coreTaskManager->setSearchCallbacks(
+        [this](const char* path, uint32_t line, const char* text) {
+            onHit(path, line, text);
+        },
+        [this](uint32_t count, const char* status) {
+            onDone(count, status);
+        });
+
+    searching = coreTaskManager->startSearch(query) != 0;
+    ScreenManager::setStatusText(searching ? "Searching..." : "Search could not start");
+
+    updateSearchButton();
+    resultList->scrollTo(0);
+    resultList->refresh();
+    markForRedraw();
+}
+
+void SessionSearchScreen::stopSearch() {
+    if (!searching) return;
+
+    // Hits already queued are dropped by the generation check; no done message follows
+    coreTaskManager->cancelSearch();
+    onDone(totalHits, "cancelled");
+}
+
+void SessionSearchScreen::onHit(const char* path, uint32_t line, const char* text) {
+    totalHits++;
+    if (hits.size() >= SEARCH_SCREEN_MAX_HITS) {
+        return;
+    }
+
+    // Hits arrive a file at a time
+    if (files.empty() || files.back() != path) {
+        if (files.size() > 0xFF) {
+            return;
+        }
+        files.push_back(path);
+    }
+
+    Hit hit;
+    hit.file = files.size() - 1;
+    hit.line = line;
+    strncpy(hit.text, text, sizeof(hit.text) - 1);
+    hit.text[sizeof(hit.text) - 1] = '\0';
+    hits.push_back(hit);
+
+    hitsChanged = true;
+    if (active && totalHits % 20 == 1) {
+        ScreenManager::setStatusText(String("Searching... ") + totalHits + " hits");
+    }
+}
+
+void SessionSearchScreen::onDone(uint32_t count, const char* status) {
+    searching = false;
+    totalHits = count;
+
+    String text = String(count) + " hits";
+    if (strcmp(status, "limit") == 0) {
+        text += ", stopped at the limit";
+    } else if (strcmp(status, "cancelled") == 0) {
+        text += ", cancelled";
+    }
+    if (count > hits.size()) {
+        text += String(", first ") + hits.size() + " shown";
+    }
+    ScreenManager::setStatusText(text);
+
+    updateSearchButton();
+    hitsChanged = true;
+    lastHitDraw = 0;  // The final list goes up at once
+    FrameScheduler::requestFrame();
+}
+
+void SessionSearchScreen::updateSearchButton() {
+    if (searchButton) {
+        searchButton->setText(searching ? "STOP" : "SEARCH");
+    }
+    markForRedraw();
+}
+
+void SessionSearchScreen::drawScreen() {
+    if (!lcd) return;
+
+    auto& gfx = RenderTarget::begin(RenderTarget::BODY);
+    gfx.fillScreen(0x0000);
+
+    if (backButton) backButton->draw(gfx);
+    if (searchButton) searchButton->draw(gfx);
+
+    gfx.drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+
+    resultList->draw(gfx);
+
+    // Draw scroll indicators
+    int infoAreaY = HEADER_HEIGHT;
+    int indicatorX = lcd->width() - UIScale::scale(10);
+    gfx.setTextColor(0xFFFF);
+    gfx.setTextSize(UIScale::getGeneralTextSize());
+    if (resultList->canScrollUp()) {
+        gfx.setCursor(indicatorX, infoAreaY + UIScale::scale(5));
+        gfx.print("^");
+    }
+    if (resultList->canScrollDown()) {
+        gfx.setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
+        gfx.print("v");
+    }
+
+    RenderTarget::present(RenderTarget::BODY);
+}
+
+void SessionSearchScreen::handleScrolling(int x, int y, bool wasTapped) {
+    if (!wasTapped || !resultList || (!resultList->canScrollUp() && !resultList->canScrollDown())) return;
+
+    int infoAreaY = HEADER_HEIGHT;
+    int infoAreaHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
+
+    if (y >= infoAreaY && y < lcd->height() - FOOTER_HEIGHT) {
+        int rows = y < infoAreaY + infoAreaHeight / 2 ? -1 : 1;
+        if (resultList->scrollBy(rows)) {
+            markForRedraw();
+        }
+    }
+}
+
+const char* SessionSearchScreen::getLevelName(uint8_t level) {
+    static const char* names[] = {"VERBOSE", "DEBUG", "INFO", "WARN", "ERROR"};
+    return level < 5 ? names[level] : "?";
+}
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../Screen.hpp"
+#include "../Widgets/Button.hpp"
+#include "../Widgets/VirtualList.hpp"
+#include "../../Core/CoreTaskManager.hpp"
+#include <vector>
+
+namespace BTLogger {
+namespace UI {
+namespace Screens {
+
+#define SEARCH_SCREEN_MAX_HITS 100    // Hits kept for the list; the count goes on to SEARCH_MAX_HITS
+#define SEARCH_SCREEN_TEXT_LENGTH 64  // Of each hit's line, enough for one row
+
+/**
+ * Search over the stored sessions (see CoreTaskManager::startSearch). The
+ * first rows set the query: minimum level, tag and device, cycled by
+ * tapping, and the live filter's text when one is set. Hits stream in below
+ * them as the storage task finds them, and tapping one opens the file in the
+ * FileViewer at that line.
+ */
+class SessionSearchScreen : public Screen, private Widgets::VirtualList::Source {
+   public:
+    SessionSearchScreen();
+    virtual ~SessionSearchScreen();
+
+    void activate() override;
+    void deactivate() override;
+    void update() override;
+    void handleTouch(int x, int y, bool touched) override;
+    void cleanup() override;
+
+    void setCoreTaskManager(Core::CoreTaskManager* manager) { coreTaskManager = manager; }
+
+   private:
+    struct Hit {
+        uint8_t file;  // Into files
+        uint32_t line;
+        char text[SEARCH_SCREEN_TEXT_LENGTH];
+    };
+
+    enum QueryRow { ROW_LEVEL, ROW_TAG, ROW_DEVICE, ROW_TEXT };
+
+    // UI Elements
+    Widgets::Button* backButton;
+    Widgets::Button* searchButton;
+    Widgets::VirtualList* resultList;
+
+    Core::CoreTaskManager* coreTaskManager;
+
+    // Query
+    uint8_t minLevel;
+    Core::TagId tagId;        // TAG_ID_OTHER for any
+    Core::DeviceId deviceId;  // DEVICE_ID_UNKNOWN for any
+    bool useText;
+    String filterText;  // The live filter's, read on activate
+
+    // Results
+    std::vector<String> files;
+    std::vector<Hit> hits;
+    uint32_t totalHits;
+    bool searching;
+    bool hitsChanged;
+    bool lastTouchState;
+    unsigned long lastHitDraw;
+
+    // Constants
+    static const int ROW_BUTTON_HEIGHT = 30;
+
+    // VirtualList::Source
+    size_t getRowCount() override;
+    void bindRow(size_t index, Widgets::VirtualList::Row& row) override;
+    void onRowTapped(size_t index, int cell) override;
+
+    void createControls();
+    size_t getQueryRowCount() const;
+    String getQueryLabel(size_t row) const;
+    void cycleQueryRow(size_t row);
+    void startSearch();
+    void stopSearch();
+    void onHit(const char* path, uint32_t line, const char* text);
+    void onDone(uint32_t count, const char* status);
+    void drawScreen();
+    void handleScrolling(int x, int y, bool wasTapped);
+    void updateSearchButton();
+
+    static const char* getLevelName(uint8_t level);
+};
+
+}  // namespace Screens
+}  // namespace UI
+}  // namespace BTLogger
@@ -1,7 +1,10 @@
 #include "SettingsScreen.hpp"
 #include "../UIScale.hpp"
 #include "../ScreenManager.hpp"
+#include "../RenderTarget.hpp"
 #include "../TouchManager.hpp"
+#include "../../Core/SerialMirror.hpp"
+#include "../../Core/NetworkRelay.hpp"
 
 namespace BTLogger {
 namespace UI {
@@ -13,8 +16,7 @@ const SettingsScreen::AdjustmentRange SettingsScreen::TEXT_SIZE_RANGE(0.8f, 2.0f
 
 SettingsScreen::SettingsScreen() : Screen("Settings"),
                                    backButton(nullptr),
-                                   scrollOffset(0),
-                                   maxVisibleSettings(0),
+                                   settingsList(nullptr),
                                    lastTouchState(false) {
 }
 
@@ -48,10 +50,7 @@ void SettingsScreen::update() {
 
     if (backButton) backButton->update();
 
-    // Update setting buttons
-    for (auto button : settingButtons) {
-        if (button) button->update();
-    }
+    if (settingsList) settingsList->update();
 }
 
 void SettingsScreen::handleTouch(int x, int y, bool touched) {
@@ -66,12 +65,7 @@ void SettingsScreen::handleTouch(int x, int y, bool touched) {
     if (touched || lastTouchState) {
         if (backButton) backButton->handleTouch(x, y, touched);
 
-        // Handle setting buttons
-        for (auto button : settingButtons) {
-            if (button) {
-                button->handleTouch(x, y, touched);
-            }
-        }
+        if (settingsList) settingsList->handleTouch(x, y, touched);
 
         lastTouchState = touched;
     }
@@ -79,13 +73,10 @@ void SettingsScreen::handleTouch(int x, int y, bool touched) {
 
 void SettingsScreen::cleanup() {
     delete backButton;
-
-    for (auto button : settingButtons) {
-        delete button;
-    }
-    settingButtons.clear();
+    delete settingsList;
 
     backButton = nullptr;
+    settingsList = nullptr;
     settings.clear();
 }
 
@@ -102,6 +93,9 @@ void SettingsScreen::createControlButtons() {
         Serial.println("Back button pressed in Settings");
         goBack();
     });
+
+    settingsList = new Widgets::VirtualList(*lcd);
+    settingsList->setSource(this);
 }
 
 void SettingsScreen::createSettings() {
@@ -135,6 +129,20 @@ void SettingsScreen::createSettings() {
         toggleDebugMode();
     });
 
+    // Serial mirror of received records
+    settings.emplace_back("Serial Mirror", Core::SerialMirror::getFormatName(Core::SerialMirror::getFormat()), [this]() {
+        cycleSerialMirror();
+    });
+
+    settings.emplace_back("Serial Baud", String(Core::SerialMirror::getBaud()), [this](bool increase) {
+        adjustSerialBaud(increase);
+    });
+
+    // Network relay; network and collector are set over serial ("relay ...")
+    settings.emplace_back("Network Relay", Core::NetworkRelay::isEnabled() ? "On" : "Off", [this]() {
+        toggleNetworkRelay();
+    });
+
     // Reset Settings
     settings.emplace_back("Reset Settings", "Factory Reset", [this]() {
         resetSettings();
@@ -147,142 +155,105 @@ void SettingsScreen::createSettings() {
 }
 
 void SettingsScreen::updateSettingsList() {
-    // Clear existing buttons
-    for (auto button : settingButtons) {
-        delete button;
-    }
-    settingButtons.clear();
-
-    // Calculate layout
-    int startY = HEADER_HEIGHT + UIScale::scale(10);
-    int buttonHeight = UIScale::scale(SETTING_BUTTON_HEIGHT);
+    // Layout follows the UI scale, which the settings themselves change
     int buttonSpacing = UIScale::scale(45);
-    int totalWidth = lcd->width() - UIScale::scale(20);
+    int visibleRows = (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(20)) / buttonSpacing;
+    settingsList->setLayout(UIScale::scale(10), HEADER_HEIGHT + UIScale::scale(10), UIScale::scale(SETTING_BUTTON_HEIGHT),
+                            buttonSpacing, visibleRows, UIScale::scale(5));
+}
 
-    maxVisibleSettings = (lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT - UIScale::scale(20)) / buttonSpacing;
-
-    // Create buttons for visible settings
-    for (size_t i = 0; i < settings.size(); i++) {
-        int visibleIndex = i - scrollOffset;
-        if (visibleIndex >= 0 && visibleIndex < maxVisibleSettings) {
-            int buttonY = startY + (visibleIndex * buttonSpacing);
-            size_t settingIndex = i;
-
-            if (settings[i].hasAdjustment) {
-                // Create label + buttons layout for adjustable settings
-                int labelWidth = totalWidth * 0.5f;
-                int buttonWidth = totalWidth * 0.2f;
-                int buttonGap = UIScale::scale(5);
-
-                // Setting label
-                String labelText = settings[i].name + ": " + settings[i].value;
-                auto labelButton = new Widgets::Button(*lcd, UIScale::scale(10), buttonY,
-                                                       labelWidth, buttonHeight, labelText);
-                labelButton->setColors(0x0000, 0x0000, 0x8410, 0xFFFF);  // Read-only appearance
-                settingButtons.push_back(labelButton);
-
-                // Minus button
-                auto minusButton = new Widgets::Button(*lcd, UIScale::scale(10) + labelWidth + buttonGap, buttonY,
-                                                       buttonWidth, buttonHeight, "-");
-                minusButton->setCallback([this, settingIndex]() {
-                    if (settingIndex < settings.size() && settings[settingIndex].adjustCallback) {
-                        settings[settingIndex].adjustCallback(false);  // false = decrease
-                        createSettings();
-                        updateSettingsList();
-                        markForRedraw();
-                    }
-                });
-                minusButton->setColors(0x8000, 0xA000, 0x8410, 0xFFFF);  // Red theme for minus
-                settingButtons.push_back(minusButton);
-
-                // Plus button
-                auto plusButton = new Widgets::Button(*lcd, UIScale::scale(10) + labelWidth + buttonGap + buttonWidth + buttonGap, buttonY,
-                                                      buttonWidth, buttonHeight, "+");
-                plusButton->setCallback([this, settingIndex]() {
-                    if (settingIndex < settings.size() && settings[settingIndex].adjustCallback) {
-                        settings[settingIndex].adjustCallback(true);  // true = increase
-                        createSettings();
-                        updateSettingsList();
-                        markForRedraw();
-                    }
-                });
-                plusButton->setColors(0x03E0, 0x07E0, 0x8410, 0xFFFF);  // Green theme for plus
-                settingButtons.push_back(plusButton);
-            } else {
-                // Single button for non-adjustable settings
-                String buttonText = settings[i].name + ": " + settings[i].value;
-                auto settingButton = new Widgets::Button(*lcd, UIScale::scale(10), buttonY,
-                                                         totalWidth, buttonHeight, buttonText);
-
-                settingButton->setCallback([this, settingIndex]() {
-                    if (settingIndex < settings.size() && settings[settingIndex].callback) {
-                        settings[settingIndex].callback();
-                        // Refresh settings list after action
-                        createSettings();
-                        updateSettingsList();
-                        markForRedraw();
-                    }
-                });
-
-                // Use different colors for different setting types
-                settingButton->setColors(0x001F, 0x051F, 0x8410, 0xFFFF);  // Blue theme
-
-                settingButtons.push_back(settingButton);
-            }
-        }
+void SettingsScreen::bindRow(size_t index, Widgets::VirtualList::Row& row) {
+    const SettingItem& setting = settings[index];
+    int totalWidth = lcd->width() - UIScale::scale(20);
+    String labelText = setting.name + ": " + setting.value;
+
+    if (setting.hasAdjustment) {
+        // Label + buttons layout for adjustable settings
+        int widths[3] = {(int)(totalWidth * 0.5f), (int)(totalWidth * 0.2f), (int)(totalWidth * 0.2f)};
+        row.setCells(widths, 3);
+
+        row.cell(0)->setText(labelText);
+        row.cell(0)->setColors(0x0000, 0x0000, 0x8410, 0xFFFF);  // Read-only appearance
+        row.cell(1)->setText("-");
+        row.cell(1)->setColors(0x8000, 0xA000, 0x8410, 0xFFFF);  // Red theme for minus
+        row.cell(2)->setText("+");
+        row.cell(2)->setColors(0x03E0, 0x07E0, 0x8410, 0xFFFF);  // Green theme for plus
+    } else {
+        // Single button for non-adjustable settings
+        row.setCells(&totalWidth, 1);
+        row.cell(0)->setText(labelText);
+        row.cell(0)->setColors(0x001F, 0x051F, 0x8410, 0xFFFF);  // Blue theme
     }
 }
 
+void SettingsScreen::onRowTapped(size_t index, int cell) {
+    if (index >= settings.size()) return;
+
+    SettingItem& setting = settings[index];
+    if (setting.hasAdjustment) {
+        if (cell == 0 || !setting.adjustCallback) return;  // The label is read-only
+        setting.adjustCallback(cell == 2);                  // Cell 2 is "+"
+    } else if (setting.callback) {
+        setting.callback();
+    } else {
+        return;
+    }
+
+    // Refresh values (and layout, the scale may have changed) after the action
+    createSettings();
+    updateSettingsList();
+    markForRedraw();
+}
 void SettingsScreen::drawSettings() {
     if (!lcd) return;
 
-    // Clear screen
-    lcd->fillScreen(0x0000);
+    // Compose the whole page off-screen
+    auto& gfx = RenderTarget::begin(RenderTarget::BODY);
+    gfx.fillScreen(0x0000);
 
     // Draw header - just buttons, no title
-    if (backButton) backButton->draw();
+    if (backButton) backButton->draw(gfx);
 
-    lcd->drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+    gfx.drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
 
     int infoAreaY = HEADER_HEIGHT;
 
     if (settings.empty()) {
-        lcd->setTextColor(0x8410);
-        lcd->setTextSize(UIScale::getGeneralTextSize());
-        lcd->setCursor(UIScale::scale(10), infoAreaY + UIScale::scale(20));
-        lcd->print("No settings available");
+        gfx.setTextColor(0x8410);
+        gfx.setTextSize(UIScale::getGeneralTextSize());
+        gfx.setCursor(UIScale::scale(10), infoAreaY + UIScale::scale(20));
+        gfx.print("No settings available");
+        RenderTarget::present(RenderTarget::BODY);
         return;
     }
 
     // Draw setting buttons
-    for (auto button : settingButtons) {
-        if (button) {
-            button->draw();
-        }
-    }
+    settingsList->draw(gfx);
 
     // Draw scroll indicators
-    if (settings.size() > maxVisibleSettings) {
+    if (settingsList->canScrollUp() || settingsList->canScrollDown()) {
         int indicatorX = lcd->width() - UIScale::scale(10);
 
-        if (scrollOffset > 0) {
-            lcd->setTextColor(0xFFFF);
-            lcd->setTextSize(UIScale::getGeneralTextSize());
-            lcd->setCursor(indicatorX, infoAreaY + UIScale::scale(5));
-            lcd->print("^");
+        if (settingsList->canScrollUp()) {
+            gfx.setTextColor(0xFFFF);
+            gfx.setTextSize(UIScale::getGeneralTextSize());
+            gfx.setCursor(indicatorX, infoAreaY + UIScale::scale(5));
+            gfx.print("^");
         }
 
-        if (scrollOffset < (int)settings.size() - maxVisibleSettings) {
-            lcd->setTextColor(0xFFFF);
-            lcd->setTextSize(UIScale::getGeneralTextSize());
-            lcd->setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
-            lcd->print("v");
+        if (settingsList->canScrollDown()) {
+            gfx.setTextColor(0xFFFF);
+            gfx.setTextSize(UIScale::getGeneralTextSize());
+            gfx.setCursor(indicatorX, lcd->height() - FOOTER_HEIGHT - UIScale::scale(15));
+            gfx.print("v");
         }
     }
+
+    RenderTarget::present(RenderTarget::BODY);
 }
 
 void SettingsScreen::handleScrolling(int x, int y, bool wasTapped) {
-    if (!wasTapped || settings.size() <= maxVisibleSettings) return;
+    if (!wasTapped || !settingsList || (!settingsList->canScrollUp() && !settingsList->canScrollDown())) return;
 
     int infoAreaY = HEADER_HEIGHT;
     int infoAreaHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
@@ -297,22 +268,15 @@ void SettingsScreen::handleScrolling(int x, int y, bool wasTapped) {
 }
 
 void SettingsScreen::scrollUp() {
-    if (scrollOffset > 0) {
-        scrollOffset--;
-        updateSettingsList();
+    if (settingsList->scrollBy(-1)) {
         markForRedraw();
     }
 }
-
 void SettingsScreen::scrollDown() {
-    int maxScroll = std::max(0, (int)settings.size() - maxVisibleSettings);
-    if (scrollOffset < maxScroll) {
-        scrollOffset++;
-        updateSettingsList();
+    if (settingsList->scrollBy(1)) {
         markForRedraw();
     }
 }
-
 void SettingsScreen::calibrateTouch() {
     ScreenManager::setStatusText("Starting touch calibration...");
     TouchManager::resetCalibration();
@@ -356,6 +320,26 @@ void SettingsScreen::toggleDebugMode() {
     ScreenManager::setStatusText(debugMode ? "Debug mode enabled" : "Debug mode disabled");
 }
 
+void SettingsScreen::cycleSerialMirror() {
+    using Core::SerialMirror;
+    Core::SerialMirrorFormat next = (Core::SerialMirrorFormat)((SerialMirror::getFormat() + 1) % Core::SERIAL_MIRROR_FORMATS);
+    SerialMirror::setFormat(next);
+    ScreenManager::setStatusText(String("Serial mirror: ") + SerialMirror::getFormatName(next));
+}
+
+void SettingsScreen::adjustSerialBaud(bool increase) {
+    using Core::SerialMirror;
+    uint32_t baud = SerialMirror::stepBaud(SerialMirror::getBaud(), increase);
+    SerialMirror::setBaud(baud);
+    ScreenManager::setStatusText("Serial baud " + String(baud) + " (also after restart)");
+}
+
+void SettingsScreen::toggleNetworkRelay() {
+    using Core::NetworkRelay;
+    NetworkRelay::setEnabled(!NetworkRelay::isEnabled());
+    ScreenManager::setStatusText(String("Network relay: ") + NetworkRelay::getStateName(NetworkRelay::getState()));
+}
+
 void SettingsScreen::resetSettings() {
     // Reset UI scale
     UIScale::setScale(1.0f);
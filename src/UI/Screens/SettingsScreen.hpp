@@ -2,6 +2,7 @@
 
 #include "../Screen.hpp"
 #include "../Widgets/Button.hpp"
+#include "../Widgets/VirtualList.hpp"
 #include <vector>
 
 namespace BTLogger {
@@ -11,7 +12,7 @@ namespace Screens {
 /**
  * Settings screen for system configuration
  */
-class SettingsScreen : public Screen {
+class SettingsScreen : public Screen, private Widgets::VirtualList::Source {
    public:
     SettingsScreen();
     virtual ~SettingsScreen();
@@ -53,12 +54,10 @@ class SettingsScreen : public Screen {
     // UI Elements
     Widgets::Button* backButton;
 
-    // Setting buttons (dynamically created)
-    std::vector<Widgets::Button*> settingButtons;
+    // Setting rows, recycled as the list scrolls
+    Widgets::VirtualList* settingsList;
     std::vector<SettingItem> settings;
 
-    int scrollOffset;
-    int maxVisibleSettings;
     bool lastTouchState;
 
     // Constants
@@ -67,6 +66,11 @@ class SettingsScreen : public Screen {
     void createControlButtons();
     void createSettings();
     void updateSettingsList();
+
+    // VirtualList::Source
+    size_t getRowCount() override { return settings.size(); }
+    void bindRow(size_t index, Widgets::VirtualList::Row& row) override;
+    void onRowTapped(size_t index, int cell) override;
     void drawSettings();
     void handleScrolling(int x, int y, bool wasTapped);
     void scrollUp();
@@ -79,6 +83,9 @@ class SettingsScreen : public Screen {
     void adjustButtonTextSize(bool increase);
     void adjustGeneralTextSize(bool increase);
     void toggleDebugMode();
+    void cycleSerialMirror();
+    void adjustSerialBaud(bool increase);
+    void toggleNetworkRelay();
     void resetSettings();
     void showAbout();
 
@@ -2,6 +2,7 @@
 #include "../UIScale.hpp"
 #include "../TouchManager.hpp"
 #include "../ScreenManager.hpp"
+#include "../RenderTarget.hpp"
 
 namespace BTLogger {
 namespace UI {
@@ -42,6 +43,7 @@ void SystemInfoScreen::update() {
         needsRedraw = false;
         lastUpdate = millis();
     }
+    FrameScheduler::requestFrameIn(1000 - min(1000UL, millis() - lastUpdate) + 1);
 
     // Update buttons
     if (backButton) backButton->update();
@@ -120,70 +122,78 @@ void SystemInfoScreen::createButtons() {
 void SystemInfoScreen::drawHeader() {
     if (!lcd) return;
 
+    auto& gfx = RenderTarget::begin(RenderTarget::HEADER);
+
     // Clear header area
-    lcd->fillRect(0, 0, lcd->width(), HEADER_HEIGHT, 0x0000);
+    gfx.fillRect(0, 0, lcd->width(), HEADER_HEIGHT, 0x0000);
 
     // Draw buttons
-    if (backButton) backButton->draw();
-    if (touchCalButton) touchCalButton->draw();
-    if (debugButton) debugButton->draw();
+    if (backButton) backButton->draw(gfx);
+    if (touchCalButton) touchCalButton->draw(gfx);
+    if (debugButton) debugButton->draw(gfx);
 
     // Draw separator line
-    lcd->drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+    gfx.drawFastHLine(0, HEADER_HEIGHT - 1, lcd->width(), 0x8410);
+
+    RenderTarget::present(RenderTarget::HEADER);
 }
 
 void SystemInfoScreen::drawSystemInfo() {
     if (!lcd) return;
 
+    auto& gfx = RenderTarget::begin(RenderTarget::CONTENT);
+
     // Clear info area
     int infoAreaY = HEADER_HEIGHT;
     int infoAreaHeight = lcd->height() - HEADER_HEIGHT - FOOTER_HEIGHT;
-    lcd->fillRect(0, infoAreaY, lcd->width(), infoAreaHeight, 0x0000);
+    gfx.fillRect(0, infoAreaY, lcd->width(), infoAreaHeight, 0x0000);
 
-    lcd->setTextColor(0xFFFF);  // White
-    lcd->setTextSize(UIScale::scale(1));
+    gfx.setTextColor(0xFFFF);  // White
+    gfx.setTextSize(UIScale::scale(1));
 
     int y = infoAreaY + UIScale::scale(10);
     int lineHeight = UIScale::scale(15);
 
     // System info
-    lcd->setCursor(UIScale::scale(10), y);
-    lcd->print("BTLogger System Info");
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.print("BTLogger System Info");
     y += lineHeight * 2;
 
-    lcd->setCursor(UIScale::scale(10), y);
-    lcd->printf("Display: %dx%d", lcd->width(), lcd->height());
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.printf("Display: %dx%d", lcd->width(), lcd->height());
     y += lineHeight;
 
-    lcd->setCursor(UIScale::scale(10), y);
-    lcd->printf("Free Heap: %d KB", ESP.getFreeHeap() / 1024);
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.printf("Free Heap: %d KB", ESP.getFreeHeap() / 1024);
     y += lineHeight;
 
-    lcd->setCursor(UIScale::scale(10), y);
-    lcd->printf("Uptime: %lu sec", millis() / 1000);
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.printf("Uptime: %lu sec", millis() / 1000);
     y += lineHeight;
 
-    lcd->setCursor(UIScale::scale(10), y);
-    lcd->printf("CPU Freq: %d MHz", ESP.getCpuFreqMHz());
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.printf("CPU Freq: %d MHz", ESP.getCpuFreqMHz());
     y += lineHeight;
 
     // Touch info
     y += lineHeight;
-    lcd->setCursor(UIScale::scale(10), y);
-    lcd->print("Touch Status:");
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.print("Touch Status:");
     y += lineHeight;
 
     TouchManager::TouchPoint touch = TouchManager::getTouch();
-    lcd->setCursor(UIScale::scale(10), y);
-    lcd->printf("Position: (%d, %d)", touch.x, touch.y);
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.printf("Position: (%d, %d)", touch.x, touch.y);
     y += lineHeight;
 
-    lcd->setCursor(UIScale::scale(10), y);
-    lcd->printf("Pressed: %s", touch.pressed ? "YES" : "NO");
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.printf("Pressed: %s", touch.pressed ? "YES" : "NO");
     y += lineHeight;
 
-    lcd->setCursor(UIScale::scale(10), y);
-    lcd->printf("Calibrated: %s", TouchManager::needsCalibration() ? "NO" : "YES");
+    gfx.setCursor(UIScale::scale(10), y);
+    gfx.printf("Calibrated: %s", TouchManager::needsCalibration() ? "NO" : "YES");
+
+    RenderTarget::present(RenderTarget::CONTENT);
 }
 
 void SystemInfoScreen::performTouchCalibration() {
@@ -1,5 +1,6 @@
 #include "ToastManager.hpp"
 #include "UIScale.hpp"
+#include "FrameScheduler.hpp"
 
 namespace BTLogger {
 namespace UI {
@@ -7,10 +8,12 @@ namespace UI {
 // Static member definitions
 bool ToastManager::initialized = false;
 lgfx::LGFX_Device* ToastManager::lcd = nullptr;
-String ToastManager::currentMessage = "";
+char ToastManager::currentMessage[TOAST_MESSAGE_LENGTH] = "";
 ToastManager::ToastType ToastManager::currentType = INFO;
 unsigned long ToastManager::showTime = 0;
+unsigned long ToastManager::lastDraw = 0;
 bool ToastManager::visible = false;
+bool ToastManager::dirty = false;
 
 void ToastManager::initialize(lgfx::LGFX_Device& display) {
     if (initialized) {
@@ -28,39 +31,50 @@ void ToastManager::update() {
     }
 
     // Check if toast should be hidden
-    if (millis() - showTime > TOAST_DURATION) {
+    unsigned long now = millis();
+    if (now - showTime > TOAST_DURATION) {
         visible = false;
         // Could add fade-out animation here
     } else {
-        drawToast();
+        if (dirty || now - lastDraw >= TOAST_REDRAW_MS) {
+            drawToast();
+            lastDraw = now;
+            dirty = false;
+        }
+        // Next repair, or the frame that takes it down
+        unsigned long remaining = TOAST_DURATION + 1 - (now - showTime);
+        FrameScheduler::requestFrameIn(remaining < TOAST_REDRAW_MS ? remaining : TOAST_REDRAW_MS);
     }
 }
 
 void ToastManager::showInfo(const String& message) {
-    showToast(message, INFO);
+    show(message.c_str(), INFO);
 }
 
 void ToastManager::showSuccess(const String& message) {
-    showToast(message, SUCCESS);
+    show(message.c_str(), SUCCESS);
 }
 
 void ToastManager::showWarning(const String& message) {
-    showToast(message, WARNING);
+    show(message.c_str(), WARNING);
 }
 
 void ToastManager::showError(const String& message) {
-    showToast(message, ERROR);
+    show(message.c_str(), ERROR);
 }
 
-void ToastManager::showToast(const String& message, ToastType type) {
+void ToastManager::show(const char* message, ToastType type) {
     if (!initialized) return;
 
-    currentMessage = message;
+    strncpy(currentMessage, message, sizeof(currentMessage) - 1);
+    currentMessage[sizeof(currentMessage) - 1] = '\0';
     currentType = type;
     showTime = millis();
     visible = true;
+    dirty = true;
+    FrameScheduler::requestFrame();
 
-    Serial.printf("Toast: %s\n", message.c_str());
+    Serial.printf("Toast: %s\n", currentMessage);
 }
 
 void ToastManager::drawToast() {
@@ -81,7 +95,10 @@ void ToastManager::drawToast() {
     lcd->setTextColor(0xFFFF);
     lcd->setTextSize(1);
     lcd->setCursor(x + UIScale::scale(10), y + UIScale::scale(15));
-    lcd->print(currentMessage.substring(0, 25));  // Limit length
+    char shown[26];  // Limit length
+    strncpy(shown, currentMessage, sizeof(shown) - 1);
+    shown[sizeof(shown) - 1] = '\0';
+    lcd->print(shown);
 }
 
 uint16_t ToastManager::getToastColor(ToastType type) {
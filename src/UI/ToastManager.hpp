@@ -6,8 +6,12 @@
 namespace BTLogger {
 namespace UI {
 
+#define TOAST_MESSAGE_LENGTH 64
+
 /**
- * ToastManager provides non-intrusive notifications
+ * ToastManager provides non-intrusive notifications. The toast is drawn when
+ * it changes and otherwise only every TOAST_REDRAW_MS, to restore it after
+ * screens paint over it.
  */
 class ToastManager {
    public:
@@ -21,6 +25,7 @@ class ToastManager {
     // Initialization
     static void initialize(lgfx::LGFX_Device& display);
     static bool isInitialized() { return initialized; }
+    static bool isVisible() { return visible; }
 
     // Main update loop
     static void update();
@@ -30,17 +35,20 @@ class ToastManager {
     static void showSuccess(const String& message);
     static void showWarning(const String& message);
     static void showError(const String& message);
+    static void show(const char* message, ToastType type);  // No String copies on hot paths
 
    private:
     static bool initialized;
     static lgfx::LGFX_Device* lcd;
-    static String currentMessage;
+    static char currentMessage[TOAST_MESSAGE_LENGTH];
     static ToastType currentType;
     static unsigned long showTime;
+    static unsigned long lastDraw;
     static bool visible;
+    static bool dirty;
     static const unsigned long TOAST_DURATION = 1500;  // 1.5 seconds
+    static const unsigned long TOAST_REDRAW_MS = 100;
 
-    static void showToast(const String& message, ToastType type);
     static void drawToast();
     static uint16_t getToastColor(ToastType type);
 };
@@ -1,11 +1,20 @@
 #include "TouchManager.hpp"
 #include "UIScale.hpp"
+#include "FrameScheduler.hpp"
 #include <algorithm>
 
-#ifdef USE_BITBANG_TOUCH
 #include "../Hardware/ESP32_SPI_9341.h"
+#if defined(USE_BITBANG_TOUCH) && TOUCH_SHARED_SPI
+#include "../Hardware/SharedSPIBus.hpp"
 #endif
 
+// XPT2046 control bytes (12-bit, differential; the last one powers down and re-arms PENIRQ)
+#define XPT2046_CMD_X 0xD1
+#define XPT2046_CMD_Y 0x91
+#define XPT2046_CMD_Z1 0xB1
+#define XPT2046_CMD_Z2 0xC1
+#define XPT2046_CMD_POWER_DOWN 0xD0
+
 // Compile-time calibration version - increment this to invalidate all existing calibration data
 #define TOUCH_CALIBRATION_VERSION 6
 
@@ -20,6 +29,7 @@ TouchManager::CalibrationData TouchManager::calibrationData;
 
 #ifdef USE_BITBANG_TOUCH
 XPT2046_Bitbang* TouchManager::touchController = nullptr;
+bool TouchManager::controllerReady = false;
 #endif
 
 TouchManager::TouchPoint TouchManager::currentTouch;
@@ -89,10 +99,18 @@ bool TouchManager::initialize(lgfx::LGFX_Device& display) {
     Serial.println("TouchManager initialized with LovyanGFX hardware SPI touch");
 #endif
 
+    // Contact pulls the XPT2046 PENIRQ line low: wake the UI task for a frame
+    pinMode(TOUCH_IRQ, INPUT);
+    attachInterrupt(digitalPinToInterrupt(TOUCH_IRQ), onTouchInterrupt, FALLING);
+
     initialized = true;
     return true;
 }
 
+void IRAM_ATTR TouchManager::onTouchInterrupt() {
+    FrameScheduler::requestFrameFromISR();
+}
+
 void TouchManager::update() {
     if (!initialized || !lcd) {
         return;
@@ -348,6 +366,13 @@ void TouchManager::showTouchDebugInfo() {
 
 #ifdef USE_BITBANG_TOUCH
 bool TouchManager::initializeBitbangTouch() {
+#if TOUCH_SHARED_SPI
+    // The data lines belong to the SD card's bus; only the chip select is ours
+    pinMode(TOUCH_CS, OUTPUT);
+    digitalWrite(TOUCH_CS, HIGH);
+    controllerReady = true;
+    Serial.println("Touch controller on the shared VSPI bus");
+#else
     if (touchController) {
         delete touchController;
     }
@@ -355,24 +380,113 @@ bool TouchManager::initializeBitbangTouch() {
     touchController = new XPT2046_Bitbang(TOUCH_MOSI, TOUCH_MISO, TOUCH_SCK, TOUCH_CS);
     touchController->begin();
     // touchController->setRotation(1);  // Match display rotation
+    controllerReady = true;
 
     Serial.println("Software SPI touch controller initialized");
+#endif
     return true;
 }
 
+bool TouchManager::readRaw(RawSample& sample, bool wait) {
+#if TOUCH_SHARED_SPI
+    // Skip a reading rather than wait behind an SD commit
+    if (wait) {
+        Hardware::SharedSPIBus::lock();
+    } else if (!Hardware::SharedSPIBus::tryLock()) {
+        return false;
+    }
+
+    SPIClass& spi = Hardware::SharedSPIBus::get();
+    spi.beginTransaction(SPISettings(TOUCH_SPI_FREQUENCY, MSBFIRST, SPI_MODE0));
+    digitalWrite(TOUCH_CS, LOW);
+
+    // Each transfer clocks out the previous conversion while sending the next command
+    spi.transfer(XPT2046_CMD_Z1);
+    int z1 = spi.transfer16(XPT2046_CMD_Z2) >> 3;
+    int z2 = spi.transfer16(XPT2046_CMD_X) >> 3;
+    sample.xRaw = spi.transfer16(XPT2046_CMD_Y) >> 3;
+    sample.yRaw = spi.transfer16(XPT2046_CMD_POWER_DOWN) >> 3;
+    spi.transfer16(0);
+
+    digitalWrite(TOUCH_CS, HIGH);
+    spi.endTransaction();
+    Hardware::SharedSPIBus::unlock();
+
+    sample.zRaw = z1 + 4095 - z2;
+    return true;
+#else
+    auto touch = readRaw();
+    sample.xRaw = touch.xRaw;
+    sample.yRaw = touch.yRaw;
+    sample.zRaw = touch.zRaw;
+    return true;
+#endif
+}
+
+TouchManager::RawSample TouchManager::readRaw() {
+    RawSample sample = {0, 0, 0};
+    if (controllerReady) {
+        readRaw(sample, true);
+    }
+    return sample;
+}
+
+int TouchManager::trimmedMean(int* values, int count) {
+    // Insertion sort; the window is a handful of samples
+    for (int i = 1; i < count; i++) {
+        int value = values[i];
+        int j = i - 1;
+        while (j >= 0 && values[j] > value) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = value;
+    }
+
+    // Drop the extremes when there are enough samples to spare them
+    int first = count >= 3 ? 1 : 0;
+    int last = count >= 3 ? count - 1 : count;
+    long sum = 0;
+    for (int i = first; i < last; i++) {
+        sum += values[i];
+    }
+    return sum / (last - first);
+}
+
 TouchManager::TouchPoint TouchManager::getBitbangTouchCoordinates() {
     TouchPoint point;
 
-    if (!touchController) {
+    if (!controllerReady) {
+        return point;
+    }
+
+#if TOUCH_IRQ_SAMPLING
+    // PENIRQ is high without contact: no bus traffic at all while idle
+    if (digitalRead(TOUCH_IRQ) == HIGH) {
         return point;
     }
+#endif
 
-    auto touch = touchController->getTouch();
+    int xs[TOUCH_SAMPLE_WINDOW];
+    int ys[TOUCH_SAMPLE_WINDOW];
+    int count = 0;
+    for (int i = 0; i < TOUCH_SAMPLE_WINDOW; i++) {
+        RawSample sample;
+        if (!readRaw(sample, false)) {
+            return currentTouch;  // Bus busy: keep the last reading for this frame
+        }
+        if (sample.zRaw >= TOUCH_MIN_PRESSURE) {  // Minimum pressure threshold
+            xs[count] = sample.xRaw;
+            ys[count] = sample.yRaw;
+            count++;
+        }
+    }
 
-    if (touch.zRaw >= 500) {  // Minimum pressure threshold
+    // Mostly light samples are a finger landing or lifting
+    if (count * 2 > TOUCH_SAMPLE_WINDOW) {
         // Return raw coordinates - calibration will be handled at higher level
-        point.x = touch.xRaw;
-        point.y = touch.yRaw;
+        point.x = trimmedMean(xs, count);
+        point.y = trimmedMean(ys, count);
         point.pressed = true;
 
         // If we have calibration data, also provide calibrated coordinates
@@ -390,7 +504,7 @@ TouchManager::TouchPoint TouchManager::getBitbangTouchCoordinates() {
 }
 
 void TouchManager::performBitbangTouchCalibration() {
-    if (!lcd || !touchController) return;
+    if (!lcd || !controllerReady) return;
 
     Serial.println("Starting bitbang touch calibration...");
 
@@ -432,7 +546,7 @@ void TouchManager::performBitbangTouchCalibration() {
         const unsigned long timeout = 30000;  // 30 second timeout
 
         while (!pointCollected && (millis() - startTime) < timeout) {
-            auto touch = touchController->getTouch();
+            auto touch = readRaw();
 
             if (touch.zRaw >= 500) {  // Touch detected - accept any touch during calibration
                 // Collect multiple samples for stability
@@ -441,7 +555,7 @@ void TouchManager::performBitbangTouchCalibration() {
                 unsigned long sampleStart = millis();
 
                 while (millis() - sampleStart < 1000) {  // Sample for 1 second for better stability
-                    auto sampleTouch = touchController->getTouch();
+                    auto sampleTouch = readRaw();
                     if (sampleTouch.zRaw >= 500) {
                         sumX += sampleTouch.xRaw;
                         sumY += sampleTouch.yRaw;
@@ -673,8 +787,8 @@ bool TouchManager::improvedCalibrationRoutine() {
 
         while (!pointCollected && (millis() - startTime) < timeout) {
 #ifdef USE_BITBANG_TOUCH
-            if (touchController) {
-                auto touch = touchController->getTouch();
+            if (controllerReady) {
+                auto touch = readRaw();
                 if (touch.zRaw >= 500) {
                     // Collect samples for 1 second
                     int sampleCount = 0;
@@ -682,7 +796,7 @@ bool TouchManager::improvedCalibrationRoutine() {
                     unsigned long sampleStart = millis();
 
                     while (millis() - sampleStart < 1000) {
-                        auto sampleTouch = touchController->getTouch();
+                        auto sampleTouch = readRaw();
                         if (sampleTouch.zRaw >= 500) {
                             sumX += sampleTouch.xRaw;
                             sumY += sampleTouch.yRaw;
@@ -36,6 +36,17 @@
 #include <XPT2046_Bitbang.h>
 #endif
 
+// Touch sampling (USE_BITBANG_TOUCH builds)
+#ifndef TOUCH_IRQ_SAMPLING
+#define TOUCH_IRQ_SAMPLING 1  // Only talk to the controller while PENIRQ reports contact
+#endif
+#ifndef TOUCH_SHARED_SPI
+#define TOUCH_SHARED_SPI 0    // Controller wired to the SD card's VSPI bus (own CS): hardware SPI instead of bitbang
+#endif
+#define TOUCH_SAMPLE_WINDOW 5     // Raw samples per reading, combined by a trimmed mean
+#define TOUCH_MIN_PRESSURE 500
+#define TOUCH_SPI_FREQUENCY 2000000
+
 namespace BTLogger {
 namespace UI {
 
@@ -131,12 +142,21 @@ class TouchManager {
 
     // Touch coordinate retrieval (internal use)
     static TouchPoint getTouchCoordinates();
+    static void IRAM_ATTR onTouchInterrupt();
 
 #ifdef USE_BITBANG_TOUCH
     // Software SPI touch implementation for CYD SPI conflict resolution
+    struct RawSample {
+        int xRaw, yRaw, zRaw;
+    };
+
     static XPT2046_Bitbang* touchController;
+    static bool controllerReady;
     static TouchPoint getBitbangTouchCoordinates();
     static bool initializeBitbangTouch();
+    static bool readRaw(RawSample& sample, bool wait);  // false if the shared bus was busy
+    static RawSample readRaw();                          // Waits for the bus (calibration)
+    static int trimmedMean(int* values, int count);
 
     // Bitbang touch calibration methods
     static void performBitbangTouchCalibration();
@@ -16,7 +16,7 @@ const int UIScale::DEFAULT_LABEL_TEXT_SIZE = 1;
 const int UIScale::DEFAULT_BUTTON_TEXT_SIZE = 2;
 const int UIScale::DEFAULT_GENERAL_TEXT_SIZE = 1;
 
-// Font size estimation (based on standard 6x8 pixel font at size 1)
+// Font size estimate (standard 6x8 font at size 1), used until the real font is measured
 const int UIScale::CHAR_WIDTH_SIZE_1 = 6;
 const int UIScale::CHAR_HEIGHT_SIZE_1 = 8;
 
@@ -26,6 +26,11 @@ float UIScale::currentScale = DEFAULT_SCALE;
 int UIScale::labelTextSize = DEFAULT_LABEL_TEXT_SIZE;
 int UIScale::buttonTextSize = DEFAULT_BUTTON_TEXT_SIZE;
 int UIScale::generalTextSize = DEFAULT_GENERAL_TEXT_SIZE;
+uint16_t UIScale::layoutGeneration = 0;
+uint8_t UIScale::glyphWidths[UI_TEXT_SIZE_MAX][UI_FONT_GLYPHS];
+uint8_t UIScale::widestGlyph[UI_TEXT_SIZE_MAX];
+uint8_t UIScale::fontHeight = CHAR_HEIGHT_SIZE_1;
+bool UIScale::metricsLoaded = false;
 Preferences UIScale::preferences;
 
 void UIScale::initialize() {
@@ -43,6 +48,7 @@ void UIScale::setScale(float scale) {
     float newScale = clampScale(scale);
     if (newScale != currentScale) {
         currentScale = newScale;
+        layoutGeneration++;
         saveScale();
         Serial.printf("UI Scale changed to %.1fx\n", currentScale);
     }
@@ -79,18 +85,21 @@ void UIScale::resetScale() {
 // Text sizing methods
 void UIScale::setLabelTextSize(int size) {
     labelTextSize = constrain(size, 1, 4);
+    layoutGeneration++;
     saveSettings();
     Serial.printf("Label text size set to %d\n", labelTextSize);
 }
 
 void UIScale::setButtonTextSize(int size) {
     buttonTextSize = constrain(size, 1, 4);
+    layoutGeneration++;
     saveSettings();
     Serial.printf("Button text size set to %d\n", buttonTextSize);
 }
 
 void UIScale::setGeneralTextSize(int size) {
     generalTextSize = constrain(size, 1, 4);
+    layoutGeneration++;
     saveSettings();
     Serial.printf("General text size set to %d\n", generalTextSize);
 }
@@ -107,16 +116,99 @@ int UIScale::getGeneralTextSize() {
     return generalTextSize;
 }
 
+// Font metrics
+void UIScale::loadFontMetrics(lgfx::LovyanGFX& display) {
+    float savedSize = display.getTextSizeX();
+    char glyph[2] = {0, 0};
+
+    // Measured at every size rather than scaled, so rounding matches what gets drawn
+    for (int size = 1; size <= UI_TEXT_SIZE_MAX; size++) {
+        display.setTextSize(size);
+        uint8_t widest = 0;
+        for (int i = 0; i < UI_FONT_GLYPHS; i++) {
+            glyph[0] = (char)(UI_FONT_FIRST_GLYPH + i);
+            int width = display.textWidth(glyph);
+            glyphWidths[size - 1][i] = (uint8_t)constrain(width, 0, 255);
+            if (glyphWidths[size - 1][i] > widest) {
+                widest = glyphWidths[size - 1][i];
+            }
+        }
+        widestGlyph[size - 1] = widest;
+    }
+    display.setTextSize(1);
+    fontHeight = (uint8_t)display.fontHeight();
+    display.setTextSize(savedSize);
+
+    metricsLoaded = true;
+    layoutGeneration++;  // Layouts measured with the estimate are stale
+    Serial.printf("Font metrics loaded - widest glyph %d px, height %d px\n", widestGlyph[0], fontHeight);
+}
+
+int UIScale::glyphWidth(uint8_t c, int textSize) {
+    if (!metricsLoaded) {
+        return CHAR_WIDTH_SIZE_1 * textSize;
+    }
+
+    // Sizes past the table scale from size 1
+    int size = textSize;
+    int factor = 1;
+    if (size < 1 || size > UI_TEXT_SIZE_MAX) {
+        factor = max(textSize, 1);
+        size = 1;
+    }
+
+    unsigned index = (unsigned)c - UI_FONT_FIRST_GLYPH;
+    if (index >= UI_FONT_GLYPHS) {
+        return widestGlyph[size - 1] * factor;
+    }
+    return glyphWidths[size - 1][index] * factor;
+}
+
 // Text width calculation helpers
 int UIScale::calculateTextWidth(const String& text, int textSize) {
-    // Estimate text width based on character count and font size
-    int charCount = text.length();
-    int charWidth = CHAR_WIDTH_SIZE_1 * textSize;
-    return charCount * charWidth;
+    return calculateTextWidth(text.c_str(), text.length(), textSize);
+}
+
+int UIScale::calculateTextWidth(const char* text, size_t length, int textSize) {
+    if (!text) {
+        return 0;
+    }
+    int width = 0;
+    for (size_t i = 0; i < length; i++) {
+        width += glyphWidth((uint8_t)text[i], textSize);
+    }
+    return width;
+}
+
+int UIScale::calculateTextWidth(size_t charCount, int textSize) {
+    if (!metricsLoaded) {
+        return charCount * CHAR_WIDTH_SIZE_1 * textSize;
+    }
+    return charCount * glyphWidth(0xFF, textSize);  // Widest glyph
+}
+
+size_t UIScale::fitTextLength(const char* text, size_t length, int textSize, int maxWidth, int* fittedWidth) {
+    int width = 0;
+    size_t fit = 0;
+    if (text && maxWidth > 0) {
+        // Stop at the first glyph that would cross the limit
+        while (fit < length) {
+            int next = width + glyphWidth((uint8_t)text[fit], textSize);
+            if (next > maxWidth) {
+                break;
+            }
+            width = next;
+            fit++;
+        }
+    }
+    if (fittedWidth) {
+        *fittedWidth = width;
+    }
+    return fit;
 }
 
 int UIScale::calculateTextHeight(int textSize) {
-    return CHAR_HEIGHT_SIZE_1 * textSize;
+    return fontHeight * textSize;
 }
 
 // Settings persistence
@@ -144,6 +236,7 @@ void UIScale::loadSettings() {
     labelTextSize = constrain(labelTextSize, 1, 4);
     buttonTextSize = constrain(buttonTextSize, 1, 4);
     generalTextSize = constrain(generalTextSize, 1, 4);
+    layoutGeneration++;
 }
 
 String UIScale::getScaleDescription() {
@@ -167,6 +260,7 @@ void UIScale::loadScale() {
     currentScale = preferences.getFloat("scale", DEFAULT_SCALE);
     preferences.end();
     currentScale = clampScale(currentScale);
+    layoutGeneration++;
 }
 
 float UIScale::clampScale(float scale) {
@@ -2,10 +2,16 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include <LovyanGFX.hpp>
 
 namespace BTLogger {
 namespace UI {
 
+// Font metrics tables
+#define UI_FONT_FIRST_GLYPH 0x20  // Printable ASCII only; other bytes use the widest glyph
+#define UI_FONT_GLYPHS 95
+#define UI_TEXT_SIZE_MAX 4        // Text size settings run 1..4
+
 /**
  * UIScale manages UI element scaling for responsive design
  * Provides adaptive scaling based on screen size and user preferences
@@ -64,9 +70,24 @@ class UIScale {
     static int getButtonTextSize();
     static int getGeneralTextSize();
 
+    // Measure the display's font once; until then widths are estimated
+    static void loadFontMetrics(lgfx::LovyanGFX& display);
+    static bool hasFontMetrics() { return metricsLoaded; }
+
     // Text width calculation helpers
     static int calculateTextWidth(const String& text, int textSize);
+    static int calculateTextWidth(const char* text, size_t length, int textSize);
+    static int calculateTextWidth(size_t charCount, int textSize);  // Widest case, for fixed columns
     static int calculateTextHeight(int textSize);
+    static int glyphWidth(uint8_t c, int textSize);
+
+    // Number of leading characters of text that fit in maxWidth, in one pass with no
+    // allocation; fittedWidth receives the width of that prefix
+    static size_t fitTextLength(const char* text, size_t length, int textSize, int maxWidth,
+                                int* fittedWidth = nullptr);
+
+    // Changes whenever scale or text size changes; cached layouts compare against it
+    static uint16_t getLayoutGeneration() { return layoutGeneration; }
 
     // Save/load settings
     static void saveSettings();
@@ -79,6 +100,13 @@ class UIScale {
     static int labelTextSize;
     static int buttonTextSize;
     static int generalTextSize;
+    static uint16_t layoutGeneration;
+
+    // Advance of each glyph at each text size, measured from the real font
+    static uint8_t glyphWidths[UI_TEXT_SIZE_MAX][UI_FONT_GLYPHS];
+    static uint8_t widestGlyph[UI_TEXT_SIZE_MAX];
+    static uint8_t fontHeight;
+    static bool metricsLoaded;
 
     // Default values
     static const float DEFAULT_SCALE;
@@ -6,7 +6,7 @@ namespace UI {
 namespace Widgets {
 
 Button::Button(lgfx::LGFX_Device& display, int x, int y, int w, int h, const String& label)
-    : lcd(&display), posX(x), posY(y), width(w), height(h), text(label), bgColor(0x0000), borderColor(0x8410), textColor(0xFFFF), bgColorPressed(0x8410), borderColorPressed(0xFFFF), textColorPressed(0x0000), pressed(false), enabled(true), callback(nullptr), scrollingText(nullptr), useScrollingText(false) {
+    : lcd(&display), posX(x), posY(y), width(w), height(h), text(label), bgColor(0x0000), borderColor(0x8410), textColor(0xFFFF), bgColorPressed(0x8410), borderColorPressed(0xFFFF), textColorPressed(0x0000), pressed(false), enabled(true), fixedWidth(false), callback(nullptr), scrollingText(nullptr), useScrollingText(false) {
     // Auto-adjust width if it's too small for the text
     adjustWidthForText();
     // Initialize scrolling text if needed
@@ -18,6 +18,8 @@ Button::~Button() {
 }
 
 void Button::adjustWidthForText() {
+    if (fixedWidth) return;
+
     int textSize = UIScale::getButtonTextSize();
     int requiredWidth = UIScale::calculateTextWidth(text, textSize) + UIScale::scale(16);  // 8px padding on each side
 
@@ -78,17 +80,20 @@ void Button::setText(const String& newText) {
 
 void Button::draw() {
     if (!lcd) return;
+    draw(*lcd);
+}
 
+void Button::draw(lgfx::LovyanGFX& target) {
     // Choose colors based on state
     uint16_t currentBg = pressed ? bgColorPressed : bgColor;
     uint16_t currentBorder = pressed ? borderColorPressed : borderColor;
     uint16_t currentText = pressed ? textColorPressed : textColor;
 
     // Draw button background
-    lcd->fillRect(posX, posY, width, height, currentBg);
+    target.fillRect(posX, posY, width, height, currentBg);
 
     // Draw border
-    lcd->drawRect(posX, posY, width, height, currentBorder);
+    target.drawRect(posX, posY, width, height, currentBorder);
 
     // Draw text
     if (!text.isEmpty()) {
@@ -96,12 +101,12 @@ void Button::draw() {
             // Update scrolling text properties and draw
             updateScrollingTextProperties();
             scrollingText->setColors(currentText, currentBg);
-            scrollingText->draw();
+            scrollingText->draw(target);
         } else {
             // Static text drawing (fallback)
             int textSize = UIScale::getButtonTextSize();
-            lcd->setTextSize(textSize);
-            lcd->setTextColor(currentText);
+            target.setTextSize(textSize);
+            target.setTextColor(currentText);
 
             // Calculate text position for centering
             int textWidth = UIScale::calculateTextWidth(text, textSize);
@@ -114,8 +119,8 @@ void Button::draw() {
             textX = constrain(textX, posX + 2, posX + width - textWidth - 2);
             textY = constrain(textY, posY + 2, posY + height - textHeight - 2);
 
-            lcd->setCursor(textX, textY);
-            lcd->print(text);
+            target.setCursor(textX, textY);
+            target.print(text);
         }
     }
 }
@@ -197,6 +202,13 @@ void Button::setPosition(int x, int y) {
     posY = y;
 }
 
+void Button::setSize(int w, int h) {
+    width = w;
+    height = h;
+    fixedWidth = true;
+    initializeScrollingText();
+}
+
 void Button::pauseScrolling() {
     if (scrollingText) {
         scrollingText->pauseScrolling();
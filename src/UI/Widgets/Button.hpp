@@ -44,6 +44,7 @@ class Button {
 
     // Core functionality
     void draw();
+    void draw(lgfx::LovyanGFX& target);  // Into a sprite or another surface
     void update();
     bool handleTouch(int x, int y, bool touched);
 
@@ -53,6 +54,7 @@ class Button {
     void setCallback(std::function<void()> cb);
     void setColors(uint16_t bg, uint16_t bgPress, uint16_t border, uint16_t txt);
     void setPosition(int x, int y);
+    void setSize(int w, int h);  // Fixed from then on; longer text scrolls
 
     // Scrolling control
     void pauseScrolling();
@@ -84,6 +86,7 @@ class Button {
     // State
     bool pressed;
     bool enabled;
+    bool fixedWidth;
 
     // Callback
     std::function<void()> callback;
@@ -92,24 +92,29 @@ void ScrollingText::update() {
 }
 
 void ScrollingText::draw() {
-    if (!lcd || text.isEmpty()) return;
+    if (!lcd) return;
+    draw(*lcd);
+}
+
+void ScrollingText::draw(lgfx::LovyanGFX& target) {
+    if (text.isEmpty()) return;
 
     // Clear the background
-    lcd->fillRect(posX, posY, maxWidth, UIScale::calculateTextHeight(textSize), backgroundColor);
+    target.fillRect(posX, posY, maxWidth, UIScale::calculateTextHeight(textSize), backgroundColor);
 
     // Set text properties
-    lcd->setTextSize(textSize);
-    lcd->setTextColor(textColor);
+    target.setTextSize(textSize);
+    target.setTextColor(textColor);
 
     if (!textNeedsScrolling) {
         // Text fits, draw normally centered
         int textHeight = UIScale::calculateTextHeight(textSize);
         int yOffset = (UIScale::calculateTextHeight(textSize) - textHeight) / 2;
-        lcd->setCursor(posX, posY + yOffset);
-        lcd->print(text);
+        target.setCursor(posX, posY + yOffset);
+        target.print(text);
     } else {
         // Text needs scrolling, draw with clipping
-        drawClippedText();
+        drawClippedText(target);
     }
 }
 
@@ -152,9 +157,7 @@ void ScrollingText::updateScrollPosition() {
     }
 }
 
-void ScrollingText::drawClippedText() {
-    if (!lcd) return;
-
+void ScrollingText::drawClippedText(lgfx::LovyanGFX& target) {
     // Set up clipping rectangle
     int clipX = posX;
     int clipY = posY;
@@ -162,18 +165,18 @@ void ScrollingText::drawClippedText() {
     int clipH = UIScale::calculateTextHeight(textSize);
 
     // Save current clip region
-    lcd->setClipRect(clipX, clipY, clipW, clipH);
+    target.setClipRect(clipX, clipY, clipW, clipH);
 
     // Calculate text position with scroll offset
     int textX = posX - scrollOffset;
     int textY = posY;
 
     // Draw the text
-    lcd->setCursor(textX, textY);
-    lcd->print(text);
+    target.setCursor(textX, textY);
+    target.print(text);
 
     // Restore clipping (remove clip)
-    lcd->clearClipRect();
+    target.clearClipRect();
 }
 
 int ScrollingText::getMaxScrollOffset() const {
@@ -34,6 +34,7 @@ class ScrollingText {
     // Update and render
     void update();
     void draw();
+    void draw(lgfx::LovyanGFX& target);  // Into a sprite or another surface
 
     // State queries
     bool isScrolling() const { return scrollingEnabled && textNeedsScrolling; }
@@ -77,7 +78,7 @@ class ScrollingText {
     // Helper methods
     void calculateTextMetrics();
     void updateScrollPosition();
-    void drawClippedText();
+    void drawClippedText(lgfx::LovyanGFX& target);
     int getMaxScrollOffset() const;
 };
 
@@ -0,0 +1,141 @@
+#include "VirtualList.hpp"
+#include <algorithm>
+
+namespace BTLogger {
+namespace UI {
+namespace Widgets {
+
+void VirtualList::Row::setCells(const int* widths, int count) {
+    cellCount = constrain(count, 0, VIRTUAL_LIST_MAX_CELLS);
+
+    int cellX = x;
+    for (int i = 0; i < cellCount; i++) {
+        if (!cells[i]) {
+            cells[i] = list->createCell(slot, i);
+        }
+        cells[i]->setPosition(cellX, y);
+        cells[i]->setSize(widths[i], height);
+        cellX += widths[i] + gap;
+    }
+}
+
+VirtualList::VirtualList(lgfx::LGFX_Device& display)
+    : lcd(&display), source(nullptr), visibleRows(0), boundRows(0), first(0), rowSpacing(0), pendingSlot(-1), pendingCell(-1) {
+    for (int i = 0; i < VIRTUAL_LIST_MAX_ROWS; i++) {
+        rows[i].list = this;
+        rows[i].slot = i;
+    }
+}
+
+VirtualList::~VirtualList() {
+    for (auto& row : rows) {
+        for (auto cell : row.cells) {
+            delete cell;
+        }
+    }
+}
+
+Button* VirtualList::createCell(int slot, int cell) {
+    // Created once per slot; from then on only rebound
+    auto button = new Button(*lcd, 0, 0, 100, 30, "");
+    button->setCallback([this, slot, cell]() {
+        pendingSlot = slot;
+        pendingCell = cell;
+    });
+    return button;
+}
+
+void VirtualList::setLayout(int x, int y, int rowHeight, int spacing, int rowsShown, int cellGap) {
+    visibleRows = constrain(rowsShown, 0, VIRTUAL_LIST_MAX_ROWS);
+    rowSpacing = spacing;
+    for (int i = 0; i < VIRTUAL_LIST_MAX_ROWS; i++) {
+        rows[i].x = x;
+        rows[i].y = y + i * spacing;
+        rows[i].height = rowHeight;
+        rows[i].gap = cellGap;
+    }
+    refresh();
+}
+
+void VirtualList::refresh() {
+    boundRows = 0;
+    if (!source) {
+        return;
+    }
+
+    // Keep the window inside the list when it shrinks
+    size_t maxFirst = getMaxFirst();
+    if (first > maxFirst) {
+        first = maxFirst;
+    }
+
+    size_t total = source->getRowCount();
+    for (int i = 0; i < visibleRows && first + i < total; i++) {
+        rows[i].cellCount = 0;
+        source->bindRow(first + i, rows[i]);
+        boundRows++;
+    }
+}
+
+bool VirtualList::scrollTo(size_t firstIndex) {
+    size_t target = std::min(firstIndex, getMaxFirst());
+    if (target == first) {
+        return false;
+    }
+    first = target;
+    refresh();
+    return true;
+}
+
+bool VirtualList::scrollBy(int delta) {
+    long target = (long)first + delta;
+    return scrollTo(target < 0 ? 0 : (size_t)target);
+}
+
+size_t VirtualList::getMaxFirst() const {
+    size_t total = source ? source->getRowCount() : 0;
+    return total > (size_t)visibleRows ? total - visibleRows : 0;
+}
+
+bool VirtualList::canScrollDown() const {
+    return first < getMaxFirst();
+}
+
+void VirtualList::draw(lgfx::LovyanGFX& target) {
+    for (int i = 0; i < boundRows; i++) {
+        for (int c = 0; c < rows[i].cellCount; c++) {
+            rows[i].cells[c]->draw(target);
+        }
+    }
+}
+
+void VirtualList::update() {
+    for (int i = 0; i < boundRows; i++) {
+        for (int c = 0; c < rows[i].cellCount; c++) {
+            rows[i].cells[c]->update();
+        }
+    }
+}
+
+bool VirtualList::handleTouch(int x, int y, bool touched) {
+    bool inside = false;
+    for (int i = 0; i < boundRows; i++) {
+        for (int c = 0; c < rows[i].cellCount; c++) {
+            inside |= rows[i].cells[c]->handleTouch(x, y, touched);
+        }
+    }
+
+    // Dispatched last: the source may rebind rows from here
+    if (pendingSlot >= 0 && source) {
+        size_t index = first + pendingSlot;
+        int cell = pendingCell;
+        pendingSlot = -1;
+        pendingCell = -1;
+        source->onRowTapped(index, cell);
+    }
+    return inside;
+}
+
+}  // namespace Widgets
+}  // namespace UI
+}  // namespace BTLogger
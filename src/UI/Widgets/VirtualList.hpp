@@ -0,0 +1,87 @@
+#pragma once
+
+#define LGFX_USE_V1
+#include <LovyanGFX.hpp>
+#include <Arduino.h>
+#include "Button.hpp"
+
+namespace BTLogger {
+namespace UI {
+namespace Widgets {
+
+#define VIRTUAL_LIST_MAX_ROWS 8
+#define VIRTUAL_LIST_MAX_CELLS 3  // Buttons per row, e.g. label, "-" and "+"
+
+/**
+ * VirtualList shows a window of a longer list through a fixed pool of row
+ * views. Rows are bound to items by a Source as the window moves, so
+ * scrolling reuses the same buttons whatever the list length, and no button
+ * is created or deleted after the first layout.
+ *
+ * Taps are reported after all rows have seen the touch, so a Source may
+ * rebind or change the list from onRowTapped().
+ */
+class VirtualList {
+   public:
+    class Row {
+       public:
+        // Cells are laid out left to right with the given widths
+        void setCells(const int* widths, int count);
+        Button* cell(int index) { return index < cellCount ? cells[index] : nullptr; }
+        int getCellCount() const { return cellCount; }
+
+       private:
+        friend class VirtualList;
+        Button* cells[VIRTUAL_LIST_MAX_CELLS] = {nullptr, nullptr, nullptr};
+        int cellCount = 0;
+        int x = 0, y = 0, height = 0, gap = 0;
+        VirtualList* list = nullptr;
+        int slot = 0;
+    };
+
+    class Source {
+       public:
+        virtual ~Source() = default;
+        virtual size_t getRowCount() = 0;
+        virtual void bindRow(size_t index, Row& row) = 0;
+        virtual void onRowTapped(size_t index, int cell) = 0;
+    };
+
+    VirtualList(lgfx::LGFX_Device& display);
+    ~VirtualList();
+
+    void setSource(Source* listSource) { source = listSource; }
+    void setLayout(int x, int y, int rowHeight, int rowSpacing, int visibleRows, int cellGap);
+
+    // Rebind the visible rows after the data changed
+    void refresh();
+    bool scrollTo(size_t firstIndex);
+    bool scrollBy(int rows);
+
+    size_t getFirstVisible() const { return first; }
+    int getVisibleRows() const { return visibleRows; }
+    bool canScrollUp() const { return first > 0; }
+    bool canScrollDown() const;
+
+    void draw(lgfx::LovyanGFX& target);
+    void update();
+    bool handleTouch(int x, int y, bool touched);
+
+   private:
+    lgfx::LGFX_Device* lcd;
+    Source* source;
+    Row rows[VIRTUAL_LIST_MAX_ROWS];
+    int visibleRows;
+    int boundRows;
+    size_t first;
+    int rowSpacing;
+    int pendingSlot;
+    int pendingCell;
+
+    size_t getMaxFirst() const;
+    Button* createCell(int slot, int cell);
+};
+
+}  // namespace Widgets
+}  // namespace UI
+}  // namespace BTLogger